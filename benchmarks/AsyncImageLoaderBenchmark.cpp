@@ -0,0 +1,88 @@
+#include "Benchmark.h"
+#include "TestImages.h"
+#include "image/AsyncImageLoader.h"
+#include "image/MipGenerator.h"
+
+#include <thread>
+
+// What the UI thread pays to load a set of PNGs: synchronously, as ImGuiManager did before the loader, and
+// through AsyncImageLoader with a sink that stands in for texture creation. "Longest frame" is the worst
+// time the UI thread spends in one Publish call, polling every 16 ms as a 60 Hz frame loop would.
+// Options: --count=<images> --size=<pixels per side>.
+
+namespace
+{
+	class NullSink : public IAsyncTextureSink
+	{
+	public:
+		void OnImageDecoded(AsyncImageHandle, const std::string&, DecodedImage& image) override
+		{
+			Benchmark::DoNotOptimize(image.Pixels);
+			NumImages++;
+		}
+		void OnImageShared(AsyncImageHandle, const std::string&, uint64_t) override { NumImages++; }
+		void OnImageFailed(AsyncImageHandle, const std::string&) override { NumFailed++; }
+
+		int NumImages = 0;
+		int NumFailed = 0;
+	};
+}
+
+int main(int argc, char** argv)
+{
+	int count = Benchmark::GetIntArgument(argc, argv, "count", 32);
+	int size = Benchmark::GetIntArgument(argc, argv, "size", 1024);
+
+	TestImages::TempDirectory directory("async-loader-bench");
+	std::vector<std::string> paths;
+	for (int i = 0; i < count; i++)
+	{
+		std::vector<unsigned char> pixels = TestImages::MakePhoto(size, size, 4, i);
+		paths.push_back(directory / ("image" + std::to_string(i) + ".png"));
+		TestImages::WriteFile(paths.back(), TestImages::EncodePng(pixels.data(), size, size, {}));
+	}
+	std::printf("%d PNGs of %dx%d, %u hardware threads\n\n", count, size, size,
+	            std::thread::hardware_concurrency());
+	std::printf("%-22s %12s %16s\n", "path", "total (ms)", "longest frame (ms)");
+
+	// Everything on the UI thread: the frame that loads them takes all of it.
+	double syncSeconds = Benchmark::MeasureBest(1, [&] {
+		ImageDecodeContext context;
+		for (const std::string& path : paths)
+		{
+			DecodedImage image;
+			ImageDecoder::DecodeFile(path, image, 0, &context);
+			MipGenerator::GenerateMipChain(image);
+			Benchmark::DoNotOptimize(image.Pixels);
+		}
+	});
+	std::printf("%-22s %12.1f %16.1f\n", "synchronous", syncSeconds * 1000.0, syncSeconds * 1000.0);
+
+	int maxWorkers = static_cast<int>(std::thread::hardware_concurrency());
+	for (int workers = 1; workers <= (maxWorkers > 1 ? maxWorkers : 1); workers *= 2)
+	{
+		AsyncImageLoader loader;
+		loader.Start(workers);
+		NullSink sink;
+		double longestFrame = 0.0;
+		Benchmark::Clock::time_point start = Benchmark::Clock::now();
+		for (const std::string& path : paths)
+			loader.Request(path);
+		while (loader.GetNumPending() > 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(16));
+			Benchmark::Clock::time_point frameStart = Benchmark::Clock::now();
+			loader.Publish(sink);
+			double frame = Benchmark::GetSeconds(frameStart, Benchmark::Clock::now());
+			longestFrame = frame > longestFrame ? frame : longestFrame;
+		}
+		double total = Benchmark::GetSeconds(start, Benchmark::Clock::now());
+
+		char label[32];
+		std::snprintf(label, sizeof(label), "async, %d worker%s", workers, workers > 1 ? "s" : "");
+		std::printf("%-22s %12.1f %16.3f\n", label, total * 1000.0, longestFrame * 1000.0);
+		if (sink.NumImages != count)
+			std::printf("  %d image(s) failed\n", sink.NumFailed);
+	}
+	return 0;
+}
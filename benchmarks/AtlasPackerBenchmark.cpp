@@ -0,0 +1,147 @@
+#include "Benchmark.h"
+#include "image/AtlasPacker.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// AtlasPacker on icon sets loaded in batches, as AsyncImageLoader publishes them, into pages of the size
+// TextureAtlas uses (its header needs D3D12, so the sizes are repeated here). Draws counts the ImGui draw
+// commands of a grid showing every image in load order: one per image with a texture each, one per run of
+// images on the same page with the atlas. Efficiency is the share of the packed area that still holds images;
+// fill is the share of the pages. The churn rows then replace a fifth of the images at a time and report
+// repacks and the texels they copy.
+// Options: --count=<images> --batch=<images per Insert> --rounds=<churn rounds> --runs=<timed runs>.
+
+namespace
+{
+	const int PAGE_SIZE = 1024; // APP_TEXTURE_ATLAS_PAGE_SIZE
+	const int MAX_PAGES = 16; // APP_TEXTURE_ATLAS_MAX_PAGES
+	const int MAX_IMAGE_SIZE = 128; // APP_TEXTURE_ATLAS_MAX_IMAGE_SIZE
+
+	class SizeSource
+	{
+	public:
+		explicit SizeSource(uint64_t seed) : m_state(seed) {}
+
+		// Square icons at the usual sizes, sometimes a thumbnail of any aspect up to the atlas limit.
+		AtlasRequest Next(bool thumbnails)
+		{
+			static const int ICON_SIZES[] = {16, 20, 24, 32, 48, 64};
+			AtlasRequest request;
+			if (thumbnails && Below(4) == 0)
+			{
+				request.Width = 32 + Below(MAX_IMAGE_SIZE - 31);
+				request.Height = 32 + Below(MAX_IMAGE_SIZE - 31);
+			}
+			else
+			{
+				request.Width = request.Height = ICON_SIZES[Below(6)];
+			}
+			return request;
+		}
+
+		int Below(int bound)
+		{
+			m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+			return static_cast<int>((m_state >> 33) % static_cast<uint64_t>(bound));
+		}
+
+	private:
+		uint64_t m_state;
+	};
+
+	int CountDraws(const AtlasPacker& packer, const std::vector<AtlasHandle>& handles)
+	{
+		int draws = 0;
+		int lastPage = -1;
+		for (const AtlasHandle& handle : handles)
+		{
+			int page = packer.GetPlacement(handle).Page;
+			if (page < 0)
+				draws++; // left out; drawn from a texture of its own
+			else if (page != lastPage)
+				draws++;
+			lastPage = page;
+		}
+		return draws;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int count = Benchmark::GetIntArgument(argc, argv, "count", 1000);
+	int batch = Benchmark::GetIntArgument(argc, argv, "batch", 32);
+	int rounds = Benchmark::GetIntArgument(argc, argv, "rounds", 50);
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 5);
+
+	std::printf("%d images in batches of %d, %dx%d pages, at most %d\n\n", count, batch, PAGE_SIZE, PAGE_SIZE,
+	            MAX_PAGES);
+	std::printf("%-22s %12s %7s %7s %9s %11s %8s %9s %12s\n", "", "us/image", "packed", "pages", "draws",
+	            "efficiency", "fill", "repacks", "moved (MB)");
+	for (bool thumbnails : {false, true})
+	{
+		AtlasPacker packer;
+		std::vector<AtlasHandle> handles;
+		std::vector<AtlasRequest> requests;
+		std::vector<AtlasMove> moves;
+		double seconds = Benchmark::MeasureBest(runs, [&] {
+			packer.Initialize(PAGE_SIZE, MAX_PAGES);
+			SizeSource sizes(1);
+			handles.clear();
+			for (int first = 0; first < count; first += batch)
+			{
+				requests.resize(std::min(batch, count - first));
+				for (AtlasRequest& request : requests)
+					request = sizes.Next(thumbnails);
+				moves.clear();
+				packer.Insert(requests.data(), requests.size(), moves);
+				for (const AtlasRequest& request : requests)
+					handles.push_back(request.Handle);
+			}
+		});
+
+		auto printRow = [&](const char* name, double microseconds, uint64_t movedTexels) {
+			AtlasPackerStats stats = packer.GetStats();
+			char draws[32];
+			std::snprintf(draws, sizeof(draws), "%d/%zu", CountDraws(packer, handles), handles.size());
+			std::printf("%-22s %12.2f %7u %7u %9s %10.1f%% %7.1f%% %9llu %12.1f\n", name, microseconds,
+			            stats.NumEntries, stats.NumPages, draws, stats.GetEfficiency() * 100.0f,
+			            100.0 * static_cast<double>(stats.LiveArea) / static_cast<double>(stats.PageArea),
+			            static_cast<unsigned long long>(stats.Repacks),
+			            Benchmark::ToMegabytes(static_cast<double>(movedTexels) * 4.0));
+		};
+		printRow(thumbnails ? "icons and thumbnails" : "icons", seconds * 1e6 / count, 0);
+
+		// Churn: a fifth of the images go and as many new ones come in, round after round. Timed as one run,
+		// since it continues from the state above.
+		SizeSource churn(2);
+		uint64_t movedTexels = 0;
+		Benchmark::Clock::time_point start = Benchmark::Clock::now();
+		for (int round = 0; round < rounds; round++)
+		{
+			int numReplaced = count / 5;
+			for (int i = 0; i < numReplaced; i++)
+			{
+				size_t victim = static_cast<size_t>(churn.Below(static_cast<int>(handles.size())));
+				packer.Remove(handles[victim]);
+				handles.erase(handles.begin() + victim); // the grid keeps its order
+			}
+			for (int first = 0; first < numReplaced; first += batch)
+			{
+				requests.resize(std::min(batch, numReplaced - first));
+				for (AtlasRequest& request : requests)
+					request = churn.Next(thumbnails);
+				moves.clear();
+				packer.Insert(requests.data(), requests.size(), moves);
+				for (const AtlasMove& move : moves)
+					movedTexels += static_cast<uint64_t>(move.Width) * move.Height;
+				for (const AtlasRequest& request : requests)
+					handles.push_back(request.Handle);
+			}
+		}
+		double churnSeconds = Benchmark::GetSeconds(start, Benchmark::Clock::now());
+		printRow("  after churn", churnSeconds * 1e6 / (static_cast<double>(rounds) * (count / 5)), movedTexels);
+	}
+	return 0;
+}
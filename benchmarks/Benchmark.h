@@ -0,0 +1,69 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Helpers shared by the benchmark executables. Each one prints a table to stdout; timings are the best of a
+// few runs, which is the one least disturbed by the rest of the machine.
+namespace Benchmark
+{
+	using Clock = std::chrono::steady_clock;
+
+	inline double GetSeconds(Clock::time_point start, Clock::time_point end)
+	{
+		return std::chrono::duration<double>(end - start).count();
+	}
+
+	// Best time of runs calls to body, in seconds.
+	template <typename TBody>
+	double MeasureBest(int runs, TBody&& body)
+	{
+		double best = 1e30;
+		for (int run = 0; run < runs; run++)
+		{
+			Clock::time_point start = Clock::now();
+			body();
+			double seconds = GetSeconds(start, Clock::now());
+			best = seconds < best ? seconds : best;
+		}
+		return best;
+	}
+
+	// Keeps the compiler from discarding a result that is otherwise unused.
+	template <typename T>
+	void DoNotOptimize(const T& value)
+	{
+#if defined(__GNUC__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile const void* sink;
+		sink = &value;
+#endif
+	}
+
+	// Value of "--name=<value>" on the command line, or fallback.
+	inline const char* GetArgument(int argc, char** argv, const char* name, const char* fallback)
+	{
+		size_t length = std::strlen(name);
+		for (int i = 1; i < argc; i++)
+		{
+			if (std::strncmp(argv[i], "--", 2) == 0 && std::strncmp(argv[i] + 2, name, length) == 0 &&
+				argv[i][2 + length] == '=')
+				return argv[i] + 3 + length;
+		}
+		return fallback;
+	}
+
+	// Lets a quick run use smaller inputs, e.g. --size=1024.
+	inline int GetIntArgument(int argc, char** argv, const char* name, int fallback)
+	{
+		const char* value = GetArgument(argc, argv, name, nullptr);
+		return value ? std::atoi(value) : fallback;
+	}
+
+	inline double ToMegabytes(double bytes)
+	{
+		return bytes / (1024.0 * 1024.0);
+	}
+}
@@ -0,0 +1,71 @@
+#include "Benchmark.h"
+#include "TestImages.h"
+#include "core/ThreadPool.h"
+#include "image/BlockCompressor.h"
+#include "image/ImageDecoder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Encoding one photo-like image to BC1 (opaque) and BC7 (with alpha) at every quality, on the calling thread
+// and across a ThreadPool, in megapixels per second, with the PSNR of the decoded blocks against the source.
+// Mip levels are left out so that the rate is per pixel of the image itself.
+// Options: --size=<side> --threads=<pool size> --runs=<timed runs>.
+
+namespace
+{
+	DecodedImage MakeImage(const std::vector<unsigned char>& rgba, int size)
+	{
+		DecodedImage image;
+		image.Width = size;
+		image.Height = size;
+		image.Pixels = ImageDecoder::AllocatePixels(rgba.size());
+		memcpy(image.Pixels, rgba.data(), rgba.size());
+		return image;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int size = Benchmark::GetIntArgument(argc, argv, "size", 2048) / 4 * 4;
+	int numThreads = Benchmark::GetIntArgument(argc, argv, "threads", 0);
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 3);
+
+	ThreadPool pool;
+	pool.Start(numThreads);
+	std::printf("%dx%d, %d pool threads, %d hardware threads\n\n", size, size, pool.GetNumThreads(),
+	            static_cast<int>(std::thread::hardware_concurrency()));
+	std::printf("%-8s %-8s %13s %13s %11s\n", "format", "quality", "serial (MP/s)", "pool (MP/s)", "PSNR (dB)");
+
+	for (int channels : {3, 4})
+	{
+		std::vector<unsigned char> photo = TestImages::MakePhoto(size, size, channels, 1);
+		std::vector<unsigned char> rgba = TestImages::ToRgba(photo.data(), static_cast<size_t>(size) * size, channels);
+		double megapixels = static_cast<double>(size) * size / 1e6;
+		for (int quality = 0; quality <= APP_MAX_BLOCK_COMPRESSION_QUALITY; quality++)
+		{
+			double serial = 0.0;
+			double parallel = 0.0;
+			DecodedImage image;
+			for (ThreadPool* compressPool : {static_cast<ThreadPool*>(nullptr), &pool})
+			{
+				double best = 1e30;
+				for (int run = 0; run < runs; run++)
+				{
+					image = MakeImage(rgba, size);
+					Benchmark::Clock::time_point start = Benchmark::Clock::now();
+					BlockCompressor::CompressImage(image, quality, compressPool);
+					best = std::min(best, Benchmark::GetSeconds(start, Benchmark::Clock::now()));
+				}
+				(compressPool ? parallel : serial) = best;
+			}
+
+			std::vector<unsigned char> decoded = TestImages::DecodeBlocks(image.Format, image.Pixels, size, size);
+			std::printf("%-8s %-8d %13.1f %13.1f %11.2f\n", image.Format == TextureFormat::Bc1 ? "BC1" : "BC7",
+			            quality, megapixels / serial, megapixels / parallel, TestImages::GetPsnr(rgba, decoded));
+		}
+	}
+	return 0;
+}
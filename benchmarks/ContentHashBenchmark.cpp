@@ -0,0 +1,59 @@
+#include "Benchmark.h"
+#include "core/ContentHash.h"
+#include "core/CpuFeatures.h"
+
+#include <string>
+#include <vector>
+
+// XXH3-64 throughput of the portable path and of the SIMD kernel Hash64 dispatches to, over a buffer that
+// stays in the L2 cache and one that streams from memory like a freshly mapped file, plus the cost of hashing
+// a key-sized input. Options: --size=<large buffer in MB> --runs=<timed runs>.
+
+int main(int argc, char** argv)
+{
+	size_t largeSize = static_cast<size_t>(Benchmark::GetIntArgument(argc, argv, "size", 64)) * 1024 * 1024;
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 5);
+
+	const Cpu::Features& features = Cpu::GetFeatures();
+	std::printf("Hash64 uses %s\n\n", features.Avx2 ? "AVX2" : features.Sse2 ? "SSE2" : "the scalar path");
+	std::printf("%-12s %14s %14s %9s\n", "input", "scalar", "Hash64", "speedup");
+
+	std::vector<unsigned char> data(largeSize);
+	uint64_t state = 1;
+	for (unsigned char& value : data)
+	{
+		state = state * 6364136223846793005ull + 1442695040888963407ull;
+		value = static_cast<unsigned char>(state >> 56);
+	}
+
+	for (size_t size : {size_t(256) * 1024, largeSize})
+	{
+		// The buffer is hashed several times per run when it is small, so that a run lasts long enough to time.
+		int repeats = static_cast<int>(largeSize / size);
+		auto measure = [&](uint64_t (*hash)(const void*, size_t))
+		{
+			double seconds = Benchmark::MeasureBest(runs, [&] {
+				for (int i = 0; i < repeats; i++)
+					Benchmark::DoNotOptimize(hash(data.data(), size));
+			});
+			return static_cast<double>(size) * repeats / seconds / 1e9;
+		};
+		double scalar = measure(ContentHash::Hash64Scalar);
+		double simd = measure(ContentHash::Hash64);
+		std::printf("%-12s %9.1f GB/s %9.1f GB/s %8.1fx\n",
+		            size == largeSize ? (std::to_string(size >> 20) + " MB").c_str() : "256 KB", scalar, simd,
+		            simd / scalar);
+	}
+
+	// Short inputs never reach the SIMD kernels; what matters there is the latency of one call.
+	const int numKeys = 1000000;
+	for (size_t size : {size_t(16), size_t(64), size_t(200)})
+	{
+		double seconds = Benchmark::MeasureBest(runs, [&] {
+			for (int i = 0; i < numKeys; i++)
+				Benchmark::DoNotOptimize(ContentHash::Hash64(data.data() + (i & 1023), size));
+		});
+		std::printf("%-12s %14s %11.1f ns\n", (std::to_string(size) + " B").c_str(), "-", seconds * 1e9 / numKeys);
+	}
+	return 0;
+}
@@ -0,0 +1,154 @@
+#include "Benchmark.h"
+#include "TestImages.h"
+#include "image/ImageDecoder.h"
+#include "image/MipGenerator.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Filling upload memory for one large image: decoded into a heap image, mipmapped and copied into staging
+// (the path CreateTextureFromImage takes), against ImageDecoder::DecodeMemoryInto writing the rows straight
+// into staging, with the mip chain built on the way and without. The staging buffer is allocated and touched
+// beforehand, as a mapped upload ring would be; peak is what each path adds to the resident set on top of it
+// (Linux only, where the peak can be reset). Options: --width=<pixels> --height=<pixels> --runs=<timed runs>.
+
+namespace
+{
+	const uint64_t PLACEMENT_ALIGNMENT = 512; // D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
+	const uint64_t PITCH_ALIGNMENT = 256; // D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+
+	struct Level
+	{
+		uint64_t Offset;
+		uint64_t RowPitch;
+		int Width;
+		int Height;
+	};
+
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// What GetCopyableFootprints returns for an RGBA8 mip chain.
+	std::vector<Level> GetFootprints(int width, int height, uint64_t* out_size)
+	{
+		std::vector<Level> levels;
+		uint64_t size = 0;
+		for (int level = 0; level < MipGenerator::GetMipLevelCount(width, height); level++)
+		{
+			size = AlignUp(size, PLACEMENT_ALIGNMENT);
+			uint64_t rowPitch = AlignUp(static_cast<uint64_t>(width) * 4, PITCH_ALIGNMENT);
+			levels.push_back({size, rowPitch, width, height});
+			size += rowPitch * height;
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+		}
+		*out_size = size;
+		return levels;
+	}
+
+	// Levels 1..N-1, tightly packed as in DecodedImage::MipData, into their footprints.
+	void CopyMipData(const std::vector<unsigned char>& mipData, const std::vector<Level>& levels,
+	                 unsigned char* staging)
+	{
+		const unsigned char* src = mipData.data();
+		for (size_t level = 1; level < levels.size(); level++)
+		{
+			size_t rowSize = static_cast<size_t>(levels[level].Width) * 4;
+			for (int y = 0; y < levels[level].Height; y++, src += rowSize)
+				std::memcpy(staging + levels[level].Offset + y * levels[level].RowPitch, src, rowSize);
+		}
+	}
+
+	bool TwoCopies(const std::vector<unsigned char>& file, const std::vector<Level>& levels, unsigned char* staging)
+	{
+		DecodedImage image;
+		if (!ImageDecoder::DecodeMemory(file.data(), file.size(), image) || !MipGenerator::GenerateMipChain(image))
+			return false;
+		size_t rowSize = static_cast<size_t>(image.Width) * 4;
+		for (int y = 0; y < image.Height; y++)
+			std::memcpy(staging + y * levels[0].RowPitch, image.Pixels + y * rowSize, rowSize);
+		CopyMipData(image.MipData, levels, staging);
+		return true;
+	}
+
+	bool Direct(const std::vector<unsigned char>& file, const std::vector<Level>& levels, unsigned char* staging,
+	            bool withMips)
+	{
+		std::vector<unsigned char> mipData;
+		if (!ImageDecoder::DecodeMemoryInto(file.data(), file.size(), staging, levels[0].RowPitch, levels[0].Width,
+		                                    levels[0].Height, withMips ? &mipData : nullptr))
+			return false;
+		if (withMips)
+			CopyMipData(mipData, levels, staging);
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int width = Benchmark::GetIntArgument(argc, argv, "width", 6000);
+	int height = Benchmark::GetIntArgument(argc, argv, "height", 4000);
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 3);
+
+	struct Input
+	{
+		std::string Name;
+		std::vector<unsigned char> File;
+	};
+	std::vector<Input> inputs;
+	std::vector<unsigned char> rgb = TestImages::MakePhoto(width, height, 3, 11);
+	std::vector<unsigned char> rgba = TestImages::MakePhoto(width, height, 4, 12);
+	TestImages::PngOptions rgbPng;
+	rgbPng.ColorType = 2;
+	inputs.push_back({"PNG RGB", TestImages::EncodePng(rgb.data(), width, height, rgbPng)});
+	inputs.push_back({"PNG RGBA", TestImages::EncodePng(rgba.data(), width, height, {})});
+	inputs.push_back({"JPEG baseline", TestImages::EncodeJpeg(rgb.data(), width, height, {})});
+	TestImages::JpegOptions progressive;
+	progressive.Progressive = true;
+	inputs.push_back({"JPEG progressive", TestImages::EncodeJpeg(rgb.data(), width, height, progressive)});
+	rgb = {};
+	rgba = {};
+
+	uint64_t stagingSize = 0;
+	std::vector<Level> levels = GetFootprints(width, height, &stagingSize);
+	std::vector<unsigned char> staging(stagingSize, 0);
+	bool canResetPeak = TestImages::ResetPeakRss();
+
+	std::printf("%dx%d, %.0f MB of staging\n\n", width, height,
+	            Benchmark::ToMegabytes(static_cast<double>(stagingSize)));
+	std::printf("%-18s %-20s %10s %12s\n", "file", "path", "ms", "peak (MB)");
+	for (const Input& input : inputs)
+	{
+		struct Path
+		{
+			const char* Name;
+			int Kind;
+		};
+		for (Path path : {Path{"heap image + copy", 0}, Path{"direct, mips", 1}, Path{"direct, base level", 2}})
+		{
+			auto run = [&] {
+				bool decoded = path.Kind == 0 ? TwoCopies(input.File, levels, staging.data())
+				                              : Direct(input.File, levels, staging.data(), path.Kind == 1);
+				if (!decoded)
+					std::printf("%s failed to decode\n", input.Name.c_str());
+			};
+
+			// Peak of one cold run, then the best time.
+			char peak[32] = "-";
+			if (canResetPeak && TestImages::ResetPeakRss())
+			{
+				uint64_t before = TestImages::GetPeakRss();
+				run();
+				std::snprintf(peak, sizeof(peak), "%.1f",
+				              Benchmark::ToMegabytes(static_cast<double>(TestImages::GetPeakRss() - before)));
+			}
+			double seconds = Benchmark::MeasureBest(runs, run);
+			std::printf("%-18s %-20s %10.1f %12s\n", input.Name.c_str(), path.Name, seconds * 1e3, peak);
+		}
+	}
+	return 0;
+}
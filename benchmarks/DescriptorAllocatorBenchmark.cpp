@@ -0,0 +1,114 @@
+#include "Benchmark.h"
+#include "imgui/imgui.h"
+#include "render/DescriptorIndexAllocator.h"
+
+#include <vector>
+
+// Alloc/free throughput of DescriptorIndexAllocator at heap sizes from a dashboard's to D3D12's tier limit,
+// next to the ImVector free list ExampleDescriptorHeapAllocator used before it: filling the heap, then random
+// churn at half occupancy (free one, allocate one). Memory is what the bookkeeping holds once the heap has
+// been filled. Options: --ops=<churn operations per size>.
+
+namespace
+{
+	constexpr uint32_t PAGE_SIZE = 64; // APP_SRV_HEAP_PAGE_SIZE
+
+	uint64_t NextRandom(uint64_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+
+	// The bitmap allocator, with the generation-checked handles the renderer keeps.
+	struct BitmapAllocator
+	{
+		using Handle = DescriptorHandle;
+
+		void Initialize(uint32_t size) { Allocator.Initialize(PAGE_SIZE, size); }
+		void Allocate(Handle* out_handle) { Allocator.Allocate(out_handle); }
+		void Free(Handle handle) { Allocator.Free(handle); }
+		size_t GetMemoryUsage() const { return Allocator.GetMemoryUsage(); }
+
+		DescriptorIndexAllocator Allocator;
+	};
+
+	// ExampleDescriptorHeapAllocator's bookkeeping before the bitmap: a stack of free indices, filled up
+	// front, with no check against double or stale frees.
+	struct FreeListAllocator
+	{
+		using Handle = int;
+
+		void Initialize(uint32_t size)
+		{
+			FreeIndices.clear();
+			FreeIndices.reserve(static_cast<int>(size));
+			for (int n = static_cast<int>(size); n > 0; n--)
+				FreeIndices.push_back(n - 1);
+		}
+		void Allocate(Handle* out_handle)
+		{
+			*out_handle = FreeIndices.back();
+			FreeIndices.pop_back();
+		}
+		void Free(Handle handle) { FreeIndices.push_back(handle); }
+		size_t GetMemoryUsage() const { return static_cast<size_t>(FreeIndices.Capacity) * sizeof(int); }
+
+		ImVector<int> FreeIndices;
+	};
+
+	template <typename TAllocator>
+	void Run(const char* name, uint32_t size, int numOps)
+	{
+		using Handle = typename TAllocator::Handle;
+		TAllocator allocator;
+		std::vector<Handle> handles(size);
+
+		double fill = Benchmark::MeasureBest(5, [&] {
+			allocator.Initialize(size);
+			for (Handle& handle : handles)
+				allocator.Allocate(&handle);
+		});
+		size_t memory = allocator.GetMemoryUsage();
+
+		// Half the heap in use, in random places.
+		uint64_t state = 0x9e3779b97f4a7c15ull;
+		allocator.Initialize(size);
+		for (Handle& handle : handles)
+			allocator.Allocate(&handle);
+		std::vector<Handle> live;
+		for (Handle& handle : handles)
+		{
+			if (NextRandom(state) & 1)
+				allocator.Free(handle);
+			else
+				live.push_back(handle);
+		}
+
+		double churn = Benchmark::MeasureBest(3, [&] {
+			for (int op = 0; op < numOps; op++)
+			{
+				Handle& victim = live[NextRandom(state) % live.size()];
+				allocator.Free(victim);
+				allocator.Allocate(&victim);
+			}
+		});
+
+		std::printf("%-10u %-10s %14.2f %14.2f %12.1f\n", size, name, fill * 1e9 / size, churn * 1e9 / (2.0 * numOps),
+		            memory / 1024.0);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int numOps = Benchmark::GetIntArgument(argc, argv, "ops", 2000000);
+
+	std::printf("%-10s %-10s %14s %14s %12s\n", "size", "allocator", "fill (ns/op)", "churn (ns/op)", "memory (KB)");
+	for (uint32_t size : {64u, 1024u, 16384u, 1000000u})
+	{
+		Run<BitmapAllocator>("bitmap", size, numOps);
+		Run<FreeListAllocator>("free list", size, numOps);
+	}
+	return 0;
+}
@@ -0,0 +1,159 @@
+#include "Benchmark.h"
+#include "TestImages.h"
+#include "core/ContentHash.h"
+#include "image/AsyncImageLoader.h"
+#include "image/DiskTextureCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+// Startup with an empty DiskTextureCache against startup with a warm one, loading a set of PNG and JPEG
+// files through AsyncImageLoader into a stand-in for the staging buffer. Cold is decode, mips, optional block
+// compression and the store; warm is a mapped read and one copy per level. The warm files come from the page
+// cache, as they would on a second launch. "Same" checks that both runs staged identical bytes.
+// Options: --count=<files> --width=<pixels> --height=<pixels> --runs=<timed runs>.
+
+namespace
+{
+	// Lays every image out as the D3D12 upload buffer would and copies it there, like RecordTextureUpload.
+	class StagingSink : public IAsyncTextureSink
+	{
+	public:
+		void OnImageDecoded(AsyncImageHandle, const std::string&, DecodedImage& image) override
+		{
+			m_staging.clear();
+			const unsigned char* levelPixels = image.Pixels;
+			int width = image.Width;
+			int height = image.Height;
+			for (int level = 0; level < image.MipLevels; level++)
+			{
+				size_t rowSize = TextureFormats::GetRowPitch(image.Format, width);
+				size_t rowPitch = (rowSize + APP_DISK_CACHE_ROW_PITCH_ALIGNMENT - 1) /
+					APP_DISK_CACHE_ROW_PITCH_ALIGNMENT * APP_DISK_CACHE_ROW_PITCH_ALIGNMENT;
+				int numRows = TextureFormats::GetNumRows(image.Format, height);
+				size_t offset = (m_staging.size() + APP_DISK_CACHE_LEVEL_ALIGNMENT - 1) /
+					APP_DISK_CACHE_LEVEL_ALIGNMENT * APP_DISK_CACHE_LEVEL_ALIGNMENT;
+				m_staging.resize(offset + rowPitch * numRows);
+
+				if (image.CacheEntry)
+				{
+					memcpy(m_staging.data() + offset, image.CacheEntry->GetLevelData(level), rowPitch * numRows);
+				}
+				else
+				{
+					for (int row = 0; row < numRows; row++)
+						memcpy(m_staging.data() + offset + row * rowPitch, levelPixels + row * rowSize, rowSize);
+					levelPixels = level == 0 ? image.MipData.data() : levelPixels + rowSize * numRows;
+				}
+				width = std::max(1, width / 2);
+				height = std::max(1, height / 2);
+			}
+			// Order-independent, as the loader publishes in whatever order the workers finish.
+			StagedHash ^= ContentHash::Hash64(m_staging.data(), m_staging.size());
+			NumImages++;
+		}
+		void OnImageShared(AsyncImageHandle, const std::string&, uint64_t) override { NumImages++; }
+		void OnImageFailed(AsyncImageHandle, const std::string&) override {}
+
+		uint64_t StagedHash = 0;
+		int NumImages = 0;
+
+	private:
+		std::vector<unsigned char> m_staging;
+	};
+
+	struct Result
+	{
+		double Seconds = 0.0;
+		uint64_t StagedHash = 0;
+		int NumImages = 0;
+	};
+
+	Result LoadAll(DiskTextureCache& cache, const std::vector<std::string>& paths, int maxDimension,
+	               const BlockCompressionOptions& compression)
+	{
+		Benchmark::Clock::time_point start = Benchmark::Clock::now();
+		AsyncImageLoader loader;
+		loader.SetDiskCache(&cache);
+		loader.Start();
+		StagingSink sink;
+		for (const std::string& path : paths)
+			loader.Request(path, maxDimension, 0, compression);
+		while (loader.GetNumPending() > 0)
+		{
+			if (loader.Publish(sink) == 0)
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+		loader.Shutdown();
+		return {Benchmark::GetSeconds(start, Benchmark::Clock::now()), sink.StagedHash, sink.NumImages};
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int count = Benchmark::GetIntArgument(argc, argv, "count", 16);
+	int width = Benchmark::GetIntArgument(argc, argv, "width", 2048);
+	int height = Benchmark::GetIntArgument(argc, argv, "height", 1536);
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 3);
+
+	TestImages::TempDirectory directory("disk-cache-bench");
+	std::vector<std::string> paths;
+	for (int i = 0; i < count; i++)
+	{
+		// Every other file is a JPEG, and the JPEGs are opaque.
+		bool jpeg = i % 2 == 1;
+		std::vector<unsigned char> pixels = TestImages::MakePhoto(width, height, jpeg ? 3 : 4, i);
+		paths.push_back(directory / ("image" + std::to_string(i) + (jpeg ? ".jpg" : ".png")));
+		TestImages::WriteFile(paths.back(), jpeg ? TestImages::EncodeJpeg(pixels.data(), width, height, {})
+		                                         : TestImages::EncodePng(pixels.data(), width, height, {}));
+	}
+	std::printf("%d PNG/JPEG files of %dx%d, %u hardware threads\n\n", count, width, height,
+	            std::thread::hardware_concurrency());
+	std::printf("%-20s %10s %10s %9s %11s %6s\n", "images", "cold (ms)", "warm (ms)", "speedup", "cache (MB)",
+	            "same");
+
+	struct Case
+	{
+		const char* Name;
+		int MaxDimension;
+		BlockCompressionOptions Compression;
+	};
+	const Case cases[] = {{"thumbnails (256)", 256, {}}, {"full size RGBA8", 0, {}}, {"full size BC q1", 0, {true, 1}}};
+	for (const Case& test : cases)
+	{
+		std::string cacheDirectory = directory / "cache";
+		DiskTextureCache cache;
+		Result cold;
+		cold.Seconds = 1e30;
+		for (int run = 0; run < runs; run++)
+		{
+			std::filesystem::remove_all(cacheDirectory);
+			cache.Open(cacheDirectory);
+			Result result = LoadAll(cache, paths, test.MaxDimension, test.Compression);
+			if (result.Seconds < cold.Seconds)
+				cold = result;
+		}
+		uint64_t cacheBytes = cache.GetStats().TotalBytes;
+
+		Result warm;
+		warm.Seconds = 1e30;
+		for (int run = 0; run < runs; run++)
+		{
+			cache.Open(cacheDirectory);
+			Result result = LoadAll(cache, paths, test.MaxDimension, test.Compression);
+			if (result.Seconds < warm.Seconds)
+				warm = result;
+		}
+		bool same = warm.StagedHash == cold.StagedHash && warm.NumImages == count && cold.NumImages == count;
+		std::printf("%-20s %10.1f %10.1f %8.1fx %11.1f %6s\n", test.Name, cold.Seconds * 1000.0,
+		            warm.Seconds * 1000.0, cold.Seconds / warm.Seconds,
+		            Benchmark::ToMegabytes(static_cast<double>(cacheBytes)), same ? "yes" : "NO");
+		cache.Close();
+		std::filesystem::remove_all(cacheDirectory);
+	}
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include "Benchmark.h"
+#include "TestImages.h"
+#include "image/FileSource.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Getting a whole file's bytes in front of a decoder: stdio into a fresh buffer (stbi_load's way, before
+// FileSource), FileSource's read path into its reused buffer, and its mapping. Every path then reads every
+// byte, as a decoder would. "Cold" drops the file from the page cache before each run where the platform
+// allows it (posix_fadvise). Options: --count=<files per size> --runs=<n>.
+
+namespace
+{
+	uint64_t Checksum(const unsigned char* data, size_t size)
+	{
+		uint64_t sum = 0;
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			uint64_t word;
+			std::memcpy(&word, data + i, 8);
+			sum += word;
+		}
+		for (; i < size; i++)
+			sum += data[i];
+		return sum;
+	}
+
+	bool DropFromPageCache(const std::string& path)
+	{
+#if !defined(_WIN32) && defined(POSIX_FADV_DONTNEED)
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+		// Dirty pages stay cached: the files were only just written.
+		fdatasync(fd);
+		bool dropped = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+		close(fd);
+		return dropped;
+#else
+		(void)path;
+		return false;
+#endif
+	}
+
+	uint64_t ReadWithStdio(const std::string& path)
+	{
+		FILE* file = std::fopen(path.c_str(), "rb");
+		if (file == nullptr)
+			return 0;
+		std::fseek(file, 0, SEEK_END);
+		long size = std::ftell(file);
+		std::fseek(file, 0, SEEK_SET);
+		std::vector<unsigned char> data(static_cast<size_t>(size));
+		size_t read = std::fread(data.data(), 1, data.size(), file);
+		std::fclose(file);
+		return Checksum(data.data(), read);
+	}
+
+	uint64_t ReadWithFileSource(FileSource& source, const std::string& path)
+	{
+		if (!source.Open(path))
+			return 0;
+		uint64_t sum = Checksum(source.GetData(), source.GetSize());
+		source.Close();
+		return sum;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int count = Benchmark::GetIntArgument(argc, argv, "count", 8);
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 5);
+
+	TestImages::TempDirectory directory("file-source-bench");
+	std::printf("%-10s %-6s %14s %14s %14s\n", "file", "cache", "stdio (MB/s)", "read (MB/s)", "mapped (MB/s)");
+	for (size_t size : {size_t(256) << 10, size_t(4) << 20, size_t(32) << 20})
+	{
+		std::vector<std::string> paths;
+		for (int i = 0; i < count; i++)
+		{
+			paths.push_back(directory / ("file" + std::to_string(size) + "_" + std::to_string(i)));
+			TestImages::WriteFile(paths.back(), TestImages::MakeNoise(size, i));
+		}
+
+		for (bool cold : {false, true})
+		{
+			if (cold && !DropFromPageCache(paths[0]))
+				continue;
+
+			// Only the reads are timed; dropping the cache happens between them.
+			auto measure = [&](auto&& readFile) {
+				double best = 0;
+				for (int run = 0; run < runs; run++)
+				{
+					double seconds = 0;
+					for (const std::string& path : paths)
+					{
+						if (cold)
+							DropFromPageCache(path);
+						Benchmark::Clock::time_point start = Benchmark::Clock::now();
+						Benchmark::DoNotOptimize(readFile(path));
+						seconds += Benchmark::GetSeconds(start, Benchmark::Clock::now());
+					}
+					best = run == 0 || seconds < best ? seconds : best;
+				}
+				return Benchmark::ToMegabytes(static_cast<double>(size) * count) / best;
+			};
+
+			FileSource readSource;
+			readSource.SetMappingEnabled(false);
+			FileSource mappedSource;
+			double stdio = measure([&](const std::string& path) { return ReadWithStdio(path); });
+			double read = measure([&](const std::string& path) { return ReadWithFileSource(readSource, path); });
+			double mapped = measure([&](const std::string& path) { return ReadWithFileSource(mappedSource, path); });
+
+			char label[32];
+			std::snprintf(label, sizeof(label), "%zu KB", size >> 10);
+			std::printf("%-10s %-6s %14.0f %14.0f %14.0f\n", label, cold ? "cold" : "warm", stdio, read, mapped);
+		}
+	}
+	return 0;
+}
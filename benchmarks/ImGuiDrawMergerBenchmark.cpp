@@ -0,0 +1,133 @@
+#include "Benchmark.h"
+#include "imgui/imgui.h"
+#include "render/ImGuiDrawMerger.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Draw commands of recorded 1080p frames before and after ImGuiDrawMerger, and what merging costs next to
+// ImGui::Render(): an icon grid, a thumbnail gallery and a table with an icon column (tables draw through
+// split channels). Each image has a texture of its own, as it does without the atlas. Every run merges the
+// same recorded frame. Options: --runs=<timed runs>.
+
+namespace
+{
+	void DrawGrid(int cellSize, int textureBase)
+	{
+		ImGui::SetNextWindowPos(ImVec2(0, 0));
+		ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+		ImGui::Begin("Grid", nullptr, ImGuiWindowFlags_NoDecoration);
+		const int columns = static_cast<int>(ImGui::GetIO().DisplaySize.x) / (cellSize + 16);
+		for (int i = 0; i < 2000; i++)
+		{
+			if (i % columns != 0)
+				ImGui::SameLine();
+			ImGui::BeginGroup();
+			ImGui::Image(ImTextureRef(static_cast<ImTextureID>(textureBase + i)),
+			             ImVec2(static_cast<float>(cellSize), static_cast<float>(cellSize)));
+			ImGui::Text("%04d.png", i);
+			ImGui::EndGroup();
+		}
+		ImGui::End();
+	}
+
+	void DrawTable()
+	{
+		ImGui::SetNextWindowPos(ImVec2(0, 0));
+		ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+		ImGui::Begin("Table", nullptr, ImGuiWindowFlags_NoDecoration);
+		if (ImGui::BeginTable("Files", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+		{
+			for (int row = 0; row < 60; row++)
+			{
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Image(ImTextureRef(static_cast<ImTextureID>(1000 + row)), ImVec2(16, 16));
+				ImGui::TableNextColumn();
+				ImGui::Text("image%04d.png", row);
+				ImGui::TableNextColumn();
+				ImGui::Text("%d x %d", 64 + row, 48 + row);
+				ImGui::TableNextColumn();
+				ImGui::Image(ImTextureRef(static_cast<ImTextureID>(2000 + row)), ImVec2(16, 16));
+			}
+			ImGui::EndTable();
+		}
+		ImGui::End();
+	}
+
+	// Records one frame, with the font atlas "uploaded" like the DX12 backend does before merging.
+	template <typename TDraw>
+	double Record(TDraw&& draw)
+	{
+		Benchmark::Clock::time_point start = Benchmark::Clock::now();
+		ImGui::NewFrame();
+		draw();
+		ImGui::Render();
+		double seconds = Benchmark::GetSeconds(start, Benchmark::Clock::now());
+		for (ImTextureData* texture : ImGui::GetPlatformIO().Textures)
+		{
+			if (texture->Status == ImTextureStatus_WantCreate)
+				texture->SetTexID(1);
+			if (texture->Status != ImTextureStatus_OK)
+				texture->SetStatus(ImTextureStatus_OK);
+		}
+		return seconds;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 20);
+
+	ImGui::CreateContext();
+	ImGuiIO& io = ImGui::GetIO();
+	io.IniFilename = nullptr;
+	io.DisplaySize = ImVec2(1920.0f, 1080.0f);
+	io.DeltaTime = 1.0f / 60.0f;
+	io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures | ImGuiBackendFlags_RendererHasVtxOffset;
+
+	std::printf("%-20s %10s %8s %8s %10s %12s %12s\n", "frame", "commands", "draws", "merged", "indices",
+	            "Render (us)", "Merge (us)");
+	struct Case
+	{
+		const char* Name;
+		void (*Draw)();
+	};
+	const Case cases[] = {
+		{"icon grid (32)", [] { DrawGrid(32, 100000); }},
+		{"gallery (128)", [] { DrawGrid(128, 200000); }},
+		{"table", DrawTable},
+	};
+	ImGuiDrawMerger merger;
+	for (const Case& test : cases)
+	{
+		// The first frame only sizes the windows.
+		Record(test.Draw);
+		double renderSeconds = 1e30;
+		for (int run = 0; run < runs; run++)
+			renderSeconds = std::min(renderSeconds, Record(test.Draw));
+
+		ImDrawData* drawData = ImGui::GetDrawData();
+		std::vector<ImVector<ImDrawCmd>> recorded;
+		for (const ImDrawList* drawList : drawData->CmdLists)
+			recorded.push_back(drawList->CmdBuffer);
+
+		double mergeSeconds = 1e30;
+		for (int run = 0; run < runs; run++)
+		{
+			for (size_t i = 0; i < recorded.size(); i++)
+				drawData->CmdLists[static_cast<int>(i)]->CmdBuffer = recorded[i];
+			Benchmark::Clock::time_point start = Benchmark::Clock::now();
+			merger.Merge(drawData, [](ImTextureID textureId, void*) { return static_cast<uint32_t>(textureId); },
+			             nullptr);
+			mergeSeconds = std::min(mergeSeconds, Benchmark::GetSeconds(start, Benchmark::Clock::now()));
+		}
+
+		const ImGuiDrawMergeStats& stats = merger.GetStats();
+		std::printf("%-20s %10u %8u %8u %10u %12.1f %12.1f\n", test.Name, stats.NumCommands, stats.NumDraws,
+		            stats.GetMergedCommands(), stats.NumIndices, renderSeconds * 1e6, mergeSeconds * 1e6);
+	}
+	ImGui::DestroyContext();
+	return 0;
+}
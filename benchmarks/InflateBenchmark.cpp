@@ -0,0 +1,69 @@
+#include "Benchmark.h"
+#include "TestImages.h"
+#include "image/Inflate.h"
+
+#include <string>
+#include <vector>
+
+#include "stb/stb_image.h"
+#include <zlib.h>
+
+// Inflate throughput, in megabytes of output per second: Inflate against stb_image's inflate, which PNGs went
+// through before, and against zlib. Inputs are the samples of a generated RGB photo at three levels, text, and
+// incompressible bytes, which deflate stores. Options: --size=<MB of output> --runs=<n>.
+
+int main(int argc, char** argv)
+{
+	int sizeMb = Benchmark::GetIntArgument(argc, argv, "size", 64);
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 5);
+
+	struct Input
+	{
+		std::string Name;
+		std::vector<unsigned char> Data;
+		int Level;
+	};
+	std::vector<Input> inputs;
+	int side = 1;
+	while (static_cast<size_t>(side) * side * 3 < static_cast<size_t>(sizeMb) << 20)
+		side *= 2;
+	std::vector<unsigned char> photo = TestImages::MakePhoto(side, side, 3, 1);
+	for (int level : {1, 6, 9})
+		inputs.push_back({"photo, level " + std::to_string(level), photo, level});
+
+	std::string text;
+	while (text.size() < static_cast<size_t>(sizeMb) << 20)
+		text += "The quick brown fox " + std::to_string(text.size() * 7919 % 100000) + " jumps over the lazy dog. ";
+	inputs.push_back({"text, level 6", std::vector<unsigned char>(text.begin(), text.end()), 6});
+	inputs.push_back({"noise, level 6", TestImages::MakeNoise(static_cast<size_t>(sizeMb) << 20, 2), 6});
+
+	std::printf("%-16s %8s %9s %14s %14s %14s %9s\n", "input", "MB", "ratio", "Inflate (MB/s)", "stb (MB/s)",
+	            "zlib (MB/s)", "vs stb");
+	for (const Input& input : inputs)
+	{
+		std::vector<unsigned char> stream = TestImages::Deflate(input.Data.data(), input.Data.size(), input.Level);
+		std::vector<unsigned char> out(input.Data.size());
+
+		double inflate = Benchmark::MeasureBest(runs, [&] {
+			size_t size = 0;
+			Inflate::DecompressZlib(stream.data(), stream.size(), out.data(), out.size(), &size);
+			Benchmark::DoNotOptimize(out[0]);
+		});
+		double stb = Benchmark::MeasureBest(runs, [&] {
+			stbi_zlib_decode_buffer(reinterpret_cast<char*>(out.data()), static_cast<int>(out.size()),
+			                        reinterpret_cast<const char*>(stream.data()), static_cast<int>(stream.size()));
+			Benchmark::DoNotOptimize(out[0]);
+		});
+		double zlib = Benchmark::MeasureBest(runs, [&] {
+			uLongf size = static_cast<uLongf>(out.size());
+			uncompress(out.data(), &size, stream.data(), static_cast<uLong>(stream.size()));
+			Benchmark::DoNotOptimize(out[0]);
+		});
+
+		double megabytes = Benchmark::ToMegabytes(static_cast<double>(input.Data.size()));
+		std::printf("%-16s %8.1f %8.2fx %14.0f %14.0f %14.0f %8.1fx\n", input.Name.c_str(), megabytes,
+		            static_cast<double>(input.Data.size()) / stream.size(), megabytes / inflate, megabytes / stb,
+		            megabytes / zlib, stb / inflate);
+	}
+	return 0;
+}
@@ -0,0 +1,122 @@
+#include "Benchmark.h"
+#include "TestImages.h"
+#include "image/JpegDecoder.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "stb/stb_image.h"
+
+// Full-size JPEG decoding to RGBA8, in megapixels per second: JpegDecoder's fused AVX2 path against stb_image,
+// which ImageDecoder used before, and libjpeg for reference. The generated corpus has 4:2:0, 4:2:2 and 4:4:4
+// photos from 1080p to 24 MP. Options: --corpus=<directory of .jpg files> --runs=<timed runs>.
+
+namespace
+{
+	struct Sample
+	{
+		std::string Name;
+		std::vector<unsigned char> Data;
+		int Width = 0;
+		int Height = 0;
+	};
+
+	std::vector<Sample> LoadCorpus(const std::string& directory)
+	{
+		std::vector<Sample> samples;
+		for (const auto& entry : std::filesystem::directory_iterator(directory))
+		{
+			std::string extension = entry.path().extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+			if (extension != ".jpg" && extension != ".jpeg")
+				continue;
+			Sample sample;
+			sample.Name = entry.path().filename().string();
+			sample.Data = TestImages::ReadFile(entry.path());
+			JpegInfo info;
+			if (!JpegDecoder::ReadInfo(sample.Data.data(), sample.Data.size(), &info))
+				continue;
+			sample.Width = info.Width;
+			sample.Height = info.Height;
+			samples.push_back(std::move(sample));
+		}
+		return samples;
+	}
+
+	std::vector<Sample> MakeCorpus()
+	{
+		struct Subsampling
+		{
+			const char* Name;
+			int H;
+			int V;
+		};
+		const Subsampling layouts[] = {{"4:2:0", 2, 2}, {"4:2:2", 2, 1}, {"4:4:4", 1, 1}};
+
+		std::vector<Sample> samples;
+		for (auto [width, height] : {std::pair{1920, 1080}, {4032, 3024}, {6000, 4000}})
+		{
+			std::vector<unsigned char> pixels = TestImages::MakePhoto(width, height, 3, width);
+			for (const Subsampling& layout : layouts)
+			{
+				TestImages::JpegOptions options;
+				options.SamplingH = layout.H;
+				options.SamplingV = layout.V;
+				Sample sample;
+				sample.Name = std::to_string(width) + "x" + std::to_string(height) + " " + layout.Name;
+				sample.Data = TestImages::EncodeJpeg(pixels.data(), width, height, options);
+				sample.Width = width;
+				sample.Height = height;
+				samples.push_back(std::move(sample));
+			}
+		}
+		return samples;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string corpus = Benchmark::GetArgument(argc, argv, "corpus", "");
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 3);
+
+	std::vector<Sample> samples = corpus.empty() ? MakeCorpus() : LoadCorpus(corpus);
+	std::printf("%-24s %15s %15s %15s %9s\n", "image", "AVX2 (MP/s)", "stb (MP/s)", "libjpeg (MP/s)", "vs stb");
+
+	for (const Sample& sample : samples)
+	{
+		JpegInfo info;
+		if (!JpegDecoder::ReadInfo(sample.Data.data(), sample.Data.size(), &info) || !JpegDecoder::IsSupported(info))
+		{
+			std::printf("%-24s not supported by JpegDecoder\n", sample.Name.c_str());
+			continue;
+		}
+
+		size_t rowPitch = static_cast<size_t>(sample.Width) * 4;
+		std::unique_ptr<unsigned char[]> rgba(new unsigned char[rowPitch * sample.Height]);
+		double fused = Benchmark::MeasureBest(runs, [&] {
+			JpegDecoder::Decode(sample.Data.data(), sample.Data.size(), rgba.get(), rowPitch);
+			Benchmark::DoNotOptimize(rgba[0]);
+		});
+		double stb = Benchmark::MeasureBest(runs, [&] {
+			int width, height, channels;
+			stbi_uc* pixels = stbi_load_from_memory(sample.Data.data(), static_cast<int>(sample.Data.size()), &width,
+			                                        &height, &channels, 4);
+			Benchmark::DoNotOptimize(pixels);
+			stbi_image_free(pixels);
+		});
+		double libjpeg = Benchmark::MeasureBest(runs, [&] {
+			int width = 0;
+			int height = 0;
+			std::vector<unsigned char> pixels = TestImages::DecodeJpegScaled(sample.Data, 1, &width, &height);
+			Benchmark::DoNotOptimize(pixels[0]);
+		});
+
+		double megapixels = static_cast<double>(sample.Width) * sample.Height / 1e6;
+		std::printf("%-24s %15.0f %15.0f %15.0f %8.1fx\n", sample.Name.c_str(), megapixels / fused, megapixels / stb,
+		            megapixels / libjpeg, stb / fused);
+	}
+	return 0;
+}
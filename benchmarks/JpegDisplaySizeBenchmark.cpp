@@ -0,0 +1,134 @@
+#include "Benchmark.h"
+#include "TestImages.h"
+#include "image/ImageDecoder.h"
+#include "image/JpegDecoder.h"
+#include "image/MipGenerator.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Decoding JPEGs for display at a bounded size: the full-size decode box-halved down afterwards, as
+// ImageDecoder did before, against the scaled IDCT it uses now, with libjpeg's DCT scaling for reference.
+// Options: --corpus=<directory of .jpg files> (generated photos otherwise) --max=<maxDimension> --runs=<n>.
+
+namespace
+{
+	struct Sample
+	{
+		std::string Name;
+		std::vector<unsigned char> Data;
+		int Width = 0;
+		int Height = 0;
+	};
+
+	std::vector<Sample> LoadCorpus(const std::string& directory)
+	{
+		std::vector<Sample> samples;
+		for (const auto& entry : std::filesystem::directory_iterator(directory))
+		{
+			std::string extension = entry.path().extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+			if (extension != ".jpg" && extension != ".jpeg")
+				continue;
+			Sample sample;
+			sample.Name = entry.path().filename().string();
+			sample.Data = TestImages::ReadFile(entry.path());
+			JpegInfo info;
+			if (!JpegDecoder::ReadInfo(sample.Data.data(), sample.Data.size(), &info))
+				continue;
+			sample.Width = info.Width;
+			sample.Height = info.Height;
+			samples.push_back(std::move(sample));
+		}
+		return samples;
+	}
+
+	std::vector<Sample> MakeCorpus()
+	{
+		std::vector<Sample> samples;
+		for (auto [width, height] : {std::pair{1920, 1080}, {4032, 3024}, {6000, 4000}})
+		{
+			std::vector<unsigned char> pixels = TestImages::MakePhoto(width, height, 3, width);
+			Sample sample;
+			sample.Name = std::to_string(width) + "x" + std::to_string(height) + " 4:2:0";
+			sample.Data = TestImages::EncodeJpeg(pixels.data(), width, height, {});
+			sample.Width = width;
+			sample.Height = height;
+			samples.push_back(std::move(sample));
+		}
+		return samples;
+	}
+
+	// The old path: the whole image into a new buffer, then ReduceToDisplaySize's halvings.
+	std::unique_ptr<unsigned char[]> DecodeFullAndHalve(const Sample& sample, int maxDimension)
+	{
+		int width = sample.Width;
+		int height = sample.Height;
+		std::unique_ptr<unsigned char[]> pixels(new unsigned char[static_cast<size_t>(width) * height * 4]);
+		JpegDecoder::Decode(sample.Data.data(), sample.Data.size(), pixels.get(), static_cast<size_t>(width) * 4);
+		while (std::max(width, height) / 2 >= maxDimension)
+		{
+			int dstWidth = std::max(1, width / 2);
+			int dstHeight = std::max(1, height / 2);
+			MipGenerator::DownsampleBox(pixels.get(), width, height, static_cast<size_t>(width) * 4, pixels.get(),
+			                            static_cast<size_t>(dstWidth) * 4);
+			width = dstWidth;
+			height = dstHeight;
+		}
+		return pixels;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string corpus = Benchmark::GetArgument(argc, argv, "corpus", "");
+	int maxDimension = Benchmark::GetIntArgument(argc, argv, "max", 512);
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 3);
+
+	std::vector<Sample> samples = corpus.empty() ? MakeCorpus() : LoadCorpus(corpus);
+	std::printf("maxDimension %d\n\n", maxDimension);
+	std::printf("%-24s %11s %15s %13s %13s %9s\n", "image", "output", "full+box (ms)", "scaled (ms)",
+	            "libjpeg (ms)", "speedup");
+
+	for (const Sample& sample : samples)
+	{
+		JpegInfo info;
+		if (!JpegDecoder::ReadInfo(sample.Data.data(), sample.Data.size(), &info) || !JpegDecoder::IsSupported(info))
+		{
+			std::printf("%-24s not supported by JpegDecoder\n", sample.Name.c_str());
+			continue;
+		}
+
+		double full = Benchmark::MeasureBest(runs, [&] {
+			std::unique_ptr<unsigned char[]> pixels = DecodeFullAndHalve(sample, maxDimension);
+			Benchmark::DoNotOptimize(pixels[0]);
+		});
+
+		DecodedImage image;
+		double scaled = Benchmark::MeasureBest(runs, [&] {
+			ImageDecoder::DecodeMemory(sample.Data.data(), sample.Data.size(), image, maxDimension);
+			Benchmark::DoNotOptimize(image.Pixels);
+		});
+
+		// libjpeg scales by at most 8 and leaves the rest undone, which flatters it for large images.
+		int reduction = 0;
+		for (int size = std::max(sample.Width, sample.Height); size / 2 >= maxDimension && reduction < 3; size /= 2)
+			reduction++;
+		double libjpeg = Benchmark::MeasureBest(runs, [&] {
+			int width = 0;
+			int height = 0;
+			std::vector<unsigned char> rgba =
+				TestImages::DecodeJpegScaled(sample.Data, 1 << reduction, &width, &height);
+			Benchmark::DoNotOptimize(rgba[0]);
+		});
+
+		char output[32];
+		std::snprintf(output, sizeof(output), "%dx%d", image.Width, image.Height);
+		std::printf("%-24s %11s %15.2f %13.2f %13.2f %8.1fx\n", sample.Name.c_str(), output, full * 1000.0,
+		            scaled * 1000.0, libjpeg * 1000.0, full / scaled);
+	}
+	return 0;
+}
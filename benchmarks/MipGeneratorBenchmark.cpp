@@ -0,0 +1,44 @@
+#include "Benchmark.h"
+#include "image/MipGenerator.h"
+
+#include <vector>
+
+// Throughput of the 2x2 box filter, SIMD against the scalar reference, for one level and for a whole chain,
+// in megapixels of source per second. Options: --runs=<timed runs per row>.
+
+int main(int argc, char** argv)
+{
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 5);
+
+	std::printf("%-12s %14s %14s %9s %14s\n", "size", "SIMD (MP/s)", "scalar (MP/s)", "speedup", "chain (ms)");
+	for (auto [width, height] : {std::pair{1024, 1024}, {1920, 1080}, {4096, 4096}, {8192, 8192}})
+	{
+		size_t pitch = static_cast<size_t>(width) * 4;
+		std::vector<unsigned char> src(pitch * height);
+		for (size_t i = 0; i < src.size(); i++)
+			src[i] = static_cast<unsigned char>(i * 2654435761u >> 13);
+		std::vector<unsigned char> dst(pitch * height / 4);
+
+		double simd = Benchmark::MeasureBest(runs, [&] {
+			MipGenerator::DownsampleBox(src.data(), width, height, pitch, dst.data(), pitch / 2);
+			Benchmark::DoNotOptimize(dst[0]);
+		});
+		double scalar = Benchmark::MeasureBest(runs, [&] {
+			MipGenerator::DownsampleBoxReference(src.data(), width, height, pitch, dst.data(), pitch / 2);
+			Benchmark::DoNotOptimize(dst[0]);
+		});
+
+		std::vector<unsigned char> chain(MipGenerator::GetMipChainSize(width, height));
+		double chainTime = Benchmark::MeasureBest(runs, [&] {
+			MipGenerator::FillMipChain(src.data(), width, height, pitch, chain.data());
+			Benchmark::DoNotOptimize(chain[0]);
+		});
+
+		double megapixels = static_cast<double>(width) * height / 1e6;
+		char size[32];
+		std::snprintf(size, sizeof(size), "%dx%d", width, height);
+		std::printf("%-12s %14.0f %14.0f %8.1fx %14.2f\n", size, megapixels / simd, megapixels / scalar,
+		            scalar / simd, chainTime * 1000.0);
+	}
+	return 0;
+}
@@ -0,0 +1,64 @@
+#include "Benchmark.h"
+#include "image/PixelConvert.h"
+
+#include <vector>
+
+// Throughput of the dispatched row converters against their scalar references, converting a whole image row by
+// row the way the decoders call them, in megapixels per second. Options: --size=<image side> --runs=<timed runs>.
+
+namespace
+{
+	using RowFn = void (*)(const uint8_t* src, uint8_t* dst, int width);
+
+	struct Converter
+	{
+		const char* Name;
+		int SrcChannels;
+		RowFn Dispatched;
+		RowFn Reference;
+	};
+
+	double ConvertImage(RowFn convert, const std::vector<uint8_t>& src, int srcChannels, std::vector<uint8_t>& dst,
+	                    int size, int runs)
+	{
+		size_t srcPitch = static_cast<size_t>(size) * srcChannels;
+		size_t dstPitch = static_cast<size_t>(size) * 4;
+		return Benchmark::MeasureBest(runs, [&] {
+			for (int y = 0; y < size; y++)
+				convert(src.data() + srcPitch * y, dst.data() + dstPitch * y, size);
+			Benchmark::DoNotOptimize(dst[0]);
+		});
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int size = Benchmark::GetIntArgument(argc, argv, "size", 4096);
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 5);
+
+	const Converter converters[] = {
+		{"RGB", 3, PixelConvert::RgbToRgba, PixelConvert::RgbToRgbaReference},
+		{"BGR", 3, PixelConvert::BgrToRgba, PixelConvert::BgrToRgbaReference},
+		{"BGRA", 4, PixelConvert::BgraToRgba, PixelConvert::BgraToRgbaReference},
+		{"gray", 1, PixelConvert::GrayToRgba, PixelConvert::GrayToRgbaReference},
+		{"gray+alpha", 2, PixelConvert::GrayAlphaToRgba, PixelConvert::GrayAlphaToRgbaReference},
+	};
+
+	std::vector<uint8_t> src(static_cast<size_t>(size) * size * 4);
+	for (size_t i = 0; i < src.size(); i++)
+		src[i] = static_cast<uint8_t>(i * 2654435761u >> 13);
+	std::vector<uint8_t> dst(static_cast<size_t>(size) * size * 4);
+
+	std::printf("%dx%d, kernels: %s\n\n", size, size, PixelConvert::GetKernelName());
+	std::printf("%-12s %16s %16s %9s %14s\n", "layout", "kernel (MP/s)", "scalar (MP/s)", "speedup", "kernel (GB/s)");
+	double megapixels = static_cast<double>(size) * size / 1e6;
+	for (const Converter& converter : converters)
+	{
+		double kernel = ConvertImage(converter.Dispatched, src, converter.SrcChannels, dst, size, runs);
+		double scalar = ConvertImage(converter.Reference, src, converter.SrcChannels, dst, size, runs);
+		double bytes = static_cast<double>(size) * size * (converter.SrcChannels + 4);
+		std::printf("%-12s %16.0f %16.0f %8.1fx %14.2f\n", converter.Name, megapixels / kernel, megapixels / scalar,
+		            scalar / kernel, bytes / kernel / 1e9);
+	}
+	return 0;
+}
@@ -0,0 +1,77 @@
+#include "Benchmark.h"
+#include "TestImages.h"
+#include "core/ThreadPool.h"
+#include "image/PngDecoder.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "stb/stb_image.h"
+
+// Decoding one large RGB PNG: stb_image, PngDecoder on the calling thread, and PngDecoder across a ThreadPool,
+// for a plain deflate stream and for one full-flushed every 64 rows (pigz -i), which lets inflate run in
+// parallel too. Sizes are square, 4K to 16K; a 16K image needs about 4 GB of memory.
+// Options: --max=<largest side> --threads=<pool size> --runs=<timed runs>.
+
+int main(int argc, char** argv)
+{
+	int maxSize = Benchmark::GetIntArgument(argc, argv, "max", 16384);
+	int numThreads = Benchmark::GetIntArgument(argc, argv, "threads", 0);
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 3);
+
+	ThreadPool pool;
+	pool.Start(numThreads);
+	std::printf("%d pool threads, %d hardware threads\n\n", pool.GetNumThreads(),
+	            static_cast<int>(std::thread::hardware_concurrency()));
+	std::printf("%-8s %-12s %10s %11s %11s %11s %9s\n", "size", "stream", "PNG (MB)", "stb (ms)", "serial (ms)",
+	            "pool (ms)", "speedup");
+
+	for (int size : {4096, 8192, 16384})
+	{
+		if (size > maxSize)
+			break;
+		std::vector<std::vector<unsigned char>> pngs;
+		{
+			std::vector<unsigned char> pixels = TestImages::MakePhoto(size, size, 3, size);
+			for (int fullFlushRows : {0, 64})
+			{
+				TestImages::PngOptions options;
+				options.ColorType = 2;
+				options.Level = 1;
+				options.FullFlushRows = fullFlushRows;
+				pngs.push_back(TestImages::EncodePng(pixels.data(), size, size, options));
+			}
+		}
+
+		size_t rowPitch = static_cast<size_t>(size) * 4;
+		std::unique_ptr<unsigned char[]> rgba(new unsigned char[rowPitch * size]);
+		for (size_t i = 0; i < pngs.size(); i++)
+		{
+			const std::vector<unsigned char>& png = pngs[i];
+			double stb = Benchmark::MeasureBest(runs, [&] {
+				int width, height, channels;
+				stbi_uc* pixels = stbi_load_from_memory(png.data(), static_cast<int>(png.size()), &width, &height,
+				                                        &channels, 4);
+				Benchmark::DoNotOptimize(pixels);
+				stbi_image_free(pixels);
+			});
+			double serial = Benchmark::MeasureBest(runs, [&] {
+				PngDecoder::Decode(png.data(), png.size(), rgba.get(), rowPitch, nullptr);
+				Benchmark::DoNotOptimize(rgba[0]);
+			});
+			double parallel = Benchmark::MeasureBest(runs, [&] {
+				PngDecoder::Decode(png.data(), png.size(), rgba.get(), rowPitch, &pool);
+				Benchmark::DoNotOptimize(rgba[0]);
+			});
+
+			std::string label = std::to_string(size / 1024) + "K";
+			std::printf("%-8s %-12s %10.1f %11.0f %11.0f %11.0f %8.1fx\n", label.c_str(),
+			            i == 0 ? "plain" : "full flush", Benchmark::ToMegabytes(static_cast<double>(png.size())),
+			            stb * 1000.0, serial * 1000.0, parallel * 1000.0, stb / parallel);
+		}
+	}
+	return 0;
+}
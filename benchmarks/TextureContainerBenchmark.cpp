@@ -0,0 +1,68 @@
+#include "Benchmark.h"
+#include "TestImages.h"
+#include "image/ImageDecoder.h"
+#include "image/MipGenerator.h"
+#include "image/TextureContainer.h"
+
+#include <string>
+#include <vector>
+
+// What it costs to get a mipmapped texture ready for upload from a PNG (decode to RGBA8, then build the chain)
+// and from DDS and KTX2 files whose BC blocks and mip chain are used as they are, along with the video memory
+// each texture takes. Options: --size=<image side> --runs=<timed runs>.
+
+namespace
+{
+	size_t GetTextureSize(const DecodedImage& image)
+	{
+		size_t size = 0;
+		int width = image.Width;
+		int height = image.Height;
+		for (int level = 0; level < image.MipLevels; level++)
+		{
+			size += TextureFormats::GetLevelSize(image.Format, width, height);
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+		}
+		return size;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int size = Benchmark::GetIntArgument(argc, argv, "size", 4096);
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 5);
+	int mipLevels = MipGenerator::GetMipLevelCount(size, size);
+
+	struct Input
+	{
+		std::string Name;
+		std::vector<unsigned char> Data;
+	};
+	std::vector<Input> inputs;
+	{
+		std::vector<unsigned char> pixels = TestImages::MakePhoto(size, size, 4, 1);
+		TestImages::PngOptions options;
+		options.Level = 1;
+		inputs.push_back({"PNG (RGBA8)", TestImages::EncodePng(pixels.data(), size, size, options)});
+	}
+	inputs.push_back({"DDS BC7", TestImages::MakeDds(TextureFormat::Bc7, size, size, mipLevels, 2)});
+	inputs.push_back({"DDS BC1", TestImages::MakeDds(TextureFormat::Bc1, size, size, mipLevels, 3)});
+	inputs.push_back({"KTX2 BC7", TestImages::MakeKtx2(TextureFormat::Bc7, size, size, mipLevels, 4)});
+
+	std::printf("%dx%d with a full mip chain\n\n", size, size);
+	std::printf("%-14s %10s %10s %14s\n", "file", "file (MB)", "load (ms)", "texture (MB)");
+	for (const Input& input : inputs)
+	{
+		DecodedImage image;
+		double seconds = Benchmark::MeasureBest(runs, [&] {
+			ImageDecoder::DecodeMemory(input.Data.data(), input.Data.size(), image);
+			MipGenerator::GenerateMipChain(image); // leaves block-compressed images alone
+			Benchmark::DoNotOptimize(image.Pixels);
+		});
+		std::printf("%-14s %10.1f %10.2f %14.1f\n", input.Name.c_str(),
+		            Benchmark::ToMegabytes(static_cast<double>(input.Data.size())), seconds * 1000.0,
+		            Benchmark::ToMegabytes(static_cast<double>(GetTextureSize(image))));
+	}
+	return 0;
+}
@@ -0,0 +1,151 @@
+#include "Benchmark.h"
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Scheduling overhead of ThreadPool against a pool with one shared queue, the usual first design: tiny tasks
+// submitted from outside, tasks fanned out from inside a worker (where the work-stealing pool keeps them in the
+// worker's own deque), and ParallelFor over small bodies. Times are per task.
+// Options: --tasks=<tasks per row> --runs=<timed runs>.
+
+namespace
+{
+	// One mutex, one deque, one condition variable.
+	class SharedQueuePool
+	{
+	public:
+		void Start(int numThreads)
+		{
+			m_stopping = false;
+			for (int i = 0; i < numThreads; i++)
+				m_threads.emplace_back([this] { WorkerMain(); });
+		}
+
+		void Shutdown()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stopping = true;
+			}
+			m_wake.notify_all();
+			for (std::thread& thread : m_threads)
+				thread.join();
+			m_threads.clear();
+		}
+
+		void Submit(std::function<void()> task)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_tasks.push_back(std::move(task));
+				m_numUnfinished++;
+			}
+			m_wake.notify_one();
+		}
+
+		void WaitIdle()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_idle.wait(lock, [this] { return m_numUnfinished == 0; });
+		}
+
+	private:
+		void WorkerMain()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			for (;;)
+			{
+				m_wake.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+				if (m_stopping)
+					return;
+				std::function<void()> task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+				lock.unlock();
+				task();
+				lock.lock();
+				if (--m_numUnfinished == 0)
+					m_idle.notify_all();
+			}
+		}
+
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_idle;
+		std::deque<std::function<void()>> m_tasks;
+		std::vector<std::thread> m_threads;
+		size_t m_numUnfinished = 0;
+		bool m_stopping = false;
+	};
+
+	// A few hundred nanoseconds of arithmetic, about what scheduling one task costs.
+	void SmallWork(std::atomic<uint64_t>& sink, uint64_t seed)
+	{
+		uint64_t value = seed;
+		for (int i = 0; i < 64; i++)
+			value = value * 6364136223846793005ull + 1442695040888963407ull;
+		sink.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	template <typename TPool>
+	void Run(const char* name, int numThreads, int numTasks, int runs)
+	{
+		TPool pool;
+		pool.Start(numThreads);
+		std::atomic<uint64_t> sink = 0;
+
+		double outside = Benchmark::MeasureBest(runs, [&] {
+			for (int i = 0; i < numTasks; i++)
+				pool.Submit([&sink, i] { SmallWork(sink, i); });
+			pool.WaitIdle();
+		});
+
+		double fanOut = Benchmark::MeasureBest(runs, [&] {
+			pool.Submit([&] {
+				for (int i = 0; i < numTasks; i++)
+					pool.Submit([&sink, i] { SmallWork(sink, i); });
+			});
+			pool.WaitIdle();
+		});
+
+		double parallelFor = 0.0;
+		if constexpr (std::is_same_v<TPool, ThreadPool>)
+		{
+			parallelFor = Benchmark::MeasureBest(runs, [&] {
+				pool.ParallelFor(numTasks, [&](int i) { SmallWork(sink, i); });
+			});
+		}
+		pool.Shutdown();
+		Benchmark::DoNotOptimize(sink);
+
+		std::printf("%-8d %-14s %16.0f %16.0f", numThreads, name, outside * 1e9 / numTasks, fanOut * 1e9 / numTasks);
+		if (parallelFor > 0.0)
+			std::printf(" %16.0f\n", parallelFor * 1e9 / numTasks);
+		else
+			std::printf(" %16s\n", "-");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int numTasks = Benchmark::GetIntArgument(argc, argv, "tasks", 200000);
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 5);
+	int hardwareThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+	std::printf("%d hardware threads, %d tasks\n\n", hardwareThreads, numTasks);
+	std::printf("%-8s %-14s %16s %16s %16s\n", "threads", "pool", "outside (ns)", "fan-out (ns)",
+	            "ParallelFor (ns)");
+	for (int numThreads : {1, 2, 4, hardwareThreads})
+	{
+		Run<ThreadPool>("work-stealing", numThreads, numTasks, runs);
+		Run<SharedQueuePool>("shared queue", numThreads, numTasks, runs);
+	}
+	return 0;
+}
@@ -0,0 +1,114 @@
+#include "Benchmark.h"
+#include "image/TilePyramid.h"
+#include "image/TileResidency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <tuple>
+#include <vector>
+
+// The CPU side of tiled display. Build is the mip chain of a large image; CopyTile is filling a bordered slot
+// in the upload buffer; a frame is Update, AllocateUploads and GetDraws for a 1080p view panning and zooming
+// over a gigapixel layout on a fixed path, so runs are comparable.
+// Options: --width=<pixels> --height=<pixels> --frames=<frames per path> --runs=<timed runs>.
+
+namespace
+{
+	// Zooms out from 1:1 to the whole image and back while drifting across it, one full cycle per path.
+	TileView GetPathView(const TileLayout& layout, int frame, int numFrames)
+	{
+		const float screenWidth = 1920.0f;
+		const float screenHeight = 1080.0f;
+		float t = static_cast<float>(frame) / static_cast<float>(numFrames);
+		float maxZoom = std::log2(static_cast<float>(layout.Width) / screenWidth);
+		float texelsPerPixel = std::exp2(maxZoom * 0.5f * (1.0f - std::cos(t * 6.2831853f)));
+		float width = screenWidth * texelsPerPixel;
+		float height = screenHeight * texelsPerPixel;
+		float centreX = layout.Width * (0.2f + 0.6f * t);
+		float centreY = layout.Height * (0.5f + 0.3f * std::sin(t * 12.566371f));
+		return TileView{centreX - width / 2, centreY - height / 2, centreX + width / 2, centreY + height / 2,
+		                screenWidth, screenHeight};
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int width = Benchmark::GetIntArgument(argc, argv, "width", 8192);
+	int height = Benchmark::GetIntArgument(argc, argv, "height", 4096);
+	int numFrames = Benchmark::GetIntArgument(argc, argv, "frames", 2000);
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 3);
+
+	std::vector<unsigned char> rgba(static_cast<size_t>(width) * height * 4);
+	for (size_t i = 0; i < rgba.size(); i++)
+		rgba[i] = static_cast<unsigned char>(i * 2654435761u >> 13);
+
+	double buildSeconds = 1e30;
+	TilePyramid pyramid;
+	for (int run = 0; run < runs; run++)
+	{
+		DecodedImage image;
+		image.Width = width;
+		image.Height = height;
+		image.SourceWidth = width;
+		image.SourceHeight = height;
+		image.Pixels = ImageDecoder::AllocatePixels(rgba.size());
+		std::memcpy(image.Pixels, rgba.data(), rgba.size());
+		Benchmark::Clock::time_point start = Benchmark::Clock::now();
+		pyramid.Build(std::move(image));
+		buildSeconds = std::min(buildSeconds, Benchmark::GetSeconds(start, Benchmark::Clock::now()));
+	}
+	const TileLayout& layout = pyramid.GetLayout();
+	std::printf("%dx%d, %d levels, %.1f MB\n\n", width, height, layout.NumLevels,
+	            Benchmark::ToMegabytes(static_cast<double>(pyramid.GetSizeInBytes())));
+	std::printf("%-28s %10.1f ms\n", "Build", buildSeconds * 1000.0);
+
+	// Every tile of level 0 into one slot, at the D3D12 row pitch alignment.
+	const size_t rowPitch = (APP_TILE_SLOT_SIZE * 4 + 255) / 256 * 256;
+	std::vector<unsigned char> slot(rowPitch * APP_TILE_SLOT_SIZE);
+	int numTiles = layout.GetTilesX(0) * layout.GetTilesY(0);
+	double copySeconds = Benchmark::MeasureBest(runs, [&] {
+		for (int y = 0; y < layout.GetTilesY(0); y++)
+		{
+			for (int x = 0; x < layout.GetTilesX(0); x++)
+				pyramid.CopyTile({0, x, y}, slot.data(), rowPitch);
+		}
+		Benchmark::DoNotOptimize(slot[0]);
+	});
+	double slotBytes = static_cast<double>(APP_TILE_SLOT_SIZE) * APP_TILE_SLOT_SIZE * 4 * numTiles;
+	std::printf("%-28s %10.1f GB/s %8.2f us/tile\n\n", "CopyTile", slotBytes / copySeconds / 1e9,
+	            copySeconds * 1e6 / numTiles);
+
+	// Residency over a layout far larger than anything decoded here; it never touches pixels.
+	std::printf("%-28s %10s %10s %10s %10s\n", "residency, 1080p view", "us/frame", "draws", "uploads", "evictions");
+	for (auto [gigaWidth, gigaHeight, numSlots] : {std::tuple{65536, 32768, 256}, {131072, 65536, 512}})
+	{
+		TileLayout gigaLayout = TileLayout::Make(gigaWidth, gigaHeight);
+		std::vector<TileUpload> uploads;
+		std::vector<TileDraw> draws;
+		TileResidencyStats stats;
+		size_t numDraws = 0;
+		double seconds = Benchmark::MeasureBest(runs, [&] {
+			TileResidency residency;
+			residency.Initialize(gigaLayout, numSlots, 3);
+			numDraws = 0;
+			for (int frame = 0; frame < numFrames; frame++)
+			{
+				TileView view = GetPathView(gigaLayout, frame, numFrames);
+				residency.Update(view, static_cast<uint64_t>(frame) + 1);
+				uploads.clear();
+				residency.AllocateUploads(8, uploads);
+				draws.clear();
+				residency.GetDraws(view, draws);
+				numDraws += draws.size();
+			}
+			stats = residency.GetStats();
+		});
+		char name[64];
+		std::snprintf(name, sizeof(name), "%dx%d, %d slots", gigaWidth, gigaHeight, numSlots);
+		std::printf("%-28s %10.2f %10.1f %10llu %10llu\n", name, seconds * 1e6 / numFrames,
+		            static_cast<double>(numDraws) / numFrames, static_cast<unsigned long long>(stats.Uploads),
+		            static_cast<unsigned long long>(stats.Evictions));
+	}
+	return 0;
+}
@@ -0,0 +1,186 @@
+#include "Benchmark.h"
+#include "render/TlsfAllocator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <vector>
+
+// TlsfAllocator against an address-ordered first-fit free list, the simple alternative, on one texture heap
+// block under a fixed, seeded stream of allocations and frees with texture-like sizes and alignments, filling
+// the block to different levels. Fails are allocations that found no room (TLSF / first fit). Also what the
+// textures live at the end occupy placed at 4 KB and as committed resources, each rounded up to 64 KB.
+// Options: --ops=<allocations per run> --live=<textures kept alive> --runs=<timed runs>.
+
+namespace
+{
+	const uint64_t KB = 1024;
+	const uint64_t MB = 1024 * KB;
+
+	struct Request
+	{
+		uint64_t Size;
+		uint64_t Alignment;
+	};
+
+	// Mostly icons and thumbnails at 4 KB placement, some full images at 64 KB.
+	std::vector<Request> MakeRequests(int count)
+	{
+		std::vector<Request> requests(count);
+		uint64_t state = 7;
+		auto next = [&state] {
+			state = state * 6364136223846793005ull + 1442695040888963407ull;
+			return state >> 33;
+		};
+		for (Request& request : requests)
+		{
+			bool large = next() % 10 == 0;
+			request.Size = large ? 256 * KB + next() % (4 * MB) : 4 * KB + next() % (60 * KB);
+			request.Alignment = large ? 64 * KB : 4 * KB;
+		}
+		return requests;
+	}
+
+	// First fit over free ranges kept in address order, merged on free.
+	class FirstFitAllocator
+	{
+	public:
+		explicit FirstFitAllocator(uint64_t capacity) { m_free[0] = capacity; }
+
+		bool Allocate(uint64_t size, uint64_t alignment, uint64_t* out_offset)
+		{
+			size = (size + 4 * KB - 1) & ~(4 * KB - 1);
+			for (auto it = m_free.begin(); it != m_free.end(); ++it)
+			{
+				uint64_t start = (it->first + alignment - 1) & ~(alignment - 1);
+				uint64_t end = it->first + it->second;
+				if (start + size > end)
+					continue;
+				uint64_t offset = it->first;
+				m_free.erase(it);
+				if (start > offset)
+					m_free[offset] = start - offset;
+				if (end > start + size)
+					m_free[start + size] = end - start - size;
+				*out_offset = start;
+				return true;
+			}
+			return false;
+		}
+
+		void Free(uint64_t offset, uint64_t size)
+		{
+			size = (size + 4 * KB - 1) & ~(4 * KB - 1);
+			auto next = m_free.lower_bound(offset);
+			if (next != m_free.end() && next->first == offset + size)
+			{
+				size += next->second;
+				next = m_free.erase(next);
+			}
+			if (next != m_free.begin() && std::prev(next)->first + std::prev(next)->second == offset)
+			{
+				std::prev(next)->second += size;
+				return;
+			}
+			m_free[offset] = size;
+		}
+
+	private:
+		std::map<uint64_t, uint64_t> m_free; // offset to size
+	};
+
+	struct Result
+	{
+		double Seconds = 0.0;
+		int Failures = 0;
+	};
+
+	// Keeps up to live textures, replacing a pseudo-random one once full. Allocate and free are both timed.
+	template <typename TAllocate, typename TFree>
+	Result Run(const std::vector<Request>& requests, int live, int runs, TAllocate&& allocate, TFree&& free)
+	{
+		Result result;
+		result.Seconds = Benchmark::MeasureBest(runs, [&] {
+			std::vector<std::pair<int, uint64_t>> slots; // request index and what allocate returned
+			slots.reserve(live);
+			result.Failures = 0;
+			for (int i = 0; i < static_cast<int>(requests.size()); i++)
+			{
+				if (static_cast<int>(slots.size()) == live)
+				{
+					size_t victim = (static_cast<size_t>(i) * 2654435761u) % slots.size();
+					free(slots[victim].first, slots[victim].second);
+					slots[victim] = slots.back();
+					slots.pop_back();
+				}
+				uint64_t handle;
+				if (allocate(i, &handle))
+					slots.emplace_back(i, handle);
+				else
+					result.Failures++;
+			}
+			for (const auto& [index, handle] : slots)
+				free(index, handle);
+		});
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int numOps = Benchmark::GetIntArgument(argc, argv, "ops", 200000);
+	int runs = Benchmark::GetIntArgument(argc, argv, "runs", 5);
+	const uint64_t capacity = 256 * MB;
+	std::vector<Request> requests = MakeRequests(numOps);
+
+	std::printf("%.0f MB heap, %d allocations\n\n", Benchmark::ToMegabytes(static_cast<double>(capacity)), numOps);
+	std::printf("%-8s %14s %14s %9s %13s %10s %12s %15s\n", "live", "TLSF (ns/op)", "first fit", "speedup",
+	            "fails", "frag. (%)", "placed (MB)", "committed (MB)");
+	int defaultLive = Benchmark::GetIntArgument(argc, argv, "live", 0);
+	std::vector<int> lives = defaultLive > 0 ? std::vector<int>{defaultLive} : std::vector<int>{100, 400, 800};
+	for (int live : lives)
+	{
+		TlsfAllocator tlsf;
+		tlsf.Initialize(capacity, 4 * KB);
+		std::vector<TlsfAllocation> tlsfAllocations(requests.size());
+		float fragmentation = 0.0f;
+		Result tlsfResult = Run(
+			requests, live, runs,
+			[&](int index, uint64_t* out_handle) {
+				*out_handle = static_cast<uint64_t>(index);
+				bool allocated = tlsf.Allocate(requests[index].Size, requests[index].Alignment,
+				                               &tlsfAllocations[index]);
+				// Sampled once the heap has settled, just before everything is released.
+				if (index == static_cast<int>(requests.size()) - 1)
+					fragmentation = tlsf.GetStats().GetFragmentation();
+				return allocated;
+			},
+			[&](int index, uint64_t) { tlsf.Free(tlsfAllocations[index]); });
+
+		FirstFitAllocator firstFit(capacity);
+		Result firstFitResult = Run(
+			requests, live, runs,
+			[&](int index, uint64_t* out_offset) {
+				return firstFit.Allocate(requests[index].Size, requests[index].Alignment, out_offset);
+			},
+			[&](int index, uint64_t offset) { firstFit.Free(offset, requests[index].Size); });
+
+		// The last live textures, placed at 4 KB granularity and as committed resources.
+		uint64_t placedBytes = 0;
+		uint64_t committedBytes = 0;
+		for (size_t i = requests.size() - std::min<size_t>(live, requests.size()); i < requests.size(); i++)
+		{
+			placedBytes += (requests[i].Size + 4 * KB - 1) / (4 * KB) * (4 * KB);
+			committedBytes += (requests[i].Size + 64 * KB - 1) / (64 * KB) * (64 * KB);
+		}
+
+		double tlsfNs = tlsfResult.Seconds * 1e9 / (2.0 * numOps);
+		double firstFitNs = firstFitResult.Seconds * 1e9 / (2.0 * numOps);
+		std::printf("%-8d %14.1f %14.1f %8.1fx %6d/%-6d %10.1f %12.1f %15.1f\n", live, tlsfNs, firstFitNs,
+		            firstFitNs / tlsfNs, tlsfResult.Failures, firstFitResult.Failures, fragmentation * 100.0f,
+		            Benchmark::ToMegabytes(static_cast<double>(placedBytes)),
+		            Benchmark::ToMegabytes(static_cast<double>(committedBytes)));
+	}
+	return 0;
+}
@@ -0,0 +1,203 @@
+#include "Benchmark.h"
+#include "image/MipGenerator.h"
+#include "render/UploadRingAllocator.h"
+#include "render/UploadScheduler.h"
+
+#include <vector>
+
+// Loading a folder the old way (one submission, barrier and CPU wait per image) against one batch, through the
+// same scheduler, ring and footprint rules Dx12UploadQueue uses. The D3D12 objects are replaced by a recording
+// mock that counts command list calls, submissions, fence waits and staged bytes instead of executing them.
+// Options: --count=<images per folder> --size=<largest image side>.
+
+namespace
+{
+	constexpr uint64_t RING_SIZE = 64ull * 1024 * 1024; // APP_UPLOAD_RING_SIZE
+	constexpr uint64_t PLACEMENT_ALIGNMENT = 512; // D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
+	constexpr uint64_t PITCH_ALIGNMENT = 256; // D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+
+	struct MockStats
+	{
+		uint64_t Submissions = 0;
+		uint64_t FenceWaits = 0;
+		uint64_t CopyCalls = 0;
+		uint64_t BarrierCalls = 0;
+		uint64_t Barriers = 0;
+		uint64_t StagedBytes = 0;
+		uint64_t DedicatedBuffers = 0; // staging the ring could not hold
+	};
+
+	// The copy queue; the GPU finishes whatever is waited for.
+	class RecordingQueue : public IUploadQueue
+	{
+	public:
+		explicit RecordingQueue(MockStats& stats) : m_stats(stats) {}
+
+		void Execute(uint32_t) override { m_stats.Submissions++; }
+		void Signal(uint64_t fenceValue) override { m_signaled = fenceValue; }
+		uint64_t GetCompletedValue() const override { return m_completed; }
+		void WaitForValue(uint64_t fenceValue) override
+		{
+			m_stats.FenceWaits++;
+			m_completed = fenceValue <= m_signaled ? fenceValue : m_signaled;
+		}
+
+	private:
+		MockStats& m_stats;
+		uint64_t m_signaled = 0;
+		uint64_t m_completed = 0;
+	};
+
+	// Dx12UploadQueue with its command list reduced to counters.
+	class RecordingUploadQueue
+	{
+	public:
+		RecordingUploadQueue() : m_queue(m_stats)
+		{
+			m_scheduler.Initialize(&m_queue, 4);
+			m_ring.Initialize(RING_SIZE);
+		}
+
+		void BeginUpload()
+		{
+			m_ring.Retire(m_scheduler.GetCompletedValue());
+			m_context = m_scheduler.AcquireContext();
+		}
+
+		void AllocateStaging(uint64_t size)
+		{
+			if (m_ring.Allocate(size, PLACEMENT_ALIGNMENT) == UploadRingAllocator::INVALID_OFFSET)
+			{
+				m_scheduler.WaitIdle();
+				m_ring.Retire(m_scheduler.GetCompletedValue());
+				if (m_ring.Allocate(size, PLACEMENT_ALIGNMENT) == UploadRingAllocator::INVALID_OFFSET)
+					m_stats.DedicatedBuffers++;
+			}
+			m_stats.StagedBytes += size;
+		}
+
+		void CopyTextureRegion() { m_stats.CopyCalls++; }
+		void QueueTransition() { m_pendingBarriers++; }
+
+		uint64_t EndUpload()
+		{
+			if (m_pendingBarriers != 0)
+			{
+				m_stats.BarrierCalls++;
+				m_stats.Barriers += m_pendingBarriers;
+				m_pendingBarriers = 0;
+			}
+			uint64_t fenceValue = m_scheduler.Submit(m_context);
+			m_ring.Submit(fenceValue);
+			return fenceValue;
+		}
+
+		void WaitForValue(uint64_t fenceValue) { m_scheduler.WaitForValue(fenceValue); }
+
+		const MockStats& GetStats() const { return m_stats; }
+
+	private:
+		MockStats m_stats;
+		RecordingQueue m_queue;
+		UploadScheduler m_scheduler;
+		UploadRingAllocator m_ring;
+		uint32_t m_context = 0;
+		uint64_t m_pendingBarriers = 0;
+	};
+
+	struct Image
+	{
+		int Width;
+		int Height;
+		int MipLevels;
+	};
+
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// What GetCopyableFootprints returns for an RGBA8 mip chain: pitch-aligned rows, placement-aligned levels.
+	uint64_t GetUploadSize(const Image& image)
+	{
+		uint64_t size = 0;
+		int width = image.Width;
+		int height = image.Height;
+		for (int level = 0; level < image.MipLevels; level++)
+		{
+			size = AlignUp(size, PLACEMENT_ALIGNMENT);
+			uint64_t rowPitch = static_cast<uint64_t>(width) * 4;
+			size += AlignUp(rowPitch, PITCH_ALIGNMENT) * (height - 1) + rowPitch;
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+		}
+		return size;
+	}
+
+	void RecordImage(RecordingUploadQueue& queue, const Image& image)
+	{
+		queue.AllocateStaging(GetUploadSize(image));
+		for (int level = 0; level < image.MipLevels; level++)
+			queue.CopyTextureRegion();
+		queue.QueueTransition();
+	}
+
+	void PrintRow(const char* label, const MockStats& stats, int numImages, double seconds)
+	{
+		std::printf("%-12s %11llu %10llu %13llu %9llu %10llu %10.2f %9.2f\n", label,
+		            static_cast<unsigned long long>(stats.Submissions),
+		            static_cast<unsigned long long>(stats.FenceWaits),
+		            static_cast<unsigned long long>(stats.BarrierCalls),
+		            static_cast<unsigned long long>(stats.Barriers),
+		            static_cast<unsigned long long>(stats.DedicatedBuffers),
+		            Benchmark::ToMegabytes(static_cast<double>(stats.StagedBytes)) / numImages,
+		            seconds * 1e6 / numImages);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int count = Benchmark::GetIntArgument(argc, argv, "count", 256);
+	int maxSize = Benchmark::GetIntArgument(argc, argv, "size", 1024);
+
+	// A folder of mixed sizes, from icons to photos.
+	std::vector<Image> images;
+	for (int i = 0; i < count; i++)
+	{
+		int width = maxSize >> (i % 7);
+		width = width > 0 ? width : 1;
+		int height = width * 3 / 4 > 0 ? width * 3 / 4 : 1;
+		images.push_back({width, height, MipGenerator::GetMipLevelCount(width, height)});
+	}
+
+	std::printf("%d images up to %dx%d, RGBA8 with mips\n\n", count, maxSize, maxSize * 3 / 4);
+	std::printf("%-12s %11s %10s %13s %9s %10s %10s %9s\n", "path", "submissions", "CPU waits", "barrier calls",
+	            "barriers", "dedicated", "MB/image", "us/image");
+
+	// Before: every image is its own upload, and the loader waits for it before the next.
+	MockStats perImageStats;
+	double perImage = Benchmark::MeasureBest(5, [&] {
+		RecordingUploadQueue queue;
+		for (const Image& image : images)
+		{
+			queue.BeginUpload();
+			RecordImage(queue, image);
+			queue.WaitForValue(queue.EndUpload());
+		}
+		perImageStats = queue.GetStats();
+	});
+	PrintRow("per image", perImageStats, count, perImage);
+
+	// After: one command list, one barrier call, one fence signal; nobody waits on the CPU.
+	MockStats batchStats;
+	double batched = Benchmark::MeasureBest(5, [&] {
+		RecordingUploadQueue queue;
+		queue.BeginUpload();
+		for (const Image& image : images)
+			RecordImage(queue, image);
+		queue.EndUpload();
+		batchStats = queue.GetStats();
+	});
+	PrintRow("one batch", batchStats, count, batched);
+	return 0;
+}
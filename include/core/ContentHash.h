@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit XXH3 (seed 0, default secret) of a byte range, identical to the reference xxHash implementation so
+// values can be checked with any xxHash tool. Used to recognise files with the same bytes under different
+// paths. Inputs over 240 bytes are accumulated 64 bytes at a time with AVX2 or SSE2 when the CPU has them.
+namespace ContentHash
+{
+	uint64_t Hash64(const void* data, size_t size);
+
+	// Portable path that Hash64 dispatches away from; same results (for comparisons).
+	uint64_t Hash64Scalar(const void* data, size_t size);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// Instruction sets the SIMD kernels dispatch on, detected once at first use. Everything is false on CPUs
+// other than x86; NEON kernels are chosen at compile time instead.
+namespace Cpu
+{
+	struct Features
+	{
+		bool Sse2 = false;
+		bool Ssse3 = false;
+		bool Avx2 = false; // only when the OS also saves the YMM registers
+	};
+
+	const Features& GetFeatures();
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size work-stealing pool. Every worker owns a deque: tasks submitted from a worker go to the back
+// of its own deque and are popped LIFO (cache-warm), tasks from other threads are spread round-robin,
+// and idle workers steal FIFO from the front of the others. Platform-neutral.
+class ThreadPool
+{
+public:
+	using Task = std::function<void()>;
+
+	ThreadPool() = default;
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	~ThreadPool();
+
+	// numThreads <= 0 uses one thread per hardware thread.
+	void Start(int numThreads = 0);
+	// Runs every task already queued, and any those submit in turn (ParallelFor chunks included), then joins
+	// the workers. Tasks submitted after it returns are ignored until Start.
+	void Shutdown();
+
+	void Submit(Task task);
+	// Blocks until every submitted task has finished. Must not be called from a pool thread.
+	void WaitIdle();
+
+	// Runs body(0) .. body(count - 1) on the calling thread and on whichever workers are free, and returns
+	// once all of them have finished. Safe to call from a pool thread: when every worker is busy the caller
+	// simply runs the whole loop itself, so nesting cannot deadlock.
+	void ParallelFor(int count, const std::function<void(int)>& body);
+
+	int GetNumThreads() const { return static_cast<int>(m_threads.size()); }
+	uint64_t GetNumSteals() const { return m_numSteals.load(std::memory_order_relaxed); }
+
+	// Index of the calling pool thread in [0, GetNumThreads()), or -1 when called from outside this pool.
+	int GetCurrentWorkerIndex() const;
+
+private:
+	struct WorkerQueue
+	{
+		std::mutex Mutex;
+		std::deque<Task> Tasks;
+	};
+
+	void WorkerMain(int index);
+	bool TryPop(int index, Task& out_task);
+	bool TrySteal(int index, Task& out_task);
+
+	std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeWorkers;
+	std::condition_variable m_idle;
+	size_t m_numQueued = 0; // guarded by m_sleepMutex
+	size_t m_numUnfinished = 0; // guarded by m_sleepMutex
+	bool m_stopping = false;
+
+	std::atomic<uint32_t> m_nextQueue = 0;
+	std::atomic<uint64_t> m_numSteals = 0;
+};
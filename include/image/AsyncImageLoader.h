@@ -0,0 +1,119 @@
+#pragma once
+#include "core/ThreadPool.h"
+#include "image/BlockCompressor.h"
+#include "image/DiskTextureCache.h"
+#include "image/ImageDecoder.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using AsyncImageHandle = uint32_t;
+static constexpr AsyncImageHandle INVALID_ASYNC_IMAGE_HANDLE = 0;
+
+static constexpr uint64_t APP_MAX_DECODED_BYTES_IN_FLIGHT = 256ull * 1024 * 1024;
+
+// Receives decoded images on the thread that calls AsyncImageLoader::Publish. The D3D12 implementation
+// creates and uploads the texture; headless tools can plug in a fake one.
+class IAsyncTextureSink
+{
+public:
+	virtual ~IAsyncTextureSink() = default;
+
+	virtual void OnImageDecoded(AsyncImageHandle handle, const std::string& path, DecodedImage& image) = 0;
+	// The file has the same bytes and load options as an image handed over earlier, or just before in the same
+	// Publish call, and was not decoded again; see AsyncImageLoader::ReleaseContent.
+	virtual void OnImageShared(AsyncImageHandle handle, const std::string& path, uint64_t contentHash) = 0;
+	virtual void OnImageFailed(AsyncImageHandle handle, const std::string& path) = 0;
+};
+
+// Decodes requested files on a work-stealing ThreadPool. Requests carry a priority that can be changed
+// while they wait: workers always start the highest-priority queued request, and Publish hands finished
+// ones over highest priority first. Decoding pauses while decoded-but-unpublished images exceed the
+// byte cap (soft: images already being decoded still finish).
+// Files are hashed as they are read (DecodedImage::ContentHash), so a file whose bytes match an image that is
+// being decoded or that the sink holds, requested with the same size limit and compression, is not decoded
+// twice, whatever its path.
+class AsyncImageLoader
+{
+public:
+	AsyncImageLoader() = default;
+	AsyncImageLoader(const AsyncImageLoader&) = delete;
+	AsyncImageLoader& operator=(const AsyncImageLoader&) = delete;
+
+	~AsyncImageLoader();
+
+	// numWorkers <= 0 picks a count from the hardware concurrency.
+	void Start(int numWorkers = 0, uint64_t maxBytesInFlight = APP_MAX_DECODED_BYTES_IN_FLIGHT);
+	void Shutdown();
+
+	// Requests are looked up in the cache before decoding, and what is decoded is stored in it. Set before
+	// Start; nullptr (the default) decodes every time.
+	void SetDiskCache(DiskTextureCache* cache) { m_diskCache = cache; }
+
+	// Never blocks on I/O or decode; the returned handle is later passed to the sink. maxDimension is as
+	// for ImageDecoder::DecodeFile (0 = full resolution). Higher priorities go first; equal
+	// priorities keep request order. With compression enabled, images are block-compressed on the pool
+	// after their mip chain is built.
+	AsyncImageHandle Request(const std::string& path, int maxDimension = 0, int priority = 0,
+	                         const BlockCompressionOptions& compression = {});
+	// No effect once the request has been published.
+	void SetPriority(AsyncImageHandle handle, int priority);
+
+	// What requests share on, as DiskTextureCache::MakeKey keys on the options too: the hash of the file's
+	// bytes combined with the options that shape the decoded image, so a thumbnail and a full-size load of the
+	// same file stay apart. Never 0, except for an unknown (0) file hash.
+	static uint64_t MakeContentKey(uint64_t fileHash, int maxDimension, const BlockCompressionOptions& compression);
+
+	// Images handed to the sink are taken to stay resident, and later requests for the same bytes are
+	// published through OnImageShared. The sink calls this once it no longer holds the image.
+	void ReleaseContent(uint64_t contentHash);
+
+	// Hands at most maxImages finished decodes to the sink (0 = all of them). Returns how many were published.
+	int Publish(IAsyncTextureSink& sink, int maxImages = 0);
+
+	int GetNumPending() const;
+	uint64_t GetBytesInFlight() const;
+
+private:
+	struct Job
+	{
+		AsyncImageHandle Handle = INVALID_ASYNC_IMAGE_HANDLE;
+		std::string Path;
+		int MaxDimension = 0;
+		int Priority = 0;
+		BlockCompressionOptions Compression;
+		DecodedImage Image;
+		bool Succeeded = false;
+		bool Shared = false; // same bytes as an image the sink holds; Image is empty
+		std::vector<Job> Sharers; // requests for the same bytes that waited for this decode
+	};
+
+	static size_t FindHighestPriority(const std::vector<Job>& jobs);
+
+	// Submits decode tasks while there are queued jobs, idle workers and room under the byte cap.
+	// Called with m_mutex held.
+	void ScheduleLocked();
+	void DecodeTask();
+	// Returns true, having taken the job, when its content is resident or already being decoded; otherwise
+	// records that this job decodes it. Called with m_mutex held.
+	bool ShareContentLocked(Job& job, uint64_t contentHash);
+
+	ThreadPool m_pool;
+	DiskTextureCache* m_diskCache = nullptr;
+	mutable std::mutex m_mutex;
+	std::vector<Job> m_queued;
+	std::vector<Job> m_completed;
+	std::unordered_set<uint64_t> m_residentContent; // handed to the sink and not released since
+	std::unordered_map<uint64_t, std::vector<Job>> m_decodingContent; // until published, with the jobs waiting
+	AsyncImageHandle m_nextHandle = 1;
+	uint64_t m_maxBytesInFlight = 0;
+	uint64_t m_bytesInFlight = 0; // decoded and not yet published
+	int m_numWorkers = 0;
+	int m_numScheduled = 0; // decode tasks submitted to the pool and not yet finished
+	int m_numInFlight = 0;
+	bool m_running = false;
+};
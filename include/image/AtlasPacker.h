@@ -0,0 +1,135 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Edge texels repeated around every packed image, so bilinear filtering at its border never reads a neighbour.
+static constexpr int APP_ATLAS_PADDING = 1;
+
+// Identifies one packed image. Like DescriptorHandle it carries a generation, so a handle kept past its
+// Remove() no longer resolves even after the entry is reused.
+struct AtlasHandle
+{
+	uint32_t Index = UINT32_MAX;
+	uint32_t Generation = 0;
+
+	bool IsNull() const { return Index == UINT32_MAX; }
+};
+
+// Where a packed image sits: the page and its rectangle there, padding excluded.
+struct AtlasPlacement
+{
+	int Page = -1;
+	int X = 0;
+	int Y = 0;
+	int Width = 0;
+	int Height = 0;
+};
+
+// One image of an Insert() call; Handle is left null when it fits nowhere.
+struct AtlasRequest
+{
+	int Width = 0;
+	int Height = 0;
+	AtlasHandle Handle;
+};
+
+// An entry that Insert() moved while repacking its page. The repacked page starts from a blank texture, so
+// every entry left on it is listed, moved or not. Rectangles include the padding.
+struct AtlasMove
+{
+	AtlasHandle Entry;
+	int Page = 0;
+	int SrcX = 0;
+	int SrcY = 0;
+	int DstX = 0;
+	int DstY = 0;
+	int Width = 0;
+	int Height = 0;
+};
+
+struct AtlasPackerStats
+{
+	uint32_t NumPages = 0;
+	uint32_t NumEntries = 0;
+	uint64_t LiveArea = 0; // texels of the entries, padding included
+	uint64_t UsedArea = 0; // texels under the pages' skylines, including what removed entries left behind
+	uint64_t PageArea = 0;
+	uint64_t Repacks = 0;
+
+	// Share of the area packing has consumed that still holds images.
+	float GetEfficiency() const
+	{
+		return UsedArea == 0 ? 1.0f : static_cast<float>(LiveArea) / static_cast<float>(UsedArea);
+	}
+};
+
+// Packs small images into square pages with the skyline packer from imstb_rectpack. Inserts are incremental:
+// each call packs its batch, tallest first, on top of what the pages already hold. A skyline cannot reuse the
+// space of removed entries, so a page is reset once its last entry goes, and a batch that fits nowhere else
+// repacks pages that lost a quarter of their area before a new page is opened, and pages that lost less only
+// once no page can be added. Knows nothing about textures; TextureAtlas copies pixels to the places it picks.
+class AtlasPacker
+{
+public:
+	AtlasPacker();
+	~AtlasPacker();
+	AtlasPacker(AtlasPacker&& other) noexcept;
+	AtlasPacker& operator=(AtlasPacker&& other) noexcept;
+
+	AtlasPacker(const AtlasPacker&) = delete;
+	AtlasPacker& operator=(const AtlasPacker&) = delete;
+
+	void Initialize(int pageSize, int maxPages);
+	void Reset();
+
+	// Sets the handle of every request that was packed and returns how many were. Pages repacked on the way
+	// append the copies they need to out_moves; those must happen before anything is written to the new places.
+	int Insert(AtlasRequest* requests, size_t numRequests, std::vector<AtlasMove>& out_moves);
+	// Returns false for null or stale handles.
+	bool Remove(AtlasHandle handle);
+
+	bool IsValid(AtlasHandle handle) const;
+	// Page is -1 for handles that are not valid.
+	AtlasPlacement GetPlacement(AtlasHandle handle) const;
+
+	int GetPageSize() const { return m_pageSize; }
+	int GetNumPages() const { return static_cast<int>(m_pages.size()); }
+	bool IsPageEmpty(int page) const;
+	// Walks every page's skyline; meant for statistics, not for every frame's logic.
+	AtlasPackerStats GetStats() const;
+
+	// Copies an RGBA8 image into dst surrounded by APP_ATLAS_PADDING repeated edge texels, so dst takes
+	// (width + 2 * APP_ATLAS_PADDING) x (height + 2 * APP_ATLAS_PADDING) texels.
+	static void CopyWithPadding(const unsigned char* pixels, size_t rowPitch, int width, int height,
+	                            unsigned char* dst, size_t dstRowPitch);
+
+private:
+	struct Page; // the skyline state; defined next to imstb_rectpack in the .cpp
+
+	struct Entry
+	{
+		int Page = -1; // -1 while unused
+		int X = 0; // padded rectangle
+		int Y = 0;
+		int Width = 0;
+		int Height = 0;
+		uint32_t Generation = 0; // bumped by every Remove() of the entry
+	};
+
+	std::unique_ptr<Page> CreatePage() const;
+	AtlasHandle AddEntry(int page, int x, int y, int width, int height);
+	// Packs the requests listed in pending into page, sets their handles and drops them from pending.
+	void PackInto(int page, AtlasRequest* requests, std::vector<size_t>& pending);
+	// Rebuilds page with its entries and as many pending requests as fit; keeps the result only if one does.
+	bool Repack(int page, AtlasRequest* requests, std::vector<size_t>& pending, std::vector<AtlasMove>& out_moves);
+
+	std::vector<std::unique_ptr<Page>> m_pages;
+	std::vector<Entry> m_entries;
+	std::vector<uint32_t> m_unusedEntries;
+	int m_pageSize = 0;
+	int m_maxPages = 0;
+	uint32_t m_numEntries = 0;
+	uint64_t m_repacks = 0;
+};
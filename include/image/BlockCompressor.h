@@ -0,0 +1,46 @@
+#pragma once
+#include "image/ImageDecoder.h"
+
+#include <cstdint>
+
+class ThreadPool;
+
+static constexpr int APP_MAX_BLOCK_COMPRESSION_QUALITY = 2;
+// Smaller images stay RGBA8: they take little video memory, and their encode time is better spent elsewhere.
+static constexpr int64_t APP_BLOCK_COMPRESSION_MIN_PIXELS = 512ll * 512;
+
+// Whether images decoded to RGBA8 are block-compressed before upload, and how hard the encoder tries.
+struct BlockCompressionOptions
+{
+	bool Enabled = false;
+	int Quality = 1; // 0 fastest .. APP_MAX_BLOCK_COMPRESSION_QUALITY best
+};
+
+// CPU encoder from RGBA8 to BC1 for opaque images and BC7 (mode 6) for images with alpha, for a quarter or an
+// eighth of the video memory. Endpoints start at the extremes of each block's principal axis; quality 1
+// refines them with least-squares passes and quality 2 also tries the neighbouring quantized endpoints.
+// Indices are the nearest palette entry, picked with SSE2 where available; SelectNearestReference is the
+// scalar definition it must match, so the output is identical either way. Platform-neutral.
+namespace BlockCompressor
+{
+	// RGBA8, at least APP_BLOCK_COMPRESSION_MIN_PIXELS, a whole number of blocks as D3D12 requires, and within
+	// APP_MAX_TEXTURE_DIMENSION.
+	bool CanCompress(const DecodedImage& image);
+
+	bool IsOpaque(const unsigned char* pixels, int width, int height, size_t rowPitch);
+
+	// block is 4x4 RGBA8 pixels, row after row (64 bytes). BC1 writes 8 bytes, BC7 16. Alpha is ignored by BC1.
+	void CompressBlockBc1(const unsigned char* block, int quality, unsigned char* out);
+	void CompressBlockBc7(const unsigned char* block, int quality, unsigned char* out);
+
+	// Index of the nearest of numColors (at most 16) RGBA8 palette entries for each of the 16 pixels, by squared
+	// error over all four channels, ties going to the lower index. Returns the total error.
+	uint32_t SelectNearest(const unsigned char* pixels, const unsigned char* palette, int numColors, uint8_t* indices);
+	uint32_t SelectNearestReference(const unsigned char* pixels, const unsigned char* palette, int numColors,
+	                                uint8_t* indices);
+
+	// Replaces every level of image with BC1 blocks when it is opaque and BC7 blocks otherwise, with rows of
+	// blocks spread over pool when one is given. Returns false, leaving the image as it was, if CanCompress
+	// does.
+	bool CompressImage(DecodedImage& image, int quality, ThreadPool* pool = nullptr);
+}
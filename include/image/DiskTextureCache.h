@@ -0,0 +1,107 @@
+#pragma once
+#include "image/BlockCompressor.h"
+#include "image/FileSource.h"
+#include "image/ImageDecoder.h"
+#include "image/TextureContainer.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+static constexpr uint64_t APP_DISK_CACHE_BUDGET_BYTES = 1024ull * 1024 * 1024;
+// The payload is laid out like a D3D12 upload buffer (D3D12_TEXTURE_DATA_PITCH_ALIGNMENT and
+// D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT), so every level reaches staging memory with a single memcpy.
+static constexpr uint32_t APP_DISK_CACHE_ROW_PITCH_ALIGNMENT = 256;
+static constexpr uint32_t APP_DISK_CACHE_LEVEL_ALIGNMENT = 512;
+
+// Everything a cached image depends on. The source file is identified by path, size and modification time
+// rather than by its contents, so a lookup costs one stat instead of a read.
+struct DiskCacheKey
+{
+	std::string Path;
+	uint64_t FileSize = 0;
+	int64_t FileTime = 0; // last write time, in ticks of the file system clock
+	int MaxDimension = 0;
+	BlockCompressionOptions Compression;
+	uint64_t Hash = 0; // of all the above; names the cache file
+};
+
+struct DiskCacheLevel
+{
+	uint64_t Offset = 0; // from the start of the cache file
+	uint32_t RowPitch = 0; // multiple of APP_DISK_CACHE_ROW_PITCH_ALIGNMENT
+	uint32_t NumRows = 0; // rows of 4x4 blocks for block-compressed formats
+	uint64_t RowSize = 0; // bytes of each row that hold pixels
+};
+
+// A cache file mapped read-only. Images loaded from the cache point into it instead of owning pixels; see
+// DecodedImage::CacheEntry.
+struct DiskCacheEntry
+{
+	FileSource File;
+	DiskCacheLevel Levels[APP_MAX_TEXTURE_MIP_LEVELS];
+
+	const unsigned char* GetLevelData(int level) const { return File.GetData() + Levels[level].Offset; }
+};
+
+struct DiskCacheStats
+{
+	uint64_t Hits = 0;
+	uint64_t Misses = 0;
+	uint64_t Stores = 0;
+	uint64_t Evictions = 0;
+	uint64_t TotalBytes = 0;
+	uint32_t NumFiles = 0;
+};
+
+// Persistent cache of images as they are uploaded: decoded, mipmapped, block-compressed if requested, and
+// already at the upload row pitch. A warm start maps the file and copies it into the staging buffer without
+// decoding anything. Files are named after the key hash and written to a temporary name first, so a crash
+// never leaves a torn entry behind. Their modification time records the last use, which keeps the least
+// recently used order across runs; Store trims the oldest files once the directory exceeds its budget.
+// Thread-safe and platform-neutral.
+class DiskTextureCache
+{
+public:
+	DiskTextureCache() = default;
+	DiskTextureCache(const DiskTextureCache&) = delete;
+	DiskTextureCache& operator=(const DiskTextureCache&) = delete;
+
+	// Creates the directory if needed and indexes the entries already in it.
+	bool Open(const std::string& directory, uint64_t budgetBytes = APP_DISK_CACHE_BUDGET_BYTES);
+	void Close();
+	bool IsOpen() const;
+
+	// Returns false when the source file cannot be found.
+	static bool MakeKey(const std::string& path, int maxDimension, const BlockCompressionOptions& compression,
+	                    DiskCacheKey* out_key);
+
+	// On a hit, out_image refers to the mapped cache file and the entry becomes the most recently used.
+	bool Load(const DiskCacheKey& key, DecodedImage& out_image);
+	// Writes the image for key, then trims least recently used entries over the budget.
+	bool Store(const DiskCacheKey& key, const DecodedImage& image);
+
+	void SetBudget(uint64_t budgetBytes);
+	uint64_t GetBudget() const;
+	DiskCacheStats GetStats() const;
+
+private:
+	struct IndexEntry
+	{
+		uint64_t Size = 0;
+		int64_t LastUse = 0; // file system clock ticks
+	};
+
+	std::string GetFilePath(uint64_t hash) const;
+	void TouchLocked(uint64_t hash);
+	// Deletes the least recently used files until the total fits the budget; keep is never deleted.
+	void TrimLocked(uint64_t keep);
+
+	mutable std::mutex m_mutex;
+	std::string m_directory;
+	std::map<uint64_t, IndexEntry> m_index;
+	uint64_t m_budgetBytes = APP_DISK_CACHE_BUDGET_BYTES;
+	DiskCacheStats m_stats;
+	bool m_open = false;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Read-only view of a whole file for the decoders. The file is memory-mapped (POSIX mmap or a Win32 file
+// mapping) with sequential-access hints; if mapping fails it is read into an owned buffer instead. The
+// buffer keeps its capacity across Open() calls, so a long-lived FileSource doubles as a decode context.
+class FileSource
+{
+public:
+	FileSource() = default;
+	FileSource(const FileSource&) = delete;
+	FileSource& operator=(const FileSource&) = delete;
+
+	~FileSource();
+
+	bool Open(const std::string& path);
+	void Close();
+
+	const unsigned char* GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+	bool IsMapped() const { return m_mapping != nullptr; }
+
+	// Disables mapping so every Open() uses the buffered-read path (for comparisons).
+	void SetMappingEnabled(bool enabled) { m_mappingEnabled = enabled; }
+
+private:
+	bool Map(const std::string& path);
+	bool Read(const std::string& path);
+
+	const unsigned char* m_data = nullptr;
+	size_t m_size = 0;
+	void* m_mapping = nullptr; // base of the mapped view
+	std::vector<unsigned char> m_buffer;
+	bool m_mappingEnabled = true;
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include "image/FileSource.h"
+#include "image/TextureContainer.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+struct DiskCacheEntry;
+
+// Platform-neutral decode step. Nothing here touches Windows or D3D12, so it can run on worker threads
+// and be built on its own for headless tools.
+
+struct DecodedImage
+{
+	unsigned char* Pixels = nullptr; // level 0 in Format, tightly packed
+	TextureFormat Format = TextureFormat::Rgba8; // block-compressed only when read from a DDS or KTX2 file
+	int Width = 0;
+	int Height = 0;
+	int SourceWidth = 0; // size stored in the file; larger than Width/Height when decoded for display
+	int SourceHeight = 0;
+	int MipLevels = 1; // level 0 is Pixels; see MipGenerator::GenerateMipChain
+	// Of the file's bytes and the options it was loaded with (see AsyncImageLoader::MakeContentKey) when the
+	// loader knows it, else 0.
+	uint64_t ContentHash = 0;
+	std::vector<unsigned char> MipData; // levels 1..MipLevels-1, tightly packed
+	// Set instead of Pixels and MipData for images loaded from a DiskTextureCache: every level stays in the
+	// mapped cache file, already at the upload row pitch.
+	std::shared_ptr<const DiskCacheEntry> CacheEntry;
+
+	~DecodedImage();
+
+	void Release();
+
+	// For block-compressed formats a row is a row of 4x4 blocks.
+	size_t GetRowPitch() const { return TextureFormats::GetRowPitch(Format, Width); }
+	size_t GetSizeInBytes() const { return TextureFormats::GetLevelSize(Format, Width, Height); }
+
+	DecodedImage(DecodedImage&& other) noexcept;
+	DecodedImage& operator=(DecodedImage&& other) noexcept;
+
+	DecodedImage() = default;
+
+	DecodedImage(const DecodedImage&) = delete;
+	DecodedImage& operator=(const DecodedImage&) = delete;
+};
+
+// Per-thread state reused across decodes, so a worker does not reallocate its read buffer for every file.
+struct ImageDecodeContext
+{
+	FileSource Source;
+	ThreadPool* Pool = nullptr; // large PNGs spread their rows over it; see PngDecoder
+};
+
+namespace ImageDecoder
+{
+	// With maxDimension > 0 the image is halved with a box filter for as long as its longer side stays at or
+	// above maxDimension, which is all a preview of that size can show once it is mipmapped.
+	// DDS and KTX2 files keep their BC blocks and their own mip chain (see TextureContainer); maxDimension then
+	// skips the levels that are larger than needed. Everything else is decoded to RGBA8.
+	bool DecodeFile(const std::string& filename, DecodedImage& out_image, int maxDimension = 0,
+	                ImageDecodeContext* context = nullptr);
+	bool DecodeMemory(const unsigned char* data, size_t size, DecodedImage& out_image, int maxDimension = 0,
+	                  ThreadPool* pool = nullptr);
+
+	bool ReadImageInfo(const unsigned char* data, size_t size, int* out_width, int* out_height);
+
+	// Memory for DecodedImage::Pixels, which Release frees.
+	unsigned char* AllocatePixels(size_t size);
+
+	// Decodes straight into caller memory (e.g. a mapped upload buffer) as RGBA8 rows dstRowPitch apart;
+	// width and height must match ReadImageInfo. With out_mipData, levels 1..N-1 are generated on the way,
+	// packed like DecodedImage::MipData, without ever reading dst back, from a transient copy of the decoded
+	// rows. Without out_mipData, the PNGs and JPEGs PngDecoder and JpegDecoder support need no buffer but dst.
+	bool DecodeMemoryInto(
+		const unsigned char* data,
+		size_t size,
+		unsigned char* dst,
+		size_t dstRowPitch,
+		int width,
+		int height,
+		std::vector<unsigned char>* out_mipData = nullptr,
+		ThreadPool* pool = nullptr);
+}
@@ -1,16 +1,30 @@
 #pragma once
+#include "image/AtlasPacker.h"
+#include "image/BlockCompressor.h"
+#include "image/ImageDecoder.h"
 #include "render/Dx12Renderer.h"
 
 
 struct ExampleDescriptorHeapAllocator;
+class TextureAtlas;
 
 struct ImGuiDx12Texture
 {
 	Microsoft::WRL::ComPtr<ID3D12Resource> TextureResource;
 	D3D12_CPU_DESCRIPTOR_HANDLE SrvCpuDescriptorHandle = {};
 	D3D12_GPU_DESCRIPTOR_HANDLE SrvGpuDescriptorHandle = {};
+	DescriptorHandle SrvDescriptor; // generation-checked; see ExampleDescriptorHeapAllocator::IsValid
+	DXGI_FORMAT Format = DXGI_FORMAT_UNKNOWN; // R8G8B8A8_UNORM, or the BC format of a DDS/KTX2 file
 	int Width = 0;
 	int Height = 0;
+	int SourceWidth = 0; // size of the image file, which may have been reduced on decode
+	int SourceHeight = 0;
+	UINT64 UploadFenceValue = 0; // copy-queue fence value after which the texture may be sampled
+	UINT64 SizeInBytes = 0; // video memory taken by the resource, as reported by the device
+	Dx12TextureHeap* Heap = nullptr; // where the resource was created; null when it was created directly
+	Dx12TextureAllocation HeapAllocation;
+	TextureAtlas* Atlas = nullptr; // set instead of a resource for images packed into a TextureAtlas
+	AtlasHandle AtlasEntry;
 
 	~ImGuiDx12Texture();
 
@@ -25,12 +39,61 @@ struct ImGuiDx12Texture
 	ImGuiDx12Texture& operator=(const ImGuiDx12Texture&) = delete;
 };
 
+// What drawing a texture takes: its own descriptor and the whole texture, or for an image in a TextureAtlas
+// the page's descriptor and the image's rectangle there.
+struct ImGuiDx12TextureView
+{
+	ImTextureID TextureId = 0;
+	ImVec2 Uv0 = ImVec2(0.0f, 0.0f);
+	ImVec2 Uv1 = ImVec2(1.0f, 1.0f);
+	UINT64 UploadFenceValue = 0;
+};
+
+// textureHeap may be null, in which case every texture gets a committed resource of its own.
 namespace ImageLoader
 {
+	// Decodes the file straight into upload memory (no intermediate RGBA image) and queues its upload. DDS and
+	// KTX2 files have their blocks copied instead; see TextureContainer. With compression enabled the image
+	// is decoded, mipmapped and block-compressed first, across pool when one is given.
 	bool LoadTextureFromFile(
 		const std::string& filename,
 		ID3D12Device* device,
-		ID3D12CommandQueue* commandQueue,
+		Dx12TextureHeap* textureHeap,
+		Dx12UploadQueue* uploadQueue,
+		ExampleDescriptorHeapAllocator* srvAllocator,
+		ImGuiDx12Texture& out_texture,
+		const BlockCompressionOptions& compression = {},
+		ThreadPool* pool = nullptr);
+
+	// Creates a texture from pixels that were already decoded (e.g. by AsyncImageLoader) and queues its
+	// upload without waiting for it; see ImGuiDx12Texture::UploadFenceValue.
+	bool CreateTextureFromImage(
+		const DecodedImage& image,
+		ID3D12Device* device,
+		Dx12TextureHeap* textureHeap,
+		Dx12UploadQueue* uploadQueue,
 		ExampleDescriptorHeapAllocator* srvAllocator,
 		ImGuiDx12Texture& out_texture);
+
+	// Batch variants: every texture is recorded into one copy command list with a single barrier call and
+	// a single fence signal. out_textures[i] matches the i-th input and is left empty if that one failed.
+	// Return the number of textures created.
+	int LoadTexturesFromFiles(
+		const std::vector<std::string>& filenames,
+		ID3D12Device* device,
+		Dx12TextureHeap* textureHeap,
+		Dx12UploadQueue* uploadQueue,
+		ExampleDescriptorHeapAllocator* srvAllocator,
+		std::vector<ImGuiDx12Texture>& out_textures,
+		const BlockCompressionOptions& compression = {},
+		ThreadPool* pool = nullptr);
+
+	int CreateTexturesFromImages(
+		const DecodedImage* const* images,
+		size_t numImages,
+		ID3D12Device* device,
+		Dx12TextureHeap* textureHeap,
+		Dx12UploadQueue* uploadQueue,
+		ExampleDescriptorHeapAllocator* srvAllocator,
+		std::vector<ImGuiDx12Texture>& out_textures);
 }
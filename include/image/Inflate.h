@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// DEFLATE decoder (RFC 1951) for PNG image data, in the style of libdeflate: a 64-bit bit buffer that is
+// refilled a word at a time, an 11-bit literal/length table whose entries decode up to two literals at
+// once, length and distance extra bits taken from the same refill, and matches copied eight bytes at a
+// time. The whole output buffer is the window, so it must be large enough for everything. Platform-neutral.
+namespace Inflate
+{
+	// Raw deflate stream. Fails on corrupt or truncated data and when the output does not fit in dstSize.
+	// out_consumed, if given, receives the number of input bytes the stream took.
+	bool DecompressRaw(
+		const unsigned char* src,
+		size_t srcSize,
+		unsigned char* dst,
+		size_t dstSize,
+		size_t* out_size,
+		size_t* out_consumed = nullptr);
+
+	// zlib stream (RFC 1950): header, deflate data, and an Adler-32 of the output that is verified.
+	bool DecompressZlib(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize, size_t* out_size);
+
+	uint32_t Adler32(const unsigned char* data, size_t size, uint32_t adler = 1);
+	// Checksum of A followed by B from the checksums of both and the length of B (zlib's adler32_combine).
+	uint32_t CombineAdler32(uint32_t adlerA, uint32_t adlerB, size_t lengthB);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+
+struct JpegInfo
+{
+	int Width = 0;
+	int Height = 0;
+	int Components = 0; // 1 gray, 3 YCbCr (or RGB), 4 CMYK/YCCK
+	int Precision = 0; // bits per sample
+	int SamplingH[4] = {};
+	int SamplingV[4] = {};
+	bool Sequential = false; // baseline or extended Huffman; false for progressive, lossless and arithmetic
+};
+
+// JPEG decoder for the files cameras and the web produce: sequential Huffman, 8-bit, gray or YCbCr with
+// chroma at full, half or quarter resolution. It never holds whole component planes: each row of MCUs is
+// Huffman-decoded and run through the IDCT (two blocks at once, one per AVX2 lane; blocks with only a DC
+// coefficient are filled directly) into a strip buffer, and output rows come out of the strips in one pass
+// that upsamples chroma and converts YCbCr to RGBA8. The output matches stb_image's byte for byte: same
+// integer IDCT, same "fancy" upsampling, same YCbCr rounding. Platform-neutral; without AVX2 everything is
+// left to stb_image, whose SSE2/NEON kernels are the better choice there.
+//
+// It can also decode at 1/2, 1/4 or 1/8 scale, for images shown smaller than they are: luma blocks then go
+// through a 4x4 or 2x2 IDCT, or are just their DC value, and subsampled chroma is decoded straight to the
+// output resolution, so the full-size image is never produced. The result is the box-filtered full decode
+// up to rounding and chroma upsampling, not byte for byte.
+namespace JpegDecoder
+{
+	static constexpr int MAX_SCALE_SHIFT = 3;
+
+	bool ReadInfo(const unsigned char* data, size_t size, JpegInfo* out_info);
+
+	// False for everything Decode does not handle, and for every file on CPUs without AVX2.
+	bool IsSupported(const JpegInfo& info);
+
+	// Width or height of the image decoded at 1 / (1 << scaleShift) of its size, rounded up.
+	int GetScaledSize(int size, int scaleShift);
+
+	// Writes RGBA8 rows dstRowPitch apart, GetScaledSize of the image's size. Returns false for files it does
+	// not support or cannot decode, including baseline files whose components come in separate scans.
+	bool Decode(const unsigned char* data, size_t size, unsigned char* dst, size_t dstRowPitch, int scaleShift = 0);
+}
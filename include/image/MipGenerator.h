@@ -0,0 +1,38 @@
+#pragma once
+#include "image/ImageDecoder.h"
+
+#include <cstddef>
+
+// CPU mip chain generation for RGBA8 images. Each level is a 2x2 box filter of the previous one, with
+// D3D12 sizing (max(1, size / 2)); the last row/column of odd-sized levels is dropped. DownsampleBox uses
+// SSE2 where available and produces bit-identical output to DownsampleBoxReference.
+namespace MipGenerator
+{
+	int GetMipLevelCount(int width, int height);
+
+	// dst may be the same buffer as src (in-place reduction) as long as dstRowPitch <= srcRowPitch.
+	void DownsampleBox(
+		const unsigned char* src,
+		int srcWidth,
+		int srcHeight,
+		size_t srcRowPitch,
+		unsigned char* dst,
+		size_t dstRowPitch);
+
+	void DownsampleBoxReference(
+		const unsigned char* src,
+		int srcWidth,
+		int srcHeight,
+		size_t srcRowPitch,
+		unsigned char* dst,
+		size_t dstRowPitch);
+
+	// Bytes taken by levels 1..N-1 of a width x height image when tightly packed.
+	size_t GetMipChainSize(int width, int height);
+	// Writes every level below base (levels 1..N-1 relative to it) tightly packed into mipData.
+	void FillMipChain(const unsigned char* base, int width, int height, size_t rowPitch, unsigned char* mipData);
+
+	// Fills image.MipData with levels 1..N-1, tightly packed one after the other. Block-compressed images are
+	// left as they are.
+	bool GenerateMipChain(DecodedImage& image);
+}
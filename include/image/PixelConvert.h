@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+
+// Row converters from decoder output to RGBA8. The SIMD kernels (SSE2/SSSE3/AVX2 on x86, NEON on ARM) are
+// picked once at runtime from the CPU's features; the *Reference functions are the scalar definitions
+// they must match byte for byte. src and dst must not overlap.
+namespace PixelConvert
+{
+	void RgbToRgba(const uint8_t* src, uint8_t* dst, int width);
+	void BgrToRgba(const uint8_t* src, uint8_t* dst, int width);
+	void BgraToRgba(const uint8_t* src, uint8_t* dst, int width);
+	void GrayToRgba(const uint8_t* src, uint8_t* dst, int width);
+	void GrayAlphaToRgba(const uint8_t* src, uint8_t* dst, int width);
+
+	// Picks the converter for a decoder's channel count (1 = gray, 2 = gray+alpha, 3 = RGB, 4 = RGBA).
+	void ConvertRowToRgba(const uint8_t* src, int components, uint8_t* dst, int width);
+
+	// Name of the instruction set the dispatched kernels use ("AVX2", "SSSE3", "SSE2", "NEON" or "scalar").
+	const char* GetKernelName();
+
+	void RgbToRgbaReference(const uint8_t* src, uint8_t* dst, int width);
+	void BgrToRgbaReference(const uint8_t* src, uint8_t* dst, int width);
+	void BgraToRgbaReference(const uint8_t* src, uint8_t* dst, int width);
+	void GrayToRgbaReference(const uint8_t* src, uint8_t* dst, int width);
+	void GrayAlphaToRgbaReference(const uint8_t* src, uint8_t* dst, int width);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+class ThreadPool;
+
+// Images with at least this many pixels are worth splitting across threads; below it the task overhead
+// eats the gain.
+static constexpr int64_t APP_PARALLEL_PNG_MIN_PIXELS = 2048ll * 2048;
+
+struct PngInfo
+{
+	int Width = 0;
+	int Height = 0;
+	int BitDepth = 0;
+	int ColorType = 0; // 0 gray, 2 RGB, 3 palette, 4 gray+alpha, 6 RGBA
+	bool Interlaced = false;
+};
+
+// PNG decoder used for every PNG it supports, with Inflate in place of stb_image's zlib. Large images are
+// spread over a ThreadPool: inflate is serial unless the encoder flushed the deflate stream into
+// independent segments (zlib Z_FULL_FLUSH, pigz -i); those are inflated in parallel and checked against
+// the stream's Adler-32. Unfiltering runs in parallel across runs of rows that start with a None or Sub
+// filter, which do not depend on the row above, and the conversion to RGBA8 runs in parallel across row
+// bands. The output matches stb_image's 8-bit RGBA byte for byte. Platform-neutral.
+namespace PngDecoder
+{
+	bool ReadInfo(const unsigned char* data, size_t size, PngInfo* out_info);
+
+	// 8- and 16-bit non-interlaced images of any color type, up to stb_image's 2 GB of RGBA8; everything else
+	// is left to stb_image.
+	bool IsSupported(const PngInfo& info);
+
+	// Writes RGBA8 rows dstRowPitch apart. With pool == nullptr everything runs on the calling thread.
+	// Returns false for files it does not support or cannot decode, including headers whose size the image data
+	// cannot fill and images it cannot allocate the filtered rows for.
+	bool Decode(const unsigned char* data, size_t size, unsigned char* dst, size_t dstRowPitch, ThreadPool* pool);
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "image/AtlasPacker.h"
+#include "image/ImageLoader.h"
+
+#include <vector>
+
+// 4 MB of RGBA8 per page, room for about fifty 128x128 images or a few hundred icons.
+static constexpr int APP_TEXTURE_ATLAS_PAGE_SIZE = 1024;
+static constexpr int APP_TEXTURE_ATLAS_MAX_PAGES = 16;
+// RGBA8 images no larger than this on either side are packed instead of getting a texture of their own. The
+// UI draws them at their size or larger, so the pages need no mip levels.
+static constexpr int APP_TEXTURE_ATLAS_MAX_IMAGE_SIZE = 128;
+
+// Small images packed into shared pages by an AtlasPacker, so they take no descriptor or resource of their
+// own and images of one page drawn one after another share an ImGui draw command. The ImGuiDx12Textures it
+// hands out only name an entry; GetView() resolves it when drawing, since a repack moves entries to a new
+// page texture. Pages are written on the copy queue while frames in flight sample other entries of them,
+// so like the tile atlas they allow simultaneous access.
+class TextureAtlas
+{
+public:
+	TextureAtlas() = default;
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+	bool Create(
+		ID3D12Device* device,
+		Dx12TextureHeap* textureHeap,
+		ExampleDescriptorHeapAllocator* srvAllocator,
+		int framesInFlight);
+	// The GPU must be idle and every texture handed out released.
+	void Release();
+
+	// RGBA8 images within APP_TEXTURE_ATLAS_MAX_IMAGE_SIZE; only their top level is packed.
+	static bool CanPack(const DecodedImage& image);
+
+	// Counterpart of ImageLoader::CreateTexturesFromImages for images CanPack accepts: packs them as one batch
+	// and records the copies of repacked pages and the new images into a single upload. out_textures[i] is left
+	// empty for images that found no room. Returns the number packed.
+	int AddImages(
+		const DecodedImage* const* images,
+		size_t numImages,
+		Dx12UploadQueue* uploadQueue,
+		std::vector<ImGuiDx12Texture>& out_textures);
+	// Called by ImGuiDx12Texture::Release once no frame in flight draws the entry any more.
+	void Remove(AtlasHandle handle);
+
+	bool GetView(AtlasHandle handle, ImGuiDx12TextureView* out_view) const;
+
+	// Call once per rendered frame. Releases the page textures that repacks replaced, and those of empty pages
+	// beyond one kept for reuse, once no frame in flight or upload uses them.
+	void EndFrame(Dx12UploadQueue* uploadQueue);
+
+	// Page textures, including replaced ones still waiting to be released.
+	UINT64 GetSizeInBytes() const;
+	AtlasPackerStats GetStats() const { return m_packer.GetStats(); }
+
+private:
+	struct Page
+	{
+		ImGuiDx12Texture Texture; // no resource while the page is empty and its texture was released
+		UINT64 RepackFenceValue = 0; // the copy of the entries into Texture; every entry waits for it
+	};
+
+	struct RetiredTexture
+	{
+		ImGuiDx12Texture Texture;
+		uint64_t ReleaseFrame = 0;
+	};
+
+	bool CreatePageTexture(ImGuiDx12Texture& out_texture);
+	void RetireTexture(ImGuiDx12Texture&& texture);
+	// Moves the entries of repacked pages into new page textures. Entries of a page whose new texture cannot
+	// be created are dropped; their textures stop resolving.
+	void RecordMoves(const std::vector<AtlasMove>& moves, ID3D12GraphicsCommandList* commandList,
+	                 std::vector<int>& out_repackedPages);
+
+	ID3D12Device* m_device = nullptr;
+	Dx12TextureHeap* m_textureHeap = nullptr;
+	ExampleDescriptorHeapAllocator* m_srvAllocator = nullptr;
+	uint64_t m_framesInFlight = 0;
+	AtlasPacker m_packer;
+	std::vector<Page> m_pages;
+	std::vector<UINT64> m_uploadFenceValues; // by entry index
+	std::vector<RetiredTexture> m_retiredTextures;
+	std::vector<AtlasMove> m_moves;
+	uint64_t m_frame = 0;
+};
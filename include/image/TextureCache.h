@@ -0,0 +1,238 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct TextureCacheStats
+{
+	uint64_t Hits = 0;
+	uint64_t Misses = 0;
+	uint64_t Evictions = 0;
+	uint64_t Shares = 0; // keys pointed at a resident texture with the same content instead of a new one
+	uint64_t ResidentBytes = 0;
+	uint64_t PendingReleaseBytes = 0;
+	uint32_t ResidentCount = 0;
+	uint32_t KeyCount = 0; // at least ResidentCount; more when textures are shared
+};
+
+// Byte-budgeted cache of GPU textures keyed by string. Entries remember the frame they were last drawn
+// in; when the budget is exceeded, EndFrame() evicts the least recently drawn ones and only hands them
+// to the release callback once the frames that might still sample them have retired. The texture type
+// and the release callback are the only backend dependencies, so a fake backend can drive it.
+// Entries inserted with a content hash can be shared: Share() points another key at the same texture, the
+// entry counts the keys naming it, and it leaves the cache with all of them.
+template <typename TTexture>
+class TextureCache
+{
+public:
+	using ReleaseFn = std::function<void(TTexture&)>;
+	using ContentEvictedFn = std::function<void(uint64_t contentHash)>;
+
+	// contentEvictedFn, when given, is called as soon as an entry with a content hash leaves the cache,
+	// frames before its texture is released.
+	void Initialize(uint64_t budgetBytes, uint32_t framesInFlight, ReleaseFn releaseFn,
+	                ContentEvictedFn contentEvictedFn = {})
+	{
+		m_budgetBytes = budgetBytes;
+		m_framesInFlight = framesInFlight;
+		m_releaseFn = std::move(releaseFn);
+		m_contentEvictedFn = std::move(contentEvictedFn);
+	}
+
+	void SetBudget(uint64_t budgetBytes) { m_budgetBytes = budgetBytes; }
+	uint64_t GetBudget() const { return m_budgetBytes; }
+
+	// Looks up a texture for drawing this frame. Counts a hit or a miss and marks the entry as used.
+	TTexture* Find(const std::string& key)
+	{
+		auto it = m_keys.find(key);
+		if (it == m_keys.end())
+		{
+			m_stats.Misses++;
+			return nullptr;
+		}
+
+		m_stats.Hits++;
+		Touch(it->second);
+		return &it->second->Texture;
+	}
+
+	bool Contains(const std::string& key) const { return m_keys.find(key) != m_keys.end(); }
+	bool ContainsContent(uint64_t contentHash) const { return m_contents.find(contentHash) != m_contents.end(); }
+
+	// contentHash identifies what the texture shows (0 = nothing to share it by) and must not be resident
+	// already; see ContainsContent and Share.
+	TTexture& Insert(const std::string& key, TTexture&& texture, uint64_t sizeInBytes, uint64_t contentHash = 0)
+	{
+		Unlink(key);
+
+		m_lru.push_front(Entry{std::move(texture), sizeInBytes, m_frame, contentHash, {key}});
+		m_keys.emplace(key, m_lru.begin());
+		if (contentHash != 0)
+			m_contents[contentHash] = m_lru.begin();
+		m_stats.ResidentBytes += sizeInBytes;
+		m_stats.ResidentCount++;
+		m_stats.KeyCount++;
+		return m_lru.front().Texture;
+	}
+
+	// Points key at the resident texture with contentHash, dropping whatever key named before. Returns
+	// nullptr, leaving key alone, when no resident texture has that content.
+	TTexture* Share(const std::string& key, uint64_t contentHash)
+	{
+		auto content = m_contents.find(contentHash);
+		if (contentHash == 0 || content == m_contents.end())
+			return nullptr;
+
+		EntryIterator entry = content->second;
+		auto existing = m_keys.find(key);
+		if (existing == m_keys.end() || existing->second != entry)
+		{
+			Unlink(key);
+			entry->Keys.push_back(key);
+			m_keys.emplace(key, entry);
+			m_stats.Shares++;
+			m_stats.KeyCount++;
+		}
+		Touch(entry);
+		return &entry->Texture;
+	}
+
+	// Call once per rendered frame, after all Find() calls for it.
+	void EndFrame()
+	{
+		while (m_stats.ResidentBytes > m_budgetBytes && !m_lru.empty())
+		{
+			auto it = std::prev(m_lru.end());
+			if (it->LastUsedFrame >= m_frame)
+				break; // everything left was drawn this frame
+			Evict(it);
+		}
+
+		m_frame++;
+
+		for (size_t i = 0; i < m_pendingReleases.size();)
+		{
+			PendingRelease& pending = m_pendingReleases[i];
+			if (pending.ReleaseFrame <= m_frame)
+			{
+				if (m_releaseFn)
+					m_releaseFn(pending.Texture);
+				m_stats.PendingReleaseBytes -= pending.SizeInBytes;
+				m_pendingReleases[i] = std::move(m_pendingReleases.back());
+				m_pendingReleases.pop_back();
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+
+	// Releases everything immediately; the caller guarantees the GPU is idle.
+	void Clear()
+	{
+		for (Entry& entry : m_lru)
+			if (m_releaseFn)
+				m_releaseFn(entry.Texture);
+		for (PendingRelease& pending : m_pendingReleases)
+			if (m_releaseFn)
+				m_releaseFn(pending.Texture);
+		m_lru.clear();
+		m_keys.clear();
+		m_contents.clear();
+		m_pendingReleases.clear();
+		m_stats.ResidentBytes = 0;
+		m_stats.PendingReleaseBytes = 0;
+		m_stats.ResidentCount = 0;
+		m_stats.KeyCount = 0;
+	}
+
+	const TextureCacheStats& GetStats() const { return m_stats; }
+	uint64_t GetFrame() const { return m_frame; }
+
+private:
+	struct Entry
+	{
+		TTexture Texture;
+		uint64_t SizeInBytes = 0;
+		uint64_t LastUsedFrame = 0;
+		uint64_t ContentHash = 0;
+		std::vector<std::string> Keys; // its reference count; shared when there is more than one
+	};
+	using EntryIterator = typename std::list<Entry>::iterator;
+
+	struct PendingRelease
+	{
+		TTexture Texture;
+		uint64_t SizeInBytes = 0;
+		uint64_t ReleaseFrame = 0;
+	};
+
+	void Touch(EntryIterator entry)
+	{
+		entry->LastUsedFrame = m_frame;
+		m_lru.splice(m_lru.begin(), m_lru, entry);
+	}
+
+	// Drops key's reference to its entry, evicting the entry once no key names it.
+	void Unlink(const std::string& key)
+	{
+		auto it = m_keys.find(key);
+		if (it == m_keys.end())
+			return;
+
+		EntryIterator entry = it->second;
+		m_keys.erase(it);
+		m_stats.KeyCount--;
+		for (size_t i = 0; i < entry->Keys.size(); i++)
+		{
+			if (entry->Keys[i] == key)
+			{
+				entry->Keys.erase(entry->Keys.begin() + i);
+				break;
+			}
+		}
+		if (entry->Keys.empty())
+			Evict(entry);
+	}
+
+	void Evict(EntryIterator entry)
+	{
+		m_stats.ResidentBytes -= entry->SizeInBytes;
+		m_stats.ResidentCount--;
+		m_stats.PendingReleaseBytes += entry->SizeInBytes;
+		m_stats.Evictions++;
+
+		for (const std::string& key : entry->Keys)
+			m_keys.erase(key);
+		m_stats.KeyCount -= static_cast<uint32_t>(entry->Keys.size());
+		if (entry->ContentHash != 0)
+		{
+			m_contents.erase(entry->ContentHash);
+			if (m_contentEvictedFn)
+				m_contentEvictedFn(entry->ContentHash);
+		}
+
+		// The frames that drew it may still be in flight; they have all retired once framesInFlight more
+		// frames have been submitted after the current one.
+		m_pendingReleases.push_back({std::move(entry->Texture), entry->SizeInBytes, m_frame + m_framesInFlight + 1});
+		m_lru.erase(entry);
+	}
+
+	std::list<Entry> m_lru; // most recently drawn first
+	std::map<std::string, EntryIterator> m_keys;
+	std::unordered_map<uint64_t, EntryIterator> m_contents;
+	std::vector<PendingRelease> m_pendingReleases;
+	ReleaseFn m_releaseFn;
+	ContentEvictedFn m_contentEvictedFn;
+	TextureCacheStats m_stats;
+	uint64_t m_budgetBytes = 0;
+	uint64_t m_frame = 0;
+	uint32_t m_framesInFlight = 0;
+};
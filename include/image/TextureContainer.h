@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Largest texture side D3D12 accepts; bigger containers are rejected before anything is allocated.
+static constexpr int APP_MAX_TEXTURE_DIMENSION = 16384;
+static constexpr int APP_MAX_TEXTURE_MIP_LEVELS = 15; // full chain of an APP_MAX_TEXTURE_DIMENSION image
+
+// Formats a DecodedImage can hold. The values are the matching DXGI_FORMAT numbers, so the D3D12 side casts
+// instead of mapping. sRGB files are read as their UNORM twin: the UI samples every texture as UNORM, and
+// doing the same for compressed files keeps them looking like the PNG they were made from.
+enum class TextureFormat : uint32_t
+{
+	Rgba8 = 28, // DXGI_FORMAT_R8G8B8A8_UNORM
+	Bc1 = 71, // DXGI_FORMAT_BC1_UNORM
+	Bc3 = 77, // DXGI_FORMAT_BC3_UNORM
+	Bc5 = 83, // DXGI_FORMAT_BC5_UNORM
+	Bc7 = 98, // DXGI_FORMAT_BC7_UNORM
+};
+
+namespace TextureFormats
+{
+	inline bool IsBlockCompressed(TextureFormat format) { return format != TextureFormat::Rgba8; }
+
+	// Bytes per 4x4 block for block-compressed formats, per pixel otherwise.
+	inline int GetElementSize(TextureFormat format)
+	{
+		return format == TextureFormat::Bc1 ? 8 : format == TextureFormat::Rgba8 ? 4 : 16;
+	}
+
+	// Rows as a copy footprint counts them: rows of 4x4 blocks for block-compressed formats, so a level
+	// smaller than a block still takes a whole one.
+	inline int GetNumRows(TextureFormat format, int height)
+	{
+		return IsBlockCompressed(format) ? (height + 3) / 4 : height;
+	}
+
+	inline size_t GetRowPitch(TextureFormat format, int width)
+	{
+		int numElements = IsBlockCompressed(format) ? (width + 3) / 4 : width;
+		return static_cast<size_t>(numElements) * GetElementSize(format);
+	}
+
+	inline size_t GetLevelSize(TextureFormat format, int width, int height)
+	{
+		return GetRowPitch(format, width) * GetNumRows(format, height);
+	}
+}
+
+struct TextureContainerLevel
+{
+	size_t Offset = 0; // from the start of the file
+	size_t Size = 0; // tightly packed, as GetLevelSize
+	int Width = 0;
+	int Height = 0;
+};
+
+struct TextureContainerInfo
+{
+	TextureFormat Format = TextureFormat::Rgba8;
+	int Width = 0;
+	int Height = 0;
+	int MipLevels = 0;
+	TextureContainerLevel Levels[APP_MAX_TEXTURE_MIP_LEVELS];
+};
+
+// DDS and KTX2 files holding GPU-ready BC1, BC3, BC5 or BC7 blocks, which are uploaded as they are instead of
+// being decoded: a 4K BC7 image takes 16 MB of video memory where RGBA8 takes 64 MB. Only single 2D images
+// are read (no arrays, cube maps or volumes, no KTX2 supercompression), and the base level must be a whole
+// number of blocks, as D3D12 requires. Platform-neutral; nothing is copied, the levels are located in place.
+namespace TextureContainer
+{
+	// True when the data starts with a DDS or KTX2 signature, whether or not ReadInfo accepts the rest.
+	bool IsContainer(const unsigned char* data, size_t size);
+
+	// Fills out_info with the format and every mip level found in the file, largest first. Returns false,
+	// with the reason on std::cerr, for files it does not support or that are truncated.
+	bool ReadInfo(const unsigned char* data, size_t size, TextureContainerInfo* out_info);
+}
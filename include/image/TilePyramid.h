@@ -0,0 +1,89 @@
+#pragma once
+#include "image/ImageDecoder.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+static constexpr int APP_TILE_SIZE = 256; // image texels along a tile side
+// Texels repeated from the neighbouring tiles (or the clamped edge) around each tile, so bilinear filtering
+// inside a tile never reads another tile's slot.
+static constexpr int APP_TILE_BORDER = 1;
+static constexpr int APP_TILE_SLOT_SIZE = APP_TILE_SIZE + 2 * APP_TILE_BORDER;
+
+struct TileId
+{
+	int Level = 0;
+	int X = 0;
+	int Y = 0;
+
+	uint64_t GetKey() const
+	{
+		return static_cast<uint64_t>(Level) << 48 | static_cast<uint64_t>(Y) << 24 | static_cast<uint64_t>(X);
+	}
+	bool operator==(const TileId& other) const = default;
+};
+
+// Geometry of a tile pyramid: level l is max(1, size >> l) texels (MipGenerator sizing) and is cut into
+// APP_TILE_SIZE tiles, the last row and column partial. Levels stop at the first one that fits in a single
+// tile. Every level is stretched over the whole image, so tile rectangles are given in level 0 texels.
+struct TileLayout
+{
+	int Width = 0;
+	int Height = 0;
+	int NumLevels = 0;
+
+	static TileLayout Make(int width, int height);
+
+	int GetLevelWidth(int level) const { return Width >> level > 1 ? Width >> level : 1; }
+	int GetLevelHeight(int level) const { return Height >> level > 1 ? Height >> level : 1; }
+	int GetTilesX(int level) const { return (GetLevelWidth(level) + APP_TILE_SIZE - 1) / APP_TILE_SIZE; }
+	int GetTilesY(int level) const { return (GetLevelHeight(level) + APP_TILE_SIZE - 1) / APP_TILE_SIZE; }
+
+	// Level 0 texels per texel of level.
+	float GetScaleX(int level) const { return static_cast<float>(Width) / static_cast<float>(GetLevelWidth(level)); }
+	float GetScaleY(int level) const
+	{
+		return static_cast<float>(Height) / static_cast<float>(GetLevelHeight(level));
+	}
+
+	// Texels of level that tile covers, without its border; partial at the right and bottom edges.
+	int GetTileWidth(const TileId& tile) const;
+	int GetTileHeight(const TileId& tile) const;
+};
+
+// CPU side of a tiled image: the full-resolution RGBA8 image and its mip chain, read out one bordered tile
+// at a time. This is how images too large for one texture (APP_MAX_TEXTURE_DIMENSION) are shown: only the
+// tiles a view needs are copied to the GPU. Platform-neutral.
+class TilePyramid
+{
+public:
+	// Takes over an RGBA8 image, generating the levels of its mip chain that the layout needs if they are
+	// missing. Images loaded from a DiskTextureCache are read from the mapped file in place. Returns false,
+	// leaving image as it was, for block-compressed images.
+	bool Build(DecodedImage&& image);
+
+	const TileLayout& GetLayout() const { return m_layout; }
+	int GetSourceWidth() const { return m_image.SourceWidth; }
+	int GetSourceHeight() const { return m_image.SourceHeight; }
+	const unsigned char* GetLevelPixels(int level) const { return m_levels[level].Pixels; }
+	size_t GetLevelRowPitch(int level) const { return m_levels[level].RowPitch; }
+	// Memory the levels take, whether owned or mapped from a cache file.
+	uint64_t GetSizeInBytes() const { return m_sizeInBytes; }
+
+	// Writes the tile and its border as APP_TILE_SLOT_SIZE rows of APP_TILE_SLOT_SIZE RGBA8 texels,
+	// dstRowPitch apart. Texels beyond the level's edges repeat the edge.
+	void CopyTile(const TileId& tile, unsigned char* dst, size_t dstRowPitch) const;
+
+private:
+	struct Level
+	{
+		const unsigned char* Pixels = nullptr;
+		size_t RowPitch = 0;
+	};
+
+	DecodedImage m_image;
+	TileLayout m_layout;
+	std::vector<Level> m_levels;
+	uint64_t m_sizeInBytes = 0;
+};
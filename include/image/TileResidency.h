@@ -0,0 +1,96 @@
+#pragma once
+#include "image/TilePyramid.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Part of the image a draw shows, in level 0 texels, and the screen pixels it is drawn into.
+struct TileView
+{
+	float X0 = 0.0f;
+	float Y0 = 0.0f;
+	float X1 = 0.0f;
+	float Y1 = 0.0f;
+	float ScreenWidth = 0.0f;
+	float ScreenHeight = 0.0f;
+};
+
+struct TileUpload
+{
+	TileId Tile;
+	int Slot = 0;
+};
+
+// One quad of a tiled draw: the image rectangle it covers (level 0 texels) and where that rectangle is in its
+// slot (slot texels, border included). Falls back to a coarser resident tile while the wanted one streams in.
+struct TileDraw
+{
+	int Slot = 0;
+	float X0 = 0.0f;
+	float Y0 = 0.0f;
+	float X1 = 0.0f;
+	float Y1 = 0.0f;
+	float U0 = 0.0f;
+	float V0 = 0.0f;
+	float U1 = 0.0f;
+	float V1 = 0.0f;
+};
+
+struct TileResidencyStats
+{
+	uint64_t Uploads = 0;
+	uint64_t Evictions = 0;
+	int ResidentTiles = 0;
+	int NumSlots = 0;
+};
+
+// Decides which tiles of a TileLayout live in a fixed set of atlas slots. Every frame, Update is called for
+// each view of the image; it marks the tiles those views show as used and queues the missing ones, coarsest
+// level first and then nearest the view centre. AllocateUploads hands out slots for queued tiles, reusing the
+// least recently used slot once no frame still in flight can sample it. The single tile of the coarsest level
+// is pinned so something can always be drawn. No GPU calls here; see TiledImage for the D3D12 side.
+class TileResidency
+{
+public:
+	void Initialize(const TileLayout& layout, int numSlots, int framesInFlight);
+
+	// Level whose texels come closest to one per screen pixel for view.
+	int SelectLevel(const TileView& view) const;
+	// Tiles of level that intersect view, inclusive.
+	void GetVisibleTiles(const TileView& view, int level, int& out_x0, int& out_y0, int& out_x1, int& out_y1) const;
+
+	void Update(const TileView& view, uint64_t frame);
+	// Assigns slots to up to maxUploads queued tiles; the caller copies each into its slot before drawing.
+	void AllocateUploads(int maxUploads, std::vector<TileUpload>& out_uploads);
+	// Frees the slot of an upload that could not be recorded; the tile is queued again by the next Update.
+	void Discard(const TileUpload& upload);
+	// Quads that draw view from resident tiles. Tiles resident at the wanted level are used as they are; the
+	// others are cut out of their nearest resident ancestor. Empty only if nothing is resident yet.
+	void GetDraws(const TileView& view, std::vector<TileDraw>& out_draws) const;
+
+	bool IsResident(const TileId& tile) const { return m_residentSlots.count(tile.GetKey()) != 0; }
+	bool HasPendingUploads() const;
+	const TileLayout& GetLayout() const { return m_layout; }
+	TileResidencyStats GetStats() const;
+
+private:
+	struct Slot
+	{
+		TileId Tile;
+		bool Occupied = false;
+		uint64_t LastUsedFrame = 0;
+	};
+
+	int FindSlot();
+	TileId GetCoarsestTile() const { return TileId{m_layout.NumLevels - 1, 0, 0}; }
+
+	TileLayout m_layout;
+	int m_framesInFlight = 0;
+	uint64_t m_frame = 0;
+	std::vector<Slot> m_slots;
+	std::unordered_map<uint64_t, int> m_residentSlots; // TileId key -> slot
+	std::vector<TileId> m_requests;                    // this frame's missing tiles, most wanted first
+	uint64_t m_uploads = 0;
+	uint64_t m_evictions = 0;
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include "image/ImageLoader.h"
+#include "image/TilePyramid.h"
+#include "image/TileResidency.h"
+
+#include <vector>
+
+// The atlas holds APP_TILE_ATLAS_SLOTS_PER_SIDE^2 bordered tiles: 3096x3096 RGBA8, about 37 MB per image,
+// enough for every tile a 1920x1200 view needs at its level.
+static constexpr int APP_TILE_ATLAS_SLOTS_PER_SIDE = 12;
+static constexpr int APP_TILE_ATLAS_SIZE = APP_TILE_ATLAS_SLOTS_PER_SIDE * APP_TILE_SLOT_SIZE;
+// Tiles copied per Draw call; a tile stages 330 KB, so this bounds what one view adds to a frame.
+static constexpr int APP_MAX_TILE_UPLOADS_PER_DRAW = 8;
+
+// An image shown through a TilePyramid instead of a single texture, for images past
+// APP_MAX_TEXTURE_DIMENSION or too large to keep whole in video memory. Tiles live in a fixed atlas texture
+// that TileResidency assigns slots of; Draw streams in the tiles a view is missing and draws the ones that are
+// there, falling back to coarser tiles meanwhile. Movable, so it can live in a TextureCache.
+class TiledImage
+{
+public:
+	TiledImage() = default;
+	TiledImage(TiledImage&& other) = default;
+	TiledImage& operator=(TiledImage&& other) = default;
+
+	TiledImage(const TiledImage&) = delete;
+	TiledImage& operator=(const TiledImage&) = delete;
+
+	// Takes over the image (see TilePyramid::Build) and creates the atlas. On failure image may be gone.
+	bool Create(
+		DecodedImage&& image,
+		ID3D12Device* device,
+		ExampleDescriptorHeapAllocator* srvAllocator,
+		int framesInFlight);
+	void Release(ExampleDescriptorHeapAllocator* srvAllocator);
+
+	// Shows view in the screen rectangle [min, max). Call from inside an ImGui frame; a view drawn more than
+	// once per frame, or several views of the image, share the frame's uploads.
+	void Draw(ImDrawList* drawList, const TileView& view, ImVec2 min, ImVec2 max, Dx12UploadQueue* uploadQueue);
+
+	int GetWidth() const { return m_pyramid.GetLayout().Width; }
+	int GetHeight() const { return m_pyramid.GetLayout().Height; }
+	int GetSourceWidth() const { return m_pyramid.GetSourceWidth(); }
+	int GetSourceHeight() const { return m_pyramid.GetSourceHeight(); }
+	// Copy-queue fence value of the last tile upload; see ImGuiDx12Texture::UploadFenceValue.
+	UINT64 GetUploadFenceValue() const { return m_atlas.UploadFenceValue; }
+	// Pyramid in system memory plus the atlas in video memory.
+	uint64_t GetSizeInBytes() const { return m_pyramid.GetSizeInBytes() + m_atlas.SizeInBytes; }
+	TileResidencyStats GetStats() const { return m_residency.GetStats(); }
+
+private:
+	// Copies the tiles into their slots in one copy-queue submission. Uploads that cannot be staged are
+	// discarded and requested again later.
+	void UploadTiles(Dx12UploadQueue* uploadQueue);
+
+	TilePyramid m_pyramid;
+	TileResidency m_residency;
+	ImGuiDx12Texture m_atlas;
+	std::vector<TileUpload> m_uploads;
+	std::vector<TileDraw> m_draws;
+};
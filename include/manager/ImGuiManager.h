@@ -1,10 +1,32 @@
 #pragma once
+#include "image/AsyncImageLoader.h"
 #include "image/ImageLoader.h"
+#include "image/TextureAtlas.h"
+#include "image/TextureCache.h"
+#include "image/TiledImage.h"
 #include "render/Dx12Renderer.h"
 
+#include <set>
+
+static constexpr int APP_TEXTURE_CACHE_BUDGET_MB = 512;
+static constexpr int APP_MAX_IMAGE_SIZE = 400;
+static constexpr int APP_THUMBNAIL_SIZE = 128;
+// Full-size decodes with a longer side above this are shown through a TiledImage instead of one texture.
+static constexpr int APP_TILED_IMAGE_MIN_DIMENSION = 8192;
+// Tiled images keep their whole pyramid in system memory; this bounds that plus their atlases.
+static constexpr int APP_TILED_IMAGE_BUDGET_MB = 2048;
+
 class Dx12Renderer;
 
-class ImGuiManager
+// Zoom and pan of an image window showing a TiledImage.
+struct TiledImageView
+{
+	float Zoom = 0.0f; // screen pixels per image pixel; 0 until the window first fits the image
+	float CenterX = 0.0f; // image pixel at the centre of the view
+	float CenterY = 0.0f;
+};
+
+class ImGuiManager : private IAsyncTextureSink
 {
 public:
 	ImGuiManager();
@@ -29,7 +51,46 @@ private:
 	char IMAGE_PATH[256] = "C:\\blablabla.png";
 
 	Dx12Renderer* m_renderer = nullptr;
+	DiskTextureCache m_diskCache; // outlives m_imageLoader, whose workers use it
+	AsyncImageLoader m_imageLoader;
+	std::vector<std::string> m_decodedPaths;
+	std::vector<DecodedImage> m_decodedImages;
+	std::vector<std::pair<std::string, uint64_t>> m_sharedImages; // path and content hash, from OnImageShared
+	int m_textureBudgetMB = APP_TEXTURE_CACHE_BUDGET_MB;
+	int m_diskCacheBudgetMB = static_cast<int>(APP_DISK_CACHE_BUDGET_BYTES / (1024 * 1024));
+	bool m_decodeAtDisplaySize = true;
+	BlockCompressionOptions m_compression;
+	std::map<std::string, TiledImageView> m_tiledViews;
 
 	static Dx12Renderer* s_dx12Renderer;
-	static std::map<std::string, ImGuiDx12Texture> s_loadedTextures;
+	static std::set<std::string> s_openImages;
+	static TextureCache<ImGuiDx12Texture> s_textureCache;
+	static TextureAtlas s_textureAtlas; // holds the small images of s_textureCache; released after it
+	static TextureCache<TiledImage> s_tiledImages;
+	static std::map<std::string, AsyncImageHandle> s_pendingTextures;
+	static std::set<std::string> s_failedImages;
+	static std::vector<std::string> s_galleryImages;
+
+	void LoadDirectory(const std::string& directory);
+	void DrawGallery();
+
+	// Returns the texture if it is resident, otherwise makes sure it is being decoded at this priority.
+	const ImGuiDx12Texture* AcquireTexture(const std::string& path, int priority);
+	// Resolves a texture of its own or an image in s_textureAtlas; false when it cannot be drawn.
+	static bool GetTextureView(const ImGuiDx12Texture& texture, ImGuiDx12TextureView* out_view);
+	// Tiled images are looked up before AcquireTexture; nullptr when path is not one.
+	TiledImage* FindTiledImage(const std::string& path);
+	// Fills the rest of the window with the image; the wheel zooms around the cursor and dragging pans.
+	void DrawTiledImage(const std::string& path, TiledImage& image);
+	void PrefetchImage(const std::string& path);
+	void RequestImage(const std::string& path, int priority);
+	void UploadDecodedImages();
+	// Takes over a decoded image too large for one texture; see APP_TILED_IMAGE_MIN_DIMENSION.
+	void CreateTiledImage(const std::string& path, DecodedImage&& image);
+	// Points the paths of files whose bytes match a resident texture at it; runs after UploadDecodedImages.
+	void ShareDecodedImages();
+
+	void OnImageDecoded(AsyncImageHandle handle, const std::string& path, DecodedImage& image) override;
+	void OnImageShared(AsyncImageHandle handle, const std::string& path, uint64_t contentHash) override;
+	void OnImageFailed(AsyncImageHandle handle, const std::string& path) override;
 };
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Identifies one allocation of a descriptor slot. The generation changes every time the slot is freed,
+// so a handle kept past its Free() no longer validates even after the index is handed out again.
+struct DescriptorHandle
+{
+	uint32_t Index = UINT32_MAX;
+	uint32_t Generation = 0;
+
+	bool IsNull() const { return Index == UINT32_MAX; }
+};
+
+// Index bookkeeping for a descriptor heap. Free slots are tracked in a bitmap with a one-word-per-64-words
+// summary, so Allocate() is a couple of count-trailing-zero scans. Indices are committed in pages
+// (a multiple of 64) on demand, up to maxDescriptors. Independent of D3D12.
+class DescriptorIndexAllocator
+{
+public:
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+	void Initialize(uint32_t pageSize, uint32_t maxDescriptors);
+	void Reset();
+
+	// Returns false when every page is full and no more pages can be added. Always hands out the
+	// lowest free index.
+	bool Allocate(DescriptorHandle* out_handle);
+	// Returns false for stale handles (double free, or the slot was already reused).
+	bool Free(DescriptorHandle handle);
+	// For callers that only kept the index; detects double frees but not stale handles.
+	bool FreeIndex(uint32_t index);
+
+	bool IsValid(DescriptorHandle handle) const;
+
+	uint32_t GetNumAllocated() const { return m_numAllocated; }
+	uint32_t GetNumPages() const { return m_numPages; }
+	uint32_t GetCommittedCapacity() const;
+	uint32_t GetMaxDescriptors() const { return m_maxDescriptors; }
+	size_t GetMemoryUsage() const;
+
+private:
+	bool AddPage();
+	bool IsAllocated(uint32_t index) const;
+	void MarkFree(uint32_t index);
+
+	std::vector<uint64_t> m_freeBits; // bit set = slot free
+	std::vector<uint64_t> m_summaryBits; // bit set = m_freeBits word has a free slot
+	std::vector<uint32_t> m_generations;
+	size_t m_firstFreeSummaryWord = 0; // no m_summaryBits word before it has a bit set
+	uint32_t m_pageSize = 0;
+	uint32_t m_maxDescriptors = 0;
+	uint32_t m_numPages = 0;
+	uint32_t m_numAllocated = 0;
+};
@@ -1,4 +1,8 @@
 #pragma once
+#include "render/DescriptorIndexAllocator.h"
+#include "render/Dx12TextureHeap.h"
+#include "render/Dx12UploadQueue.h"
+#include "render/ImGuiDrawMerger.h"
 
 #ifdef _DEBUG
 #define DX12_ENABLE_DEBUG_LAYER
@@ -6,7 +10,10 @@
 
 static constexpr int APP_NUM_FRAMES_IN_FLIGHT = 2;
 static constexpr int APP_NUM_BACK_BUFFERS = 2;
-static constexpr int APP_SRV_HEAP_SIZE = 64;
+// The shader-visible heap reserves room for APP_SRV_HEAP_MAX_SIZE descriptors up front so GPU handles
+// (ImTextureID) never move; the allocator only commits pages of APP_SRV_HEAP_PAGE_SIZE as needed.
+static constexpr int APP_SRV_HEAP_PAGE_SIZE = 64;
+static constexpr int APP_SRV_HEAP_MAX_SIZE = 16384;
 
 struct FrameContext
 {
@@ -21,12 +28,17 @@ struct ExampleDescriptorHeapAllocator
 	D3D12_CPU_DESCRIPTOR_HANDLE HeapStartCpu;
 	D3D12_GPU_DESCRIPTOR_HANDLE HeapStartGpu;
 	UINT HeapHandleIncrement;
-	ImVector<int> FreeIndices;
+	DescriptorIndexAllocator Indices;
 
-	void Create(ID3D12Device* device, ID3D12DescriptorHeap* heap);
+	void Create(ID3D12Device* device, ID3D12DescriptorHeap* heap, UINT pageSize);
 	void Destroy();
-	void Alloc(D3D12_CPU_DESCRIPTOR_HANDLE* out_cpu_desc_handle, D3D12_GPU_DESCRIPTOR_HANDLE* out_gpu_desc_handle);
-	void Free(D3D12_CPU_DESCRIPTOR_HANDLE out_cpu_desc_handle, D3D12_GPU_DESCRIPTOR_HANDLE out_gpu_desc_handle);
+	// Returns false (and null handles) when the heap is full.
+	bool Alloc(D3D12_CPU_DESCRIPTOR_HANDLE* out_cpu_desc_handle, D3D12_GPU_DESCRIPTOR_HANDLE* out_gpu_desc_handle,
+	           DescriptorHandle* out_handle = nullptr);
+	bool Free(D3D12_CPU_DESCRIPTOR_HANDLE out_cpu_desc_handle, D3D12_GPU_DESCRIPTOR_HANDLE out_gpu_desc_handle);
+	// Rejects stale handles instead of freeing a slot that now belongs to another texture.
+	bool Free(DescriptorHandle handle);
+	bool IsValid(DescriptorHandle handle) const { return Indices.IsValid(handle); }
 };
 
 class Dx12Renderer
@@ -49,6 +61,10 @@ public:
 	ID3D12CommandQueue* GetCommandQueue() const { return g_pd3dCommandQueue; }
 	ID3D12DescriptorHeap* GetSrvDescriptorHeap() const { return g_pd3dSrvDescHeap; }
 	ExampleDescriptorHeapAllocator* GetSrvDescriptorHeapAllocator() { return &g_pd3dSrvDescHeapAlloc; }
+	Dx12UploadQueue* GetUploadQueue() { return &g_uploadQueue; }
+	Dx12TextureHeap* GetTextureHeap() { return &g_textureHeap; }
+	// Of the last rendered frame; only filled in the backend's bindless mode.
+	const ImGuiDrawMergeStats& GetDrawMergeStats() const { return g_drawMerger.GetStats(); }
 
 private:
 	FrameContext g_frameContext[APP_NUM_FRAMES_IN_FLIGHT] = {};
@@ -58,6 +74,9 @@ private:
 	ID3D12DescriptorHeap* g_pd3dSrvDescHeap = nullptr;
 	ExampleDescriptorHeapAllocator g_pd3dSrvDescHeapAlloc;
 	ID3D12CommandQueue* g_pd3dCommandQueue = nullptr;
+	Dx12UploadQueue g_uploadQueue;
+	Dx12TextureHeap g_textureHeap;
+	ImGuiDrawMerger g_drawMerger;
 	ID3D12GraphicsCommandList* g_pd3dCommandList = nullptr;
 	ID3D12Fence* g_fence = nullptr;
 	HANDLE g_fenceEvent = nullptr;
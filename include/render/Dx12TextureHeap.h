@@ -0,0 +1,84 @@
+#pragma once
+#include "render/TlsfAllocator.h"
+
+#include <vector>
+
+static constexpr UINT64 APP_TEXTURE_HEAP_BLOCK_SIZE = 64ull * 1024 * 1024;
+// Larger textures get a committed resource of their own; placed, they would leave most of a block unusable.
+static constexpr UINT64 APP_TEXTURE_HEAP_MAX_PLACED_SIZE = APP_TEXTURE_HEAP_BLOCK_SIZE / 4;
+// Empty blocks kept instead of released, so textures streaming in and out do not create a heap every time.
+static constexpr UINT APP_TEXTURE_HEAP_SPARE_BLOCKS = 1;
+
+// Where a texture's memory came from. Block is UINT_MAX for committed resources.
+struct Dx12TextureAllocation
+{
+	UINT Block = UINT_MAX;
+	TlsfAllocation Range;
+	UINT64 SizeInBytes = 0;
+	bool SmallAlignment = false; // placed at D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT
+
+	bool IsPlaced() const { return Block != UINT_MAX; }
+};
+
+struct Dx12TextureHeapStats
+{
+	UINT NumBlocks = 0;
+	UINT64 BlockBytes = 0;
+	UINT64 PlacedBytes = 0;
+	UINT NumPlaced = 0;
+	UINT NumSmallAligned = 0;
+	UINT NumCommitted = 0;
+	UINT64 CommittedBytes = 0;
+	UINT64 LargestFreeRange = 0; // over all blocks
+	UINT NumFreeRanges = 0;
+	float Fragmentation = 0.0f; // of the free space in blocks; see TlsfStats::GetFragmentation
+};
+
+// Texture memory sub-allocated from large ID3D12Heap blocks. CreateTexture places a resource at an offset
+// a TlsfAllocator picks in the first block with room, adding a block when none has; small textures use
+// 4 KB placement where D3D12 allows it instead of the 64 KB every committed resource is rounded to.
+// Textures above APP_TEXTURE_HEAP_MAX_PLACED_SIZE, or that fail to place, fall back to committed resources.
+// Not thread-safe; used by the thread that records uploads.
+class Dx12TextureHeap
+{
+public:
+	Dx12TextureHeap() = default;
+	Dx12TextureHeap(const Dx12TextureHeap&) = delete;
+	Dx12TextureHeap& operator=(const Dx12TextureHeap&) = delete;
+
+	bool Create(ID3D12Device* device, UINT64 blockSize = APP_TEXTURE_HEAP_BLOCK_SIZE);
+	// Every texture must have been freed first.
+	void Destroy();
+
+	HRESULT CreateTexture(
+		const D3D12_RESOURCE_DESC& desc,
+		D3D12_RESOURCE_STATES initialState,
+		Microsoft::WRL::ComPtr<ID3D12Resource>& out_resource,
+		Dx12TextureAllocation* out_allocation);
+	// Takes back the memory of a texture whose resource has been released and that no queue still uses.
+	void Free(Dx12TextureAllocation& allocation);
+
+	Dx12TextureHeapStats GetStats() const;
+
+private:
+	struct Block
+	{
+		Microsoft::WRL::ComPtr<ID3D12Heap> Heap; // null once released; the slot is reused by AddBlock
+		TlsfAllocator Allocator;
+	};
+
+	bool PlaceTexture(
+		const D3D12_RESOURCE_DESC& desc,
+		const D3D12_RESOURCE_ALLOCATION_INFO& info,
+		D3D12_RESOURCE_STATES initialState,
+		Microsoft::WRL::ComPtr<ID3D12Resource>& out_resource,
+		Dx12TextureAllocation* out_allocation);
+	UINT AddBlock();
+
+	ID3D12Device* m_device = nullptr;
+	UINT64 m_blockSize = 0;
+	std::vector<Block> m_blocks;
+	UINT m_numCommitted = 0;
+	UINT64 m_committedBytes = 0;
+	UINT m_numSmallAligned = 0;
+};
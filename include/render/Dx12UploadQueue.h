@@ -0,0 +1,89 @@
+#pragma once
+#include "render/Dx12UploadRing.h"
+#include "render/UploadScheduler.h"
+
+static constexpr UINT APP_NUM_UPLOAD_CONTEXTS = 4;
+
+struct Dx12UploadAllocation
+{
+	ID3D12Resource* Resource = nullptr;
+	void* MappedData = nullptr; // base of the mapped buffer, not of the allocation
+	UINT64 Offset = 0;
+};
+
+struct Dx12UploadStats
+{
+	UINT64 Submissions = 0;
+	UINT64 BarrierCalls = 0;
+	UINT64 Barriers = 0;
+	UINT64 BytesStaged = 0;
+	UINT64 DedicatedStagingBuffers = 0;
+};
+
+// Long-lived copy queue used for all texture uploads. Every submission signals the same monotonic
+// fence; the render queue only waits on it before the first frame that samples a fresh texture.
+class Dx12UploadQueue : private IUploadQueue
+{
+public:
+	Dx12UploadQueue() = default;
+	Dx12UploadQueue(const Dx12UploadQueue&) = delete;
+	Dx12UploadQueue& operator=(const Dx12UploadQueue&) = delete;
+
+	~Dx12UploadQueue();
+
+	bool Create(ID3D12Device* device);
+	void Destroy();
+
+	// Returns a reset copy command list from the pool, or nullptr on failure.
+	ID3D12GraphicsCommandList* BeginUpload();
+	// Staging memory for the upload being recorded. Comes from the ring, or from a one-off buffer that
+	// is released once the upload retires when the ring cannot hold the request.
+	bool AllocateStaging(UINT64 size, Dx12UploadAllocation* out_allocation);
+	// Transitions are collected and issued as one ResourceBarrier call when the upload ends.
+	void QueueTransition(ID3D12Resource* resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after);
+	// Closes and submits the list; textures written by it are ready once the returned value completes.
+	UINT64 EndUpload();
+
+	const Dx12UploadStats& GetStats() const { return m_stats; }
+	void ResetStats() { m_stats = {}; }
+
+	void RequireForFrame(UINT64 fenceValue) { m_scheduler.RequireForFrame(fenceValue); }
+	UINT64 ConsumeFrameWait() { return m_scheduler.ConsumeFrameWait(); }
+	bool IsComplete(UINT64 fenceValue) const { return m_scheduler.IsComplete(fenceValue); }
+	void WaitIdle();
+
+	ID3D12CommandQueue* GetCommandQueue() const { return m_commandQueue.Get(); }
+	ID3D12Fence* GetFence() const { return m_fence.Get(); }
+
+private:
+	struct CommandContext
+	{
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CommandAllocator;
+		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> CommandList;
+	};
+
+	struct DeferredRelease
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		UINT64 FenceValue; // 0 while the upload that uses it is still being recorded
+	};
+
+	void Execute(uint32_t contextIndex) override;
+	void Signal(uint64_t fenceValue) override;
+	uint64_t GetCompletedValue() const override;
+	void WaitForValue(uint64_t fenceValue) override;
+
+	void Retire();
+
+	ID3D12Device* m_device = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> m_commandQueue;
+	Microsoft::WRL::ComPtr<ID3D12Fence> m_fence;
+	HANDLE m_fenceEvent = nullptr;
+	std::vector<CommandContext> m_contexts;
+	UINT m_recordingContext = UINT_MAX;
+	UploadScheduler m_scheduler;
+	Dx12UploadRing m_ring;
+	std::vector<DeferredRelease> m_deferredReleases;
+	std::vector<D3D12_RESOURCE_BARRIER> m_pendingBarriers;
+	Dx12UploadStats m_stats;
+};
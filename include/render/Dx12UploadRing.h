@@ -0,0 +1,34 @@
+#pragma once
+#include "render/UploadRingAllocator.h"
+
+static constexpr UINT64 APP_UPLOAD_RING_SIZE = 64ull * 1024 * 1024;
+
+// Persistently mapped upload heap shared by all texture uploads. Space is recycled once the upload
+// fence value a submission was tagged with has completed.
+class Dx12UploadRing
+{
+public:
+	Dx12UploadRing() = default;
+	Dx12UploadRing(const Dx12UploadRing&) = delete;
+	Dx12UploadRing& operator=(const Dx12UploadRing&) = delete;
+
+	~Dx12UploadRing();
+
+	bool Create(ID3D12Device* device, UINT64 size);
+	void Destroy();
+
+	// Sub-allocates staging memory aligned to D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT.
+	bool Allocate(UINT64 size, UINT64* out_offset);
+
+	void Submit(UINT64 fenceValue) { m_allocator.Submit(fenceValue); }
+	void Retire(UINT64 completedFenceValue) { m_allocator.Retire(completedFenceValue); }
+
+	ID3D12Resource* GetResource() const { return m_buffer.Get(); }
+	void* GetMappedData() const { return m_mappedData; }
+	UINT64 GetUsedBytes() const { return m_allocator.GetUsedBytes(); }
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_buffer;
+	void* m_mappedData = nullptr;
+	UploadRingAllocator m_allocator;
+};
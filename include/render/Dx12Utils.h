@@ -7,10 +7,43 @@ namespace Dx12Utils
 		UINT FirstSubresource,
 		UINT NumSubresources);
 
+	// Layouts of the subresources inside an intermediate buffer starting at IntermediateOffset. Returns the
+	// intermediate size needed, or 0 on failure.
+	UINT64 GetCopyableFootprints(
+		ID3D12Resource* pDestinationResource,
+		UINT FirstSubresource,
+		UINT NumSubresources,
+		UINT64 IntermediateOffset,
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts,
+		UINT* pNumRows,
+		UINT64* pRowSizesInBytes);
+
+	// Records the copies for data the caller already wrote into pIntermediate at pLayouts.
+	void CopySubresourcesFromIntermediate(
+		ID3D12GraphicsCommandList* pCmdList,
+		ID3D12Resource* pDestinationResource,
+		ID3D12Resource* pIntermediate,
+		UINT FirstSubresource,
+		UINT NumSubresources,
+		const D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts);
+
+	// Copies pSrcData into the intermediate at the device's footprints and records the copies. For
+	// block-compressed formats a row is a row of 4x4 blocks, both in pSrcData and in the footprints.
+	UINT64 UpdateSubresources(
+		ID3D12GraphicsCommandList* pCmdList,
+		ID3D12Resource* pDestinationResource,
+		ID3D12Resource* pIntermediate,
+		UINT64 IntermediateOffset,
+		UINT FirstSubresource,
+		UINT NumSubresources,
+		D3D12_SUBRESOURCE_DATA* pSrcData);
+
+	// Same as above for an intermediate buffer that is already persistently mapped at pIntermediateData.
 	UINT64 UpdateSubresources(
 		ID3D12GraphicsCommandList* pCmdList,
 		ID3D12Resource* pDestinationResource,
 		ID3D12Resource* pIntermediate,
+		void* pIntermediateData,
 		UINT64 IntermediateOffset,
 		UINT FirstSubresource,
 		UINT NumSubresources,
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+
+// When the DX12 ImGui backend grows its vertex and index buffers, and when it may release the ones it
+// replaced. Kept apart from the backend, which needs D3D12, so the policy can be checked headlessly.
+namespace ImGuiBufferGrowth
+{
+	// Elements to allocate when 'required' does not fit in 'current': 1.5x steps, as ImVector takes them, from
+	// the larger of the two and from no less than minSize, so an empty or one-element buffer grows as well.
+	// Returns current when required fits, and required when a step would overflow an int.
+	int GetGrownSize(int current, int required, int minSize);
+
+	// Whether a buffer replaced at retiredFrame is no longer read by any frame in flight at frameIndex; the
+	// application waits for a frame's fence before reusing its resources. Frame indices may wrap.
+	bool CanRelease(uint32_t retiredFrame, uint32_t frameIndex, uint32_t numFramesInFlight);
+}
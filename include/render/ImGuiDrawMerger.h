@@ -0,0 +1,36 @@
+#pragma once
+#include "imgui/imgui.h"
+
+#include <cstdint>
+
+struct ImGuiDrawMergeStats
+{
+	uint32_t NumCommands = 0; // draw commands ImGui recorded, callbacks excluded
+	uint32_t NumDraws = 0; // what is left of them after merging
+	uint32_t NumCallbacks = 0;
+	uint32_t NumIndices = 0; // indices walked to stamp their vertices
+
+	uint32_t GetMergedCommands() const { return NumCommands - NumDraws; }
+};
+
+// Turns ImGui's draw commands into fewer draws for the DX12 backend's bindless mode. ImGui already joins
+// consecutive commands with the same texture and clip rectangle; what still splits a window is the texture,
+// as between a gallery's thumbnails and their labels. Once every vertex carries the heap index of the texture
+// it samples (ImDrawVert::tex_index), neighbouring commands that only differ in texture draw as one.
+// Rewrites the ImDrawData from ImGui::Render() in place, so the plain backend must not draw it afterwards.
+// Independent of D3D12; texture IDs are turned into indices by the caller.
+class ImGuiDrawMerger
+{
+public:
+	// Called once per draw command, with IDs that have been uploaded.
+	using TextureIndexFn = uint32_t (*)(ImTextureID textureId, void* userData);
+
+	// Texture updates must have run first: ImDrawCmd::GetTexID() asserts on a texture not created yet.
+	void Merge(ImDrawData* drawData, TextureIndexFn textureIndexFn, void* userData);
+
+	// Of the last Merge().
+	const ImGuiDrawMergeStats& GetStats() const { return m_stats; }
+
+private:
+	ImGuiDrawMergeStats m_stats;
+};
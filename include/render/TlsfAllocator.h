@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// One allocation made by a TlsfAllocator. Keep it to free the range; like DescriptorHandle it carries a
+// generation, so a stale or repeated Free() is rejected instead of corrupting the block list.
+struct TlsfAllocation
+{
+	uint32_t Node = UINT32_MAX;
+	uint32_t Generation = 0;
+	uint64_t Offset = 0;
+	uint64_t Size = 0;
+
+	bool IsNull() const { return Node == UINT32_MAX; }
+};
+
+struct TlsfStats
+{
+	uint64_t Capacity = 0;
+	uint64_t UsedBytes = 0; // sizes as rounded to the granularity; padding in front of aligned blocks is free space
+	uint64_t LargestFreeBlock = 0;
+	uint32_t NumAllocations = 0;
+	uint32_t NumFreeBlocks = 0;
+
+	uint64_t GetFreeBytes() const { return Capacity - UsedBytes; }
+	// 0 when all free space is one block, approaching 1 as it splits into many small ones.
+	float GetFragmentation() const
+	{
+		uint64_t freeBytes = GetFreeBytes();
+		return freeBytes == 0 ? 0.0f : 1.0f - static_cast<float>(LargestFreeBlock) / static_cast<float>(freeBytes);
+	}
+};
+
+// Offset bookkeeping for one block of memory using two-level segregated fit: free ranges are binned by the
+// position of their highest bit and the four bits below it, with a bitmap per level, so Allocate() and Free()
+// are a few count-trailing-zero scans and no search. Freed ranges merge with free neighbours immediately.
+// Every offset and size is a multiple of the granularity given to Initialize().
+// Knows nothing about D3D12; Dx12TextureHeap places resources at the offsets it hands out.
+class TlsfAllocator
+{
+public:
+	void Initialize(uint64_t capacity, uint64_t granularity);
+	void Reset();
+
+	// alignment must be a power of two. Returns false when no free range can hold the request; good fit
+	// rather than best fit, so that can happen while GetStats().LargestFreeBlock would just hold it.
+	bool Allocate(uint64_t size, uint64_t alignment, TlsfAllocation* out_allocation);
+	// Returns false for null, stale or already freed allocations.
+	bool Free(const TlsfAllocation& allocation);
+
+	bool IsEmpty() const { return m_numAllocations == 0; }
+	uint64_t GetCapacity() const { return m_capacity; }
+	uint64_t GetUsedBytes() const { return m_usedBytes; }
+	// Walks the non-empty bins; meant for statistics, not for every allocation.
+	TlsfStats GetStats() const;
+
+private:
+	static constexpr uint32_t SUBDIVISION_BITS = 4;
+	static constexpr uint32_t SUBDIVISIONS = 1u << SUBDIVISION_BITS;
+	static constexpr uint32_t NUM_LEVELS = 64 - SUBDIVISION_BITS + 1;
+	static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+	struct Node
+	{
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+		uint32_t PrevPhysical = NO_NODE;
+		uint32_t NextPhysical = NO_NODE;
+		uint32_t PrevFree = NO_NODE;
+		uint32_t NextFree = NO_NODE;
+		uint32_t Generation = 0; // bumped by every allocation of the node
+		bool Free = false;
+	};
+
+	static void GetBin(uint64_t size, uint32_t& out_level, uint32_t& out_subdivision);
+	uint32_t FindFreeNode(uint64_t size) const;
+	uint32_t NewNode();
+	void ReleaseNode(uint32_t index);
+	void InsertFree(uint32_t index);
+	void RemoveFree(uint32_t index);
+	// Splits size bytes off the front of index; the rest becomes a new node after it. Returns the new node.
+	uint32_t Split(uint32_t index, uint64_t size);
+	// Merges next, which must follow index physically, into index.
+	void Merge(uint32_t index, uint32_t next);
+
+	std::vector<Node> m_nodes;
+	std::vector<uint32_t> m_unusedNodes;
+	uint32_t m_bins[NUM_LEVELS][SUBDIVISIONS] = {};
+	uint64_t m_levelBits = 0; // bit set = level has a non-empty bin
+	uint32_t m_subdivisionBits[NUM_LEVELS] = {};
+	uint64_t m_capacity = 0;
+	uint64_t m_granularity = 1;
+	uint64_t m_usedBytes = 0;
+	uint32_t m_numAllocations = 0;
+	uint32_t m_numFreeBlocks = 0;
+};
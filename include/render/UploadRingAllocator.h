@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+
+// Offset bookkeeping for a ring of staging memory. Allocations made between two Submit() calls are
+// tagged with the fence value passed to Submit() and become reusable once Retire() sees that value
+// completed. Knows nothing about D3D12, so a simulated fence can drive it.
+class UploadRingAllocator
+{
+public:
+	static constexpr uint64_t INVALID_OFFSET = ~0ull;
+
+	void Initialize(uint64_t capacity);
+	void Reset();
+
+	// Returns INVALID_OFFSET when the request cannot fit until older submissions retire.
+	uint64_t Allocate(uint64_t size, uint64_t alignment);
+
+	void Submit(uint64_t fenceValue);
+	void Retire(uint64_t completedFenceValue);
+
+	uint64_t GetCapacity() const { return m_capacity; }
+	uint64_t GetUsedBytes() const { return m_usedBytes; }
+	bool HasUnsubmittedAllocations() const { return m_unsubmittedBytes != 0; }
+
+private:
+	struct Submission
+	{
+		uint64_t FenceValue;
+		uint64_t End;
+		uint64_t Bytes;
+	};
+
+	std::deque<Submission> m_submissions;
+	uint64_t m_capacity = 0;
+	uint64_t m_head = 0; // oldest byte still in use
+	uint64_t m_tail = 0; // next free byte
+	uint64_t m_usedBytes = 0; // includes alignment and wrap padding
+	uint64_t m_unsubmittedBytes = 0;
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// The GPU side of the upload timeline: one queue with one monotonic fence. The D3D12 implementation
+// wraps a copy queue; headless tools can simulate it.
+class IUploadQueue
+{
+public:
+	virtual ~IUploadQueue() = default;
+
+	virtual void Execute(uint32_t contextIndex) = 0;
+	virtual void Signal(uint64_t fenceValue) = 0;
+	virtual uint64_t GetCompletedValue() const = 0;
+	virtual void WaitForValue(uint64_t fenceValue) = 0;
+};
+
+// Hands out pooled recording contexts, stamps every submission with the next fence value and tracks
+// the newest upload the next rendered frame depends on.
+class UploadScheduler
+{
+public:
+	void Initialize(IUploadQueue* queue, uint32_t maxContexts);
+	void Shutdown();
+
+	// Returns a context whose previous submission has retired, waiting on the oldest one when the pool
+	// is exhausted. Indices past the previous pool size are new and need their command objects created.
+	uint32_t AcquireContext();
+	uint64_t Submit(uint32_t contextIndex);
+
+	uint64_t GetCompletedValue() const;
+	uint64_t GetLastSubmittedValue() const { return m_lastSubmittedValue; }
+	bool IsComplete(uint64_t fenceValue) const { return fenceValue == 0 || GetCompletedValue() >= fenceValue; }
+	void WaitForValue(uint64_t fenceValue);
+	void WaitIdle() { WaitForValue(m_lastSubmittedValue); }
+
+	// Called for every texture the current frame samples.
+	void RequireForFrame(uint64_t fenceValue);
+	// The value the render queue must wait on before executing the frame, or 0 if nothing is pending.
+	uint64_t ConsumeFrameWait();
+
+	uint32_t GetNumContexts() const { return static_cast<uint32_t>(m_contexts.size()); }
+
+private:
+	struct Context
+	{
+		uint64_t FenceValue = 0;
+		bool Recording = false;
+	};
+
+	IUploadQueue* m_queue = nullptr;
+	std::vector<Context> m_contexts;
+	uint32_t m_maxContexts = 0;
+	uint64_t m_lastSubmittedValue = 0;
+	uint64_t m_frameRequiredValue = 0;
+};
@@ -0,0 +1,374 @@
+#include "core/ContentHash.h"
+#include "core/CpuFeatures.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CONTENT_HASH_X86
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// GCC and Clang only emit AVX2 instructions in functions that ask for them; MSVC always does.
+#if defined(__GNUC__) || defined(__clang__)
+#define CONTENT_HASH_AVX2 __attribute__((target("avx2")))
+#else
+#define CONTENT_HASH_AVX2
+#endif
+
+namespace ContentHash
+{
+	static constexpr uint64_t PRIME32_1 = 0x9E3779B1u;
+	static constexpr uint64_t PRIME32_2 = 0x85EBCA77u;
+	static constexpr uint64_t PRIME32_3 = 0xC2B2AE3Du;
+	static constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ull;
+	static constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+	static constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ull;
+	static constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+	static constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ull;
+	static constexpr uint64_t PRIME_MX1 = 0x165667919E3779F9ull;
+	static constexpr uint64_t PRIME_MX2 = 0x9FB21C651E98DF25ull;
+
+	static constexpr size_t SECRET_SIZE = 192;
+	static constexpr size_t STRIPE_LEN = 64;
+	static constexpr size_t SECRET_CONSUME_RATE = 8;
+	static constexpr size_t STRIPES_PER_BLOCK = (SECRET_SIZE - STRIPE_LEN) / SECRET_CONSUME_RATE;
+	static constexpr size_t BLOCK_LEN = STRIPE_LEN * STRIPES_PER_BLOCK;
+
+	alignas(64) static constexpr uint8_t SECRET[SECRET_SIZE] = {
+		0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+		0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+		0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+		0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+		0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+		0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+		0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+		0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+		0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+		0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+		0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+		0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+	};
+
+	// Little-endian loads; every target this builds for is little-endian.
+	static uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	static uint64_t Read64(const uint8_t* p)
+	{
+		uint64_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	static uint64_t RotateLeft(uint64_t value, int bits)
+	{
+		return value << bits | value >> (64 - bits);
+	}
+
+	static uint32_t Swap32(uint32_t value)
+	{
+		return value << 24 | (value << 8 & 0x00ff0000u) | (value >> 8 & 0x0000ff00u) | value >> 24;
+	}
+
+	static uint64_t Swap64(uint64_t value)
+	{
+		return static_cast<uint64_t>(Swap32(static_cast<uint32_t>(value))) << 32 |
+			Swap32(static_cast<uint32_t>(value >> 32));
+	}
+
+	// Low and high halves of the 128-bit product, xored together.
+	static uint64_t MultiplyFold64(uint64_t a, uint64_t b)
+	{
+#if defined(__SIZEOF_INT128__)
+		unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+		return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+		uint64_t high = 0;
+		uint64_t low = _umul128(a, b, &high);
+		return low ^ high;
+#else
+		uint64_t loLo = (a & 0xFFFFFFFFu) * (b & 0xFFFFFFFFu);
+		uint64_t hiLo = (a >> 32) * (b & 0xFFFFFFFFu);
+		uint64_t loHi = (a & 0xFFFFFFFFu) * (b >> 32);
+		uint64_t hiHi = (a >> 32) * (b >> 32);
+		uint64_t cross = (loLo >> 32) + (hiLo & 0xFFFFFFFFu) + loHi;
+		uint64_t high = (hiLo >> 32) + (cross >> 32) + hiHi;
+		uint64_t low = (cross << 32) | (loLo & 0xFFFFFFFFu);
+		return low ^ high;
+#endif
+	}
+
+	static uint64_t Avalanche(uint64_t h)
+	{
+		h ^= h >> 37;
+		h *= PRIME_MX1;
+		return h ^ (h >> 32);
+	}
+
+	static uint64_t Avalanche64(uint64_t h)
+	{
+		h ^= h >> 33;
+		h *= PRIME64_2;
+		h ^= h >> 29;
+		h *= PRIME64_3;
+		return h ^ (h >> 32);
+	}
+
+	static uint64_t Mix16(const uint8_t* input, const uint8_t* secret)
+	{
+		return MultiplyFold64(Read64(input) ^ Read64(secret), Read64(input + 8) ^ Read64(secret + 8));
+	}
+
+	static uint64_t HashUpTo16(const uint8_t* input, size_t size)
+	{
+		if (size > 8)
+		{
+			uint64_t low = Read64(input) ^ (Read64(SECRET + 24) ^ Read64(SECRET + 32));
+			uint64_t high = Read64(input + size - 8) ^ (Read64(SECRET + 40) ^ Read64(SECRET + 48));
+			return Avalanche(size + Swap64(low) + high + MultiplyFold64(low, high));
+		}
+		if (size >= 4)
+		{
+			uint64_t combined = Read32(input + size - 4) + (static_cast<uint64_t>(Read32(input)) << 32);
+			uint64_t h = combined ^ (Read64(SECRET + 8) ^ Read64(SECRET + 16));
+			h ^= RotateLeft(h, 49) ^ RotateLeft(h, 24);
+			h *= PRIME_MX2;
+			h ^= (h >> 35) + size;
+			h *= PRIME_MX2;
+			return h ^ (h >> 28);
+		}
+		if (size > 0)
+		{
+			uint32_t combined = static_cast<uint32_t>(input[0]) << 16 | static_cast<uint32_t>(input[size >> 1]) << 24 |
+				input[size - 1] | static_cast<uint32_t>(size) << 8;
+			return Avalanche64(combined ^ static_cast<uint64_t>(Read32(SECRET) ^ Read32(SECRET + 4)));
+		}
+		return Avalanche64(Read64(SECRET + 56) ^ Read64(SECRET + 64));
+	}
+
+	static uint64_t HashUpTo128(const uint8_t* input, size_t size)
+	{
+		uint64_t acc = size * PRIME64_1;
+		if (size > 32)
+		{
+			if (size > 64)
+			{
+				if (size > 96)
+				{
+					acc += Mix16(input + 48, SECRET + 96);
+					acc += Mix16(input + size - 64, SECRET + 112);
+				}
+				acc += Mix16(input + 32, SECRET + 64);
+				acc += Mix16(input + size - 48, SECRET + 80);
+			}
+			acc += Mix16(input + 16, SECRET + 32);
+			acc += Mix16(input + size - 32, SECRET + 48);
+		}
+		acc += Mix16(input, SECRET);
+		acc += Mix16(input + size - 16, SECRET + 16);
+		return Avalanche(acc);
+	}
+
+	static uint64_t HashUpTo240(const uint8_t* input, size_t size)
+	{
+		uint64_t acc = size * PRIME64_1;
+		for (size_t i = 0; i < 8; i++)
+			acc += Mix16(input + 16 * i, SECRET + 16 * i);
+		acc = Avalanche(acc);
+		for (size_t i = 8; i < size / 16; i++)
+			acc += Mix16(input + 16 * i, SECRET + 16 * (i - 8) + 3);
+		acc += Mix16(input + size - 16, SECRET + 136 - 17);
+		return Avalanche(acc);
+	}
+
+	// The long-input kernels. Accumulate consumes numStripes 64-byte stripes, moving 8 bytes along the secret
+	// per stripe; Scramble mixes the accumulators at the end of every block.
+	struct ScalarKernel
+	{
+		static void Accumulate(uint64_t* acc, const uint8_t* input, const uint8_t* secret, size_t numStripes)
+		{
+			for (size_t stripe = 0; stripe < numStripes; stripe++)
+			{
+				const uint8_t* data = input + stripe * STRIPE_LEN;
+				const uint8_t* key = secret + stripe * SECRET_CONSUME_RATE;
+				for (int i = 0; i < 8; i++)
+				{
+					uint64_t value = Read64(data + 8 * i);
+					uint64_t keyed = value ^ Read64(key + 8 * i);
+					acc[i ^ 1] += value;
+					acc[i] += (keyed & 0xFFFFFFFFu) * (keyed >> 32);
+				}
+			}
+		}
+
+		static void Scramble(uint64_t* acc, const uint8_t* secret)
+		{
+			for (int i = 0; i < 8; i++)
+			{
+				uint64_t value = acc[i];
+				value ^= value >> 47;
+				value ^= Read64(secret + 8 * i);
+				acc[i] = value * PRIME32_1;
+			}
+		}
+	};
+
+#ifdef CONTENT_HASH_X86
+	struct Sse2Kernel
+	{
+		static void Accumulate(uint64_t* acc, const uint8_t* input, const uint8_t* secret, size_t numStripes)
+		{
+			auto* accVec = reinterpret_cast<__m128i*>(acc);
+			__m128i a0 = _mm_load_si128(accVec + 0);
+			__m128i a1 = _mm_load_si128(accVec + 1);
+			__m128i a2 = _mm_load_si128(accVec + 2);
+			__m128i a3 = _mm_load_si128(accVec + 3);
+			for (size_t stripe = 0; stripe < numStripes; stripe++)
+			{
+				const auto* data = reinterpret_cast<const __m128i*>(input + stripe * STRIPE_LEN);
+				const auto* key = reinterpret_cast<const __m128i*>(secret + stripe * SECRET_CONSUME_RATE);
+				a0 = Round(a0, _mm_loadu_si128(data + 0), _mm_loadu_si128(key + 0));
+				a1 = Round(a1, _mm_loadu_si128(data + 1), _mm_loadu_si128(key + 1));
+				a2 = Round(a2, _mm_loadu_si128(data + 2), _mm_loadu_si128(key + 2));
+				a3 = Round(a3, _mm_loadu_si128(data + 3), _mm_loadu_si128(key + 3));
+			}
+			_mm_store_si128(accVec + 0, a0);
+			_mm_store_si128(accVec + 1, a1);
+			_mm_store_si128(accVec + 2, a2);
+			_mm_store_si128(accVec + 3, a3);
+		}
+
+		static __m128i Round(__m128i acc, __m128i data, __m128i key)
+		{
+			__m128i keyed = _mm_xor_si128(data, key);
+			__m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+			// Each lane's data goes to the neighbouring accumulator, as acc[i ^ 1] in the scalar kernel.
+			__m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+			return _mm_add_epi64(_mm_add_epi64(acc, swapped), product);
+		}
+
+		static void Scramble(uint64_t* acc, const uint8_t* secret)
+		{
+			const __m128i prime = _mm_set1_epi32(static_cast<int>(PRIME32_1));
+			auto* accVec = reinterpret_cast<__m128i*>(acc);
+			for (int i = 0; i < 4; i++)
+			{
+				__m128i value = _mm_load_si128(accVec + i);
+				value = _mm_xor_si128(value, _mm_srli_epi64(value, 47));
+				value = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i));
+				__m128i low = _mm_mul_epu32(value, prime);
+				__m128i high = _mm_mul_epu32(_mm_shuffle_epi32(value, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+				_mm_store_si128(accVec + i, _mm_add_epi64(low, _mm_slli_epi64(high, 32)));
+			}
+		}
+	};
+
+	struct Avx2Kernel
+	{
+		CONTENT_HASH_AVX2
+		static void Accumulate(uint64_t* acc, const uint8_t* input, const uint8_t* secret, size_t numStripes)
+		{
+			auto* accVec = reinterpret_cast<__m256i*>(acc);
+			__m256i a0 = _mm256_load_si256(accVec + 0);
+			__m256i a1 = _mm256_load_si256(accVec + 1);
+			for (size_t stripe = 0; stripe < numStripes; stripe++)
+			{
+				const auto* data = reinterpret_cast<const __m256i*>(input + stripe * STRIPE_LEN);
+				const auto* key = reinterpret_cast<const __m256i*>(secret + stripe * SECRET_CONSUME_RATE);
+				a0 = Round(a0, _mm256_loadu_si256(data + 0), _mm256_loadu_si256(key + 0));
+				a1 = Round(a1, _mm256_loadu_si256(data + 1), _mm256_loadu_si256(key + 1));
+			}
+			_mm256_store_si256(accVec + 0, a0);
+			_mm256_store_si256(accVec + 1, a1);
+		}
+
+		CONTENT_HASH_AVX2
+		static __m256i Round(__m256i acc, __m256i data, __m256i key)
+		{
+			__m256i keyed = _mm256_xor_si256(data, key);
+			__m256i product = _mm256_mul_epu32(keyed, _mm256_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+			__m256i swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+			return _mm256_add_epi64(_mm256_add_epi64(acc, swapped), product);
+		}
+
+		CONTENT_HASH_AVX2
+		static void Scramble(uint64_t* acc, const uint8_t* secret)
+		{
+			const __m256i prime = _mm256_set1_epi32(static_cast<int>(PRIME32_1));
+			auto* accVec = reinterpret_cast<__m256i*>(acc);
+			for (int i = 0; i < 2; i++)
+			{
+				__m256i value = _mm256_load_si256(accVec + i);
+				value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 47));
+				value = _mm256_xor_si256(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret) + i));
+				__m256i low = _mm256_mul_epu32(value, prime);
+				__m256i high = _mm256_mul_epu32(_mm256_shuffle_epi32(value, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+				_mm256_store_si256(accVec + i, _mm256_add_epi64(low, _mm256_slli_epi64(high, 32)));
+			}
+		}
+	};
+#endif
+
+	template <typename Kernel>
+	static uint64_t HashLong(const uint8_t* input, size_t size)
+	{
+		alignas(32) uint64_t acc[8] = {PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3,
+		                               PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1};
+
+		size_t numBlocks = (size - 1) / BLOCK_LEN;
+		for (size_t block = 0; block < numBlocks; block++)
+		{
+			Kernel::Accumulate(acc, input + block * BLOCK_LEN, SECRET, STRIPES_PER_BLOCK);
+			Kernel::Scramble(acc, SECRET + SECRET_SIZE - STRIPE_LEN);
+		}
+
+		// The partial last block, then the last 64 bytes again against their own slice of the secret.
+		size_t numStripes = ((size - 1) - numBlocks * BLOCK_LEN) / STRIPE_LEN;
+		Kernel::Accumulate(acc, input + numBlocks * BLOCK_LEN, SECRET, numStripes);
+		Kernel::Accumulate(acc, input + size - STRIPE_LEN, SECRET + SECRET_SIZE - STRIPE_LEN - 7, 1);
+
+		uint64_t result = size * PRIME64_1;
+		for (int i = 0; i < 4; i++)
+			result += MultiplyFold64(acc[2 * i] ^ Read64(SECRET + 11 + 16 * i),
+			                         acc[2 * i + 1] ^ Read64(SECRET + 11 + 16 * i + 8));
+		return Avalanche(result);
+	}
+
+	static uint64_t HashShort(const uint8_t* input, size_t size)
+	{
+		if (size <= 16)
+			return HashUpTo16(input, size);
+		if (size <= 128)
+			return HashUpTo128(input, size);
+		return HashUpTo240(input, size);
+	}
+
+	uint64_t Hash64(const void* data, size_t size)
+	{
+		const auto* input = static_cast<const uint8_t*>(data);
+		if (size <= 240)
+			return HashShort(input, size);
+#ifdef CONTENT_HASH_X86
+		const Cpu::Features& features = Cpu::GetFeatures();
+		if (features.Avx2)
+			return HashLong<Avx2Kernel>(input, size);
+		if (features.Sse2)
+			return HashLong<Sse2Kernel>(input, size);
+#endif
+		return HashLong<ScalarKernel>(input, size);
+	}
+
+	uint64_t Hash64Scalar(const void* data, size_t size)
+	{
+		const auto* input = static_cast<const uint8_t*>(data);
+		return size <= 240 ? HashShort(input, size) : HashLong<ScalarKernel>(input, size);
+	}
+}
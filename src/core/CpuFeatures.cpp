@@ -0,0 +1,45 @@
+#include "core/CpuFeatures.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_FEATURES_X86
+#ifdef _MSC_VER
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+#endif
+
+namespace Cpu
+{
+	static Features DetectFeatures()
+	{
+		Features features;
+#if defined(CPU_FEATURES_X86) && defined(_MSC_VER)
+		int info[4] = {};
+		__cpuid(info, 0);
+		int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		features.Sse2 = (info[3] & (1 << 26)) != 0;
+		features.Ssse3 = (info[2] & (1 << 9)) != 0;
+		bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+
+		if (maxLeaf >= 7 && osSavesYmm)
+		{
+			__cpuidex(info, 7, 0);
+			features.Avx2 = (info[1] & (1 << 5)) != 0;
+		}
+#elif defined(CPU_FEATURES_X86)
+		__builtin_cpu_init();
+		features.Sse2 = __builtin_cpu_supports("sse2");
+		features.Ssse3 = __builtin_cpu_supports("ssse3");
+		features.Avx2 = __builtin_cpu_supports("avx2");
+#endif
+		return features;
+	}
+
+	const Features& GetFeatures()
+	{
+		static const Features features = DetectFeatures();
+		return features;
+	}
+}
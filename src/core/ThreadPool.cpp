@@ -0,0 +1,205 @@
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+
+namespace
+{
+	thread_local const ThreadPool* t_currentPool = nullptr;
+	thread_local int t_currentWorkerIndex = -1;
+}
+
+ThreadPool::~ThreadPool()
+{
+	Shutdown();
+}
+
+void ThreadPool::Start(int numThreads)
+{
+	if (!m_threads.empty())
+		return;
+
+	if (numThreads <= 0)
+		numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stopping = false;
+		m_numQueued = 0;
+		m_numUnfinished = 0;
+	}
+
+	m_queues.clear();
+	for (int i = 0; i < numThreads; i++)
+		m_queues.push_back(std::make_unique<WorkerQueue>());
+
+	m_threads.reserve(numThreads);
+	for (int i = 0; i < numThreads; i++)
+		m_threads.emplace_back(&ThreadPool::WorkerMain, this, i);
+}
+
+void ThreadPool::Shutdown()
+{
+	if (m_threads.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stopping = true;
+	}
+	m_wakeWorkers.notify_all();
+
+	for (std::thread& thread : m_threads)
+		thread.join();
+	m_threads.clear();
+	m_queues.clear();
+
+	std::lock_guard<std::mutex> lock(m_sleepMutex);
+	m_numQueued = 0;
+	m_numUnfinished = 0;
+	m_idle.notify_all();
+}
+
+int ThreadPool::GetCurrentWorkerIndex() const
+{
+	return t_currentPool == this ? t_currentWorkerIndex : -1;
+}
+
+void ThreadPool::Submit(Task task)
+{
+	if (m_queues.empty())
+		return;
+
+	int index = GetCurrentWorkerIndex();
+	if (index < 0)
+		index = static_cast<int>(m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size());
+
+	// Count the task before it becomes visible, so a worker that picks it up at once cannot finish it
+	// before it is counted.
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_numQueued++;
+		m_numUnfinished++;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_queues[index]->Mutex);
+		m_queues[index]->Tasks.push_back(std::move(task));
+	}
+	m_wakeWorkers.notify_one();
+}
+
+void ThreadPool::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(m_sleepMutex);
+	m_idle.wait(lock, [this] { return m_numUnfinished == 0 || m_stopping; });
+}
+
+void ThreadPool::ParallelFor(int count, const std::function<void(int)>& body)
+{
+	int numHelpers = std::min(count - 1, GetNumThreads());
+	if (numHelpers <= 0)
+	{
+		for (int i = 0; i < count; i++)
+			body(i);
+		return;
+	}
+
+	struct Loop
+	{
+		const std::function<void(int)>* Body = nullptr;
+		int Count = 0;
+		std::atomic<int> Next = 0;
+		std::mutex Mutex;
+		std::condition_variable Finished;
+		int NumFinished = 0; // guarded by Mutex
+	};
+
+	auto loop = std::make_shared<Loop>();
+	loop->Body = &body;
+	loop->Count = count;
+
+	// Indices are claimed one at a time, so a helper that only starts after the caller has drained the
+	// loop claims nothing and never touches body, which may be gone by then.
+	auto runLoop = [](Loop& loop)
+	{
+		int numFinished = 0;
+		for (int i = loop.Next.fetch_add(1); i < loop.Count; i = loop.Next.fetch_add(1))
+		{
+			(*loop.Body)(i);
+			numFinished++;
+		}
+		if (numFinished == 0)
+			return;
+
+		std::lock_guard<std::mutex> lock(loop.Mutex);
+		loop.NumFinished += numFinished;
+		if (loop.NumFinished == loop.Count)
+			loop.Finished.notify_all();
+	};
+
+	for (int i = 0; i < numHelpers; i++)
+		Submit([loop, runLoop] { runLoop(*loop); });
+	runLoop(*loop);
+
+	std::unique_lock<std::mutex> lock(loop->Mutex);
+	loop->Finished.wait(lock, [&loop] { return loop->NumFinished == loop->Count; });
+}
+
+bool ThreadPool::TryPop(int index, Task& out_task)
+{
+	WorkerQueue& queue = *m_queues[index];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	if (queue.Tasks.empty())
+		return false;
+	out_task = std::move(queue.Tasks.back());
+	queue.Tasks.pop_back();
+	return true;
+}
+
+bool ThreadPool::TrySteal(int index, Task& out_task)
+{
+	int numQueues = static_cast<int>(m_queues.size());
+	for (int offset = 1; offset < numQueues; offset++)
+	{
+		WorkerQueue& victim = *m_queues[(index + offset) % numQueues];
+		std::lock_guard<std::mutex> lock(victim.Mutex);
+		if (victim.Tasks.empty())
+			continue;
+		out_task = std::move(victim.Tasks.front());
+		victim.Tasks.pop_front();
+		m_numSteals.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::WorkerMain(int index)
+{
+	t_currentPool = this;
+	t_currentWorkerIndex = index;
+
+	for (;;)
+	{
+		Task task;
+		if (TryPop(index, task) || TrySteal(index, task))
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_sleepMutex);
+				m_numQueued--;
+			}
+
+			task();
+
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			if (--m_numUnfinished == 0)
+				m_idle.notify_all();
+			continue;
+		}
+
+		// Sleep until something is queued. A count that runs ahead of the deques only costs another lap.
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wakeWorkers.wait(lock, [this] { return m_stopping || m_numQueued > 0; });
+		if (m_stopping)
+			return;
+	}
+}
@@ -0,0 +1,303 @@
+#include "image/AsyncImageLoader.h"
+#include "core/ContentHash.h"
+#include "image/MipGenerator.h"
+
+#include <algorithm>
+#include <iostream>
+
+AsyncImageLoader::~AsyncImageLoader()
+{
+	Shutdown();
+}
+
+void AsyncImageLoader::Start(int numWorkers, uint64_t maxBytesInFlight)
+{
+	if (m_running)
+		return;
+
+	if (numWorkers <= 0)
+	{
+		// Leave one core for the UI thread.
+		int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+		numWorkers = std::clamp(hardwareThreads - 1, 1, 8);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_running = true;
+		m_numWorkers = numWorkers;
+		m_maxBytesInFlight = maxBytesInFlight;
+	}
+	m_pool.Start(numWorkers);
+}
+
+void AsyncImageLoader::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_running)
+			return;
+		m_running = false;
+		m_queued.clear();
+	}
+
+	// The pool drains: running decodes finish and see m_running == false, tasks still queued find m_queued
+	// empty and return.
+	m_pool.Shutdown();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_completed.clear();
+	m_residentContent.clear();
+	m_decodingContent.clear();
+	m_bytesInFlight = 0;
+	m_numScheduled = 0;
+	m_numInFlight = 0;
+}
+
+AsyncImageHandle AsyncImageLoader::Request(const std::string& path, int maxDimension, int priority,
+                                           const BlockCompressionOptions& compression)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_running)
+		return INVALID_ASYNC_IMAGE_HANDLE;
+
+	Job job;
+	job.Handle = m_nextHandle++;
+	job.Path = path;
+	job.MaxDimension = maxDimension;
+	job.Priority = priority;
+	job.Compression = compression;
+	AsyncImageHandle handle = job.Handle;
+	m_queued.push_back(std::move(job));
+	m_numInFlight++;
+	ScheduleLocked();
+	return handle;
+}
+
+void AsyncImageLoader::SetPriority(AsyncImageHandle handle, int priority)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (std::vector<Job>* jobs : {&m_queued, &m_completed})
+	{
+		for (Job& job : *jobs)
+		{
+			if (job.Handle == handle)
+			{
+				job.Priority = priority;
+				return;
+			}
+		}
+	}
+}
+
+uint64_t AsyncImageLoader::MakeContentKey(uint64_t fileHash, int maxDimension,
+                                          const BlockCompressionOptions& compression)
+{
+	if (fileHash == 0)
+		return 0;
+
+	struct ContentKey
+	{
+		uint64_t FileHash;
+		int32_t MaxDimension;
+		int32_t CompressionQuality; // -1 when compression is off, as in the disk cache
+	};
+	ContentKey key = {fileHash, maxDimension, compression.Enabled ? compression.Quality : -1};
+	uint64_t hash = ContentHash::Hash64(&key, sizeof(key));
+	return hash != 0 ? hash : 1;
+}
+
+void AsyncImageLoader::ReleaseContent(uint64_t contentHash)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_residentContent.erase(contentHash);
+}
+
+int AsyncImageLoader::Publish(IAsyncTextureSink& sink, int maxImages)
+{
+	int published = 0;
+	while (maxImages <= 0 || published < maxImages)
+	{
+		Job job;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_completed.empty())
+				break;
+			size_t best = FindHighestPriority(m_completed);
+			job = std::move(m_completed[best]);
+			m_completed.erase(m_completed.begin() + best);
+			m_bytesInFlight -= job.Image.GetSizeInBytes() + job.Image.MipData.size();
+
+			// Requests that arrived while this one was decoding or waiting here share its image. From now on the
+			// sink holds it, until it says otherwise.
+			auto decoding = m_decodingContent.find(job.Image.ContentHash);
+			if (!job.Shared && decoding != m_decodingContent.end())
+			{
+				for (Job& sharer : decoding->second)
+					job.Sharers.push_back(std::move(sharer));
+				m_decodingContent.erase(decoding);
+			}
+			if (job.Succeeded && job.Image.ContentHash != 0)
+				m_residentContent.insert(job.Image.ContentHash);
+			m_numInFlight -= 1 + static_cast<int>(job.Sharers.size());
+			ScheduleLocked();
+		}
+
+		// The sink runs outside the lock so workers keep decoding while textures are created.
+		uint64_t contentHash = job.Image.ContentHash;
+		if (job.Shared)
+			sink.OnImageShared(job.Handle, job.Path, contentHash);
+		else if (job.Succeeded)
+			sink.OnImageDecoded(job.Handle, job.Path, job.Image);
+		else
+			sink.OnImageFailed(job.Handle, job.Path);
+
+		// The same bytes fail the same way.
+		for (const Job& sharer : job.Sharers)
+		{
+			if (job.Succeeded)
+				sink.OnImageShared(sharer.Handle, sharer.Path, contentHash);
+			else
+				sink.OnImageFailed(sharer.Handle, sharer.Path);
+		}
+		published++;
+	}
+	return published;
+}
+
+int AsyncImageLoader::GetNumPending() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_numInFlight;
+}
+
+uint64_t AsyncImageLoader::GetBytesInFlight() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_bytesInFlight;
+}
+
+size_t AsyncImageLoader::FindHighestPriority(const std::vector<Job>& jobs)
+{
+	// Handles increase with request order, so the lower one wins a tie.
+	size_t best = 0;
+	for (size_t i = 1; i < jobs.size(); i++)
+	{
+		if (jobs[i].Priority > jobs[best].Priority ||
+			(jobs[i].Priority == jobs[best].Priority && jobs[i].Handle < jobs[best].Handle))
+			best = i;
+	}
+	return best;
+}
+
+void AsyncImageLoader::ScheduleLocked()
+{
+	while (m_running && m_numScheduled < m_numWorkers && static_cast<size_t>(m_numScheduled) < m_queued.size() &&
+		m_bytesInFlight < m_maxBytesInFlight)
+	{
+		m_numScheduled++;
+		m_pool.Submit([this] { DecodeTask(); });
+	}
+}
+
+void AsyncImageLoader::DecodeTask()
+{
+	// One read buffer per pool thread, reused for every file it decodes.
+	thread_local ImageDecodeContext decodeContext;
+	decodeContext.Pool = &m_pool;
+	FileSource& source = decodeContext.Source;
+
+	// A task keeps taking the best queued job until the queue or the byte budget runs out, so priorities
+	// are re-evaluated at every pick rather than when the request was made.
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (m_running && !m_queued.empty() && m_bytesInFlight < m_maxBytesInFlight)
+	{
+		size_t best = FindHighestPriority(m_queued);
+		Job job = std::move(m_queued[best]);
+		m_queued.erase(m_queued.begin() + best);
+		lock.unlock();
+
+		// A cache hit is the finished image: mipmapped, compressed and at the upload pitch, with its hash.
+		DiskCacheKey cacheKey;
+		bool cacheable = m_diskCache && DiskTextureCache::MakeKey(job.Path, job.MaxDimension, job.Compression,
+		                                                          &cacheKey);
+		bool cached = cacheable && m_diskCache->Load(cacheKey, job.Image);
+		bool opened = !cached && source.Open(job.Path);
+
+		// Hashed as soon as it is mapped: this pass pages the file in, and the decoder reads it from memory.
+		// Cache entries store the key they were loaded with.
+		uint64_t contentHash = cached ? job.Image.ContentHash : 0;
+		if (opened)
+			contentHash = MakeContentKey(ContentHash::Hash64(source.GetData(), source.GetSize()), job.MaxDimension,
+			                             job.Compression);
+
+		lock.lock();
+		if (!m_running || (contentHash != 0 && ShareContentLocked(job, contentHash)))
+		{
+			source.Close();
+			continue; // the loop ends here when shutting down
+		}
+		lock.unlock();
+
+		if (cached)
+		{
+			job.Succeeded = true;
+		}
+		else if (!opened)
+		{
+			std::cerr << "Failed to open image: " << job.Path << std::endl;
+		}
+		else
+		{
+			job.Succeeded = ImageDecoder::DecodeMemory(source.GetData(), source.GetSize(), job.Image,
+			                                           job.MaxDimension, &m_pool);
+			source.Close();
+			if (job.Succeeded)
+			{
+				job.Image.ContentHash = contentHash;
+				MipGenerator::GenerateMipChain(job.Image);
+				if (job.Compression.Enabled)
+					BlockCompressor::CompressImage(job.Image, job.Compression.Quality, &m_pool);
+				if (cacheable)
+					m_diskCache->Store(cacheKey, job.Image);
+			}
+			else
+			{
+				std::cerr << "Failed to load image: " << job.Path << std::endl;
+				// Still published with its hash, so the requests that waited for it fail with it.
+				job.Image.ContentHash = contentHash;
+			}
+		}
+
+		lock.lock();
+		if (!m_running)
+			break;
+		m_bytesInFlight += job.Image.GetSizeInBytes() + job.Image.MipData.size();
+		m_completed.push_back(std::move(job));
+	}
+	m_numScheduled--;
+}
+
+bool AsyncImageLoader::ShareContentLocked(Job& job, uint64_t contentHash)
+{
+	if (m_residentContent.contains(contentHash))
+	{
+		job.Image.Release();
+		job.Image.ContentHash = contentHash;
+		job.Succeeded = true;
+		job.Shared = true;
+		m_completed.push_back(std::move(job));
+		return true;
+	}
+
+	auto decoding = m_decodingContent.find(contentHash);
+	if (decoding != m_decodingContent.end())
+	{
+		job.Image.Release();
+		decoding->second.push_back(std::move(job));
+		return true;
+	}
+
+	m_decodingContent.emplace(contentHash, std::vector<Job>());
+	return false;
+}
@@ -0,0 +1,287 @@
+#include "image/AtlasPacker.h"
+
+#include <cstring>
+#include <utility>
+
+// imgui_draw.cpp compiles its own static copy for the font atlas; this one is private to this file as well.
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imgui/imstb_rectpack.h"
+
+struct AtlasPacker::Page
+{
+	stbrp_context Context = {}; // points into Nodes and into itself, so a Page never moves
+	std::vector<stbrp_node> Nodes;
+	uint32_t NumEntries = 0;
+	uint64_t RemovedArea = 0; // texels of entries removed since the page was last reset or repacked
+};
+
+AtlasPacker::AtlasPacker() = default;
+AtlasPacker::~AtlasPacker() = default;
+AtlasPacker::AtlasPacker(AtlasPacker&& other) noexcept = default;
+AtlasPacker& AtlasPacker::operator=(AtlasPacker&& other) noexcept = default;
+
+void AtlasPacker::Initialize(int pageSize, int maxPages)
+{
+	m_pageSize = pageSize;
+	m_maxPages = maxPages;
+	Reset();
+}
+
+void AtlasPacker::Reset()
+{
+	m_pages.clear();
+	m_entries.clear();
+	m_unusedEntries.clear();
+	m_numEntries = 0;
+	m_repacks = 0;
+}
+
+std::unique_ptr<AtlasPacker::Page> AtlasPacker::CreatePage() const
+{
+	auto page = std::make_unique<Page>();
+	// One node per column keeps the packer from quantizing widths; see stbrp_init_target.
+	page->Nodes.resize(m_pageSize);
+	stbrp_init_target(&page->Context, m_pageSize, m_pageSize, page->Nodes.data(), m_pageSize);
+	// Best fit leaves fewer holes under the skyline than bottom-left for the mixed sizes of icon sets.
+	stbrp_setup_heuristic(&page->Context, STBRP_HEURISTIC_Skyline_BF_sortHeight);
+	return page;
+}
+
+AtlasHandle AtlasPacker::AddEntry(int page, int x, int y, int width, int height)
+{
+	AtlasHandle handle;
+	if (!m_unusedEntries.empty())
+	{
+		handle.Index = m_unusedEntries.back();
+		m_unusedEntries.pop_back();
+	}
+	else
+	{
+		handle.Index = static_cast<uint32_t>(m_entries.size());
+		m_entries.emplace_back();
+	}
+
+	Entry& entry = m_entries[handle.Index];
+	entry.Page = page;
+	entry.X = x;
+	entry.Y = y;
+	entry.Width = width;
+	entry.Height = height;
+	handle.Generation = entry.Generation;
+
+	m_pages[page]->NumEntries++;
+	m_numEntries++;
+	return handle;
+}
+
+void AtlasPacker::PackInto(int page, AtlasRequest* requests, std::vector<size_t>& pending)
+{
+	std::vector<stbrp_rect> rects(pending.size());
+	for (size_t i = 0; i < pending.size(); i++)
+	{
+		const AtlasRequest& request = requests[pending[i]];
+		rects[i].id = static_cast<int>(i);
+		rects[i].w = request.Width + 2 * APP_ATLAS_PADDING;
+		rects[i].h = request.Height + 2 * APP_ATLAS_PADDING;
+	}
+	stbrp_pack_rects(&m_pages[page]->Context, rects.data(), static_cast<int>(rects.size()));
+
+	// stbrp_pack_rects restores the original order, so rects[i] still belongs to pending[i].
+	size_t numLeft = 0;
+	for (size_t i = 0; i < pending.size(); i++)
+	{
+		if (rects[i].was_packed)
+			requests[pending[i]].Handle = AddEntry(page, rects[i].x, rects[i].y, rects[i].w, rects[i].h);
+		else
+			pending[numLeft++] = pending[i];
+	}
+	pending.resize(numLeft);
+}
+
+bool AtlasPacker::Repack(int page, AtlasRequest* requests, std::vector<size_t>& pending,
+                         std::vector<AtlasMove>& out_moves)
+{
+	// The page's entries come first in rects, then the pending requests.
+	std::vector<uint32_t> entries;
+	entries.reserve(m_pages[page]->NumEntries);
+	for (uint32_t i = 0; i < m_entries.size(); i++)
+		if (m_entries[i].Page == page)
+			entries.push_back(i);
+
+	std::vector<stbrp_rect> rects(entries.size() + pending.size());
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		rects[i].w = m_entries[entries[i]].Width;
+		rects[i].h = m_entries[entries[i]].Height;
+	}
+	for (size_t i = 0; i < pending.size(); i++)
+	{
+		rects[entries.size() + i].w = requests[pending[i]].Width + 2 * APP_ATLAS_PADDING;
+		rects[entries.size() + i].h = requests[pending[i]].Height + 2 * APP_ATLAS_PADDING;
+	}
+
+	std::unique_ptr<Page> repacked = CreatePage();
+	stbrp_pack_rects(&repacked->Context, rects.data(), static_cast<int>(rects.size()));
+
+	// Sorted by height, the page's own entries are not guaranteed to fit again; and a repack that takes
+	// none of the requests only costs copies.
+	bool gainsRequest = false;
+	for (size_t i = 0; i < rects.size(); i++)
+	{
+		if (i < entries.size() && !rects[i].was_packed)
+			return false;
+		if (i >= entries.size() && rects[i].was_packed)
+			gainsRequest = true;
+	}
+	if (!gainsRequest)
+		return false;
+
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		Entry& entry = m_entries[entries[i]];
+		AtlasHandle handle{entries[i], entry.Generation};
+		out_moves.push_back({handle, page, entry.X, entry.Y, rects[i].x, rects[i].y, entry.Width, entry.Height});
+		entry.X = rects[i].x;
+		entry.Y = rects[i].y;
+	}
+	repacked->NumEntries = m_pages[page]->NumEntries;
+	m_pages[page] = std::move(repacked);
+	m_repacks++;
+
+	size_t numLeft = 0;
+	for (size_t i = 0; i < pending.size(); i++)
+	{
+		const stbrp_rect& rect = rects[entries.size() + i];
+		if (rect.was_packed)
+			requests[pending[i]].Handle = AddEntry(page, rect.x, rect.y, rect.w, rect.h);
+		else
+			pending[numLeft++] = pending[i];
+	}
+	pending.resize(numLeft);
+	return true;
+}
+
+int AtlasPacker::Insert(AtlasRequest* requests, size_t numRequests, std::vector<AtlasMove>& out_moves)
+{
+	std::vector<size_t> pending;
+	pending.reserve(numRequests);
+	for (size_t i = 0; i < numRequests; i++)
+	{
+		requests[i].Handle = {};
+		if (requests[i].Width > 0 && requests[i].Height > 0 &&
+			requests[i].Width + 2 * APP_ATLAS_PADDING <= m_pageSize &&
+			requests[i].Height + 2 * APP_ATLAS_PADDING <= m_pageSize)
+			pending.push_back(i);
+	}
+	const size_t numPackable = pending.size();
+
+	// Room on top of the skylines costs nothing; a repack costs a copy of the page, a new page its memory. So
+	// only pages that lost a good part of their area are repacked before a page is added, and the others only
+	// when no page can be added.
+	for (int page = 0; page < GetNumPages() && !pending.empty(); page++)
+		PackInto(page, requests, pending);
+	const uint64_t worthRepacking = static_cast<uint64_t>(m_pageSize) * m_pageSize / 4;
+	for (int page = 0; page < GetNumPages() && !pending.empty(); page++)
+		if (m_pages[page]->RemovedArea >= worthRepacking)
+			Repack(page, requests, pending, out_moves);
+	while (!pending.empty() && GetNumPages() < m_maxPages)
+	{
+		m_pages.push_back(CreatePage());
+		size_t numPending = pending.size();
+		PackInto(GetNumPages() - 1, requests, pending);
+		if (pending.size() == numPending)
+			break; // cannot happen for requests that fit a page, but never loop on it
+	}
+	for (int page = 0; page < GetNumPages() && !pending.empty(); page++)
+		if (m_pages[page]->RemovedArea != 0 && m_pages[page]->RemovedArea < worthRepacking)
+			Repack(page, requests, pending, out_moves);
+
+	return static_cast<int>(numPackable - pending.size());
+}
+
+bool AtlasPacker::Remove(AtlasHandle handle)
+{
+	if (!IsValid(handle))
+		return false;
+
+	Entry& entry = m_entries[handle.Index];
+	Page& page = *m_pages[entry.Page];
+	page.RemovedArea += static_cast<uint64_t>(entry.Width) * entry.Height;
+	if (--page.NumEntries == 0)
+	{
+		// Nothing left to keep, so the whole page is free again without copying anything.
+		m_pages[entry.Page] = CreatePage();
+	}
+
+	entry.Page = -1;
+	entry.Generation++;
+	m_unusedEntries.push_back(handle.Index);
+	m_numEntries--;
+	return true;
+}
+
+bool AtlasPacker::IsValid(AtlasHandle handle) const
+{
+	return handle.Index < m_entries.size() && m_entries[handle.Index].Page >= 0 &&
+		m_entries[handle.Index].Generation == handle.Generation;
+}
+
+AtlasPlacement AtlasPacker::GetPlacement(AtlasHandle handle) const
+{
+	AtlasPlacement placement;
+	if (!IsValid(handle))
+		return placement;
+
+	const Entry& entry = m_entries[handle.Index];
+	placement.Page = entry.Page;
+	placement.X = entry.X + APP_ATLAS_PADDING;
+	placement.Y = entry.Y + APP_ATLAS_PADDING;
+	placement.Width = entry.Width - 2 * APP_ATLAS_PADDING;
+	placement.Height = entry.Height - 2 * APP_ATLAS_PADDING;
+	return placement;
+}
+
+bool AtlasPacker::IsPageEmpty(int page) const
+{
+	return m_pages[page]->NumEntries == 0;
+}
+
+AtlasPackerStats AtlasPacker::GetStats() const
+{
+	AtlasPackerStats stats;
+	stats.NumPages = static_cast<uint32_t>(m_pages.size());
+	stats.NumEntries = m_numEntries;
+	stats.PageArea = static_cast<uint64_t>(m_pageSize) * m_pageSize * m_pages.size();
+	stats.Repacks = m_repacks;
+	for (const Entry& entry : m_entries)
+		if (entry.Page >= 0)
+			stats.LiveArea += static_cast<uint64_t>(entry.Width) * entry.Height;
+
+	// The skyline ends in a sentinel node at x = width, so every other node opens a segment up to the next one.
+	for (const std::unique_ptr<Page>& page : m_pages)
+		for (const stbrp_node* node = page->Context.active_head; node && node->next; node = node->next)
+			stats.UsedArea += static_cast<uint64_t>(node->next->x - node->x) * node->y;
+	return stats;
+}
+
+void AtlasPacker::CopyWithPadding(const unsigned char* pixels, size_t rowPitch, int width, int height,
+                                  unsigned char* dst, size_t dstRowPitch)
+{
+	const int paddedWidth = width + 2 * APP_ATLAS_PADDING;
+	const int paddedHeight = height + 2 * APP_ATLAS_PADDING;
+	for (int y = 0; y < paddedHeight; y++)
+	{
+		int srcY = y - APP_ATLAS_PADDING;
+		srcY = srcY < 0 ? 0 : srcY >= height ? height - 1 : srcY;
+		const unsigned char* srcRow = pixels + static_cast<size_t>(srcY) * rowPitch;
+		unsigned char* dstRow = dst + static_cast<size_t>(y) * dstRowPitch;
+
+		for (int x = 0; x < APP_ATLAS_PADDING; x++)
+		{
+			memcpy(dstRow + x * 4, srcRow, 4);
+			memcpy(dstRow + (paddedWidth - 1 - x) * 4, srcRow + (width - 1) * 4, 4);
+		}
+		memcpy(dstRow + APP_ATLAS_PADDING * 4, srcRow, static_cast<size_t>(width) * 4);
+	}
+}
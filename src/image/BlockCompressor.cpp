@@ -0,0 +1,669 @@
+#include "image/BlockCompressor.h"
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOCK_COMPRESSOR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace BlockCompressor
+{
+	// Interpolation weights of BC7's 4-bit indices, out of 64.
+	static constexpr int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+	// Weight of the second endpoint for each BC1 index in four-color mode.
+	static constexpr float BC1_WEIGHTS[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+	static constexpr int BC7_MODE6 = 1 << 6;
+	// Rows of blocks per task: enough work to pay for the task, few enough rows to balance the threads.
+	static constexpr int BLOCK_ROWS_PER_TASK = 4;
+
+	static int GetRefinementPasses(int quality)
+	{
+		return quality <= 0 ? 0 : quality == 1 ? 2 : 8;
+	}
+
+	static void LoadBlock(const unsigned char* src, int width, int height, size_t rowPitch, int blockX, int blockY,
+	                      unsigned char* block)
+	{
+		// Blocks hanging over the edge of small mip levels repeat the last row and column.
+		for (int y = 0; y < 4; y++)
+		{
+			const unsigned char* row = src + std::min(blockY * 4 + y, height - 1) * rowPitch;
+			if (blockX * 4 + 4 <= width)
+			{
+				memcpy(block + y * 16, row + blockX * 16, 16);
+				continue;
+			}
+			for (int x = 0; x < 4; x++)
+				memcpy(block + y * 16 + x * 4, row + std::min(blockX * 4 + x, width - 1) * 4, 4);
+		}
+	}
+
+	uint32_t SelectNearestReference(const unsigned char* pixels, const unsigned char* palette, int numColors,
+	                                uint8_t* indices)
+	{
+		uint32_t total = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			const unsigned char* pixel = pixels + i * 4;
+			int best = INT_MAX;
+			int bestIndex = 0;
+			for (int k = 0; k < numColors; k++)
+			{
+				int error = 0;
+				for (int c = 0; c < 4; c++)
+				{
+					int d = pixel[c] - palette[k * 4 + c];
+					error += d * d;
+				}
+				if (error < best)
+				{
+					best = error;
+					bestIndex = k;
+				}
+			}
+			indices[i] = static_cast<uint8_t>(bestIndex);
+			total += static_cast<uint32_t>(best);
+		}
+		return total;
+	}
+
+#ifdef BLOCK_COMPRESSOR_SSE2
+	// Four pixels at a time against each palette entry; ties go to the lower index as in the scalar loop.
+	static uint32_t SelectNearestSse2(const unsigned char* pixels, const unsigned char* palette, int numColors,
+	                                  uint8_t* indices)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i entries[16];
+		for (int k = 0; k < numColors; k++)
+		{
+			int color;
+			memcpy(&color, palette + k * 4, 4);
+			entries[k] = _mm_unpacklo_epi8(_mm_set1_epi32(color), zero);
+		}
+
+		__m128i total = zero;
+		for (int i = 0; i < 16; i += 4)
+		{
+			__m128i quad = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4));
+			__m128i pixels01 = _mm_unpacklo_epi8(quad, zero);
+			__m128i pixels23 = _mm_unpackhi_epi8(quad, zero);
+			__m128i best = _mm_set1_epi32(INT_MAX);
+			__m128i bestIndex = zero;
+			for (int k = 0; k < numColors; k++)
+			{
+				__m128i d01 = _mm_sub_epi16(pixels01, entries[k]);
+				__m128i d23 = _mm_sub_epi16(pixels23, entries[k]);
+				// RG and BA sums of squares per pixel, then added pairwise into one error per pixel.
+				__m128 squares01 = _mm_castsi128_ps(_mm_madd_epi16(d01, d01));
+				__m128 squares23 = _mm_castsi128_ps(_mm_madd_epi16(d23, d23));
+				__m128i error = _mm_add_epi32(
+					_mm_castps_si128(_mm_shuffle_ps(squares01, squares23, _MM_SHUFFLE(2, 0, 2, 0))),
+					_mm_castps_si128(_mm_shuffle_ps(squares01, squares23, _MM_SHUFFLE(3, 1, 3, 1))));
+
+				__m128i less = _mm_cmplt_epi32(error, best);
+				best = _mm_or_si128(_mm_and_si128(less, error), _mm_andnot_si128(less, best));
+				bestIndex = _mm_or_si128(_mm_and_si128(less, _mm_set1_epi32(k)),
+				                         _mm_andnot_si128(less, bestIndex));
+			}
+			total = _mm_add_epi32(total, best);
+
+			alignas(16) int32_t lanes[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(lanes), bestIndex);
+			for (int j = 0; j < 4; j++)
+				indices[i + j] = static_cast<uint8_t>(lanes[j]);
+		}
+
+		alignas(16) uint32_t sums[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(sums), total);
+		return sums[0] + sums[1] + sums[2] + sums[3];
+	}
+#endif
+
+	uint32_t SelectNearest(const unsigned char* pixels, const unsigned char* palette, int numColors, uint8_t* indices)
+	{
+#ifdef BLOCK_COMPRESSOR_SSE2
+		return SelectNearestSse2(pixels, palette, numColors, indices);
+#else
+		return SelectNearestReference(pixels, palette, numColors, indices);
+#endif
+	}
+
+	// Extremes of the block along its principal axis, found by power iteration on the covariance of the
+	// first NumChannels channels.
+	template <int NumChannels>
+	static void FindEndpoints(const unsigned char* pixels, float* out_endpoint0, float* out_endpoint1)
+	{
+		// Integer sums are exact and spare a conversion per channel and pixel.
+		int sums[4] = {};
+		int products[4][4] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			const unsigned char* pixel = pixels + i * 4;
+			for (int a = 0; a < NumChannels; a++)
+			{
+				sums[a] += pixel[a];
+				for (int b = a; b < NumChannels; b++)
+					products[a][b] += pixel[a] * pixel[b];
+			}
+		}
+
+		float mean[4] = {};
+		float covariance[4][4] = {};
+		for (int a = 0; a < NumChannels; a++)
+		{
+			mean[a] = sums[a] / 16.0f;
+			for (int b = a; b < NumChannels; b++)
+				covariance[a][b] = products[a][b] - sums[a] * sums[b] / 16.0f;
+		}
+
+		// Start from the column of the channel that varies most, which is never orthogonal to the axis.
+		int widest = 0;
+		for (int c = 1; c < NumChannels; c++)
+			if (covariance[c][c] > covariance[widest][widest])
+				widest = c;
+
+		float axis[4] = {};
+		for (int c = 0; c < NumChannels; c++)
+			axis[c] = c <= widest ? covariance[c][widest] : covariance[widest][c];
+		for (int iteration = 0; iteration < 4; iteration++)
+		{
+			float next[4] = {};
+			float largest = 0.0f;
+			for (int a = 0; a < NumChannels; a++)
+			{
+				for (int b = 0; b < NumChannels; b++)
+					next[a] += (a <= b ? covariance[a][b] : covariance[b][a]) * axis[b];
+				largest = std::max(largest, std::fabs(next[a]));
+			}
+			if (largest == 0.0f)
+				break;
+			float scale = 1.0f / largest;
+			for (int c = 0; c < NumChannels; c++)
+				axis[c] = next[c] * scale;
+		}
+
+		float length = 0.0f;
+		for (int c = 0; c < NumChannels; c++)
+			length += axis[c] * axis[c];
+		float minT = 0.0f;
+		float maxT = 0.0f;
+		if (length > 0.0f)
+		{
+			float scale = 1.0f / std::sqrt(length);
+			for (int c = 0; c < NumChannels; c++)
+				axis[c] *= scale;
+			for (int i = 0; i < 16; i++)
+			{
+				float t = 0.0f;
+				for (int c = 0; c < NumChannels; c++)
+					t += (pixels[i * 4 + c] - mean[c]) * axis[c];
+				minT = std::min(minT, t);
+				maxT = std::max(maxT, t);
+			}
+		}
+
+		for (int c = 0; c < NumChannels; c++)
+		{
+			out_endpoint0[c] = std::clamp(mean[c] + minT * axis[c], 0.0f, 255.0f);
+			out_endpoint1[c] = std::clamp(mean[c] + maxT * axis[c], 0.0f, 255.0f);
+		}
+	}
+
+	// Least-squares endpoints for the given indices, where weights[index] is the share of endpoint 1.
+	// Returns false when every pixel uses the same weight and the system has no single solution.
+	template <int NumChannels>
+	static bool FitEndpoints(const unsigned char* pixels, const uint8_t* indices, const float* weights,
+	                         float* out_endpoint0, float* out_endpoint1)
+	{
+		float aa = 0.0f;
+		float bb = 0.0f;
+		float ab = 0.0f;
+		float ax[4] = {};
+		float bx[4] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			float b = weights[indices[i]];
+			float a = 1.0f - b;
+			aa += a * a;
+			bb += b * b;
+			ab += a * b;
+			for (int c = 0; c < NumChannels; c++)
+			{
+				ax[c] += a * pixels[i * 4 + c];
+				bx[c] += b * pixels[i * 4 + c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) < 1e-4f)
+			return false;
+		float inverse = 1.0f / determinant;
+		for (int c = 0; c < NumChannels; c++)
+		{
+			out_endpoint0[c] = std::clamp((bb * ax[c] - ab * bx[c]) * inverse, 0.0f, 255.0f);
+			out_endpoint1[c] = std::clamp((aa * bx[c] - ab * ax[c]) * inverse, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	struct Bc1Block
+	{
+		uint16_t Color0 = 0;
+		uint16_t Color1 = 0;
+		uint8_t Indices[16] = {};
+		uint32_t Error = UINT32_MAX;
+	};
+
+	static uint16_t PackRgb565(const float* rgb)
+	{
+		// The endpoints are clamped to [0, 255], so adding a half rounds.
+		int r = static_cast<int>(rgb[0] * (31.0f / 255.0f) + 0.5f);
+		int g = static_cast<int>(rgb[1] * (63.0f / 255.0f) + 0.5f);
+		int b = static_cast<int>(rgb[2] * (31.0f / 255.0f) + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	static void UnpackRgb565(uint16_t color, unsigned char* rgba)
+	{
+		int r = color >> 11;
+		int g = (color >> 5) & 63;
+		int b = color & 31;
+		rgba[0] = static_cast<unsigned char>((r << 3) | (r >> 2));
+		rgba[1] = static_cast<unsigned char>((g << 2) | (g >> 4));
+		rgba[2] = static_cast<unsigned char>((b << 3) | (b >> 2));
+		rgba[3] = 0;
+	}
+
+	// Four-color mode needs color0 > color1, so the pair is ordered before the palette is built; equal colors
+	// would select the three-color mode, whose index 3 is transparent, and only ever use index 0.
+	static void EvaluateBc1(const unsigned char* pixels, uint16_t color0, uint16_t color1, Bc1Block& out_block)
+	{
+		out_block.Color0 = std::max(color0, color1);
+		out_block.Color1 = std::min(color0, color1);
+
+		alignas(16) unsigned char palette[16];
+		UnpackRgb565(out_block.Color0, palette);
+		UnpackRgb565(out_block.Color1, palette + 4);
+		for (int c = 0; c < 4; c++)
+		{
+			palette[8 + c] = static_cast<unsigned char>((2 * palette[c] + palette[4 + c] + 1) / 3);
+			palette[12 + c] = static_cast<unsigned char>((palette[c] + 2 * palette[4 + c] + 1) / 3);
+		}
+		int numColors = out_block.Color0 == out_block.Color1 ? 1 : 4;
+		out_block.Error = SelectNearest(pixels, palette, numColors, out_block.Indices);
+	}
+
+	static void TryBc1(const unsigned char* pixels, uint16_t color0, uint16_t color1, Bc1Block& best)
+	{
+		Bc1Block candidate;
+		EvaluateBc1(pixels, color0, color1, candidate);
+		if (candidate.Error < best.Error)
+			best = candidate;
+	}
+
+	// Nudges each 5/6/5 component of both endpoints by one step while that lowers the error.
+	static void SearchBc1Neighbours(const unsigned char* pixels, Bc1Block& best)
+	{
+		static constexpr int SHIFTS[3] = {11, 5, 0};
+		static constexpr int MASKS[3] = {31, 63, 31};
+		bool improved = true;
+		for (int sweep = 0; sweep < 2 && improved && best.Error > 0; sweep++)
+		{
+			improved = false;
+			for (int endpoint = 0; endpoint < 2; endpoint++)
+			{
+				for (int channel = 0; channel < 3; channel++)
+				{
+					for (int delta = -1; delta <= 1; delta += 2)
+					{
+						uint16_t colors[2] = {best.Color0, best.Color1};
+						int value = ((colors[endpoint] >> SHIFTS[channel]) & MASKS[channel]) + delta;
+						if (value < 0 || value > MASKS[channel])
+							continue;
+						int cleared = colors[endpoint] & ~(MASKS[channel] << SHIFTS[channel]);
+						colors[endpoint] = static_cast<uint16_t>(cleared | (value << SHIFTS[channel]));
+						uint32_t before = best.Error;
+						TryBc1(pixels, colors[0], colors[1], best);
+						improved |= best.Error < before;
+					}
+				}
+			}
+		}
+	}
+
+	void CompressBlockBc1(const unsigned char* block, int quality, unsigned char* out)
+	{
+		// Alpha is cleared so that it drops out of the palette distances.
+		alignas(16) unsigned char pixels[64];
+		memcpy(pixels, block, sizeof(pixels));
+		for (int i = 0; i < 16; i++)
+			pixels[i * 4 + 3] = 0;
+
+		float endpoint0[4];
+		float endpoint1[4];
+		FindEndpoints<3>(pixels, endpoint0, endpoint1);
+		Bc1Block best;
+		EvaluateBc1(pixels, PackRgb565(endpoint0), PackRgb565(endpoint1), best);
+
+		// EvaluateBc1 may have swapped the endpoints, which FitEndpoints then sees through the indices.
+		for (int pass = 0; pass < GetRefinementPasses(quality) && best.Error > 0; pass++)
+		{
+			uint32_t before = best.Error;
+			if (!FitEndpoints<3>(pixels, best.Indices, BC1_WEIGHTS, endpoint0, endpoint1))
+				break;
+			TryBc1(pixels, PackRgb565(endpoint0), PackRgb565(endpoint1), best);
+			if (best.Error >= before)
+				break;
+		}
+		if (quality >= 2)
+			SearchBc1Neighbours(pixels, best);
+
+		uint32_t indexBits = 0;
+		for (int i = 0; i < 16; i++)
+			indexBits |= static_cast<uint32_t>(best.Indices[i]) << (i * 2);
+		out[0] = static_cast<unsigned char>(best.Color0);
+		out[1] = static_cast<unsigned char>(best.Color0 >> 8);
+		out[2] = static_cast<unsigned char>(best.Color1);
+		out[3] = static_cast<unsigned char>(best.Color1 >> 8);
+		for (int i = 0; i < 4; i++)
+			out[4 + i] = static_cast<unsigned char>(indexBits >> (i * 8));
+	}
+
+	struct Bc7Block
+	{
+		uint8_t Endpoints[2][4] = {}; // 7 bits per channel
+		uint8_t PBits[2] = {};
+		uint8_t Indices[16] = {};
+		uint32_t Error = UINT32_MAX;
+	};
+
+	// Mode 6 endpoints are 7 bits per channel plus one p-bit shared by the channels; picks the p-bit that
+	// lands closer to the unquantized color.
+	static void QuantizeBc7Endpoint(const float* color, uint8_t* out_endpoint, uint8_t* out_pBit)
+	{
+		float bestError = 0.0f;
+		for (int pBit = 0; pBit < 2; pBit++)
+		{
+			uint8_t endpoint[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++)
+			{
+				int value = std::min(static_cast<int>((color[c] - pBit) * 0.5f + 0.5f), 127);
+				endpoint[c] = static_cast<uint8_t>(value);
+				float d = static_cast<float>((value << 1) | pBit) - color[c];
+				error += d * d;
+			}
+			if (pBit == 0 || error < bestError)
+			{
+				bestError = error;
+				memcpy(out_endpoint, endpoint, 4);
+				*out_pBit = static_cast<uint8_t>(pBit);
+			}
+		}
+	}
+
+	static void EvaluateBc7(const unsigned char* pixels, Bc7Block& block)
+	{
+		unsigned char colors[2][4];
+		for (int e = 0; e < 2; e++)
+			for (int c = 0; c < 4; c++)
+				colors[e][c] = static_cast<unsigned char>((block.Endpoints[e][c] << 1) | block.PBits[e]);
+
+		alignas(16) unsigned char palette[64];
+		for (int k = 0; k < 16; k++)
+		{
+			for (int c = 0; c < 4; c++)
+				palette[k * 4 + c] = static_cast<unsigned char>(
+					((64 - BC7_WEIGHTS[k]) * colors[0][c] + BC7_WEIGHTS[k] * colors[1][c] + 32) >> 6);
+		}
+		block.Error = SelectNearest(pixels, palette, 16, block.Indices);
+	}
+
+	static void TryBc7(const unsigned char* pixels, const float* endpoint0, const float* endpoint1, Bc7Block& best)
+	{
+		Bc7Block candidate;
+		QuantizeBc7Endpoint(endpoint0, candidate.Endpoints[0], &candidate.PBits[0]);
+		QuantizeBc7Endpoint(endpoint1, candidate.Endpoints[1], &candidate.PBits[1]);
+		EvaluateBc7(pixels, candidate);
+		if (candidate.Error < best.Error)
+			best = candidate;
+	}
+
+	// Nudges each 7-bit component and flips each p-bit while that lowers the error.
+	static void SearchBc7Neighbours(const unsigned char* pixels, Bc7Block& best)
+	{
+		bool improved = true;
+		for (int sweep = 0; sweep < 2 && improved && best.Error > 0; sweep++)
+		{
+			improved = false;
+			for (int endpoint = 0; endpoint < 2; endpoint++)
+			{
+				for (int channel = 0; channel <= 4; channel++)
+				{
+					for (int delta = -1; delta <= 1; delta += 2)
+					{
+						// Channel 4 stands for the p-bit, which only has one other value to try.
+						if (channel == 4 && delta > 0)
+							continue;
+						Bc7Block candidate = best;
+						if (channel == 4)
+						{
+							candidate.PBits[endpoint] ^= 1;
+						}
+						else
+						{
+							int value = candidate.Endpoints[endpoint][channel] + delta;
+							if (value < 0 || value > 127)
+								continue;
+							candidate.Endpoints[endpoint][channel] = static_cast<uint8_t>(value);
+						}
+						EvaluateBc7(pixels, candidate);
+						if (candidate.Error < best.Error)
+						{
+							best = candidate;
+							improved = true;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Mode 6: 7 mode bits, R0 R1 G0 G1 B0 B1 A0 A1 at 7 bits, two p-bits, then the indices at 4 bits except
+	// for the first, whose top bit is implied to be 0. Packed least significant bit first.
+	static void WriteBc7Mode6(Bc7Block block, unsigned char* out)
+	{
+		if (block.Indices[0] >= 8)
+		{
+			std::swap(block.Endpoints[0], block.Endpoints[1]);
+			std::swap(block.PBits[0], block.PBits[1]);
+			for (uint8_t& index : block.Indices)
+				index = static_cast<uint8_t>(15 - index);
+		}
+
+		uint64_t bits[2] = {};
+		int position = 0;
+		auto put = [&](uint32_t value, int count)
+		{
+			for (int i = 0; i < count; i++, position++)
+				bits[position >> 6] |= static_cast<uint64_t>((value >> i) & 1) << (position & 63);
+		};
+		put(BC7_MODE6, 7);
+		for (int c = 0; c < 4; c++)
+		{
+			put(block.Endpoints[0][c], 7);
+			put(block.Endpoints[1][c], 7);
+		}
+		put(block.PBits[0], 1);
+		put(block.PBits[1], 1);
+		put(block.Indices[0], 3);
+		for (int i = 1; i < 16; i++)
+			put(block.Indices[i], 4);
+
+		for (int i = 0; i < 16; i++)
+			out[i] = static_cast<unsigned char>(bits[i >> 3] >> ((i & 7) * 8));
+	}
+
+	void CompressBlockBc7(const unsigned char* block, int quality, unsigned char* out)
+	{
+		alignas(16) unsigned char pixels[64];
+		memcpy(pixels, block, sizeof(pixels));
+
+		float endpoint0[4];
+		float endpoint1[4];
+		FindEndpoints<4>(pixels, endpoint0, endpoint1);
+		Bc7Block best;
+		TryBc7(pixels, endpoint0, endpoint1, best);
+
+		float weights[16];
+		for (int k = 0; k < 16; k++)
+			weights[k] = BC7_WEIGHTS[k] / 64.0f;
+		for (int pass = 0; pass < GetRefinementPasses(quality) && best.Error > 0; pass++)
+		{
+			uint32_t before = best.Error;
+			if (!FitEndpoints<4>(pixels, best.Indices, weights, endpoint0, endpoint1))
+				break;
+			TryBc7(pixels, endpoint0, endpoint1, best);
+			if (best.Error >= before)
+				break;
+		}
+		if (quality >= 2)
+			SearchBc7Neighbours(pixels, best);
+
+		WriteBc7Mode6(best, out);
+	}
+
+	bool CanCompress(const DecodedImage& image)
+	{
+		return image.Pixels != nullptr && image.Format == TextureFormat::Rgba8 && image.Width % 4 == 0 &&
+			image.Height % 4 == 0 && image.Width <= APP_MAX_TEXTURE_DIMENSION &&
+			image.Height <= APP_MAX_TEXTURE_DIMENSION &&
+			static_cast<int64_t>(image.Width) * image.Height >= APP_BLOCK_COMPRESSION_MIN_PIXELS;
+	}
+
+	bool IsOpaque(const unsigned char* pixels, int width, int height, size_t rowPitch)
+	{
+		for (int y = 0; y < height; y++)
+		{
+			const unsigned char* row = pixels + y * rowPitch;
+			// AND of every alpha in the row; written so that it vectorizes.
+			unsigned char alpha = 0xFF;
+			for (int x = 0; x < width; x++)
+				alpha &= row[x * 4 + 3];
+			if (alpha != 0xFF)
+				return false;
+		}
+		return true;
+	}
+
+	bool CompressImage(DecodedImage& image, int quality, ThreadPool* pool)
+	{
+		if (!CanCompress(image))
+			return false;
+
+		TextureFormat format = IsOpaque(image.Pixels, image.Width, image.Height, image.GetRowPitch())
+			? TextureFormat::Bc1
+			: TextureFormat::Bc7;
+
+		struct Level
+		{
+			const unsigned char* Src = nullptr;
+			unsigned char* Dst = nullptr;
+			int Width = 0;
+			int Height = 0;
+		};
+		struct Task
+		{
+			int Level = 0;
+			int FirstBlockRow = 0;
+		};
+
+		std::vector<Level> levels(image.MipLevels);
+		size_t mipDataSize = 0;
+		int width = image.Width;
+		int height = image.Height;
+		for (int i = 0; i < image.MipLevels; i++)
+		{
+			levels[i].Width = width;
+			levels[i].Height = height;
+			if (i > 0)
+				mipDataSize += TextureFormats::GetLevelSize(format, width, height);
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+		}
+
+		unsigned char* blocks = ImageDecoder::AllocatePixels(TextureFormats::GetLevelSize(format, image.Width,
+		                                                                                  image.Height));
+		if (blocks == nullptr)
+			return false;
+		std::vector<unsigned char> mipData(mipDataSize);
+
+		std::vector<Task> tasks;
+		const unsigned char* src = image.Pixels;
+		unsigned char* dst = blocks;
+		for (int i = 0; i < image.MipLevels; i++)
+		{
+			Level& level = levels[i];
+			level.Src = src;
+			level.Dst = dst;
+			int numBlockRows = TextureFormats::GetNumRows(format, level.Height);
+			for (int row = 0; row < numBlockRows; row += BLOCK_ROWS_PER_TASK)
+				tasks.push_back({i, row});
+
+			src = i == 0 ? image.MipData.data() : src + static_cast<size_t>(level.Width) * level.Height * 4;
+			dst = i == 0 ? mipData.data() : dst + TextureFormats::GetLevelSize(format, level.Width, level.Height);
+		}
+
+		auto compressRows = [&](int taskIndex)
+		{
+			const Task& task = tasks[taskIndex];
+			const Level& level = levels[task.Level];
+			size_t srcRowPitch = static_cast<size_t>(level.Width) * 4;
+			size_t dstRowPitch = TextureFormats::GetRowPitch(format, level.Width);
+			int blockSize = TextureFormats::GetElementSize(format);
+			int numBlocksWide = (level.Width + 3) / 4;
+			int lastBlockRow = std::min(task.FirstBlockRow + BLOCK_ROWS_PER_TASK,
+			                            TextureFormats::GetNumRows(format, level.Height));
+
+			alignas(16) unsigned char block[64];
+			for (int blockY = task.FirstBlockRow; blockY < lastBlockRow; blockY++)
+			{
+				unsigned char* out = level.Dst + blockY * dstRowPitch;
+				for (int blockX = 0; blockX < numBlocksWide; blockX++, out += blockSize)
+				{
+					LoadBlock(level.Src, level.Width, level.Height, srcRowPitch, blockX, blockY, block);
+					if (format == TextureFormat::Bc1)
+						CompressBlockBc1(block, quality, out);
+					else
+						CompressBlockBc7(block, quality, out);
+				}
+			}
+		};
+		if (pool)
+			pool->ParallelFor(static_cast<int>(tasks.size()), compressRows);
+		else
+			for (int i = 0; i < static_cast<int>(tasks.size()); i++)
+				compressRows(i);
+
+		int mipLevels = image.MipLevels;
+		int sourceWidth = image.SourceWidth;
+		int sourceHeight = image.SourceHeight;
+		uint64_t contentHash = image.ContentHash;
+		image.Release();
+		image.Pixels = blocks;
+		image.Format = format;
+		image.Width = levels[0].Width;
+		image.Height = levels[0].Height;
+		image.SourceWidth = sourceWidth;
+		image.SourceHeight = sourceHeight;
+		image.MipLevels = mipLevels;
+		image.ContentHash = contentHash;
+		image.MipData = std::move(mipData);
+		return true;
+	}
+}
@@ -0,0 +1,458 @@
+#include "image/DiskTextureCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	constexpr char CACHE_FILE_MAGIC[4] = {'I', 'I', 'T', 'C'};
+	constexpr uint32_t CACHE_FILE_VERSION = 3;
+	constexpr const char* CACHE_FILE_EXTENSION = ".tex";
+	constexpr const char* CACHE_TEMP_EXTENSION = ".tmp";
+
+	// Written and read by the same build on little-endian machines, so it is copied as it is.
+	struct CacheFileHeader
+	{
+		char Magic[4];
+		uint32_t Version;
+		uint64_t KeyHash;
+		uint64_t FileSize;
+		int64_t FileTime;
+		uint64_t ContentHash; // see DecodedImage::ContentHash
+		int32_t MaxDimension;
+		int32_t CompressionQuality; // -1 when compression is off
+		uint32_t Format;
+		int32_t Width;
+		int32_t Height;
+		int32_t SourceWidth;
+		int32_t SourceHeight;
+		int32_t MipLevels;
+		uint32_t PathLength; // the path follows the header, then MipLevels DiskCacheLevel records
+		uint32_t Reserved;
+	};
+	static_assert(sizeof(CacheFileHeader) == 80);
+	static_assert(sizeof(DiskCacheLevel) == 24);
+
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	int64_t GetFileTimeNow()
+	{
+		return static_cast<int64_t>(std::filesystem::file_time_type::clock::now().time_since_epoch().count());
+	}
+
+	void HashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		// FNV-1a; keys are short, and collisions are caught by comparing the stored key.
+		const auto* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+	}
+
+	int GetCompressionQuality(const BlockCompressionOptions& compression)
+	{
+		return compression.Enabled ? compression.Quality : -1;
+	}
+
+	bool IsKnownFormat(uint32_t format)
+	{
+		switch (static_cast<TextureFormat>(format))
+		{
+		case TextureFormat::Rgba8:
+		case TextureFormat::Bc1:
+		case TextureFormat::Bc3:
+		case TextureFormat::Bc5:
+		case TextureFormat::Bc7:
+			return true;
+		}
+		return false;
+	}
+
+	// Fills levels with the upload layout of a format/size/mip count, starting at payloadOffset. Returns the
+	// size of the whole file.
+	uint64_t ComputeLayout(TextureFormat format, int width, int height, int mipLevels, uint64_t payloadOffset,
+	                       DiskCacheLevel* levels)
+	{
+		uint64_t offset = payloadOffset;
+		for (int level = 0; level < mipLevels; level++)
+		{
+			offset = AlignUp(offset, APP_DISK_CACHE_LEVEL_ALIGNMENT);
+			levels[level].Offset = offset;
+			levels[level].RowSize = TextureFormats::GetRowPitch(format, width);
+			levels[level].RowPitch = static_cast<uint32_t>(AlignUp(levels[level].RowSize,
+			                                                       APP_DISK_CACHE_ROW_PITCH_ALIGNMENT));
+			levels[level].NumRows = static_cast<uint32_t>(TextureFormats::GetNumRows(format, height));
+			offset += static_cast<uint64_t>(levels[level].RowPitch) * levels[level].NumRows;
+
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+		}
+		return offset;
+	}
+
+	bool ParseCacheFileName(const std::filesystem::path& path, uint64_t* out_hash)
+	{
+		std::string stem = path.stem().string();
+		if (stem.size() != 16)
+			return false;
+		uint64_t hash = 0;
+		for (char c : stem)
+		{
+			int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+			if (digit < 0)
+				return false;
+			hash = hash << 4 | static_cast<uint64_t>(digit);
+		}
+		*out_hash = hash;
+		return true;
+	}
+}
+
+bool DiskTextureCache::Open(const std::string& directory, uint64_t budgetBytes)
+{
+	Close();
+
+	std::error_code ec;
+	std::filesystem::create_directories(directory, ec);
+	if (!std::filesystem::is_directory(directory, ec))
+	{
+		std::cerr << "Failed to open texture cache directory: " << directory << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_directory = directory;
+	m_budgetBytes = budgetBytes;
+	m_stats = {};
+
+	for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec))
+	{
+		const std::filesystem::path& path = it->path();
+		if (path.extension() == CACHE_TEMP_EXTENSION)
+		{
+			// Left behind by a run that stopped while writing.
+			std::filesystem::remove(path, ec);
+			ec.clear();
+			continue;
+		}
+
+		uint64_t hash = 0;
+		if (path.extension() != CACHE_FILE_EXTENSION || !ParseCacheFileName(path, &hash))
+			continue;
+
+		std::error_code entryError;
+		IndexEntry entry;
+		entry.Size = it->file_size(entryError);
+		entry.LastUse = static_cast<int64_t>(it->last_write_time(entryError).time_since_epoch().count());
+		if (entryError)
+			continue;
+
+		m_index[hash] = entry;
+		m_stats.TotalBytes += entry.Size;
+	}
+
+	m_open = true;
+	TrimLocked(0);
+	return true;
+}
+
+void DiskTextureCache::Close()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_open = false;
+	m_index.clear();
+	m_directory.clear();
+}
+
+bool DiskTextureCache::IsOpen() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_open;
+}
+
+bool DiskTextureCache::MakeKey(const std::string& path, int maxDimension, const BlockCompressionOptions& compression,
+                               DiskCacheKey* out_key)
+{
+	std::error_code ec;
+	uint64_t fileSize = std::filesystem::file_size(path, ec);
+	if (ec)
+		return false;
+	auto fileTime = std::filesystem::last_write_time(path, ec);
+	if (ec)
+		return false;
+
+	DiskCacheKey& key = *out_key;
+	key.Path = path;
+	key.FileSize = fileSize;
+	key.FileTime = static_cast<int64_t>(fileTime.time_since_epoch().count());
+	key.MaxDimension = maxDimension;
+	key.Compression = compression.Enabled ? compression : BlockCompressionOptions();
+
+	int32_t quality = GetCompressionQuality(key.Compression);
+	uint64_t hash = 0xcbf29ce484222325ull;
+	HashBytes(hash, &CACHE_FILE_VERSION, sizeof(CACHE_FILE_VERSION));
+	HashBytes(hash, key.Path.data(), key.Path.size());
+	HashBytes(hash, &key.FileSize, sizeof(key.FileSize));
+	HashBytes(hash, &key.FileTime, sizeof(key.FileTime));
+	HashBytes(hash, &key.MaxDimension, sizeof(key.MaxDimension));
+	HashBytes(hash, &quality, sizeof(quality));
+	key.Hash = hash;
+	return true;
+}
+
+bool DiskTextureCache::Load(const DiskCacheKey& key, DecodedImage& out_image)
+{
+	std::string filePath;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_open)
+			return false;
+		if (m_index.find(key.Hash) == m_index.end())
+		{
+			m_stats.Misses++;
+			return false;
+		}
+		filePath = GetFilePath(key.Hash);
+	}
+
+	// Validated field by field: a file that does not match the key is a miss, and Store replaces it.
+	auto entry = std::make_shared<DiskCacheEntry>();
+	bool valid = entry->File.Open(filePath);
+	const unsigned char* data = entry->File.GetData();
+	size_t size = entry->File.GetSize();
+
+	CacheFileHeader header = {};
+	valid = valid && size >= sizeof(header);
+	if (valid)
+	{
+		std::memcpy(&header, data, sizeof(header));
+		valid = std::memcmp(header.Magic, CACHE_FILE_MAGIC, sizeof(header.Magic)) == 0 &&
+			header.Version == CACHE_FILE_VERSION && header.KeyHash == key.Hash && header.FileSize == key.FileSize &&
+			header.FileTime == key.FileTime && header.MaxDimension == key.MaxDimension &&
+			header.CompressionQuality == GetCompressionQuality(key.Compression) && IsKnownFormat(header.Format) &&
+			header.Width > 0 && header.Width <= APP_MAX_TEXTURE_DIMENSION && header.Height > 0 &&
+			header.Height <= APP_MAX_TEXTURE_DIMENSION && header.MipLevels >= 1 &&
+			header.MipLevels <= APP_MAX_TEXTURE_MIP_LEVELS && header.PathLength == key.Path.size();
+	}
+
+	uint64_t levelTableOffset = sizeof(header) + static_cast<uint64_t>(header.PathLength);
+	uint64_t payloadOffset = levelTableOffset + sizeof(DiskCacheLevel) * static_cast<uint64_t>(header.MipLevels);
+	valid = valid && payloadOffset <= size &&
+		std::memcmp(data + sizeof(header), key.Path.data(), key.Path.size()) == 0;
+	if (valid)
+	{
+		// The stored table must be exactly the layout this build would have written.
+		DiskCacheLevel expected[APP_MAX_TEXTURE_MIP_LEVELS];
+		uint64_t fileSize = ComputeLayout(static_cast<TextureFormat>(header.Format), header.Width, header.Height,
+		                                  header.MipLevels, payloadOffset, expected);
+		std::memcpy(entry->Levels, data + levelTableOffset, sizeof(DiskCacheLevel) * header.MipLevels);
+		valid = fileSize <= size;
+		for (int level = 0; valid && level < header.MipLevels; level++)
+		{
+			const DiskCacheLevel& stored = entry->Levels[level];
+			valid = stored.Offset == expected[level].Offset && stored.RowPitch == expected[level].RowPitch &&
+				stored.NumRows == expected[level].NumRows && stored.RowSize == expected[level].RowSize;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!valid)
+	{
+		m_stats.Misses++;
+		return false;
+	}
+
+	m_stats.Hits++;
+	TouchLocked(key.Hash);
+
+	out_image.Release();
+	out_image.Format = static_cast<TextureFormat>(header.Format);
+	out_image.Width = header.Width;
+	out_image.Height = header.Height;
+	out_image.SourceWidth = header.SourceWidth;
+	out_image.SourceHeight = header.SourceHeight;
+	out_image.MipLevels = header.MipLevels;
+	out_image.ContentHash = header.ContentHash;
+	out_image.CacheEntry = std::move(entry);
+	return true;
+}
+
+bool DiskTextureCache::Store(const DiskCacheKey& key, const DecodedImage& image)
+{
+	// Load rejects anything past the texture size limit, so storing it would only evict entries for nothing.
+	if (image.Pixels == nullptr || image.MipLevels < 1 || image.MipLevels > APP_MAX_TEXTURE_MIP_LEVELS ||
+		image.Width > APP_MAX_TEXTURE_DIMENSION || image.Height > APP_MAX_TEXTURE_DIMENSION)
+		return false;
+
+	std::string filePath;
+	std::string tempPath;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_open)
+			return false;
+		filePath = GetFilePath(key.Hash);
+		// Unique per store, as two workers may write the same key.
+		tempPath = filePath + "." + std::to_string(m_stats.Stores) + CACHE_TEMP_EXTENSION;
+		m_stats.Stores++;
+	}
+
+	CacheFileHeader header = {};
+	std::memcpy(header.Magic, CACHE_FILE_MAGIC, sizeof(header.Magic));
+	header.Version = CACHE_FILE_VERSION;
+	header.KeyHash = key.Hash;
+	header.FileSize = key.FileSize;
+	header.FileTime = key.FileTime;
+	header.ContentHash = image.ContentHash;
+	header.MaxDimension = key.MaxDimension;
+	header.CompressionQuality = GetCompressionQuality(key.Compression);
+	header.Format = static_cast<uint32_t>(image.Format);
+	header.Width = image.Width;
+	header.Height = image.Height;
+	header.SourceWidth = image.SourceWidth;
+	header.SourceHeight = image.SourceHeight;
+	header.MipLevels = image.MipLevels;
+	header.PathLength = static_cast<uint32_t>(key.Path.size());
+
+	DiskCacheLevel levels[APP_MAX_TEXTURE_MIP_LEVELS];
+	uint64_t payloadOffset = sizeof(header) + key.Path.size() + sizeof(DiskCacheLevel) * image.MipLevels;
+	uint64_t fileSize = ComputeLayout(image.Format, image.Width, image.Height, image.MipLevels, payloadOffset,
+	                                  levels);
+
+	std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(key.Path.data(), static_cast<std::streamsize>(key.Path.size()));
+	file.write(reinterpret_cast<const char*>(levels), static_cast<std::streamsize>(sizeof(DiskCacheLevel) *
+	                                                                               image.MipLevels));
+
+	// One write per level, padded out to the upload pitch; the gap before the level is zeros too.
+	std::vector<unsigned char> levelBuffer;
+	uint64_t written = payloadOffset;
+	const unsigned char* levelPixels = image.Pixels;
+	for (int level = 0; level < image.MipLevels && file; level++)
+	{
+		const DiskCacheLevel& layout = levels[level];
+		size_t gap = static_cast<size_t>(layout.Offset - written);
+		levelBuffer.assign(gap + static_cast<size_t>(layout.RowPitch) * layout.NumRows, 0);
+		for (uint32_t row = 0; row < layout.NumRows; row++)
+			std::memcpy(levelBuffer.data() + gap + static_cast<size_t>(row) * layout.RowPitch,
+			            levelPixels + row * layout.RowSize, layout.RowSize);
+		file.write(reinterpret_cast<const char*>(levelBuffer.data()), static_cast<std::streamsize>(levelBuffer.size()));
+		written += levelBuffer.size();
+
+		// Level 0 is Pixels and the rest follow one another, tightly packed, in MipData.
+		levelPixels = level == 0 ? image.MipData.data() : levelPixels + layout.RowSize * layout.NumRows;
+	}
+	file.close();
+
+	std::error_code ec;
+	if (!file || written != fileSize)
+	{
+		std::cerr << "Failed to write texture cache file: " << tempPath << std::endl;
+		std::filesystem::remove(tempPath, ec);
+		return false;
+	}
+
+	// Fails on Windows while another worker still has the old file mapped; the old one stays in use then.
+	std::filesystem::rename(tempPath, filePath, ec);
+	if (ec)
+	{
+		std::filesystem::remove(tempPath, ec);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_open)
+		return true;
+
+	IndexEntry& entry = m_index[key.Hash];
+	m_stats.TotalBytes = m_stats.TotalBytes - entry.Size + fileSize;
+	entry.Size = fileSize;
+	// The time the write left on the file comes from the file system's coarse clock and can be older than the
+	// time a Load just set on another entry, which would turn the order around for the next Open.
+	TouchLocked(key.Hash);
+	TrimLocked(key.Hash);
+	return true;
+}
+
+void DiskTextureCache::SetBudget(uint64_t budgetBytes)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_budgetBytes = budgetBytes;
+	if (m_open)
+		TrimLocked(0);
+}
+
+uint64_t DiskTextureCache::GetBudget() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_budgetBytes;
+}
+
+DiskCacheStats DiskTextureCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	DiskCacheStats stats = m_stats;
+	stats.NumFiles = static_cast<uint32_t>(m_index.size());
+	return stats;
+}
+
+std::string DiskTextureCache::GetFilePath(uint64_t hash) const
+{
+	char name[17];
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+	return (std::filesystem::path(m_directory) / (std::string(name) + CACHE_FILE_EXTENSION)).string();
+}
+
+void DiskTextureCache::TouchLocked(uint64_t hash)
+{
+	auto it = m_index.find(hash);
+	if (it == m_index.end())
+		return;
+
+	// The modification time is the persistent part of the LRU order; failing to set it only makes the
+	// entry look older to the next run.
+	it->second.LastUse = GetFileTimeNow();
+	std::error_code ec;
+	std::filesystem::last_write_time(GetFilePath(hash), std::filesystem::file_time_type::clock::now(), ec);
+}
+
+void DiskTextureCache::TrimLocked(uint64_t keep)
+{
+	if (m_stats.TotalBytes <= m_budgetBytes)
+		return;
+
+	std::vector<std::pair<int64_t, uint64_t>> byAge;
+	byAge.reserve(m_index.size());
+	for (const auto& [hash, entry] : m_index)
+		if (hash != keep)
+			byAge.emplace_back(entry.LastUse, hash);
+	std::sort(byAge.begin(), byAge.end());
+
+	for (const auto& [lastUse, hash] : byAge)
+	{
+		if (m_stats.TotalBytes <= m_budgetBytes)
+			break;
+
+		// Windows refuses while the file is mapped by a texture still being uploaded. It is dropped from the
+		// index regardless and found again by the next Open.
+		std::error_code ec;
+		std::filesystem::remove(GetFilePath(hash), ec);
+
+		auto it = m_index.find(hash);
+		m_stats.TotalBytes -= it->second.Size;
+		m_stats.Evictions++;
+		m_index.erase(it);
+	}
+}
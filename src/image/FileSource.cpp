@@ -0,0 +1,180 @@
+#include "image/FileSource.h"
+
+#include <cstdint>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FileSource::~FileSource()
+{
+	Close();
+}
+
+bool FileSource::Open(const std::string& path)
+{
+	Close();
+	if (m_mappingEnabled && Map(path))
+		return true;
+	return Read(path);
+}
+
+void FileSource::Close()
+{
+	if (m_mapping)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_mapping);
+#else
+		munmap(m_mapping, m_size);
+#endif
+		m_mapping = nullptr;
+	}
+	m_buffer.clear();
+	m_data = nullptr;
+	m_size = 0;
+}
+
+#ifdef _WIN32
+bool FileSource::Map(const std::string& path)
+{
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+	                          FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0 ||
+		static_cast<unsigned long long>(fileSize.QuadPart) > SIZE_MAX)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr)
+		return false;
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping); // the view keeps the mapping alive
+	if (view == nullptr)
+		return false;
+
+	m_mapping = view;
+	m_data = static_cast<const unsigned char*>(view);
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+	// Start paging the whole file in now instead of one fault at a time as the decoder walks it.
+	WIN32_MEMORY_RANGE_ENTRY range = {view, m_size};
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+	return true;
+}
+#else
+bool FileSource::Map(const std::string& path)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st = {};
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+	{
+		close(fd);
+		return false;
+	}
+
+#ifdef POSIX_FADV_SEQUENTIAL
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	size_t size = static_cast<size_t>(st.st_size);
+	void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // the mapping keeps the file referenced
+	if (view == MAP_FAILED)
+		return false;
+
+	madvise(view, size, MADV_SEQUENTIAL);
+	madvise(view, size, MADV_WILLNEED);
+
+	m_mapping = view;
+	m_data = static_cast<const unsigned char*>(view);
+	m_size = size;
+	return true;
+}
+#endif
+
+#ifdef _WIN32
+bool FileSource::Read(const std::string& path)
+{
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+	                          FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize = {};
+	bool ok = GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0 && fileSize.QuadPart <= MAXDWORD;
+	if (ok)
+	{
+		// One read for the whole file; the buffer is reused by the next Open().
+		m_buffer.resize(static_cast<size_t>(fileSize.QuadPart));
+		DWORD bytesRead = 0;
+		ok = ReadFile(file, m_buffer.data(), static_cast<DWORD>(m_buffer.size()), &bytesRead, nullptr) &&
+			bytesRead == m_buffer.size();
+	}
+	CloseHandle(file);
+
+	if (!ok)
+	{
+		m_buffer.clear();
+		return false;
+	}
+
+	m_data = m_buffer.data();
+	m_size = m_buffer.size();
+	return true;
+}
+#else
+bool FileSource::Read(const std::string& path)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st = {};
+	bool ok = fstat(fd, &st) == 0 && st.st_size > 0;
+	if (ok)
+	{
+		// One read for the whole file; the buffer is reused by the next Open().
+		m_buffer.resize(static_cast<size_t>(st.st_size));
+		size_t total = 0;
+		while (ok && total < m_buffer.size())
+		{
+			ssize_t bytesRead = read(fd, m_buffer.data() + total, m_buffer.size() - total);
+			ok = bytesRead > 0;
+			if (ok)
+				total += static_cast<size_t>(bytesRead);
+		}
+	}
+	close(fd);
+
+	if (!ok)
+	{
+		m_buffer.clear();
+		return false;
+	}
+
+	m_data = m_buffer.data();
+	m_size = m_buffer.size();
+	return true;
+}
+#endif
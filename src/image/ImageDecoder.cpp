@@ -0,0 +1,438 @@
+#include "image/ImageDecoder.h"
+#include "image/JpegDecoder.h"
+#include "image/MipGenerator.h"
+#include "image/PixelConvert.h"
+#include "image/PngDecoder.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_NO_DDS
+#define STBI_NO_HDR
+#include "stb/stb_image.h"
+
+DecodedImage::~DecodedImage()
+{
+	Release();
+}
+
+void DecodedImage::Release()
+{
+	if (Pixels)
+	{
+		stbi_image_free(Pixels);
+		Pixels = nullptr;
+	}
+	Format = TextureFormat::Rgba8;
+	Width = 0;
+	Height = 0;
+	SourceWidth = 0;
+	SourceHeight = 0;
+	MipLevels = 1;
+	ContentHash = 0;
+	MipData.clear();
+	MipData.shrink_to_fit();
+	CacheEntry.reset();
+}
+
+DecodedImage::DecodedImage(DecodedImage&& other) noexcept
+	: Pixels(std::exchange(other.Pixels, nullptr)),
+	  Format(std::exchange(other.Format, TextureFormat::Rgba8)),
+	  Width(std::exchange(other.Width, 0)),
+	  Height(std::exchange(other.Height, 0)),
+	  SourceWidth(std::exchange(other.SourceWidth, 0)),
+	  SourceHeight(std::exchange(other.SourceHeight, 0)),
+	  MipLevels(std::exchange(other.MipLevels, 1)),
+	  ContentHash(std::exchange(other.ContentHash, 0)),
+	  MipData(std::move(other.MipData)),
+	  CacheEntry(std::move(other.CacheEntry))
+{
+}
+
+DecodedImage& DecodedImage::operator=(DecodedImage&& other) noexcept
+{
+	if (this != &other)
+	{
+		Release();
+		Pixels = std::exchange(other.Pixels, nullptr);
+		Format = std::exchange(other.Format, TextureFormat::Rgba8);
+		Width = std::exchange(other.Width, 0);
+		Height = std::exchange(other.Height, 0);
+		SourceWidth = std::exchange(other.SourceWidth, 0);
+		SourceHeight = std::exchange(other.SourceHeight, 0);
+		MipLevels = std::exchange(other.MipLevels, 1);
+		ContentHash = std::exchange(other.ContentHash, 0);
+		MipData = std::move(other.MipData);
+		CacheEntry = std::move(other.CacheEntry);
+	}
+	return *this;
+}
+
+namespace ImageDecoder
+{
+	static void ReduceToDisplaySize(DecodedImage& image, int maxDimension)
+	{
+		int width = image.Width;
+		int height = image.Height;
+		while (std::max(width, height) / 2 >= maxDimension)
+		{
+			int dstWidth = std::max(1, width / 2);
+			int dstHeight = std::max(1, height / 2);
+			MipGenerator::DownsampleBox(image.Pixels, width, height, static_cast<size_t>(width) * 4, image.Pixels,
+			                            static_cast<size_t>(dstWidth) * 4);
+			width = dstWidth;
+			height = dstHeight;
+		}
+
+		if (width == image.Width && height == image.Height)
+			return;
+
+		image.Width = width;
+		image.Height = height;
+
+		// Give the tail of the full-size buffer back; keeping the old block is fine if that fails.
+		void* shrunk = STBI_REALLOC(image.Pixels, image.GetSizeInBytes());
+		if (shrunk)
+			image.Pixels = static_cast<unsigned char*>(shrunk);
+	}
+
+	// PNGs go through PngDecoder, across the pool when they are large; anything it does not handle, or fails
+	// on, goes to stb_image as before. Returns an RGBA8 buffer from STBI_MALLOC, or nullptr.
+	static unsigned char* DecodePng(const unsigned char* data, size_t size, ThreadPool* pool, int* out_width,
+	                                int* out_height)
+	{
+		PngInfo info;
+		if (!PngDecoder::ReadInfo(data, size, &info) || !PngDecoder::IsSupported(info))
+			return nullptr;
+		if (static_cast<int64_t>(info.Width) * info.Height < APP_PARALLEL_PNG_MIN_PIXELS)
+			pool = nullptr;
+
+		size_t rowPitch = static_cast<size_t>(info.Width) * 4;
+		auto rgba = static_cast<unsigned char*>(STBI_MALLOC(rowPitch * info.Height));
+		if (rgba == nullptr)
+			return nullptr;
+		if (!PngDecoder::Decode(data, size, rgba, rowPitch, pool))
+		{
+			STBI_FREE(rgba);
+			return nullptr;
+		}
+
+		*out_width = info.Width;
+		*out_height = info.Height;
+		return rgba;
+	}
+
+	// Halvings ReduceToDisplaySize would apply to an image of this size.
+	static int GetDisplayReduction(int width, int height, int maxDimension)
+	{
+		int reduction = 0;
+		for (int size = std::max(width, height); maxDimension > 0 && size / 2 >= maxDimension; size /= 2)
+			reduction++;
+		return reduction;
+	}
+
+	// Supported JPEGs go through JpegDecoder; the rest, or what it fails on, goes to stb_image as before.
+	// With a maxDimension, JpegDecoder takes up to three of the halvings ReduceToDisplaySize would make, in
+	// the IDCT. Returns an RGBA8 buffer from STBI_MALLOC, or nullptr.
+	static unsigned char* DecodeJpeg(const unsigned char* data, size_t size, int maxDimension, int* out_width,
+	                                 int* out_height)
+	{
+		JpegInfo info;
+		if (!JpegDecoder::ReadInfo(data, size, &info) || !JpegDecoder::IsSupported(info))
+			return nullptr;
+
+		int scaleShift = std::min(GetDisplayReduction(info.Width, info.Height, maxDimension),
+		                          JpegDecoder::MAX_SCALE_SHIFT);
+		int width = JpegDecoder::GetScaledSize(info.Width, scaleShift);
+		int height = JpegDecoder::GetScaledSize(info.Height, scaleShift);
+		size_t rowPitch = static_cast<size_t>(width) * 4;
+		auto rgba = static_cast<unsigned char*>(STBI_MALLOC(rowPitch * height));
+		if (rgba == nullptr)
+			return nullptr;
+		if (!JpegDecoder::Decode(data, size, rgba, rowPitch, scaleShift))
+		{
+			STBI_FREE(rgba);
+			return nullptr;
+		}
+
+		*out_width = width;
+		*out_height = height;
+		return rgba;
+	}
+
+	// Copies the block data of a DDS or KTX2 file as it is. The display-size reduction starts at the first level
+	// that is small enough, as long as the file has it and it is still a whole number of blocks.
+	static bool DecodeContainer(const unsigned char* data, size_t size, DecodedImage& out_image, int maxDimension)
+	{
+		TextureContainerInfo info;
+		if (!TextureContainer::ReadInfo(data, size, &info))
+		{
+			stbi__err("unsupported container", "Unsupported or corrupt DDS/KTX2 file");
+			return false;
+		}
+
+		int firstLevel = 0;
+		while (maxDimension > 0 && firstLevel + 1 < info.MipLevels)
+		{
+			const TextureContainerLevel& level = info.Levels[firstLevel];
+			const TextureContainerLevel& next = info.Levels[firstLevel + 1];
+			if (std::max(level.Width, level.Height) / 2 < maxDimension || next.Width % 4 != 0 || next.Height % 4 != 0)
+				break;
+			firstLevel++;
+		}
+
+		const TextureContainerLevel& base = info.Levels[firstLevel];
+		auto pixels = static_cast<unsigned char*>(STBI_MALLOC(base.Size));
+		if (pixels == nullptr)
+		{
+			stbi__err("outofmem", "Out of memory");
+			return false;
+		}
+		memcpy(pixels, data + base.Offset, base.Size);
+
+		out_image.Release();
+		out_image.Pixels = pixels;
+		out_image.Format = info.Format;
+		out_image.Width = base.Width;
+		out_image.Height = base.Height;
+		out_image.SourceWidth = info.Width;
+		out_image.SourceHeight = info.Height;
+		out_image.MipLevels = info.MipLevels - firstLevel;
+
+		size_t mipDataSize = 0;
+		for (int level = firstLevel + 1; level < info.MipLevels; level++)
+			mipDataSize += info.Levels[level].Size;
+		out_image.MipData.resize(mipDataSize);
+		unsigned char* mipData = out_image.MipData.data();
+		for (int level = firstLevel + 1; level < info.MipLevels; level++)
+		{
+			memcpy(mipData, data + info.Levels[level].Offset, info.Levels[level].Size);
+			mipData += info.Levels[level].Size;
+		}
+		return true;
+	}
+
+	static bool DecodeBuffer(const unsigned char* data, size_t size, DecodedImage& out_image, int maxDimension,
+	                         ThreadPool* pool)
+	{
+		if (size > static_cast<size_t>(INT_MAX))
+		{
+			stbi__err("file too large", "Image file too large");
+			return false;
+		}
+		if (TextureContainer::IsContainer(data, size))
+			return DecodeContainer(data, size, out_image, maxDimension);
+
+		int image_width = 0;
+		int image_height = 0;
+		int components = 4;
+		unsigned char* image_data = DecodePng(data, size, pool, &image_width, &image_height);
+		if (image_data == nullptr)
+			image_data = DecodeJpeg(data, size, maxDimension, &image_width, &image_height);
+		if (image_data == nullptr)
+			image_data = stbi_load_from_memory(data, static_cast<int>(size), &image_width, &image_height,
+			                                   &components, 0);
+		if (image_data == nullptr)
+			return false;
+
+		// A JPEG may already be decoded at a fraction of its size.
+		int sourceWidth = image_width;
+		int sourceHeight = image_height;
+		JpegInfo jpegInfo;
+		if (JpegDecoder::ReadInfo(data, size, &jpegInfo))
+		{
+			sourceWidth = jpegInfo.Width;
+			sourceHeight = jpegInfo.Height;
+		}
+
+		// Expand to RGBA with the SIMD converters instead of stb's per-pixel loop.
+		if (components != 4)
+		{
+			size_t srcRowPitch = static_cast<size_t>(image_width) * components;
+			size_t dstRowPitch = static_cast<size_t>(image_width) * 4;
+			auto rgba = static_cast<unsigned char*>(STBI_MALLOC(dstRowPitch * image_height));
+			if (rgba == nullptr)
+			{
+				stbi_image_free(image_data);
+				stbi__err("outofmem", "Out of memory");
+				return false;
+			}
+
+			for (int y = 0; y < image_height; y++)
+				PixelConvert::ConvertRowToRgba(image_data + y * srcRowPitch, components, rgba + y * dstRowPitch,
+				                               image_width);
+			stbi_image_free(image_data);
+			image_data = rgba;
+		}
+
+		out_image.Release();
+		out_image.Pixels = image_data;
+		out_image.Width = image_width;
+		out_image.Height = image_height;
+		out_image.SourceWidth = sourceWidth;
+		out_image.SourceHeight = sourceHeight;
+
+		if (maxDimension > 0)
+			ReduceToDisplaySize(out_image, maxDimension);
+		return true;
+	}
+
+	bool DecodeFile(const std::string& filename, DecodedImage& out_image, int maxDimension,
+	                ImageDecodeContext* context)
+	{
+		ImageDecodeContext localContext;
+		FileSource& source = context ? context->Source : localContext.Source;
+		if (!source.Open(filename))
+		{
+			std::cerr << "Failed to open image: " << filename << std::endl;
+			return false;
+		}
+
+		bool decoded = DecodeBuffer(source.GetData(), source.GetSize(), out_image, maxDimension,
+		                            context ? context->Pool : nullptr);
+		source.Close();
+		if (!decoded)
+		{
+			std::cerr << "Failed to load image: " << filename << " (" << stbi_failure_reason() << ")" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	unsigned char* AllocatePixels(size_t size)
+	{
+		return static_cast<unsigned char*>(STBI_MALLOC(size));
+	}
+
+	bool ReadImageInfo(const unsigned char* data, size_t size, int* out_width, int* out_height)
+	{
+		int components = 0;
+		return size <= static_cast<size_t>(INT_MAX) &&
+			stbi_info_from_memory(data, static_cast<int>(size), out_width, out_height, &components) != 0;
+	}
+
+	bool DecodeMemoryInto(
+		const unsigned char* data,
+		size_t size,
+		unsigned char* dst,
+		size_t dstRowPitch,
+		int width,
+		int height,
+		std::vector<unsigned char>* out_mipData,
+		ThreadPool* pool)
+	{
+		if (size > static_cast<size_t>(INT_MAX))
+		{
+			std::cerr << "Failed to decode image: file too large" << std::endl;
+			return false;
+		}
+
+		// PngDecoder and JpegDecoder write RGBA8 rows at any pitch, so without a mip chain to build they decode
+		// straight into dst. A chain is built from the rows, which dst may not be read back for.
+		if (!out_mipData)
+		{
+			PngInfo pngInfo;
+			JpegInfo jpegInfo;
+			if (PngDecoder::ReadInfo(data, size, &pngInfo) && PngDecoder::IsSupported(pngInfo) &&
+				pngInfo.Width == width && pngInfo.Height == height)
+			{
+				ThreadPool* pngPool =
+					static_cast<int64_t>(width) * height < APP_PARALLEL_PNG_MIN_PIXELS ? nullptr : pool;
+				if (PngDecoder::Decode(data, size, dst, dstRowPitch, pngPool))
+					return true;
+			}
+			else if (JpegDecoder::ReadInfo(data, size, &jpegInfo) && JpegDecoder::IsSupported(jpegInfo) &&
+			         jpegInfo.Width == width && jpegInfo.Height == height)
+			{
+				if (JpegDecoder::Decode(data, size, dst, dstRowPitch))
+					return true;
+			}
+		}
+
+		// stb_image keeps its buffer at the file's channel count (PngDecoder and JpegDecoder return RGBA);
+		// expansion to RGBA happens per row below.
+		int image_width = 0;
+		int image_height = 0;
+		int components = 4;
+		unsigned char* image_data = DecodePng(data, size, pool, &image_width, &image_height);
+		if (image_data == nullptr)
+			image_data = DecodeJpeg(data, size, 0, &image_width, &image_height);
+		if (image_data == nullptr)
+			image_data = stbi_load_from_memory(data, static_cast<int>(size), &image_width, &image_height,
+			                                   &components, 0);
+		if (image_data == nullptr)
+		{
+			std::cerr << "Failed to decode image from memory (" << stbi_failure_reason() << ")" << std::endl;
+			return false;
+		}
+		if (image_width != width || image_height != height)
+		{
+			std::cerr << "Decoded image is " << image_width << "x" << image_height << ", expected " << width << "x"
+				<< height << std::endl;
+			stbi_image_free(image_data);
+			return false;
+		}
+
+		size_t srcRowPitch = static_cast<size_t>(width) * components;
+		size_t rgbaRowPitch = static_cast<size_t>(width) * 4;
+		bool buildMips = out_mipData && (width > 1 || height > 1);
+
+		// Level 1 comes from row pairs while they are still in cache, so dst is only ever written to; it may be
+		// write-combined upload memory.
+		std::vector<unsigned char> rowPair;
+		if (buildMips)
+		{
+			out_mipData->resize(MipGenerator::GetMipChainSize(width, height));
+			rowPair.resize(rgbaRowPitch * 2);
+		}
+		int level1Width = std::max(1, width / 2);
+		int level1Height = std::max(1, height / 2);
+
+		for (int y = 0; y < height; y++)
+		{
+			const unsigned char* srcRow = image_data + y * srcRowPitch;
+			unsigned char* dstRow = dst + y * dstRowPitch;
+			if (!buildMips)
+			{
+				PixelConvert::ConvertRowToRgba(srcRow, components, dstRow, width);
+				continue;
+			}
+
+			unsigned char* rgbaRow = rowPair.data() + (y & 1) * rgbaRowPitch;
+			PixelConvert::ConvertRowToRgba(srcRow, components, rgbaRow, width);
+			memcpy(dstRow, rgbaRow, rgbaRowPitch);
+
+			bool lastRow = y == height - 1;
+			if (((y & 1) == 1 || (height == 1 && lastRow)) && y / 2 < level1Height)
+			{
+				MipGenerator::DownsampleBox(rowPair.data(), width, height == 1 ? 1 : 2, rgbaRowPitch,
+				                            out_mipData->data() + static_cast<size_t>(y / 2) * level1Width * 4,
+				                            static_cast<size_t>(level1Width) * 4);
+			}
+		}
+		stbi_image_free(image_data);
+
+		if (buildMips)
+		{
+			size_t level1Size = static_cast<size_t>(level1Width) * level1Height * 4;
+			MipGenerator::FillMipChain(out_mipData->data(), level1Width, level1Height,
+			                           static_cast<size_t>(level1Width) * 4, out_mipData->data() + level1Size);
+		}
+		return true;
+	}
+
+	bool DecodeMemory(const unsigned char* data, size_t size, DecodedImage& out_image, int maxDimension,
+	                  ThreadPool* pool)
+	{
+		if (!DecodeBuffer(data, size, out_image, maxDimension, pool))
+		{
+			std::cerr << "Failed to decode image from memory (" << stbi_failure_reason() << ")" << std::endl;
+			return false;
+		}
+		return true;
+	}
+}
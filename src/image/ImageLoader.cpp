@@ -1,10 +1,8 @@
 #include "Stdafx.hpp"
 #include "image/ImageLoader.h"
-
-#define STB_IMAGE_IMPLEMENTATION
-#define STBI_NO_DDS
-#define STBI_NO_HDR
-#include "stb/stb_image.h"
+#include "image/DiskTextureCache.h"
+#include "image/MipGenerator.h"
+#include "image/TextureAtlas.h"
 
 ImGuiDx12Texture::~ImGuiDx12Texture()
 {
@@ -16,27 +14,64 @@ void ImGuiDx12Texture::Release(ExampleDescriptorHeapAllocator* srvAllocator)
 	{
 		TextureResource.Reset();
 	}
-	if (SrvCpuDescriptorHandle.ptr != 0 && srvAllocator)
+	if (Heap)
+	{
+		Heap->Free(HeapAllocation);
+		Heap = nullptr;
+	}
+	if (Atlas)
 	{
-		srvAllocator->Free(SrvCpuDescriptorHandle, SrvGpuDescriptorHandle);
+		Atlas->Remove(AtlasEntry);
+		Atlas = nullptr;
+		AtlasEntry = {};
+	}
+	if (!SrvDescriptor.IsNull() && srvAllocator)
+	{
+		srvAllocator->Free(SrvDescriptor);
 		SrvCpuDescriptorHandle = {};
 		SrvGpuDescriptorHandle = {};
+		SrvDescriptor = {};
 	}
+	Format = DXGI_FORMAT_UNKNOWN;
 	Width = 0;
 	Height = 0;
+	SourceWidth = 0;
+	SourceHeight = 0;
+	UploadFenceValue = 0;
+	SizeInBytes = 0;
 }
 
 ImGuiDx12Texture::ImGuiDx12Texture(ImGuiDx12Texture&& other) noexcept
 	: TextureResource(std::move(other.TextureResource)),
 	  SrvCpuDescriptorHandle(other.SrvCpuDescriptorHandle),
 	  SrvGpuDescriptorHandle(other.SrvGpuDescriptorHandle),
+	  SrvDescriptor(other.SrvDescriptor),
+	  Format(other.Format),
 	  Width(other.Width),
-	  Height(other.Height)
+	  Height(other.Height),
+	  SourceWidth(other.SourceWidth),
+	  SourceHeight(other.SourceHeight),
+	  UploadFenceValue(other.UploadFenceValue),
+	  SizeInBytes(other.SizeInBytes),
+	  Heap(other.Heap),
+	  HeapAllocation(other.HeapAllocation),
+	  Atlas(other.Atlas),
+	  AtlasEntry(other.AtlasEntry)
 {
 	other.SrvCpuDescriptorHandle = {};
 	other.SrvGpuDescriptorHandle = {};
+	other.SrvDescriptor = {};
+	other.Format = DXGI_FORMAT_UNKNOWN;
 	other.Width = 0;
 	other.Height = 0;
+	other.SourceWidth = 0;
+	other.SourceHeight = 0;
+	other.UploadFenceValue = 0;
+	other.SizeInBytes = 0;
+	other.Heap = nullptr;
+	other.HeapAllocation = {};
+	other.Atlas = nullptr;
+	other.AtlasEntry = {};
 }
 
 ImGuiDx12Texture& ImGuiDx12Texture::operator=(ImGuiDx12Texture&& other) noexcept
@@ -46,13 +81,33 @@ ImGuiDx12Texture& ImGuiDx12Texture::operator=(ImGuiDx12Texture&& other) noexcept
 		TextureResource = std::move(other.TextureResource);
 		SrvCpuDescriptorHandle = other.SrvCpuDescriptorHandle;
 		SrvGpuDescriptorHandle = other.SrvGpuDescriptorHandle;
+		SrvDescriptor = other.SrvDescriptor;
+		Format = other.Format;
 		Width = other.Width;
 		Height = other.Height;
+		SourceWidth = other.SourceWidth;
+		SourceHeight = other.SourceHeight;
+		UploadFenceValue = other.UploadFenceValue;
+		SizeInBytes = other.SizeInBytes;
+		Heap = other.Heap;
+		HeapAllocation = other.HeapAllocation;
+		Atlas = other.Atlas;
+		AtlasEntry = other.AtlasEntry;
 
 		other.SrvCpuDescriptorHandle = {};
 		other.SrvGpuDescriptorHandle = {};
+		other.SrvDescriptor = {};
+		other.Format = DXGI_FORMAT_UNKNOWN;
 		other.Width = 0;
 		other.Height = 0;
+		other.SourceWidth = 0;
+		other.SourceHeight = 0;
+		other.UploadFenceValue = 0;
+		other.SizeInBytes = 0;
+		other.Heap = nullptr;
+		other.HeapAllocation = {};
+		other.Atlas = nullptr;
+		other.AtlasEntry = {};
 	}
 	return *this;
 }
@@ -60,65 +115,85 @@ ImGuiDx12Texture& ImGuiDx12Texture::operator=(ImGuiDx12Texture&& other) noexcept
 
 namespace ImageLoader
 {
-	bool LoadTextureFromFile(
-		const std::string& filename,
+	static bool CreateTextureResource(
+		TextureFormat format,
+		int width,
+		int height,
+		int mipLevels,
 		ID3D12Device* device,
-		ID3D12CommandQueue* commandQueue,
+		Dx12TextureHeap* textureHeap,
 		ExampleDescriptorHeapAllocator* srvAllocator,
 		ImGuiDx12Texture& out_texture)
 	{
-		int image_width = 0;
-		int image_height = 0;
-		int components = 0; // RGBA
-		unsigned char* image_data = stbi_load(filename.c_str(), &image_width, &image_height, &components,
-		                                      STBI_rgb_alpha);
-		if (image_data == nullptr)
+		if (width > APP_MAX_TEXTURE_DIMENSION || height > APP_MAX_TEXTURE_DIMENSION)
 		{
-			std::cerr << "Failed to load image: " << filename << std::endl;
+			// CreateCommittedResource would fail anyway; such images are shown through a TiledImage.
+			std::cerr << "Image of " << width << "x" << height << " exceeds the " << APP_MAX_TEXTURE_DIMENSION
+				<< " texture size limit." << std::endl;
 			return false;
 		}
 
-		out_texture.Width = image_width;
-		out_texture.Height = image_height;
-
-		D3D12_HEAP_PROPERTIES heapProps = {};
-		heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+		// TextureFormat values are DXGI_FORMAT numbers.
+		out_texture.Format = static_cast<DXGI_FORMAT>(format);
+		out_texture.Width = width;
+		out_texture.Height = height;
 
 		D3D12_RESOURCE_DESC resDesc = {};
 		resDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
 		resDesc.Alignment = 0;
-		resDesc.Width = image_width;
-		resDesc.Height = image_height;
+		resDesc.Width = width;
+		resDesc.Height = height;
 		resDesc.DepthOrArraySize = 1;
-		resDesc.MipLevels = 1;
-		resDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		resDesc.MipLevels = static_cast<UINT16>(mipLevels);
+		resDesc.Format = out_texture.Format;
 		resDesc.SampleDesc.Count = 1;
 		resDesc.SampleDesc.Quality = 0;
 		resDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
 		resDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-		HRESULT hr = device->CreateCommittedResource(
-			&heapProps,
-			D3D12_HEAP_FLAG_NONE,
-			&resDesc,
-			D3D12_RESOURCE_STATE_COPY_DEST,
-			nullptr,
-			IID_PPV_ARGS(&out_texture.TextureResource));
+		// A placed texture may reuse memory of a released one. Every subresource is written by the upload
+		// before anything samples it, which is all D3D12 asks of non-render-target textures in that case.
+		HRESULT hr;
+		if (textureHeap)
+		{
+			hr = textureHeap->CreateTexture(resDesc, D3D12_RESOURCE_STATE_COPY_DEST, out_texture.TextureResource,
+			                                &out_texture.HeapAllocation);
+			if (SUCCEEDED(hr))
+			{
+				out_texture.Heap = textureHeap;
+				out_texture.SizeInBytes = out_texture.HeapAllocation.SizeInBytes;
+			}
+		}
+		else
+		{
+			D3D12_HEAP_PROPERTIES heapProps = {};
+			heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+			hr = device->CreateCommittedResource(
+				&heapProps,
+				D3D12_HEAP_FLAG_NONE,
+				&resDesc,
+				D3D12_RESOURCE_STATE_COPY_DEST,
+				nullptr,
+				IID_PPV_ARGS(&out_texture.TextureResource));
+			if (SUCCEEDED(hr))
+				out_texture.SizeInBytes = device->GetResourceAllocationInfo(0, 1, &resDesc).SizeInBytes;
+		}
 
 		if (FAILED(hr))
 		{
 			std::cerr << "Failed to create D3D12 texture resource. HRESULT: " << std::hex << hr << std::endl;
-			stbi_image_free(image_data);
 			return false;
 		}
 
 		if (!srvAllocator)
 		{
 			std::cerr << "Error: SRV descriptor allocator is null." << std::endl;
-			stbi_image_free(image_data);
 			return false;
 		}
-		srvAllocator->Alloc(&out_texture.SrvCpuDescriptorHandle, &out_texture.SrvGpuDescriptorHandle);
+		if (!srvAllocator->Alloc(&out_texture.SrvCpuDescriptorHandle, &out_texture.SrvGpuDescriptorHandle,
+		                         &out_texture.SrvDescriptor))
+			return false;
 
 		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
@@ -127,79 +202,281 @@ namespace ImageLoader
 		srvDesc.Texture2D.MipLevels = resDesc.MipLevels;
 		device->CreateShaderResourceView(out_texture.TextureResource.Get(), &srvDesc,
 		                                 out_texture.SrvCpuDescriptorHandle);
+		return true;
+	}
+
+	// Records the copy into the upload currently open on uploadQueue; the transition back to COMMON is
+	// queued and flushed together with the rest of the batch by EndUpload().
+	static bool RecordTextureUpload(
+		const DecodedImage& image,
+		Dx12UploadQueue* uploadQueue,
+		ID3D12GraphicsCommandList* commandList,
+		ImGuiDx12Texture& texture)
+	{
+		UINT numSubresources = static_cast<UINT>(image.MipLevels);
+		UINT64 uploadBufferSize = Dx12Utils::GetRequiredIntermediateSize(texture.TextureResource.Get(), 0,
+		                                                                 numSubresources);
 
-		UINT64 uploadBufferSize = Dx12Utils::GetRequiredIntermediateSize(out_texture.TextureResource.Get(), 0, 1);
-
-
-		Microsoft::WRL::ComPtr<ID3D12Resource> uploadBuffer;
-		D3D12_HEAP_PROPERTIES uploadHeapProps = {};
-		uploadHeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
-
-		D3D12_RESOURCE_DESC uploadResDesc = {};
-		uploadResDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-		uploadResDesc.Width = uploadBufferSize;
-		uploadResDesc.Height = 1;
-		uploadResDesc.DepthOrArraySize = 1;
-		uploadResDesc.MipLevels = 1;
-		uploadResDesc.Format = DXGI_FORMAT_UNKNOWN;
-		uploadResDesc.SampleDesc.Count = 1;
-		uploadResDesc.SampleDesc.Quality = 0;
-		uploadResDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-		uploadResDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
-		hr = device->CreateCommittedResource(
-			&uploadHeapProps,
-			D3D12_HEAP_FLAG_NONE,
-			&uploadResDesc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&uploadBuffer));
+		Dx12UploadAllocation staging;
+		if (!uploadQueue->AllocateStaging(uploadBufferSize, &staging))
+			return false;
 
-		if (FAILED(hr))
+		std::vector<D3D12_SUBRESOURCE_DATA> subresourceData(numSubresources);
+		const unsigned char* levelPixels = image.Pixels;
+		int levelWidth = image.Width;
+		int levelHeight = image.Height;
+		for (UINT level = 0; level < numSubresources; level++)
+		{
+			if (image.CacheEntry)
+			{
+				// Cached levels are already at the footprint's pitch, so UpdateSubresources copies each one whole.
+				const DiskCacheLevel& cached = image.CacheEntry->Levels[level];
+				subresourceData[level].pData = image.CacheEntry->GetLevelData(static_cast<int>(level));
+				subresourceData[level].RowPitch = static_cast<LONG_PTR>(cached.RowPitch);
+				subresourceData[level].SlicePitch = static_cast<LONG_PTR>(cached.RowPitch) * cached.NumRows;
+				continue;
+			}
+
+			// Block-compressed levels are rows of 4x4 blocks, which is also how the copy footprints count them.
+			auto rowPitch = static_cast<LONG_PTR>(TextureFormats::GetRowPitch(image.Format, levelWidth));
+			subresourceData[level].pData = levelPixels;
+			subresourceData[level].RowPitch = rowPitch;
+			subresourceData[level].SlicePitch = rowPitch * TextureFormats::GetNumRows(image.Format, levelHeight);
+
+			levelPixels = level == 0 ? image.MipData.data() : levelPixels + subresourceData[level].SlicePitch;
+			levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+			levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+		}
+
+		Dx12Utils::UpdateSubresources(commandList, texture.TextureResource.Get(), staging.Resource,
+		                              staging.MappedData, staging.Offset, 0, numSubresources,
+		                              subresourceData.data());
+
+		// Copy queues can only go back to COMMON; the first direct-queue read promotes it implicitly.
+		uploadQueue->QueueTransition(texture.TextureResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
+		                             D3D12_RESOURCE_STATE_COMMON);
+		return true;
+	}
+
+	bool LoadTextureFromFile(
+		const std::string& filename,
+		ID3D12Device* device,
+		Dx12TextureHeap* textureHeap,
+		Dx12UploadQueue* uploadQueue,
+		ExampleDescriptorHeapAllocator* srvAllocator,
+		ImGuiDx12Texture& out_texture,
+		const BlockCompressionOptions& compression,
+		ThreadPool* pool)
+	{
+		if (!uploadQueue)
+		{
+			std::cerr << "Error: upload queue is null." << std::endl;
+			return false;
+		}
+
+		FileSource source;
+		if (!source.Open(filename))
+		{
+			std::cerr << "Failed to load image: " << filename << std::endl;
+			return false;
+		}
+
+		// Compressed blocks need no decoding and images to be compressed need their whole mip chain first, so
+		// neither gains from writing into staging memory directly; they take the same path as images from
+		// AsyncImageLoader.
+		if (compression.Enabled || TextureContainer::IsContainer(source.GetData(), source.GetSize()))
+		{
+			DecodedImage image;
+			if (!ImageDecoder::DecodeMemory(source.GetData(), source.GetSize(), image, 0, pool))
+			{
+				std::cerr << "Failed to load image: " << filename << std::endl;
+				return false;
+			}
+			MipGenerator::GenerateMipChain(image);
+			if (compression.Enabled)
+				BlockCompressor::CompressImage(image, compression.Quality, pool);
+			if (!CreateTextureFromImage(image, device, textureHeap, uploadQueue, srvAllocator, out_texture))
+			{
+				std::cerr << "Failed to load image: " << filename << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+		int width = 0;
+		int height = 0;
+		if (!ImageDecoder::ReadImageInfo(source.GetData(), source.GetSize(), &width, &height))
+		{
+			std::cerr << "Failed to load image: " << filename << std::endl;
+			return false;
+		}
+
+		UINT mipLevels = static_cast<UINT>(MipGenerator::GetMipLevelCount(width, height));
+		if (!CreateTextureResource(TextureFormat::Rgba8, width, height, static_cast<int>(mipLevels), device,
+		                           textureHeap, srvAllocator, out_texture))
 		{
-			std::cerr << "Failed to create upload buffer. HRESULT: " << std::hex << hr << std::endl;
-			stbi_image_free(image_data);
 			out_texture.Release(srvAllocator);
 			return false;
 		}
+		out_texture.SourceWidth = width;
+		out_texture.SourceHeight = height;
 
-		D3D12_SUBRESOURCE_DATA subresourceData = {};
-		subresourceData.pData = image_data;
-		subresourceData.RowPitch = static_cast<LONG_PTR>(image_width) * 4; // 4 bytes por pixel (RGBA)
-		subresourceData.SlicePitch = subresourceData.RowPitch * image_height;
+		ID3D12GraphicsCommandList* commandList = uploadQueue->BeginUpload();
+		if (!commandList)
+		{
+			out_texture.Release(srvAllocator);
+			return false;
+		}
 
-		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocator;
-		device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator));
+		// The pixels are decoded straight into the staging memory at the copy footprint's row pitch, so
+		// there is no intermediate RGBA image to copy from.
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(mipLevels);
+		std::vector<UINT> numRows(mipLevels);
+		std::vector<UINT64> rowSizesInBytes(mipLevels);
+		UINT64 uploadBufferSize = Dx12Utils::GetCopyableFootprints(out_texture.TextureResource.Get(), 0, mipLevels,
+		                                                           0, layouts.data(), numRows.data(),
+		                                                           rowSizesInBytes.data());
 
-		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList;
-		device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator.Get(), nullptr,
-		                          IID_PPV_ARGS(&commandList));
+		Dx12UploadAllocation staging;
+		bool uploaded = uploadBufferSize != 0 && uploadQueue->AllocateStaging(uploadBufferSize, &staging);
+		if (uploaded)
+		{
+			BYTE* stagingData = static_cast<BYTE*>(staging.MappedData) + staging.Offset;
+			std::vector<unsigned char> mipData;
+			uploaded = ImageDecoder::DecodeMemoryInto(source.GetData(), source.GetSize(),
+			                                          stagingData + layouts[0].Offset,
+			                                          layouts[0].Footprint.RowPitch, width, height,
+			                                          mipLevels > 1 ? &mipData : nullptr);
+			if (uploaded)
+			{
+				const unsigned char* levelPixels = mipData.data();
+				for (UINT level = 1; level < mipLevels; level++)
+				{
+					for (UINT row = 0; row < numRows[level]; row++)
+					{
+						memcpy(stagingData + layouts[level].Offset + row * layouts[level].Footprint.RowPitch,
+						       levelPixels + row * rowSizesInBytes[level], rowSizesInBytes[level]);
+					}
+					levelPixels += rowSizesInBytes[level] * numRows[level];
+				}
 
-		Dx12Utils::UpdateSubresources(commandList.Get(), out_texture.TextureResource.Get(), uploadBuffer.Get(), 0, 0, 1,
-		                              &subresourceData);
+				for (D3D12_PLACED_SUBRESOURCE_FOOTPRINT& layout : layouts)
+					layout.Offset += staging.Offset;
+				Dx12Utils::CopySubresourcesFromIntermediate(commandList, out_texture.TextureResource.Get(),
+				                                            staging.Resource, 0, mipLevels, layouts.data());
+				uploadQueue->QueueTransition(out_texture.TextureResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
+				                             D3D12_RESOURCE_STATE_COMMON);
+			}
+		}
 
-		D3D12_RESOURCE_BARRIER barrier = {};
-		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-		barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-		barrier.Transition.pResource = out_texture.TextureResource.Get();
-		barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-		barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-		barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-		commandList->ResourceBarrier(1, &barrier);
-		commandList->Close();
+		// The upload is closed either way; a failed one just submits an empty list.
+		UINT64 fenceValue = uploadQueue->EndUpload();
+		if (!uploaded)
+		{
+			std::cerr << "Failed to load image: " << filename << std::endl;
+			out_texture.Release(srvAllocator);
+			return false;
+		}
 
-		ID3D12CommandList* ppCommandLists[] = {commandList.Get()};
-		commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+		out_texture.UploadFenceValue = fenceValue;
+		return true;
+	}
 
-		Microsoft::WRL::ComPtr<ID3D12Fence> fence;
-		device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence));
-		HANDLE fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-		commandQueue->Signal(fence.Get(), 1);
-		fence->SetEventOnCompletion(1, fenceEvent);
-		WaitForSingleObject(fenceEvent, INFINITE);
-		CloseHandle(fenceEvent);
+	bool CreateTextureFromImage(
+		const DecodedImage& image,
+		ID3D12Device* device,
+		Dx12TextureHeap* textureHeap,
+		Dx12UploadQueue* uploadQueue,
+		ExampleDescriptorHeapAllocator* srvAllocator,
+		ImGuiDx12Texture& out_texture)
+	{
+		const DecodedImage* images[] = {&image};
+		std::vector<ImGuiDx12Texture> textures;
+		if (CreateTexturesFromImages(images, _countof(images), device, textureHeap, uploadQueue, srvAllocator,
+		                             textures) != 1)
+			return false;
 
-		stbi_image_free(image_data);
+		out_texture = std::move(textures[0]);
 		return true;
 	}
+
+	int LoadTexturesFromFiles(
+		const std::vector<std::string>& filenames,
+		ID3D12Device* device,
+		Dx12TextureHeap* textureHeap,
+		Dx12UploadQueue* uploadQueue,
+		ExampleDescriptorHeapAllocator* srvAllocator,
+		std::vector<ImGuiDx12Texture>& out_textures,
+		const BlockCompressionOptions& compression,
+		ThreadPool* pool)
+	{
+		std::vector<DecodedImage> images(filenames.size());
+		std::vector<const DecodedImage*> imagePtrs(filenames.size());
+		ImageDecodeContext decodeContext;
+		decodeContext.Pool = pool;
+		for (size_t i = 0; i < filenames.size(); i++)
+		{
+			if (ImageDecoder::DecodeFile(filenames[i], images[i], 0, &decodeContext))
+			{
+				MipGenerator::GenerateMipChain(images[i]);
+				if (compression.Enabled)
+					BlockCompressor::CompressImage(images[i], compression.Quality, pool);
+			}
+			imagePtrs[i] = &images[i];
+		}
+
+		return CreateTexturesFromImages(imagePtrs.data(), imagePtrs.size(), device, textureHeap, uploadQueue,
+		                                srvAllocator, out_textures);
+	}
+
+	int CreateTexturesFromImages(
+		const DecodedImage* const* images,
+		size_t numImages,
+		ID3D12Device* device,
+		Dx12TextureHeap* textureHeap,
+		Dx12UploadQueue* uploadQueue,
+		ExampleDescriptorHeapAllocator* srvAllocator,
+		std::vector<ImGuiDx12Texture>& out_textures)
+	{
+		out_textures.clear();
+		out_textures.resize(numImages);
+
+		if (!uploadQueue)
+		{
+			std::cerr << "Error: upload queue is null." << std::endl;
+			return 0;
+		}
+
+		ID3D12GraphicsCommandList* commandList = uploadQueue->BeginUpload();
+		if (!commandList)
+			return 0;
+
+		int numCreated = 0;
+		for (size_t i = 0; i < numImages; i++)
+		{
+			const DecodedImage& image = *images[i];
+			ImGuiDx12Texture& texture = out_textures[i];
+			if (image.Pixels == nullptr && !image.CacheEntry)
+				continue;
+
+			if (!CreateTextureResource(image.Format, image.Width, image.Height, image.MipLevels, device, textureHeap,
+			                           srvAllocator, texture) ||
+				!RecordTextureUpload(image, uploadQueue, commandList, texture))
+			{
+				texture.Release(srvAllocator);
+				continue;
+			}
+			texture.SourceWidth = image.SourceWidth;
+			texture.SourceHeight = image.SourceHeight;
+			numCreated++;
+		}
+
+		// One submission and one fence signal for the whole batch.
+		UINT64 fenceValue = uploadQueue->EndUpload();
+		for (ImGuiDx12Texture& texture : out_textures)
+			if (texture.TextureResource)
+				texture.UploadFenceValue = fenceValue;
+
+		return numCreated;
+	}
 }
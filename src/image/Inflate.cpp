@@ -0,0 +1,659 @@
+#include "image/Inflate.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INFLATE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Inflate
+{
+	static constexpr int LITLEN_TABLE_BITS = 11;
+	static constexpr int DIST_TABLE_BITS = 8;
+	static constexpr int PRECODE_TABLE_BITS = 7;
+	static constexpr int MAX_CODE_LENGTH = 15;
+	static constexpr int MAX_PRECODE_LENGTH = 7;
+
+	// Primary table plus the worst case of subtables for these symbol counts and table bits (the same
+	// bounds zlib's enough tool and libdeflate use).
+	static constexpr size_t LITLEN_TABLE_SIZE = 2342;
+	static constexpr size_t DIST_TABLE_SIZE = 402;
+	static constexpr size_t PRECODE_TABLE_SIZE = 1 << PRECODE_TABLE_BITS;
+
+	static constexpr int NUM_LITLEN_SYMBOLS = 288;
+	static constexpr int NUM_DIST_SYMBOLS = 32;
+	static constexpr int NUM_PRECODE_SYMBOLS = 19;
+
+	// A full match is at most 15 + 5 bits of length and 15 + 13 bits of distance, so one refill covers it.
+	static constexpr unsigned BITS_PER_MATCH = 48;
+
+	// Decode table entries: bits 0-7 are the bits to consume, 8-11 the kind, 12-15 the extra bits (or the
+	// subtable's index bits) and 16-31 the value: one or two literals, a length or distance base, or the
+	// subtable's offset in the table.
+	static constexpr uint32_t ENTRY_LITERAL = 0 << 8;
+	static constexpr uint32_t ENTRY_LITERAL_PAIR = 1 << 8;
+	static constexpr uint32_t ENTRY_MATCH = 2 << 8;
+	static constexpr uint32_t ENTRY_END_OF_BLOCK = 3 << 8;
+	static constexpr uint32_t ENTRY_SUBTABLE = 4 << 8;
+	static constexpr uint32_t ENTRY_INVALID = 5 << 8;
+	static constexpr uint32_t ENTRY_KIND_MASK = 0xF << 8;
+
+	static constexpr uint16_t LENGTH_BASE[29] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+	};
+	static constexpr uint8_t LENGTH_EXTRA[29] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+	};
+	static constexpr uint16_t DIST_BASE[30] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+		6145, 8193, 12289, 16385, 24577
+	};
+	static constexpr uint8_t DIST_EXTRA[30] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+	};
+	static constexpr uint8_t PRECODE_ORDER[NUM_PRECODE_SYMBOLS] = {
+		16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+	};
+
+	static uint64_t Load64(const unsigned char* data)
+	{
+		// Little-endian hosts only, like every target of this project.
+		uint64_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	struct BitReader
+	{
+		const unsigned char* In = nullptr;
+		const unsigned char* End = nullptr;
+		uint64_t Bits = 0;
+		unsigned Count = 0; // valid bits at the bottom of Bits; the ones above are the bytes that follow
+		size_t Overread = 0; // zero bytes made up past the end of the input
+
+		// Tops the buffer up to at least 56 bits. Whole words are loaded while 8 input bytes remain; the
+		// bytes that do not fit are loaded again, at the same position, by the next refill.
+		void Refill()
+		{
+			if (End - In >= 8)
+			{
+				Bits |= Load64(In) << Count;
+				In += (63 - Count) >> 3;
+				Count |= 56;
+				return;
+			}
+			while (Count < 56)
+			{
+				uint64_t byte = 0;
+				if (In < End)
+					byte = *In++;
+				else
+					Overread++;
+				Bits |= byte << Count;
+				Count += 8;
+			}
+		}
+
+		uint32_t Peek(unsigned numBits) const { return static_cast<uint32_t>(Bits & ((1ull << numBits) - 1)); }
+
+		void Consume(unsigned numBits)
+		{
+			Bits >>= numBits;
+			Count -= numBits;
+		}
+
+		uint32_t Read(unsigned numBits)
+		{
+			uint32_t value = Peek(numBits);
+			Consume(numBits);
+			return value;
+		}
+
+		// True once bits past the end of the input have been consumed.
+		bool IsOverrun() const { return Overread * 8 > Count; }
+
+		// Drops the bits up to the next byte boundary and hands the whole bytes still buffered back to the
+		// input, for stored blocks.
+		bool AlignToByte()
+		{
+			Consume(Count & 7);
+			size_t buffered = Count / 8;
+			if (buffered < Overread)
+				return false;
+			In -= buffered - Overread;
+			Bits = 0;
+			Count = 0;
+			Overread = 0;
+			return true;
+		}
+	};
+
+	static uint32_t ReverseBits(uint32_t code, int length)
+	{
+		uint32_t reversed = 0;
+		for (int i = 0; i < length; i++)
+		{
+			reversed = (reversed << 1) | (code & 1);
+			code >>= 1;
+		}
+		return reversed;
+	}
+
+	// Builds a decode table for a canonical Huffman code. Codes up to tableBits long are replicated across
+	// the primary table; longer ones go to subtables indexed by their remaining bits. makeEntry gives each
+	// symbol's decode result without the length. Incomplete codes are accepted only when they have at
+	// most one codeword, as RFC 1951 allows for distances; unused entries decode as invalid.
+	static bool BuildDecodeTable(
+		const uint8_t* lengths,
+		int numSymbols,
+		uint32_t (*makeEntry)(int symbol),
+		int tableBits,
+		uint32_t* table,
+		size_t tableSize)
+	{
+		int count[MAX_CODE_LENGTH + 1] = {};
+		for (int symbol = 0; symbol < numSymbols; symbol++)
+			count[lengths[symbol]]++;
+		count[0] = 0;
+
+		int left = 1;
+		int numCodes = 0;
+		for (int length = 1; length <= MAX_CODE_LENGTH; length++)
+		{
+			left = (left << 1) - count[length];
+			if (left < 0)
+				return false; // over-subscribed
+			numCodes += count[length];
+		}
+		if (left > 0 && numCodes > 1)
+			return false;
+
+		int offsets[MAX_CODE_LENGTH + 2] = {};
+		for (int length = 1; length <= MAX_CODE_LENGTH; length++)
+			offsets[length + 1] = offsets[length] + count[length];
+		uint16_t sorted[NUM_LITLEN_SYMBOLS];
+		for (int symbol = 0; symbol < numSymbols; symbol++)
+			if (lengths[symbol] != 0)
+				sorted[offsets[lengths[symbol]]++] = static_cast<uint16_t>(symbol);
+
+		size_t primarySize = size_t(1) << tableBits;
+		for (size_t i = 0; i < primarySize; i++)
+			table[i] = ENTRY_INVALID;
+
+		uint32_t tableMask = static_cast<uint32_t>(primarySize - 1);
+		uint32_t code = 0;
+		size_t nextSubtable = primarySize;
+		uint32_t currentPrefix = UINT32_MAX;
+		size_t subtableStart = 0;
+		for (int i = 0; i < numCodes; i++)
+		{
+			int symbol = sorted[i];
+			int length = lengths[symbol];
+			uint32_t reversed = ReverseBits(code, length);
+
+			if (length <= tableBits)
+			{
+				for (size_t index = reversed; index < primarySize; index += size_t(1) << length)
+					table[index] = makeEntry(symbol) | static_cast<uint32_t>(length);
+			}
+			else
+			{
+				uint32_t prefix = reversed & tableMask;
+				if (prefix != currentPrefix)
+				{
+					// Size the subtable for every remaining code that shares this prefix, as zlib does.
+					int subtableBits = length - tableBits;
+					int available = 1 << subtableBits;
+					while (subtableBits + tableBits < MAX_CODE_LENGTH)
+					{
+						available -= count[subtableBits + tableBits];
+						if (available <= 0)
+							break;
+						subtableBits++;
+						available <<= 1;
+					}
+
+					subtableStart = nextSubtable;
+					nextSubtable += size_t(1) << subtableBits;
+					if (nextSubtable > tableSize)
+						return false;
+					for (size_t index = subtableStart; index < nextSubtable; index++)
+						table[index] = ENTRY_INVALID;
+
+					table[prefix] = ENTRY_SUBTABLE | (static_cast<uint32_t>(subtableBits) << 12) |
+						(static_cast<uint32_t>(subtableStart) << 16) | static_cast<uint32_t>(tableBits);
+					currentPrefix = prefix;
+				}
+
+				int subtableBits = (table[prefix] >> 12) & 0xF;
+				int remainingLength = length - tableBits;
+				for (size_t index = reversed >> tableBits; index < (size_t(1) << subtableBits);
+				     index += size_t(1) << remainingLength)
+					table[subtableStart + index] = makeEntry(symbol) | static_cast<uint32_t>(remainingLength);
+			}
+
+			count[length]--;
+			code++;
+			if (i + 1 < numCodes)
+				code <<= lengths[sorted[i + 1]] - length;
+		}
+		return true;
+	}
+
+	// Lets one primary lookup emit two literals: wherever a literal's code leaves enough of the table's
+	// bits for a second literal's complete code, the entry is replaced by the pair.
+	static void MergeLiteralPairs(uint32_t* table)
+	{
+		constexpr size_t PRIMARY_SIZE = size_t(1) << LITLEN_TABLE_BITS;
+		uint32_t single[PRIMARY_SIZE];
+		memcpy(single, table, sizeof(single));
+
+		for (size_t index = 0; index < PRIMARY_SIZE; index++)
+		{
+			uint32_t first = single[index];
+			if ((first & ENTRY_KIND_MASK) != ENTRY_LITERAL)
+				continue;
+			unsigned firstLength = first & 0xFF;
+			uint32_t second = single[index >> firstLength];
+			unsigned secondLength = second & 0xFF;
+			if ((second & ENTRY_KIND_MASK) != ENTRY_LITERAL || firstLength + secondLength > LITLEN_TABLE_BITS)
+				continue;
+			table[index] = ENTRY_LITERAL_PAIR | (first & 0x00FF0000) | ((second & 0x00FF0000) << 8) |
+				(firstLength + secondLength);
+		}
+	}
+
+	static uint32_t MakeLitlenEntry(int symbol)
+	{
+		if (symbol < 256)
+			return ENTRY_LITERAL | (static_cast<uint32_t>(symbol) << 16);
+		if (symbol == 256)
+			return ENTRY_END_OF_BLOCK;
+		if (symbol < 286)
+			return ENTRY_MATCH | (static_cast<uint32_t>(LENGTH_EXTRA[symbol - 257]) << 12) |
+				(static_cast<uint32_t>(LENGTH_BASE[symbol - 257]) << 16);
+		return ENTRY_INVALID;
+	}
+
+	static uint32_t MakeDistEntry(int symbol)
+	{
+		if (symbol < 30)
+			return ENTRY_MATCH | (static_cast<uint32_t>(DIST_EXTRA[symbol]) << 12) |
+				(static_cast<uint32_t>(DIST_BASE[symbol]) << 16);
+		return ENTRY_INVALID;
+	}
+
+	static uint32_t MakePrecodeEntry(int symbol)
+	{
+		return ENTRY_LITERAL | (static_cast<uint32_t>(symbol) << 16);
+	}
+
+	struct DecodeTables
+	{
+		uint32_t Litlen[LITLEN_TABLE_SIZE];
+		uint32_t Dist[DIST_TABLE_SIZE];
+	};
+
+	static bool BuildTables(const uint8_t* litlenLengths, int numLitlen, const uint8_t* distLengths, int numDist,
+	                        DecodeTables& tables)
+	{
+		if (!BuildDecodeTable(litlenLengths, numLitlen, MakeLitlenEntry, LITLEN_TABLE_BITS, tables.Litlen,
+		                      LITLEN_TABLE_SIZE) ||
+			!BuildDecodeTable(distLengths, numDist, MakeDistEntry, DIST_TABLE_BITS, tables.Dist,
+			                  DIST_TABLE_SIZE))
+			return false;
+		MergeLiteralPairs(tables.Litlen);
+		return true;
+	}
+
+	static bool BuildFixedTables(DecodeTables& tables)
+	{
+		uint8_t litlenLengths[NUM_LITLEN_SYMBOLS];
+		uint8_t distLengths[NUM_DIST_SYMBOLS];
+		memset(litlenLengths, 8, 144);
+		memset(litlenLengths + 144, 9, 256 - 144);
+		memset(litlenLengths + 256, 7, 280 - 256);
+		memset(litlenLengths + 280, 8, NUM_LITLEN_SYMBOLS - 280);
+		memset(distLengths, 5, NUM_DIST_SYMBOLS);
+		return BuildTables(litlenLengths, NUM_LITLEN_SYMBOLS, distLengths, NUM_DIST_SYMBOLS, tables);
+	}
+
+	static bool ReadDynamicTables(BitReader& reader, DecodeTables& tables)
+	{
+		reader.Refill();
+		int numLitlen = static_cast<int>(reader.Read(5)) + 257;
+		int numDist = static_cast<int>(reader.Read(5)) + 1;
+		int numPrecode = static_cast<int>(reader.Read(4)) + 4;
+
+		uint8_t precodeLengths[NUM_PRECODE_SYMBOLS] = {};
+		for (int i = 0; i < numPrecode; i++)
+		{
+			reader.Refill();
+			precodeLengths[PRECODE_ORDER[i]] = static_cast<uint8_t>(reader.Read(3));
+		}
+
+		uint32_t precodeTable[PRECODE_TABLE_SIZE];
+		if (!BuildDecodeTable(precodeLengths, NUM_PRECODE_SYMBOLS, MakePrecodeEntry, PRECODE_TABLE_BITS,
+		                      precodeTable, PRECODE_TABLE_SIZE))
+			return false;
+
+		// Literal/length and distance code lengths form one sequence; repeats may run across the boundary.
+		uint8_t lengths[NUM_LITLEN_SYMBOLS + NUM_DIST_SYMBOLS] = {};
+		int total = numLitlen + numDist;
+		for (int i = 0; i < total;)
+		{
+			reader.Refill();
+			uint32_t entry = precodeTable[reader.Peek(MAX_PRECODE_LENGTH)];
+			if ((entry & ENTRY_KIND_MASK) != ENTRY_LITERAL)
+				return false;
+			reader.Consume(entry & 0xFF);
+
+			uint32_t symbol = entry >> 16;
+			if (symbol < 16)
+			{
+				lengths[i++] = static_cast<uint8_t>(symbol);
+				continue;
+			}
+
+			uint8_t value = 0;
+			int repeat = 0;
+			if (symbol == 16)
+			{
+				if (i == 0)
+					return false;
+				value = lengths[i - 1];
+				repeat = 3 + static_cast<int>(reader.Read(2));
+			}
+			else if (symbol == 17)
+			{
+				repeat = 3 + static_cast<int>(reader.Read(3));
+			}
+			else
+			{
+				repeat = 11 + static_cast<int>(reader.Read(7));
+			}
+			if (repeat > total - i)
+				return false;
+			memset(lengths + i, value, repeat);
+			i += repeat;
+		}
+
+		if (reader.IsOverrun() || lengths[256] == 0)
+			return false;
+		return BuildTables(lengths, numLitlen, lengths + numLitlen, numDist, tables);
+	}
+
+	// Copies a match in 8-byte words; may write up to 7 bytes past its end, which the caller leaves room for
+	// and later output overwrites.
+	static void CopyMatchFast(unsigned char* out, size_t distance, size_t length)
+	{
+		const unsigned char* src = out - distance;
+		unsigned char* end = out + length;
+		if (distance < 8)
+		{
+			if (distance == 1)
+			{
+				uint64_t pattern = src[0] * 0x0101010101010101ull;
+				do
+				{
+					memcpy(out, &pattern, 8);
+					out += 8;
+				}
+				while (out < end);
+				return;
+			}
+
+			// The match repeats every distance bytes, so once one period of at least 8 bytes is out the rest
+			// can be copied in words from that period back.
+			size_t period = (8 + distance - 1) / distance * distance;
+			for (size_t i = 0; i < period; i++)
+				out[i] = src[i];
+			out += period;
+			src = out - period;
+			if (out >= end)
+				return;
+		}
+
+		do
+		{
+			memcpy(out, src, 8);
+			out += 8;
+			src += 8;
+		}
+		while (out < end);
+	}
+
+	static uint32_t DecodeEntry(BitReader& reader, const uint32_t* table, unsigned tableBits)
+	{
+		uint32_t entry = table[reader.Peek(tableBits)];
+		if ((entry & ENTRY_KIND_MASK) == ENTRY_SUBTABLE)
+		{
+			reader.Consume(tableBits);
+			entry = table[(entry >> 16) + reader.Peek((entry >> 12) & 0xF)];
+		}
+		reader.Consume(entry & 0xFF);
+		return entry;
+	}
+
+	static bool DecodeHuffmanBlock(BitReader& reader, const DecodeTables& tables, unsigned char* outBegin,
+	                               unsigned char*& out, unsigned char* outEnd)
+	{
+		// Far enough from the end of the output for any symbol and the overshoot of a word copy, the loop
+		// needs no bounds checks on the output.
+		constexpr size_t FAST_LOOP_MARGIN = 258 + 8;
+		unsigned char* fastEnd = static_cast<size_t>(outEnd - out) > FAST_LOOP_MARGIN ? outEnd - FAST_LOOP_MARGIN : out;
+
+		for (;;)
+		{
+			if (reader.Count < BITS_PER_MATCH)
+				reader.Refill();
+
+			uint32_t entry = DecodeEntry(reader, tables.Litlen, LITLEN_TABLE_BITS);
+			uint32_t kind = entry & ENTRY_KIND_MASK;
+			bool fast = out < fastEnd;
+			if (kind == ENTRY_LITERAL)
+			{
+				if (!fast && out == outEnd)
+					return false;
+				*out++ = static_cast<unsigned char>(entry >> 16);
+				continue;
+			}
+			if (kind == ENTRY_LITERAL_PAIR)
+			{
+				if (!fast && outEnd - out < 2)
+					return false;
+				out[0] = static_cast<unsigned char>(entry >> 16);
+				out[1] = static_cast<unsigned char>(entry >> 24);
+				out += 2;
+				continue;
+			}
+			if (kind == ENTRY_END_OF_BLOCK)
+				return !reader.IsOverrun();
+			if (kind != ENTRY_MATCH)
+				return false;
+
+			size_t length = (entry >> 16) + reader.Read((entry >> 12) & 0xF);
+			entry = DecodeEntry(reader, tables.Dist, DIST_TABLE_BITS);
+			if ((entry & ENTRY_KIND_MASK) != ENTRY_MATCH)
+				return false;
+			size_t distance = (entry >> 16) + reader.Read((entry >> 12) & 0xF);
+			if (distance > static_cast<size_t>(out - outBegin))
+				return false;
+
+			if (fast)
+			{
+				CopyMatchFast(out, distance, length);
+			}
+			else
+			{
+				if (length > static_cast<size_t>(outEnd - out))
+					return false;
+				for (size_t i = 0; i < length; i++)
+					out[i] = out[i - distance];
+			}
+			out += length;
+		}
+	}
+
+	static bool CopyStoredBlock(BitReader& reader, unsigned char*& out, unsigned char* outEnd)
+	{
+		if (!reader.AlignToByte() || reader.End - reader.In < 4)
+			return false;
+		size_t length = reader.In[0] | (reader.In[1] << 8);
+		size_t inverse = reader.In[2] | (reader.In[3] << 8);
+		reader.In += 4;
+		if ((length ^ 0xFFFF) != inverse || length > static_cast<size_t>(reader.End - reader.In) ||
+			length > static_cast<size_t>(outEnd - out))
+			return false;
+		memcpy(out, reader.In, length);
+		reader.In += length;
+		out += length;
+		return true;
+	}
+
+	bool DecompressRaw(
+		const unsigned char* src,
+		size_t srcSize,
+		unsigned char* dst,
+		size_t dstSize,
+		size_t* out_size,
+		size_t* out_consumed)
+	{
+		BitReader reader;
+		reader.In = src;
+		reader.End = src + srcSize;
+
+		unsigned char* out = dst;
+		unsigned char* outEnd = dst + dstSize;
+		// Both tables together are about 11 KB; the stack is fine for them.
+		DecodeTables tables;
+
+		bool finalBlock = false;
+		while (!finalBlock)
+		{
+			reader.Refill();
+			finalBlock = reader.Read(1) != 0;
+			uint32_t type = reader.Read(2);
+
+			bool decoded = false;
+			if (type == 0)
+				decoded = CopyStoredBlock(reader, out, outEnd);
+			else if (type == 1)
+				decoded = BuildFixedTables(tables) && DecodeHuffmanBlock(reader, tables, dst, out, outEnd);
+			else if (type == 2)
+				decoded = ReadDynamicTables(reader, tables) && DecodeHuffmanBlock(reader, tables, dst, out, outEnd);
+			if (!decoded || reader.IsOverrun())
+				return false;
+		}
+
+		*out_size = static_cast<size_t>(out - dst);
+		if (out_consumed)
+		{
+			reader.Consume(reader.Count & 7);
+			*out_consumed = static_cast<size_t>(reader.In - src) - (reader.Count / 8 - reader.Overread);
+		}
+		return true;
+	}
+
+	bool DecompressZlib(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize, size_t* out_size)
+	{
+		// Deflate with a window of at most 32 KB, no preset dictionary, and a valid header check.
+		if (srcSize < 6 || (src[0] & 0x0F) != 8 || (src[0] >> 4) > 7 || (src[1] & 0x20) != 0 ||
+			((src[0] << 8) | src[1]) % 31 != 0)
+			return false;
+
+		size_t consumed = 0;
+		if (!DecompressRaw(src + 2, srcSize - 2, dst, dstSize, out_size, &consumed) || srcSize - 2 - consumed < 4)
+			return false;
+
+		const unsigned char* trailer = src + 2 + consumed;
+		uint32_t expected = (static_cast<uint32_t>(trailer[0]) << 24) | (static_cast<uint32_t>(trailer[1]) << 16) |
+			(static_cast<uint32_t>(trailer[2]) << 8) | trailer[3];
+		return Adler32(dst, *out_size) == expected;
+	}
+
+#ifdef INFLATE_SSE2
+	static uint32_t SumLanes(__m128i v)
+	{
+		v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+		v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+		return static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+	}
+#endif
+
+	uint32_t Adler32(const unsigned char* data, size_t size, uint32_t adler)
+	{
+		constexpr uint32_t BASE = 65521;
+		// Largest run that cannot overflow 32-bit sums before the modulo; a multiple of 16.
+		constexpr size_t MAX_RUN = 5552;
+
+		uint32_t a = adler & 0xFFFF;
+		uint32_t b = adler >> 16;
+		while (size > 0)
+		{
+			size_t run = size < MAX_RUN ? size : MAX_RUN;
+			size -= run;
+
+#ifdef INFLATE_SSE2
+			// Over n bytes, b gains n * a plus every byte weighted by how many bytes are left including
+			// itself. Per 16-byte chunk: the byte sum goes into a, the chunk weighted 16..1 into b, and the
+			// byte sum of all earlier chunks, once per chunk, accounts for the other 16 each chunk adds.
+			size_t numChunks = run / 16;
+			if (numChunks > 0)
+			{
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i weightsLow = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+				const __m128i weightsHigh = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+				__m128i byteSum = zero;
+				__m128i runningSum = zero;
+				__m128i weightedSum = zero;
+				for (size_t chunk = 0; chunk < numChunks; chunk++)
+				{
+					__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + chunk * 16));
+					runningSum = _mm_add_epi32(runningSum, byteSum);
+					byteSum = _mm_add_epi32(byteSum, _mm_sad_epu8(bytes, zero));
+					weightedSum = _mm_add_epi32(weightedSum, _mm_madd_epi16(_mm_unpacklo_epi8(bytes, zero), weightsLow));
+					weightedSum = _mm_add_epi32(weightedSum, _mm_madd_epi16(_mm_unpackhi_epi8(bytes, zero), weightsHigh));
+				}
+
+				size_t numBytes = numChunks * 16;
+				uint64_t newB = b + static_cast<uint64_t>(numBytes) * a + 16ull * SumLanes(runningSum) +
+					SumLanes(weightedSum);
+				a += SumLanes(byteSum);
+				b = static_cast<uint32_t>(newB % BASE);
+				data += numBytes;
+				run -= numBytes;
+			}
+#endif
+
+			for (; run > 0; run--)
+			{
+				a += *data++;
+				b += a;
+			}
+			a %= BASE;
+			b %= BASE;
+		}
+		return (b << 16) | a;
+	}
+
+	uint32_t CombineAdler32(uint32_t adlerA, uint32_t adlerB, size_t lengthB)
+	{
+		constexpr uint32_t BASE = 65521;
+		uint32_t remainder = static_cast<uint32_t>(lengthB % BASE);
+		uint32_t sum1 = adlerA & 0xFFFF;
+		uint32_t sum2 = (remainder * sum1) % BASE;
+		sum1 += (adlerB & 0xFFFF) + BASE - 1;
+		sum2 += ((adlerA >> 16) & 0xFFFF) + ((adlerB >> 16) & 0xFFFF) + BASE - remainder;
+		if (sum1 >= BASE)
+			sum1 -= BASE;
+		if (sum1 >= BASE)
+			sum1 -= BASE;
+		if (sum2 >= BASE * 2)
+			sum2 -= BASE * 2;
+		if (sum2 >= BASE)
+			sum2 -= BASE;
+		return sum1 | (sum2 << 16);
+	}
+}
@@ -0,0 +1,1291 @@
+#include "image/JpegDecoder.h"
+#include "core/CpuFeatures.h"
+#include "image/PixelConvert.h"
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define JPEG_DECODER_X86
+#include <immintrin.h>
+#endif
+
+// GCC and Clang only emit AVX2 instructions in functions that ask for them; MSVC always does.
+#if defined(__GNUC__) || defined(__clang__)
+#define JPEG_DECODER_AVX2 __attribute__((target("avx2")))
+#else
+#define JPEG_DECODER_AVX2
+#endif
+
+namespace JpegDecoder
+{
+	// Codes up to this long are decoded with a single table lookup.
+	static constexpr int FAST_BITS = 9;
+	// Sampling factors are at most 2, so an MCU has at most 4 luma and 2 x 4 chroma blocks.
+	static constexpr int MAX_BLOCKS_PER_MCU = 12;
+
+	// Natural (row-major) index of the k-th coefficient in zigzag order.
+	static constexpr uint8_t DEZIGZAG[64] = {
+		0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+		12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+		35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+		58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+	struct HuffmanTable
+	{
+		bool Defined = false;
+		uint16_t Fast[1 << FAST_BITS] = {}; // (code length << 8) | symbol, 0 for longer codes
+		// AC tables only: (coefficient << 16) | (zero run << 8) | bits for code and value together, for
+		// codes whose value bits also fit in FAST_BITS; 0 otherwise.
+		int32_t FastAc[1 << FAST_BITS] = {};
+		uint32_t MaxCode[18] = {}; // first code past the codes of each length, left-aligned to 16 bits
+		int Delta[17] = {}; // index into Values minus code, per length
+		uint8_t Values[256] = {};
+		int NumValues = 0;
+	};
+
+	struct Component
+	{
+		int Id = 0;
+		int H = 1; // sampling factors
+		int V = 1;
+		int QuantTable = 0;
+		int DcTable = 0;
+		int AcTable = 0;
+		int DcPrediction = 0;
+
+		int Hs = 1; // upsampling factors to full resolution
+		int Vs = 1;
+		int BlockWidth = 8; // samples a block decodes to
+		int BlockHeight = 8;
+		int Width = 0; // samples in a row before upsampling
+		int Rows = 0; // rows before upsampling
+		int BlocksPerLine = 0;
+		int StripRows = 0; // rows per row of MCUs
+		size_t Stride = 0;
+		// Two strips, the current row of MCUs and the one before it. Each pointer is at row 0; row -1 holds
+		// the last row of the strip before, for the vertical upsampling filter.
+		unsigned char* Strips[2] = {};
+	};
+
+	struct JpegFile
+	{
+		JpegInfo Info;
+		Component Components[4];
+		int HMax = 1;
+		int VMax = 1;
+		int BlockSize = 8; // samples per luma block side at the output scale
+		int OutWidth = 0;
+		int OutHeight = 0;
+		uint16_t Quant[4][64] = {}; // natural order
+		bool QuantDefined[4] = {};
+		HuffmanTable Dc[4];
+		HuffmanTable Ac[4];
+		int RestartInterval = 0;
+		bool Jfif = false;
+		int AdobeTransform = -1;
+
+		int ScanOrder[4] = {};
+		const unsigned char* ScanData = nullptr;
+		const unsigned char* DataEnd = nullptr;
+	};
+
+	static uint16_t ReadUint16(const unsigned char* data)
+	{
+		return static_cast<uint16_t>((data[0] << 8) | data[1]);
+	}
+
+	static bool IsFrameMarker(int marker)
+	{
+		// C4 (DHT), C8 (reserved) and CC (DAC) share the range with the SOFn markers.
+		return marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+	}
+
+	static bool IsStandaloneMarker(int marker)
+	{
+		return marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7);
+	}
+
+	// Reads the marker at pos, skipping fill bytes, and leaves pos on its segment.
+	static bool ReadMarker(const unsigned char* data, size_t size, size_t& pos, int* out_marker)
+	{
+		if (pos >= size || data[pos] != 0xFF)
+			return false;
+		while (pos < size && data[pos] == 0xFF)
+			pos++;
+		if (pos >= size)
+			return false;
+		*out_marker = data[pos++];
+		return true;
+	}
+
+	// Payload of the segment at pos, after its length field; moves pos past it.
+	static bool ReadSegment(const unsigned char* data, size_t size, size_t& pos, const unsigned char** out_payload,
+	                        size_t* out_length)
+	{
+		if (size - pos < 2)
+			return false;
+		size_t length = ReadUint16(data + pos);
+		if (length < 2 || length > size - pos)
+			return false;
+		*out_payload = data + pos + 2;
+		*out_length = length - 2;
+		pos += length;
+		return true;
+	}
+
+	static bool ParseFrame(const unsigned char* payload, size_t length, int marker, JpegInfo& info, Component* components)
+	{
+		if (length < 6)
+			return false;
+		info.Precision = payload[0];
+		info.Height = ReadUint16(payload + 1);
+		info.Width = ReadUint16(payload + 3);
+		info.Components = payload[5];
+		info.Sequential = marker == 0xC0 || marker == 0xC1;
+		// A height of 0 defers it to a DNL marker after the first scan, which nothing here reads.
+		if (info.Width == 0 || info.Height == 0 || info.Components < 1 || info.Components > 4 ||
+			length != 6 + static_cast<size_t>(info.Components) * 3)
+			return false;
+
+		for (int i = 0; i < info.Components; i++)
+		{
+			const unsigned char* spec = payload + 6 + i * 3;
+			info.SamplingH[i] = spec[1] >> 4;
+			info.SamplingV[i] = spec[1] & 15;
+			if (info.SamplingH[i] < 1 || info.SamplingH[i] > 4 || info.SamplingV[i] < 1 || info.SamplingV[i] > 4 ||
+				spec[2] > 3)
+				return false;
+			if (components)
+			{
+				components[i].Id = spec[0];
+				components[i].H = info.SamplingH[i];
+				components[i].V = info.SamplingV[i];
+				components[i].QuantTable = spec[2];
+			}
+		}
+		return true;
+	}
+
+	static bool ParseQuantTables(const unsigned char* payload, size_t length, JpegFile& file)
+	{
+		while (length > 0)
+		{
+			int precision = payload[0] >> 4;
+			int table = payload[0] & 15;
+			size_t tableSize = 1 + 64 * (precision + 1);
+			if (precision > 1 || table > 3 || length < tableSize)
+				return false;
+			for (int i = 0; i < 64; i++)
+				file.Quant[table][DEZIGZAG[i]] = precision ? ReadUint16(payload + 1 + i * 2) : payload[1 + i];
+			file.QuantDefined[table] = true;
+			payload += tableSize;
+			length -= tableSize;
+		}
+		return true;
+	}
+
+	static bool BuildHuffmanTable(const unsigned char* counts, const unsigned char* values, int numValues,
+	                              bool isAc, HuffmanTable& table)
+	{
+		table = HuffmanTable();
+		memcpy(table.Values, values, numValues);
+		table.NumValues = numValues;
+
+		// Canonical codes: each length continues from the last code of the length before, shifted left.
+		uint32_t code = 0;
+		int index = 0;
+		for (int length = 1; length <= 16; length++)
+		{
+			table.Delta[length] = index - static_cast<int>(code);
+			for (int i = 0; i < counts[length - 1]; i++, index++, code++)
+			{
+				if (code >= (1u << length))
+					return false;
+				if (length > FAST_BITS)
+					continue;
+				int first = static_cast<int>(code << (FAST_BITS - length));
+				for (int j = 0; j < (1 << (FAST_BITS - length)); j++)
+					table.Fast[first + j] = static_cast<uint16_t>((length << 8) | values[index]);
+			}
+			table.MaxCode[length] = code << (16 - length);
+			code <<= 1;
+		}
+		table.MaxCode[17] = 0xFFFFFFFF;
+
+		if (isAc)
+		{
+			for (int bits = 0; bits < (1 << FAST_BITS); bits++)
+			{
+				int fast = table.Fast[bits];
+				int codeLength = fast >> 8;
+				int run = (fast >> 4) & 15;
+				int valueBits = fast & 15;
+				if (fast == 0 || valueBits == 0 || codeLength + valueBits > FAST_BITS)
+					continue;
+				int value = ((bits << codeLength) & ((1 << FAST_BITS) - 1)) >> (FAST_BITS - valueBits);
+				if (value < (1 << (valueBits - 1)))
+					value -= (1 << valueBits) - 1;
+				table.FastAc[bits] = static_cast<int32_t>(static_cast<uint32_t>(value) << 16) | (run << 8) |
+					(codeLength + valueBits);
+			}
+		}
+		table.Defined = true;
+		return true;
+	}
+
+	static bool ParseHuffmanTables(const unsigned char* payload, size_t length, JpegFile& file)
+	{
+		while (length > 0)
+		{
+			if (length < 17)
+				return false;
+			int tableClass = payload[0] >> 4;
+			int table = payload[0] & 15;
+			const unsigned char* counts = payload + 1;
+			int numValues = 0;
+			for (int i = 0; i < 16; i++)
+				numValues += counts[i];
+			if (tableClass > 1 || table > 3 || numValues > 256 || length < 17 + static_cast<size_t>(numValues))
+				return false;
+			if (!BuildHuffmanTable(counts, payload + 17, numValues, tableClass == 1,
+			                       tableClass == 0 ? file.Dc[table] : file.Ac[table]))
+				return false;
+			payload += 17 + numValues;
+			length -= 17 + numValues;
+		}
+		return true;
+	}
+
+	static bool ParseScanHeader(const unsigned char* payload, size_t length, JpegFile& file)
+	{
+		int numComponents = length > 0 ? payload[0] : 0;
+		if (numComponents < 1 || length != 4 + static_cast<size_t>(numComponents) * 2)
+			return false;
+
+		// Only a single scan with every component interleaved, as baseline encoders write it.
+		if (numComponents != file.Info.Components)
+			return false;
+		for (int i = 0; i < numComponents; i++)
+		{
+			int id = payload[1 + i * 2];
+			int tables = payload[2 + i * 2];
+			int which = 0;
+			while (which < file.Info.Components && file.Components[which].Id != id)
+				which++;
+			if (which == file.Info.Components)
+				return false;
+
+			Component& component = file.Components[which];
+			component.DcTable = tables >> 4;
+			component.AcTable = tables & 15;
+			if (component.DcTable > 3 || component.AcTable > 3 || !file.Dc[component.DcTable].Defined ||
+				!file.Ac[component.AcTable].Defined || !file.QuantDefined[component.QuantTable])
+				return false;
+			file.ScanOrder[i] = which;
+		}
+
+		const unsigned char* spectral = payload + 1 + numComponents * 2;
+		return spectral[0] == 0 && spectral[1] == 63 && spectral[2] == 0;
+	}
+
+	// Reads the markers up to the first scan; ScanData is left on its entropy-coded data.
+	static bool ParseFile(const unsigned char* data, size_t size, JpegFile& file)
+	{
+		if (size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+			return false;
+
+		bool haveFrame = false;
+		size_t pos = 2;
+		int marker = 0;
+		while (ReadMarker(data, size, pos, &marker))
+		{
+			if (IsStandaloneMarker(marker))
+				continue;
+			if (marker == 0xD8 || marker == 0xD9)
+				return false;
+
+			const unsigned char* payload = nullptr;
+			size_t length = 0;
+			if (!ReadSegment(data, size, pos, &payload, &length))
+				return false;
+
+			if (IsFrameMarker(marker))
+			{
+				if (haveFrame || !ParseFrame(payload, length, marker, file.Info, file.Components) ||
+					!IsSupported(file.Info))
+					return false;
+				haveFrame = true;
+			}
+			else if (marker == 0xDB)
+			{
+				if (!ParseQuantTables(payload, length, file))
+					return false;
+			}
+			else if (marker == 0xC4)
+			{
+				if (!ParseHuffmanTables(payload, length, file))
+					return false;
+			}
+			else if (marker == 0xDD)
+			{
+				if (length != 2)
+					return false;
+				file.RestartInterval = ReadUint16(payload);
+			}
+			else if (marker == 0xE0)
+			{
+				if (length >= 5 && memcmp(payload, "JFIF", 5) == 0)
+					file.Jfif = true;
+			}
+			else if (marker == 0xEE)
+			{
+				// "Adobe", version, two flag words, then the color transform.
+				if (length >= 12 && memcmp(payload, "Adobe", 6) == 0)
+					file.AdobeTransform = payload[11];
+			}
+			else if (marker == 0xDA)
+			{
+				if (!haveFrame || !ParseScanHeader(payload, length, file))
+					return false;
+				file.ScanData = data + pos;
+				file.DataEnd = data + size;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// MSB-first reader over entropy-coded data. FF 00 is a stuffed FF byte; any other byte after an FF is a
+	// marker, which ends the data: from there on, like past the end of the file, it reads zeros.
+	struct BitReader
+	{
+		const unsigned char* In = nullptr;
+		const unsigned char* End = nullptr;
+		uint64_t Bits = 0; // next bit in the top bit
+		int Count = 0;
+		bool AtMarker = false;
+
+		void Refill()
+		{
+			// Eight bytes without an FF are all plain data and can be taken in one go. Bits below Count
+			// may then already hold the start of the next byte; later refills OR in the same bits again.
+			if (!AtMarker && End - In >= 8)
+			{
+				uint64_t word = 0;
+				for (int i = 0; i < 8; i++)
+					word = (word << 8) | In[i];
+				uint64_t inverted = ~word;
+				if (((inverted - 0x0101010101010101ull) & ~inverted & 0x8080808080808080ull) == 0)
+				{
+					Bits |= word >> Count;
+					In += (63 - Count) >> 3;
+					Count |= 56;
+					return;
+				}
+			}
+
+			while (Count <= 56)
+			{
+				unsigned int byte = 0;
+				if (!AtMarker && In < End)
+				{
+					byte = *In;
+					if (byte != 0xFF)
+						In++;
+					else if (End - In >= 2 && In[1] == 0)
+						In += 2;
+					else
+					{
+						AtMarker = true;
+						byte = 0;
+					}
+				}
+				Bits |= static_cast<uint64_t>(byte) << (56 - Count);
+				Count += 8;
+			}
+		}
+
+		// Enough for a 16-bit code and up to 16 value bits.
+		void EnsureBits()
+		{
+			if (Count < 32)
+				Refill();
+		}
+
+		uint32_t Peek(int numBits) const
+		{
+			return static_cast<uint32_t>(Bits >> (64 - numBits));
+		}
+
+		void Consume(int numBits)
+		{
+			Bits <<= numBits;
+			Count -= numBits;
+		}
+
+		// numBits of a coefficient in JPEG's sign convention: values below half the range are negative.
+		int ReceiveExtend(int numBits)
+		{
+			int value = static_cast<int>(Peek(numBits));
+			Consume(numBits);
+			return value < (1 << (numBits - 1)) ? value - (1 << numBits) + 1 : value;
+		}
+
+		// Drops the padding bits at the end of a restart interval and steps over its RSTn marker.
+		bool Restart()
+		{
+			Bits = 0;
+			Count = 0;
+			AtMarker = false;
+			if (End - In < 2 || In[0] != 0xFF)
+				return false;
+			while (In < End && In[0] == 0xFF)
+				In++;
+			if (In == End || In[0] < 0xD0 || In[0] > 0xD7)
+				return false;
+			In++;
+			return true;
+		}
+	};
+
+	// Codes longer than FAST_BITS, from the next 16 bits. Returns the symbol, or -1 for an invalid code.
+	static int DecodeLongCode(uint32_t code, const HuffmanTable& table, int* out_length)
+	{
+		int length = FAST_BITS + 1;
+		while (code >= table.MaxCode[length])
+			length++;
+		if (length > 16)
+			return -1;
+		int index = static_cast<int>(code >> (16 - length)) + table.Delta[length];
+		if (index < 0 || index >= table.NumValues)
+			return -1;
+		*out_length = length;
+		return table.Values[index];
+	}
+
+	static int DecodeSymbol(BitReader& reader, const HuffmanTable& table)
+	{
+		uint16_t fast = table.Fast[reader.Peek(FAST_BITS)];
+		if (fast != 0)
+		{
+			reader.Consume(fast >> 8);
+			return fast & 0xFF;
+		}
+
+		int length = 0;
+		int symbol = DecodeLongCode(reader.Peek(16), table, &length);
+		if (symbol >= 0)
+			reader.Consume(length);
+		return symbol;
+	}
+
+	// Dequantized coefficients in natural order. out_hasAc is false when only the DC coefficient is set.
+	// Works on a copy of the reader so that its state can stay in registers.
+	static bool DecodeBlock(BitReader& sharedReader, const JpegFile& file, Component& component, int16_t* coeffs,
+	                        bool* out_hasAc)
+	{
+		BitReader reader = sharedReader;
+		const HuffmanTable& ac = file.Ac[component.AcTable];
+		const uint16_t* quant = file.Quant[component.QuantTable];
+		memset(coeffs, 0, 64 * sizeof(int16_t));
+
+		reader.EnsureBits();
+		int dcBits = DecodeSymbol(reader, file.Dc[component.DcTable]);
+		if (dcBits < 0 || dcBits > 15)
+			return false;
+		component.DcPrediction += dcBits ? reader.ReceiveExtend(dcBits) : 0;
+		coeffs[0] = static_cast<int16_t>(component.DcPrediction * quant[0]);
+
+		bool hasAc = false;
+		int k = 1;
+		while (k < 64)
+		{
+			reader.EnsureBits();
+			int32_t fast = ac.FastAc[reader.Peek(FAST_BITS)];
+			if (fast != 0)
+			{
+				reader.Consume(fast & 0xFF);
+				k += (fast >> 8) & 15;
+				if (k > 63)
+					return false;
+				int zig = DEZIGZAG[k++];
+				coeffs[zig] = static_cast<int16_t>((fast >> 16) * quant[zig]);
+				hasAc = true;
+				continue;
+			}
+
+			int symbol = DecodeSymbol(reader, ac);
+			if (symbol < 0)
+				return false;
+			int run = symbol >> 4;
+			int valueBits = symbol & 15;
+			if (valueBits == 0)
+			{
+				if (symbol != 0xF0) // end of block
+					break;
+				k += 16;
+				continue;
+			}
+			k += run;
+			if (k > 63)
+				return false;
+			int zig = DEZIGZAG[k++];
+			coeffs[zig] = static_cast<int16_t>(reader.ReceiveExtend(valueBits) * quant[zig]);
+			hasAc = true;
+		}
+		sharedReader = reader;
+		*out_hasAc = hasAc;
+		return true;
+	}
+
+	// What stb_image's integer IDCT produces for a block with only a DC coefficient, filled into a block of
+	// any size. At 1/8 scale every luma block is decoded this way: the DC coefficient is the block's mean.
+	static void FillDcBlock(int16_t dc, unsigned char* out, size_t stride, int width, int height)
+	{
+		int value = (dc * 4 * 4096 + 65536 + (128 << 17)) >> 17;
+		unsigned char sample = static_cast<unsigned char>(value < 0 ? 0 : value > 255 ? 255 : value);
+		for (int y = 0; y < height; y++)
+			memset(out + y * stride, sample, width);
+	}
+
+	// stb_image's fancy upsampling for one output sample: vertically 3:1 between the near and far chroma
+	// rows, horizontally 3:1 between the nearest chroma sample and its neighbour on the output sample's side,
+	// with the edge samples repeated.
+	static int UpsampleChroma(const unsigned char* nearRow, const unsigned char* farRow, int hs, int vs, int width,
+	                          int x)
+	{
+		// stb_image's horizontal-only filter swaps the weights for the next to last output sample.
+		if (hs == 2 && vs == 1 && width >= 2 && x == 2 * (width - 1))
+			return (3 * nearRow[width - 2] + nearRow[width - 1] + 2) >> 2;
+
+		int i = hs == 2 ? x >> 1 : x;
+		int center = vs == 2 ? 3 * nearRow[i] + farRow[i] : 4 * nearRow[i];
+		if (hs == 1)
+			return (4 * center + 8) >> 4;
+
+		int neighbour = (x & 1) ? (i + 1 < width ? i + 1 : i) : (i > 0 ? i - 1 : i);
+		int side = vs == 2 ? 3 * nearRow[neighbour] + farRow[neighbour] : 4 * nearRow[neighbour];
+		return (3 * center + side + 8) >> 4;
+	}
+
+	struct ChromaRows
+	{
+		const unsigned char* CbNear = nullptr;
+		const unsigned char* CbFar = nullptr;
+		const unsigned char* CrNear = nullptr;
+		const unsigned char* CrFar = nullptr;
+		int Hs = 1;
+		int Vs = 1;
+		int Width = 0; // chroma samples per row
+	};
+
+	static unsigned char ClampToByte(int value)
+	{
+		return static_cast<unsigned char>(value < 0 ? 0 : value > 255 ? 255 : value);
+	}
+
+	// stb_image's fixed-point YCbCr to RGB, including its truncation of the Cb term of green.
+	static void YCbCrToRgbaPixel(int y, int cb, int cr, unsigned char* dst)
+	{
+		constexpr int CR_TO_R = static_cast<int>(1.40200f * 4096.0f + 0.5f) << 8;
+		constexpr int CR_TO_G = -(static_cast<int>(0.71414f * 4096.0f + 0.5f) << 8);
+		constexpr int CB_TO_G = -(static_cast<int>(0.34414f * 4096.0f + 0.5f) << 8);
+		constexpr int CB_TO_B = static_cast<int>(1.77200f * 4096.0f + 0.5f) << 8;
+
+		int yFixed = (y << 20) + (1 << 19);
+		cr -= 128;
+		cb -= 128;
+		dst[0] = ClampToByte((yFixed + cr * CR_TO_R) >> 20);
+		dst[1] = ClampToByte((yFixed + cr * CR_TO_G + static_cast<int>((cb * CB_TO_G) & 0xFFFF0000)) >> 20);
+		dst[2] = ClampToByte((yFixed + cb * CB_TO_B) >> 20);
+		dst[3] = 255;
+	}
+
+	static void YCbCrRowToRgbaReference(const unsigned char* y, const ChromaRows& chroma, unsigned char* dst,
+	                                    int begin, int end)
+	{
+		for (int x = begin; x < end; x++)
+		{
+			int cb = UpsampleChroma(chroma.CbNear, chroma.CbFar, chroma.Hs, chroma.Vs, chroma.Width, x);
+			int cr = UpsampleChroma(chroma.CrNear, chroma.CrFar, chroma.Hs, chroma.Vs, chroma.Width, x);
+			YCbCrToRgbaPixel(y[x], cb, cr, dst + x * 4);
+		}
+	}
+
+#ifdef JPEG_DECODER_X86
+	// The IDCT is stb_image's SSE2 one with each 128-bit lane of an AVX2 register holding a different block.
+	// All of its shuffles, packs and multiply-adds stay within lanes, so the two blocks never mix and each
+	// comes out exactly as stb_image's scalar IDCT would produce it.
+
+	// 32-bit intermediates for one 16-bit register, from its low and high halves.
+	struct Wide
+	{
+		__m256i Low;
+		__m256i High;
+	};
+
+	// Multiply-add constant with x in the even and y in the odd 16-bit elements.
+	JPEG_DECODER_AVX2
+	static __m256i IdctConstant(int x, int y)
+	{
+		return _mm256_set1_epi32(static_cast<int>((static_cast<uint32_t>(x) & 0xFFFF) | (static_cast<uint32_t>(y) << 16)));
+	}
+
+	// out0 = c0.even * x + c0.odd * y, out1 likewise with c1, in 32 bits.
+	JPEG_DECODER_AVX2
+	static void IdctRotate(__m256i x, __m256i y, __m256i c0, __m256i c1, Wide& out0, Wide& out1)
+	{
+		__m256i low = _mm256_unpacklo_epi16(x, y);
+		__m256i high = _mm256_unpackhi_epi16(x, y);
+		out0 = {_mm256_madd_epi16(low, c0), _mm256_madd_epi16(high, c0)};
+		out1 = {_mm256_madd_epi16(low, c1), _mm256_madd_epi16(high, c1)};
+	}
+
+	// v << 12 in 32 bits.
+	JPEG_DECODER_AVX2
+	static Wide IdctWiden(__m256i v)
+	{
+		__m256i zero = _mm256_setzero_si256();
+		return {_mm256_srai_epi32(_mm256_unpacklo_epi16(zero, v), 4), _mm256_srai_epi32(_mm256_unpackhi_epi16(zero, v), 4)};
+	}
+
+	JPEG_DECODER_AVX2
+	static Wide IdctAdd(const Wide& a, const Wide& b)
+	{
+		return {_mm256_add_epi32(a.Low, b.Low), _mm256_add_epi32(a.High, b.High)};
+	}
+
+	JPEG_DECODER_AVX2
+	static Wide IdctSub(const Wide& a, const Wide& b)
+	{
+		return {_mm256_sub_epi32(a.Low, b.Low), _mm256_sub_epi32(a.High, b.High)};
+	}
+
+	// (a + bias + b) >> Shift and (a + bias - b) >> Shift, packed back to 16 bits.
+	template <int Shift>
+	JPEG_DECODER_AVX2
+	static void IdctButterfly(const Wide& a, const Wide& b, __m256i bias, __m256i& out0, __m256i& out1)
+	{
+		Wide biased = {_mm256_add_epi32(a.Low, bias), _mm256_add_epi32(a.High, bias)};
+		Wide sum = IdctAdd(biased, b);
+		Wide difference = IdctSub(biased, b);
+		out0 = _mm256_packs_epi32(_mm256_srai_epi32(sum.Low, Shift), _mm256_srai_epi32(sum.High, Shift));
+		out1 = _mm256_packs_epi32(_mm256_srai_epi32(difference.Low, Shift), _mm256_srai_epi32(difference.High, Shift));
+	}
+
+	JPEG_DECODER_AVX2
+	static void Interleave16(__m256i& a, __m256i& b)
+	{
+		__m256i low = _mm256_unpacklo_epi16(a, b);
+		b = _mm256_unpackhi_epi16(a, b);
+		a = low;
+	}
+
+	JPEG_DECODER_AVX2
+	static void Interleave8(__m256i& a, __m256i& b)
+	{
+		__m256i low = _mm256_unpacklo_epi8(a, b);
+		b = _mm256_unpackhi_epi8(a, b);
+		a = low;
+	}
+
+	// One 1-D pass over eight rows of 16-bit values (stb_image's dct_pass).
+	template <int Shift>
+	JPEG_DECODER_AVX2
+	static void IdctPass(__m256i* rows, __m256i bias)
+	{
+		constexpr auto f2f = [](float x) { return static_cast<int>(x * 4096 + 0.5); };
+
+		// Even part.
+		Wide t2e, t3e;
+		IdctRotate(rows[2], rows[6], IdctConstant(f2f(0.5411961f), f2f(0.5411961f) + f2f(-1.847759065f)),
+		           IdctConstant(f2f(0.5411961f) + f2f(0.765366865f), f2f(0.5411961f)), t2e, t3e);
+		Wide t0e = IdctWiden(_mm256_add_epi16(rows[0], rows[4]));
+		Wide t1e = IdctWiden(_mm256_sub_epi16(rows[0], rows[4]));
+		Wide x0 = IdctAdd(t0e, t3e);
+		Wide x3 = IdctSub(t0e, t3e);
+		Wide x1 = IdctAdd(t1e, t2e);
+		Wide x2 = IdctSub(t1e, t2e);
+
+		// Odd part.
+		Wide y0o, y2o, y1o, y3o, y4o, y5o;
+		IdctRotate(rows[7], rows[3], IdctConstant(f2f(-1.961570560f) + f2f(0.298631336f), f2f(-1.961570560f)),
+		           IdctConstant(f2f(-1.961570560f), f2f(-1.961570560f) + f2f(3.072711026f)), y0o, y2o);
+		IdctRotate(rows[5], rows[1], IdctConstant(f2f(-0.390180644f) + f2f(2.053119869f), f2f(-0.390180644f)),
+		           IdctConstant(f2f(-0.390180644f), f2f(-0.390180644f) + f2f(1.501321110f)), y1o, y3o);
+		IdctRotate(_mm256_add_epi16(rows[1], rows[7]), _mm256_add_epi16(rows[3], rows[5]),
+		           IdctConstant(f2f(1.175875602f) + f2f(-0.899976223f), f2f(1.175875602f)),
+		           IdctConstant(f2f(1.175875602f), f2f(1.175875602f) + f2f(-2.562915447f)), y4o, y5o);
+		Wide x4 = IdctAdd(y0o, y4o);
+		Wide x5 = IdctAdd(y1o, y5o);
+		Wide x6 = IdctAdd(y2o, y5o);
+		Wide x7 = IdctAdd(y3o, y4o);
+
+		IdctButterfly<Shift>(x0, x7, bias, rows[0], rows[7]);
+		IdctButterfly<Shift>(x1, x6, bias, rows[1], rows[6]);
+		IdctButterfly<Shift>(x2, x5, bias, rows[2], rows[5]);
+		IdctButterfly<Shift>(x3, x4, bias, rows[3], rows[4]);
+	}
+
+	JPEG_DECODER_AVX2
+	static void StoreRowPair(__m256i rows, unsigned char* outA, size_t strideA, unsigned char* outB, size_t strideB)
+	{
+		__m128i a = _mm256_castsi256_si128(rows);
+		__m128i b = _mm256_extracti128_si256(rows, 1);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(outA), a);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(outA + strideA), _mm_unpackhi_epi64(a, a));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(outB), b);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(outB + strideB), _mm_unpackhi_epi64(b, b));
+	}
+
+	// Two blocks of 32-byte aligned coefficients, which may belong to different components.
+	JPEG_DECODER_AVX2
+	static void IdctBlockPair(const int16_t* coeffsA, unsigned char* outA, size_t strideA, const int16_t* coeffsB,
+	                          unsigned char* outB, size_t strideB)
+	{
+		__m256i rows[8];
+		for (int i = 0; i < 8; i++)
+		{
+			__m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(coeffsA + i * 8));
+			__m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(coeffsB + i * 8));
+			rows[i] = _mm256_inserti128_si256(_mm256_castsi128_si256(a), b, 1);
+		}
+
+		// Columns, keeping two extra bits of precision, then a transpose and the rows, which also remove
+		// the 1 << 17 scale and add the 128 level shift.
+		IdctPass<10>(rows, _mm256_set1_epi32(512));
+
+		Interleave16(rows[0], rows[4]);
+		Interleave16(rows[1], rows[5]);
+		Interleave16(rows[2], rows[6]);
+		Interleave16(rows[3], rows[7]);
+		Interleave16(rows[0], rows[2]);
+		Interleave16(rows[1], rows[3]);
+		Interleave16(rows[4], rows[6]);
+		Interleave16(rows[5], rows[7]);
+		Interleave16(rows[0], rows[1]);
+		Interleave16(rows[2], rows[3]);
+		Interleave16(rows[4], rows[5]);
+		Interleave16(rows[6], rows[7]);
+
+		IdctPass<17>(rows, _mm256_set1_epi32(65536 + (128 << 17)));
+
+		__m256i p0 = _mm256_packus_epi16(rows[0], rows[1]);
+		__m256i p1 = _mm256_packus_epi16(rows[2], rows[3]);
+		__m256i p2 = _mm256_packus_epi16(rows[4], rows[5]);
+		__m256i p3 = _mm256_packus_epi16(rows[6], rows[7]);
+		Interleave8(p0, p2);
+		Interleave8(p1, p3);
+		Interleave8(p0, p1);
+		Interleave8(p2, p3);
+		Interleave8(p0, p2);
+		Interleave8(p1, p3);
+
+		StoreRowPair(p0, outA, strideA, outB, strideB);
+		StoreRowPair(p2, outA + 2 * strideA, strideA, outB + 2 * strideB, strideB);
+		StoreRowPair(p1, outA + 4 * strideA, strideA, outB + 4 * strideB, strideB);
+		StoreRowPair(p3, outA + 6 * strideA, strideA, outB + 6 * strideB, strideB);
+	}
+
+	// Scaled 1-D IDCTs for N = 8, 4, 2 and 1 samples, in 12-bit fixed point, by [frequency][output sample]:
+	// C(u) / 2 times the mean of cos((2k + 1) u pi / 16) over the 8 / N full-size samples k that output sample
+	// x covers (C(0) is 1 / sqrt(2), otherwise 1), zero past N. N = 8 is the plain IDCT; for the smaller N every
+	// frequency still counts, so a block comes out as its full-size IDCT box-filtered down to N samples,
+	// without computing that IDCT.
+	alignas(32) static constexpr int32_t SCALED_IDCT[4][8][8] = {
+		{{1448, 1448, 1448, 1448, 1448, 1448, 1448, 1448},
+		 {2009, 1703, 1138, 400, -400, -1138, -1703, -2009},
+		 {1892, 784, -784, -1892, -1892, -784, 784, 1892},
+		 {1703, -400, -2009, -1138, 1138, 2009, 400, -1703},
+		 {1448, -1448, -1448, 1448, 1448, -1448, -1448, 1448},
+		 {1138, -2009, 400, 1703, -1703, -400, 2009, -1138},
+		 {784, -1892, 1892, -784, -784, 1892, -1892, 784},
+		 {400, -1138, 1703, -2009, 2009, -1703, 1138, -400}},
+		{{1448, 1448, 1448, 1448, 0, 0, 0, 0},
+		 {1856, 769, -769, -1856, 0, 0, 0, 0},
+		 {1338, -1338, -1338, 1338, 0, 0, 0, 0},
+		 {652, -1573, 1573, -652, 0, 0, 0, 0},
+		 {0, 0, 0, 0, 0, 0, 0, 0},
+		 {-435, 1051, -1051, 435, 0, 0, 0, 0},
+		 {-554, 554, 554, -554, 0, 0, 0, 0},
+		 {-369, -153, 153, 369, 0, 0, 0, 0}},
+		{{1448, 1448, 0, 0, 0, 0, 0, 0},
+		 {1312, -1312, 0, 0, 0, 0, 0, 0},
+		 {0, 0, 0, 0, 0, 0, 0, 0},
+		 {-461, 461, 0, 0, 0, 0, 0, 0},
+		 {0, 0, 0, 0, 0, 0, 0, 0},
+		 {308, -308, 0, 0, 0, 0, 0, 0},
+		 {0, 0, 0, 0, 0, 0, 0, 0},
+		 {-261, 261, 0, 0, 0, 0, 0, 0}},
+		{{1448, 0, 0, 0, 0, 0, 0, 0},
+		 {0, 0, 0, 0, 0, 0, 0, 0},
+		 {0, 0, 0, 0, 0, 0, 0, 0},
+		 {0, 0, 0, 0, 0, 0, 0, 0},
+		 {0, 0, 0, 0, 0, 0, 0, 0},
+		 {0, 0, 0, 0, 0, 0, 0, 0},
+		 {0, 0, 0, 0, 0, 0, 0, 0},
+		 {0, 0, 0, 0, 0, 0, 0, 0}}};
+
+	// A block decoded straight to width x height samples (each 8, 4, 2 or 1) with the scaled IDCTs. Used for
+	// the reduced scales, where chroma blocks are also decoded at the output resolution instead of being
+	// upsampled. Every 32-bit lane holds one frequency in the column pass and one output sample in the row
+	// pass; out-of-range coefficients in a corrupt file wrap instead of overflowing.
+	JPEG_DECODER_AVX2
+	static void IdctScaledBlock(const int16_t* coeffs, int width, int height, unsigned char* out, size_t stride)
+	{
+		const int32_t* vertical = &SCALED_IDCT[std::countr_zero(8u / height)][0][0];
+		const int32_t* horizontal = &SCALED_IDCT[std::countr_zero(8u / width)][0][0];
+
+		__m256i rows[8];
+		for (int v = 0; v < 8; v++)
+			rows[v] = _mm256_cvtepi16_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(coeffs + v * 8)));
+
+		for (int y = 0; y < height; y++)
+		{
+			// Columns, keeping two extra bits of precision for the rows.
+			__m256i column = _mm256_set1_epi32(512);
+			for (int v = 0; v < 8; v++)
+				column = _mm256_add_epi32(column, _mm256_mullo_epi32(rows[v], _mm256_set1_epi32(vertical[v * 8 + y])));
+			column = _mm256_srai_epi32(column, 10);
+
+			// Rows, with the level shift.
+			__m256i samples = _mm256_set1_epi32((1 << 13) + (128 << 14));
+			for (int u = 0; u < 8; u++)
+			{
+				__m256i frequency = _mm256_permutevar8x32_epi32(column, _mm256_set1_epi32(u));
+				__m256i kernel = _mm256_load_si256(reinterpret_cast<const __m256i*>(horizontal + u * 8));
+				samples = _mm256_add_epi32(samples, _mm256_mullo_epi32(frequency, kernel));
+			}
+			samples = _mm256_srai_epi32(samples, 14);
+			__m128i words = _mm_packs_epi32(_mm256_castsi256_si128(samples), _mm256_extracti128_si256(samples, 1));
+			alignas(8) unsigned char bytes[8];
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(bytes), _mm_packus_epi16(words, words));
+			memcpy(out + y * stride, bytes, width);
+		}
+	}
+
+	// Eight vertically filtered chroma samples from i on, scaled by 4: 3 * near + far, or 4 * near.
+	JPEG_DECODER_AVX2
+	static __m128i VerticalChroma8(const unsigned char* nearRow, const unsigned char* farRow, int vs, int i)
+	{
+		__m128i nearSamples = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(nearRow + i)));
+		if (vs == 1)
+			return _mm_slli_epi16(nearSamples, 2);
+		__m128i farSamples = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(farRow + i)));
+		return _mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(nearSamples, 1), nearSamples), farSamples);
+	}
+
+	// Upsampled chroma for output samples x..x+15 as 16-bit values. With hs == 2 the samples on both sides
+	// must exist: x / 2 >= 1 and x / 2 + 8 < the chroma width.
+	JPEG_DECODER_AVX2
+	static __m256i UpsampleChroma16(const unsigned char* nearRow, const unsigned char* farRow, int hs, int vs, int x)
+	{
+		const __m128i rounding = _mm_set1_epi16(8);
+		if (hs == 1)
+		{
+			__m128i low = VerticalChroma8(nearRow, farRow, vs, x);
+			__m128i high = VerticalChroma8(nearRow, farRow, vs, x + 8);
+			low = _mm_srli_epi16(_mm_add_epi16(_mm_slli_epi16(low, 2), rounding), 4);
+			high = _mm_srli_epi16(_mm_add_epi16(_mm_slli_epi16(high, 2), rounding), 4);
+			return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+		}
+
+		int i = x >> 1;
+		__m128i previous = VerticalChroma8(nearRow, farRow, vs, i - 1);
+		__m128i center = VerticalChroma8(nearRow, farRow, vs, i);
+		__m128i next = VerticalChroma8(nearRow, farRow, vs, i + 1);
+		__m128i center3 = _mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(center, 1), center), rounding);
+		__m128i even = _mm_srli_epi16(_mm_add_epi16(center3, previous), 4);
+		__m128i odd = _mm_srli_epi16(_mm_add_epi16(center3, next), 4);
+		return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(even, odd)),
+		                               _mm_unpackhi_epi16(even, odd), 1);
+	}
+
+	// YCbCrToRgbaPixel for 16 pixels. Divided through by 256 the same formula is
+	// (y * 4096 + c * k + 2048) >> 12, and a 16-bit multiply-add of (y, c) pairs gives it exactly.
+	JPEG_DECODER_AVX2
+	static void YCbCrToRgba16(__m256i y, __m256i cb, __m256i cr, unsigned char* dst)
+	{
+		const __m256i chromaBias = _mm256_set1_epi16(128);
+		const __m256i rounding = _mm256_set1_epi32(2048);
+		const __m256i toRed = IdctConstant(4096, static_cast<int>(1.40200f * 4096.0f + 0.5f));
+		const __m256i toGreen = IdctConstant(4096, -static_cast<int>(0.71414f * 4096.0f + 0.5f));
+		const __m256i cbToGreen = IdctConstant(-static_cast<int>(0.34414f * 4096.0f + 0.5f), 0);
+		const __m256i toBlue = IdctConstant(4096, static_cast<int>(1.77200f * 4096.0f + 0.5f));
+		const __m256i truncate = _mm256_set1_epi32(~0xFF);
+
+		cb = _mm256_sub_epi16(cb, chromaBias);
+		cr = _mm256_sub_epi16(cr, chromaBias);
+		__m256i yCrLow = _mm256_unpacklo_epi16(y, cr);
+		__m256i yCrHigh = _mm256_unpackhi_epi16(y, cr);
+		__m256i yCbLow = _mm256_unpacklo_epi16(y, cb);
+		__m256i yCbHigh = _mm256_unpackhi_epi16(y, cb);
+		__m256i cbLow = _mm256_unpacklo_epi16(cb, _mm256_setzero_si256());
+		__m256i cbHigh = _mm256_unpackhi_epi16(cb, _mm256_setzero_si256());
+
+		__m256i redLow = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yCrLow, toRed), rounding), 12);
+		__m256i redHigh = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yCrHigh, toRed), rounding), 12);
+		__m256i greenLow = _mm256_add_epi32(_mm256_madd_epi16(yCrLow, toGreen),
+		                                    _mm256_and_si256(_mm256_madd_epi16(cbLow, cbToGreen), truncate));
+		__m256i greenHigh = _mm256_add_epi32(_mm256_madd_epi16(yCrHigh, toGreen),
+		                                     _mm256_and_si256(_mm256_madd_epi16(cbHigh, cbToGreen), truncate));
+		greenLow = _mm256_srai_epi32(_mm256_add_epi32(greenLow, rounding), 12);
+		greenHigh = _mm256_srai_epi32(_mm256_add_epi32(greenHigh, rounding), 12);
+		__m256i blueLow = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yCbLow, toBlue), rounding), 12);
+		__m256i blueHigh = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yCbHigh, toBlue), rounding), 12);
+
+		// Unpack and pack both work within lanes, so the lanes come back in pixel order: 0-7 and 8-15.
+		__m256i red = _mm256_packs_epi32(redLow, redHigh);
+		__m256i green = _mm256_packs_epi32(greenLow, greenHigh);
+		__m256i blue = _mm256_packs_epi32(blueLow, blueHigh);
+		__m256i redBlue = _mm256_packus_epi16(red, blue);
+		__m256i greenAlpha = _mm256_packus_epi16(green, _mm256_set1_epi16(255));
+		__m256i redGreen = _mm256_unpacklo_epi8(redBlue, greenAlpha);
+		__m256i blueAlpha = _mm256_unpackhi_epi8(redBlue, greenAlpha);
+		__m256i pixels0 = _mm256_unpacklo_epi16(redGreen, blueAlpha); // 0-3 | 8-11
+		__m256i pixels1 = _mm256_unpackhi_epi16(redGreen, blueAlpha); // 4-7 | 12-15
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_permute2x128_si256(pixels0, pixels1, 0x20));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 32), _mm256_permute2x128_si256(pixels0, pixels1, 0x31));
+	}
+
+	JPEG_DECODER_AVX2
+	static void YCbCrRowToRgba(const unsigned char* y, const ChromaRows& chroma, unsigned char* dst, int width)
+	{
+		int x = 0;
+		for (; x + 16 <= width; x += 16)
+		{
+			__m256i luma = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x)));
+			__m256i cb, cr;
+			if (chroma.Hs == 1 || (x > 0 && (x >> 1) + 8 < chroma.Width))
+			{
+				cb = UpsampleChroma16(chroma.CbNear, chroma.CbFar, chroma.Hs, chroma.Vs, x);
+				cr = UpsampleChroma16(chroma.CrNear, chroma.CrFar, chroma.Hs, chroma.Vs, x);
+			}
+			else
+			{
+				alignas(32) int16_t cbSamples[16];
+				alignas(32) int16_t crSamples[16];
+				for (int i = 0; i < 16; i++)
+				{
+					cbSamples[i] = static_cast<int16_t>(
+						UpsampleChroma(chroma.CbNear, chroma.CbFar, chroma.Hs, chroma.Vs, chroma.Width, x + i));
+					crSamples[i] = static_cast<int16_t>(
+						UpsampleChroma(chroma.CrNear, chroma.CrFar, chroma.Hs, chroma.Vs, chroma.Width, x + i));
+				}
+				cb = _mm256_load_si256(reinterpret_cast<const __m256i*>(cbSamples));
+				cr = _mm256_load_si256(reinterpret_cast<const __m256i*>(crSamples));
+			}
+			YCbCrToRgba16(luma, cb, cr, dst + x * 4);
+		}
+		YCbCrRowToRgbaReference(y, chroma, dst, x, width);
+	}
+#endif
+
+	// Output rows of one row of MCUs.
+	static void EmitStrip(const JpegFile& file, int strip, bool isRgb, unsigned char* dst, size_t dstRowPitch)
+	{
+		const JpegInfo& info = file.Info;
+		int stripHeight = file.BlockSize * file.VMax;
+		int endRow = (strip + 1) * stripHeight < file.OutHeight ? (strip + 1) * stripHeight : file.OutHeight;
+
+		// Row of a component by its index in the whole image, as long as it is in this strip, the row just
+		// above it, or the first row of the next one.
+		auto componentRow = [strip](const Component& component, int row) -> const unsigned char*
+		{
+			int local = row - strip * component.StripRows;
+			if (local >= component.StripRows)
+				return component.Strips[(strip + 1) & 1] + static_cast<size_t>(local - component.StripRows) * component.Stride;
+			return component.Strips[strip & 1] + static_cast<ptrdiff_t>(local) * static_cast<ptrdiff_t>(component.Stride);
+		};
+		// Output row j between the chroma row it falls in and the one on its side (stb_image's line0/line1).
+		auto nearFarRows = [&](const Component& component, int j, const unsigned char** out_near,
+		                       const unsigned char** out_far)
+		{
+			int nearRow = j / component.Vs;
+			int farRow = nearRow;
+			if (component.Vs == 2)
+				farRow = (j & 1) ? (nearRow + 1 < component.Rows ? nearRow + 1 : nearRow) : (nearRow > 0 ? nearRow - 1 : 0);
+			*out_near = componentRow(component, nearRow);
+			*out_far = componentRow(component, farRow);
+		};
+
+		for (int j = strip * stripHeight; j < endRow; j++)
+		{
+			unsigned char* dstRow = dst + j * dstRowPitch;
+			const unsigned char* luma = componentRow(file.Components[0], j);
+			if (info.Components == 1)
+			{
+				PixelConvert::GrayToRgba(luma, dstRow, file.OutWidth);
+				continue;
+			}
+
+			ChromaRows chroma;
+			const Component& cb = file.Components[1];
+			nearFarRows(cb, j, &chroma.CbNear, &chroma.CbFar);
+			nearFarRows(file.Components[2], j, &chroma.CrNear, &chroma.CrFar);
+			chroma.Hs = cb.Hs;
+			chroma.Vs = cb.Vs;
+			chroma.Width = cb.Width;
+
+			if (isRgb)
+			{
+				// Files that store RGB as is; rare enough for the scalar path.
+				for (int x = 0; x < file.OutWidth; x++)
+				{
+					dstRow[x * 4 + 0] = luma[x];
+					dstRow[x * 4 + 1] = static_cast<unsigned char>(
+						UpsampleChroma(chroma.CbNear, chroma.CbFar, chroma.Hs, chroma.Vs, chroma.Width, x));
+					dstRow[x * 4 + 2] = static_cast<unsigned char>(
+						UpsampleChroma(chroma.CrNear, chroma.CrFar, chroma.Hs, chroma.Vs, chroma.Width, x));
+					dstRow[x * 4 + 3] = 255;
+				}
+				continue;
+			}
+#ifdef JPEG_DECODER_X86
+			YCbCrRowToRgba(luma, chroma, dstRow, file.OutWidth);
+#else
+			YCbCrRowToRgbaReference(luma, chroma, dstRow, 0, file.OutWidth);
+#endif
+		}
+	}
+
+	bool ReadInfo(const unsigned char* data, size_t size, JpegInfo* out_info)
+	{
+		if (size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+			return false;
+
+		size_t pos = 2;
+		int marker = 0;
+		while (ReadMarker(data, size, pos, &marker))
+		{
+			if (IsStandaloneMarker(marker))
+				continue;
+			const unsigned char* payload = nullptr;
+			size_t length = 0;
+			if (marker == 0xDA || marker == 0xD9 || !ReadSegment(data, size, pos, &payload, &length))
+				return false;
+			if (IsFrameMarker(marker))
+				return ParseFrame(payload, length, marker, *out_info, nullptr);
+		}
+		return false;
+	}
+
+	bool IsSupported(const JpegInfo& info)
+	{
+#ifdef JPEG_DECODER_X86
+		if (!Cpu::GetFeatures().Avx2 || !info.Sequential || info.Precision != 8)
+			return false;
+		if (info.Components == 1)
+			return true;
+		if (info.Components != 3)
+			return false;
+
+		// Luma at full resolution, both chroma planes alike at full or half resolution on each axis.
+		int h = info.SamplingH[0];
+		int v = info.SamplingV[0];
+		return h <= 2 && v <= 2 && info.SamplingH[1] == info.SamplingH[2] && info.SamplingV[1] == info.SamplingV[2] &&
+			h % info.SamplingH[1] == 0 && v % info.SamplingV[1] == 0;
+#else
+		(void)info;
+		return false;
+#endif
+	}
+
+	int GetScaledSize(int size, int scaleShift)
+	{
+		return (size + (1 << scaleShift) - 1) >> scaleShift;
+	}
+
+	bool Decode(const unsigned char* data, size_t size, unsigned char* dst, size_t dstRowPitch, int scaleShift)
+	{
+#ifdef JPEG_DECODER_X86
+		if (scaleShift < 0 || scaleShift > MAX_SCALE_SHIFT)
+			return false;
+		auto file = std::make_unique<JpegFile>();
+		if (!ParseFile(data, size, *file))
+			return false;
+
+		const JpegInfo& info = file->Info;
+		int blockSize = 8 >> scaleShift;
+		file->BlockSize = blockSize;
+		file->OutWidth = GetScaledSize(info.Width, scaleShift);
+		file->OutHeight = GetScaledSize(info.Height, scaleShift);
+		int numComponents = info.Components;
+		int mcusPerLine = 0;
+		int mcuRows = 0;
+		if (numComponents == 1)
+		{
+			// A single-component scan is not interleaved: its MCU is one block, whatever the sampling factors.
+			Component& gray = file->Components[0];
+			gray.H = gray.V = 1;
+			mcusPerLine = (info.Width + 7) / 8;
+			mcuRows = (info.Height + 7) / 8;
+		}
+		else
+		{
+			file->HMax = info.SamplingH[0];
+			file->VMax = info.SamplingV[0];
+			mcusPerLine = (info.Width + 8 * file->HMax - 1) / (8 * file->HMax);
+			mcuRows = (info.Height + 8 * file->VMax - 1) / (8 * file->VMax);
+		}
+
+		// Both strips of every component live in one buffer. Each strip has a row above it for the upsampling
+		// filter, and the buffer some slack after the last one for 8-byte loads at the end of a row.
+		size_t bufferSize = 64;
+		for (int c = 0; c < numComponents; c++)
+		{
+			Component& component = file->Components[c];
+			component.Hs = file->HMax / component.H;
+			component.Vs = file->VMax / component.V;
+			if (scaleShift > 0)
+			{
+				// Subsampled chroma at a reduced scale: the IDCT produces it at the output resolution, which
+				// is sharper than upsampling and leaves EmitStrip nothing to filter.
+				component.BlockWidth = blockSize * component.Hs;
+				component.BlockHeight = blockSize * component.Vs;
+				component.Hs = component.Vs = 1;
+			}
+			component.Width = (file->OutWidth + component.Hs - 1) / component.Hs;
+			component.Rows = (file->OutHeight + component.Vs - 1) / component.Vs;
+			component.BlocksPerLine = mcusPerLine * component.H;
+			component.StripRows = component.BlockHeight * component.V;
+			component.Stride = static_cast<size_t>(component.BlocksPerLine) * component.BlockWidth;
+			bufferSize += 2 * (component.StripRows + 1) * component.Stride;
+		}
+		// Failing to allocate it fails the decode, and the caller falls back to stb_image.
+		std::unique_ptr<unsigned char[]> buffer(new (std::nothrow) unsigned char[bufferSize]());
+		if (buffer == nullptr)
+			return false;
+		size_t offset = 0;
+		for (int c = 0; c < numComponents; c++)
+		{
+			Component& component = file->Components[c];
+			for (unsigned char*& strip : component.Strips)
+			{
+				strip = buffer.get() + offset + component.Stride;
+				offset += (component.StripRows + 1) * component.Stride;
+			}
+		}
+
+		bool isRgb = numComponents == 3 &&
+			((file->Components[0].Id == 'R' && file->Components[1].Id == 'G' && file->Components[2].Id == 'B') ||
+			 (file->AdobeTransform == 0 && !file->Jfif));
+
+		BitReader reader;
+		reader.In = file->ScanData;
+		reader.End = file->DataEnd;
+
+		struct PendingBlock
+		{
+			const int16_t* Coeffs;
+			unsigned char* Out;
+			size_t Stride;
+		};
+		alignas(32) int16_t coeffs[MAX_BLOCKS_PER_MCU][64];
+		PendingBlock pending[MAX_BLOCKS_PER_MCU];
+		alignas(32) int16_t carriedCoeffs[64];
+		PendingBlock carry = {};
+		bool hasCarry = false;
+
+		int restartsLeft = file->RestartInterval;
+		for (int mcuY = 0; mcuY < mcuRows; mcuY++)
+		{
+			int slot = mcuY & 1;
+			if (mcuY > 0)
+			{
+				for (int c = 0; c < numComponents; c++)
+				{
+					Component& component = file->Components[c];
+					memcpy(component.Strips[slot] - component.Stride,
+					       component.Strips[slot ^ 1] + (component.StripRows - 1) * component.Stride, component.Stride);
+				}
+			}
+
+			for (int mcuX = 0; mcuX < mcusPerLine; mcuX++)
+			{
+				if (file->RestartInterval > 0)
+				{
+					if (restartsLeft == 0)
+					{
+						if (!reader.Restart())
+							return false;
+						for (int c = 0; c < numComponents; c++)
+							file->Components[c].DcPrediction = 0;
+						restartsLeft = file->RestartInterval;
+					}
+					restartsLeft--;
+				}
+
+				int numBlocks = 0;
+				int numPending = 0;
+				for (int i = 0; i < numComponents; i++)
+				{
+					Component& component = file->Components[file->ScanOrder[i]];
+					for (int by = 0; by < component.V; by++)
+					{
+						for (int bx = 0; bx < component.H; bx++)
+						{
+							int16_t* block = coeffs[numBlocks++];
+							bool hasAc = false;
+							if (!DecodeBlock(reader, *file, component, block, &hasAc))
+								return false;
+							int blockWidth = component.BlockWidth;
+							int blockHeight = component.BlockHeight;
+							unsigned char* out = component.Strips[slot] + by * blockHeight * component.Stride +
+								(mcuX * component.H + bx) * blockWidth;
+							if (hasAc && blockWidth == 8 && blockHeight == 8)
+								pending[numPending++] = {block, out, component.Stride};
+							else if (hasAc && blockWidth * blockHeight > 1)
+								IdctScaledBlock(block, blockWidth, blockHeight, out, component.Stride);
+							else
+								FillDcBlock(block[0], out, component.Stride, blockWidth, blockHeight);
+						}
+					}
+				}
+
+				// Blocks go through the IDCT in pairs; an odd one out waits for the next MCU.
+				int i = 0;
+				if (hasCarry && numPending > 0)
+				{
+					IdctBlockPair(carry.Coeffs, carry.Out, carry.Stride, pending[0].Coeffs, pending[0].Out,
+					              pending[0].Stride);
+					hasCarry = false;
+					i = 1;
+				}
+				for (; i + 1 < numPending; i += 2)
+					IdctBlockPair(pending[i].Coeffs, pending[i].Out, pending[i].Stride, pending[i + 1].Coeffs,
+					              pending[i + 1].Out, pending[i + 1].Stride);
+				if (i < numPending)
+				{
+					memcpy(carriedCoeffs, pending[i].Coeffs, sizeof(carriedCoeffs));
+					carry = {carriedCoeffs, pending[i].Out, pending[i].Stride};
+					hasCarry = true;
+				}
+			}
+			if (hasCarry)
+			{
+				// Nothing left to pair it with: the other lane repeats it into scratch space.
+				alignas(8) unsigned char scratch[64];
+				IdctBlockPair(carry.Coeffs, carry.Out, carry.Stride, carry.Coeffs, scratch, 8);
+				hasCarry = false;
+			}
+
+			if (mcuY > 0)
+				EmitStrip(*file, mcuY - 1, isRgb, dst, dstRowPitch);
+		}
+		EmitStrip(*file, mcuRows - 1, isRgb, dst, dstRowPitch);
+		return true;
+#else
+		(void)data;
+		(void)size;
+		(void)dst;
+		(void)dstRowPitch;
+		(void)scaleShift;
+		return false;
+#endif
+	}
+}
@@ -0,0 +1,171 @@
+#include "image/MipGenerator.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_GENERATOR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace MipGenerator
+{
+	int GetMipLevelCount(int width, int height)
+	{
+		int levels = 1;
+		while (width > 1 || height > 1)
+		{
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+			levels++;
+		}
+		return levels;
+	}
+
+	static void DownsampleRowScalar(
+		const unsigned char* row0,
+		const unsigned char* row1,
+		int srcWidth,
+		int firstX,
+		int dstWidth,
+		unsigned char* dst)
+	{
+		for (int x = firstX; x < dstWidth; x++)
+		{
+			int x0 = x * 2;
+			int x1 = std::min(x0 + 1, srcWidth - 1);
+			for (int c = 0; c < 4; c++)
+			{
+				unsigned int sum = row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c];
+				dst[x * 4 + c] = static_cast<unsigned char>((sum + 2) >> 2);
+			}
+		}
+	}
+
+	void DownsampleBoxReference(
+		const unsigned char* src,
+		int srcWidth,
+		int srcHeight,
+		size_t srcRowPitch,
+		unsigned char* dst,
+		size_t dstRowPitch)
+	{
+		int dstWidth = std::max(1, srcWidth / 2);
+		int dstHeight = std::max(1, srcHeight / 2);
+		for (int y = 0; y < dstHeight; y++)
+		{
+			int y0 = y * 2;
+			int y1 = std::min(y0 + 1, srcHeight - 1);
+			DownsampleRowScalar(src + y0 * srcRowPitch, src + y1 * srcRowPitch, srcWidth, 0, dstWidth,
+			                    dst + y * dstRowPitch);
+		}
+	}
+
+#ifdef MIP_GENERATOR_SSE2
+	// Four output pixels from eight source pixels of each row.
+	static int DownsampleRowSse2(const unsigned char* row0, const unsigned char* row1, int dstWidth, unsigned char* dst)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i rounding = _mm_set1_epi16(2);
+
+		int x = 0;
+		for (; x + 4 <= dstWidth; x += 4)
+		{
+			__m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+			__m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8 + 16));
+			__m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+			__m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8 + 16));
+
+			// Vertical sums, one 16-bit lane per channel: p0 p1 | p2 p3 | p4 p5 | p6 p7
+			__m128i v01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+			__m128i v23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+			__m128i v45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+			__m128i v67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+			// Horizontal pairs end up in the low half of each register.
+			__m128i h0 = _mm_add_epi16(v01, _mm_srli_si128(v01, 8));
+			__m128i h1 = _mm_add_epi16(v23, _mm_srli_si128(v23, 8));
+			__m128i h2 = _mm_add_epi16(v45, _mm_srli_si128(v45, 8));
+			__m128i h3 = _mm_add_epi16(v67, _mm_srli_si128(v67, 8));
+
+			__m128i out01 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(h0, h1), rounding), 2);
+			__m128i out23 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(h2, h3), rounding), 2);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packus_epi16(out01, out23));
+		}
+		return x;
+	}
+#endif
+
+	void DownsampleBox(
+		const unsigned char* src,
+		int srcWidth,
+		int srcHeight,
+		size_t srcRowPitch,
+		unsigned char* dst,
+		size_t dstRowPitch)
+	{
+		int dstWidth = std::max(1, srcWidth / 2);
+		int dstHeight = std::max(1, srcHeight / 2);
+		for (int y = 0; y < dstHeight; y++)
+		{
+			int y0 = y * 2;
+			int y1 = std::min(y0 + 1, srcHeight - 1);
+			const unsigned char* row0 = src + y0 * srcRowPitch;
+			const unsigned char* row1 = src + y1 * srcRowPitch;
+			unsigned char* dstRow = dst + y * dstRowPitch;
+
+			int x = 0;
+#ifdef MIP_GENERATOR_SSE2
+			// Every output pixel reads two full source pixels as long as the source is at least 2 wide.
+			if (srcWidth >= 2)
+				x = DownsampleRowSse2(row0, row1, dstWidth, dstRow);
+#endif
+			DownsampleRowScalar(row0, row1, srcWidth, x, dstWidth, dstRow);
+		}
+	}
+
+	size_t GetMipChainSize(int width, int height)
+	{
+		size_t mipBytes = 0;
+		while (width > 1 || height > 1)
+		{
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+			mipBytes += static_cast<size_t>(width) * height * 4;
+		}
+		return mipBytes;
+	}
+
+	void FillMipChain(const unsigned char* base, int width, int height, size_t rowPitch, unsigned char* mipData)
+	{
+		const unsigned char* src = base;
+		size_t srcRowPitch = rowPitch;
+		unsigned char* dst = mipData;
+		while (width > 1 || height > 1)
+		{
+			int dstWidth = std::max(1, width / 2);
+			int dstHeight = std::max(1, height / 2);
+			DownsampleBox(src, width, height, srcRowPitch, dst, static_cast<size_t>(dstWidth) * 4);
+
+			src = dst;
+			srcRowPitch = static_cast<size_t>(dstWidth) * 4;
+			dst += static_cast<size_t>(dstWidth) * dstHeight * 4;
+			width = dstWidth;
+			height = dstHeight;
+		}
+	}
+
+	bool GenerateMipChain(DecodedImage& image)
+	{
+		if (image.Pixels == nullptr)
+			return false;
+		// Block-compressed images keep the chain their file came with.
+		if (TextureFormats::IsBlockCompressed(image.Format))
+			return true;
+
+		image.MipData.resize(GetMipChainSize(image.Width, image.Height));
+		FillMipChain(image.Pixels, image.Width, image.Height, image.GetRowPitch(), image.MipData.data());
+		image.MipLevels = GetMipLevelCount(image.Width, image.Height);
+		return true;
+	}
+}
@@ -0,0 +1,435 @@
+#include "image/PixelConvert.h"
+#include "core/CpuFeatures.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PIXEL_CONVERT_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define PIXEL_CONVERT_NEON
+#include <arm_neon.h>
+#endif
+
+// GCC and Clang only emit SSSE3/AVX2 instructions in functions that ask for them; MSVC always does.
+#if defined(__GNUC__) || defined(__clang__)
+#define PIXEL_CONVERT_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PIXEL_CONVERT_TARGET(isa)
+#endif
+
+namespace PixelConvert
+{
+	void RgbToRgbaReference(const uint8_t* src, uint8_t* dst, int width)
+	{
+		for (int x = 0; x < width; x++, src += 3, dst += 4)
+		{
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = src[2];
+			dst[3] = 255;
+		}
+	}
+
+	void BgrToRgbaReference(const uint8_t* src, uint8_t* dst, int width)
+	{
+		for (int x = 0; x < width; x++, src += 3, dst += 4)
+		{
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = src[0];
+			dst[3] = 255;
+		}
+	}
+
+	void BgraToRgbaReference(const uint8_t* src, uint8_t* dst, int width)
+	{
+		for (int x = 0; x < width; x++, src += 4, dst += 4)
+		{
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = src[0];
+			dst[3] = src[3];
+		}
+	}
+
+	void GrayToRgbaReference(const uint8_t* src, uint8_t* dst, int width)
+	{
+		for (int x = 0; x < width; x++, src += 1, dst += 4)
+		{
+			dst[0] = dst[1] = dst[2] = src[0];
+			dst[3] = 255;
+		}
+	}
+
+	void GrayAlphaToRgbaReference(const uint8_t* src, uint8_t* dst, int width)
+	{
+		for (int x = 0; x < width; x++, src += 2, dst += 4)
+		{
+			dst[0] = dst[1] = dst[2] = src[0];
+			dst[3] = src[1];
+		}
+	}
+
+	using RowFn = void (*)(const uint8_t* src, uint8_t* dst, int width);
+
+#ifdef PIXEL_CONVERT_X86
+	// Each SIMD kernel converts the largest multiple of its block size and leaves the tail to the reference.
+
+	PIXEL_CONVERT_TARGET("sse2")
+	static void GrayToRgbaSse2(const uint8_t* src, uint8_t* dst, int width)
+	{
+		const __m128i alpha = _mm_set1_epi8(static_cast<char>(0xFF));
+		int x = 0;
+		for (; x + 16 <= width; x += 16)
+		{
+			__m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+			__m128i gg0 = _mm_unpacklo_epi8(g, g);
+			__m128i gg1 = _mm_unpackhi_epi8(g, g);
+			__m128i ga0 = _mm_unpacklo_epi8(g, alpha);
+			__m128i ga1 = _mm_unpackhi_epi8(g, alpha);
+			__m128i* out = reinterpret_cast<__m128i*>(dst + x * 4);
+			_mm_storeu_si128(out + 0, _mm_unpacklo_epi16(gg0, ga0));
+			_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(gg0, ga0));
+			_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(gg1, ga1));
+			_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(gg1, ga1));
+		}
+		GrayToRgbaReference(src + x, dst + x * 4, width - x);
+	}
+
+	PIXEL_CONVERT_TARGET("sse2")
+	static void GrayAlphaToRgbaSse2(const uint8_t* src, uint8_t* dst, int width)
+	{
+		const __m128i lowByte = _mm_set1_epi16(0x00FF);
+		int x = 0;
+		for (; x + 8 <= width; x += 8)
+		{
+			__m128i ga = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 2));
+			__m128i g = _mm_and_si128(ga, lowByte);
+			__m128i gg = _mm_or_si128(g, _mm_slli_epi16(g, 8));
+			__m128i* out = reinterpret_cast<__m128i*>(dst + x * 4);
+			_mm_storeu_si128(out + 0, _mm_unpacklo_epi16(gg, ga));
+			_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(gg, ga));
+		}
+		GrayAlphaToRgbaReference(src + x * 2, dst + x * 4, width - x);
+	}
+
+	PIXEL_CONVERT_TARGET("sse2")
+	static void BgraToRgbaSse2(const uint8_t* src, uint8_t* dst, int width)
+	{
+		const __m128i greenAlpha = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+		const __m128i lowByte = _mm_set1_epi32(0x000000FF);
+		int x = 0;
+		for (; x + 4 <= width; x += 4)
+		{
+			__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+			__m128i red = _mm_and_si128(_mm_srli_epi32(p, 16), lowByte);
+			__m128i blue = _mm_slli_epi32(_mm_and_si128(p, lowByte), 16);
+			__m128i rgba = _mm_or_si128(_mm_and_si128(p, greenAlpha), _mm_or_si128(red, blue));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), rgba);
+		}
+		BgraToRgbaReference(src + x * 4, dst + x * 4, width - x);
+	}
+
+	// 16 pixels from four 16-byte loads at 0, 12, 24 and 32; the last one takes its pixels from bytes 4..15
+	// so that nothing past the 48 source bytes is read.
+	PIXEL_CONVERT_TARGET("ssse3")
+	static void Rgb24ToRgbaSsse3(const uint8_t* src, uint8_t* dst, int width, __m128i shuffle, __m128i shuffleHigh,
+	                             RowFn tail)
+	{
+		const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+		int x = 0;
+		for (; x + 16 <= width; x += 16)
+		{
+			const uint8_t* s = src + x * 3;
+			__m128i* out = reinterpret_cast<__m128i*>(dst + x * 4);
+			__m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 0));
+			__m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 12));
+			__m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 24));
+			__m128i p3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 32));
+			_mm_storeu_si128(out + 0, _mm_or_si128(_mm_shuffle_epi8(p0, shuffle), alpha));
+			_mm_storeu_si128(out + 1, _mm_or_si128(_mm_shuffle_epi8(p1, shuffle), alpha));
+			_mm_storeu_si128(out + 2, _mm_or_si128(_mm_shuffle_epi8(p2, shuffle), alpha));
+			_mm_storeu_si128(out + 3, _mm_or_si128(_mm_shuffle_epi8(p3, shuffleHigh), alpha));
+		}
+		tail(src + x * 3, dst + x * 4, width - x);
+	}
+
+	PIXEL_CONVERT_TARGET("ssse3")
+	static void RgbToRgbaSsse3(const uint8_t* src, uint8_t* dst, int width)
+	{
+		Rgb24ToRgbaSsse3(src, dst, width, _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1),
+		                 _mm_setr_epi8(4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1),
+		                 RgbToRgbaReference);
+	}
+
+	PIXEL_CONVERT_TARGET("ssse3")
+	static void BgrToRgbaSsse3(const uint8_t* src, uint8_t* dst, int width)
+	{
+		Rgb24ToRgbaSsse3(src, dst, width, _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1),
+		                 _mm_setr_epi8(6, 5, 4, -1, 9, 8, 7, -1, 12, 11, 10, -1, 15, 14, 13, -1),
+		                 BgrToRgbaReference);
+	}
+
+	PIXEL_CONVERT_TARGET("avx2")
+	static void GrayToRgbaAvx2(const uint8_t* src, uint8_t* dst, int width)
+	{
+		const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+		int x = 0;
+		for (; x + 8 <= width; x += 8)
+		{
+			__m256i g = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + x)));
+			__m256i rgba = _mm256_or_si256(_mm256_or_si256(g, _mm256_slli_epi32(g, 8)),
+			                               _mm256_or_si256(_mm256_slli_epi32(g, 16), alpha));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), rgba);
+		}
+		GrayToRgbaReference(src + x, dst + x * 4, width - x);
+	}
+
+	PIXEL_CONVERT_TARGET("avx2")
+	static void GrayAlphaToRgbaAvx2(const uint8_t* src, uint8_t* dst, int width)
+	{
+		const __m256i lowByte = _mm256_set1_epi32(0x000000FF);
+		const __m256i alphaByte = _mm256_set1_epi32(0x0000FF00);
+		int x = 0;
+		for (; x + 8 <= width; x += 8)
+		{
+			// One dword per pixel: g | a << 8.
+			__m256i ga = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 2)));
+			__m256i g = _mm256_and_si256(ga, lowByte);
+			__m256i rgba = _mm256_or_si256(_mm256_or_si256(g, _mm256_slli_epi32(g, 8)),
+			                               _mm256_or_si256(_mm256_slli_epi32(g, 16),
+			                                               _mm256_slli_epi32(_mm256_and_si256(ga, alphaByte), 16)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), rgba);
+		}
+		GrayAlphaToRgbaReference(src + x * 2, dst + x * 4, width - x);
+	}
+
+	PIXEL_CONVERT_TARGET("avx2")
+	static void BgraToRgbaAvx2(const uint8_t* src, uint8_t* dst, int width)
+	{
+		const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+		                                         2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		int x = 0;
+		for (; x + 8 <= width; x += 8)
+		{
+			__m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), _mm256_shuffle_epi8(p, shuffle));
+		}
+		BgraToRgbaReference(src + x * 4, dst + x * 4, width - x);
+	}
+
+	// 32 pixels per iteration: each 256-bit register holds two 4-pixel groups, one per 128-bit lane. The
+	// very last group is loaded from 4 bytes earlier and uses the high shuffle, like the SSSE3 version.
+	PIXEL_CONVERT_TARGET("avx2")
+	static void Rgb24ToRgbaAvx2(const uint8_t* src, uint8_t* dst, int width, __m256i shuffle, __m256i shuffleLast,
+	                            RowFn tail)
+	{
+		const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+		int x = 0;
+		for (; x + 32 <= width; x += 32)
+		{
+			const uint8_t* s = src + x * 3;
+			__m256i* out = reinterpret_cast<__m256i*>(dst + x * 4);
+			for (int i = 0; i < 4; i++)
+			{
+				const uint8_t* group = s + i * 24;
+				__m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+				__m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group + (i == 3 ? 8 : 12)));
+				__m256i p = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+				__m256i rgba = _mm256_shuffle_epi8(p, i == 3 ? shuffleLast : shuffle);
+				_mm256_storeu_si256(out + i, _mm256_or_si256(rgba, alpha));
+			}
+		}
+		tail(src + x * 3, dst + x * 4, width - x);
+	}
+
+	PIXEL_CONVERT_TARGET("avx2")
+	static void RgbToRgbaAvx2(const uint8_t* src, uint8_t* dst, int width)
+	{
+		Rgb24ToRgbaAvx2(src, dst, width,
+		                _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+		                                 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1),
+		                _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+		                                 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1),
+		                RgbToRgbaReference);
+	}
+
+	PIXEL_CONVERT_TARGET("avx2")
+	static void BgrToRgbaAvx2(const uint8_t* src, uint8_t* dst, int width)
+	{
+		Rgb24ToRgbaAvx2(src, dst, width,
+		                _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+		                                 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1),
+		                _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+		                                 6, 5, 4, -1, 9, 8, 7, -1, 12, 11, 10, -1, 15, 14, 13, -1),
+		                BgrToRgbaReference);
+	}
+#endif
+
+#ifdef PIXEL_CONVERT_NEON
+	static void RgbToRgbaNeon(const uint8_t* src, uint8_t* dst, int width)
+	{
+		int x = 0;
+		for (; x + 16 <= width; x += 16)
+		{
+			uint8x16x3_t rgb = vld3q_u8(src + x * 3);
+			uint8x16x4_t rgba = {{rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8(255)}};
+			vst4q_u8(dst + x * 4, rgba);
+		}
+		RgbToRgbaReference(src + x * 3, dst + x * 4, width - x);
+	}
+
+	static void BgrToRgbaNeon(const uint8_t* src, uint8_t* dst, int width)
+	{
+		int x = 0;
+		for (; x + 16 <= width; x += 16)
+		{
+			uint8x16x3_t bgr = vld3q_u8(src + x * 3);
+			uint8x16x4_t rgba = {{bgr.val[2], bgr.val[1], bgr.val[0], vdupq_n_u8(255)}};
+			vst4q_u8(dst + x * 4, rgba);
+		}
+		BgrToRgbaReference(src + x * 3, dst + x * 4, width - x);
+	}
+
+	static void BgraToRgbaNeon(const uint8_t* src, uint8_t* dst, int width)
+	{
+		int x = 0;
+		for (; x + 16 <= width; x += 16)
+		{
+			uint8x16x4_t bgra = vld4q_u8(src + x * 4);
+			uint8x16x4_t rgba = {{bgra.val[2], bgra.val[1], bgra.val[0], bgra.val[3]}};
+			vst4q_u8(dst + x * 4, rgba);
+		}
+		BgraToRgbaReference(src + x * 4, dst + x * 4, width - x);
+	}
+
+	static void GrayToRgbaNeon(const uint8_t* src, uint8_t* dst, int width)
+	{
+		int x = 0;
+		for (; x + 16 <= width; x += 16)
+		{
+			uint8x16_t g = vld1q_u8(src + x);
+			uint8x16x4_t rgba = {{g, g, g, vdupq_n_u8(255)}};
+			vst4q_u8(dst + x * 4, rgba);
+		}
+		GrayToRgbaReference(src + x, dst + x * 4, width - x);
+	}
+
+	static void GrayAlphaToRgbaNeon(const uint8_t* src, uint8_t* dst, int width)
+	{
+		int x = 0;
+		for (; x + 16 <= width; x += 16)
+		{
+			uint8x16x2_t ga = vld2q_u8(src + x * 2);
+			uint8x16x4_t rgba = {{ga.val[0], ga.val[0], ga.val[0], ga.val[1]}};
+			vst4q_u8(dst + x * 4, rgba);
+		}
+		GrayAlphaToRgbaReference(src + x * 2, dst + x * 4, width - x);
+	}
+#endif
+
+	struct Kernels
+	{
+		RowFn Rgb = RgbToRgbaReference;
+		RowFn Bgr = BgrToRgbaReference;
+		RowFn Bgra = BgraToRgbaReference;
+		RowFn Gray = GrayToRgbaReference;
+		RowFn GrayAlpha = GrayAlphaToRgbaReference;
+		const char* Name = "scalar";
+	};
+
+	static Kernels SelectKernels()
+	{
+		Kernels kernels;
+#ifdef PIXEL_CONVERT_X86
+		const Cpu::Features& features = Cpu::GetFeatures();
+		if (features.Sse2)
+		{
+			kernels.Bgra = BgraToRgbaSse2;
+			kernels.Gray = GrayToRgbaSse2;
+			kernels.GrayAlpha = GrayAlphaToRgbaSse2;
+			kernels.Name = "SSE2";
+		}
+		if (features.Ssse3)
+		{
+			kernels.Rgb = RgbToRgbaSsse3;
+			kernels.Bgr = BgrToRgbaSsse3;
+			kernels.Name = "SSSE3";
+		}
+		if (features.Avx2)
+		{
+			kernels.Rgb = RgbToRgbaAvx2;
+			kernels.Bgr = BgrToRgbaAvx2;
+			kernels.Bgra = BgraToRgbaAvx2;
+			kernels.Gray = GrayToRgbaAvx2;
+			kernels.GrayAlpha = GrayAlphaToRgbaAvx2;
+			kernels.Name = "AVX2";
+		}
+#elif defined(PIXEL_CONVERT_NEON)
+		kernels.Rgb = RgbToRgbaNeon;
+		kernels.Bgr = BgrToRgbaNeon;
+		kernels.Bgra = BgraToRgbaNeon;
+		kernels.Gray = GrayToRgbaNeon;
+		kernels.GrayAlpha = GrayAlphaToRgbaNeon;
+		kernels.Name = "NEON";
+#endif
+		return kernels;
+	}
+
+	static const Kernels& GetKernels()
+	{
+		static const Kernels kernels = SelectKernels();
+		return kernels;
+	}
+
+	void RgbToRgba(const uint8_t* src, uint8_t* dst, int width)
+	{
+		GetKernels().Rgb(src, dst, width);
+	}
+
+	void BgrToRgba(const uint8_t* src, uint8_t* dst, int width)
+	{
+		GetKernels().Bgr(src, dst, width);
+	}
+
+	void BgraToRgba(const uint8_t* src, uint8_t* dst, int width)
+	{
+		GetKernels().Bgra(src, dst, width);
+	}
+
+	void GrayToRgba(const uint8_t* src, uint8_t* dst, int width)
+	{
+		GetKernels().Gray(src, dst, width);
+	}
+
+	void GrayAlphaToRgba(const uint8_t* src, uint8_t* dst, int width)
+	{
+		GetKernels().GrayAlpha(src, dst, width);
+	}
+
+	void ConvertRowToRgba(const uint8_t* src, int components, uint8_t* dst, int width)
+	{
+		const Kernels& kernels = GetKernels();
+		switch (components)
+		{
+		case 1:
+			kernels.Gray(src, dst, width);
+			break;
+		case 2:
+			kernels.GrayAlpha(src, dst, width);
+			break;
+		case 3:
+			kernels.Rgb(src, dst, width);
+			break;
+		default:
+			memcpy(dst, src, static_cast<size_t>(width) * 4);
+			break;
+		}
+	}
+
+	const char* GetKernelName()
+	{
+		return GetKernels().Name;
+	}
+}
@@ -0,0 +1,452 @@
+#include "image/PngDecoder.h"
+#include "core/ThreadPool.h"
+#include "image/Inflate.h"
+#include "image/PixelConvert.h"
+
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace PngDecoder
+{
+	static constexpr unsigned char PNG_SIGNATURE[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+	// Less compressed data than this per segment is not worth a task of its own.
+	static constexpr size_t MIN_INFLATE_SEGMENT_SIZE = 256 * 1024;
+	// Row bands per thread, so a thread that got a slow band does not hold up the others for long.
+	static constexpr int BANDS_PER_THREAD = 4;
+	// Output bytes one byte of deflate data can produce at most: a 258-byte match coded in under two bits.
+	static constexpr size_t MAX_DEFLATE_RATIO = 1032;
+
+	struct PngFile
+	{
+		PngInfo Info;
+		int Channels = 0;
+		int BytesPerSample = 0;
+		size_t RowBytes = 0; // without the filter byte
+		std::vector<unsigned char> Zlib; // IDAT payloads, concatenated
+		unsigned char Palette[256][4] = {};
+		int PaletteSize = 0;
+		bool HasTransparency = false;
+		uint16_t TransparentColor[3] = {};
+	};
+
+	static uint32_t ReadUint32(const unsigned char* data)
+	{
+		return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+			(static_cast<uint32_t>(data[2]) << 8) | data[3];
+	}
+
+	static uint16_t ReadUint16(const unsigned char* data)
+	{
+		return static_cast<uint16_t>((data[0] << 8) | data[1]);
+	}
+
+	static int GetChannelCount(int colorType)
+	{
+		switch (colorType)
+		{
+		case 0:
+		case 3:
+			return 1;
+		case 2:
+			return 3;
+		case 4:
+			return 2;
+		case 6:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	static void ForEach(ThreadPool* pool, int count, const std::function<void(int)>& body)
+	{
+		if (pool)
+		{
+			pool->ParallelFor(count, body);
+			return;
+		}
+		for (int i = 0; i < count; i++)
+			body(i);
+	}
+
+	static bool ParseFile(const unsigned char* data, size_t size, PngFile& file)
+	{
+		if (!ReadInfo(data, size, &file.Info) || !IsSupported(file.Info))
+			return false;
+
+		file.Channels = GetChannelCount(file.Info.ColorType);
+		file.BytesPerSample = file.Info.BitDepth / 8;
+		file.RowBytes = static_cast<size_t>(file.Info.Width) * file.Channels * file.BytesPerSample;
+		for (unsigned char* entry : file.Palette)
+			entry[3] = 255;
+
+		// IDAT payloads never add up to more than the file itself.
+		file.Zlib.reserve(size);
+
+		size_t pos = sizeof(PNG_SIGNATURE);
+		while (pos + 12 <= size)
+		{
+			uint32_t length = ReadUint32(data + pos);
+			if (length > size - pos - 12)
+				return false;
+			const unsigned char* type = data + pos + 4;
+			const unsigned char* payload = data + pos + 8;
+
+			if (memcmp(type, "IDAT", 4) == 0)
+			{
+				file.Zlib.insert(file.Zlib.end(), payload, payload + length);
+			}
+			else if (memcmp(type, "PLTE", 4) == 0)
+			{
+				if (length % 3 != 0 || length > 256 * 3)
+					return false;
+				file.PaletteSize = static_cast<int>(length / 3);
+				for (int i = 0; i < file.PaletteSize; i++)
+					memcpy(file.Palette[i], payload + i * 3, 3);
+			}
+			else if (memcmp(type, "tRNS", 4) == 0)
+			{
+				if (file.Info.ColorType == 3)
+				{
+					if (file.PaletteSize == 0 || length > static_cast<uint32_t>(file.PaletteSize))
+						return false;
+					for (uint32_t i = 0; i < length; i++)
+						file.Palette[i][3] = payload[i];
+				}
+				else
+				{
+					// Only gray and RGB carry a transparent color; stb_image rejects the chunk on the others.
+					if ((file.Info.ColorType != 0 && file.Info.ColorType != 2) || length != file.Channels * 2u)
+						return false;
+					for (int c = 0; c < file.Channels; c++)
+					{
+						uint16_t value = ReadUint16(payload + c * 2);
+						file.TransparentColor[c] = file.Info.BitDepth == 8 ? value & 0xFF : value;
+					}
+					file.HasTransparency = true;
+				}
+			}
+			else if (memcmp(type, "IEND", 4) == 0)
+			{
+				break;
+			}
+			pos += 12 + static_cast<size_t>(length);
+		}
+
+		return !file.Zlib.empty() && (file.Info.ColorType != 3 || file.PaletteSize > 0);
+	}
+
+	// A full flush ends with an empty stored block, which leaves the stream byte-aligned on 00 00 FF FF
+	// with no back-references reaching across it. The same bytes can occur by chance inside compressed
+	// data; a split there fails to inflate or fails the checksum, and the caller inflates serially instead.
+	static std::vector<size_t> FindSegmentStarts(const unsigned char* deflate, size_t size, int maxSegments)
+	{
+		std::vector<size_t> starts = {0};
+		size_t pos = 0;
+		for (int i = 1; i < maxSegments; i++)
+		{
+			size_t target = size / maxSegments * i;
+			if (pos < target)
+				pos = target;
+
+			bool found = false;
+			while (pos + 4 < size)
+			{
+				auto zero = static_cast<const unsigned char*>(memchr(deflate + pos, 0, size - 4 - pos));
+				if (!zero)
+					break;
+				pos = zero - deflate;
+				if (zero[1] == 0 && zero[2] == 0xFF && zero[3] == 0xFF)
+				{
+					found = true;
+					break;
+				}
+				pos++;
+			}
+			if (!found)
+				break;
+
+			pos += 4;
+			starts.push_back(pos);
+		}
+		return starts;
+	}
+
+	static bool InflateSegments(const PngFile& file, unsigned char* raw, size_t rawSize, ThreadPool* pool)
+	{
+		// zlib header: deflate, no preset dictionary. The last four bytes are the Adler-32 of the output.
+		const std::vector<unsigned char>& zlib = file.Zlib;
+		if (zlib.size() < 6 || (zlib[0] & 0x0F) != 8 || (zlib[1] & 0x20) != 0 || ((zlib[0] << 8) | zlib[1]) % 31 != 0)
+			return false;
+		const unsigned char* deflate = zlib.data() + 2;
+		size_t deflateSize = zlib.size() - 6;
+
+		size_t maxSegments = static_cast<size_t>(pool->GetNumThreads() + 1) * 2;
+		if (maxSegments > deflateSize / MIN_INFLATE_SEGMENT_SIZE)
+			maxSegments = deflateSize / MIN_INFLATE_SEGMENT_SIZE;
+		if (maxSegments < 2)
+			return false;
+
+		std::vector<size_t> starts = FindSegmentStarts(deflate, deflateSize, static_cast<int>(maxSegments));
+		int numSegments = static_cast<int>(starts.size());
+		if (numSegments < 2)
+			return false;
+		starts.push_back(deflateSize);
+
+		struct Segment
+		{
+			std::unique_ptr<unsigned char[]> Data;
+			size_t Size = 0;
+			uint32_t Adler = 0;
+			bool Decoded = false;
+		};
+		std::vector<Segment> segments(numSegments);
+
+		pool->ParallelFor(numSegments, [&](int i)
+		{
+			// Every segment but the last ends on a flush, not on a final block, so close it with an empty
+			// final stored block to make it a complete stream of its own.
+			std::vector<unsigned char> input(deflate + starts[i], deflate + starts[i + 1]);
+			if (i + 1 < numSegments)
+				input.insert(input.end(), {0x01, 0x00, 0x00, 0xFF, 0xFF});
+
+			// Guess the output from the segment's share of the input, and retry with room for the whole
+			// image if the guess was short. A segment that cannot be allocated fails like a corrupt one, and
+			// the image is inflated serially straight into raw instead.
+			size_t expectedSize = rawSize * input.size() / deflateSize;
+			size_t capacity = expectedSize + expectedSize / 4 + 4096;
+			Segment& segment = segments[i];
+			for (;;)
+			{
+				if (capacity > rawSize)
+					capacity = rawSize;
+				segment.Data.reset(new (std::nothrow) unsigned char[capacity]);
+				if (segment.Data == nullptr)
+					break;
+				segment.Decoded = Inflate::DecompressRaw(input.data(), input.size(), segment.Data.get(), capacity,
+				                                         &segment.Size);
+				if (segment.Decoded || capacity == rawSize)
+					break;
+				capacity = rawSize;
+			}
+			if (segment.Decoded)
+				segment.Adler = Inflate::Adler32(segment.Data.get(), segment.Size);
+		});
+
+		bool valid = true;
+		size_t totalSize = 0;
+		uint32_t adler = 1;
+		std::vector<size_t> offsets(numSegments);
+		for (int i = 0; i < numSegments && valid; i++)
+		{
+			valid = segments[i].Decoded && totalSize + segments[i].Size <= rawSize;
+			offsets[i] = totalSize;
+			totalSize += segments[i].Size;
+			adler = Inflate::CombineAdler32(adler, segments[i].Adler, segments[i].Size);
+		}
+		if (!valid || totalSize != rawSize || adler != ReadUint32(zlib.data() + zlib.size() - 4))
+			return false;
+
+		pool->ParallelFor(numSegments, [&](int i)
+		{
+			memcpy(raw + offsets[i], segments[i].Data.get(), segments[i].Size);
+		});
+		return true;
+	}
+
+	static bool InflateImageData(const PngFile& file, unsigned char* raw, size_t rawSize, ThreadPool* pool)
+	{
+		if (pool && InflateSegments(file, raw, rawSize, pool))
+			return true;
+
+		size_t written = 0;
+		return Inflate::DecompressZlib(file.Zlib.data(), file.Zlib.size(), raw, rawSize, &written) &&
+			written == rawSize;
+	}
+
+	static int Paeth(int a, int b, int c)
+	{
+		int p = a + b - c;
+		int pa = abs(p - a);
+		int pb = abs(p - b);
+		int pc = abs(p - c);
+		if (pa <= pb && pa <= pc)
+			return a;
+		if (pb <= pc)
+			return b;
+		return c;
+	}
+
+	static void UnfilterRow(int filter, unsigned char* row, const unsigned char* prior, size_t rowBytes,
+	                        size_t bytesPerPixel)
+	{
+		switch (filter)
+		{
+		case 1: // Sub
+			for (size_t i = bytesPerPixel; i < rowBytes; i++)
+				row[i] += row[i - bytesPerPixel];
+			break;
+		case 2: // Up
+			for (size_t i = 0; i < rowBytes; i++)
+				row[i] += prior[i];
+			break;
+		case 3: // Average
+			for (size_t i = 0; i < bytesPerPixel; i++)
+				row[i] += prior[i] >> 1;
+			for (size_t i = bytesPerPixel; i < rowBytes; i++)
+				row[i] += static_cast<unsigned char>((row[i - bytesPerPixel] + prior[i]) >> 1);
+			break;
+		case 4: // Paeth; with no left neighbour it always picks the byte above
+			for (size_t i = 0; i < bytesPerPixel; i++)
+				row[i] += prior[i];
+			for (size_t i = bytesPerPixel; i < rowBytes; i++)
+				row[i] += static_cast<unsigned char>(Paeth(row[i - bytesPerPixel], prior[i], prior[i - bytesPerPixel]));
+			break;
+		default: // None
+			break;
+		}
+	}
+
+	static bool Unfilter(const PngFile& file, unsigned char* raw, ThreadPool* pool)
+	{
+		int height = file.Info.Height;
+		size_t stride = file.RowBytes + 1;
+		size_t bytesPerPixel = static_cast<size_t>(file.Channels) * file.BytesPerSample;
+
+		// None and Sub rows do not read the row above, so a band of rows can start at any of them and be
+		// unfiltered independently of the bands before it.
+		int numThreads = pool ? pool->GetNumThreads() + 1 : 1;
+		int minRowsPerBand = (height + numThreads * BANDS_PER_THREAD - 1) / (numThreads * BANDS_PER_THREAD);
+		std::vector<int> bandStarts;
+		for (int y = 0; y < height; y++)
+		{
+			int filter = raw[y * stride];
+			if (filter > 4)
+				return false;
+			if (y == 0 || (filter <= 1 && y >= bandStarts.back() + minRowsPerBand))
+				bandStarts.push_back(y);
+		}
+		bandStarts.push_back(height);
+
+		// The first row is filtered against a row of zeros.
+		std::vector<unsigned char> zeroRow(file.RowBytes, 0);
+		ForEach(pool, static_cast<int>(bandStarts.size()) - 1, [&](int band)
+		{
+			for (int y = bandStarts[band]; y < bandStarts[band + 1]; y++)
+			{
+				unsigned char* row = raw + y * stride;
+				const unsigned char* prior = y > 0 ? row - stride + 1 : zeroRow.data();
+				UnfilterRow(row[0], row + 1, prior, file.RowBytes, bytesPerPixel);
+			}
+		});
+		return true;
+	}
+
+	static void ConvertRow(const PngFile& file, const unsigned char* src, unsigned char* dst, unsigned char* narrowed)
+	{
+		int width = file.Info.Width;
+		if (file.Info.ColorType == 3)
+		{
+			for (int x = 0; x < width; x++)
+				memcpy(dst + x * 4, file.Palette[src[x]], 4);
+			return;
+		}
+
+		// 16-bit samples are reduced to their high byte, as stb_image does.
+		const unsigned char* samples = src;
+		size_t numSamples = static_cast<size_t>(width) * file.Channels;
+		if (file.BytesPerSample == 2)
+		{
+			for (size_t i = 0; i < numSamples; i++)
+				narrowed[i] = src[i * 2];
+			samples = narrowed;
+		}
+		PixelConvert::ConvertRowToRgba(samples, file.Channels, dst, width);
+
+		if (!file.HasTransparency)
+			return;
+
+		// Pixels that equal the tRNS color, compared at the file's full precision, become transparent.
+		for (int x = 0; x < width; x++)
+		{
+			const unsigned char* pixel = src + static_cast<size_t>(x) * file.Channels * file.BytesPerSample;
+			bool transparent = true;
+			for (int c = 0; c < file.Channels && transparent; c++)
+			{
+				const unsigned char* sample = pixel + c * file.BytesPerSample;
+				uint16_t value = file.BytesPerSample == 2 ? ReadUint16(sample) : sample[0];
+				transparent = value == file.TransparentColor[c];
+			}
+			if (transparent)
+				dst[x * 4 + 3] = 0;
+		}
+	}
+
+	bool ReadInfo(const unsigned char* data, size_t size, PngInfo* out_info)
+	{
+		// The signature must be followed directly by IHDR; Apple's CgBI variant puts a chunk before it.
+		if (size < sizeof(PNG_SIGNATURE) + 8 + 13 || memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) != 0)
+			return false;
+		const unsigned char* chunk = data + sizeof(PNG_SIGNATURE);
+		if (ReadUint32(chunk) != 13 || memcmp(chunk + 4, "IHDR", 4) != 0)
+			return false;
+
+		const unsigned char* header = chunk + 8;
+		uint32_t width = ReadUint32(header);
+		uint32_t height = ReadUint32(header + 4);
+		if (width == 0 || height == 0 || width > (1u << 24) || height > (1u << 24))
+			return false;
+		if (header[10] != 0 || header[11] != 0 || header[12] > 1 || GetChannelCount(header[9]) == 0)
+			return false;
+
+		out_info->Width = static_cast<int>(width);
+		out_info->Height = static_cast<int>(height);
+		out_info->BitDepth = header[8];
+		out_info->ColorType = header[9];
+		out_info->Interlaced = header[12] == 1;
+		return true;
+	}
+
+	bool IsSupported(const PngInfo& info)
+	{
+		// stb_image's own limit on the RGBA8 result (stbi__mad3sizes_valid), so neither decoder allocates more.
+		return !info.Interlaced && GetChannelCount(info.ColorType) != 0 &&
+			(info.BitDepth == 8 || (info.BitDepth == 16 && info.ColorType != 3)) &&
+			static_cast<int64_t>(info.Width) * info.Height <= INT_MAX / 4;
+	}
+
+	bool Decode(const unsigned char* data, size_t size, unsigned char* dst, size_t dstRowPitch, ThreadPool* pool)
+	{
+		PngFile file;
+		if (!ParseFile(data, size, file))
+			return false;
+
+		int height = file.Info.Height;
+		size_t stride = file.RowBytes + 1;
+		size_t rawSize = stride * height;
+
+		// Deflate expands at most 1032:1, so a header promising more than the IDATs can hold is rejected
+		// before the filtered rows are allocated; a failed allocation is a failed decode as well.
+		if (file.Zlib.size() * MAX_DEFLATE_RATIO < rawSize)
+			return false;
+		std::unique_ptr<unsigned char[]> raw(new (std::nothrow) unsigned char[rawSize]);
+		if (raw == nullptr || !InflateImageData(file, raw.get(), rawSize, pool) || !Unfilter(file, raw.get(), pool))
+			return false;
+
+		int numThreads = pool ? pool->GetNumThreads() + 1 : 1;
+		int numBands = numThreads * BANDS_PER_THREAD < height ? numThreads * BANDS_PER_THREAD : height;
+		ForEach(pool, numBands, [&](int band)
+		{
+			std::vector<unsigned char> narrowed(file.BytesPerSample == 2 ? file.RowBytes / 2 : 0);
+			int endRow = static_cast<int>(static_cast<int64_t>(height) * (band + 1) / numBands);
+			for (int y = static_cast<int>(static_cast<int64_t>(height) * band / numBands); y < endRow; y++)
+				ConvertRow(file, raw.get() + y * stride + 1, dst + y * dstRowPitch, narrowed.data());
+		});
+		return true;
+	}
+}
@@ -0,0 +1,347 @@
+#include "Stdafx.hpp"
+#include "image/TextureAtlas.h"
+#include "image/DiskTextureCache.h"
+
+namespace
+{
+	UINT GetStagingRowPitch(int paddedWidth)
+	{
+		return (static_cast<UINT>(paddedWidth) * 4 + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) &
+			~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+	}
+
+	UINT64 GetStagingSize(int paddedWidth, int paddedHeight)
+	{
+		UINT64 size = static_cast<UINT64>(GetStagingRowPitch(paddedWidth)) * paddedHeight;
+		return (size + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1ull);
+	}
+}
+
+bool TextureAtlas::Create(
+	ID3D12Device* device,
+	Dx12TextureHeap* textureHeap,
+	ExampleDescriptorHeapAllocator* srvAllocator,
+	int framesInFlight)
+{
+	if (!device || !textureHeap || !srvAllocator)
+		return false;
+
+	m_device = device;
+	m_textureHeap = textureHeap;
+	m_srvAllocator = srvAllocator;
+	m_framesInFlight = static_cast<uint64_t>(framesInFlight);
+	m_packer.Initialize(APP_TEXTURE_ATLAS_PAGE_SIZE, APP_TEXTURE_ATLAS_MAX_PAGES);
+	return true;
+}
+
+void TextureAtlas::Release()
+{
+	for (Page& page : m_pages)
+		page.Texture.Release(m_srvAllocator);
+	for (RetiredTexture& retired : m_retiredTextures)
+		retired.Texture.Release(m_srvAllocator);
+	m_pages.clear();
+	m_retiredTextures.clear();
+	m_uploadFenceValues.clear();
+	m_packer.Reset();
+}
+
+bool TextureAtlas::CanPack(const DecodedImage& image)
+{
+	return image.Format == TextureFormat::Rgba8 && (image.Pixels || image.CacheEntry) &&
+		image.Width <= APP_TEXTURE_ATLAS_MAX_IMAGE_SIZE && image.Height <= APP_TEXTURE_ATLAS_MAX_IMAGE_SIZE;
+}
+
+bool TextureAtlas::CreatePageTexture(ImGuiDx12Texture& out_texture)
+{
+	D3D12_RESOURCE_DESC resDesc = {};
+	resDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	resDesc.Width = APP_TEXTURE_ATLAS_PAGE_SIZE;
+	resDesc.Height = APP_TEXTURE_ATLAS_PAGE_SIZE;
+	resDesc.DepthOrArraySize = 1;
+	resDesc.MipLevels = 1;
+	resDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	resDesc.SampleDesc.Count = 1;
+	resDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	resDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS;
+
+	// Texels no entry covers are never sampled, so a page placed over memory of a released texture needs no
+	// clearing.
+	HRESULT hr = m_textureHeap->CreateTexture(resDesc, D3D12_RESOURCE_STATE_COMMON, out_texture.TextureResource,
+	                                          &out_texture.HeapAllocation);
+	if (FAILED(hr))
+	{
+		std::cerr << "Failed to create atlas page. HRESULT: " << std::hex << hr << std::dec << std::endl;
+		return false;
+	}
+	out_texture.Heap = m_textureHeap;
+	out_texture.Format = resDesc.Format;
+	out_texture.Width = APP_TEXTURE_ATLAS_PAGE_SIZE;
+	out_texture.Height = APP_TEXTURE_ATLAS_PAGE_SIZE;
+	out_texture.SizeInBytes = out_texture.HeapAllocation.SizeInBytes;
+
+	if (!m_srvAllocator->Alloc(&out_texture.SrvCpuDescriptorHandle, &out_texture.SrvGpuDescriptorHandle,
+	                           &out_texture.SrvDescriptor))
+	{
+		out_texture.Release(m_srvAllocator);
+		return false;
+	}
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Format = resDesc.Format;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MipLevels = 1;
+	m_device->CreateShaderResourceView(out_texture.TextureResource.Get(), &srvDesc,
+	                                   out_texture.SrvCpuDescriptorHandle);
+	return true;
+}
+
+void TextureAtlas::RetireTexture(ImGuiDx12Texture&& texture)
+{
+	// Frames drawn with it may still be in flight; they have all retired once framesInFlight more frames have
+	// been submitted after the current one.
+	if (texture.TextureResource)
+		m_retiredTextures.push_back({std::move(texture), m_frame + m_framesInFlight + 1});
+}
+
+void TextureAtlas::RecordMoves(const std::vector<AtlasMove>& moves, ID3D12GraphicsCommandList* commandList,
+                               std::vector<int>& out_repackedPages)
+{
+	D3D12_TEXTURE_COPY_LOCATION dst = {};
+	dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+	D3D12_TEXTURE_COPY_LOCATION src = {};
+	src.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+
+	// Moves come grouped by page. Both textures are promoted from COMMON by the copies and decay back after.
+	for (size_t first = 0; first < moves.size();)
+	{
+		const int pageIndex = moves[first].Page;
+		size_t end = first;
+		while (end < moves.size() && moves[end].Page == pageIndex)
+			end++;
+
+		Page& page = m_pages[pageIndex];
+		ImGuiDx12Texture texture;
+		if (!page.Texture.TextureResource || !CreatePageTexture(texture))
+		{
+			// Requests packed into the page with them still get a texture created for them, if possible.
+			for (size_t i = first; i < end; i++)
+				m_packer.Remove(moves[i].Entry);
+			RetireTexture(std::move(page.Texture));
+			first = end;
+			continue;
+		}
+
+		src.pResource = page.Texture.TextureResource.Get();
+		dst.pResource = texture.TextureResource.Get();
+		for (size_t i = first; i < end; i++)
+		{
+			const AtlasMove& move = moves[i];
+			D3D12_BOX box = {static_cast<UINT>(move.SrcX), static_cast<UINT>(move.SrcY), 0,
+			                 static_cast<UINT>(move.SrcX + move.Width), static_cast<UINT>(move.SrcY + move.Height), 1};
+			commandList->CopyTextureRegion(&dst, move.DstX, move.DstY, 0, &src, &box);
+		}
+
+		RetireTexture(std::move(page.Texture));
+		page.Texture = std::move(texture);
+		out_repackedPages.push_back(pageIndex);
+		first = end;
+	}
+}
+
+int TextureAtlas::AddImages(
+	const DecodedImage* const* images,
+	size_t numImages,
+	Dx12UploadQueue* uploadQueue,
+	std::vector<ImGuiDx12Texture>& out_textures)
+{
+	out_textures.clear();
+	out_textures.resize(numImages);
+	if (numImages == 0 || !m_device)
+		return 0;
+
+	// Opened before packing: a repack has to be copied out once the packer made it.
+	ID3D12GraphicsCommandList* commandList = uploadQueue->BeginUpload();
+	if (!commandList)
+		return 0;
+
+	std::vector<AtlasRequest> requests(numImages);
+	for (size_t i = 0; i < numImages; i++)
+	{
+		if (CanPack(*images[i]))
+		{
+			requests[i].Width = images[i]->Width;
+			requests[i].Height = images[i]->Height;
+		}
+	}
+	m_moves.clear();
+	m_packer.Insert(requests.data(), numImages, m_moves);
+	if (m_pages.size() < static_cast<size_t>(m_packer.GetNumPages()))
+		m_pages.resize(m_packer.GetNumPages());
+
+	std::vector<int> repackedPages;
+	const size_t firstRetired = m_retiredTextures.size();
+	RecordMoves(m_moves, commandList, repackedPages);
+
+	// Pages opened by this batch, or emptied and released earlier, get their texture now; entries of a page
+	// without one are given up.
+	UINT64 stagingSize = 0;
+	for (size_t i = 0; i < numImages; i++)
+	{
+		AtlasPlacement placement = m_packer.GetPlacement(requests[i].Handle);
+		if (placement.Page < 0)
+			continue;
+		Page& page = m_pages[placement.Page];
+		if (!page.Texture.TextureResource && !CreatePageTexture(page.Texture))
+		{
+			m_packer.Remove(requests[i].Handle);
+			continue;
+		}
+		stagingSize += GetStagingSize(placement.Width + 2 * APP_ATLAS_PADDING,
+		                              placement.Height + 2 * APP_ATLAS_PADDING);
+	}
+
+	Dx12UploadAllocation staging;
+	if (stagingSize != 0 && !uploadQueue->AllocateStaging(stagingSize, &staging))
+	{
+		for (AtlasRequest& request : requests)
+			m_packer.Remove(request.Handle);
+		stagingSize = 0;
+	}
+
+	D3D12_TEXTURE_COPY_LOCATION dst = {};
+	dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+	D3D12_TEXTURE_COPY_LOCATION src = {};
+	src.pResource = staging.Resource;
+	src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+	src.PlacedFootprint.Offset = staging.Offset;
+	src.PlacedFootprint.Footprint.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	src.PlacedFootprint.Footprint.Depth = 1;
+
+	std::vector<size_t> packed;
+	for (size_t i = 0; i < numImages && stagingSize != 0; i++)
+	{
+		AtlasPlacement placement = m_packer.GetPlacement(requests[i].Handle);
+		if (placement.Page < 0)
+			continue;
+
+		const DecodedImage& image = *images[i];
+		const unsigned char* pixels = image.Pixels;
+		size_t rowPitch = TextureFormats::GetRowPitch(image.Format, image.Width);
+		if (image.CacheEntry)
+		{
+			pixels = image.CacheEntry->GetLevelData(0);
+			rowPitch = image.CacheEntry->Levels[0].RowPitch;
+		}
+
+		const int paddedWidth = placement.Width + 2 * APP_ATLAS_PADDING;
+		const int paddedHeight = placement.Height + 2 * APP_ATLAS_PADDING;
+		src.PlacedFootprint.Footprint.Width = static_cast<UINT>(paddedWidth);
+		src.PlacedFootprint.Footprint.Height = static_cast<UINT>(paddedHeight);
+		src.PlacedFootprint.Footprint.RowPitch = GetStagingRowPitch(paddedWidth);
+		AtlasPacker::CopyWithPadding(pixels, rowPitch, image.Width, image.Height,
+		                             static_cast<unsigned char*>(staging.MappedData) + src.PlacedFootprint.Offset,
+		                             src.PlacedFootprint.Footprint.RowPitch);
+
+		dst.pResource = m_pages[placement.Page].Texture.TextureResource.Get();
+		commandList->CopyTextureRegion(&dst, placement.X - APP_ATLAS_PADDING, placement.Y - APP_ATLAS_PADDING, 0,
+		                               &src, nullptr);
+		src.PlacedFootprint.Offset += GetStagingSize(paddedWidth, paddedHeight);
+		packed.push_back(i);
+	}
+
+	// No transitions: the pages decay back to COMMON when the copy list finishes.
+	// Textures remember their last copy, so none is released while one still reads or writes it.
+	UINT64 fenceValue = uploadQueue->EndUpload();
+	for (size_t i = firstRetired; i < m_retiredTextures.size(); i++)
+		m_retiredTextures[i].Texture.UploadFenceValue = fenceValue;
+	for (int page : repackedPages)
+	{
+		m_pages[page].RepackFenceValue = fenceValue;
+		m_pages[page].Texture.UploadFenceValue = fenceValue;
+	}
+
+	for (size_t i : packed)
+	{
+		const AtlasHandle handle = requests[i].Handle;
+		if (m_uploadFenceValues.size() <= handle.Index)
+			m_uploadFenceValues.resize(handle.Index + 1);
+		m_uploadFenceValues[handle.Index] = fenceValue;
+
+		m_pages[m_packer.GetPlacement(handle).Page].Texture.UploadFenceValue = fenceValue;
+
+		ImGuiDx12Texture& texture = out_textures[i];
+		texture.Atlas = this;
+		texture.AtlasEntry = handle;
+		texture.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		texture.Width = images[i]->Width;
+		texture.Height = images[i]->Height;
+		texture.SourceWidth = images[i]->SourceWidth;
+		texture.SourceHeight = images[i]->SourceHeight;
+		texture.UploadFenceValue = fenceValue;
+		texture.SizeInBytes = static_cast<UINT64>(texture.Width + 2 * APP_ATLAS_PADDING) *
+			(texture.Height + 2 * APP_ATLAS_PADDING) * 4;
+	}
+	return static_cast<int>(packed.size());
+}
+
+void TextureAtlas::Remove(AtlasHandle handle)
+{
+	m_packer.Remove(handle);
+}
+
+bool TextureAtlas::GetView(AtlasHandle handle, ImGuiDx12TextureView* out_view) const
+{
+	AtlasPlacement placement = m_packer.GetPlacement(handle);
+	if (placement.Page < 0 || !m_pages[placement.Page].Texture.TextureResource)
+		return false;
+
+	const Page& page = m_pages[placement.Page];
+	constexpr float PAGE_TEXEL = 1.0f / APP_TEXTURE_ATLAS_PAGE_SIZE;
+	out_view->TextureId = page.Texture.SrvGpuDescriptorHandle.ptr;
+	out_view->Uv0 = ImVec2(placement.X * PAGE_TEXEL, placement.Y * PAGE_TEXEL);
+	out_view->Uv1 = ImVec2((placement.X + placement.Width) * PAGE_TEXEL, (placement.Y + placement.Height) * PAGE_TEXEL);
+	UINT64 uploadFenceValue = m_uploadFenceValues[handle.Index];
+	out_view->UploadFenceValue = uploadFenceValue > page.RepackFenceValue ? uploadFenceValue : page.RepackFenceValue;
+	return true;
+}
+
+void TextureAtlas::EndFrame(Dx12UploadQueue* uploadQueue)
+{
+	m_frame++;
+
+	bool keptEmptyPage = false;
+	for (int i = 0; i < static_cast<int>(m_pages.size()); i++)
+	{
+		if (!m_pages[i].Texture.TextureResource || !m_packer.IsPageEmpty(i))
+			continue;
+		if (keptEmptyPage)
+			RetireTexture(std::move(m_pages[i].Texture));
+		keptEmptyPage = true;
+	}
+
+	for (size_t i = 0; i < m_retiredTextures.size();)
+	{
+		RetiredTexture& retired = m_retiredTextures[i];
+		// A repack copies out of the texture it replaces, and that copy may still be running.
+		if (retired.ReleaseFrame <= m_frame && uploadQueue->IsComplete(retired.Texture.UploadFenceValue))
+		{
+			retired.Texture.Release(m_srvAllocator);
+			m_retiredTextures[i] = std::move(m_retiredTextures.back());
+			m_retiredTextures.pop_back();
+			continue;
+		}
+		i++;
+	}
+}
+
+UINT64 TextureAtlas::GetSizeInBytes() const
+{
+	UINT64 sizeInBytes = 0;
+	for (const Page& page : m_pages)
+		sizeInBytes += page.Texture.SizeInBytes;
+	for (const RetiredTexture& retired : m_retiredTextures)
+		sizeInBytes += retired.Texture.SizeInBytes;
+	return sizeInBytes;
+}
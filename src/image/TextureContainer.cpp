@@ -0,0 +1,316 @@
+#include "image/TextureContainer.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace TextureContainer
+{
+	static constexpr unsigned char DDS_SIGNATURE[4] = {'D', 'D', 'S', ' '};
+	static constexpr unsigned char KTX2_SIGNATURE[12] = {
+		0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+	// DDS_HEADER follows the signature; DDS_HEADER_DXT10 follows it when the pixel format says "DX10".
+	static constexpr size_t DDS_HEADER_SIZE = 124;
+	static constexpr size_t DDS_DX10_HEADER_SIZE = 20;
+	static constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+	static constexpr uint32_t DDPF_FOURCC = 0x4;
+	static constexpr uint32_t DDSCAPS2_CUBEMAP = 0x200;
+	static constexpr uint32_t DDSCAPS2_VOLUME = 0x200000;
+	static constexpr uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+	static constexpr uint32_t DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+	// Header and level index as laid out by the KTX 2.0 specification.
+	static constexpr size_t KTX2_HEADER_SIZE = 80;
+	static constexpr size_t KTX2_LEVEL_ENTRY_SIZE = 24;
+
+	static uint32_t ReadUint32(const unsigned char* data)
+	{
+		return data[0] | (static_cast<uint32_t>(data[1]) << 8) | (static_cast<uint32_t>(data[2]) << 16) |
+			(static_cast<uint32_t>(data[3]) << 24);
+	}
+
+	static uint64_t ReadUint64(const unsigned char* data)
+	{
+		return ReadUint32(data) | (static_cast<uint64_t>(ReadUint32(data + 4)) << 32);
+	}
+
+	static uint32_t MakeFourCc(char a, char b, char c, char d)
+	{
+		return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) |
+			(static_cast<uint32_t>(d) << 24);
+	}
+
+	static bool HasSignature(const unsigned char* data, size_t size, const unsigned char* signature,
+	                         size_t signatureSize)
+	{
+		return size >= signatureSize && memcmp(data, signature, signatureSize) == 0;
+	}
+
+	static bool GetFormatFromFourCc(uint32_t fourCc, TextureFormat* out_format)
+	{
+		if (fourCc == MakeFourCc('D', 'X', 'T', '1'))
+			*out_format = TextureFormat::Bc1;
+		else if (fourCc == MakeFourCc('D', 'X', 'T', '4') || fourCc == MakeFourCc('D', 'X', 'T', '5'))
+			*out_format = TextureFormat::Bc3;
+		else if (fourCc == MakeFourCc('A', 'T', 'I', '2') || fourCc == MakeFourCc('B', 'C', '5', 'U'))
+			*out_format = TextureFormat::Bc5;
+		else
+			return false;
+		return true;
+	}
+
+	static bool GetFormatFromDxgi(uint32_t dxgiFormat, TextureFormat* out_format)
+	{
+		switch (dxgiFormat)
+		{
+		case 70: // BC1_TYPELESS
+		case 71: // BC1_UNORM
+		case 72: // BC1_UNORM_SRGB
+			*out_format = TextureFormat::Bc1;
+			return true;
+		case 76: // BC3_TYPELESS
+		case 77: // BC3_UNORM
+		case 78: // BC3_UNORM_SRGB
+			*out_format = TextureFormat::Bc3;
+			return true;
+		case 82: // BC5_TYPELESS
+		case 83: // BC5_UNORM
+			*out_format = TextureFormat::Bc5;
+			return true;
+		case 97: // BC7_TYPELESS
+		case 98: // BC7_UNORM
+		case 99: // BC7_UNORM_SRGB
+			*out_format = TextureFormat::Bc7;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	static bool GetFormatFromVulkan(uint32_t vkFormat, TextureFormat* out_format)
+	{
+		switch (vkFormat)
+		{
+		case 131: // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+		case 132: // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+		case 133: // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+		case 134: // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+			*out_format = TextureFormat::Bc1;
+			return true;
+		case 137: // VK_FORMAT_BC3_UNORM_BLOCK
+		case 138: // VK_FORMAT_BC3_SRGB_BLOCK
+			*out_format = TextureFormat::Bc3;
+			return true;
+		case 141: // VK_FORMAT_BC5_UNORM_BLOCK
+			*out_format = TextureFormat::Bc5;
+			return true;
+		case 145: // VK_FORMAT_BC7_UNORM_BLOCK
+		case 146: // VK_FORMAT_BC7_SRGB_BLOCK
+			*out_format = TextureFormat::Bc7;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Checks the size shared by both containers and fills in the dimensions of every level.
+	static bool SetDimensions(uint32_t width, uint32_t height, uint32_t mipLevels, TextureContainerInfo* out_info)
+	{
+		if (width == 0 || height == 0 || width > APP_MAX_TEXTURE_DIMENSION || height > APP_MAX_TEXTURE_DIMENSION)
+		{
+			std::cerr << "Texture container has an unsupported size: " << width << "x" << height << std::endl;
+			return false;
+		}
+		if (width % 4 != 0 || height % 4 != 0)
+		{
+			std::cerr << "Block-compressed texture is " << width << "x" << height
+				<< ", which is not a multiple of 4." << std::endl;
+			return false;
+		}
+
+		out_info->Width = static_cast<int>(width);
+		out_info->Height = static_cast<int>(height);
+		out_info->MipLevels = 0;
+		int levelWidth = out_info->Width;
+		int levelHeight = out_info->Height;
+		// Files may carry a chain longer than the image allows; the 1x1 level ends it.
+		for (uint32_t level = 0; level < mipLevels && level < APP_MAX_TEXTURE_MIP_LEVELS; level++)
+		{
+			TextureContainerLevel& entry = out_info->Levels[level];
+			entry.Width = levelWidth;
+			entry.Height = levelHeight;
+			entry.Size = TextureFormats::GetLevelSize(out_info->Format, levelWidth, levelHeight);
+			out_info->MipLevels++;
+
+			if (levelWidth == 1 && levelHeight == 1)
+				break;
+			levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+			levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+		}
+		return true;
+	}
+
+	static bool ReadDdsInfo(const unsigned char* data, size_t size, TextureContainerInfo* out_info)
+	{
+		size_t dataOffset = sizeof(DDS_SIGNATURE) + DDS_HEADER_SIZE;
+		if (size < dataOffset || ReadUint32(data + 4) != DDS_HEADER_SIZE)
+		{
+			std::cerr << "DDS header is truncated or corrupt." << std::endl;
+			return false;
+		}
+
+		const unsigned char* header = data + sizeof(DDS_SIGNATURE);
+		uint32_t flags = ReadUint32(header + 4);
+		uint32_t height = ReadUint32(header + 8);
+		uint32_t width = ReadUint32(header + 12);
+		uint32_t mipLevels = (flags & DDSD_MIPMAPCOUNT) != 0 ? ReadUint32(header + 24) : 1;
+		uint32_t pixelFormatFlags = ReadUint32(header + 76);
+		uint32_t fourCc = ReadUint32(header + 80);
+		uint32_t caps2 = ReadUint32(header + 108);
+
+		if ((caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)) != 0)
+		{
+			std::cerr << "DDS cube maps and volume textures are not supported." << std::endl;
+			return false;
+		}
+		if ((pixelFormatFlags & DDPF_FOURCC) == 0)
+		{
+			std::cerr << "Uncompressed DDS files are not supported." << std::endl;
+			return false;
+		}
+
+		if (fourCc == MakeFourCc('D', 'X', '1', '0'))
+		{
+			if (size < dataOffset + DDS_DX10_HEADER_SIZE)
+			{
+				std::cerr << "DDS header is truncated or corrupt." << std::endl;
+				return false;
+			}
+			const unsigned char* dx10 = data + dataOffset;
+			dataOffset += DDS_DX10_HEADER_SIZE;
+			uint32_t dxgiFormat = ReadUint32(dx10);
+			uint32_t dimension = ReadUint32(dx10 + 4);
+			uint32_t miscFlags = ReadUint32(dx10 + 8);
+			uint32_t arraySize = ReadUint32(dx10 + 12);
+			if (dimension != DDS_DIMENSION_TEXTURE2D || (miscFlags & DDS_RESOURCE_MISC_TEXTURECUBE) != 0 ||
+				arraySize > 1)
+			{
+				std::cerr << "DDS arrays, cube maps and non-2D textures are not supported." << std::endl;
+				return false;
+			}
+			if (!GetFormatFromDxgi(dxgiFormat, &out_info->Format))
+			{
+				std::cerr << "DDS format " << dxgiFormat << " is not supported (BC1, BC3, BC5 and BC7 are)."
+					<< std::endl;
+				return false;
+			}
+		}
+		else if (!GetFormatFromFourCc(fourCc, &out_info->Format))
+		{
+			std::cerr << "DDS format '" << static_cast<char>(fourCc) << static_cast<char>(fourCc >> 8)
+				<< static_cast<char>(fourCc >> 16) << static_cast<char>(fourCc >> 24)
+				<< "' is not supported (BC1, BC3, BC5 and BC7 are)." << std::endl;
+			return false;
+		}
+
+		if (!SetDimensions(width, height, mipLevels == 0 ? 1 : mipLevels, out_info))
+			return false;
+
+		// The levels are stored back to back after the headers, largest first.
+		size_t offset = dataOffset;
+		for (int level = 0; level < out_info->MipLevels; level++)
+		{
+			TextureContainerLevel& entry = out_info->Levels[level];
+			if (entry.Size > size - offset)
+			{
+				if (level == 0)
+				{
+					std::cerr << "DDS file is truncated." << std::endl;
+					return false;
+				}
+				// Keep the levels that are there; D3D12 is fine with a shorter chain.
+				out_info->MipLevels = level;
+				break;
+			}
+			entry.Offset = offset;
+			offset += entry.Size;
+		}
+		return true;
+	}
+
+	static bool ReadKtx2Info(const unsigned char* data, size_t size, TextureContainerInfo* out_info)
+	{
+		if (size < KTX2_HEADER_SIZE)
+		{
+			std::cerr << "KTX2 header is truncated." << std::endl;
+			return false;
+		}
+
+		uint32_t vkFormat = ReadUint32(data + 12);
+		uint32_t width = ReadUint32(data + 20);
+		uint32_t height = ReadUint32(data + 24);
+		uint32_t depth = ReadUint32(data + 28);
+		uint32_t layerCount = ReadUint32(data + 32);
+		uint32_t faceCount = ReadUint32(data + 36);
+		uint32_t levelCount = ReadUint32(data + 40);
+		uint32_t supercompressionScheme = ReadUint32(data + 44);
+
+		if (depth != 0 || layerCount > 1 || faceCount != 1)
+		{
+			std::cerr << "KTX2 arrays, cube maps and volume textures are not supported." << std::endl;
+			return false;
+		}
+		if (supercompressionScheme != 0)
+		{
+			std::cerr << "KTX2 supercompression (scheme " << supercompressionScheme << ") is not supported."
+				<< std::endl;
+			return false;
+		}
+		if (!GetFormatFromVulkan(vkFormat, &out_info->Format))
+		{
+			std::cerr << "KTX2 format " << vkFormat << " is not supported (BC1, BC3, BC5 and BC7 are)." << std::endl;
+			return false;
+		}
+
+		// levelCount 0 asks the loader to generate the chain; only the base level is in the file then.
+		uint32_t numLevelEntries = levelCount == 0 ? 1 : levelCount;
+		if (numLevelEntries > 32 || size - KTX2_HEADER_SIZE < numLevelEntries * KTX2_LEVEL_ENTRY_SIZE)
+		{
+			std::cerr << "KTX2 level index is truncated or corrupt." << std::endl;
+			return false;
+		}
+		if (!SetDimensions(width, height, numLevelEntries, out_info))
+			return false;
+
+		for (int level = 0; level < out_info->MipLevels; level++)
+		{
+			const unsigned char* entry = data + KTX2_HEADER_SIZE + level * KTX2_LEVEL_ENTRY_SIZE;
+			uint64_t offset = ReadUint64(entry);
+			uint64_t length = ReadUint64(entry + 8);
+			TextureContainerLevel& info = out_info->Levels[level];
+			if (length != info.Size || offset > size || length > size - offset)
+			{
+				std::cerr << "KTX2 level " << level << " is truncated or corrupt." << std::endl;
+				return false;
+			}
+			info.Offset = static_cast<size_t>(offset);
+		}
+		return true;
+	}
+
+	bool IsContainer(const unsigned char* data, size_t size)
+	{
+		return HasSignature(data, size, DDS_SIGNATURE, sizeof(DDS_SIGNATURE)) ||
+			HasSignature(data, size, KTX2_SIGNATURE, sizeof(KTX2_SIGNATURE));
+	}
+
+	bool ReadInfo(const unsigned char* data, size_t size, TextureContainerInfo* out_info)
+	{
+		*out_info = TextureContainerInfo();
+		if (HasSignature(data, size, DDS_SIGNATURE, sizeof(DDS_SIGNATURE)))
+			return ReadDdsInfo(data, size, out_info);
+		if (HasSignature(data, size, KTX2_SIGNATURE, sizeof(KTX2_SIGNATURE)))
+			return ReadKtx2Info(data, size, out_info);
+		return false;
+	}
+}
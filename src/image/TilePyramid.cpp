@@ -0,0 +1,107 @@
+#include "image/TilePyramid.h"
+#include "image/DiskTextureCache.h"
+#include "image/MipGenerator.h"
+
+#include <algorithm>
+#include <cstring>
+
+TileLayout TileLayout::Make(int width, int height)
+{
+	TileLayout layout;
+	layout.Width = width;
+	layout.Height = height;
+	layout.NumLevels = 1;
+	while (layout.GetLevelWidth(layout.NumLevels - 1) > APP_TILE_SIZE ||
+		layout.GetLevelHeight(layout.NumLevels - 1) > APP_TILE_SIZE)
+		layout.NumLevels++;
+	return layout;
+}
+
+int TileLayout::GetTileWidth(const TileId& tile) const
+{
+	return std::min(APP_TILE_SIZE, GetLevelWidth(tile.Level) - tile.X * APP_TILE_SIZE);
+}
+
+int TileLayout::GetTileHeight(const TileId& tile) const
+{
+	return std::min(APP_TILE_SIZE, GetLevelHeight(tile.Level) - tile.Y * APP_TILE_SIZE);
+}
+
+bool TilePyramid::Build(DecodedImage&& image)
+{
+	if (image.Format != TextureFormat::Rgba8 || (image.Pixels == nullptr && !image.CacheEntry))
+		return false;
+
+	TileLayout layout = TileLayout::Make(image.Width, image.Height);
+	if (image.CacheEntry)
+	{
+		if (image.MipLevels < layout.NumLevels)
+			return false;
+	}
+	else if (image.MipLevels < layout.NumLevels)
+	{
+		// A chain that stops early (a container's own) is replaced rather than extended.
+		image.MipData.clear();
+		image.MipLevels = 1;
+		MipGenerator::GenerateMipChain(image);
+	}
+
+	m_image = std::move(image);
+	m_layout = layout;
+
+	// The chain goes down to 1x1; only the levels down to the single-tile one are kept track of.
+	m_levels.assign(m_layout.NumLevels, Level{});
+	m_sizeInBytes = 0;
+	const unsigned char* mipPixels = m_image.MipData.data();
+	for (int level = 0; level < m_layout.NumLevels; level++)
+	{
+		Level& out = m_levels[level];
+		if (m_image.CacheEntry)
+		{
+			out.Pixels = m_image.CacheEntry->GetLevelData(level);
+			out.RowPitch = m_image.CacheEntry->Levels[level].RowPitch;
+			m_sizeInBytes += static_cast<uint64_t>(out.RowPitch) * m_layout.GetLevelHeight(level);
+			continue;
+		}
+
+		out.RowPitch = static_cast<size_t>(m_layout.GetLevelWidth(level)) * 4;
+		m_sizeInBytes += static_cast<uint64_t>(out.RowPitch) * m_layout.GetLevelHeight(level);
+		if (level == 0)
+		{
+			out.Pixels = m_image.Pixels;
+			continue;
+		}
+		out.Pixels = mipPixels;
+		mipPixels += out.RowPitch * m_layout.GetLevelHeight(level);
+	}
+	return true;
+}
+
+void TilePyramid::CopyTile(const TileId& tile, unsigned char* dst, size_t dstRowPitch) const
+{
+	const int levelWidth = m_layout.GetLevelWidth(tile.Level);
+	const int levelHeight = m_layout.GetLevelHeight(tile.Level);
+	const unsigned char* pixels = m_levels[tile.Level].Pixels;
+	const size_t srcRowPitch = m_levels[tile.Level].RowPitch;
+
+	// Slot column c shows level column x0 + c; the run inside the level is copied, the rest clamped.
+	const int x0 = tile.X * APP_TILE_SIZE - APP_TILE_BORDER;
+	const int y0 = tile.Y * APP_TILE_SIZE - APP_TILE_BORDER;
+	const int firstInside = std::max(0, -x0);
+	const int endInside = std::min(APP_TILE_SLOT_SIZE, levelWidth - x0);
+
+	for (int row = 0; row < APP_TILE_SLOT_SIZE; row++)
+	{
+		int y = std::clamp(y0 + row, 0, levelHeight - 1);
+		const unsigned char* src = pixels + y * srcRowPitch;
+		unsigned char* out = dst + row * dstRowPitch;
+
+		std::memcpy(out + firstInside * 4, src + static_cast<size_t>(x0 + firstInside) * 4,
+		            static_cast<size_t>(endInside - firstInside) * 4);
+		for (int c = 0; c < firstInside; c++)
+			std::memcpy(out + c * 4, src, 4);
+		const unsigned char* lastTexel = src + static_cast<size_t>(levelWidth - 1) * 4;
+		for (int c = endInside; c < APP_TILE_SLOT_SIZE; c++)
+			std::memcpy(out + c * 4, lastTexel, 4);
+	}
+}
@@ -0,0 +1,239 @@
+#include "image/TileResidency.h"
+
+#include <algorithm>
+#include <cmath>
+
+void TileResidency::Initialize(const TileLayout& layout, int numSlots, int framesInFlight)
+{
+	m_layout = layout;
+	m_framesInFlight = framesInFlight;
+	m_frame = 0;
+	m_slots.assign(numSlots, Slot{});
+	m_residentSlots.clear();
+	m_requests.clear();
+	m_uploads = 0;
+	m_evictions = 0;
+}
+
+int TileResidency::SelectLevel(const TileView& view) const
+{
+	if (view.ScreenWidth <= 0.0f || view.ScreenHeight <= 0.0f)
+		return m_layout.NumLevels - 1;
+
+	float texelsPerPixel = std::max((view.X1 - view.X0) / view.ScreenWidth, (view.Y1 - view.Y0) / view.ScreenHeight);
+	if (texelsPerPixel <= 1.0f)
+		return 0;
+	// Rounded rather than floored: a level is used from 1/sqrt(2) to sqrt(2) of its texels per pixel.
+	int level = static_cast<int>(std::floor(std::log2(texelsPerPixel) + 0.5f));
+	return std::clamp(level, 0, m_layout.NumLevels - 1);
+}
+
+void TileResidency::GetVisibleTiles(
+	const TileView& view,
+	int level,
+	int& out_x0,
+	int& out_y0,
+	int& out_x1,
+	int& out_y1) const
+{
+	float x0 = std::max(view.X0, 0.0f);
+	float y0 = std::max(view.Y0, 0.0f);
+	float x1 = std::min(view.X1, static_cast<float>(m_layout.Width));
+	float y1 = std::min(view.Y1, static_cast<float>(m_layout.Height));
+	if (x1 <= x0 || y1 <= y0)
+	{
+		out_x0 = out_y0 = 0;
+		out_x1 = out_y1 = -1;
+		return;
+	}
+
+	const float tileWidth = APP_TILE_SIZE * m_layout.GetScaleX(level);
+	const float tileHeight = APP_TILE_SIZE * m_layout.GetScaleY(level);
+	out_x0 = std::clamp(static_cast<int>(x0 / tileWidth), 0, m_layout.GetTilesX(level) - 1);
+	out_y0 = std::clamp(static_cast<int>(y0 / tileHeight), 0, m_layout.GetTilesY(level) - 1);
+	out_x1 = std::clamp(static_cast<int>(std::ceil(x1 / tileWidth)) - 1, out_x0, m_layout.GetTilesX(level) - 1);
+	out_y1 = std::clamp(static_cast<int>(std::ceil(y1 / tileHeight)) - 1, out_y0, m_layout.GetTilesY(level) - 1);
+}
+
+void TileResidency::Update(const TileView& view, uint64_t frame)
+{
+	if (frame != m_frame)
+	{
+		m_frame = frame;
+		m_requests.clear();
+
+		auto pinned = m_residentSlots.find(GetCoarsestTile().GetKey());
+		if (pinned != m_residentSlots.end())
+			m_slots[pinned->second].LastUsedFrame = frame;
+		else
+			m_requests.push_back(GetCoarsestTile());
+	}
+
+	int level = SelectLevel(view);
+	int x0, y0, x1, y1;
+	GetVisibleTiles(view, level, x0, y0, x1, y1);
+
+	const float centerX = (view.X0 + view.X1) * 0.5f / m_layout.GetScaleX(level);
+	const float centerY = (view.Y0 + view.Y1) * 0.5f / m_layout.GetScaleY(level);
+	std::vector<std::pair<float, TileId>> missing;
+	for (int y = y0; y <= y1; y++)
+	{
+		for (int x = x0; x <= x1; x++)
+		{
+			TileId tile{level, x, y};
+			auto resident = m_residentSlots.find(tile.GetKey());
+			if (resident != m_residentSlots.end())
+			{
+				m_slots[resident->second].LastUsedFrame = frame;
+				continue;
+			}
+
+			// The ancestor GetDraws falls back to is drawn this frame as well, so it must not be reused either.
+			for (TileId ancestor = tile; ancestor.Level < m_layout.NumLevels - 1;)
+			{
+				ancestor = TileId{ancestor.Level + 1, ancestor.X / 2, ancestor.Y / 2};
+				auto found = m_residentSlots.find(ancestor.GetKey());
+				if (found != m_residentSlots.end())
+				{
+					m_slots[found->second].LastUsedFrame = frame;
+					break;
+				}
+			}
+
+			float dx = (x + 0.5f) * APP_TILE_SIZE - centerX;
+			float dy = (y + 0.5f) * APP_TILE_SIZE - centerY;
+			missing.emplace_back(dx * dx + dy * dy, tile);
+		}
+	}
+
+	std::sort(missing.begin(), missing.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+	for (const auto& [distance, tile] : missing)
+	{
+		if (std::find(m_requests.begin(), m_requests.end(), tile) == m_requests.end())
+			m_requests.push_back(tile);
+	}
+}
+
+int TileResidency::FindSlot()
+{
+	const uint64_t pinnedKey = GetCoarsestTile().GetKey();
+	int best = -1;
+	for (int i = 0; i < static_cast<int>(m_slots.size()); i++)
+	{
+		const Slot& slot = m_slots[i];
+		if (!slot.Occupied)
+			return i;
+		if (slot.Tile.GetKey() == pinnedKey || slot.LastUsedFrame + m_framesInFlight >= m_frame)
+			continue;
+		if (best < 0 || slot.LastUsedFrame < m_slots[best].LastUsedFrame)
+			best = i;
+	}
+	return best;
+}
+
+void TileResidency::AllocateUploads(int maxUploads, std::vector<TileUpload>& out_uploads)
+{
+	size_t handled = 0;
+	for (; handled < m_requests.size() && maxUploads > 0; handled++)
+	{
+		const TileId& tile = m_requests[handled];
+		if (IsResident(tile))
+			continue;
+
+		int index = FindSlot();
+		if (index < 0)
+			break; // every slot is in view or still read by a frame in flight; fallbacks cover the rest
+
+		Slot& slot = m_slots[index];
+		if (slot.Occupied)
+		{
+			m_residentSlots.erase(slot.Tile.GetKey());
+			m_evictions++;
+		}
+		slot.Tile = tile;
+		slot.Occupied = true;
+		slot.LastUsedFrame = m_frame;
+		m_residentSlots[tile.GetKey()] = index;
+
+		out_uploads.push_back(TileUpload{tile, index});
+		m_uploads++;
+		maxUploads--;
+	}
+	m_requests.erase(m_requests.begin(), m_requests.begin() + handled);
+}
+
+void TileResidency::Discard(const TileUpload& upload)
+{
+	Slot& slot = m_slots[upload.Slot];
+	if (!slot.Occupied || !(slot.Tile == upload.Tile))
+		return;
+	m_residentSlots.erase(slot.Tile.GetKey());
+	slot = Slot{};
+	m_uploads--;
+}
+
+void TileResidency::GetDraws(const TileView& view, std::vector<TileDraw>& out_draws) const
+{
+	int level = SelectLevel(view);
+	int x0, y0, x1, y1;
+	GetVisibleTiles(view, level, x0, y0, x1, y1);
+
+	const float scaleX = m_layout.GetScaleX(level);
+	const float scaleY = m_layout.GetScaleY(level);
+	for (int y = y0; y <= y1; y++)
+	{
+		for (int x = x0; x <= x1; x++)
+		{
+			TileId tile{level, x, y};
+			auto resident = m_residentSlots.find(tile.GetKey());
+			while (resident == m_residentSlots.end() && tile.Level < m_layout.NumLevels - 1)
+			{
+				tile = TileId{tile.Level + 1, tile.X / 2, tile.Y / 2};
+				resident = m_residentSlots.find(tile.GetKey());
+			}
+			if (resident == m_residentSlots.end())
+				continue;
+
+			TileDraw draw;
+			draw.Slot = resident->second;
+			draw.X0 = x * APP_TILE_SIZE * scaleX;
+			draw.Y0 = y * APP_TILE_SIZE * scaleY;
+			draw.X1 = std::min(static_cast<float>(m_layout.Width), (x + 1) * APP_TILE_SIZE * scaleX);
+			draw.Y1 = std::min(static_cast<float>(m_layout.Height), (y + 1) * APP_TILE_SIZE * scaleY);
+
+			// Where the rectangle lands in the drawn tile's slot; levels are rounded down in size, so an
+			// ancestor can fall a fraction of a texel short and is clamped to its own texels.
+			const float tileScaleX = m_layout.GetScaleX(tile.Level);
+			const float tileScaleY = m_layout.GetScaleY(tile.Level);
+			const float originX = static_cast<float>(tile.X * APP_TILE_SIZE - APP_TILE_BORDER);
+			const float originY = static_cast<float>(tile.Y * APP_TILE_SIZE - APP_TILE_BORDER);
+			const float maxU = static_cast<float>(APP_TILE_BORDER + m_layout.GetTileWidth(tile));
+			const float maxV = static_cast<float>(APP_TILE_BORDER + m_layout.GetTileHeight(tile));
+			draw.U0 = std::clamp(draw.X0 / tileScaleX - originX, static_cast<float>(APP_TILE_BORDER), maxU);
+			draw.V0 = std::clamp(draw.Y0 / tileScaleY - originY, static_cast<float>(APP_TILE_BORDER), maxV);
+			draw.U1 = std::clamp(draw.X1 / tileScaleX - originX, static_cast<float>(APP_TILE_BORDER), maxU);
+			draw.V1 = std::clamp(draw.Y1 / tileScaleY - originY, static_cast<float>(APP_TILE_BORDER), maxV);
+			out_draws.push_back(draw);
+		}
+	}
+}
+
+bool TileResidency::HasPendingUploads() const
+{
+	for (const TileId& tile : m_requests)
+	{
+		if (!IsResident(tile))
+			return true;
+	}
+	return false;
+}
+
+TileResidencyStats TileResidency::GetStats() const
+{
+	TileResidencyStats stats;
+	stats.Uploads = m_uploads;
+	stats.Evictions = m_evictions;
+	stats.ResidentTiles = static_cast<int>(m_residentSlots.size());
+	stats.NumSlots = static_cast<int>(m_slots.size());
+	return stats;
+}
@@ -0,0 +1,164 @@
+#include "Stdafx.hpp"
+#include "image/TiledImage.h"
+
+namespace
+{
+	// Every tile is staged at the copy footprint's pitch; 258 * 4 bytes rounds up to 1280, and 258 such rows
+	// are a multiple of D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, so tiles can sit back to back.
+	constexpr UINT TILE_STAGING_ROW_PITCH = (APP_TILE_SLOT_SIZE * 4 + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) &
+		~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+	constexpr UINT64 TILE_STAGING_SIZE = static_cast<UINT64>(TILE_STAGING_ROW_PITCH) * APP_TILE_SLOT_SIZE;
+	static_assert(TILE_STAGING_SIZE % D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT == 0);
+}
+
+bool TiledImage::Create(
+	DecodedImage&& image,
+	ID3D12Device* device,
+	ExampleDescriptorHeapAllocator* srvAllocator,
+	int framesInFlight)
+{
+	if (!m_pyramid.Build(std::move(image)))
+	{
+		std::cerr << "Only RGBA8 images can be tiled." << std::endl;
+		return false;
+	}
+
+	D3D12_HEAP_PROPERTIES heapProps = {};
+	heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+	D3D12_RESOURCE_DESC resDesc = {};
+	resDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	resDesc.Width = APP_TILE_ATLAS_SIZE;
+	resDesc.Height = APP_TILE_ATLAS_SIZE;
+	resDesc.DepthOrArraySize = 1;
+	resDesc.MipLevels = 1;
+	resDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	resDesc.SampleDesc.Count = 1;
+	resDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	// Slots are written on the copy queue while frames in flight still sample other slots of the same
+	// texture; simultaneous access allows that and lets both queues promote it from COMMON implicitly.
+	resDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS;
+
+	HRESULT hr = device->CreateCommittedResource(
+		&heapProps,
+		D3D12_HEAP_FLAG_NONE,
+		&resDesc,
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(&m_atlas.TextureResource));
+	if (FAILED(hr))
+	{
+		std::cerr << "Failed to create tile atlas. HRESULT: " << std::hex << hr << std::dec << std::endl;
+		return false;
+	}
+	m_atlas.Format = resDesc.Format;
+	m_atlas.Width = APP_TILE_ATLAS_SIZE;
+	m_atlas.Height = APP_TILE_ATLAS_SIZE;
+	m_atlas.SourceWidth = m_pyramid.GetSourceWidth();
+	m_atlas.SourceHeight = m_pyramid.GetSourceHeight();
+	m_atlas.SizeInBytes = device->GetResourceAllocationInfo(0, 1, &resDesc).SizeInBytes;
+
+	if (!srvAllocator->Alloc(&m_atlas.SrvCpuDescriptorHandle, &m_atlas.SrvGpuDescriptorHandle, &m_atlas.SrvDescriptor))
+	{
+		m_atlas.Release(srvAllocator);
+		return false;
+	}
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Format = resDesc.Format;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MipLevels = 1;
+	device->CreateShaderResourceView(m_atlas.TextureResource.Get(), &srvDesc, m_atlas.SrvCpuDescriptorHandle);
+
+	m_residency.Initialize(m_pyramid.GetLayout(), APP_TILE_ATLAS_SLOTS_PER_SIDE * APP_TILE_ATLAS_SLOTS_PER_SIDE,
+	                       framesInFlight);
+	return true;
+}
+
+void TiledImage::Release(ExampleDescriptorHeapAllocator* srvAllocator)
+{
+	m_atlas.Release(srvAllocator);
+	m_pyramid = TilePyramid();
+	m_uploads.clear();
+	m_draws.clear();
+}
+
+void TiledImage::Draw(ImDrawList* drawList, const TileView& view, ImVec2 min, ImVec2 max,
+                      Dx12UploadQueue* uploadQueue)
+{
+	if (!m_atlas.TextureResource || view.X1 <= view.X0 || view.Y1 <= view.Y0)
+		return;
+
+	m_residency.Update(view, static_cast<uint64_t>(ImGui::GetFrameCount()));
+	m_uploads.clear();
+	m_residency.AllocateUploads(APP_MAX_TILE_UPLOADS_PER_DRAW, m_uploads);
+	if (!m_uploads.empty())
+		UploadTiles(uploadQueue);
+
+	m_draws.clear();
+	m_residency.GetDraws(view, m_draws);
+	if (m_draws.empty())
+		return;
+
+	uploadQueue->RequireForFrame(m_atlas.UploadFenceValue);
+
+	const float scaleX = (max.x - min.x) / (view.X1 - view.X0);
+	const float scaleY = (max.y - min.y) / (view.Y1 - view.Y0);
+	constexpr float ATLAS_TEXEL = 1.0f / APP_TILE_ATLAS_SIZE;
+	drawList->PushClipRect(min, max, true);
+	for (const TileDraw& draw : m_draws)
+	{
+		float slotX = static_cast<float>(draw.Slot % APP_TILE_ATLAS_SLOTS_PER_SIDE * APP_TILE_SLOT_SIZE);
+		float slotY = static_cast<float>(draw.Slot / APP_TILE_ATLAS_SLOTS_PER_SIDE * APP_TILE_SLOT_SIZE);
+		drawList->AddImage(m_atlas.SrvGpuDescriptorHandle.ptr,
+		                   ImVec2(min.x + (draw.X0 - view.X0) * scaleX, min.y + (draw.Y0 - view.Y0) * scaleY),
+		                   ImVec2(min.x + (draw.X1 - view.X0) * scaleX, min.y + (draw.Y1 - view.Y0) * scaleY),
+		                   ImVec2((slotX + draw.U0) * ATLAS_TEXEL, (slotY + draw.V0) * ATLAS_TEXEL),
+		                   ImVec2((slotX + draw.U1) * ATLAS_TEXEL, (slotY + draw.V1) * ATLAS_TEXEL));
+	}
+	drawList->PopClipRect();
+}
+
+void TiledImage::UploadTiles(Dx12UploadQueue* uploadQueue)
+{
+	ID3D12GraphicsCommandList* commandList = uploadQueue->BeginUpload();
+	Dx12UploadAllocation staging;
+	if (!commandList || !uploadQueue->AllocateStaging(TILE_STAGING_SIZE * m_uploads.size(), &staging))
+	{
+		if (commandList)
+			uploadQueue->EndUpload();
+		for (const TileUpload& upload : m_uploads)
+			m_residency.Discard(upload);
+		return;
+	}
+
+	D3D12_TEXTURE_COPY_LOCATION dst = {};
+	dst.pResource = m_atlas.TextureResource.Get();
+	dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+	dst.SubresourceIndex = 0;
+
+	D3D12_TEXTURE_COPY_LOCATION src = {};
+	src.pResource = staging.Resource;
+	src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+	src.PlacedFootprint.Footprint.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	src.PlacedFootprint.Footprint.Width = APP_TILE_SLOT_SIZE;
+	src.PlacedFootprint.Footprint.Height = APP_TILE_SLOT_SIZE;
+	src.PlacedFootprint.Footprint.Depth = 1;
+	src.PlacedFootprint.Footprint.RowPitch = TILE_STAGING_ROW_PITCH;
+
+	for (size_t i = 0; i < m_uploads.size(); i++)
+	{
+		const TileUpload& upload = m_uploads[i];
+		src.PlacedFootprint.Offset = staging.Offset + i * TILE_STAGING_SIZE;
+		m_pyramid.CopyTile(upload.Tile, static_cast<unsigned char*>(staging.MappedData) + src.PlacedFootprint.Offset,
+		                   TILE_STAGING_ROW_PITCH);
+
+		UINT slotX = upload.Slot % APP_TILE_ATLAS_SLOTS_PER_SIDE * APP_TILE_SLOT_SIZE;
+		UINT slotY = upload.Slot / APP_TILE_ATLAS_SLOTS_PER_SIDE * APP_TILE_SLOT_SIZE;
+		commandList->CopyTextureRegion(&dst, slotX, slotY, 0, &src, nullptr);
+	}
+
+	// No transition: the atlas decays back to COMMON when the copy list finishes.
+	m_atlas.UploadFenceValue = uploadQueue->EndUpload();
+}
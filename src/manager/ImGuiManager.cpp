@@ -1,10 +1,32 @@
 #include "Stdafx.hpp"
 #include "manager/ImGuiManager.h"
 
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
 Dx12Renderer* ImGuiManager::s_dx12Renderer = nullptr;
-std::map<std::string, ImGuiDx12Texture> ImGuiManager::s_loadedTextures;
+std::set<std::string> ImGuiManager::s_openImages;
+TextureCache<ImGuiDx12Texture> ImGuiManager::s_textureCache;
+TextureAtlas ImGuiManager::s_textureAtlas;
+TextureCache<TiledImage> ImGuiManager::s_tiledImages;
+std::map<std::string, AsyncImageHandle> ImGuiManager::s_pendingTextures;
+std::set<std::string> ImGuiManager::s_failedImages;
+std::vector<std::string> ImGuiManager::s_galleryImages;
+
+namespace
+{
+	// Full-size RGBA8 decodes past APP_TILED_IMAGE_MIN_DIMENSION. Block-compressed images are within
+	// APP_MAX_TEXTURE_DIMENSION (see BlockCompressor::CanCompress) and take a quarter or less of the memory,
+	// so they stay single textures.
+	bool IsTiledImage(const DecodedImage& image)
+	{
+		return image.Format == TextureFormat::Rgba8 &&
+			(image.Width > APP_TILED_IMAGE_MIN_DIMENSION || image.Height > APP_TILED_IMAGE_MIN_DIMENSION);
+	}
+}
 
 ImGuiManager::ImGuiManager() : m_renderer(nullptr)
 {
@@ -58,6 +80,8 @@ bool ImGuiManager::Initialize(HWND hWnd, Dx12Renderer* renderer)
 	init_info.RTVFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
 	init_info.DSVFormat = DXGI_FORMAT_UNKNOWN;
 	init_info.SrvDescriptorHeap = s_dx12Renderer->GetSrvDescriptorHeap();
+	// Every texture, the atlas pages and the font included, has its descriptor in that one heap.
+	init_info.BindlessTextures = true;
 
 	if (!init_info.Device || !init_info.CommandQueue || !init_info.SrvDescriptorHeap)
 	{
@@ -71,7 +95,8 @@ bool ImGuiManager::Initialize(HWND hWnd, Dx12Renderer* renderer)
 	{
 		if (s_dx12Renderer && s_dx12Renderer->GetSrvDescriptorHeapAllocator())
 		{
-			s_dx12Renderer->GetSrvDescriptorHeapAllocator()->Alloc(out_cpu_handle, out_gpu_handle);
+			if (!s_dx12Renderer->GetSrvDescriptorHeapAllocator()->Alloc(out_cpu_handle, out_gpu_handle))
+				std::cerr << "Error: no SRV descriptor left for ImGui texture!" << std::endl;
 		}
 		else
 		{
@@ -96,19 +121,58 @@ bool ImGuiManager::Initialize(HWND hWnd, Dx12Renderer* renderer)
 	};
 	ImGui_ImplDX12_Init(&init_info);
 
+	s_textureCache.Initialize(static_cast<uint64_t>(m_textureBudgetMB) * 1024 * 1024,
+	                          s_dx12Renderer->GetNumFramesInFlight(),
+	                          [](ImGuiDx12Texture& texture)
+	                          {
+		                          // Evicted before its copy even finished; rare, but the copy queue must let go first.
+		                          if (!s_dx12Renderer->GetUploadQueue()->IsComplete(texture.UploadFenceValue))
+			                          s_dx12Renderer->GetUploadQueue()->WaitIdle();
+		                          texture.Release(s_dx12Renderer->GetSrvDescriptorHeapAllocator());
+	                          },
+	                          [this](uint64_t contentHash) { m_imageLoader.ReleaseContent(contentHash); });
+	s_textureAtlas.Create(s_dx12Renderer->GetDevice(), s_dx12Renderer->GetTextureHeap(),
+	                      s_dx12Renderer->GetSrvDescriptorHeapAllocator(), s_dx12Renderer->GetNumFramesInFlight());
+	s_tiledImages.Initialize(static_cast<uint64_t>(APP_TILED_IMAGE_BUDGET_MB) * 1024 * 1024,
+	                         s_dx12Renderer->GetNumFramesInFlight(),
+	                         [](TiledImage& image)
+	                         {
+		                         if (!s_dx12Renderer->GetUploadQueue()->IsComplete(image.GetUploadFenceValue()))
+			                         s_dx12Renderer->GetUploadQueue()->WaitIdle();
+		                         image.Release(s_dx12Renderer->GetSrvDescriptorHeapAllocator());
+	                         },
+	                         [this](uint64_t contentHash) { m_imageLoader.ReleaseContent(contentHash); });
+
+	// Decoded images persist between runs; without a usable temp directory every start decodes from scratch.
+	std::error_code ec;
+	std::filesystem::path cacheDirectory = std::filesystem::temp_directory_path(ec) / "imgui-images" / "textures";
+	if (!ec && m_diskCache.Open(cacheDirectory.string(), static_cast<uint64_t>(m_diskCacheBudgetMB) * 1024 * 1024))
+		m_imageLoader.SetDiskCache(&m_diskCache);
+
+	m_imageLoader.Start();
+
 	return true;
 }
 
 void ImGuiManager::Shutdown()
 {
+	m_imageLoader.Shutdown();
+	m_diskCache.Close();
+	s_pendingTextures.clear();
+	m_decodedPaths.clear();
+	m_decodedImages.clear();
+	m_sharedImages.clear();
+
 	if (s_dx12Renderer && s_dx12Renderer->GetSrvDescriptorHeapAllocator())
 	{
-		for (auto& pair : s_loadedTextures)
-		{
-			pair.second.Release(s_dx12Renderer->GetSrvDescriptorHeapAllocator());
-		}
-		s_loadedTextures.clear();
+		s_textureCache.Clear();
+		s_textureAtlas.Release();
+		s_tiledImages.Clear();
 	}
+	m_tiledViews.clear();
+	s_openImages.clear();
+	s_failedImages.clear();
+	s_galleryImages.clear();
 
 	ImGui_ImplDX12_Shutdown();
 	ImGui_ImplWin32_Shutdown();
@@ -118,6 +182,11 @@ void ImGuiManager::Shutdown()
 
 void ImGuiManager::NewFrame()
 {
+	// Uploads no longer stall, but creating resources and staging pixels still costs UI time.
+	m_imageLoader.Publish(*this, 8);
+	UploadDecodedImages();
+	ShareDecodedImages();
+
 	ImGui_ImplDX12_NewFrame();
 	ImGui_ImplWin32_NewFrame();
 	ImGui::NewFrame();
@@ -127,6 +196,66 @@ void ImGuiManager::NewFrame()
 	ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Once);
 	ImGui::Begin("##fps", nullptr, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize);
 	ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
+	if (s_dx12Renderer)
+	{
+		const Dx12UploadStats& uploadStats = s_dx12Renderer->GetUploadQueue()->GetStats();
+		ImGui::Text("Uploads: %llu submissions, %llu barriers in %llu calls, %.1f MB staged",
+		            uploadStats.Submissions, uploadStats.Barriers, uploadStats.BarrierCalls,
+		            static_cast<double>(uploadStats.BytesStaged) / (1024.0 * 1024.0));
+		Dx12TextureHeapStats heapStats = s_dx12Renderer->GetTextureHeap()->GetStats();
+		ImGui::Text("Texture heaps: %u blocks, %.1f/%.1f MB placed in %u textures (%u at 4 KB), %u committed %.1f MB",
+		            heapStats.NumBlocks, static_cast<double>(heapStats.PlacedBytes) / (1024.0 * 1024.0),
+		            static_cast<double>(heapStats.BlockBytes) / (1024.0 * 1024.0), heapStats.NumPlaced,
+		            heapStats.NumSmallAligned, heapStats.NumCommitted,
+		            static_cast<double>(heapStats.CommittedBytes) / (1024.0 * 1024.0));
+		ImGui::Text("Largest free range %.1f MB in %u ranges, fragmentation %.0f%%",
+		            static_cast<double>(heapStats.LargestFreeRange) / (1024.0 * 1024.0), heapStats.NumFreeRanges,
+		            heapStats.Fragmentation * 100.0f);
+		if (ImGui_ImplDX12_IsBindless())
+		{
+			const ImGuiDrawMergeStats& mergeStats = s_dx12Renderer->GetDrawMergeStats();
+			ImGui::Text("Bindless: %u draws for %u draw commands, %u callbacks", mergeStats.NumDraws,
+			            mergeStats.NumCommands, mergeStats.NumCallbacks);
+		}
+		const ImGui_ImplDX12_BufferStats* bufferStats = ImGui_ImplDX12_GetBufferStats();
+		ImGui::Text("UI geometry: %.1f KB per frame, %.1f KB of buffers, %llu reallocations, %d retired",
+		            static_cast<double>(bufferStats->UploadedBytes) / 1024.0,
+		            static_cast<double>(bufferStats->CapacityBytes) / 1024.0, bufferStats->Reallocations,
+		            bufferStats->RetiredBuffers);
+	}
+
+	AtlasPackerStats atlasStats = s_textureAtlas.GetStats();
+	if (atlasStats.NumEntries != 0)
+		ImGui::Text("Atlas: %u small images in %u pages (%.1f MB), %.0f%% packing efficiency, %llu repacks",
+		            atlasStats.NumEntries, atlasStats.NumPages,
+		            static_cast<double>(s_textureAtlas.GetSizeInBytes()) / (1024.0 * 1024.0),
+		            atlasStats.GetEfficiency() * 100.0f, atlasStats.Repacks);
+
+	const TextureCacheStats& cacheStats = s_textureCache.GetStats();
+	ImGui::Text("Texture cache: %u textures for %u paths, %.1f MB resident, %.1f MB pending release",
+	            cacheStats.ResidentCount, cacheStats.KeyCount,
+	            static_cast<double>(cacheStats.ResidentBytes) / (1024.0 * 1024.0),
+	            static_cast<double>(cacheStats.PendingReleaseBytes) / (1024.0 * 1024.0));
+	ImGui::Text("Hits %llu, misses %llu, evictions %llu, shared %llu", cacheStats.Hits, cacheStats.Misses,
+	            cacheStats.Evictions, cacheStats.Shares);
+	const TextureCacheStats& tiledStats = s_tiledImages.GetStats();
+	if (tiledStats.ResidentCount != 0)
+		ImGui::Text("Tiled images: %u, %.1f MB of pyramids and atlases", tiledStats.ResidentCount,
+		            static_cast<double>(tiledStats.ResidentBytes) / (1024.0 * 1024.0));
+	ImGui::SetNextItemWidth(200.0f);
+	if (ImGui::SliderInt("Texture budget (MB)", &m_textureBudgetMB, 16, 4096))
+		s_textureCache.SetBudget(static_cast<uint64_t>(m_textureBudgetMB) * 1024 * 1024);
+
+	if (m_diskCache.IsOpen())
+	{
+		DiskCacheStats diskStats = m_diskCache.GetStats();
+		ImGui::Text("Disk cache: %u files, %.1f MB; hits %llu, misses %llu, evictions %llu", diskStats.NumFiles,
+		            static_cast<double>(diskStats.TotalBytes) / (1024.0 * 1024.0), diskStats.Hits, diskStats.Misses,
+		            diskStats.Evictions);
+		ImGui::SetNextItemWidth(200.0f);
+		if (ImGui::SliderInt("Disk cache budget (MB)", &m_diskCacheBudgetMB, 64, 16384))
+			m_diskCache.SetBudget(static_cast<uint64_t>(m_diskCacheBudgetMB) * 1024 * 1024);
+	}
 	ImGui::End();
 
 	ImGui::Begin("Images");
@@ -144,84 +273,546 @@ void ImGuiManager::NewFrame()
 		std::string path_str(IMAGE_PATH);
 		if (!path_str.empty())
 		{
-			if (!s_loadedTextures.contains(path_str))
+			if (s_openImages.contains(path_str))
+			{
+				std::cout << "Image '" << path_str << "' is already loaded." << std::endl;
+			}
+			else
+			{
+				s_failedImages.erase(path_str);
+				s_openImages.insert(path_str);
+			}
+		}
+	}
+
+	ImGui::SetNextItemWidth(desiredWidthPerItem);
+	ImGui::Checkbox("Decode at display size", &m_decodeAtDisplaySize);
+	ImGui::SameLine();
+	if (ImGui::Button("Load Directory", ImVec2(-1, 0)))
+	{
+		std::string path_str(IMAGE_PATH);
+		if (!path_str.empty())
+			LoadDirectory(path_str);
+	}
+
+	// Applies to images decoded from now on; textures already resident keep their format.
+	ImGui::Checkbox("Compress to BC1/BC7", &m_compression.Enabled);
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(-1);
+	ImGui::SliderInt("##compression_quality", &m_compression.Quality, 0, APP_MAX_BLOCK_COMPRESSION_QUALITY,
+	                 "Quality %d");
+
+	ImGui::End();
+
+	constexpr float MAX_IMAGE_SIZE = static_cast<float>(APP_MAX_IMAGE_SIZE);
+
+	for (const std::string& imagePath : s_openImages)
+	{
+		ImGui::PushID(imagePath.c_str());
+		if (ImGui::Begin(imagePath.c_str()))
+		{
+			ImGui::Text("Path: %s", imagePath.c_str());
+
+			// Only windows that are actually drawn touch the cache, so collapsed ones age out first.
+			TiledImage* tiledImage = FindTiledImage(imagePath);
+			const ImGuiDx12Texture* texture = tiledImage ? nullptr : AcquireTexture(imagePath, ImGui::GetFrameCount());
+
+			if (tiledImage)
+			{
+				DrawTiledImage(imagePath, *tiledImage);
+			}
+			else if (texture)
 			{
-				ImGuiDx12Texture newTexture;
-				if (s_dx12Renderer && s_dx12Renderer->GetDevice() &&
-					s_dx12Renderer->GetCommandQueue() &&
-					s_dx12Renderer->GetSrvDescriptorHeapAllocator())
+				ImGui::Text("Original Size: %dx%d", texture->SourceWidth, texture->SourceHeight);
+				if (texture->Width != texture->SourceWidth || texture->Height != texture->SourceHeight)
+					ImGui::Text("Texture Size: %dx%d", texture->Width, texture->Height);
+
+				ImGuiDx12TextureView view;
+				if (GetTextureView(*texture, &view))
 				{
-					if (ImageLoader::LoadTextureFromFile(
-						path_str,
-						s_dx12Renderer->GetDevice(),
-						s_dx12Renderer->GetCommandQueue(),
-						s_dx12Renderer->GetSrvDescriptorHeapAllocator(),
-						newTexture))
-					{
-						s_loadedTextures[path_str] = std::move(newTexture);
-						std::cout << "Image '" << path_str << "' loaded successfully!" << std::endl;
-					}
-					else
+					auto displaySize = ImVec2(static_cast<float>(texture->Width), static_cast<float>(texture->Height));
+
+					if (displaySize.x > MAX_IMAGE_SIZE || displaySize.y > MAX_IMAGE_SIZE)
 					{
-						std::cerr << "Failed to load image: " << path_str << std::endl;
+						if (displaySize.x > displaySize.y)
+						{
+							displaySize.y = displaySize.y / displaySize.x * MAX_IMAGE_SIZE;
+							displaySize.x = MAX_IMAGE_SIZE;
+						}
+						else
+						{
+							displaySize.x = displaySize.x / displaySize.y * MAX_IMAGE_SIZE;
+							displaySize.y = MAX_IMAGE_SIZE;
+						}
 					}
+
+					s_dx12Renderer->GetUploadQueue()->RequireForFrame(view.UploadFenceValue);
+					ImGui::Image(view.TextureId, displaySize, view.Uv0, view.Uv1);
 				}
 				else
 				{
-					std::cerr << "DX12 resources not available to load image." << std::endl;
+					ImGui::TextColored(ImVec4(1, 0, 0, 1), "Invalid or unloaded image resource.");
 				}
 			}
 			else
 			{
-				std::cout << "Image '" << path_str << "' is already loaded." << std::endl;
+				ImGui::TextDisabled("Loading...");
+
+				ImVec2 placeholderMin = ImGui::GetCursorScreenPos();
+				ImVec2 placeholderMax(placeholderMin.x + MAX_IMAGE_SIZE, placeholderMin.y + MAX_IMAGE_SIZE);
+				ImGui::GetWindowDrawList()->AddRectFilled(placeholderMin, placeholderMax,
+				                                          ImGui::GetColorU32(ImGuiCol_FrameBg));
+				ImGui::Dummy(ImVec2(MAX_IMAGE_SIZE, MAX_IMAGE_SIZE));
 			}
 		}
+		ImGui::End();
+		ImGui::PopID();
 	}
 
-	ImGui::End();
+	DrawGallery();
+
+	s_textureCache.EndFrame();
+	s_textureAtlas.EndFrame(s_dx12Renderer->GetUploadQueue());
+	s_tiledImages.EndFrame();
+}
 
-	constexpr float MAX_IMAGE_SIZE = 400.0f;
+void ImGuiManager::LoadDirectory(const std::string& directory)
+{
+	static const std::set<std::string> s_supportedExtensions = {
+		".png", ".jpg", ".jpeg", ".bmp", ".tga", ".gif", ".psd", ".pic", ".pnm", ".ppm", ".pgm", ".dds", ".ktx2"
+	};
 
-	for (const auto& pair : s_loadedTextures)
+	std::error_code error;
+	std::filesystem::directory_iterator it(directory, error);
+	if (error)
 	{
-		const std::string& imagePath = pair.first;
-		const ImGuiDx12Texture& texture = pair.second;
+		std::cerr << "Failed to open directory '" << directory << "': " << error.message() << std::endl;
+		return;
+	}
 
-		ImGui::PushID(imagePath.c_str());
-		if (ImGui::Begin(imagePath.c_str()))
-		{
-			ImGui::Text("Path: %s", imagePath.c_str());
-			ImGui::Text("Original Size: %dx%d", texture.Width, texture.Height);
+	std::vector<std::string> images;
+	for (; it != std::filesystem::directory_iterator(); it.increment(error))
+	{
+		if (error)
+			break;
+		if (!it->is_regular_file(error))
+			continue;
+
+		std::string extension = it->path().extension().string();
+		for (char& c : extension)
+			c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+		if (s_supportedExtensions.contains(extension))
+			images.push_back(it->path().string());
+	}
+	std::sort(images.begin(), images.end());
 
-			if (texture.TextureResource && texture.SrvGpuDescriptorHandle.ptr != 0)
-			{
-				auto displaySize = ImVec2(static_cast<float>(texture.Width), static_cast<float>(texture.Height));
+	// Nothing is decoded up front; the gallery requests whatever scrolls into view.
+	s_galleryImages = std::move(images);
+	std::cout << "Found " << s_galleryImages.size() << " images in '" << directory << "'." << std::endl;
+}
+
+void ImGuiManager::DrawGallery()
+{
+	if (s_galleryImages.empty())
+		return;
 
-				if (displaySize.x > MAX_IMAGE_SIZE || displaySize.y > MAX_IMAGE_SIZE)
+	constexpr float THUMBNAIL_SIZE = static_cast<float>(APP_THUMBNAIL_SIZE);
+
+	ImGui::SetNextWindowSize(ImVec2(720, 480), ImGuiCond_FirstUseEver);
+	if (ImGui::Begin("Gallery"))
+	{
+		ImGui::Text("%d images, %d decoding, %.1f MB decoded and waiting", static_cast<int>(s_galleryImages.size()),
+		            m_imageLoader.GetNumPending(),
+		            static_cast<double>(m_imageLoader.GetBytesInFlight()) / (1024.0 * 1024.0));
+
+		const ImGuiStyle& style = ImGui::GetStyle();
+		int columns = static_cast<int>(ImGui::GetContentRegionAvail().x / (THUMBNAIL_SIZE + style.ItemSpacing.x));
+		if (columns < 1)
+			columns = 1;
+		int numImages = static_cast<int>(s_galleryImages.size());
+		int rows = (numImages + columns - 1) / columns;
+
+		ImGui::BeginChild("##thumbnails");
+		ImGuiListClipper clipper;
+		clipper.Begin(rows, THUMBNAIL_SIZE + style.ItemSpacing.y);
+		int lastVisibleRow = -1;
+		int numVisibleRows = 0;
+		while (clipper.Step())
+		{
+			for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+			{
+				lastVisibleRow = row > lastVisibleRow ? row : lastVisibleRow;
+				numVisibleRows++;
+				for (int column = 0; column < columns; column++)
 				{
-					if (displaySize.x > displaySize.y)
+					int index = row * columns + column;
+					if (index >= numImages)
+						break;
+					const std::string& imagePath = s_galleryImages[index];
+					if (column > 0)
+						ImGui::SameLine();
+
+					ImGui::PushID(index);
+					ImVec2 cellMin = ImGui::GetCursorScreenPos();
+					bool clicked = ImGui::InvisibleButton("##cell", ImVec2(THUMBNAIL_SIZE, THUMBNAIL_SIZE));
+					ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+					// Every drawn cell bids with the current frame number, so whatever is on screen now is decoded
+					// before anything that scrolled past.
+					TiledImage* tiledImage = FindTiledImage(imagePath);
+					const ImGuiDx12Texture* texture =
+						tiledImage ? nullptr : AcquireTexture(imagePath, ImGui::GetFrameCount());
+					ImGuiDx12TextureView textureView;
+					if (tiledImage)
+					{
+						// The whole image at thumbnail size only ever needs the coarsest level or two.
+						float width = static_cast<float>(tiledImage->GetWidth());
+						float height = static_cast<float>(tiledImage->GetHeight());
+						ImVec2 size(THUMBNAIL_SIZE, THUMBNAIL_SIZE);
+						if (width > height)
+							size.y = THUMBNAIL_SIZE * height / width;
+						else
+							size.x = THUMBNAIL_SIZE * width / height;
+						ImVec2 imageMin(cellMin.x + (THUMBNAIL_SIZE - size.x) * 0.5f,
+						                cellMin.y + (THUMBNAIL_SIZE - size.y) * 0.5f);
+						TileView view{0.0f, 0.0f, width, height, size.x, size.y};
+						tiledImage->Draw(drawList, view, imageMin, ImVec2(imageMin.x + size.x, imageMin.y + size.y),
+						                 s_dx12Renderer->GetUploadQueue());
+					}
+					else if (texture && GetTextureView(*texture, &textureView))
 					{
-						displaySize.y = displaySize.y / displaySize.x * MAX_IMAGE_SIZE;
-						displaySize.x = MAX_IMAGE_SIZE;
+						ImVec2 size(THUMBNAIL_SIZE, THUMBNAIL_SIZE);
+						if (texture->Width > texture->Height)
+							size.y = THUMBNAIL_SIZE * texture->Height / texture->Width;
+						else
+							size.x = THUMBNAIL_SIZE * texture->Width / texture->Height;
+						ImVec2 imageMin(cellMin.x + (THUMBNAIL_SIZE - size.x) * 0.5f,
+						                cellMin.y + (THUMBNAIL_SIZE - size.y) * 0.5f);
+
+						// Images of one atlas page share a texture, so neighbouring thumbnails merge into one draw.
+						s_dx12Renderer->GetUploadQueue()->RequireForFrame(textureView.UploadFenceValue);
+						drawList->AddImage(textureView.TextureId, imageMin,
+						                   ImVec2(imageMin.x + size.x, imageMin.y + size.y), textureView.Uv0,
+						                   textureView.Uv1);
 					}
 					else
 					{
-						displaySize.x = displaySize.x / displaySize.y * MAX_IMAGE_SIZE;
-						displaySize.y = MAX_IMAGE_SIZE;
+						drawList->AddRectFilled(cellMin, ImVec2(cellMin.x + THUMBNAIL_SIZE, cellMin.y + THUMBNAIL_SIZE),
+						                        ImGui::GetColorU32(ImGuiCol_FrameBg));
+						drawList->AddText(ImVec2(cellMin.x + style.FramePadding.x, cellMin.y + style.FramePadding.y),
+						                  ImGui::GetColorU32(ImGuiCol_TextDisabled),
+						                  s_failedImages.contains(imagePath) ? "Failed" : "Loading...");
 					}
-				}
 
-				ImGui::Image(texture.SrvGpuDescriptorHandle.ptr, displaySize);
-			}
-			else
-			{
-				ImGui::TextColored(ImVec4(1, 0, 0, 1), "Invalid or unloaded image resource.");
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("%s", imagePath.c_str());
+					if (clicked)
+						s_openImages.insert(imagePath);
+					ImGui::PopID();
+				}
 			}
+		}
+		clipper.End();
 
-			ImGui::End();
+		// Queue the next screenful at the lowest priority so scrolling down finds it already decoded.
+		if (lastVisibleRow >= 0)
+		{
+			int firstIndex = (lastVisibleRow + 1) * columns;
+			int lastIndex = firstIndex + numVisibleRows * columns;
+			for (int index = firstIndex; index < lastIndex && index < numImages; index++)
+				PrefetchImage(s_galleryImages[index]);
 		}
-		ImGui::PopID();
+		ImGui::EndChild();
 	}
+	ImGui::End();
+}
+
+const ImGuiDx12Texture* ImGuiManager::AcquireTexture(const std::string& path, int priority)
+{
+	auto pending = s_pendingTextures.find(path);
+	if (pending != s_pendingTextures.end())
+	{
+		m_imageLoader.SetPriority(pending->second, priority);
+		return nullptr;
+	}
+	if (s_failedImages.contains(path))
+		return nullptr;
+
+	const ImGuiDx12Texture* texture = s_textureCache.Find(path);
+	if (!texture)
+		RequestImage(path, priority); // first use, or evicted earlier; stream it (back) in
+	return texture;
+}
+
+bool ImGuiManager::GetTextureView(const ImGuiDx12Texture& texture, ImGuiDx12TextureView* out_view)
+{
+	if (texture.Atlas)
+		return texture.Atlas->GetView(texture.AtlasEntry, out_view);
+	if (!texture.TextureResource || !s_dx12Renderer->GetSrvDescriptorHeapAllocator()->IsValid(texture.SrvDescriptor))
+		return false;
+
+	out_view->TextureId = texture.SrvGpuDescriptorHandle.ptr;
+	out_view->Uv0 = ImVec2(0.0f, 0.0f);
+	out_view->Uv1 = ImVec2(1.0f, 1.0f);
+	out_view->UploadFenceValue = texture.UploadFenceValue;
+	return true;
+}
+
+TiledImage* ImGuiManager::FindTiledImage(const std::string& path)
+{
+	// Contains first, so the far more common single-texture images do not count as misses.
+	return s_tiledImages.Contains(path) ? s_tiledImages.Find(path) : nullptr;
+}
+
+void ImGuiManager::DrawTiledImage(const std::string& path, TiledImage& image)
+{
+	ImGui::Text("Original Size: %dx%d", image.GetSourceWidth(), image.GetSourceHeight());
+	TileResidencyStats tileStats = image.GetStats();
+	ImGui::Text("Tiled: %d/%d tiles resident, %llu uploaded; scroll to zoom, drag to pan", tileStats.ResidentTiles,
+	            tileStats.NumSlots, tileStats.Uploads);
+
+	constexpr float MIN_VIEW_SIZE = static_cast<float>(APP_MAX_IMAGE_SIZE);
+	constexpr float MAX_ZOOM = 8.0f;
+	ImVec2 available = ImGui::GetContentRegionAvail();
+	ImVec2 size(available.x > MIN_VIEW_SIZE ? available.x : MIN_VIEW_SIZE,
+	            available.y > MIN_VIEW_SIZE ? available.y : MIN_VIEW_SIZE);
+	ImVec2 viewMin = ImGui::GetCursorScreenPos();
+	ImVec2 viewMax(viewMin.x + size.x, viewMin.y + size.y);
+	ImGui::InvisibleButton("##tiled_view", size);
+
+	const float width = static_cast<float>(image.GetWidth());
+	const float height = static_cast<float>(image.GetHeight());
+	const float fitZoom = size.x / width < size.y / height ? size.x / width : size.y / height;
+	TiledImageView& view = m_tiledViews[path];
+	if (view.Zoom <= 0.0f)
+	{
+		view.Zoom = fitZoom;
+		view.CenterX = width * 0.5f;
+		view.CenterY = height * 0.5f;
+	}
+
+	const ImGuiIO& io = ImGui::GetIO();
+	ImVec2 viewCenter((viewMin.x + viewMax.x) * 0.5f, (viewMin.y + viewMax.y) * 0.5f);
+	if (ImGui::IsItemHovered() && io.MouseWheel != 0.0f)
+	{
+		// Keep the image pixel under the cursor where it is.
+		float imageX = view.CenterX + (io.MousePos.x - viewCenter.x) / view.Zoom;
+		float imageY = view.CenterY + (io.MousePos.y - viewCenter.y) / view.Zoom;
+		view.Zoom = std::clamp(view.Zoom * std::pow(1.25f, io.MouseWheel), fitZoom, MAX_ZOOM);
+		view.CenterX = imageX - (io.MousePos.x - viewCenter.x) / view.Zoom;
+		view.CenterY = imageY - (io.MousePos.y - viewCenter.y) / view.Zoom;
+	}
+	if (ImGui::IsItemActive() && ImGui::IsMouseDragging(ImGuiMouseButton_Left))
+	{
+		view.CenterX -= io.MouseDelta.x / view.Zoom;
+		view.CenterY -= io.MouseDelta.y / view.Zoom;
+	}
+	view.Zoom = view.Zoom > fitZoom ? view.Zoom : fitZoom; // the window may have grown
+	view.CenterX = std::clamp(view.CenterX, 0.0f, width);
+	view.CenterY = std::clamp(view.CenterY, 0.0f, height);
+
+	TileView tileView;
+	tileView.X0 = view.CenterX - size.x * 0.5f / view.Zoom;
+	tileView.Y0 = view.CenterY - size.y * 0.5f / view.Zoom;
+	tileView.X1 = view.CenterX + size.x * 0.5f / view.Zoom;
+	tileView.Y1 = view.CenterY + size.y * 0.5f / view.Zoom;
+	tileView.ScreenWidth = size.x;
+	tileView.ScreenHeight = size.y;
+
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	drawList->AddRectFilled(viewMin, viewMax, ImGui::GetColorU32(ImGuiCol_FrameBg));
+	image.Draw(drawList, tileView, viewMin, viewMax, s_dx12Renderer->GetUploadQueue());
+}
+
+void ImGuiManager::PrefetchImage(const std::string& path)
+{
+	if (!s_pendingTextures.contains(path) && !s_failedImages.contains(path) && !s_textureCache.Contains(path) &&
+		!s_tiledImages.Contains(path))
+		RequestImage(path, 0);
+}
+
+void ImGuiManager::RequestImage(const std::string& path, int priority)
+{
+	AsyncImageHandle handle = m_imageLoader.Request(path, m_decodeAtDisplaySize ? APP_MAX_IMAGE_SIZE : 0, priority,
+	                                                m_compression);
+	if (handle != INVALID_ASYNC_IMAGE_HANDLE)
+		s_pendingTextures[path] = handle;
+	else
+		std::cerr << "Image loader is not running." << std::endl;
+}
+
+void ImGuiManager::UploadDecodedImages()
+{
+	if (m_decodedImages.empty())
+		return;
+
+	if (!s_dx12Renderer || !s_dx12Renderer->GetDevice() || !s_dx12Renderer->GetSrvDescriptorHeapAllocator())
+	{
+		std::cerr << "DX12 resources not available to load image." << std::endl;
+		for (const DecodedImage& image : m_decodedImages)
+			m_imageLoader.ReleaseContent(image.ContentHash);
+		m_decodedPaths.clear();
+		m_decodedImages.clear();
+		return;
+	}
+
+	// The loader shares content it has handed over, so a duplicate here means the texture came back in while
+	// this one was decoding; it is shared rather than uploaded twice.
+	for (size_t i = 0; i < m_decodedImages.size();)
+	{
+		uint64_t contentHash = m_decodedImages[i].ContentHash;
+		if (contentHash != 0 &&
+			(s_textureCache.ContainsContent(contentHash) || s_tiledImages.ContainsContent(contentHash)))
+		{
+			m_sharedImages.emplace_back(std::move(m_decodedPaths[i]), contentHash);
+			m_decodedPaths.erase(m_decodedPaths.begin() + i);
+			m_decodedImages.erase(m_decodedImages.begin() + i);
+			continue;
+		}
+		if (IsTiledImage(m_decodedImages[i]))
+		{
+			CreateTiledImage(m_decodedPaths[i], std::move(m_decodedImages[i]));
+			m_decodedPaths.erase(m_decodedPaths.begin() + i);
+			m_decodedImages.erase(m_decodedImages.begin() + i);
+			continue;
+		}
+		i++;
+	}
+
+	// Small images are packed into the atlas first; the rest, and any the atlas had no room for, get a texture
+	// of their own.
+	std::vector<ImGuiDx12Texture> newTextures(m_decodedImages.size());
+	std::vector<const DecodedImage*> images;
+	std::vector<size_t> indices;
+	for (size_t i = 0; i < m_decodedImages.size(); i++)
+	{
+		if (TextureAtlas::CanPack(m_decodedImages[i]))
+		{
+			images.push_back(&m_decodedImages[i]);
+			indices.push_back(i);
+		}
+	}
+	std::vector<ImGuiDx12Texture> createdTextures;
+	s_textureAtlas.AddImages(images.data(), images.size(), s_dx12Renderer->GetUploadQueue(), createdTextures);
+	for (size_t i = 0; i < createdTextures.size(); i++)
+		newTextures[indices[i]] = std::move(createdTextures[i]);
+
+	images.clear();
+	indices.clear();
+	for (size_t i = 0; i < m_decodedImages.size(); i++)
+	{
+		if (!newTextures[i].Atlas)
+		{
+			images.push_back(&m_decodedImages[i]);
+			indices.push_back(i);
+		}
+	}
+	ImageLoader::CreateTexturesFromImages(
+		images.data(),
+		images.size(),
+		s_dx12Renderer->GetDevice(),
+		s_dx12Renderer->GetTextureHeap(),
+		s_dx12Renderer->GetUploadQueue(),
+		s_dx12Renderer->GetSrvDescriptorHeapAllocator(),
+		createdTextures);
+	for (size_t i = 0; i < createdTextures.size(); i++)
+		newTextures[indices[i]] = std::move(createdTextures[i]);
+
+	for (size_t i = 0; i < newTextures.size(); i++)
+	{
+		const std::string& path = m_decodedPaths[i];
+		uint64_t contentHash = m_decodedImages[i].ContentHash;
+		if (newTextures[i].TextureResource || newTextures[i].Atlas)
+		{
+			UINT64 sizeInBytes = newTextures[i].SizeInBytes;
+			s_textureCache.Insert(path, std::move(newTextures[i]), sizeInBytes, contentHash);
+			std::cout << "Image '" << path << "' loaded successfully!" << std::endl;
+		}
+		else
+		{
+			m_imageLoader.ReleaseContent(contentHash);
+			s_openImages.erase(path);
+			s_failedImages.insert(path);
+			std::cerr << "Failed to load image: " << path << std::endl;
+		}
+	}
+
+	m_decodedPaths.clear();
+	m_decodedImages.clear();
+}
+
+void ImGuiManager::CreateTiledImage(const std::string& path, DecodedImage&& image)
+{
+	uint64_t contentHash = image.ContentHash;
+	TiledImage tiledImage;
+	if (!tiledImage.Create(std::move(image), s_dx12Renderer->GetDevice(),
+	                       s_dx12Renderer->GetSrvDescriptorHeapAllocator(), s_dx12Renderer->GetNumFramesInFlight()))
+	{
+		tiledImage.Release(s_dx12Renderer->GetSrvDescriptorHeapAllocator());
+		m_imageLoader.ReleaseContent(contentHash);
+		s_openImages.erase(path);
+		s_failedImages.insert(path);
+		std::cerr << "Failed to load image: " << path << std::endl;
+		return;
+	}
+
+	uint64_t sizeInBytes = tiledImage.GetSizeInBytes();
+	const TiledImage& inserted = s_tiledImages.Insert(path, std::move(tiledImage), sizeInBytes, contentHash);
+	std::cout << "Image '" << path << "' loaded as " << inserted.GetStats().NumSlots << "-slot tiled image ("
+		<< inserted.GetWidth() << "x" << inserted.GetHeight() << ")." << std::endl;
+}
+
+void ImGuiManager::OnImageDecoded(AsyncImageHandle handle, const std::string& path, DecodedImage& image)
+{
+	auto it = s_pendingTextures.find(path);
+	if (it == s_pendingTextures.end() || it->second != handle)
+	{
+		// Nothing will hold it, so the next request for these bytes has to decode them.
+		if (!s_textureCache.ContainsContent(image.ContentHash) &&
+			!s_tiledImages.ContainsContent(image.ContentHash))
+			m_imageLoader.ReleaseContent(image.ContentHash);
+		return;
+	}
+	s_pendingTextures.erase(it);
+
+	// Collected here and uploaded together by UploadDecodedImages().
+	m_decodedPaths.push_back(path);
+	m_decodedImages.push_back(std::move(image));
+}
+
+void ImGuiManager::OnImageShared(AsyncImageHandle handle, const std::string& path, uint64_t contentHash)
+{
+	auto it = s_pendingTextures.find(path);
+	if (it == s_pendingTextures.end() || it->second != handle)
+		return;
+	s_pendingTextures.erase(it);
+
+	// The texture may still be waiting in m_decodedImages, so sharing waits for UploadDecodedImages().
+	m_sharedImages.emplace_back(path, contentHash);
+}
+
+void ImGuiManager::ShareDecodedImages()
+{
+	for (const auto& [path, contentHash] : m_sharedImages)
+	{
+		// Gone when it was evicted, or failed to upload, after the loader matched it; decode this file after all.
+		if (!s_textureCache.Share(path, contentHash) && !s_tiledImages.Share(path, contentHash))
+			RequestImage(path, 0);
+	}
+	m_sharedImages.clear();
+}
+
+void ImGuiManager::OnImageFailed(AsyncImageHandle handle, const std::string& path)
+{
+	auto it = s_pendingTextures.find(path);
+	if (it != s_pendingTextures.end() && it->second == handle)
+	{
+		s_pendingTextures.erase(it);
+		s_openImages.erase(path);
+		s_failedImages.insert(path);
+	}
+
+	std::cerr << "Failed to load image: " << path << std::endl;
 }
 
 void ImGuiManager::Render()
@@ -0,0 +1,127 @@
+#include "render/DescriptorIndexAllocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+void DescriptorIndexAllocator::Initialize(uint32_t pageSize, uint32_t maxDescriptors)
+{
+	assert(pageSize > 0 && pageSize % 64 == 0 && "Page size must be a multiple of 64.");
+	assert(maxDescriptors > 0);
+	m_pageSize = pageSize;
+	m_maxDescriptors = maxDescriptors;
+	Reset();
+}
+
+void DescriptorIndexAllocator::Reset()
+{
+	m_freeBits.clear();
+	m_summaryBits.clear();
+	m_generations.clear();
+	m_numPages = 0;
+	m_numAllocated = 0;
+	m_firstFreeSummaryWord = 0;
+}
+
+uint32_t DescriptorIndexAllocator::GetCommittedCapacity() const
+{
+	return std::min(m_numPages * m_pageSize, m_maxDescriptors);
+}
+
+size_t DescriptorIndexAllocator::GetMemoryUsage() const
+{
+	return m_freeBits.capacity() * sizeof(uint64_t) + m_summaryBits.capacity() * sizeof(uint64_t) +
+		m_generations.capacity() * sizeof(uint32_t);
+}
+
+bool DescriptorIndexAllocator::AddPage()
+{
+	uint32_t firstIndex = GetCommittedCapacity();
+	if (firstIndex >= m_maxDescriptors)
+		return false;
+
+	uint32_t endIndex = std::min(firstIndex + m_pageSize, m_maxDescriptors);
+	m_numPages++;
+
+	size_t numWords = (static_cast<size_t>(m_numPages) * m_pageSize) / 64;
+	m_freeBits.resize(numWords, 0);
+	m_summaryBits.resize((numWords + 63) / 64, 0);
+	m_generations.resize(endIndex, 0);
+
+	for (uint32_t index = firstIndex; index < endIndex; index++)
+		MarkFree(index);
+	return true;
+}
+
+bool DescriptorIndexAllocator::IsAllocated(uint32_t index) const
+{
+	return index < GetCommittedCapacity() && (m_freeBits[index / 64] & (1ull << (index % 64))) == 0;
+}
+
+void DescriptorIndexAllocator::MarkFree(uint32_t index)
+{
+	uint32_t word = index / 64;
+	m_freeBits[word] |= 1ull << (index % 64);
+	m_summaryBits[word / 64] |= 1ull << (word % 64);
+	m_firstFreeSummaryWord = std::min<size_t>(m_firstFreeSummaryWord, word / 64);
+}
+
+bool DescriptorIndexAllocator::Allocate(DescriptorHandle* out_handle)
+{
+	for (int attempt = 0; attempt < 2; attempt++)
+	{
+		// Summary words below the hint are known to be full, so filling a large heap does not rescan them.
+		for (size_t summaryWord = m_firstFreeSummaryWord; summaryWord < m_summaryBits.size(); summaryWord++)
+		{
+			uint64_t summary = m_summaryBits[summaryWord];
+			if (summary == 0)
+			{
+				m_firstFreeSummaryWord = summaryWord + 1;
+				continue;
+			}
+
+			size_t word = summaryWord * 64 + std::countr_zero(summary);
+			uint64_t bits = m_freeBits[word];
+			uint32_t index = static_cast<uint32_t>(word * 64 + std::countr_zero(bits));
+
+			bits &= bits - 1;
+			m_freeBits[word] = bits;
+			if (bits == 0)
+				m_summaryBits[summaryWord] &= ~(1ull << (word % 64));
+
+			m_numAllocated++;
+			out_handle->Index = index;
+			out_handle->Generation = m_generations[index];
+			return true;
+		}
+
+		if (!AddPage())
+			break;
+	}
+
+	*out_handle = {};
+	return false;
+}
+
+bool DescriptorIndexAllocator::Free(DescriptorHandle handle)
+{
+	if (!IsValid(handle))
+		return false;
+	return FreeIndex(handle.Index);
+}
+
+bool DescriptorIndexAllocator::FreeIndex(uint32_t index)
+{
+	if (!IsAllocated(index))
+		return false;
+
+	m_generations[index]++;
+	MarkFree(index);
+	m_numAllocated--;
+	return true;
+}
+
+bool DescriptorIndexAllocator::IsValid(DescriptorHandle handle) const
+{
+	return IsAllocated(handle.Index) && m_generations[handle.Index] == handle.Generation;
+}
@@ -5,43 +5,68 @@
 #include <dxgidebug.h>
 #endif
 
-void ExampleDescriptorHeapAllocator::Create(ID3D12Device* device, ID3D12DescriptorHeap* heap)
+void ExampleDescriptorHeapAllocator::Create(ID3D12Device* device, ID3D12DescriptorHeap* heap, UINT pageSize)
 {
-	IM_ASSERT(Heap == nullptr && FreeIndices.empty());
+	IM_ASSERT(Heap == nullptr);
 	Heap = heap;
 	D3D12_DESCRIPTOR_HEAP_DESC desc = heap->GetDesc();
 	HeapType = desc.Type;
 	HeapStartCpu = Heap->GetCPUDescriptorHandleForHeapStart();
 	HeapStartGpu = Heap->GetGPUDescriptorHandleForHeapStart();
 	HeapHandleIncrement = device->GetDescriptorHandleIncrementSize(HeapType);
-	FreeIndices.reserve(static_cast<int>(desc.NumDescriptors));
-	for (int n = desc.NumDescriptors; n > 0; n--)
-		FreeIndices.push_back(n - 1);
+	Indices.Initialize(pageSize, desc.NumDescriptors);
 }
 
 void ExampleDescriptorHeapAllocator::Destroy()
 {
 	Heap = nullptr;
-	FreeIndices.clear();
+	Indices.Reset();
 }
 
-void ExampleDescriptorHeapAllocator::Alloc(D3D12_CPU_DESCRIPTOR_HANDLE* out_cpu_desc_handle,
-                                           D3D12_GPU_DESCRIPTOR_HANDLE* out_gpu_desc_handle)
+bool ExampleDescriptorHeapAllocator::Alloc(D3D12_CPU_DESCRIPTOR_HANDLE* out_cpu_desc_handle,
+                                           D3D12_GPU_DESCRIPTOR_HANDLE* out_gpu_desc_handle,
+                                           DescriptorHandle* out_handle)
 {
-	IM_ASSERT(FreeIndices.Size > 0);
-	int idx = FreeIndices.back();
-	FreeIndices.pop_back();
-	out_cpu_desc_handle->ptr = HeapStartCpu.ptr + (idx * HeapHandleIncrement);
-	out_gpu_desc_handle->ptr = HeapStartGpu.ptr + (idx * HeapHandleIncrement);
+	DescriptorHandle handle;
+	if (!Indices.Allocate(&handle))
+	{
+		std::cerr << "SRV descriptor heap is full (" << Indices.GetMaxDescriptors() << " descriptors)." << std::endl;
+		*out_cpu_desc_handle = {};
+		*out_gpu_desc_handle = {};
+		if (out_handle)
+			*out_handle = {};
+		return false;
+	}
+	out_cpu_desc_handle->ptr = HeapStartCpu.ptr + (static_cast<SIZE_T>(handle.Index) * HeapHandleIncrement);
+	out_gpu_desc_handle->ptr = HeapStartGpu.ptr + (static_cast<UINT64>(handle.Index) * HeapHandleIncrement);
+	if (out_handle)
+		*out_handle = handle;
+	return true;
 }
 
-void ExampleDescriptorHeapAllocator::Free(D3D12_CPU_DESCRIPTOR_HANDLE out_cpu_desc_handle,
+bool ExampleDescriptorHeapAllocator::Free(D3D12_CPU_DESCRIPTOR_HANDLE out_cpu_desc_handle,
                                           D3D12_GPU_DESCRIPTOR_HANDLE out_gpu_desc_handle)
 {
-	int cpu_idx = static_cast<int>((out_cpu_desc_handle.ptr - HeapStartCpu.ptr) / HeapHandleIncrement);
-	int gpu_idx = static_cast<int>((out_gpu_desc_handle.ptr - HeapStartGpu.ptr) / HeapHandleIncrement);
+	auto cpu_idx = static_cast<uint32_t>((out_cpu_desc_handle.ptr - HeapStartCpu.ptr) / HeapHandleIncrement);
+	auto gpu_idx = static_cast<uint32_t>((out_gpu_desc_handle.ptr - HeapStartGpu.ptr) / HeapHandleIncrement);
 	IM_ASSERT(cpu_idx == gpu_idx);
-	FreeIndices.push_back(cpu_idx);
+	if (!Indices.FreeIndex(cpu_idx))
+	{
+		std::cerr << "Attempted to free SRV descriptor " << cpu_idx << " which is not allocated." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool ExampleDescriptorHeapAllocator::Free(DescriptorHandle handle)
+{
+	if (!Indices.Free(handle))
+	{
+		std::cerr << "Attempted to free stale SRV descriptor handle " << handle.Index << " (generation "
+			<< handle.Generation << ")." << std::endl;
+		return false;
+	}
+	return true;
 }
 
 
@@ -90,12 +115,29 @@ void Dx12Renderer::Render(ImDrawData* draw_data, ImVec4 clear_color)
 	                                         nullptr);
 	g_pd3dCommandList->OMSetRenderTargets(1, &g_mainRenderTargetDescriptor[backBufferIdx], FALSE, nullptr);
 	g_pd3dCommandList->SetDescriptorHeaps(1, &g_pd3dSrvDescHeap);
+	if (ImGui_ImplDX12_IsBindless())
+	{
+		// Merging looks up every command's texture index, so the font atlas must have its descriptor by now; the
+		// backend finds nothing left to update.
+		if (draw_data->Textures != nullptr)
+			for (ImTextureData* tex : *draw_data->Textures)
+				if (tex->Status != ImTextureStatus_OK)
+					ImGui_ImplDX12_UpdateTexture(tex);
+		g_drawMerger.Merge(draw_data,
+		                   [](ImTextureID textureId, void*) { return ImGui_ImplDX12_GetTextureIndex(textureId); },
+		                   nullptr);
+	}
 	ImGui_ImplDX12_RenderDrawData(draw_data, g_pd3dCommandList);
 	barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
 	barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
 	g_pd3dCommandList->ResourceBarrier(1, &barrier);
 	g_pd3dCommandList->Close();
 
+	// GPU-side wait only when this frame samples a texture whose copy has not finished yet.
+	UINT64 uploadFenceValue = g_uploadQueue.ConsumeFrameWait();
+	if (uploadFenceValue != 0)
+		g_pd3dCommandQueue->Wait(g_uploadQueue.GetFence(), uploadFenceValue);
+
 	g_pd3dCommandQueue->ExecuteCommandLists(1, (ID3D12CommandList* const*)&g_pd3dCommandList);
 
 	HRESULT hr = g_pSwapChain->Present(1, 0);
@@ -110,6 +152,8 @@ void Dx12Renderer::Render(ImDrawData* draw_data, ImVec4 clear_color)
 
 void Dx12Renderer::WaitForLastSubmittedFrame()
 {
+	g_uploadQueue.WaitIdle();
+
 	FrameContext* frameCtx = &g_frameContext[g_frameIndex % APP_NUM_FRAMES_IN_FLIGHT];
 
 	UINT64 fenceValue = frameCtx->FenceValue;
@@ -202,11 +246,11 @@ bool Dx12Renderer::CreateDeviceD3D(HWND hWnd)
 	{
 		D3D12_DESCRIPTOR_HEAP_DESC desc = {};
 		desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-		desc.NumDescriptors = APP_SRV_HEAP_SIZE;
+		desc.NumDescriptors = APP_SRV_HEAP_MAX_SIZE;
 		desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 		if (g_pd3dDevice->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&g_pd3dSrvDescHeap)) != S_OK)
 			return false;
-		g_pd3dSrvDescHeapAlloc.Create(g_pd3dDevice, g_pd3dSrvDescHeap);
+		g_pd3dSrvDescHeapAlloc.Create(g_pd3dDevice, g_pd3dSrvDescHeap, APP_SRV_HEAP_PAGE_SIZE);
 	}
 
 	{
@@ -218,6 +262,9 @@ bool Dx12Renderer::CreateDeviceD3D(HWND hWnd)
 			return false;
 	}
 
+	if (!g_uploadQueue.Create(g_pd3dDevice) || !g_textureHeap.Create(g_pd3dDevice))
+		return false;
+
 	for (UINT i = 0; i < APP_NUM_FRAMES_IN_FLIGHT; i++)
 		if (g_pd3dDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
 		                                         IID_PPV_ARGS(&g_frameContext[i].CommandAllocator)) != S_OK)
@@ -274,6 +321,8 @@ void Dx12Renderer::CleanupDeviceD3D()
 			g_frameContext[i].CommandAllocator->Release();
 			g_frameContext[i].CommandAllocator = nullptr;
 		}
+	g_textureHeap.Destroy();
+	g_uploadQueue.Destroy();
 	if (g_pd3dCommandQueue)
 	{
 		g_pd3dCommandQueue->Release();
@@ -0,0 +1,223 @@
+#include "Stdafx.hpp"
+#include "render/Dx12TextureHeap.h"
+
+namespace
+{
+	// Small-resource placement is only granted when the most detailed level fits in sixteen 4 KB tiles; asking
+	// for it otherwise makes the debug layer report an error. The tile shapes are the standard swizzle's for
+	// each element size, counted in 4x4 blocks for block-compressed formats.
+	bool CanUseSmallAlignment(const D3D12_RESOURCE_DESC& desc)
+	{
+		if (desc.Dimension != D3D12_RESOURCE_DIMENSION_TEXTURE2D || desc.DepthOrArraySize != 1 ||
+			desc.SampleDesc.Count > 1 ||
+			(desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0)
+			return false;
+
+		UINT64 width = desc.Width;
+		UINT64 height = desc.Height;
+		UINT tileWidth = 0;
+		UINT tileHeight = 0;
+		switch (desc.Format)
+		{
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+			tileWidth = 32;
+			tileHeight = 32;
+			break;
+		case DXGI_FORMAT_BC1_UNORM:
+			width = (width + 3) / 4;
+			height = (height + 3) / 4;
+			tileWidth = 32;
+			tileHeight = 16;
+			break;
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC5_UNORM:
+		case DXGI_FORMAT_BC7_UNORM:
+			width = (width + 3) / 4;
+			height = (height + 3) / 4;
+			tileWidth = 16;
+			tileHeight = 16;
+			break;
+		default:
+			return false;
+		}
+		return ((width + tileWidth - 1) / tileWidth) * ((height + tileHeight - 1) / tileHeight) <= 16;
+	}
+}
+
+bool Dx12TextureHeap::Create(ID3D12Device* device, UINT64 blockSize)
+{
+	m_device = device;
+	m_blockSize = blockSize;
+	return m_device != nullptr && m_blockSize % D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT == 0;
+}
+
+void Dx12TextureHeap::Destroy()
+{
+	m_blocks.clear();
+	m_device = nullptr;
+	m_numCommitted = 0;
+	m_committedBytes = 0;
+	m_numSmallAligned = 0;
+}
+
+HRESULT Dx12TextureHeap::CreateTexture(
+	const D3D12_RESOURCE_DESC& desc,
+	D3D12_RESOURCE_STATES initialState,
+	Microsoft::WRL::ComPtr<ID3D12Resource>& out_resource,
+	Dx12TextureAllocation* out_allocation)
+{
+	*out_allocation = {};
+
+	// The runtime has the final say on small alignment: when it does not grant it, use the default 64 KB.
+	D3D12_RESOURCE_DESC placedDesc = desc;
+	placedDesc.Alignment = CanUseSmallAlignment(desc) ? D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT : 0;
+	D3D12_RESOURCE_ALLOCATION_INFO info = m_device->GetResourceAllocationInfo(0, 1, &placedDesc);
+	if (placedDesc.Alignment != 0 && info.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+	{
+		placedDesc.Alignment = 0;
+		info = m_device->GetResourceAllocationInfo(0, 1, &placedDesc);
+	}
+
+	if (info.SizeInBytes != UINT64_MAX && info.SizeInBytes <= APP_TEXTURE_HEAP_MAX_PLACED_SIZE &&
+		PlaceTexture(placedDesc, info, initialState, out_resource, out_allocation))
+		return S_OK;
+
+	D3D12_HEAP_PROPERTIES heapProps = {};
+	heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+	D3D12_RESOURCE_DESC committedDesc = desc;
+	committedDesc.Alignment = 0;
+	HRESULT hr = m_device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &committedDesc, initialState,
+	                                               nullptr, IID_PPV_ARGS(&out_resource));
+	if (FAILED(hr))
+		return hr;
+
+	out_allocation->SizeInBytes = m_device->GetResourceAllocationInfo(0, 1, &committedDesc).SizeInBytes;
+	m_numCommitted++;
+	m_committedBytes += out_allocation->SizeInBytes;
+	return S_OK;
+}
+
+bool Dx12TextureHeap::PlaceTexture(
+	const D3D12_RESOURCE_DESC& desc,
+	const D3D12_RESOURCE_ALLOCATION_INFO& info,
+	D3D12_RESOURCE_STATES initialState,
+	Microsoft::WRL::ComPtr<ID3D12Resource>& out_resource,
+	Dx12TextureAllocation* out_allocation)
+{
+	// Lowest block first, so the later ones drain and can be released.
+	UINT block = UINT_MAX;
+	TlsfAllocation range;
+	for (UINT i = 0; i < m_blocks.size() && block == UINT_MAX; i++)
+	{
+		if (m_blocks[i].Heap && m_blocks[i].Allocator.Allocate(info.SizeInBytes, info.Alignment, &range))
+			block = i;
+	}
+	if (block == UINT_MAX)
+	{
+		block = AddBlock();
+		if (block == UINT_MAX || !m_blocks[block].Allocator.Allocate(info.SizeInBytes, info.Alignment, &range))
+			return false;
+	}
+
+	HRESULT hr = m_device->CreatePlacedResource(m_blocks[block].Heap.Get(), range.Offset, &desc, initialState,
+	                                            nullptr, IID_PPV_ARGS(&out_resource));
+	if (FAILED(hr))
+	{
+		Dx12TextureAllocation failed;
+		failed.Block = block;
+		failed.Range = range;
+		Free(failed);
+		return false;
+	}
+
+	out_allocation->Block = block;
+	out_allocation->Range = range;
+	out_allocation->SizeInBytes = range.Size;
+	out_allocation->SmallAlignment = info.Alignment == D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+	if (out_allocation->SmallAlignment)
+		m_numSmallAligned++;
+	return true;
+}
+
+UINT Dx12TextureHeap::AddBlock()
+{
+	D3D12_HEAP_DESC heapDesc = {};
+	heapDesc.SizeInBytes = m_blockSize;
+	heapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+	heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	// Resource heap tier 1 devices cannot mix buffers, textures and render targets in one heap.
+	heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+
+	Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+	HRESULT hr = m_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap));
+	if (FAILED(hr))
+	{
+		std::cerr << "Failed to create texture heap. HRESULT: " << std::hex << hr << std::dec << std::endl;
+		return UINT_MAX;
+	}
+
+	UINT index = 0;
+	while (index < m_blocks.size() && m_blocks[index].Heap)
+		index++;
+	if (index == m_blocks.size())
+		m_blocks.emplace_back();
+	m_blocks[index].Heap = std::move(heap);
+	m_blocks[index].Allocator.Initialize(m_blockSize, D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT);
+	return index;
+}
+
+void Dx12TextureHeap::Free(Dx12TextureAllocation& allocation)
+{
+	if (!allocation.IsPlaced())
+	{
+		if (allocation.SizeInBytes != 0)
+		{
+			m_numCommitted--;
+			m_committedBytes -= allocation.SizeInBytes;
+		}
+		allocation = {};
+		return;
+	}
+
+	Block& block = m_blocks[allocation.Block];
+	if (block.Allocator.Free(allocation.Range) && allocation.SmallAlignment)
+		m_numSmallAligned--;
+
+	if (block.Allocator.IsEmpty())
+	{
+		UINT numEmpty = 0;
+		for (const Block& other : m_blocks)
+			if (other.Heap && other.Allocator.IsEmpty())
+				numEmpty++;
+		if (numEmpty > APP_TEXTURE_HEAP_SPARE_BLOCKS)
+			block.Heap.Reset();
+	}
+	allocation = {};
+}
+
+Dx12TextureHeapStats Dx12TextureHeap::GetStats() const
+{
+	Dx12TextureHeapStats stats;
+	UINT64 freeBytes = 0;
+	for (const Block& block : m_blocks)
+	{
+		if (!block.Heap)
+			continue;
+		TlsfStats blockStats = block.Allocator.GetStats();
+		stats.NumBlocks++;
+		stats.BlockBytes += blockStats.Capacity;
+		stats.PlacedBytes += blockStats.UsedBytes;
+		stats.NumPlaced += blockStats.NumAllocations;
+		stats.NumFreeRanges += blockStats.NumFreeBlocks;
+		if (blockStats.LargestFreeBlock > stats.LargestFreeRange)
+			stats.LargestFreeRange = blockStats.LargestFreeBlock;
+		freeBytes += blockStats.GetFreeBytes();
+	}
+	stats.NumSmallAligned = m_numSmallAligned;
+	stats.NumCommitted = m_numCommitted;
+	stats.CommittedBytes = m_committedBytes;
+	if (freeBytes != 0)
+		stats.Fragmentation = 1.0f - static_cast<float>(stats.LargestFreeRange) / static_cast<float>(freeBytes);
+	return stats;
+}
@@ -0,0 +1,243 @@
+#include "Stdafx.hpp"
+#include "render/Dx12UploadQueue.h"
+
+Dx12UploadQueue::~Dx12UploadQueue()
+{
+	Destroy();
+}
+
+bool Dx12UploadQueue::Create(ID3D12Device* device)
+{
+	IM_ASSERT(m_device == nullptr);
+	m_device = device;
+
+	D3D12_COMMAND_QUEUE_DESC desc = {};
+	desc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	desc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	desc.NodeMask = 1;
+	if (device->CreateCommandQueue(&desc, IID_PPV_ARGS(&m_commandQueue)) != S_OK)
+		return false;
+
+	if (device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)) != S_OK)
+		return false;
+
+	m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if (m_fenceEvent == nullptr)
+		return false;
+
+	if (!m_ring.Create(device, APP_UPLOAD_RING_SIZE))
+		return false;
+
+	m_scheduler.Initialize(this, APP_NUM_UPLOAD_CONTEXTS);
+	return true;
+}
+
+void Dx12UploadQueue::Destroy()
+{
+	if (m_fence)
+		m_scheduler.Shutdown();
+
+	m_deferredReleases.clear();
+	m_pendingBarriers.clear();
+	m_ring.Destroy();
+	m_contexts.clear();
+	m_recordingContext = UINT_MAX;
+	m_fence.Reset();
+	if (m_fenceEvent)
+	{
+		CloseHandle(m_fenceEvent);
+		m_fenceEvent = nullptr;
+	}
+	m_commandQueue.Reset();
+	m_device = nullptr;
+}
+
+ID3D12GraphicsCommandList* Dx12UploadQueue::BeginUpload()
+{
+	IM_ASSERT(m_recordingContext == UINT_MAX && "EndUpload() was not called for the previous upload.");
+	Retire();
+
+	UINT contextIndex = m_scheduler.AcquireContext();
+	if (contextIndex == m_contexts.size())
+	{
+		CommandContext context;
+		if (m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY,
+		                                     IID_PPV_ARGS(&context.CommandAllocator)) != S_OK ||
+			m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, context.CommandAllocator.Get(), nullptr,
+			                            IID_PPV_ARGS(&context.CommandList)) != S_OK ||
+			context.CommandList->Close() != S_OK)
+		{
+			std::cerr << "Failed to create upload command list." << std::endl;
+			return nullptr;
+		}
+		m_contexts.push_back(std::move(context));
+	}
+
+	CommandContext& context = m_contexts[contextIndex];
+	context.CommandAllocator->Reset();
+	context.CommandList->Reset(context.CommandAllocator.Get(), nullptr);
+	m_recordingContext = contextIndex;
+	return context.CommandList.Get();
+}
+
+bool Dx12UploadQueue::AllocateStaging(UINT64 size, Dx12UploadAllocation* out_allocation)
+{
+	IM_ASSERT(m_recordingContext != UINT_MAX);
+
+	UINT64 offset = 0;
+	bool allocated = m_ring.Allocate(size, &offset);
+	if (!allocated && m_scheduler.GetLastSubmittedValue() > m_scheduler.GetCompletedValue())
+	{
+		// The ring is full of in-flight uploads; let them drain before giving up on it.
+		WaitIdle();
+		allocated = m_ring.Allocate(size, &offset);
+	}
+
+	m_stats.BytesStaged += size;
+
+	if (allocated)
+	{
+		out_allocation->Resource = m_ring.GetResource();
+		out_allocation->MappedData = m_ring.GetMappedData();
+		out_allocation->Offset = offset;
+		return true;
+	}
+
+	D3D12_HEAP_PROPERTIES uploadHeapProps = {};
+	uploadHeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+	D3D12_RESOURCE_DESC uploadResDesc = {};
+	uploadResDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	uploadResDesc.Width = size;
+	uploadResDesc.Height = 1;
+	uploadResDesc.DepthOrArraySize = 1;
+	uploadResDesc.MipLevels = 1;
+	uploadResDesc.Format = DXGI_FORMAT_UNKNOWN;
+	uploadResDesc.SampleDesc.Count = 1;
+	uploadResDesc.SampleDesc.Quality = 0;
+	uploadResDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	uploadResDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> uploadBuffer;
+	HRESULT hr = m_device->CreateCommittedResource(
+		&uploadHeapProps,
+		D3D12_HEAP_FLAG_NONE,
+		&uploadResDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&uploadBuffer));
+	if (FAILED(hr))
+	{
+		std::cerr << "Failed to create upload buffer. HRESULT: " << std::hex << hr << std::endl;
+		return false;
+	}
+
+	void* mappedData = nullptr;
+	D3D12_RANGE readRange = {};
+	hr = uploadBuffer->Map(0, &readRange, &mappedData);
+	if (FAILED(hr))
+	{
+		std::cerr << "Failed to map upload buffer. HRESULT: " << std::hex << hr << std::endl;
+		return false;
+	}
+
+	out_allocation->Resource = uploadBuffer.Get();
+	out_allocation->MappedData = mappedData;
+	out_allocation->Offset = 0;
+	m_deferredReleases.push_back({std::move(uploadBuffer), 0});
+	m_stats.DedicatedStagingBuffers++;
+	return true;
+}
+
+void Dx12UploadQueue::QueueTransition(ID3D12Resource* resource, D3D12_RESOURCE_STATES before,
+                                      D3D12_RESOURCE_STATES after)
+{
+	IM_ASSERT(m_recordingContext != UINT_MAX);
+
+	D3D12_RESOURCE_BARRIER barrier = {};
+	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+	barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+	barrier.Transition.pResource = resource;
+	barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+	barrier.Transition.StateBefore = before;
+	barrier.Transition.StateAfter = after;
+	m_pendingBarriers.push_back(barrier);
+}
+
+UINT64 Dx12UploadQueue::EndUpload()
+{
+	IM_ASSERT(m_recordingContext != UINT_MAX);
+
+	UINT contextIndex = m_recordingContext;
+	m_recordingContext = UINT_MAX;
+
+	ID3D12GraphicsCommandList* commandList = m_contexts[contextIndex].CommandList.Get();
+	if (!m_pendingBarriers.empty())
+	{
+		commandList->ResourceBarrier(static_cast<UINT>(m_pendingBarriers.size()), m_pendingBarriers.data());
+		m_stats.BarrierCalls++;
+		m_stats.Barriers += m_pendingBarriers.size();
+		m_pendingBarriers.clear();
+	}
+	commandList->Close();
+	m_stats.Submissions++;
+
+	UINT64 fenceValue = m_scheduler.Submit(contextIndex);
+	m_ring.Submit(fenceValue);
+	for (DeferredRelease& release : m_deferredReleases)
+		if (release.FenceValue == 0)
+			release.FenceValue = fenceValue;
+	return fenceValue;
+}
+
+void Dx12UploadQueue::WaitIdle()
+{
+	if (!m_fence)
+		return;
+	m_scheduler.WaitIdle();
+	Retire();
+}
+
+void Dx12UploadQueue::Execute(uint32_t contextIndex)
+{
+	ID3D12CommandList* ppCommandLists[] = {m_contexts[contextIndex].CommandList.Get()};
+	m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+}
+
+void Dx12UploadQueue::Signal(uint64_t fenceValue)
+{
+	m_commandQueue->Signal(m_fence.Get(), fenceValue);
+}
+
+uint64_t Dx12UploadQueue::GetCompletedValue() const
+{
+	return m_fence->GetCompletedValue();
+}
+
+void Dx12UploadQueue::WaitForValue(uint64_t fenceValue)
+{
+	if (m_fence->GetCompletedValue() >= fenceValue)
+		return;
+	m_fence->SetEventOnCompletion(fenceValue, m_fenceEvent);
+	WaitForSingleObject(m_fenceEvent, INFINITE);
+}
+
+void Dx12UploadQueue::Retire()
+{
+	UINT64 completedValue = m_fence->GetCompletedValue();
+	m_ring.Retire(completedValue);
+
+	for (size_t i = 0; i < m_deferredReleases.size();)
+	{
+		const DeferredRelease& release = m_deferredReleases[i];
+		if (release.FenceValue != 0 && release.FenceValue <= completedValue)
+		{
+			m_deferredReleases[i] = std::move(m_deferredReleases.back());
+			m_deferredReleases.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
@@ -0,0 +1,72 @@
+#include "Stdafx.hpp"
+#include "render/Dx12UploadRing.h"
+
+Dx12UploadRing::~Dx12UploadRing()
+{
+	Destroy();
+}
+
+bool Dx12UploadRing::Create(ID3D12Device* device, UINT64 size)
+{
+	IM_ASSERT(m_buffer == nullptr);
+
+	D3D12_HEAP_PROPERTIES heapProps = {};
+	heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+	D3D12_RESOURCE_DESC resDesc = {};
+	resDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	resDesc.Width = size;
+	resDesc.Height = 1;
+	resDesc.DepthOrArraySize = 1;
+	resDesc.MipLevels = 1;
+	resDesc.Format = DXGI_FORMAT_UNKNOWN;
+	resDesc.SampleDesc.Count = 1;
+	resDesc.SampleDesc.Quality = 0;
+	resDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	resDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+	HRESULT hr = device->CreateCommittedResource(
+		&heapProps,
+		D3D12_HEAP_FLAG_NONE,
+		&resDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&m_buffer));
+	if (FAILED(hr))
+	{
+		std::cerr << "Failed to create upload ring buffer. HRESULT: " << std::hex << hr << std::endl;
+		return false;
+	}
+
+	// Upload heaps may stay mapped for their whole lifetime; the CPU never reads from it.
+	D3D12_RANGE readRange = {};
+	hr = m_buffer->Map(0, &readRange, &m_mappedData);
+	if (FAILED(hr))
+	{
+		std::cerr << "Failed to map upload ring buffer. HRESULT: " << std::hex << hr << std::endl;
+		Destroy();
+		return false;
+	}
+
+	m_allocator.Initialize(size);
+	return true;
+}
+
+void Dx12UploadRing::Destroy()
+{
+	if (m_buffer && m_mappedData)
+		m_buffer->Unmap(0, nullptr);
+	m_mappedData = nullptr;
+	m_buffer.Reset();
+	m_allocator.Reset();
+}
+
+bool Dx12UploadRing::Allocate(UINT64 size, UINT64* out_offset)
+{
+	UINT64 offset = m_allocator.Allocate(size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+	if (offset == UploadRingAllocator::INVALID_OFFSET)
+		return false;
+
+	*out_offset = offset;
+	return true;
+}
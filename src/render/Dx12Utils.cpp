@@ -45,6 +45,29 @@ namespace Dx12Utils
 		UINT FirstSubresource,
 		UINT NumSubresources,
 		D3D12_SUBRESOURCE_DATA* pSrcData)
+	{
+		void* pData;
+		HRESULT hr = pIntermediate->Map(0, nullptr, &pData);
+		if (FAILED(hr))
+		{
+			assert(false && "Failed to map intermediate buffer.");
+			return 0;
+		}
+
+		UINT64 RequiredSize = UpdateSubresources(pCmdList, pDestinationResource, pIntermediate, pData,
+		                                         IntermediateOffset, FirstSubresource, NumSubresources, pSrcData);
+		pIntermediate->Unmap(0, nullptr);
+		return RequiredSize;
+	}
+
+	UINT64 GetCopyableFootprints(
+		ID3D12Resource* pDestinationResource,
+		UINT FirstSubresource,
+		UINT NumSubresources,
+		UINT64 IntermediateOffset,
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts,
+		UINT* pNumRows,
+		UINT64* pRowSizesInBytes)
 	{
 		UINT64 RequiredSize = 0;
 		D3D12_RESOURCE_DESC DestDesc = pDestinationResource->GetDesc();
@@ -53,27 +76,60 @@ namespace Dx12Utils
 		HRESULT hr = pDestinationResource->GetDevice(IID_PPV_ARGS(&pDevice));
 		if (FAILED(hr))
 		{
-			assert(false && "Failed to get D3D12Device from resource in UpdateSubresources.");
+			assert(false && "Failed to get D3D12Device from resource in GetCopyableFootprints.");
 			return 0;
 		}
 
+		pDevice->GetCopyableFootprints(&DestDesc, FirstSubresource, NumSubresources, IntermediateOffset, pLayouts,
+		                               pNumRows, pRowSizesInBytes, &RequiredSize);
+		return RequiredSize;
+	}
+
+	void CopySubresourcesFromIntermediate(
+		ID3D12GraphicsCommandList* pCmdList,
+		ID3D12Resource* pDestinationResource,
+		ID3D12Resource* pIntermediate,
+		UINT FirstSubresource,
+		UINT NumSubresources,
+		const D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts)
+	{
+		for (UINT i = 0; i < NumSubresources; ++i)
+		{
+			D3D12_TEXTURE_COPY_LOCATION Dst = {};
+			Dst.pResource = pDestinationResource;
+			Dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+			Dst.SubresourceIndex = FirstSubresource + i;
+
+			D3D12_TEXTURE_COPY_LOCATION Src = {};
+			Src.pResource = pIntermediate;
+			Src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+			Src.PlacedFootprint = pLayouts[i];
+
+			pCmdList->CopyTextureRegion(&Dst, 0, 0, 0, &Src, nullptr);
+		}
+	}
+
+	UINT64 UpdateSubresources(
+		ID3D12GraphicsCommandList* pCmdList,
+		ID3D12Resource* pDestinationResource,
+		ID3D12Resource* pIntermediate,
+		void* pIntermediateData,
+		UINT64 IntermediateOffset,
+		UINT FirstSubresource,
+		UINT NumSubresources,
+		D3D12_SUBRESOURCE_DATA* pSrcData)
+	{
 		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> Layouts(NumSubresources);
 		std::vector<UINT> NumRows(NumSubresources);
 		std::vector<UINT64> RowSizesInBytes(NumSubresources);
 
-		pDevice->GetCopyableFootprints(&DestDesc, FirstSubresource, NumSubresources, IntermediateOffset, Layouts.data(),
-		                               NumRows.data(), RowSizesInBytes.data(), &RequiredSize);
-
-
-		void* pData;
-		hr = pIntermediate->Map(0, nullptr, &pData);
-		if (FAILED(hr))
-		{
-			assert(false && "Failed to map intermediate buffer.");
+		UINT64 RequiredSize = GetCopyableFootprints(pDestinationResource, FirstSubresource, NumSubresources,
+		                                            IntermediateOffset, Layouts.data(), NumRows.data(),
+		                                            RowSizesInBytes.data());
+		if (RequiredSize == 0)
 			return 0;
-		}
 
-		auto pDest = reinterpret_cast<BYTE*>(pData);
+		auto pDest = reinterpret_cast<BYTE*>(pIntermediateData);
 
 		for (UINT i = 0; i < NumSubresources; ++i)
 		{
@@ -85,6 +141,14 @@ namespace Dx12Utils
 			BYTE* pDestSubresource = pDest + Layout.Offset;
 			auto pSrcSubresource = reinterpret_cast<const BYTE*>(SrcData.pData);
 
+			if (NumRow > 0 && static_cast<UINT64>(SrcData.RowPitch) == Layout.Footprint.RowPitch)
+			{
+				// Source already in footprint layout (e.g. from the disk cache): one copy for the whole level.
+				memcpy(pDestSubresource, pSrcSubresource,
+				       static_cast<SIZE_T>(Layout.Footprint.RowPitch) * (NumRow - 1) + RowSizeInBytes);
+				continue;
+			}
+
 			for (UINT row = 0; row < NumRow; ++row)
 			{
 				memcpy(pDestSubresource + row * Layout.Footprint.RowPitch,
@@ -92,22 +156,9 @@ namespace Dx12Utils
 				       RowSizeInBytes);
 			}
 		}
-		pIntermediate->Unmap(0, nullptr);
-
-		for (UINT i = 0; i < NumSubresources; ++i)
-		{
-			D3D12_TEXTURE_COPY_LOCATION Dst = {};
-			Dst.pResource = pDestinationResource;
-			Dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-			Dst.SubresourceIndex = FirstSubresource + i;
 
-			D3D12_TEXTURE_COPY_LOCATION Src = {};
-			Src.pResource = pIntermediate;
-			Src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-			Src.PlacedFootprint = Layouts[i];
-
-			pCmdList->CopyTextureRegion(&Dst, 0, 0, 0, &Src, nullptr);
-		}
+		CopySubresourcesFromIntermediate(pCmdList, pDestinationResource, pIntermediate, FirstSubresource,
+		                                 NumSubresources, Layouts.data());
 
 		return RequiredSize;
 	}
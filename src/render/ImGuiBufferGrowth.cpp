@@ -0,0 +1,24 @@
+#include "render/ImGuiBufferGrowth.h"
+
+#include <climits>
+
+namespace ImGuiBufferGrowth
+{
+	int GetGrownSize(int current, int required, int minSize)
+	{
+		if (required <= current)
+			return current;
+
+		int64_t size = current > minSize ? current : minSize;
+		if (size < 2)
+			size = 2;
+		while (size < required)
+			size += size / 2;
+		return size > INT_MAX ? required : static_cast<int>(size);
+	}
+
+	bool CanRelease(uint32_t retiredFrame, uint32_t frameIndex, uint32_t numFramesInFlight)
+	{
+		return frameIndex - retiredFrame >= numFramesInFlight;
+	}
+}
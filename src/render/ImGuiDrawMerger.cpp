@@ -0,0 +1,58 @@
+#include "render/ImGuiDrawMerger.h"
+
+#include <cstring>
+
+namespace
+{
+	// The next command must continue the previous one's indices over the same vertices and scissor; the texture
+	// no longer matters. Callbacks change state the merged draw cannot know about.
+	bool CanMerge(const ImDrawCmd& previous, const ImDrawCmd& next)
+	{
+		return previous.UserCallback == nullptr && next.UserCallback == nullptr &&
+			previous.VtxOffset == next.VtxOffset && previous.IdxOffset + previous.ElemCount == next.IdxOffset &&
+			memcmp(&previous.ClipRect, &next.ClipRect, sizeof(ImVec4)) == 0;
+	}
+}
+
+void ImGuiDrawMerger::Merge(ImDrawData* drawData, TextureIndexFn textureIndexFn, void* userData)
+{
+	m_stats = {};
+	for (ImDrawList* drawList : drawData->CmdLists)
+	{
+		ImVector<ImDrawCmd>& commands = drawList->CmdBuffer;
+		ImDrawVert* vertices = drawList->VtxBuffer.Data;
+		const ImDrawIdx* indices = drawList->IdxBuffer.Data;
+
+		int numKept = 0;
+		for (int i = 0; i < commands.Size; i++)
+		{
+			const ImDrawCmd command = commands[i];
+			if (command.UserCallback != nullptr)
+			{
+				m_stats.NumCallbacks++;
+				commands[numKept++] = command;
+				continue;
+			}
+			m_stats.NumCommands++;
+			if (command.ElemCount == 0)
+				continue;
+
+			// Walk the indices rather than a vertex range: once ImDrawListSplitter merged its channels, one
+			// command's vertices can lie on both sides of another's.
+			const uint32_t textureIndex = textureIndexFn(command.GetTexID(), userData);
+			ImDrawVert* commandVertices = vertices + command.VtxOffset;
+			const ImDrawIdx* commandIndices = indices + command.IdxOffset;
+			for (unsigned int j = 0; j < command.ElemCount; j++)
+				commandVertices[commandIndices[j]].tex_index = textureIndex;
+			m_stats.NumIndices += command.ElemCount;
+
+			if (numKept > 0 && CanMerge(commands[numKept - 1], command))
+				commands[numKept - 1].ElemCount += command.ElemCount;
+			else
+				commands[numKept++] = command;
+		}
+		commands.resize(numKept);
+		m_stats.NumDraws += static_cast<uint32_t>(numKept);
+	}
+	m_stats.NumDraws -= m_stats.NumCallbacks;
+}
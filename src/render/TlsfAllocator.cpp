@@ -0,0 +1,252 @@
+#include "render/TlsfAllocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+void TlsfAllocator::Initialize(uint64_t capacity, uint64_t granularity)
+{
+	assert(granularity > 0 && std::has_single_bit(granularity) && "Granularity must be a power of two.");
+	m_granularity = granularity;
+	m_capacity = capacity / granularity * granularity;
+	Reset();
+}
+
+void TlsfAllocator::Reset()
+{
+	m_nodes.clear();
+	m_unusedNodes.clear();
+	for (auto& level : m_bins)
+		std::fill(std::begin(level), std::end(level), NO_NODE);
+	m_levelBits = 0;
+	std::fill(std::begin(m_subdivisionBits), std::end(m_subdivisionBits), 0u);
+	m_usedBytes = 0;
+	m_numAllocations = 0;
+	m_numFreeBlocks = 0;
+
+	if (m_capacity == 0)
+		return;
+	uint32_t root = NewNode();
+	m_nodes[root].Offset = 0;
+	m_nodes[root].Size = m_capacity;
+	InsertFree(root);
+}
+
+void TlsfAllocator::GetBin(uint64_t size, uint32_t& out_level, uint32_t& out_subdivision)
+{
+	if (size < SUBDIVISIONS)
+	{
+		// Level 0 holds the sizes below one full subdivision step, one per bin.
+		out_level = 0;
+		out_subdivision = static_cast<uint32_t>(size);
+		return;
+	}
+	uint32_t highBit = 63 - static_cast<uint32_t>(std::countl_zero(size));
+	out_level = highBit - SUBDIVISION_BITS + 1;
+	out_subdivision = static_cast<uint32_t>(size >> (highBit - SUBDIVISION_BITS)) - SUBDIVISIONS;
+}
+
+uint32_t TlsfAllocator::FindFreeNode(uint64_t size) const
+{
+	// Rounded up to the next bin boundary, so any range in the bin found holds size.
+	if (size >= SUBDIVISIONS)
+	{
+		uint32_t highBit = 63 - static_cast<uint32_t>(std::countl_zero(size));
+		uint64_t step = (1ull << (highBit - SUBDIVISION_BITS)) - 1;
+		if (size > UINT64_MAX - step)
+			return NO_NODE;
+		size += step;
+	}
+
+	uint32_t level, subdivision;
+	GetBin(size, level, subdivision);
+	uint32_t subdivisionBits = m_subdivisionBits[level] & (~0u << subdivision);
+	if (subdivisionBits == 0)
+	{
+		uint64_t levelBits = level + 1 < 64 ? m_levelBits & (~0ull << (level + 1)) : 0;
+		if (levelBits == 0)
+			return NO_NODE;
+		level = static_cast<uint32_t>(std::countr_zero(levelBits));
+		subdivisionBits = m_subdivisionBits[level];
+	}
+	return m_bins[level][std::countr_zero(subdivisionBits)];
+}
+
+bool TlsfAllocator::Allocate(uint64_t size, uint64_t alignment, TlsfAllocation* out_allocation)
+{
+	assert(std::has_single_bit(alignment) && "Alignment must be a power of two.");
+	*out_allocation = {};
+	if (size == 0 || size > m_capacity)
+		return false;
+
+	alignment = std::max(alignment, m_granularity);
+	size = (size + m_granularity - 1) & ~(m_granularity - 1);
+
+	// Room for the worst-case padding in front, so the aligned range always fits in what is found.
+	uint32_t index = FindFreeNode(size + alignment - m_granularity);
+	if (index == NO_NODE)
+		return false;
+	RemoveFree(index);
+
+	uint64_t offset = m_nodes[index].Offset;
+	uint64_t padding = ((offset + alignment - 1) & ~(alignment - 1)) - offset;
+	if (padding != 0)
+	{
+		// The block before a free range is never free, so the padding stays a separate free range.
+		uint32_t aligned = Split(index, padding);
+		InsertFree(index);
+		index = aligned;
+	}
+	if (m_nodes[index].Size > size)
+		InsertFree(Split(index, size));
+
+	m_usedBytes += size;
+	m_numAllocations++;
+	m_nodes[index].Generation++;
+	out_allocation->Node = index;
+	out_allocation->Generation = m_nodes[index].Generation;
+	out_allocation->Offset = m_nodes[index].Offset;
+	out_allocation->Size = size;
+	return true;
+}
+
+bool TlsfAllocator::Free(const TlsfAllocation& allocation)
+{
+	if (allocation.Node >= m_nodes.size())
+		return false;
+	uint32_t index = allocation.Node;
+	if (m_nodes[index].Free || m_nodes[index].Generation != allocation.Generation)
+		return false;
+
+	m_usedBytes -= m_nodes[index].Size;
+	m_numAllocations--;
+
+	uint32_t prev = m_nodes[index].PrevPhysical;
+	if (prev != NO_NODE && m_nodes[prev].Free)
+	{
+		RemoveFree(prev);
+		Merge(prev, index);
+		index = prev;
+	}
+	uint32_t next = m_nodes[index].NextPhysical;
+	if (next != NO_NODE && m_nodes[next].Free)
+	{
+		RemoveFree(next);
+		Merge(index, next);
+	}
+	InsertFree(index);
+	return true;
+}
+
+TlsfStats TlsfAllocator::GetStats() const
+{
+	TlsfStats stats;
+	stats.Capacity = m_capacity;
+	stats.UsedBytes = m_usedBytes;
+	stats.NumAllocations = m_numAllocations;
+	stats.NumFreeBlocks = m_numFreeBlocks;
+
+	// Bins are ordered by size, so the largest free range is in the highest non-empty one.
+	if (m_levelBits != 0)
+	{
+		uint32_t level = 63 - static_cast<uint32_t>(std::countl_zero(m_levelBits));
+		uint32_t subdivision = 31 - static_cast<uint32_t>(std::countl_zero(m_subdivisionBits[level]));
+		for (uint32_t index = m_bins[level][subdivision]; index != NO_NODE; index = m_nodes[index].NextFree)
+			stats.LargestFreeBlock = std::max(stats.LargestFreeBlock, m_nodes[index].Size);
+	}
+	return stats;
+}
+
+uint32_t TlsfAllocator::NewNode()
+{
+	if (!m_unusedNodes.empty())
+	{
+		uint32_t index = m_unusedNodes.back();
+		m_unusedNodes.pop_back();
+		uint32_t generation = m_nodes[index].Generation;
+		m_nodes[index] = Node{};
+		m_nodes[index].Generation = generation;
+		return index;
+	}
+	m_nodes.emplace_back();
+	return static_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+void TlsfAllocator::ReleaseNode(uint32_t index)
+{
+	// Kept marked free so a stale allocation naming it fails validation.
+	uint32_t generation = m_nodes[index].Generation;
+	m_nodes[index] = Node{};
+	m_nodes[index].Generation = generation;
+	m_nodes[index].Free = true;
+	m_unusedNodes.push_back(index);
+}
+
+void TlsfAllocator::InsertFree(uint32_t index)
+{
+	uint32_t level, subdivision;
+	GetBin(m_nodes[index].Size, level, subdivision);
+
+	Node& node = m_nodes[index];
+	node.Free = true;
+	node.PrevFree = NO_NODE;
+	node.NextFree = m_bins[level][subdivision];
+	if (node.NextFree != NO_NODE)
+		m_nodes[node.NextFree].PrevFree = index;
+	m_bins[level][subdivision] = index;
+	m_subdivisionBits[level] |= 1u << subdivision;
+	m_levelBits |= 1ull << level;
+	m_numFreeBlocks++;
+}
+
+void TlsfAllocator::RemoveFree(uint32_t index)
+{
+	uint32_t level, subdivision;
+	GetBin(m_nodes[index].Size, level, subdivision);
+
+	Node& node = m_nodes[index];
+	if (node.PrevFree != NO_NODE)
+		m_nodes[node.PrevFree].NextFree = node.NextFree;
+	else
+		m_bins[level][subdivision] = node.NextFree;
+	if (node.NextFree != NO_NODE)
+		m_nodes[node.NextFree].PrevFree = node.PrevFree;
+
+	if (m_bins[level][subdivision] == NO_NODE)
+	{
+		m_subdivisionBits[level] &= ~(1u << subdivision);
+		if (m_subdivisionBits[level] == 0)
+			m_levelBits &= ~(1ull << level);
+	}
+	node.Free = false;
+	node.PrevFree = NO_NODE;
+	node.NextFree = NO_NODE;
+	m_numFreeBlocks--;
+}
+
+uint32_t TlsfAllocator::Split(uint32_t index, uint64_t size)
+{
+	uint32_t rest = NewNode(); // may move m_nodes, so no references are held across it
+	Node& node = m_nodes[index];
+	Node& restNode = m_nodes[rest];
+	restNode.Offset = node.Offset + size;
+	restNode.Size = node.Size - size;
+	restNode.PrevPhysical = index;
+	restNode.NextPhysical = node.NextPhysical;
+	if (node.NextPhysical != NO_NODE)
+		m_nodes[node.NextPhysical].PrevPhysical = rest;
+	node.NextPhysical = rest;
+	node.Size = size;
+	return rest;
+}
+
+void TlsfAllocator::Merge(uint32_t index, uint32_t next)
+{
+	Node& node = m_nodes[index];
+	const Node& nextNode = m_nodes[next];
+	node.Size += nextNode.Size;
+	node.NextPhysical = nextNode.NextPhysical;
+	if (nextNode.NextPhysical != NO_NODE)
+		m_nodes[nextNode.NextPhysical].PrevPhysical = index;
+	ReleaseNode(next);
+}
@@ -0,0 +1,91 @@
+#include "render/UploadRingAllocator.h"
+
+#include <cassert>
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void UploadRingAllocator::Initialize(uint64_t capacity)
+{
+	m_capacity = capacity;
+	Reset();
+}
+
+void UploadRingAllocator::Reset()
+{
+	m_submissions.clear();
+	m_head = 0;
+	m_tail = 0;
+	m_usedBytes = 0;
+	m_unsubmittedBytes = 0;
+}
+
+uint64_t UploadRingAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two.");
+	if (size == 0 || size > m_capacity)
+		return INVALID_OFFSET;
+
+	if (m_usedBytes == 0)
+	{
+		m_head = 0;
+		m_tail = 0;
+	}
+
+	uint64_t offset = AlignUp(m_tail, alignment);
+	uint64_t padding = 0;
+
+	if (m_tail >= m_head && !(m_usedBytes != 0 && m_tail == m_head))
+	{
+		// Free space is [tail, capacity) followed by [0, head).
+		if (offset + size <= m_capacity)
+		{
+			padding = offset - m_tail;
+		}
+		else if (size <= m_head)
+		{
+			padding = m_capacity - m_tail;
+			offset = 0;
+		}
+		else
+		{
+			return INVALID_OFFSET;
+		}
+	}
+	else
+	{
+		// Free space is [tail, head).
+		if (m_usedBytes == m_capacity || offset + size > m_head)
+			return INVALID_OFFSET;
+		padding = offset - m_tail;
+	}
+
+	m_tail = offset + size;
+	m_usedBytes += padding + size;
+	m_unsubmittedBytes += padding + size;
+	return offset;
+}
+
+void UploadRingAllocator::Submit(uint64_t fenceValue)
+{
+	if (m_unsubmittedBytes == 0)
+		return;
+
+	assert((m_submissions.empty() || m_submissions.back().FenceValue <= fenceValue) &&
+		"Fence values must be monotonic.");
+	m_submissions.push_back({fenceValue, m_tail, m_unsubmittedBytes});
+	m_unsubmittedBytes = 0;
+}
+
+void UploadRingAllocator::Retire(uint64_t completedFenceValue)
+{
+	while (!m_submissions.empty() && m_submissions.front().FenceValue <= completedFenceValue)
+	{
+		const Submission& submission = m_submissions.front();
+		m_head = submission.End;
+		m_usedBytes -= submission.Bytes;
+		m_submissions.pop_front();
+	}
+}
@@ -0,0 +1,90 @@
+#include "render/UploadScheduler.h"
+
+#include <cassert>
+
+void UploadScheduler::Initialize(IUploadQueue* queue, uint32_t maxContexts)
+{
+	assert(queue != nullptr && maxContexts > 0);
+	m_queue = queue;
+	m_maxContexts = maxContexts;
+	m_contexts.clear();
+	m_lastSubmittedValue = queue->GetCompletedValue();
+	m_frameRequiredValue = 0;
+}
+
+void UploadScheduler::Shutdown()
+{
+	if (m_queue)
+		WaitIdle();
+	m_queue = nullptr;
+	m_contexts.clear();
+}
+
+uint32_t UploadScheduler::AcquireContext()
+{
+	uint64_t completedValue = m_queue->GetCompletedValue();
+
+	uint32_t oldestIndex = UINT32_MAX;
+	for (uint32_t i = 0; i < m_contexts.size(); i++)
+	{
+		Context& context = m_contexts[i];
+		if (context.Recording)
+			continue;
+		if (context.FenceValue <= completedValue)
+		{
+			context.Recording = true;
+			return i;
+		}
+		if (oldestIndex == UINT32_MAX || context.FenceValue < m_contexts[oldestIndex].FenceValue)
+			oldestIndex = i;
+	}
+
+	if (m_contexts.size() < m_maxContexts || oldestIndex == UINT32_MAX)
+	{
+		m_contexts.push_back({0, true});
+		return static_cast<uint32_t>(m_contexts.size() - 1);
+	}
+
+	m_queue->WaitForValue(m_contexts[oldestIndex].FenceValue);
+	m_contexts[oldestIndex].Recording = true;
+	return oldestIndex;
+}
+
+uint64_t UploadScheduler::Submit(uint32_t contextIndex)
+{
+	assert(contextIndex < m_contexts.size() && m_contexts[contextIndex].Recording);
+
+	uint64_t fenceValue = m_lastSubmittedValue + 1;
+	m_queue->Execute(contextIndex);
+	m_queue->Signal(fenceValue);
+	m_lastSubmittedValue = fenceValue;
+
+	Context& context = m_contexts[contextIndex];
+	context.FenceValue = fenceValue;
+	context.Recording = false;
+	return fenceValue;
+}
+
+uint64_t UploadScheduler::GetCompletedValue() const
+{
+	return m_queue ? m_queue->GetCompletedValue() : 0;
+}
+
+void UploadScheduler::WaitForValue(uint64_t fenceValue)
+{
+	if (!IsComplete(fenceValue))
+		m_queue->WaitForValue(fenceValue);
+}
+
+void UploadScheduler::RequireForFrame(uint64_t fenceValue)
+{
+	if (fenceValue > m_frameRequiredValue)
+		m_frameRequiredValue = fenceValue;
+}
+
+uint64_t UploadScheduler::ConsumeFrameWait()
+{
+	uint64_t fenceValue = m_frameRequiredValue;
+	m_frameRequiredValue = 0;
+	return IsComplete(fenceValue) ? 0 : fenceValue;
+}
@@ -0,0 +1,306 @@
+#include "TestFramework.h"
+#include "TestImages.h"
+#include "image/AsyncImageLoader.h"
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <thread>
+
+namespace
+{
+	// Records what the loader hands over instead of creating textures.
+	class FakeSink : public IAsyncTextureSink
+	{
+	public:
+		struct Event
+		{
+			enum class Kind
+			{
+				Decoded,
+				Shared,
+				Failed,
+			};
+
+			Kind Type;
+			AsyncImageHandle Handle;
+			std::string Path;
+			int Width = 0;
+			int Height = 0;
+			uint64_t ContentHash = 0;
+		};
+
+		void OnImageDecoded(AsyncImageHandle handle, const std::string& path, DecodedImage& image) override
+		{
+			Events.push_back({Event::Kind::Decoded, handle, path, image.Width, image.Height, image.ContentHash});
+			Images.push_back(std::move(image));
+		}
+
+		void OnImageShared(AsyncImageHandle handle, const std::string& path, uint64_t contentHash) override
+		{
+			Events.push_back({Event::Kind::Shared, handle, path, 0, 0, contentHash});
+		}
+
+		void OnImageFailed(AsyncImageHandle handle, const std::string& path) override
+		{
+			Events.push_back({Event::Kind::Failed, handle, path});
+		}
+
+		const Event* Find(AsyncImageHandle handle) const
+		{
+			for (const Event& event : Events)
+				if (event.Handle == handle)
+					return &event;
+			return nullptr;
+		}
+
+		std::vector<Event> Events;
+		std::vector<DecodedImage> Images;
+	};
+
+	// Publishes like the UI thread does, once per "frame", until nothing is pending.
+	bool PublishAll(AsyncImageLoader& loader, FakeSink& sink)
+	{
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+		while (loader.GetNumPending() > 0)
+		{
+			if (std::chrono::steady_clock::now() > deadline)
+				return false;
+			if (loader.Publish(sink) == 0)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return true;
+	}
+
+	// Waits until workers have stopped producing: nothing is decoding and the byte count is stable.
+	void WaitForDecodes(AsyncImageLoader& loader, uint64_t minBytes)
+	{
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+		while (loader.GetBytesInFlight() < minBytes && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	}
+
+	std::string WritePng(const TestImages::TempDirectory& directory, const std::string& name, int width, int height,
+	                     uint64_t seed)
+	{
+		std::vector<unsigned char> pixels = TestImages::MakePhoto(width, height, 4, seed);
+		TestImages::WriteFile(directory / name, TestImages::EncodePng(pixels.data(), width, height, {}));
+		return directory / name;
+	}
+}
+
+TEST(DecodesEveryRequestOnce)
+{
+	TestImages::TempDirectory directory("async-loader");
+	std::map<AsyncImageHandle, std::string> requested;
+	AsyncImageLoader loader;
+	loader.Start(3);
+	for (int i = 0; i < 12; i++)
+	{
+		std::string path = WritePng(directory, "image" + std::to_string(i) + ".png", 40 + i, 30 + 2 * i, i);
+		AsyncImageHandle handle = loader.Request(path);
+		CHECK(handle != INVALID_ASYNC_IMAGE_HANDLE);
+		CHECK(!requested.contains(handle));
+		requested[handle] = path;
+	}
+
+	FakeSink sink;
+	REQUIRE(PublishAll(loader, sink));
+	REQUIRE_EQ(sink.Events.size(), requested.size());
+	for (const FakeSink::Event& event : sink.Events)
+	{
+		CHECK(event.Type == FakeSink::Event::Kind::Decoded);
+		CHECK_EQ(requested.at(event.Handle), event.Path);
+		int index = std::stoi(event.Path.substr(event.Path.find("image") + 5));
+		CHECK_EQ(event.Width, 40 + index);
+		CHECK_EQ(event.Height, 30 + 2 * index);
+		CHECK(event.ContentHash != 0);
+	}
+
+	// Decoded images arrive mipmapped, ready for upload.
+	for (const DecodedImage& image : sink.Images)
+		CHECK(image.MipLevels > 1);
+	CHECK_EQ(loader.GetBytesInFlight(), 0u);
+}
+
+TEST(MissingAndCorruptFilesFail)
+{
+	TestImages::TempDirectory directory("async-loader");
+	TestImages::WriteFile(directory / "corrupt.png", TestImages::MakeNoise(1000, 1));
+
+	AsyncImageLoader loader;
+	loader.Start(2);
+	AsyncImageHandle missing = loader.Request(directory / "missing.png");
+	AsyncImageHandle corrupt = loader.Request(directory / "corrupt.png");
+	AsyncImageHandle good = loader.Request(WritePng(directory, "good.png", 16, 16, 2));
+
+	FakeSink sink;
+	REQUIRE(PublishAll(loader, sink));
+	REQUIRE(sink.Find(missing) && sink.Find(corrupt) && sink.Find(good));
+	CHECK(sink.Find(missing)->Type == FakeSink::Event::Kind::Failed);
+	CHECK(sink.Find(corrupt)->Type == FakeSink::Event::Kind::Failed);
+	CHECK(sink.Find(good)->Type == FakeSink::Event::Kind::Decoded);
+}
+
+TEST(PublishesHighestPriorityFirst)
+{
+	TestImages::TempDirectory directory("async-loader");
+	std::vector<std::string> paths;
+	for (int i = 0; i < 8; i++)
+		paths.push_back(WritePng(directory, "p" + std::to_string(i) + ".png", 24, 24, 100 + i));
+
+	AsyncImageLoader loader;
+	loader.Start(2);
+	const int priorities[] = {0, 5, 1, 5, -3, 9, 0, 2};
+	std::vector<AsyncImageHandle> handles;
+	for (int i = 0; i < 8; i++)
+		handles.push_back(loader.Request(paths[i], 0, priorities[i]));
+	// Changed while waiting: now the lowest.
+	loader.SetPriority(handles[5], -10);
+
+	// Everything is decoded before the first Publish, so the order is the priority order alone.
+	WaitForDecodes(loader, 1);
+	while (true)
+	{
+		uint64_t bytes = loader.GetBytesInFlight();
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		if (bytes == loader.GetBytesInFlight() && bytes >= 8ull * 24 * 24 * 4)
+			break;
+	}
+
+	FakeSink sink;
+	REQUIRE_EQ(loader.Publish(sink), 8);
+	const int expectedOrder[] = {1, 3, 7, 2, 0, 6, 4, 5}; // equal priorities keep request order
+	for (int i = 0; i < 8; i++)
+		CHECK_EQ(sink.Events[i].Handle, handles[expectedOrder[i]]);
+}
+
+TEST(PausesAtTheByteCap)
+{
+	TestImages::TempDirectory directory("async-loader");
+	AsyncImageLoader loader;
+	// Any decoded image exceeds the cap, so one worker stops after each image until it is published.
+	loader.Start(1, 1);
+	for (int i = 0; i < 4; i++)
+		loader.Request(WritePng(directory, "c" + std::to_string(i) + ".png", 64, 64, 200 + i));
+
+	FakeSink sink;
+	for (int i = 0; i < 4; i++)
+	{
+		WaitForDecodes(loader, 1);
+		CHECK_EQ(loader.GetBytesInFlight(), static_cast<uint64_t>(64 * 64 * 4) + (64 * 64 * 4 - 4) / 3);
+		CHECK_EQ(loader.GetNumPending(), 4 - i);
+		CHECK_EQ(loader.Publish(sink, 1), 1);
+	}
+	CHECK_EQ(loader.GetNumPending(), 0);
+}
+
+TEST(RequestsFailWhenStopped)
+{
+	AsyncImageLoader loader;
+	CHECK_EQ(loader.Request("never.png"), INVALID_ASYNC_IMAGE_HANDLE);
+
+	TestImages::TempDirectory directory("async-loader");
+	loader.Start(2);
+	for (int i = 0; i < 16; i++)
+		loader.Request(WritePng(directory, "s" + std::to_string(i) + ".png", 256, 256, 300 + i));
+	// Returns once running decodes finish; queued ones are dropped.
+	loader.Shutdown();
+	CHECK_EQ(loader.GetNumPending(), 0);
+	CHECK_EQ(loader.GetBytesInFlight(), 0u);
+	CHECK_EQ(loader.Request("after.png"), INVALID_ASYNC_IMAGE_HANDLE);
+
+	FakeSink sink;
+	CHECK_EQ(loader.Publish(sink), 0);
+}
+
+TEST(ContentKeysFollowTheLoadOptions)
+{
+	BlockCompressionOptions off;
+	BlockCompressionOptions compressed;
+	compressed.Enabled = true;
+	uint64_t full = AsyncImageLoader::MakeContentKey(42, 0, off);
+	CHECK(full != 0);
+	CHECK(full != 42);
+	CHECK_EQ(AsyncImageLoader::MakeContentKey(42, 0, off), full);
+	CHECK(AsyncImageLoader::MakeContentKey(43, 0, off) != full);
+	CHECK(AsyncImageLoader::MakeContentKey(42, 256, off) != full);
+	CHECK(AsyncImageLoader::MakeContentKey(42, 0, compressed) != full);
+	CHECK_EQ(AsyncImageLoader::MakeContentKey(0, 256, compressed), 0u);
+
+	// The quality only counts when compression is on.
+	BlockCompressionOptions offBest;
+	offBest.Quality = APP_MAX_BLOCK_COMPRESSION_QUALITY;
+	CHECK_EQ(AsyncImageLoader::MakeContentKey(42, 0, offBest), full);
+	BlockCompressionOptions compressedBest = offBest;
+	compressedBest.Enabled = true;
+	CHECK(AsyncImageLoader::MakeContentKey(42, 0, compressedBest) !=
+	      AsyncImageLoader::MakeContentKey(42, 0, compressed));
+}
+
+// A copy and a symlink share the decode of the original; the same bytes at another size or compressed do not,
+// since the sink could not use that texture in their place. Released content is decoded again.
+TEST(SharesIdenticalBytesWithTheSameOptions)
+{
+	TestImages::TempDirectory directory("async-loader");
+	std::string original = WritePng(directory, "original.png", 600, 520, 400);
+	std::filesystem::copy_file(original, directory / "copy.png");
+	std::error_code ec;
+	std::filesystem::create_symlink(original, directory / "link.png", ec);
+	bool haveLink = !ec;
+
+	BlockCompressionOptions compression;
+	compression.Enabled = true;
+	AsyncImageLoader loader;
+	loader.Start(3);
+	AsyncImageHandle full = loader.Request(original);
+	AsyncImageHandle copy = loader.Request(directory / "copy.png");
+	AsyncImageHandle link = haveLink ? loader.Request(directory / "link.png") : INVALID_ASYNC_IMAGE_HANDLE;
+	AsyncImageHandle thumbnail = loader.Request(original, 64);
+	AsyncImageHandle thumbnailCopy = loader.Request(directory / "copy.png", 64);
+	AsyncImageHandle compressed = loader.Request(original, 0, 0, compression);
+
+	FakeSink sink;
+	REQUIRE(PublishAll(loader, sink));
+	std::map<uint64_t, int> numDecoded;
+	std::map<uint64_t, int> numShared;
+	for (const FakeSink::Event& event : sink.Events)
+	{
+		REQUIRE(event.Type != FakeSink::Event::Kind::Failed);
+		REQUIRE(event.ContentHash != 0);
+		(event.Type == FakeSink::Event::Kind::Decoded ? numDecoded : numShared)[event.ContentHash]++;
+	}
+	REQUIRE_EQ(numDecoded.size(), 3u);
+	for (const auto& [contentHash, count] : numDecoded)
+		CHECK_EQ(count, 1);
+
+	uint64_t fullKey = sink.Find(full)->ContentHash;
+	uint64_t thumbnailKey = sink.Find(thumbnail)->ContentHash;
+	CHECK_EQ(sink.Find(copy)->ContentHash, fullKey);
+	if (haveLink)
+		CHECK_EQ(sink.Find(link)->ContentHash, fullKey);
+	CHECK_EQ(sink.Find(thumbnailCopy)->ContentHash, thumbnailKey);
+	CHECK(thumbnailKey != fullKey);
+	CHECK(sink.Find(compressed)->ContentHash != fullKey);
+	CHECK_EQ(numShared[fullKey], haveLink ? 2 : 1);
+	CHECK_EQ(numShared[thumbnailKey], 1);
+
+	// The decoded thumbnail is the small one (under twice maxDimension), whichever request did the decoding.
+	for (const DecodedImage& image : sink.Images)
+	{
+		if (image.ContentHash == thumbnailKey)
+			CHECK(image.Width < 128 && image.Height < 128);
+		else if (image.ContentHash == fullKey)
+			CHECK_EQ(image.Format, TextureFormat::Rgba8);
+		else
+			CHECK(image.Format == TextureFormat::Bc1 || image.Format == TextureFormat::Bc7);
+	}
+
+	loader.ReleaseContent(fullKey);
+	AsyncImageHandle again = loader.Request(directory / "copy.png");
+	AsyncImageHandle stillShared = loader.Request(directory / "copy.png", 64);
+	REQUIRE(PublishAll(loader, sink));
+	CHECK(sink.Find(again)->Type == FakeSink::Event::Kind::Decoded);
+	CHECK(sink.Find(stillShared)->Type == FakeSink::Event::Kind::Shared);
+}
@@ -0,0 +1,282 @@
+#include "TestFramework.h"
+#include "image/AtlasPacker.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace
+{
+	struct ModelEntry
+	{
+		AtlasHandle Handle;
+		int Width = 0; // as requested, without padding
+		int Height = 0;
+		AtlasPlacement Placement;
+	};
+
+	bool Overlaps(const AtlasPlacement& a, const AtlasPlacement& b)
+	{
+		// Padded rectangles, which must not overlap either.
+		const int p = APP_ATLAS_PADDING;
+		return a.Page == b.Page && a.X - p < b.X + b.Width + p && b.X - p < a.X + a.Width + p &&
+			a.Y - p < b.Y + b.Height + p && b.Y - p < a.Y + a.Height + p;
+	}
+
+	AtlasRequest MakeRequest(int width, int height)
+	{
+		AtlasRequest request;
+		request.Width = width;
+		request.Height = height;
+		return request;
+	}
+}
+
+TEST(PacksIntoPagesAndReusesEmptyOnes)
+{
+	AtlasPacker packer;
+	packer.Initialize(256, 2);
+	std::vector<AtlasMove> moves;
+
+	// Four 126x126 images fill a page exactly with their padding; the fifth opens the second page.
+	std::vector<AtlasRequest> requests(5, MakeRequest(126, 126));
+	CHECK_EQ(packer.Insert(requests.data(), requests.size(), moves), 5);
+	CHECK(moves.empty());
+	CHECK_EQ(packer.GetNumPages(), 2);
+	for (int i = 0; i < 4; i++)
+	{
+		AtlasPlacement placement = packer.GetPlacement(requests[i].Handle);
+		CHECK_EQ(placement.Page, 0);
+		CHECK_EQ(placement.Width, 126);
+		CHECK_EQ(placement.X % 128, APP_ATLAS_PADDING);
+		CHECK_EQ(placement.Y % 128, APP_ATLAS_PADDING);
+	}
+	CHECK_EQ(packer.GetPlacement(requests[4].Handle).Page, 1);
+
+	AtlasPackerStats stats = packer.GetStats();
+	CHECK_EQ(stats.NumEntries, 5u);
+	CHECK_EQ(stats.LiveArea, 5u * 128 * 128);
+	CHECK_EQ(stats.PageArea, 2u * 256 * 256);
+	CHECK_EQ(stats.GetEfficiency(), 1.0f);
+
+	// Sizes that cannot fit a page, or are empty, are refused without touching the pages.
+	std::vector<AtlasRequest> refused = {MakeRequest(255, 10), MakeRequest(0, 10), MakeRequest(10, -1)};
+	CHECK_EQ(packer.Insert(refused.data(), refused.size(), moves), 0);
+	for (const AtlasRequest& request : refused)
+		CHECK(request.Handle.IsNull());
+
+	// The last entry leaving a page resets it, so it takes a full load again.
+	CHECK(packer.Remove(requests[4].Handle));
+	CHECK(!packer.Remove(requests[4].Handle));
+	CHECK(!packer.IsValid(requests[4].Handle));
+	CHECK_EQ(packer.GetPlacement(requests[4].Handle).Page, -1);
+	CHECK(packer.IsPageEmpty(1));
+	std::vector<AtlasRequest> refill(4, MakeRequest(126, 126));
+	CHECK_EQ(packer.Insert(refill.data(), refill.size(), moves), 4);
+	CHECK(moves.empty());
+	CHECK_EQ(packer.GetNumPages(), 2);
+	CHECK(!packer.IsValid(requests[4].Handle));
+}
+
+// A page that lost a quarter of its area is repacked for a batch that fits nowhere else, before a page is
+// added; the survivors are listed as moves from where they were.
+TEST(RepacksPagesThatLostSpace)
+{
+	AtlasPacker packer;
+	packer.Initialize(256, 2);
+	std::vector<AtlasMove> moves;
+	std::vector<AtlasRequest> requests(4, MakeRequest(126, 126));
+	REQUIRE_EQ(packer.Insert(requests.data(), requests.size(), moves), 4);
+	AtlasPlacement kept = packer.GetPlacement(requests[3].Handle);
+	REQUIRE(packer.Remove(requests[0].Handle));
+	REQUIRE(packer.Remove(requests[1].Handle));
+
+	std::vector<AtlasRequest> wide = {MakeRequest(254, 100)};
+	CHECK_EQ(packer.Insert(wide.data(), wide.size(), moves), 1);
+	CHECK_EQ(packer.GetNumPages(), 1);
+	CHECK_EQ(packer.GetStats().Repacks, 1u);
+	REQUIRE_EQ(moves.size(), 2u);
+	for (const AtlasMove& move : moves)
+	{
+		CHECK_EQ(move.Page, 0);
+		CHECK_EQ(move.Width, 128);
+		CHECK(packer.IsValid(move.Entry));
+		AtlasPlacement placement = packer.GetPlacement(move.Entry);
+		CHECK_EQ(placement.X, move.DstX + APP_ATLAS_PADDING);
+		CHECK_EQ(placement.Y, move.DstY + APP_ATLAS_PADDING);
+		if (move.Entry.Index == requests[3].Handle.Index)
+		{
+			CHECK_EQ(move.SrcX + APP_ATLAS_PADDING, kept.X);
+			CHECK_EQ(move.SrcY + APP_ATLAS_PADDING, kept.Y);
+		}
+	}
+	CHECK(!Overlaps(packer.GetPlacement(wide[0].Handle), packer.GetPlacement(requests[2].Handle)));
+	CHECK(!Overlaps(packer.GetPlacement(wide[0].Handle), packer.GetPlacement(requests[3].Handle)));
+}
+
+TEST(CopiesWithRepeatedEdges)
+{
+	for (auto [width, height] : {std::pair{1, 1}, {5, 3}, {16, 9}})
+	{
+		std::vector<unsigned char> pixels(static_cast<size_t>(width + 3) * height * 4);
+		for (size_t i = 0; i < pixels.size(); i++)
+			pixels[i] = static_cast<unsigned char>(i * 7 + 1);
+		const size_t rowPitch = static_cast<size_t>(width + 3) * 4;
+		const int paddedWidth = width + 2 * APP_ATLAS_PADDING;
+		const int paddedHeight = height + 2 * APP_ATLAS_PADDING;
+		const size_t dstRowPitch = static_cast<size_t>(paddedWidth + 2) * 4;
+		std::vector<unsigned char> dst(dstRowPitch * paddedHeight, 0xcd);
+		AtlasPacker::CopyWithPadding(pixels.data(), rowPitch, width, height, dst.data(), dstRowPitch);
+
+		for (int y = 0; y < paddedHeight; y++)
+		{
+			int srcY = std::clamp(y - APP_ATLAS_PADDING, 0, height - 1);
+			for (int x = 0; x < paddedWidth; x++)
+			{
+				int srcX = std::clamp(x - APP_ATLAS_PADDING, 0, width - 1);
+				REQUIRE(std::memcmp(&dst[y * dstRowPitch + x * 4], &pixels[srcY * rowPitch + srcX * 4], 4) == 0);
+			}
+			for (size_t i = static_cast<size_t>(paddedWidth) * 4; i < dstRowPitch; i++)
+				REQUIRE_EQ(dst[y * dstRowPitch + i], 0xcd);
+		}
+	}
+}
+
+// Random batches of inserts and removals against a model of where every live image is: placements stay inside
+// their page and never overlap, moves start where the model has the entry and cover every entry of a repacked
+// page, stale handles stay dead, and a request is only left out when every page is in use.
+TEST(RandomizedAgainstModel)
+{
+	uint64_t repacks = 0;
+	uint64_t numLeftOut = 0;
+	for (uint64_t seed = 1; seed <= 6; seed++)
+	{
+		Testing::Random random(seed);
+		const int pageSize = 128 << random.Below(3);
+		const int maxPages = random.Range(1, 6);
+		AtlasPacker packer;
+		packer.Initialize(pageSize, maxPages);
+
+		std::map<uint32_t, ModelEntry> live; // by handle index
+		std::vector<AtlasHandle> removed;
+		std::vector<AtlasMove> moves;
+		for (int step = 0; step < 600; step++)
+		{
+			// Drift between mostly inserting and mostly removing so full and empty pages are both visited.
+			bool insert = random.Below(100) < ((step / 50) % 2 == 0 ? 70u : 35u);
+			if (insert || live.empty())
+			{
+				std::vector<AtlasRequest> requests(random.Range(1, 12));
+				for (AtlasRequest& request : requests)
+				{
+					int limit = random.Below(4) == 0 ? pageSize / 2 : 32;
+					request = MakeRequest(random.Range(1, limit), random.Range(1, limit));
+				}
+				moves.clear();
+				int packed = packer.Insert(requests.data(), requests.size(), moves);
+
+				int numHandles = 0;
+				std::set<uint32_t> added;
+				for (const AtlasRequest& request : requests)
+				{
+					if (request.Handle.IsNull())
+					{
+						REQUIRE_EQ(packer.GetNumPages(), maxPages);
+						numLeftOut++;
+						continue;
+					}
+					numHandles++;
+					REQUIRE(!live.contains(request.Handle.Index));
+					added.insert(request.Handle.Index);
+				}
+
+				// Every entry on a repacked page moves, from where it was. An entry of this batch packed on a
+				// page before the page was repacked moves too; it has no pixels yet, so only its destination counts.
+				std::set<int> repackedPages;
+				std::set<uint32_t> moved;
+				for (const AtlasMove& move : moves)
+				{
+					REQUIRE(moved.insert(move.Entry.Index).second);
+					repackedPages.insert(move.Page);
+					AtlasPlacement placement = packer.GetPlacement(move.Entry);
+					REQUIRE_EQ(move.Page, placement.Page);
+					REQUIRE_EQ(move.DstX + APP_ATLAS_PADDING, placement.X);
+					REQUIRE_EQ(move.DstY + APP_ATLAS_PADDING, placement.Y);
+					REQUIRE_EQ(move.Width, placement.Width + 2 * APP_ATLAS_PADDING);
+					REQUIRE_EQ(move.Height, placement.Height + 2 * APP_ATLAS_PADDING);
+					if (added.contains(move.Entry.Index))
+						continue;
+
+					REQUIRE(live.contains(move.Entry.Index));
+					ModelEntry& entry = live[move.Entry.Index];
+					REQUIRE_EQ(move.Entry.Generation, entry.Handle.Generation);
+					REQUIRE_EQ(move.Page, entry.Placement.Page);
+					REQUIRE_EQ(move.SrcX + APP_ATLAS_PADDING, entry.Placement.X);
+					REQUIRE_EQ(move.SrcY + APP_ATLAS_PADDING, entry.Placement.Y);
+					entry.Placement = placement;
+				}
+				for (const auto& [index, entry] : live)
+					REQUIRE(!repackedPages.contains(entry.Placement.Page) || moved.contains(index));
+
+				for (const AtlasRequest& request : requests)
+				{
+					if (!request.Handle.IsNull())
+						live[request.Handle.Index] = {request.Handle, request.Width, request.Height,
+						                              packer.GetPlacement(request.Handle)};
+				}
+				REQUIRE_EQ(packed, numHandles);
+			}
+			else
+			{
+				auto victim = live.begin();
+				std::advance(victim, random.Below(static_cast<uint32_t>(live.size())));
+				REQUIRE(packer.Remove(victim->second.Handle));
+				removed.push_back(victim->second.Handle);
+				live.erase(victim);
+			}
+
+			for (const AtlasHandle& handle : removed)
+				REQUIRE(!packer.IsValid(handle) || live.contains(handle.Index));
+			if (!removed.empty())
+			{
+				AtlasHandle stale = removed[random.Below(static_cast<uint32_t>(removed.size()))];
+				if (!live.contains(stale.Index) || live[stale.Index].Handle.Generation != stale.Generation)
+					REQUIRE(!packer.Remove(stale));
+			}
+
+			uint64_t liveArea = 0;
+			std::vector<const ModelEntry*> entries;
+			for (const auto& [index, entry] : live)
+			{
+				AtlasPlacement placement = packer.GetPlacement(entry.Handle);
+				REQUIRE_EQ(placement.Page, entry.Placement.Page);
+				REQUIRE_EQ(placement.X, entry.Placement.X);
+				REQUIRE_EQ(placement.Y, entry.Placement.Y);
+				REQUIRE_EQ(placement.Width, entry.Width);
+				REQUIRE_EQ(placement.Height, entry.Height);
+				REQUIRE(placement.Page >= 0 && placement.Page < packer.GetNumPages());
+				REQUIRE(!packer.IsPageEmpty(placement.Page));
+				REQUIRE(placement.X >= APP_ATLAS_PADDING && placement.Y >= APP_ATLAS_PADDING);
+				REQUIRE(placement.X + placement.Width + APP_ATLAS_PADDING <= pageSize);
+				REQUIRE(placement.Y + placement.Height + APP_ATLAS_PADDING <= pageSize);
+				for (const ModelEntry* other : entries)
+					REQUIRE(!Overlaps(placement, other->Placement));
+				entries.push_back(&entry);
+				liveArea += static_cast<uint64_t>(entry.Width + 2 * APP_ATLAS_PADDING) *
+					(entry.Height + 2 * APP_ATLAS_PADDING);
+			}
+
+			AtlasPackerStats stats = packer.GetStats();
+			REQUIRE_EQ(stats.NumEntries, static_cast<uint32_t>(live.size()));
+			REQUIRE_EQ(stats.LiveArea, liveArea);
+			REQUIRE(stats.UsedArea >= stats.LiveArea && stats.UsedArea <= stats.PageArea);
+			REQUIRE(packer.GetNumPages() <= maxPages);
+		}
+		repacks += packer.GetStats().Repacks;
+	}
+	// Otherwise the pages were never full and the model checked little.
+	CHECK(repacks > 0);
+	CHECK(numLeftOut > 0);
+}
@@ -0,0 +1,236 @@
+#include "TestFramework.h"
+#include "TestImages.h"
+#include "core/ThreadPool.h"
+#include "image/BlockCompressor.h"
+#include "image/ImageDecoder.h"
+#include "image/MipGenerator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	std::vector<unsigned char> MakeRgba(int width, int height, int channels, uint64_t seed)
+	{
+		std::vector<unsigned char> photo = TestImages::MakePhoto(width, height, channels, seed);
+		return TestImages::ToRgba(photo.data(), static_cast<size_t>(width) * height, channels);
+	}
+
+	DecodedImage MakeImage(const std::vector<unsigned char>& rgba, int width, int height)
+	{
+		DecodedImage image;
+		image.Width = width;
+		image.Height = height;
+		image.Pixels = ImageDecoder::AllocatePixels(rgba.size());
+		memcpy(image.Pixels, rgba.data(), rgba.size());
+		return image;
+	}
+
+	// Compresses every block of a tightly packed RGBA8 image whose sides are multiples of 4 with the block
+	// encoder and decodes the result.
+	std::vector<unsigned char> RoundTrip(const std::vector<unsigned char>& rgba, int width, int height,
+	                                     TextureFormat format, int quality)
+	{
+		int blockSize = TextureFormats::GetElementSize(format);
+		std::vector<unsigned char> blocks(TextureFormats::GetLevelSize(format, width, height));
+		unsigned char* out = blocks.data();
+		for (int blockY = 0; blockY < height / 4; blockY++)
+		{
+			for (int blockX = 0; blockX < width / 4; blockX++, out += blockSize)
+			{
+				unsigned char block[64];
+				for (int y = 0; y < 4; y++)
+				{
+					size_t offset = ((blockY * 4 + y) * static_cast<size_t>(width) + blockX * 4) * 4;
+					memcpy(block + y * 16, &rgba[offset], 16);
+				}
+				if (format == TextureFormat::Bc1)
+					BlockCompressor::CompressBlockBc1(block, quality, out);
+				else
+					BlockCompressor::CompressBlockBc7(block, quality, out);
+			}
+		}
+		return TestImages::DecodeBlocks(format, blocks.data(), width, height);
+	}
+}
+
+// Random blocks against random palettes, some drawn from a handful of values so that distances tie and the
+// lower index has to win.
+TEST(SelectNearestMatchesReference)
+{
+	Testing::Random random(1);
+	for (int trial = 0; trial < 20000; trial++)
+	{
+		int numColors = trial % 3 == 0 ? 16 : 1 + static_cast<int>(random.Below(16));
+		uint32_t range = trial % 2 == 0 ? 256 : 3;
+		alignas(16) unsigned char pixels[64];
+		alignas(16) unsigned char palette[64] = {};
+		for (unsigned char& value : pixels)
+			value = static_cast<unsigned char>(random.Below(range));
+		for (int i = 0; i < numColors * 4; i++)
+			palette[i] = static_cast<unsigned char>(random.Below(range));
+
+		uint8_t indices[16];
+		uint8_t expectedIndices[16];
+		uint32_t error = BlockCompressor::SelectNearest(pixels, palette, numColors, indices);
+		uint32_t expectedError =
+			BlockCompressor::SelectNearestReference(pixels, palette, numColors, expectedIndices);
+		REQUIRE_EQ(error, expectedError);
+		REQUIRE(memcmp(indices, expectedIndices, sizeof(indices)) == 0);
+	}
+}
+
+// Every extra quality level only keeps endpoints that lower a block's error, so the image never gets worse.
+TEST(DecodedBlocksAreCloseToTheSource)
+{
+	const int width = 256;
+	const int height = 192;
+	for (int channels : {3, 4})
+	{
+		std::vector<unsigned char> rgba = MakeRgba(width, height, channels, channels);
+		TextureFormat format = channels == 3 ? TextureFormat::Bc1 : TextureFormat::Bc7;
+		double previous = 0.0;
+		for (int quality = 0; quality <= APP_MAX_BLOCK_COMPRESSION_QUALITY; quality++)
+		{
+			std::vector<unsigned char> decoded = RoundTrip(rgba, width, height, format, quality);
+			REQUIRE_EQ(decoded.size(), rgba.size());
+			double psnr = TestImages::GetPsnr(rgba, decoded);
+			CHECK(psnr > (format == TextureFormat::Bc1 ? 38.0 : 40.0));
+			CHECK(psnr >= previous);
+			previous = psnr;
+		}
+	}
+}
+
+// Colors that 5:6:5 and BC7's 7 bits plus a p-bit can hold come back exactly, with any quality.
+TEST(SolidBlocksAreExact)
+{
+	const unsigned char BC1_COLORS[][4] = {{0, 0, 0, 255}, {255, 255, 255, 255}, {132, 65, 16, 255}};
+	const unsigned char BC7_COLORS[][4] = {{0, 0, 0, 0}, {255, 255, 255, 255}, {200, 100, 50, 128}, {1, 3, 5, 7}};
+	for (int quality = 0; quality <= APP_MAX_BLOCK_COMPRESSION_QUALITY; quality++)
+	{
+		for (int bc7 = 0; bc7 < 2; bc7++)
+		{
+			int numColors = bc7 ? 4 : 3;
+			for (int i = 0; i < numColors; i++)
+			{
+				const unsigned char* color = bc7 ? BC7_COLORS[i] : BC1_COLORS[i];
+				std::vector<unsigned char> rgba(64);
+				for (int p = 0; p < 16; p++)
+					memcpy(&rgba[p * 4], color, 4);
+				TextureFormat format = bc7 ? TextureFormat::Bc7 : TextureFormat::Bc1;
+				CHECK(RoundTrip(rgba, 4, 4, format, quality) == rgba);
+			}
+		}
+	}
+}
+
+// Opaque images become BC1 and the rest BC7, every level is compressed, and the pool changes nothing.
+TEST(CompressImageCoversEveryLevel)
+{
+	ThreadPool pool;
+	pool.Start(3);
+	const int width = 512;
+	const int height = 516;
+	for (int channels : {3, 4})
+	{
+		std::vector<unsigned char> rgba = MakeRgba(width, height, channels, 10 + channels);
+		DecodedImage serial = MakeImage(rgba, width, height);
+		serial.SourceWidth = width * 2;
+		serial.SourceHeight = height * 2;
+		serial.ContentHash = 1234;
+		REQUIRE(MipGenerator::GenerateMipChain(serial));
+		std::vector<unsigned char> mipData = serial.MipData;
+		int mipLevels = serial.MipLevels;
+
+		DecodedImage parallel = MakeImage(rgba, width, height);
+		REQUIRE(MipGenerator::GenerateMipChain(parallel));
+		REQUIRE(BlockCompressor::CompressImage(serial, 0, nullptr));
+		REQUIRE(BlockCompressor::CompressImage(parallel, 0, &pool));
+
+		TextureFormat format = channels == 3 ? TextureFormat::Bc1 : TextureFormat::Bc7;
+		CHECK_EQ(serial.Format, format);
+		CHECK_EQ(serial.Width, width);
+		CHECK_EQ(serial.Height, height);
+		CHECK_EQ(serial.SourceWidth, width * 2);
+		CHECK_EQ(serial.SourceHeight, height * 2);
+		CHECK_EQ(serial.ContentHash, 1234u);
+		REQUIRE_EQ(serial.MipLevels, mipLevels);
+		CHECK(memcmp(serial.Pixels, parallel.Pixels, serial.GetSizeInBytes()) == 0);
+		CHECK(serial.MipData == parallel.MipData);
+
+		// Level 0 is the block encoder's output; the smaller levels follow the uncompressed chain, which gets too
+		// busy to compress well once a few pixels stand for a whole feature, and those under a block still take
+		// a whole one.
+		size_t srcOffset = 0;
+		size_t dstOffset = 0;
+		int levelWidth = width;
+		int levelHeight = height;
+		for (int level = 0; level < mipLevels; level++)
+		{
+			const unsigned char* src = level == 0 ? rgba.data() : mipData.data() + srcOffset;
+			const unsigned char* blocks = level == 0 ? serial.Pixels : serial.MipData.data() + dstOffset;
+			size_t srcSize = static_cast<size_t>(levelWidth) * levelHeight * 4;
+			std::vector<unsigned char> expected(src, src + srcSize);
+			std::vector<unsigned char> decoded = TestImages::DecodeBlocks(format, blocks, levelWidth, levelHeight);
+			REQUIRE_EQ(decoded.size(), srcSize);
+			if (level == 0)
+				CHECK(decoded == RoundTrip(rgba, width, height, format, 0));
+			if (levelWidth >= 64)
+				CHECK(TestImages::GetPsnr(expected, decoded) > 30.0);
+			if (level > 0)
+			{
+				srcOffset += srcSize;
+				dstOffset += TextureFormats::GetLevelSize(format, levelWidth, levelHeight);
+			}
+			levelWidth = std::max(1, levelWidth / 2);
+			levelHeight = std::max(1, levelHeight / 2);
+		}
+		CHECK_EQ(dstOffset, serial.MipData.size());
+	}
+}
+
+TEST(OnlyLargeRgbaImagesAreCompressed)
+{
+	std::vector<unsigned char> rgba = MakeRgba(512, 512, 3, 20);
+	DecodedImage image = MakeImage(rgba, 512, 512);
+	CHECK(BlockCompressor::CanCompress(image));
+
+	// Too small, not a whole number of blocks, or not RGBA8: CompressImage leaves the image alone.
+	for (auto [width, height] : {std::pair{508, 512}, {512, 510}, {514, 512}})
+	{
+		image.Width = width;
+		image.Height = height;
+		CHECK(!BlockCompressor::CanCompress(image));
+		CHECK(!BlockCompressor::CompressImage(image, 1));
+		CHECK_EQ(image.Format, TextureFormat::Rgba8);
+	}
+	image.Width = 512;
+	image.Height = 512;
+	image.Format = TextureFormat::Bc7;
+	CHECK(!BlockCompressor::CanCompress(image));
+	image.Format = TextureFormat::Rgba8;
+	CHECK(memcmp(image.Pixels, rgba.data(), rgba.size()) == 0);
+
+	DecodedImage empty;
+	empty.Width = 512;
+	empty.Height = 512;
+	CHECK(!BlockCompressor::CanCompress(empty));
+}
+
+TEST(OpaqueMeansEveryAlphaIs255)
+{
+	const int width = 37;
+	const int height = 5;
+	const size_t rowPitch = width * 4 + 12;
+	std::vector<unsigned char> pixels(rowPitch * height, 255);
+	CHECK(BlockCompressor::IsOpaque(pixels.data(), width, height, rowPitch));
+
+	// Padding past the end of a row does not count.
+	pixels[width * 4 + 3] = 0;
+	CHECK(BlockCompressor::IsOpaque(pixels.data(), width, height, rowPitch));
+	pixels[(height - 1) * rowPitch + (width - 1) * 4 + 3] = 254;
+	CHECK(!BlockCompressor::IsOpaque(pixels.data(), width, height, rowPitch));
+}
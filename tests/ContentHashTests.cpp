@@ -0,0 +1,94 @@
+#include "TestFramework.h"
+#include "core/ContentHash.h"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	unsigned char GetTestByte(size_t i)
+	{
+		return static_cast<unsigned char>(((i * 131 + 7) ^ (i >> 8)) & 0xff);
+	}
+
+	std::vector<unsigned char> MakeTestBytes(size_t size)
+	{
+		std::vector<unsigned char> data(size);
+		for (size_t i = 0; i < size; i++)
+			data[i] = GetTestByte(i);
+		return data;
+	}
+}
+
+// From the reference implementation (python-xxhash 4.0.1, xxh3_64_intdigest) over MakeTestBytes, one length on
+// each side of every branch: 1-3, 4-8, 9-16, 17-128, 129-240, then stripes, blocks and a partial last stripe.
+TEST(MatchesTheReferenceImplementation)
+{
+	struct KnownAnswer
+	{
+		size_t Size;
+		uint64_t Hash;
+	};
+	const KnownAnswer answers[] = {
+		{0, 0x2d06800538d394c2ull}, {1, 0x4c5cca45d0f4811full}, {3, 0x6e3e2670e61106acull},
+		{4, 0x5c4c63133443d03full}, {8, 0xf9fd4dd0b04d78f5ull}, {9, 0x7c20df9712c26edfull},
+		{16, 0x86abf6baccea0858ull}, {17, 0xb58bf5dc5022d071ull}, {128, 0x10d17f72c0ccba41ull},
+		{129, 0x1648bdc3db49d1a2ull}, {240, 0xb6cfaf343fab81e6ull}, {241, 0x956cae592c67279eull},
+		{1024, 0x9fb9947417c15b80ull}, {1025, 0xfe1b47100b1d79d8ull}, {2111, 0x226d845cbb794446ull},
+		{100000, 0xb138620783cec1e7ull},
+	};
+	for (const KnownAnswer& answer : answers)
+	{
+		std::vector<unsigned char> data = MakeTestBytes(answer.Size);
+		CHECK_EQ(ContentHash::Hash64(data.data(), data.size()), answer.Hash);
+		CHECK_EQ(ContentHash::Hash64Scalar(data.data(), data.size()), answer.Hash);
+	}
+	CHECK_EQ(ContentHash::Hash64("abc", 3), 0x78af5f94892f3950ull);
+	CHECK_EQ(ContentHash::Hash64(nullptr, 0), 0x2d06800538d394c2ull);
+}
+
+// Whichever SIMD kernel the CPU gets agrees with the scalar path at every length up to a few blocks and at
+// every alignment, and for random large inputs.
+TEST(SimdMatchesScalar)
+{
+	std::vector<unsigned char> data = MakeTestBytes(3000 + 64);
+	for (size_t offset = 0; offset < 8; offset++)
+	{
+		for (size_t size = 0; size <= 3000; size++)
+		{
+			const unsigned char* input = data.data() + offset;
+			REQUIRE_EQ(ContentHash::Hash64(input, size), ContentHash::Hash64Scalar(input, size));
+		}
+	}
+
+	Testing::Random random(20);
+	std::vector<unsigned char> large(1 << 20);
+	for (unsigned char& value : large)
+		value = static_cast<unsigned char>(random.Next());
+	for (int trial = 0; trial < 50; trial++)
+	{
+		size_t offset = random.Below(64);
+		size_t size = random.Below(static_cast<uint32_t>(large.size() - offset));
+		CHECK_EQ(ContentHash::Hash64(large.data() + offset, size),
+		         ContentHash::Hash64Scalar(large.data() + offset, size));
+	}
+}
+
+// Every bit of the input shows up in the hash, in each size class.
+TEST(SingleBitFlipsChangeTheHash)
+{
+	for (size_t size : {size_t(1), size_t(7), size_t(15), size_t(100), size_t(200), size_t(5000)})
+	{
+		std::vector<unsigned char> data = MakeTestBytes(size);
+		uint64_t hash = ContentHash::Hash64(data.data(), data.size());
+		for (size_t i = 0; i < size; i += size / 16 + 1)
+		{
+			for (int bit = 0; bit < 8; bit++)
+			{
+				data[i] ^= static_cast<unsigned char>(1 << bit);
+				CHECK(ContentHash::Hash64(data.data(), data.size()) != hash);
+				data[i] ^= static_cast<unsigned char>(1 << bit);
+			}
+		}
+	}
+}
@@ -0,0 +1,204 @@
+#include "TestFramework.h"
+#include "render/DescriptorIndexAllocator.h"
+
+#include <set>
+#include <vector>
+
+TEST(CommitsPagesOnDemand)
+{
+	DescriptorIndexAllocator allocator;
+	allocator.Initialize(64, 1000);
+	CHECK_EQ(allocator.GetNumPages(), 0u);
+	CHECK_EQ(allocator.GetCommittedCapacity(), 0u);
+
+	DescriptorHandle handle;
+	REQUIRE(allocator.Allocate(&handle));
+	CHECK_EQ(handle.Index, 0u);
+	CHECK_EQ(allocator.GetNumPages(), 1u);
+	CHECK_EQ(allocator.GetCommittedCapacity(), 64u);
+
+	for (uint32_t i = 1; i < 64; i++)
+		REQUIRE(allocator.Allocate(&handle));
+	CHECK_EQ(allocator.GetNumPages(), 1u);
+	REQUIRE(allocator.Allocate(&handle));
+	CHECK_EQ(handle.Index, 64u);
+	CHECK_EQ(allocator.GetNumPages(), 2u);
+	CHECK_EQ(allocator.GetNumAllocated(), 65u);
+}
+
+TEST(ReportsExhaustionInsteadOfAsserting)
+{
+	DescriptorIndexAllocator allocator;
+	allocator.Initialize(128, 200); // the last page is cut short
+	std::vector<DescriptorHandle> handles(200);
+	for (DescriptorHandle& handle : handles)
+		REQUIRE(allocator.Allocate(&handle));
+	CHECK_EQ(allocator.GetCommittedCapacity(), 200u);
+
+	DescriptorHandle extra;
+	CHECK(!allocator.Allocate(&extra));
+	CHECK(extra.IsNull());
+	CHECK_EQ(allocator.GetNumAllocated(), 200u);
+
+	// Room again once something is freed.
+	CHECK(allocator.Free(handles[150]));
+	REQUIRE(allocator.Allocate(&extra));
+	CHECK_EQ(extra.Index, 150u);
+}
+
+TEST(HandsOutTheLowestFreeIndex)
+{
+	DescriptorIndexAllocator allocator;
+	allocator.Initialize(64, 64 * 64 * 3);
+	std::vector<DescriptorHandle> handles(64 * 70);
+	for (DescriptorHandle& handle : handles)
+		REQUIRE(allocator.Allocate(&handle));
+
+	// Free slots in different bitmap words and different summary words.
+	for (uint32_t index : {4100u, 7u, 4095u, 64u * 64u})
+		CHECK(allocator.FreeIndex(index));
+	DescriptorHandle handle;
+	for (uint32_t expected : {7u, 4095u, 4096u, 4100u, 64u * 70u})
+	{
+		REQUIRE(allocator.Allocate(&handle));
+		CHECK_EQ(handle.Index, expected);
+	}
+}
+
+TEST(ResetForgetsEverything)
+{
+	DescriptorIndexAllocator allocator;
+	allocator.Initialize(64, 256);
+	DescriptorHandle handle;
+	for (int i = 0; i < 100; i++)
+		allocator.Allocate(&handle);
+	allocator.Reset();
+	CHECK_EQ(allocator.GetNumAllocated(), 0u);
+	CHECK_EQ(allocator.GetNumPages(), 0u);
+	REQUIRE(allocator.Allocate(&handle));
+	CHECK_EQ(handle.Index, 0u);
+}
+
+// Random allocations and frees against a set of live indices: every allocation is the lowest index not in the
+// set, the counters match, and exhaustion is reported exactly when the set is full.
+TEST(RandomizedAgainstModel)
+{
+	for (uint64_t seed = 1; seed <= 8; seed++)
+	{
+		Testing::Random random(seed);
+		uint32_t pageSize = 64u << random.Below(3);
+		uint32_t maxDescriptors = 1 + random.Below(3000);
+		DescriptorIndexAllocator allocator;
+		allocator.Initialize(pageSize, maxDescriptors);
+
+		std::set<uint32_t> live;
+		std::vector<DescriptorHandle> handles;
+		for (int step = 0; step < 30000; step++)
+		{
+			// Drift between mostly allocating and mostly freeing so both empty and full states are visited.
+			bool allocate = random.Below(100) < ((step / 2000) % 2 == 0 ? 70u : 30u);
+			if (allocate || handles.empty())
+			{
+				uint32_t expected = 0;
+				while (live.contains(expected))
+					expected++;
+
+				DescriptorHandle handle;
+				bool allocated = allocator.Allocate(&handle);
+				REQUIRE_EQ(allocated, expected < maxDescriptors);
+				if (!allocated)
+					continue;
+				REQUIRE_EQ(handle.Index, expected);
+				REQUIRE(allocator.IsValid(handle));
+				live.insert(handle.Index);
+				handles.push_back(handle);
+			}
+			else
+			{
+				size_t victim = random.Below(static_cast<uint32_t>(handles.size()));
+				REQUIRE(allocator.Free(handles[victim]));
+				live.erase(handles[victim].Index);
+				handles[victim] = handles.back();
+				handles.pop_back();
+			}
+			REQUIRE_EQ(allocator.GetNumAllocated(), static_cast<uint32_t>(live.size()));
+			REQUIRE(allocator.GetCommittedCapacity() <= maxDescriptors);
+		}
+	}
+}
+
+TEST(StaleHandlesAreRejected)
+{
+	DescriptorIndexAllocator allocator;
+	allocator.Initialize(64, 64);
+	DescriptorHandle first;
+	REQUIRE(allocator.Allocate(&first));
+	CHECK(allocator.IsValid(first));
+
+	CHECK(allocator.Free(first));
+	CHECK(!allocator.IsValid(first));
+	CHECK(!allocator.Free(first)); // double free
+
+	// The slot is handed out again under a new generation; the old handle must not reach it.
+	DescriptorHandle second;
+	REQUIRE(allocator.Allocate(&second));
+	CHECK_EQ(second.Index, first.Index);
+	CHECK(second.Generation != first.Generation);
+	CHECK(!allocator.IsValid(first));
+	CHECK(!allocator.Free(first));
+	CHECK(allocator.IsValid(second));
+	CHECK_EQ(allocator.GetNumAllocated(), 1u);
+}
+
+TEST(InvalidIndicesAreRejected)
+{
+	DescriptorIndexAllocator allocator;
+	allocator.Initialize(64, 128);
+	DescriptorHandle handle;
+	REQUIRE(allocator.Allocate(&handle));
+
+	CHECK(!allocator.IsValid(DescriptorHandle()));
+	CHECK(!allocator.Free(DescriptorHandle()));
+	CHECK(!allocator.FreeIndex(5)); // committed but never allocated
+	CHECK(!allocator.FreeIndex(100)); // not committed yet
+	CHECK(!allocator.FreeIndex(DescriptorIndexAllocator::INVALID_INDEX));
+	CHECK(allocator.FreeIndex(handle.Index));
+	CHECK(!allocator.FreeIndex(handle.Index));
+	CHECK_EQ(allocator.GetNumAllocated(), 0u);
+}
+
+// Every handle ever freed stays invalid however often its slot is reused.
+TEST(RandomizedStaleHandles)
+{
+	Testing::Random random(42);
+	DescriptorIndexAllocator allocator;
+	allocator.Initialize(64, 256);
+	std::vector<DescriptorHandle> live;
+	std::vector<DescriptorHandle> stale;
+	for (int step = 0; step < 20000; step++)
+	{
+		if (random.Below(2) == 0 || live.empty())
+		{
+			DescriptorHandle handle;
+			if (allocator.Allocate(&handle))
+				live.push_back(handle);
+		}
+		else
+		{
+			size_t victim = random.Below(static_cast<uint32_t>(live.size()));
+			REQUIRE(allocator.Free(live[victim]));
+			stale.push_back(live[victim]);
+			live[victim] = live.back();
+			live.pop_back();
+		}
+
+		if (!stale.empty())
+		{
+			const DescriptorHandle& old = stale[random.Below(static_cast<uint32_t>(stale.size()))];
+			REQUIRE(!allocator.IsValid(old));
+			REQUIRE(!allocator.Free(old));
+		}
+	}
+	for (const DescriptorHandle& handle : live)
+		CHECK(allocator.IsValid(handle));
+}
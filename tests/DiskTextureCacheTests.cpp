@@ -0,0 +1,422 @@
+#include "TestFramework.h"
+#include "TestImages.h"
+#include "image/AsyncImageLoader.h"
+#include "image/DiskTextureCache.h"
+#include "image/MipGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <list>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	// Mipmapped RGBA8 image, or BC1/BC7 when compressed, as AsyncImageLoader hands it to Store.
+	DecodedImage MakeImage(int width, int height, int channels, uint64_t seed, int quality = -1)
+	{
+		std::vector<unsigned char> photo = TestImages::MakePhoto(width, height, channels, seed);
+		std::vector<unsigned char> rgba = TestImages::ToRgba(photo.data(), static_cast<size_t>(width) * height,
+		                                                     channels);
+		DecodedImage image;
+		image.Width = width;
+		image.Height = height;
+		image.SourceWidth = width * 2;
+		image.SourceHeight = height * 2;
+		image.ContentHash = seed + 1;
+		image.Pixels = ImageDecoder::AllocatePixels(rgba.size());
+		std::memcpy(image.Pixels, rgba.data(), rgba.size());
+		MipGenerator::GenerateMipChain(image);
+		if (quality >= 0)
+			BlockCompressor::CompressImage(image, quality);
+		return image;
+	}
+
+	// Small stand-in for a source file: the key only looks at its path, size and modification time.
+	DiskCacheKey MakeSourceKey(const TestImages::TempDirectory& directory, const std::string& name,
+	                           int maxDimension = 0, const BlockCompressionOptions& compression = {})
+	{
+		std::string path = directory / name;
+		if (!std::filesystem::exists(path))
+			TestImages::WriteFile(path, TestImages::MakeNoise(100, name.size()));
+		DiskCacheKey key;
+		REQUIRE(DiskTextureCache::MakeKey(path, maxDimension, compression, &key));
+		return key;
+	}
+
+	// Every level of a cached image holds the stored pixels at the upload layout, with zeros in the padding.
+	void CheckLevels(const DecodedImage& cached, const DecodedImage& stored)
+	{
+		REQUIRE(cached.CacheEntry != nullptr);
+		CHECK(cached.Pixels == nullptr);
+		CHECK_EQ(cached.Format, stored.Format);
+		CHECK_EQ(cached.Width, stored.Width);
+		CHECK_EQ(cached.Height, stored.Height);
+		CHECK_EQ(cached.SourceWidth, stored.SourceWidth);
+		CHECK_EQ(cached.SourceHeight, stored.SourceHeight);
+		CHECK_EQ(cached.ContentHash, stored.ContentHash);
+		REQUIRE_EQ(cached.MipLevels, stored.MipLevels);
+
+		const unsigned char* expected = stored.Pixels;
+		int width = stored.Width;
+		int height = stored.Height;
+		for (int level = 0; level < stored.MipLevels; level++)
+		{
+			const DiskCacheLevel& layout = cached.CacheEntry->Levels[level];
+			size_t rowSize = TextureFormats::GetRowPitch(stored.Format, width);
+			int numRows = TextureFormats::GetNumRows(stored.Format, height);
+			CHECK_EQ(layout.Offset % APP_DISK_CACHE_LEVEL_ALIGNMENT, 0u);
+			CHECK_EQ(layout.RowPitch % APP_DISK_CACHE_ROW_PITCH_ALIGNMENT, 0u);
+			REQUIRE_EQ(layout.RowSize, rowSize);
+			REQUIRE_EQ(layout.NumRows, static_cast<uint32_t>(numRows));
+
+			const unsigned char* data = cached.CacheEntry->GetLevelData(level);
+			for (int row = 0; row < numRows; row++)
+			{
+				const unsigned char* cachedRow = data + static_cast<size_t>(row) * layout.RowPitch;
+				REQUIRE(std::memcmp(cachedRow, expected + row * rowSize, rowSize) == 0);
+				for (size_t i = rowSize; i < layout.RowPitch; i++)
+					REQUIRE_EQ(cachedRow[i], 0);
+			}
+
+			expected = level == 0 ? stored.MipData.data() : expected + rowSize * numRows;
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+		}
+	}
+
+	class CountingSink : public IAsyncTextureSink
+	{
+	public:
+		void OnImageDecoded(AsyncImageHandle, const std::string&, DecodedImage& image) override
+		{
+			Images.push_back(std::move(image));
+		}
+		void OnImageShared(AsyncImageHandle, const std::string&, uint64_t) override {}
+		void OnImageFailed(AsyncImageHandle, const std::string&) override { NumFailed++; }
+
+		std::vector<DecodedImage> Images;
+		int NumFailed = 0;
+	};
+
+	bool LoadAll(DiskTextureCache& cache, const std::vector<std::string>& paths, CountingSink& sink,
+	             const BlockCompressionOptions& compression = {})
+	{
+		AsyncImageLoader loader;
+		loader.SetDiskCache(&cache);
+		loader.Start(2);
+		for (const std::string& path : paths)
+			loader.Request(path, 0, 0, compression);
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+		while (loader.GetNumPending() > 0)
+		{
+			if (std::chrono::steady_clock::now() > deadline)
+				return false;
+			if (loader.Publish(sink) == 0)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return true;
+	}
+}
+
+// Odd sizes, so that rows need padding to the upload pitch, RGBA8 and both block formats.
+TEST(StoredImagesLoadAtTheUploadLayout)
+{
+	TestImages::TempDirectory directory("disk-cache");
+	DiskTextureCache cache;
+	REQUIRE(cache.Open(directory / "cache"));
+	CHECK(cache.IsOpen());
+
+	std::vector<DecodedImage> images;
+	images.push_back(MakeImage(301, 77, 4, 1));
+	images.push_back(MakeImage(516, 512, 3, 2, 0));
+	images.push_back(MakeImage(520, 508, 4, 3, 1));
+	CHECK_EQ(images[1].Format, TextureFormat::Bc1);
+	CHECK_EQ(images[2].Format, TextureFormat::Bc7);
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		DiskCacheKey key = MakeSourceKey(directory, "source" + std::to_string(i) + ".png");
+		DecodedImage missing;
+		CHECK(!cache.Load(key, missing));
+		REQUIRE(cache.Store(key, images[i]));
+
+		DecodedImage cached;
+		REQUIRE(cache.Load(key, cached));
+		CheckLevels(cached, images[i]);
+	}
+
+	DiskCacheStats stats = cache.GetStats();
+	CHECK_EQ(stats.Hits, 3u);
+	CHECK_EQ(stats.Misses, 3u);
+	CHECK_EQ(stats.Stores, 3u);
+	CHECK_EQ(stats.NumFiles, 3u);
+	CHECK_EQ(stats.Evictions, 0u);
+
+	uint64_t totalBytes = 0;
+	for (const auto& entry : std::filesystem::directory_iterator(directory / "cache"))
+		totalBytes += entry.file_size();
+	CHECK_EQ(stats.TotalBytes, totalBytes);
+}
+
+TEST(KeysFollowTheFileAndTheOptions)
+{
+	TestImages::TempDirectory directory("disk-cache");
+	DiskCacheKey key;
+	CHECK(!DiskTextureCache::MakeKey(directory / "missing.png", 0, {}, &key));
+
+	DiskCacheKey base = MakeSourceKey(directory, "a.png");
+	CHECK_EQ(MakeSourceKey(directory, "a.png").Hash, base.Hash);
+	CHECK(MakeSourceKey(directory, "b.png").Hash != base.Hash);
+	CHECK(MakeSourceKey(directory, "a.png", 256).Hash != base.Hash);
+
+	// The quality only counts when compression is on.
+	BlockCompressionOptions compression;
+	compression.Quality = 2;
+	CHECK_EQ(MakeSourceKey(directory, "a.png", 0, compression).Hash, base.Hash);
+	compression.Enabled = true;
+	DiskCacheKey compressed = MakeSourceKey(directory, "a.png", 0, compression);
+	CHECK(compressed.Hash != base.Hash);
+	compression.Quality = 1;
+	CHECK(MakeSourceKey(directory, "a.png", 0, compression).Hash != compressed.Hash);
+
+	// Rewriting the file with another size invalidates the key.
+	TestImages::WriteFile(directory / "a.png", TestImages::MakeNoise(200, 1));
+	CHECK(MakeSourceKey(directory, "a.png").Hash != base.Hash);
+}
+
+// A file that does not match its key, or is cut short, is a miss, and the next Store replaces it.
+TEST(DamagedAndMismatchedFilesMiss)
+{
+	TestImages::TempDirectory directory("disk-cache");
+	DiskTextureCache cache;
+	REQUIRE(cache.Open(directory / "cache"));
+	DecodedImage image = MakeImage(300, 200, 4, 4);
+	DiskCacheKey key = MakeSourceKey(directory, "a.png");
+	REQUIRE(cache.Store(key, image));
+
+	// Same hash, different key: a collision is caught by the stored key.
+	DiskCacheKey collision = key;
+	collision.FileTime++;
+	DecodedImage loaded;
+	CHECK(!cache.Load(collision, loaded));
+	collision = key;
+	collision.MaxDimension = 128;
+	CHECK(!cache.Load(collision, loaded));
+
+	std::filesystem::path file;
+	for (const auto& entry : std::filesystem::directory_iterator(directory / "cache"))
+		file = entry.path();
+	std::vector<unsigned char> original = TestImages::ReadFile(file);
+	// Header bytes that are checked: magic to file time, maximum dimension to height, mip levels, path length.
+	std::vector<uint32_t> checkedOffsets;
+	for (auto [begin, end] : {std::pair{0u, 32u}, {40u, 60u}, {68u, 76u}})
+		for (uint32_t offset = begin; offset < end; offset++)
+			checkedOffsets.push_back(offset);
+
+	Testing::Random random(4);
+	for (int trial = 0; trial < 60; trial++)
+	{
+		std::vector<unsigned char> damaged = original;
+		if (trial % 2 == 0)
+			damaged.resize(random.Below(static_cast<uint32_t>(original.size())));
+		else
+			damaged[checkedOffsets[random.Below(static_cast<uint32_t>(checkedOffsets.size()))]] ^=
+				static_cast<unsigned char>(1 + random.Below(255));
+		TestImages::WriteFile(file, damaged);
+		DecodedImage damagedImage;
+		CHECK(!cache.Load(key, damagedImage));
+	}
+
+	REQUIRE(cache.Store(key, image));
+	DecodedImage restored;
+	REQUIRE(cache.Load(key, restored));
+	CheckLevels(restored, image);
+}
+
+// Entries outlive the cache object; temporaries from a crashed run and unrelated files are ignored, and a
+// smaller budget trims on Open.
+TEST(ReopenKeepsEntriesAndTrims)
+{
+	TestImages::TempDirectory directory("disk-cache");
+	std::string cacheDirectory = directory / "cache";
+	std::vector<DiskCacheKey> keys;
+	DecodedImage image = MakeImage(256, 256, 4, 5);
+	uint64_t fileSize = 0;
+	{
+		DiskTextureCache cache;
+		REQUIRE(cache.Open(cacheDirectory));
+		for (int i = 0; i < 4; i++)
+		{
+			keys.push_back(MakeSourceKey(directory, "image" + std::to_string(i) + ".png"));
+			REQUIRE(cache.Store(keys.back(), image));
+			std::this_thread::sleep_for(std::chrono::milliseconds(20)); // distinct modification times
+		}
+		fileSize = cache.GetStats().TotalBytes / 4;
+		DecodedImage loaded;
+		REQUIRE(cache.Load(keys[0], loaded)); // now the most recently used
+	}
+
+	TestImages::WriteFile(std::filesystem::path(cacheDirectory) / "0123456789abcdef.tex.3.tmp", {1, 2, 3});
+	TestImages::WriteFile(std::filesystem::path(cacheDirectory) / "notes.txt", {1, 2, 3});
+
+	DiskTextureCache cache;
+	REQUIRE(cache.Open(cacheDirectory, fileSize * 2));
+	CHECK(!std::filesystem::exists(std::filesystem::path(cacheDirectory) / "0123456789abcdef.tex.3.tmp"));
+	CHECK(std::filesystem::exists(std::filesystem::path(cacheDirectory) / "notes.txt"));
+	DiskCacheStats stats = cache.GetStats();
+	CHECK_EQ(stats.NumFiles, 2u);
+	CHECK_EQ(stats.Evictions, 2u);
+	CHECK_EQ(stats.TotalBytes, fileSize * 2);
+	CHECK_EQ(cache.GetBudget(), fileSize * 2);
+
+	for (int i = 0; i < 4; i++)
+	{
+		DecodedImage loaded;
+		CHECK_EQ(cache.Load(keys[i], loaded), i == 0 || i == 3);
+	}
+
+	cache.SetBudget(fileSize);
+	CHECK_EQ(cache.GetStats().NumFiles, 1u);
+	cache.Close();
+	CHECK(!cache.IsOpen());
+	DecodedImage loaded;
+	CHECK(!cache.Load(keys[0], loaded));
+	CHECK(!cache.Store(keys[0], image));
+}
+
+// Random stores and loads against a list in least recently used order, with the budget room for a few
+// equally sized files. Now and then the cache is closed and reopened, which has to keep the same order.
+TEST(EvictsLikeAnLruModel)
+{
+	TestImages::TempDirectory directory("disk-cache");
+	std::string cacheDirectory = directory / "cache";
+	const int numKeys = 10;
+	const uint64_t capacity = 4;
+	std::vector<DiskCacheKey> keys;
+	for (int i = 0; i < numKeys; i++)
+		keys.push_back(MakeSourceKey(directory, "image" + std::to_string(i) + ".png"));
+	DecodedImage image = MakeImage(64, 64, 4, 6);
+
+	DiskTextureCache cache;
+	REQUIRE(cache.Open(cacheDirectory));
+	REQUIRE(cache.Store(keys[0], image));
+	uint64_t fileSize = cache.GetStats().TotalBytes;
+	cache.SetBudget(fileSize * capacity);
+
+	std::list<int> model = {0}; // most recently used first
+	Testing::Random random(6);
+	for (int step = 0; step < 400; step++)
+	{
+		int key = static_cast<int>(random.Below(numKeys));
+		bool resident = false;
+		for (int entry : model)
+			resident |= entry == key;
+
+		uint32_t action = random.Below(20);
+		if (action == 0)
+		{
+			cache.Close();
+			REQUIRE(cache.Open(cacheDirectory, fileSize * capacity));
+		}
+		else if (action < 10)
+		{
+			REQUIRE(cache.Store(keys[key], image));
+			model.remove(key);
+			model.push_front(key);
+			if (model.size() > capacity)
+				model.pop_back();
+		}
+		else
+		{
+			DecodedImage loaded;
+			REQUIRE_EQ(cache.Load(keys[key], loaded), resident);
+			if (resident)
+			{
+				model.remove(key);
+				model.push_front(key);
+			}
+		}
+		REQUIRE_EQ(cache.GetStats().NumFiles, static_cast<uint32_t>(model.size()));
+		REQUIRE_EQ(cache.GetStats().TotalBytes, fileSize * model.size());
+		// Modification times on disk carry the order, so they need to tick between steps.
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+}
+
+// Workers racing to store the same key never leave a torn file behind.
+TEST(ConcurrentStoresOfOneKey)
+{
+	TestImages::TempDirectory directory("disk-cache");
+	DiskTextureCache cache;
+	REQUIRE(cache.Open(directory / "cache"));
+	DiskCacheKey key = MakeSourceKey(directory, "a.png");
+	DecodedImage image = MakeImage(300, 300, 4, 7);
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 4; i++)
+	{
+		threads.emplace_back([&] {
+			for (int j = 0; j < 10; j++)
+			{
+				cache.Store(key, image);
+				DecodedImage loaded;
+				if (cache.Load(key, loaded))
+					CheckLevels(loaded, image);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+
+	DecodedImage loaded;
+	REQUIRE(cache.Load(key, loaded));
+	CheckLevels(loaded, image);
+	CHECK_EQ(cache.GetStats().NumFiles, 1u);
+	for (const auto& entry : std::filesystem::directory_iterator(directory / "cache"))
+		CHECK(entry.path().extension() == ".tex");
+}
+
+// The second run through AsyncImageLoader decodes nothing and hands over the same images.
+TEST(WarmLoaderReadsTheCache)
+{
+	TestImages::TempDirectory directory("disk-cache");
+	std::vector<std::string> paths;
+	for (int i = 0; i < 4; i++)
+	{
+		std::vector<unsigned char> pixels = TestImages::MakePhoto(96 + i, 64, 4, i);
+		paths.push_back(directory / ("image" + std::to_string(i) + ".png"));
+		TestImages::WriteFile(paths.back(), TestImages::EncodePng(pixels.data(), 96 + i, 64, {}));
+	}
+
+	DiskTextureCache cache;
+	REQUIRE(cache.Open(directory / "cache"));
+	CountingSink cold;
+	REQUIRE(LoadAll(cache, paths, cold));
+	CHECK_EQ(cache.GetStats().Misses, 4u);
+	CHECK_EQ(cache.GetStats().Stores, 4u);
+
+	cache.Close();
+	REQUIRE(cache.Open(directory / "cache"));
+	CountingSink warm;
+	REQUIRE(LoadAll(cache, paths, warm));
+	CHECK_EQ(cache.GetStats().Hits, 4u);
+	CHECK_EQ(cache.GetStats().Stores, 0u);
+	CHECK_EQ(warm.NumFailed, 0);
+	REQUIRE_EQ(warm.Images.size(), cold.Images.size());
+	for (const DecodedImage& cached : warm.Images)
+	{
+		bool found = false;
+		for (const DecodedImage& decoded : cold.Images)
+		{
+			if (decoded.ContentHash == cached.ContentHash)
+			{
+				CheckLevels(cached, decoded);
+				found = true;
+			}
+		}
+		CHECK(found);
+	}
+}
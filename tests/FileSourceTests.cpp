@@ -0,0 +1,112 @@
+#include "TestFramework.h"
+#include "image/FileSource.h"
+#include "image/ImageDecoder.h"
+#include "support/TestImages.h"
+
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace
+{
+	bool HasContents(const FileSource& source, const std::vector<unsigned char>& expected)
+	{
+		return source.GetSize() == expected.size() && source.GetData() != nullptr &&
+			std::memcmp(source.GetData(), expected.data(), expected.size()) == 0;
+	}
+}
+
+TEST(MappedAndReadPathsSeeTheSameBytes)
+{
+	TestImages::TempDirectory directory("file-source-tests");
+	for (size_t size : {size_t(1), size_t(4095), size_t(4096), size_t(1 << 20) + 17})
+	{
+		std::vector<unsigned char> data = TestImages::MakeNoise(size, size);
+		std::string path = directory / ("file" + std::to_string(size));
+		REQUIRE(TestImages::WriteFile(path, data));
+
+		FileSource mapped;
+		REQUIRE(mapped.Open(path));
+		CHECK(mapped.IsMapped());
+		CHECK(HasContents(mapped, data));
+
+		FileSource read;
+		read.SetMappingEnabled(false);
+		REQUIRE(read.Open(path));
+		CHECK(!read.IsMapped());
+		CHECK(HasContents(read, data));
+	}
+}
+
+TEST(MissingEmptyAndDirectoryPathsFail)
+{
+	TestImages::TempDirectory directory("file-source-tests");
+	std::string empty = directory / "empty";
+	REQUIRE(TestImages::WriteFile(empty, {}));
+
+	for (bool mapping : {true, false})
+	{
+		FileSource source;
+		source.SetMappingEnabled(mapping);
+		CHECK(!source.Open(directory / "missing"));
+		CHECK(!source.Open(empty));
+		CHECK(!source.Open(directory.GetPath().string()));
+		CHECK(source.GetData() == nullptr);
+		CHECK_EQ(source.GetSize(), size_t(0));
+	}
+}
+
+// One FileSource walks a folder as a decode context does: every Open replaces the last file, whichever path
+// served it, and Close leaves nothing behind.
+TEST(ReopeningReplacesTheLastFile)
+{
+	TestImages::TempDirectory directory("file-source-tests");
+	std::vector<unsigned char> large = TestImages::MakeNoise(100000, 1);
+	std::vector<unsigned char> small = TestImages::MakeNoise(100, 2);
+	REQUIRE(TestImages::WriteFile(directory / "large", large));
+	REQUIRE(TestImages::WriteFile(directory / "small", small));
+
+	FileSource source;
+	REQUIRE(source.Open(directory / "large"));
+	CHECK(HasContents(source, large));
+	source.SetMappingEnabled(false);
+	REQUIRE(source.Open(directory / "small"));
+	CHECK(!source.IsMapped());
+	CHECK(HasContents(source, small));
+	source.SetMappingEnabled(true);
+	REQUIRE(source.Open(directory / "large"));
+	CHECK(source.IsMapped());
+	CHECK(HasContents(source, large));
+
+	// A failed Open leaves the source empty rather than on the previous file.
+	CHECK(!source.Open(directory / "missing"));
+	CHECK_EQ(source.GetSize(), size_t(0));
+
+	REQUIRE(source.Open(directory / "small"));
+	source.Close();
+	CHECK(source.GetData() == nullptr);
+	CHECK_EQ(source.GetSize(), size_t(0));
+	CHECK(!source.IsMapped());
+}
+
+TEST(DecodeFileMatchesDecodeMemory)
+{
+	TestImages::TempDirectory directory("file-source-tests");
+	std::vector<unsigned char> pixels = TestImages::MakePhoto(97, 61, 4, 5);
+	std::vector<unsigned char> png = TestImages::EncodePng(pixels.data(), 97, 61, {});
+	std::string path = directory / "photo.png";
+	REQUIRE(TestImages::WriteFile(path, png));
+
+	DecodedImage expected;
+	REQUIRE(ImageDecoder::DecodeMemory(png.data(), png.size(), expected, 0));
+	for (bool mapping : {true, false})
+	{
+		ImageDecodeContext context;
+		context.Source.SetMappingEnabled(mapping);
+		DecodedImage image;
+		REQUIRE(ImageDecoder::DecodeFile(path, image, 0, &context));
+		REQUIRE_EQ(image.GetSizeInBytes(), expected.GetSizeInBytes());
+		CHECK(std::memcmp(image.Pixels, expected.Pixels, expected.GetSizeInBytes()) == 0);
+		CHECK(std::memcmp(image.Pixels, pixels.data(), pixels.size()) == 0);
+	}
+}
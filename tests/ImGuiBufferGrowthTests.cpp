@@ -0,0 +1,177 @@
+#include "TestFramework.h"
+#include "render/ImGuiBufferGrowth.h"
+
+#include <climits>
+#include <vector>
+
+namespace
+{
+	const int MIN_SIZE = 5000; // the backend's vertex buffer default
+
+	// One vertex buffer per frame in flight and the buffers they replaced, driven the way
+	// ImGui_ImplDX12_RenderDrawData drives the backend's, with the counters of ImGui_ImplDX12_BufferStats.
+	class BackendModel
+	{
+	public:
+		BackendModel(uint32_t numFramesInFlight, uint32_t firstFrame)
+			: m_numFramesInFlight(numFramesInFlight), m_frameIndex(firstFrame),
+			  m_frames(numFramesInFlight, Buffer{MIN_SIZE, firstFrame})
+		{
+		}
+
+		// A frame drawing 'required' vertices. The application waited for the fence of the frame that last
+		// used this frame's slot, numFramesInFlight frames ago, and nothing newer.
+		void Render(int required)
+		{
+			m_frameIndex++;
+			for (size_t i = 0; i < m_retired.size(); i++)
+			{
+				if (ImGuiBufferGrowth::CanRelease(m_retired[i].FrameIndex, m_frameIndex, m_numFramesInFlight))
+				{
+					// No frame that may still be running read it.
+					CHECK(m_frameIndex - m_retired[i].LastUsed >= m_numFramesInFlight);
+					m_retired.erase(m_retired.begin() + i--);
+				}
+			}
+
+			Buffer& buffer = m_frames[m_frameIndex % m_numFramesInFlight];
+			int size = ImGuiBufferGrowth::GetGrownSize(buffer.Size, required, MIN_SIZE);
+			CHECK(size >= required);
+			if (size != buffer.Size)
+			{
+				CHECK(size > buffer.Size);
+				m_retired.push_back({buffer.LastUsed, m_frameIndex});
+				buffer.Size = size;
+				Reallocations++;
+			}
+			buffer.LastUsed = m_frameIndex;
+		}
+
+		int GetRetiredBuffers() const { return static_cast<int>(m_retired.size()); }
+
+		uint64_t GetCapacity() const
+		{
+			uint64_t capacity = 0;
+			for (const Buffer& buffer : m_frames)
+				capacity += buffer.Size;
+			return capacity;
+		}
+
+		uint64_t Reallocations = 0;
+
+	private:
+		struct Buffer
+		{
+			int Size;
+			uint32_t LastUsed;
+		};
+
+		struct Retired
+		{
+			uint32_t LastUsed;
+			uint32_t FrameIndex;
+		};
+
+		uint32_t m_numFramesInFlight;
+		uint32_t m_frameIndex;
+		std::vector<Buffer> m_frames;
+		std::vector<Retired> m_retired;
+	};
+}
+
+TEST(GrowsFromEmptyAndSingleElementBuffers)
+{
+	CHECK_EQ(ImGuiBufferGrowth::GetGrownSize(0, 0, 0), 0);
+	CHECK_EQ(ImGuiBufferGrowth::GetGrownSize(0, 1, 0), 2);
+	CHECK_EQ(ImGuiBufferGrowth::GetGrownSize(1, 2, 0), 2);
+	CHECK_EQ(ImGuiBufferGrowth::GetGrownSize(1, 2, 1), 2);
+	CHECK_EQ(ImGuiBufferGrowth::GetGrownSize(0, 1000, 0), 1066);
+	CHECK_EQ(ImGuiBufferGrowth::GetGrownSize(0, 3, MIN_SIZE), MIN_SIZE);
+}
+
+TEST(GrowsByHalfFromTheLargerOfCurrentAndMinimum)
+{
+	// What fits is kept, even below the minimum.
+	CHECK_EQ(ImGuiBufferGrowth::GetGrownSize(MIN_SIZE, 3, MIN_SIZE), MIN_SIZE);
+	CHECK_EQ(ImGuiBufferGrowth::GetGrownSize(100, 100, MIN_SIZE), 100);
+	CHECK_EQ(ImGuiBufferGrowth::GetGrownSize(100, 101, MIN_SIZE), MIN_SIZE);
+	CHECK_EQ(ImGuiBufferGrowth::GetGrownSize(MIN_SIZE, MIN_SIZE + 1, MIN_SIZE), 7500);
+	CHECK_EQ(ImGuiBufferGrowth::GetGrownSize(MIN_SIZE, 11251, MIN_SIZE), 16875);
+	CHECK_EQ(ImGuiBufferGrowth::GetGrownSize(20000, 20001, MIN_SIZE), 30000);
+
+	Testing::Random random(1);
+	for (int i = 0; i < 100000; i++)
+	{
+		int current = static_cast<int>(random.Below(1 << 20));
+		int required = static_cast<int>(random.Below(1 << 22));
+		int minSize = static_cast<int>(random.Below(3)) * MIN_SIZE;
+		int size = ImGuiBufferGrowth::GetGrownSize(current, required, minSize);
+		if (required <= current)
+		{
+			CHECK_EQ(size, current);
+			continue;
+		}
+		int64_t start = current > minSize ? current : minSize;
+		CHECK(size >= required);
+		CHECK(size >= start);
+		// One step short of it did not fit, unless no step was taken.
+		CHECK(size == start || static_cast<int64_t>(size) * 2 / 3 < required);
+	}
+}
+
+TEST(ReturnsTheRequiredSizeWhenAStepWouldOverflow)
+{
+	CHECK_EQ(ImGuiBufferGrowth::GetGrownSize(INT_MAX - 1, INT_MAX, 0), INT_MAX);
+	CHECK_EQ(ImGuiBufferGrowth::GetGrownSize(1 << 30, (1 << 30) + (1 << 29) + 1, 0), (1 << 30) + (1 << 29) + 1);
+	CHECK_EQ(ImGuiBufferGrowth::GetGrownSize(1 << 29, (1 << 29) + 1, 0), (1 << 29) + (1 << 28));
+}
+
+TEST(ReleasesAfterEveryFrameInFlightAcrossWrap)
+{
+	CHECK(!ImGuiBufferGrowth::CanRelease(10, 10, 3));
+	CHECK(!ImGuiBufferGrowth::CanRelease(10, 12, 3));
+	CHECK(ImGuiBufferGrowth::CanRelease(10, 13, 3));
+	CHECK(!ImGuiBufferGrowth::CanRelease(UINT32_MAX - 1, 0, 3));
+	CHECK(ImGuiBufferGrowth::CanRelease(UINT32_MAX - 1, 1, 3));
+}
+
+// A UI ramping to 200k vertices by 150 a frame reallocates each buffer about log1.5(200000 / 5000) times,
+// and every replaced buffer is released once the frames that read it are done.
+TEST(RampingUiReallocatesLogarithmicallyAndReleasesWhatItRetires)
+{
+	for (uint32_t numFramesInFlight : {1u, 2u, 3u})
+	{
+		BackendModel model(numFramesInFlight, 0);
+		for (int required = 0; required <= 200000; required += 150)
+		{
+			model.Render(required);
+			CHECK(model.GetRetiredBuffers() <= static_cast<int>(numFramesInFlight));
+		}
+		CHECK(model.Reallocations <= 10ull * numFramesInFlight);
+		CHECK(model.GetCapacity() <= 300000ull * numFramesInFlight);
+
+		for (uint32_t i = 0; i < numFramesInFlight; i++)
+			model.Render(0);
+		CHECK_EQ(model.GetRetiredBuffers(), 0);
+	}
+}
+
+// Counts that jump around, shrink to nothing and come back, with the frame index wrapping on the way: buffers
+// only grow, and are released only once no running frame can read them.
+TEST(RandomCountsKeepTheBookkeepingConsistent)
+{
+	Testing::Random random(2);
+	BackendModel model(3, UINT32_MAX - 10000);
+	uint64_t lastCapacity = model.GetCapacity();
+	for (int frame = 0; frame < 20000; frame++)
+	{
+		int required = random.Below(8) == 0 ? 0 : static_cast<int>(random.Below(1 + frame * 10));
+		model.Render(required);
+		CHECK(model.GetCapacity() >= lastCapacity);
+		CHECK(model.GetRetiredBuffers() <= 3);
+		lastCapacity = model.GetCapacity();
+	}
+	for (int i = 0; i < 3; i++)
+		model.Render(0);
+	CHECK_EQ(model.GetRetiredBuffers(), 0);
+}
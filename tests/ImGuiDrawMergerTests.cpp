@@ -0,0 +1,302 @@
+#include "TestFramework.h"
+#include "imgui/imgui.h"
+#include "render/ImGuiDrawMerger.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const ImTextureID FONT_TEXTURE_ID = 1;
+
+	// What the merger stamps into the vertices; anything that keeps the IDs apart will do.
+	uint32_t GetTextureIndex(ImTextureID textureId, void* userData)
+	{
+		(*static_cast<int*>(userData))++;
+		return static_cast<uint32_t>(textureId) * 7 + 3;
+	}
+
+	void Callback(const ImDrawList*, const ImDrawCmd*) {}
+
+	// A headless ImGui context that renders to draw data without a backend, the font atlas "uploaded" as
+	// FONT_TEXTURE_ID the way the DX12 backend would before merging.
+	class Context
+	{
+	public:
+		Context()
+		{
+			ImGui::CreateContext();
+			ImGuiIO& io = ImGui::GetIO();
+			io.IniFilename = nullptr;
+			io.DisplaySize = ImVec2(1280.0f, 800.0f);
+			io.DeltaTime = 1.0f / 60.0f;
+			io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures | ImGuiBackendFlags_RendererHasVtxOffset;
+		}
+		~Context() { ImGui::DestroyContext(); }
+
+		// New windows stay hidden for their first frame while they are sized, so a test records its frame twice.
+		template <typename TDraw>
+		ImDrawData* Render(TDraw&& draw)
+		{
+			for (int frame = 0; frame < 2; frame++)
+			{
+				ImGui::NewFrame();
+				draw();
+				Render();
+			}
+			return ImGui::GetDrawData();
+		}
+
+		ImDrawData* Render()
+		{
+			ImGui::Render();
+			for (ImTextureData* texture : ImGui::GetPlatformIO().Textures)
+			{
+				if (texture->Status == ImTextureStatus_WantCreate)
+					texture->SetTexID(FONT_TEXTURE_ID);
+				if (texture->Status == ImTextureStatus_WantDestroy)
+					texture->SetStatus(ImTextureStatus_Destroyed);
+				else if (texture->Status != ImTextureStatus_OK)
+					texture->SetStatus(ImTextureStatus_OK);
+			}
+			return ImGui::GetDrawData();
+		}
+	};
+
+	// One triangle corner or a callback, in the order the GPU gets them, with the texture index it samples.
+	struct Element
+	{
+		bool IsCallback = false;
+		ImVec2 Pos;
+		ImVec2 Uv;
+		ImU32 Col = 0;
+		uint32_t TextureIndex = 0;
+		ImVec4 ClipRect;
+	};
+
+	// Before merging the texture comes from the command, after merging from the vertex.
+	std::vector<Element> Flatten(const ImDrawData* drawData, bool fromVertices)
+	{
+		std::vector<Element> elements;
+		for (const ImDrawList* drawList : drawData->CmdLists)
+		{
+			for (const ImDrawCmd& command : drawList->CmdBuffer)
+			{
+				if (command.UserCallback != nullptr)
+				{
+					Element element;
+					element.IsCallback = true;
+					elements.push_back(element);
+					continue;
+				}
+				int unused = 0;
+				uint32_t commandIndex = fromVertices ? 0 : GetTextureIndex(command.GetTexID(), &unused);
+				for (unsigned int i = 0; i < command.ElemCount; i++)
+				{
+					const ImDrawVert& vertex =
+						drawList->VtxBuffer[command.VtxOffset + drawList->IdxBuffer[command.IdxOffset + i]];
+					Element element;
+					element.Pos = vertex.pos;
+					element.Uv = vertex.uv;
+					element.Col = vertex.col;
+					element.TextureIndex = fromVertices ? vertex.tex_index : commandIndex;
+					element.ClipRect = command.ClipRect;
+					elements.push_back(element);
+				}
+			}
+		}
+		return elements;
+	}
+
+	bool IsSame(const Element& a, const Element& b)
+	{
+		return a.IsCallback == b.IsCallback && std::memcmp(&a.Pos, &b.Pos, sizeof(ImVec2)) == 0 &&
+			std::memcmp(&a.Uv, &b.Uv, sizeof(ImVec2)) == 0 && a.Col == b.Col && a.TextureIndex == b.TextureIndex &&
+			std::memcmp(&a.ClipRect, &b.ClipRect, sizeof(ImVec4)) == 0;
+	}
+
+	// Merges drawData and checks it draws exactly what it drew before, with no two neighbouring draws left that
+	// could have been one.
+	ImGuiDrawMergeStats MergeAndCheck(ImDrawData* drawData)
+	{
+		uint32_t numCommands = 0;
+		uint32_t numCallbacks = 0;
+		for (const ImDrawList* drawList : drawData->CmdLists)
+			for (const ImDrawCmd& command : drawList->CmdBuffer)
+				(command.UserCallback != nullptr ? numCallbacks : numCommands)++;
+		std::vector<Element> before = Flatten(drawData, false);
+
+		ImGuiDrawMerger merger;
+		int numLookups = 0;
+		merger.Merge(drawData, GetTextureIndex, &numLookups);
+		const ImGuiDrawMergeStats& stats = merger.GetStats();
+
+		std::vector<Element> after = Flatten(drawData, true);
+		REQUIRE_EQ(after.size(), before.size());
+		for (size_t i = 0; i < before.size(); i++)
+			REQUIRE(IsSame(after[i], before[i]));
+
+		uint32_t numDraws = 0;
+		for (const ImDrawList* drawList : drawData->CmdLists)
+		{
+			for (int i = 0; i < drawList->CmdBuffer.Size; i++)
+			{
+				const ImDrawCmd& command = drawList->CmdBuffer[i];
+				if (command.UserCallback != nullptr)
+					continue;
+				numDraws++;
+				REQUIRE(command.ElemCount > 0);
+				if (i == 0 || drawList->CmdBuffer[i - 1].UserCallback != nullptr)
+					continue;
+				const ImDrawCmd& previous = drawList->CmdBuffer[i - 1];
+				bool couldMerge = previous.VtxOffset == command.VtxOffset &&
+					previous.IdxOffset + previous.ElemCount == command.IdxOffset &&
+					std::memcmp(&previous.ClipRect, &command.ClipRect, sizeof(ImVec4)) == 0;
+				REQUIRE(!couldMerge);
+			}
+		}
+		CHECK_EQ(stats.NumCommands, numCommands);
+		CHECK_EQ(stats.NumCallbacks, numCallbacks);
+		CHECK_EQ(stats.NumDraws, numDraws);
+		CHECK_EQ(stats.GetMergedCommands(), numCommands - numDraws);
+		CHECK_EQ(static_cast<size_t>(stats.NumIndices), before.size() - numCallbacks);
+		CHECK(numLookups <= static_cast<int>(numCommands));
+		return stats;
+	}
+}
+
+// A gallery of thumbnails with their labels: ImGui splits at every texture change, merging leaves the window
+// background (clipped to the whole window) and one draw for the contents.
+TEST(MergesAGalleryIntoOneDrawPerClipRect)
+{
+	Context context;
+	ImDrawData* drawData = context.Render([] {
+		ImGui::SetNextWindowPos(ImVec2(0, 0));
+		ImGui::SetNextWindowSize(ImVec2(1200, 780));
+		ImGui::Begin("Gallery", nullptr, ImGuiWindowFlags_NoDecoration);
+		for (int i = 0; i < 10; i++)
+		{
+			ImGui::Image(ImTextureRef(static_cast<ImTextureID>(100 + i)), ImVec2(48, 48));
+			ImGui::Text("image%d.png", i);
+		}
+		ImGui::End();
+	});
+	ImGuiDrawMergeStats stats = MergeAndCheck(drawData);
+	CHECK(stats.NumCommands >= 20);
+	CHECK_EQ(stats.NumDraws, 2u);
+}
+
+// Callbacks, scissor changes and child windows (their own draw lists) still split; the rest merges.
+TEST(KeepsWhatSplitsADraw)
+{
+	Context context;
+	ImDrawData* drawData = context.Render([] {
+		ImGui::Begin("Window");
+		ImGui::Image(ImTextureRef(static_cast<ImTextureID>(10)), ImVec2(32, 32));
+		ImGui::Text("before the callback");
+		ImGui::GetWindowDrawList()->AddCallback(Callback, nullptr);
+		ImGui::Image(ImTextureRef(static_cast<ImTextureID>(11)), ImVec2(32, 32));
+		ImGui::Text("after the callback");
+		ImGui::PushClipRect(ImVec2(0, 0), ImVec2(50, 50), true);
+		ImGui::Image(ImTextureRef(static_cast<ImTextureID>(12)), ImVec2(32, 32));
+		ImGui::PopClipRect();
+		ImGui::BeginChild("Child", ImVec2(200, 100), ImGuiChildFlags_Borders);
+		ImGui::Image(ImTextureRef(static_cast<ImTextureID>(13)), ImVec2(32, 32));
+		ImGui::Text("in the child");
+		ImGui::EndChild();
+		ImGui::End();
+	});
+	ImGuiDrawMergeStats stats = MergeAndCheck(drawData);
+	CHECK_EQ(stats.NumCallbacks, 1u);
+	CHECK(stats.NumDraws >= 4);
+	CHECK(stats.NumDraws < stats.NumCommands);
+}
+
+// Random windows of images, text, shapes, callbacks, clip rectangles and split channels, whose merged commands
+// must draw element for element what ImGui recorded. Enough vertices, now and then, to need a VtxOffset.
+TEST(RandomizedAgainstRecordedDrawData)
+{
+	Testing::Random random(24);
+	Context context;
+	uint32_t numMerged = 0;
+	bool usedVertexOffsets = false;
+	for (int frame = 0; frame < 60; frame++)
+	{
+		// Every tenth frame draws past what 16-bit indices reach, with primitives ImGui does not cull.
+		const bool large = frame % 10 == 9;
+		ImGui::NewFrame();
+		int numWindows = random.Range(1, 3);
+		for (int window = 0; window < numWindows; window++)
+		{
+			ImGui::SetNextWindowPos(ImVec2(window * 300.0f, window * 50.0f));
+			ImGui::SetNextWindowSize(ImVec2(400, 600));
+			ImGui::Begin(("Window " + std::to_string(window)).c_str());
+			ImDrawList* drawList = ImGui::GetWindowDrawList();
+			bool split = false;
+			int numClipRects = 0;
+			int numItems = large ? 20000 : random.Range(1, 80);
+			for (int item = 0; item < numItems; item++)
+			{
+				switch (large ? 2 + 5 * random.Below(2) : random.Below(9))
+				{
+				case 0:
+					ImGui::Image(ImTextureRef(static_cast<ImTextureID>(100 + random.Below(5))), ImVec2(16, 16));
+					break;
+				case 1:
+					ImGui::Text("item %d", item);
+					break;
+				case 2:
+					drawList->AddRectFilled(ImVec2(0, 0), ImVec2(20, 20), IM_COL32(255, 0, 0, 255));
+					break;
+				case 3:
+					drawList->AddCallback(Callback, nullptr);
+					break;
+				case 4:
+					if (numClipRects > 0 && random.Below(2) == 0)
+					{
+						ImGui::PopClipRect();
+						numClipRects--;
+					}
+					else
+					{
+						float x = static_cast<float>(random.Below(300));
+						ImGui::PushClipRect(ImVec2(x, 0), ImVec2(x + 100, 400), true);
+						numClipRects++;
+					}
+					break;
+				case 5:
+					// Channels recorded out of order, as tables and columns do.
+					if (!split)
+						drawList->ChannelsSplit(3);
+					else
+						drawList->ChannelsMerge();
+					split = !split;
+					break;
+				case 6:
+					if (split)
+						drawList->ChannelsSetCurrent(static_cast<int>(random.Below(3)));
+					break;
+				case 7:
+					drawList->AddImage(ImTextureRef(static_cast<ImTextureID>(100 + random.Below(5))), ImVec2(20, 0),
+					                   ImVec2(40, 20));
+					break;
+				default:
+					ImGui::SameLine();
+					break;
+				}
+			}
+			if (split)
+				drawList->ChannelsMerge();
+			for (; numClipRects > 0; numClipRects--)
+				ImGui::PopClipRect();
+			ImGui::End();
+		}
+		ImDrawData* drawData = context.Render();
+		for (const ImDrawList* drawList : drawData->CmdLists)
+			usedVertexOffsets |= drawList->CmdBuffer.back().VtxOffset != 0;
+		numMerged += MergeAndCheck(drawData).GetMergedCommands();
+	}
+	CHECK(numMerged > 0);
+	CHECK(usedVertexOffsets);
+}
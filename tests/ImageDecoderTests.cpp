@@ -0,0 +1,127 @@
+#include "TestFramework.h"
+#include "image/ImageDecoder.h"
+#include "image/MipGenerator.h"
+#include "support/TestImages.h"
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	const unsigned char PADDING = 0xCD;
+
+	// Caller memory laid out like an upload buffer: rows at a 256-byte pitch, whatever lies between them marked.
+	struct Staging
+	{
+		size_t RowPitch = 0;
+		std::vector<unsigned char> Data;
+	};
+
+	Staging MakeStaging(int width, int height)
+	{
+		Staging staging;
+		staging.RowPitch = (static_cast<size_t>(width) * 4 + 255) / 256 * 256;
+		staging.Data.assign(staging.RowPitch * height, PADDING);
+		return staging;
+	}
+
+	// The rows of staging against a tightly packed RGBA image; the padding must be left as it was.
+	bool MatchesRows(const Staging& staging, const DecodedImage& image)
+	{
+		size_t rowSize = static_cast<size_t>(image.Width) * 4;
+		for (int y = 0; y < image.Height; y++)
+		{
+			const unsigned char* row = staging.Data.data() + y * staging.RowPitch;
+			if (std::memcmp(row, image.Pixels + y * rowSize, rowSize) != 0)
+				return false;
+			for (size_t x = rowSize; x < staging.RowPitch; x++)
+			{
+				if (row[x] != PADDING)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	std::vector<unsigned char> EncodePng(int width, int height, int colorType, uint64_t seed)
+	{
+		static const int CHANNELS[] = {1, 0, 3, 0, 2, 0, 4};
+		std::vector<unsigned char> pixels = TestImages::MakePhoto(width, height, CHANNELS[colorType], seed);
+		TestImages::PngOptions options;
+		options.ColorType = colorType;
+		return TestImages::EncodePng(pixels.data(), width, height, options);
+	}
+
+	std::vector<unsigned char> EncodeJpeg(int width, int height, bool progressive, uint64_t seed)
+	{
+		std::vector<unsigned char> pixels = TestImages::MakePhoto(width, height, 3, seed);
+		TestImages::JpegOptions options;
+		options.Progressive = progressive;
+		return TestImages::EncodeJpeg(pixels.data(), width, height, options);
+	}
+
+	// DecodeMemoryInto against DecodeMemory, with and without the mip chain GenerateMipChain builds.
+	void CheckAgainstDecodeMemory(const std::vector<unsigned char>& file)
+	{
+		DecodedImage reference;
+		REQUIRE(ImageDecoder::DecodeMemory(file.data(), file.size(), reference));
+		REQUIRE(MipGenerator::GenerateMipChain(reference));
+
+		int width = 0;
+		int height = 0;
+		REQUIRE(ImageDecoder::ReadImageInfo(file.data(), file.size(), &width, &height));
+		CHECK_EQ(width, reference.Width);
+		CHECK_EQ(height, reference.Height);
+
+		Staging staging = MakeStaging(width, height);
+		CHECK(ImageDecoder::DecodeMemoryInto(file.data(), file.size(), staging.Data.data(), staging.RowPitch, width,
+		                                     height));
+		CHECK(MatchesRows(staging, reference));
+
+		Staging withMips = MakeStaging(width, height);
+		std::vector<unsigned char> mipData;
+		CHECK(ImageDecoder::DecodeMemoryInto(file.data(), file.size(), withMips.Data.data(), withMips.RowPitch,
+		                                     width, height, &mipData));
+		CHECK(MatchesRows(withMips, reference));
+		CHECK(mipData == reference.MipData);
+	}
+}
+
+// Every PNG colour type at sizes with odd sides and single rows or columns, through PngDecoder.
+TEST(PngsMatchDecodeMemoryAtTheCallerPitch)
+{
+	for (int colorType : {0, 2, 4, 6})
+	{
+		for (auto [width, height] : {std::pair{37, 23}, {1, 1}, {1, 9}, {64, 1}, {300, 7}})
+			CheckAgainstDecodeMemory(EncodePng(width, height, colorType, width * 31 + height));
+	}
+}
+
+// Baseline JPEGs go through JpegDecoder, progressive ones through stb_image at three channels.
+TEST(JpegsMatchDecodeMemoryAtTheCallerPitch)
+{
+	for (bool progressive : {false, true})
+	{
+		for (auto [width, height] : {std::pair{45, 29}, {1, 1}, {257, 3}})
+			CheckAgainstDecodeMemory(EncodeJpeg(width, height, progressive, width + height));
+	}
+}
+
+TEST(RejectsAnotherSizeOrACorruptFile)
+{
+	std::vector<unsigned char> png = EncodePng(20, 10, 2, 1);
+	std::vector<unsigned char> mipData;
+	for (bool withMips : {false, true})
+	{
+		Staging staging = MakeStaging(21, 10);
+		CHECK(!ImageDecoder::DecodeMemoryInto(png.data(), png.size(), staging.Data.data(), staging.RowPitch, 21, 10,
+		                                      withMips ? &mipData : nullptr));
+		CHECK(std::vector<unsigned char>(staging.Data.size(), PADDING) == staging.Data);
+	}
+
+	std::vector<unsigned char> truncated(png.begin(), png.begin() + png.size() / 2);
+	Staging staging = MakeStaging(20, 10);
+	CHECK(!ImageDecoder::DecodeMemoryInto(truncated.data(), truncated.size(), staging.Data.data(), staging.RowPitch,
+	                                      20, 10));
+}
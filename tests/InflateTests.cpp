@@ -0,0 +1,226 @@
+#include "TestFramework.h"
+#include "TestImages.h"
+#include "image/Inflate.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "stb/stb_image.h"
+#include <zlib.h>
+
+namespace
+{
+	const size_t GUARD_SIZE = 64;
+
+	struct Input
+	{
+		std::string Name;
+		std::vector<unsigned char> Data;
+	};
+
+	// What PNG rows look like, what deflate cannot shrink, and overlapping matches at every short distance.
+	std::vector<Input> MakeInputs()
+	{
+		std::vector<Input> inputs;
+		inputs.push_back({"empty", {}});
+		inputs.push_back({"one byte", {42}});
+		inputs.push_back({"photo", TestImages::MakePhoto(300, 200, 3, 1)});
+		inputs.push_back({"noise", TestImages::MakeNoise(100000, 2)});
+		inputs.push_back({"zeros", std::vector<unsigned char>(200000, 0)});
+
+		std::vector<unsigned char> periodic;
+		for (int period = 1; period <= 20; period++)
+			for (int i = 0; i < 3000; i++)
+				periodic.push_back(static_cast<unsigned char>('a' + i % period));
+		inputs.push_back({"periodic", periodic});
+
+		std::string text;
+		for (int i = 0; i < 2000; i++)
+			text += "The quick brown fox " + std::to_string(i * 7919 % 1000) + " jumps over the lazy dog. ";
+		inputs.push_back({"text", std::vector<unsigned char>(text.begin(), text.end())});
+		return inputs;
+	}
+
+	// Decompresses into a buffer of exactly dstSize bytes followed by guard bytes, which must survive.
+	bool DecompressGuarded(const std::vector<unsigned char>& stream, size_t dstSize, bool raw,
+	                       std::vector<unsigned char>& out_data)
+	{
+		std::vector<unsigned char> buffer(dstSize + GUARD_SIZE, 0xcd);
+		size_t size = 0;
+		bool decoded = raw ? Inflate::DecompressRaw(stream.data(), stream.size(), buffer.data(), dstSize, &size)
+		                   : Inflate::DecompressZlib(stream.data(), stream.size(), buffer.data(), dstSize, &size);
+		for (size_t i = dstSize; i < buffer.size(); i++)
+			REQUIRE_EQ(buffer[i], 0xcd);
+		out_data.assign(buffer.begin(), buffer.begin() + (decoded ? size : 0));
+		return decoded;
+	}
+}
+
+// Every zlib level and strategy, raw and wrapped, against the original data and against stb_image's inflate.
+TEST(MatchesZlibAndStb)
+{
+	const int strategies[] = {Z_DEFAULT_STRATEGY, Z_FILTERED, Z_HUFFMAN_ONLY, Z_RLE, Z_FIXED};
+	for (const Input& input : MakeInputs())
+	{
+		for (int level = 0; level <= 9; level++)
+		{
+			for (int strategy : strategies)
+			{
+				for (bool raw : {false, true})
+				{
+					std::vector<unsigned char> stream =
+						TestImages::Deflate(input.Data.data(), input.Data.size(), level, raw, strategy);
+					std::vector<unsigned char> decoded;
+					bool ok = DecompressGuarded(stream, input.Data.size(), raw, decoded);
+					if (!ok || decoded != input.Data)
+					{
+						std::fprintf(stderr, "%s, level %d, strategy %d, %s\n", input.Name.c_str(), level, strategy,
+						             raw ? "raw" : "zlib");
+						REQUIRE(false);
+					}
+
+					if (!raw && level == 6 && strategy == Z_DEFAULT_STRATEGY)
+					{
+						std::vector<char> stb(input.Data.size() + 1);
+						int stbSize = stbi_zlib_decode_buffer(stb.data(), static_cast<int>(stb.size()),
+						                                      reinterpret_cast<const char*>(stream.data()),
+						                                      static_cast<int>(stream.size()));
+						REQUIRE_EQ(stbSize, static_cast<int>(input.Data.size()));
+						CHECK(memcmp(stb.data(), decoded.data(), decoded.size()) == 0);
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST(ReportsTheBytesTheStreamTook)
+{
+	std::vector<unsigned char> data = TestImages::MakePhoto(64, 64, 3, 3);
+	std::vector<unsigned char> stream = TestImages::Deflate(data.data(), data.size(), 6, true);
+	size_t streamSize = stream.size();
+	stream.insert(stream.end(), {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}); // whatever follows the stream
+
+	std::vector<unsigned char> out(data.size());
+	size_t size = 0;
+	size_t consumed = 0;
+	REQUIRE(Inflate::DecompressRaw(stream.data(), stream.size(), out.data(), out.size(), &size, &consumed));
+	CHECK_EQ(size, data.size());
+	CHECK_EQ(consumed, streamSize);
+	CHECK(out == data);
+}
+
+// Every truncation of a stream fails, as does output that would not fit, and nothing is written past dstSize.
+TEST(TruncatedStreamsAndShortOutputFail)
+{
+	for (int level : {0, 1, 9})
+	{
+		std::vector<unsigned char> data = TestImages::MakePhoto(40, 30, 3, level);
+		for (bool raw : {false, true})
+		{
+			std::vector<unsigned char> stream = TestImages::Deflate(data.data(), data.size(), level, raw);
+			std::vector<unsigned char> decoded;
+			for (size_t length = 0; length < stream.size(); length++)
+			{
+				std::vector<unsigned char> truncated(stream.begin(), stream.begin() + length);
+				CHECK(!DecompressGuarded(truncated, data.size(), raw, decoded));
+			}
+			for (size_t dstSize : {size_t(0), size_t(1), data.size() / 2, data.size() - 1})
+				CHECK(!DecompressGuarded(stream, dstSize, raw, decoded));
+			CHECK(DecompressGuarded(stream, data.size() + 100, raw, decoded));
+			CHECK(decoded == data);
+		}
+	}
+}
+
+TEST(ZlibHeaderAndChecksumAreVerified)
+{
+	std::vector<unsigned char> data = TestImages::MakePhoto(50, 50, 4, 4);
+	std::vector<unsigned char> stream = TestImages::Deflate(data.data(), data.size(), 6);
+	std::vector<unsigned char> decoded;
+	REQUIRE(DecompressGuarded(stream, data.size(), false, decoded));
+
+	for (size_t i = 0; i < 4; i++)
+	{
+		std::vector<unsigned char> badAdler = stream;
+		badAdler[stream.size() - 1 - i] ^= 0x10;
+		CHECK(!DecompressGuarded(badAdler, data.size(), false, decoded));
+	}
+
+	std::vector<unsigned char> badMethod = stream;
+	badMethod[0] = (badMethod[0] & 0xF0) | 7;
+	CHECK(!DecompressGuarded(badMethod, data.size(), false, decoded));
+	std::vector<unsigned char> badCheck = stream;
+	badCheck[1] ^= 1; // header no longer a multiple of 31
+	CHECK(!DecompressGuarded(badCheck, data.size(), false, decoded));
+	std::vector<unsigned char> dictionary = stream;
+	dictionary[1] = static_cast<unsigned char>(0x20 | (31 - ((dictionary[0] << 8) | 0x20) % 31) % 31); // FDICT
+	CHECK(!DecompressGuarded(dictionary, data.size(), false, decoded));
+}
+
+// Random corruption never writes past the output buffer, and whatever decodes successfully agrees with zlib.
+TEST(RandomCorruptionAgreesWithZlib)
+{
+	Testing::Random random(15);
+	std::vector<unsigned char> data = TestImages::MakePhoto(80, 60, 3, 5);
+	std::vector<unsigned char> stream = TestImages::Deflate(data.data(), data.size(), 6, true);
+	for (int trial = 0; trial < 3000; trial++)
+	{
+		std::vector<unsigned char> corrupt = stream;
+		int numFlips = 1 + static_cast<int>(random.Below(4));
+		for (int flip = 0; flip < numFlips; flip++)
+		{
+			size_t pos = random.Below(static_cast<uint32_t>(corrupt.size()));
+			corrupt[pos] ^= static_cast<unsigned char>(1 + random.Below(255));
+		}
+
+		std::vector<unsigned char> decoded;
+		bool ok = DecompressGuarded(corrupt, data.size(), true, decoded);
+
+		std::vector<unsigned char> expected(data.size());
+		z_stream zlibStream = {};
+		inflateInit2(&zlibStream, -15);
+		zlibStream.next_in = corrupt.data();
+		zlibStream.avail_in = static_cast<uInt>(corrupt.size());
+		zlibStream.next_out = expected.data();
+		zlibStream.avail_out = static_cast<uInt>(expected.size());
+		bool zlibOk = inflate(&zlibStream, Z_FINISH) == Z_STREAM_END;
+		expected.resize(zlibStream.total_out);
+		inflateEnd(&zlibStream);
+
+		REQUIRE_EQ(ok, zlibOk);
+		if (ok)
+			REQUIRE(decoded == expected);
+	}
+}
+
+TEST(AdlerMatchesZlib)
+{
+	const char* wikipedia = "Wikipedia";
+	CHECK_EQ(Inflate::Adler32(reinterpret_cast<const unsigned char*>(wikipedia), 9), 0x11E60398u);
+	CHECK_EQ(Inflate::Adler32(nullptr, 0), 1u);
+
+	// Long runs of 0xff push both sums past the modulus as fast as possible.
+	std::vector<unsigned char> data = TestImages::MakeNoise(1 << 20, 6);
+	std::vector<unsigned char> ones(100000, 0xff);
+	for (const std::vector<unsigned char>* bytes : {&data, &ones})
+	{
+		for (size_t size : {size_t(1), size_t(15), size_t(16), size_t(5552), size_t(5553), bytes->size()})
+		{
+			uint32_t expected = static_cast<uint32_t>(adler32(1, bytes->data(), static_cast<uInt>(size)));
+			CHECK_EQ(Inflate::Adler32(bytes->data(), size), expected);
+		}
+	}
+
+	// Combining the checksums of the pieces gives the checksum of the whole.
+	Testing::Random random(16);
+	for (int trial = 0; trial < 200; trial++)
+	{
+		size_t split = random.Below(static_cast<uint32_t>(data.size()));
+		size_t end = split + random.Below(static_cast<uint32_t>(data.size() - split));
+		uint32_t a = Inflate::Adler32(data.data(), split);
+		uint32_t b = Inflate::Adler32(data.data() + split, end - split);
+		CHECK_EQ(Inflate::CombineAdler32(a, b, end - split), Inflate::Adler32(data.data(), end));
+	}
+}
@@ -0,0 +1,277 @@
+#include "TestFramework.h"
+#include "image/ImageDecoder.h"
+#include "image/JpegDecoder.h"
+#include "support/TestImages.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "stb/stb_image.h"
+
+namespace
+{
+	struct Layout
+	{
+		const char* Name;
+		TestImages::JpegOptions Options;
+	};
+
+	const Layout LAYOUTS[] = {
+		{"4:2:0", {3, 90, 2, 2}},
+		{"4:2:2", {3, 90, 2, 1}},
+		{"4:4:0", {3, 90, 1, 2}},
+		{"4:4:4", {3, 90, 1, 1}},
+		{"gray", {1, 90, 1, 1}},
+		{"4:2:0 restarts", {3, 75, 2, 2, false, 1}},
+		{"4:4:4 restarts", {3, 90, 1, 1, false, 3}},
+	};
+
+	std::vector<unsigned char> Encode(int width, int height, const TestImages::JpegOptions& options, uint64_t seed)
+	{
+		std::vector<unsigned char> pixels = TestImages::MakePhoto(width, height, options.Components, seed);
+		return TestImages::EncodeJpeg(pixels.data(), width, height, options);
+	}
+
+	std::vector<unsigned char> Decode(const std::vector<unsigned char>& file, int scaleShift, int* out_width,
+	                                  int* out_height)
+	{
+		JpegInfo info;
+		if (!JpegDecoder::ReadInfo(file.data(), file.size(), &info) || !JpegDecoder::IsSupported(info))
+			return {};
+		*out_width = JpegDecoder::GetScaledSize(info.Width, scaleShift);
+		*out_height = JpegDecoder::GetScaledSize(info.Height, scaleShift);
+		std::vector<unsigned char> rgba(static_cast<size_t>(*out_width) * *out_height * 4);
+		if (!JpegDecoder::Decode(file.data(), file.size(), rgba.data(), static_cast<size_t>(*out_width) * 4,
+		                         scaleShift))
+			return {};
+		return rgba;
+	}
+
+	std::vector<unsigned char> DecodeWithStb(const std::vector<unsigned char>& file)
+	{
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		stbi_uc* pixels = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height,
+		                                        &channels, 4);
+		if (!pixels)
+			return {};
+		std::vector<unsigned char> rgba(pixels, pixels + static_cast<size_t>(width) * height * 4);
+		stbi_image_free(pixels);
+		return rgba;
+	}
+
+	struct Difference
+	{
+		double Mean = 0;
+		int Max = 0;
+	};
+
+	// A scaled decode against the full decode averaged over the 2^s x 2^s pixels each output pixel covers.
+	Difference CompareWithBoxFilter(const std::vector<unsigned char>& full, int width, int height,
+	                                const std::vector<unsigned char>& scaled, int scaleShift)
+	{
+		int scaledWidth = JpegDecoder::GetScaledSize(width, scaleShift);
+		int scaledHeight = JpegDecoder::GetScaledSize(height, scaleShift);
+		int factor = 1 << scaleShift;
+		Difference difference;
+		double total = 0;
+		for (int y = 0; y < scaledHeight; y++)
+		{
+			for (int x = 0; x < scaledWidth; x++)
+			{
+				for (int c = 0; c < 3; c++)
+				{
+					int sum = 0;
+					int count = 0;
+					for (int sy = y * factor; sy < (y + 1) * factor && sy < height; sy++)
+						for (int sx = x * factor; sx < (x + 1) * factor && sx < width; sx++, count++)
+							sum += full[(static_cast<size_t>(sy) * width + sx) * 4 + c];
+					int expected = (sum + count / 2) / count;
+					int error = std::abs(expected - scaled[(static_cast<size_t>(y) * scaledWidth + x) * 4 + c]);
+					total += error;
+					difference.Max = error > difference.Max ? error : difference.Max;
+				}
+			}
+		}
+		difference.Mean = total / (3.0 * scaledWidth * scaledHeight);
+		return difference;
+	}
+}
+
+TEST(ReadsTheHeader)
+{
+	TestImages::JpegOptions options;
+	options.SamplingV = 1;
+	std::vector<unsigned char> file = Encode(321, 123, options, 1);
+	JpegInfo info;
+	REQUIRE(JpegDecoder::ReadInfo(file.data(), file.size(), &info));
+	CHECK_EQ(info.Width, 321);
+	CHECK_EQ(info.Height, 123);
+	CHECK_EQ(info.Components, 3);
+	CHECK_EQ(info.Precision, 8);
+	CHECK_EQ(info.SamplingH[0], 2);
+	CHECK_EQ(info.SamplingV[0], 1);
+	CHECK_EQ(info.SamplingH[1], 1);
+	CHECK(info.Sequential);
+	CHECK(!JpegDecoder::ReadInfo(file.data() + 1, file.size() - 1, &info));
+}
+
+// Every layout at sizes that end inside an MCU, byte for byte against stb_image, into rows with padding
+// after them that must be left alone.
+TEST(FullDecodesMatchStb)
+{
+	for (const Layout& layout : LAYOUTS)
+	{
+		for (auto [width, height] : {std::pair{1, 1}, {7, 5}, {16, 16}, {17, 9}, {333, 217}, {640, 480}})
+		{
+			std::vector<unsigned char> file = Encode(width, height, layout.Options, width * 3 + height);
+			std::vector<unsigned char> expected = DecodeWithStb(file);
+			REQUIRE(!expected.empty());
+
+			JpegInfo info;
+			REQUIRE(JpegDecoder::ReadInfo(file.data(), file.size(), &info));
+			REQUIRE(JpegDecoder::IsSupported(info));
+			size_t rowSize = static_cast<size_t>(width) * 4;
+			size_t rowPitch = rowSize + 20;
+			std::vector<unsigned char> padded(rowPitch * height, 0xcd);
+			REQUIRE(JpegDecoder::Decode(file.data(), file.size(), padded.data(), rowPitch));
+
+			bool matches = true;
+			for (int y = 0; y < height && matches; y++)
+			{
+				const unsigned char* row = padded.data() + rowPitch * y;
+				matches = std::memcmp(row, expected.data() + rowSize * y, rowSize) == 0;
+				for (size_t i = rowSize; i < rowPitch; i++)
+					matches = matches && row[i] == 0xcd;
+			}
+			if (!matches)
+			{
+				std::fprintf(stderr, "%s, %dx%d\n", layout.Name, width, height);
+				REQUIRE(false);
+			}
+		}
+	}
+}
+
+// Progressive files are not this decoder's; ImageDecoder hands them to stb_image.
+TEST(ProgressiveFilesAreLeftToStb)
+{
+	TestImages::JpegOptions options;
+	options.Progressive = true;
+	std::vector<unsigned char> file = Encode(200, 100, options, 2);
+	JpegInfo info;
+	REQUIRE(JpegDecoder::ReadInfo(file.data(), file.size(), &info));
+	CHECK(!info.Sequential);
+	CHECK(!JpegDecoder::IsSupported(info));
+	std::vector<unsigned char> rgba(200 * 100 * 4);
+	CHECK(!JpegDecoder::Decode(file.data(), file.size(), rgba.data(), 200 * 4));
+
+	DecodedImage image;
+	REQUIRE(ImageDecoder::DecodeMemory(file.data(), file.size(), image));
+	std::vector<unsigned char> expected = DecodeWithStb(file);
+	REQUIRE_EQ(expected.size(), rgba.size());
+	CHECK(std::memcmp(image.Pixels, expected.data(), expected.size()) == 0);
+}
+
+TEST(ScaledSizesRoundUp)
+{
+	CHECK_EQ(JpegDecoder::GetScaledSize(4000, 0), 4000);
+	CHECK_EQ(JpegDecoder::GetScaledSize(4000, 3), 500);
+	CHECK_EQ(JpegDecoder::GetScaledSize(4001, 3), 501);
+	CHECK_EQ(JpegDecoder::GetScaledSize(3, 1), 2);
+	CHECK_EQ(JpegDecoder::GetScaledSize(1, 3), 1);
+}
+
+// Each reduced IDCT against the full decode box-filtered to the same size. Without chroma subsampling that is
+// all the scaled IDCT approximates, so only rounding is left; subsampled chroma is decoded at the output
+// resolution rather than upsampled, which moves hard chroma edges a little.
+TEST(ScaledDecodesMatchTheBoxFilteredFullDecode)
+{
+	for (const Layout& layout : LAYOUTS)
+	{
+		bool subsampled = layout.Options.Components == 3 &&
+			(layout.Options.SamplingH > 1 || layout.Options.SamplingV > 1);
+		for (auto [width, height] : {std::pair{256, 192}, {333, 141}, {17, 9}})
+		{
+			std::vector<unsigned char> file = Encode(width, height, layout.Options, width + height);
+			int fullWidth = 0;
+			int fullHeight = 0;
+			std::vector<unsigned char> full = Decode(file, 0, &fullWidth, &fullHeight);
+			REQUIRE(!full.empty());
+			for (int scaleShift = 1; scaleShift <= JpegDecoder::MAX_SCALE_SHIFT; scaleShift++)
+			{
+				int scaledWidth = 0;
+				int scaledHeight = 0;
+				std::vector<unsigned char> scaled = Decode(file, scaleShift, &scaledWidth, &scaledHeight);
+				REQUIRE(!scaled.empty());
+				CHECK_EQ(scaledWidth, (width + (1 << scaleShift) - 1) >> scaleShift);
+				CHECK_EQ(scaledHeight, (height + (1 << scaleShift) - 1) >> scaleShift);
+
+				Difference difference = CompareWithBoxFilter(full, width, height, scaled, scaleShift);
+				if (!subsampled)
+					CHECK(difference.Max <= 4);
+				else if (width >= 64) // a 17x9 image is mostly chroma edges
+					CHECK(difference.Mean < 1.5);
+				for (size_t i = 3; i < scaled.size(); i += 4)
+					REQUIRE_EQ(scaled[i], 255);
+			}
+		}
+	}
+}
+
+// libjpeg's DCT scaling is also a box filter in disguise: without subsampled chroma the two agree to rounding.
+TEST(ScaledDecodesMatchLibjpeg)
+{
+	for (const Layout& layout : LAYOUTS)
+	{
+		if (layout.Options.Components == 3 && layout.Options.SamplingH * layout.Options.SamplingV > 1)
+			continue;
+		std::vector<unsigned char> file = Encode(301, 203, layout.Options, 3);
+		for (int scaleShift = 1; scaleShift <= JpegDecoder::MAX_SCALE_SHIFT; scaleShift++)
+		{
+			int width = 0;
+			int height = 0;
+			std::vector<unsigned char> scaled = Decode(file, scaleShift, &width, &height);
+			int expectedWidth = 0;
+			int expectedHeight = 0;
+			std::vector<unsigned char> expected =
+				TestImages::DecodeJpegScaled(file, 1 << scaleShift, &expectedWidth, &expectedHeight);
+			REQUIRE_EQ(width, expectedWidth);
+			REQUIRE_EQ(height, expectedHeight);
+			int maxError = 0;
+			for (size_t i = 0; i < expected.size(); i++)
+				maxError = std::max(maxError, std::abs(expected[i] - scaled[i]));
+			CHECK(maxError <= 3);
+		}
+	}
+}
+
+// The decoder only takes the halvings ReduceToDisplaySize would have made, and leaves any further ones to it.
+TEST(DisplaySizeDecodesUseTheScaledIdct)
+{
+	TestImages::JpegOptions options;
+	std::vector<unsigned char> file = Encode(1000, 600, options, 11);
+
+	DecodedImage image;
+	REQUIRE(ImageDecoder::DecodeMemory(file.data(), file.size(), image, 200));
+	CHECK_EQ(image.Width, 250);
+	CHECK_EQ(image.Height, 150);
+	CHECK_EQ(image.SourceWidth, 1000);
+	CHECK_EQ(image.SourceHeight, 600);
+	int width = 0;
+	int height = 0;
+	std::vector<unsigned char> scaled = Decode(file, 2, &width, &height);
+	CHECK(std::memcmp(image.Pixels, scaled.data(), scaled.size()) == 0);
+
+	// Four halvings: three in the IDCT, one box filter after it.
+	REQUIRE(ImageDecoder::DecodeMemory(file.data(), file.size(), image, 50));
+	CHECK_EQ(image.Width, 62);
+	CHECK_EQ(image.Height, 37);
+
+	REQUIRE(ImageDecoder::DecodeMemory(file.data(), file.size(), image, 0));
+	CHECK_EQ(image.Width, 1000);
+	CHECK_EQ(image.Height, 600);
+}
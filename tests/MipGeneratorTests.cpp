@@ -0,0 +1,150 @@
+#include "TestFramework.h"
+#include "image/MipGenerator.h"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	std::vector<unsigned char> MakePixels(int width, int height, size_t rowPitch, uint64_t seed)
+	{
+		Testing::Random random(seed);
+		std::vector<unsigned char> pixels(rowPitch * height);
+		for (unsigned char& value : pixels)
+			value = static_cast<unsigned char>(random.Next());
+		return pixels;
+	}
+
+	// The filter spelled out: the rounded mean of the 2x2 block, with the last row or column repeated where
+	// the source is only one pixel thick.
+	unsigned char ExpectedSample(const unsigned char* src, int srcWidth, int srcHeight, size_t srcRowPitch, int x,
+	                             int y, int c)
+	{
+		int x0 = 2 * x;
+		int y0 = 2 * y;
+		int x1 = x0 + 1 < srcWidth ? x0 + 1 : srcWidth - 1;
+		int y1 = y0 + 1 < srcHeight ? y0 + 1 : srcHeight - 1;
+		int sum = src[y0 * srcRowPitch + x0 * 4 + c] + src[y0 * srcRowPitch + x1 * 4 + c] +
+			src[y1 * srcRowPitch + x0 * 4 + c] + src[y1 * srcRowPitch + x1 * 4 + c];
+		return static_cast<unsigned char>((sum + 2) / 4);
+	}
+}
+
+TEST(LevelCountsFollowD3D12)
+{
+	CHECK_EQ(MipGenerator::GetMipLevelCount(1, 1), 1);
+	CHECK_EQ(MipGenerator::GetMipLevelCount(2, 1), 2);
+	CHECK_EQ(MipGenerator::GetMipLevelCount(256, 256), 9);
+	CHECK_EQ(MipGenerator::GetMipLevelCount(257, 3), 9);
+	CHECK_EQ(MipGenerator::GetMipLevelCount(1920, 1080), 11);
+	CHECK_EQ(MipGenerator::GetMipLevelCount(16384, 1), 15);
+
+	// 5x3 -> 2x1 -> 1x1
+	CHECK_EQ(MipGenerator::GetMipChainSize(5, 3), size_t(2 * 1 * 4 + 1 * 1 * 4));
+	CHECK_EQ(MipGenerator::GetMipChainSize(1, 1), size_t(0));
+}
+
+TEST(ReferenceMatchesTheFilterDefinition)
+{
+	for (auto [width, height] : {std::pair{2, 2}, {7, 5}, {1, 9}, {9, 1}, {33, 17}})
+	{
+		size_t pitch = static_cast<size_t>(width) * 4 + 12;
+		std::vector<unsigned char> src = MakePixels(width, height, pitch, width * 100 + height);
+		int dstWidth = width / 2 > 0 ? width / 2 : 1;
+		int dstHeight = height / 2 > 0 ? height / 2 : 1;
+		std::vector<unsigned char> dst(static_cast<size_t>(dstWidth) * dstHeight * 4);
+		MipGenerator::DownsampleBoxReference(src.data(), width, height, pitch, dst.data(), dstWidth * 4);
+		for (int y = 0; y < dstHeight; y++)
+			for (int x = 0; x < dstWidth; x++)
+				for (int c = 0; c < 4; c++)
+					REQUIRE_EQ(dst[(y * dstWidth + x) * 4 + c],
+					           ExpectedSample(src.data(), width, height, pitch, x, y, c));
+	}
+}
+
+// The SIMD path against the reference over every width up to a few vectors (all tail lengths), odd and
+// one-pixel sizes, and padded row pitches.
+TEST(SimdMatchesReference)
+{
+	for (int width = 1; width <= 70; width++)
+	{
+		for (int height : {1, 2, 3, 8, 11})
+		{
+			size_t srcPitch = static_cast<size_t>(width) * 4 + (width % 3) * 4;
+			std::vector<unsigned char> src = MakePixels(width, height, srcPitch, width * 31 + height);
+			int dstWidth = width / 2 > 0 ? width / 2 : 1;
+			int dstHeight = height / 2 > 0 ? height / 2 : 1;
+			size_t dstPitch = static_cast<size_t>(dstWidth) * 4 + 8;
+
+			std::vector<unsigned char> expected(dstPitch * dstHeight, 0xcd);
+			std::vector<unsigned char> actual(dstPitch * dstHeight, 0xcd);
+			MipGenerator::DownsampleBoxReference(src.data(), width, height, srcPitch, expected.data(), dstPitch);
+			MipGenerator::DownsampleBox(src.data(), width, height, srcPitch, actual.data(), dstPitch);
+			REQUIRE(expected == actual); // the pitch padding is left alone too
+		}
+	}
+}
+
+TEST(InPlaceMatchesOutOfPlace)
+{
+	const int width = 101;
+	const int height = 64;
+	const size_t pitch = width * 4;
+	std::vector<unsigned char> src = MakePixels(width, height, pitch, 5);
+	std::vector<unsigned char> expected(static_cast<size_t>(width / 2) * (height / 2) * 4);
+	MipGenerator::DownsampleBoxReference(src.data(), width, height, pitch, expected.data(), (width / 2) * 4);
+
+	MipGenerator::DownsampleBox(src.data(), width, height, pitch, src.data(), (width / 2) * 4);
+	CHECK(std::memcmp(src.data(), expected.data(), expected.size()) == 0);
+}
+
+TEST(GeneratedChainIsRepeatedDownsampling)
+{
+	const int width = 300;
+	const int height = 77;
+	std::vector<unsigned char> pixels = MakePixels(width, height, width * 4, 9);
+
+	DecodedImage image;
+	image.Width = width;
+	image.Height = height;
+	image.Pixels = ImageDecoder::AllocatePixels(pixels.size());
+	std::memcpy(image.Pixels, pixels.data(), pixels.size());
+	REQUIRE(MipGenerator::GenerateMipChain(image));
+	CHECK_EQ(image.MipLevels, MipGenerator::GetMipLevelCount(width, height));
+	REQUIRE_EQ(image.MipData.size(), MipGenerator::GetMipChainSize(width, height));
+
+	std::vector<unsigned char> level = pixels;
+	int levelWidth = width;
+	int levelHeight = height;
+	size_t offset = 0;
+	for (int i = 1; i < image.MipLevels; i++)
+	{
+		int nextWidth = levelWidth / 2 > 0 ? levelWidth / 2 : 1;
+		int nextHeight = levelHeight / 2 > 0 ? levelHeight / 2 : 1;
+		std::vector<unsigned char> next(static_cast<size_t>(nextWidth) * nextHeight * 4);
+		MipGenerator::DownsampleBoxReference(level.data(), levelWidth, levelHeight, levelWidth * 4, next.data(),
+		                                     nextWidth * 4);
+		REQUIRE(std::memcmp(image.MipData.data() + offset, next.data(), next.size()) == 0);
+		offset += next.size();
+		level = std::move(next);
+		levelWidth = nextWidth;
+		levelHeight = nextHeight;
+	}
+	CHECK_EQ(levelWidth, 1);
+	CHECK_EQ(levelHeight, 1);
+}
+
+TEST(BlockCompressedImagesKeepTheirChain)
+{
+	DecodedImage image;
+	image.Format = TextureFormat::Bc1;
+	image.Width = 8;
+	image.Height = 8;
+	image.Pixels = ImageDecoder::AllocatePixels(image.GetSizeInBytes());
+	CHECK(MipGenerator::GenerateMipChain(image));
+	CHECK_EQ(image.MipLevels, 1);
+	CHECK(image.MipData.empty());
+
+	DecodedImage empty;
+	CHECK(!MipGenerator::GenerateMipChain(empty));
+}
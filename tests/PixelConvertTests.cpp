@@ -0,0 +1,105 @@
+#include "TestFramework.h"
+#include "image/PixelConvert.h"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	using RowFn = void (*)(const uint8_t* src, uint8_t* dst, int width);
+
+	struct Converter
+	{
+		const char* Name;
+		int SrcChannels;
+		RowFn Dispatched;
+		RowFn Reference;
+	};
+
+	const Converter CONVERTERS[] = {
+		{"RGB", 3, PixelConvert::RgbToRgba, PixelConvert::RgbToRgbaReference},
+		{"BGR", 3, PixelConvert::BgrToRgba, PixelConvert::BgrToRgbaReference},
+		{"BGRA", 4, PixelConvert::BgraToRgba, PixelConvert::BgraToRgbaReference},
+		{"gray", 1, PixelConvert::GrayToRgba, PixelConvert::GrayToRgbaReference},
+		{"gray+alpha", 2, PixelConvert::GrayAlphaToRgba, PixelConvert::GrayAlphaToRgbaReference},
+	};
+
+	std::vector<uint8_t> MakeBytes(size_t size, uint64_t seed)
+	{
+		Testing::Random random(seed);
+		std::vector<uint8_t> bytes(size);
+		for (uint8_t& value : bytes)
+			value = static_cast<uint8_t>(random.Next());
+		return bytes;
+	}
+}
+
+TEST(ReferencesFollowTheChannelLayouts)
+{
+	const uint8_t src[8] = {10, 20, 30, 40, 50, 60, 70, 80};
+	const struct
+	{
+		RowFn Reference;
+		uint8_t Expected[8];
+	} cases[] = {
+		{PixelConvert::RgbToRgbaReference, {10, 20, 30, 255, 40, 50, 60, 255}},
+		{PixelConvert::BgrToRgbaReference, {30, 20, 10, 255, 60, 50, 40, 255}},
+		{PixelConvert::BgraToRgbaReference, {30, 20, 10, 40, 70, 60, 50, 80}},
+		{PixelConvert::GrayToRgbaReference, {10, 10, 10, 255, 20, 20, 20, 255}},
+		{PixelConvert::GrayAlphaToRgbaReference, {10, 10, 10, 20, 30, 30, 30, 40}},
+	};
+	for (const auto& testCase : cases)
+	{
+		uint8_t dst[8];
+		testCase.Reference(src, dst, 2);
+		CHECK(std::memcmp(dst, testCase.Expected, sizeof(dst)) == 0);
+	}
+}
+
+// Every width up to a few vector lengths, from unaligned source and destination addresses, so each kernel's
+// main loop, its tail and the scalar remainder are all compared. Nothing past the row is written.
+TEST(DispatchedKernelsMatchReferences)
+{
+	std::printf("kernels: %s\n", PixelConvert::GetKernelName());
+	for (const Converter& converter : CONVERTERS)
+	{
+		for (int width = 0; width <= 200; width++)
+		{
+			for (int misalign : {0, 1, 3})
+			{
+				size_t srcSize = static_cast<size_t>(width) * converter.SrcChannels;
+				std::vector<uint8_t> src = MakeBytes(srcSize + misalign, width * 7 + misalign);
+				std::vector<uint8_t> expected(static_cast<size_t>(width) * 4 + misalign + 64, 0xcd);
+				std::vector<uint8_t> actual(expected);
+
+				converter.Reference(src.data() + misalign, expected.data() + misalign, width);
+				converter.Dispatched(src.data() + misalign, actual.data() + misalign, width);
+				if (expected != actual)
+				{
+					std::fprintf(stderr, "%s, width %d, misaligned by %d\n", converter.Name, width, misalign);
+					REQUIRE(expected == actual);
+				}
+			}
+		}
+	}
+}
+
+TEST(ConvertRowPicksTheConverterForTheChannelCount)
+{
+	const int width = 77;
+	std::vector<uint8_t> src = MakeBytes(static_cast<size_t>(width) * 4, 3);
+	std::vector<uint8_t> expected(static_cast<size_t>(width) * 4);
+	std::vector<uint8_t> actual(expected.size());
+
+	// 1, 2 and 3 channels are gray, gray+alpha and RGB; 4 is already RGBA and copied as it is.
+	const RowFn references[] = {PixelConvert::GrayToRgbaReference, PixelConvert::GrayAlphaToRgbaReference,
+	                            PixelConvert::RgbToRgbaReference};
+	for (int components = 1; components <= 3; components++)
+	{
+		references[components - 1](src.data(), expected.data(), width);
+		PixelConvert::ConvertRowToRgba(src.data(), components, actual.data(), width);
+		CHECK(expected == actual);
+	}
+	PixelConvert::ConvertRowToRgba(src.data(), 4, actual.data(), width);
+	CHECK(actual == src);
+}
@@ -0,0 +1,322 @@
+#include "TestFramework.h"
+#include "TestImages.h"
+#include "core/ThreadPool.h"
+#include "image/ImageDecoder.h"
+#include "image/PngDecoder.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "stb/stb_image.h"
+
+namespace
+{
+	const int COLOR_TYPES[] = {0, 2, 3, 4, 6};
+
+	int GetChannelCount(int colorType)
+	{
+		switch (colorType)
+		{
+		case 0:
+		case 3:
+			return 1;
+		case 4:
+			return 2;
+		case 2:
+			return 3;
+		default:
+			return 4;
+		}
+	}
+
+	std::vector<uint32_t> MakePalette(uint64_t seed)
+	{
+		Testing::Random random(seed);
+		std::vector<uint32_t> palette(256);
+		for (uint32_t& entry : palette)
+			entry = static_cast<uint32_t>(random.Next());
+		return palette;
+	}
+
+	std::vector<unsigned char> MakePng(int width, int height, const TestImages::PngOptions& options, uint64_t seed)
+	{
+		int bitDepth = options.ColorType == 3 ? 8 : options.BitDepth;
+		std::vector<unsigned char> pixels =
+			TestImages::MakePhoto(width, height, GetChannelCount(options.ColorType), seed, bitDepth);
+		return TestImages::EncodePng(pixels.data(), width, height, options, MakePalette(seed));
+	}
+
+	std::vector<unsigned char> DecodeWithStb(const std::vector<unsigned char>& png)
+	{
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		stbi_uc* pixels = stbi_load_from_memory(png.data(), static_cast<int>(png.size()), &width, &height,
+		                                        &channels, 4);
+		if (!pixels)
+			return {};
+		std::vector<unsigned char> rgba(pixels, pixels + static_cast<size_t>(width) * height * 4);
+		stbi_image_free(pixels);
+		return rgba;
+	}
+
+	// Decodes into rows with some padding after them, checks the padding was left alone and returns the
+	// tightly packed pixels; empty when Decode fails.
+	std::vector<unsigned char> DecodeWithPngDecoder(const std::vector<unsigned char>& png, ThreadPool* pool)
+	{
+		PngInfo info;
+		if (!PngDecoder::ReadInfo(png.data(), png.size(), &info))
+			return {};
+		size_t rowSize = static_cast<size_t>(info.Width) * 4;
+		size_t rowPitch = rowSize + 12;
+		std::vector<unsigned char> padded(rowPitch * info.Height, 0xcd);
+		if (!PngDecoder::Decode(png.data(), png.size(), padded.data(), rowPitch, pool))
+			return {};
+
+		std::vector<unsigned char> rgba(rowSize * info.Height);
+		for (int y = 0; y < info.Height; y++)
+		{
+			const unsigned char* row = padded.data() + rowPitch * y;
+			memcpy(rgba.data() + rowSize * y, row, rowSize);
+			for (size_t i = rowSize; i < rowPitch; i++)
+				CHECK_EQ(row[i], 0xcd);
+		}
+		return rgba;
+	}
+
+	// Inserts a chunk before the first IDAT. Neither decoder checks CRCs, so it is left zero.
+	std::vector<unsigned char> InsertChunk(const std::vector<unsigned char>& png, const char* type,
+	                                       const std::vector<unsigned char>& payload)
+	{
+		size_t pos = 8;
+		while (memcmp(png.data() + pos + 4, "IDAT", 4) != 0)
+		{
+			uint32_t length = (png[pos] << 24) | (png[pos + 1] << 16) | (png[pos + 2] << 8) | png[pos + 3];
+			pos += 12 + length;
+		}
+
+		std::vector<unsigned char> chunk = {static_cast<unsigned char>(payload.size() >> 24),
+		                                    static_cast<unsigned char>(payload.size() >> 16),
+		                                    static_cast<unsigned char>(payload.size() >> 8),
+		                                    static_cast<unsigned char>(payload.size())};
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), payload.begin(), payload.end());
+		chunk.insert(chunk.end(), 4, 0);
+
+		std::vector<unsigned char> result(png.begin(), png.begin() + pos);
+		result.insert(result.end(), chunk.begin(), chunk.end());
+		result.insert(result.end(), png.begin() + pos, png.end());
+		return result;
+	}
+
+	// Offset of the zlib stream's Adler-32, the last four bytes of the last IDAT.
+	size_t FindAdler(const std::vector<unsigned char>& png)
+	{
+		for (size_t pos = png.size() - 8; pos > 8; pos--)
+			if (memcmp(png.data() + pos, "IEND", 4) == 0)
+				return pos - 4 - 4 - 4; // IEND length, IDAT CRC, Adler-32
+		return 0;
+	}
+}
+
+TEST(ReadsTheHeader)
+{
+	TestImages::PngOptions options;
+	options.ColorType = 2;
+	options.BitDepth = 16;
+	std::vector<unsigned char> png = MakePng(300, 200, options, 1);
+
+	PngInfo info;
+	REQUIRE(PngDecoder::ReadInfo(png.data(), png.size(), &info));
+	CHECK_EQ(info.Width, 300);
+	CHECK_EQ(info.Height, 200);
+	CHECK_EQ(info.BitDepth, 16);
+	CHECK_EQ(info.ColorType, 2);
+	CHECK(!info.Interlaced);
+	CHECK(PngDecoder::IsSupported(info));
+
+	// Interlaced files and sub-byte depths are left to stb_image.
+	std::vector<unsigned char> interlaced = png;
+	interlaced[8 + 8 + 12] = 1;
+	REQUIRE(PngDecoder::ReadInfo(interlaced.data(), interlaced.size(), &info));
+	CHECK(info.Interlaced);
+	CHECK(!PngDecoder::IsSupported(info));
+	std::vector<unsigned char> rgba(300 * 200 * 4);
+	CHECK(!PngDecoder::Decode(interlaced.data(), interlaced.size(), rgba.data(), 300 * 4, nullptr));
+
+	CHECK(!PngDecoder::IsSupported({16, 16, 4, 0, false}));
+	CHECK(!PngDecoder::IsSupported({16, 16, 16, 3, false}));
+	CHECK(!PngDecoder::ReadInfo(png.data(), 20, &info));
+	CHECK(!PngDecoder::ReadInfo(png.data() + 1, png.size() - 1, &info));
+}
+
+// Every color type, bit depth and filter, on the calling thread and on a pool, against stb_image's RGBA8.
+TEST(MatchesStbForEveryLayout)
+{
+	ThreadPool pool;
+	pool.Start(3);
+	for (int colorType : COLOR_TYPES)
+	{
+		for (int bitDepth : {8, 16})
+		{
+			if (colorType == 3 && bitDepth == 16)
+				continue;
+			for (int filter = -1; filter <= 4; filter++)
+			{
+				TestImages::PngOptions options;
+				options.ColorType = colorType;
+				options.BitDepth = bitDepth;
+				options.Filter = filter;
+				options.IdatSize = 997; // the stream spans many chunks
+				std::vector<unsigned char> png = MakePng(97, 61, options, colorType * 100 + bitDepth + filter);
+
+				std::vector<unsigned char> expected = DecodeWithStb(png);
+				REQUIRE(!expected.empty());
+				for (ThreadPool* decodePool : {static_cast<ThreadPool*>(nullptr), &pool})
+				{
+					if (DecodeWithPngDecoder(png, decodePool) != expected)
+					{
+						std::fprintf(stderr, "color type %d, %d-bit, filter %d, %s\n", colorType, bitDepth, filter,
+						             decodePool ? "pool" : "serial");
+						REQUIRE(false);
+					}
+				}
+			}
+		}
+	}
+}
+
+// A tRNS color makes the pixels that match it exactly transparent, compared at the file's bit depth.
+TEST(TransparentColorMatchesStb)
+{
+	for (int colorType : {0, 2})
+	{
+		for (int bitDepth : {8, 16})
+		{
+			const int width = 64;
+			const int height = 40;
+			int channels = GetChannelCount(colorType);
+			int bytesPerSample = bitDepth / 8;
+			std::vector<unsigned char> pixels = TestImages::MakePhoto(width, height, channels, 5, bitDepth);
+			// Repeat the first pixel so the transparent color shows up more than once.
+			size_t pixelSize = static_cast<size_t>(channels) * bytesPerSample;
+			for (size_t i = 1; i < pixels.size() / pixelSize; i += 7)
+				memcpy(pixels.data() + i * pixelSize, pixels.data(), pixelSize);
+
+			TestImages::PngOptions options;
+			options.ColorType = colorType;
+			options.BitDepth = bitDepth;
+			std::vector<unsigned char> png = TestImages::EncodePng(pixels.data(), width, height, options);
+
+			std::vector<unsigned char> trns;
+			for (int c = 0; c < channels; c++)
+			{
+				uint16_t value = pixels[c * bytesPerSample];
+				if (bitDepth == 16)
+					memcpy(&value, pixels.data() + c * 2, 2);
+				trns.push_back(static_cast<unsigned char>(value >> 8));
+				trns.push_back(static_cast<unsigned char>(value));
+			}
+			png = InsertChunk(png, "tRNS", trns);
+
+			std::vector<unsigned char> expected = DecodeWithStb(png);
+			REQUIRE(!expected.empty());
+			CHECK_EQ(expected[3], 0);
+			CHECK(DecodeWithPngDecoder(png, nullptr) == expected);
+		}
+	}
+}
+
+// Large enough for the pool to inflate full-flushed streams segment by segment and to unfilter runs of rows in
+// parallel; plain streams fall back to one inflate.
+TEST(ParallelDecodeMatchesStb)
+{
+	ThreadPool pool;
+	pool.Start(4);
+	for (int fullFlushRows : {0, 64})
+	{
+		for (auto [colorType, bitDepth] : {std::pair{6, 8}, {2, 16}})
+		{
+			TestImages::PngOptions options;
+			options.ColorType = colorType;
+			options.BitDepth = bitDepth;
+			options.Level = 1;
+			options.FullFlushRows = fullFlushRows;
+			std::vector<unsigned char> png = MakePng(1024, 768, options, 11);
+			REQUIRE(png.size() > 4 * 256 * 1024); // room for several inflate segments
+
+			std::vector<unsigned char> expected = DecodeWithStb(png);
+			REQUIRE(!expected.empty());
+			CHECK(DecodeWithPngDecoder(png, &pool) == expected);
+			CHECK(DecodeWithPngDecoder(png, nullptr) == expected);
+		}
+	}
+}
+
+TEST(CorruptStreamsFail)
+{
+	ThreadPool pool;
+	pool.Start(4);
+	TestImages::PngOptions options;
+	options.Level = 1;
+	options.FullFlushRows = 64;
+	std::vector<unsigned char> png = MakePng(1024, 768, options, 12);
+	REQUIRE(!DecodeWithPngDecoder(png, &pool).empty());
+
+	std::vector<unsigned char> badAdler = png;
+	size_t adler = FindAdler(badAdler);
+	REQUIRE(adler != 0);
+	badAdler[adler + 3] ^= 1;
+
+	std::vector<unsigned char> badData = png;
+	badData[png.size() / 2] ^= 0x5a;
+
+	std::vector<unsigned char> truncated(png.begin(), png.begin() + png.size() / 2);
+
+	for (const std::vector<unsigned char>* corrupt : {&badAdler, &badData, &truncated})
+	{
+		for (ThreadPool* decodePool : {static_cast<ThreadPool*>(nullptr), &pool})
+		{
+			std::vector<unsigned char> rgba(1024 * 768 * 4);
+			CHECK(!PngDecoder::Decode(corrupt->data(), corrupt->size(), rgba.data(), 1024 * 4, decodePool));
+		}
+	}
+}
+
+// A header claiming a huge image over a few bytes of image data must fail without allocating for it, in
+// PngDecoder and in the stb_image fallback behind ImageDecoder.
+TEST(OversizedHeadersFailWithoutAllocating)
+{
+	struct Header
+	{
+		uint32_t Width;
+		uint32_t Height;
+		unsigned char BitDepth;
+		bool Supported;
+	};
+	for (Header header : {Header{30000, 30000, 16, false}, Header{10000, 10000, 8, true}})
+	{
+		TestImages::PngOptions options;
+		options.BitDepth = header.BitDepth;
+		std::vector<unsigned char> png = MakePng(16, 16, options, 13);
+		for (int i = 0; i < 4; i++)
+		{
+			png[16 + i] = static_cast<unsigned char>(header.Width >> (24 - 8 * i));
+			png[20 + i] = static_cast<unsigned char>(header.Height >> (24 - 8 * i));
+		}
+
+		PngInfo info;
+		REQUIRE(PngDecoder::ReadInfo(png.data(), png.size(), &info));
+		CHECK_EQ(PngDecoder::IsSupported(info), header.Supported);
+
+		bool canResetPeak = TestImages::ResetPeakRss();
+		uint64_t before = TestImages::GetPeakRss();
+		unsigned char row[64] = {};
+		CHECK(!PngDecoder::Decode(png.data(), png.size(), row, 0, nullptr));
+		DecodedImage image;
+		CHECK(!ImageDecoder::DecodeMemory(png.data(), png.size(), image));
+		if (canResetPeak)
+			CHECK(TestImages::GetPeakRss() - before < 64ull * 1024 * 1024);
+	}
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Just enough of a unit test framework for the headless tests: TEST registers a function, CHECK* report a
+// failure and carry on, REQUIRE* also leave the test. Every test executable links TestMain.cpp, which runs
+// them all (or those whose name contains argv[1]) and returns non-zero when any check failed.
+namespace Testing
+{
+	struct TestCase
+	{
+		const char* Name;
+		std::function<void()> Body;
+	};
+
+	// Thrown by REQUIRE* to leave the current test.
+	struct RequireFailed
+	{
+	};
+
+	inline std::vector<TestCase>& GetTests()
+	{
+		static std::vector<TestCase> tests;
+		return tests;
+	}
+
+	inline int& GetNumFailures()
+	{
+		static int numFailures = 0;
+		return numFailures;
+	}
+
+	inline bool Register(const char* name, std::function<void()> body)
+	{
+		GetTests().push_back({name, std::move(body)});
+		return true;
+	}
+
+	inline void ReportFailure(const char* file, int line, const std::string& message)
+	{
+		std::fprintf(stderr, "%s(%d): check failed: %s\n", file, line, message.c_str());
+		GetNumFailures()++;
+	}
+
+	template <typename T>
+	void PrintValue(std::ostream& stream, const T& value)
+	{
+		if constexpr (std::is_enum_v<T>)
+			stream << static_cast<int64_t>(value);
+		else if constexpr (std::is_arithmetic_v<T>)
+			stream << +value; // characters as numbers
+		else if constexpr (requires { stream << value; })
+			stream << value;
+		else
+			stream << "?";
+	}
+
+	template <typename TA, typename TB>
+	std::string DescribeComparison(const char* expression, const TA& a, const TB& b)
+	{
+		std::ostringstream stream;
+		stream << expression << " (";
+		PrintValue(stream, a);
+		stream << " vs ";
+		PrintValue(stream, b);
+		stream << ")";
+		return stream.str();
+	}
+
+	// Deterministic and identical on every platform, unlike the std distributions.
+	class Random
+	{
+	public:
+		explicit Random(uint64_t seed) : m_state(seed * 0x9e3779b97f4a7c15ull + 1) {}
+
+		uint64_t Next()
+		{
+			// splitmix64
+			uint64_t z = (m_state += 0x9e3779b97f4a7c15ull);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			return z ^ (z >> 31);
+		}
+
+		// In [0, bound).
+		uint32_t Below(uint32_t bound) { return static_cast<uint32_t>(Next() % bound); }
+		// In [low, high].
+		int Range(int low, int high) { return low + static_cast<int>(Below(static_cast<uint32_t>(high - low + 1))); }
+
+	private:
+		uint64_t m_state;
+	};
+}
+
+#define APP_TEST_CONCAT_INNER(a, b) a##b
+#define APP_TEST_CONCAT(a, b) APP_TEST_CONCAT_INNER(a, b)
+
+#define TEST(name) \
+	static void name(); \
+	static const bool APP_TEST_CONCAT(s_registered_, name) = Testing::Register(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+			Testing::ReportFailure(__FILE__, __LINE__, #condition); \
+	} while (0)
+
+#define CHECK_EQ(a, b) \
+	do \
+	{ \
+		const auto& checkA_ = (a); \
+		const auto& checkB_ = (b); \
+		if (!(checkA_ == checkB_)) \
+			Testing::ReportFailure(__FILE__, __LINE__, Testing::DescribeComparison(#a " == " #b, checkA_, checkB_)); \
+	} while (0)
+
+#define REQUIRE(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			Testing::ReportFailure(__FILE__, __LINE__, #condition); \
+			throw Testing::RequireFailed(); \
+		} \
+	} while (0)
+
+#define REQUIRE_EQ(a, b) \
+	do \
+	{ \
+		const auto& requireA_ = (a); \
+		const auto& requireB_ = (b); \
+		if (!(requireA_ == requireB_)) \
+		{ \
+			Testing::ReportFailure(__FILE__, __LINE__, \
+			                       Testing::DescribeComparison(#a " == " #b, requireA_, requireB_)); \
+			throw Testing::RequireFailed(); \
+		} \
+	} while (0)
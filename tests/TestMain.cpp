@@ -0,0 +1,33 @@
+#include "TestFramework.h"
+
+#include <cstring>
+#include <exception>
+
+int main(int argc, char** argv)
+{
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+	int numRun = 0;
+	for (const Testing::TestCase& test : Testing::GetTests())
+	{
+		if (filter && !std::strstr(test.Name, filter))
+			continue;
+
+		int failuresBefore = Testing::GetNumFailures();
+		try
+		{
+			test.Body();
+		}
+		catch (const Testing::RequireFailed&)
+		{
+		}
+		catch (const std::exception& e)
+		{
+			Testing::ReportFailure(__FILE__, __LINE__, std::string("exception: ") + e.what());
+		}
+		numRun++;
+		std::printf("[%s] %s\n", Testing::GetNumFailures() == failuresBefore ? "  OK  " : " FAIL ", test.Name);
+	}
+
+	std::printf("%d test(s), %d failed check(s)\n", numRun, Testing::GetNumFailures());
+	return Testing::GetNumFailures() == 0 && numRun > 0 ? 0 : 1;
+}
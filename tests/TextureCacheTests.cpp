@@ -0,0 +1,227 @@
+#include "TestFramework.h"
+#include "image/TextureCache.h"
+
+#include <map>
+#include <string>
+
+namespace
+{
+	struct FakeTexture
+	{
+		int Id = 0;
+	};
+
+	// Records which textures the cache handed back for release, and when.
+	struct FakeBackend
+	{
+		std::vector<std::pair<int, uint64_t>> Released; // texture and the cache frame it was released in
+
+		TextureCache<FakeTexture>::ReleaseFn MakeReleaseFn(const TextureCache<FakeTexture>& cache)
+		{
+			return [this, &cache](FakeTexture& texture) { Released.push_back({texture.Id, cache.GetFrame()}); };
+		}
+
+		bool WasReleased(int id) const
+		{
+			for (const auto& [released, frame] : Released)
+				if (released == id)
+					return true;
+			return false;
+		}
+	};
+}
+
+TEST(CountsHitsAndMisses)
+{
+	TextureCache<FakeTexture> cache;
+	FakeBackend backend;
+	cache.Initialize(1000, 2, backend.MakeReleaseFn(cache));
+	cache.Insert("a.png", {1}, 100);
+
+	REQUIRE(cache.Find("a.png") != nullptr);
+	CHECK_EQ(cache.Find("a.png")->Id, 1);
+	CHECK(cache.Find("b.png") == nullptr);
+	CHECK(cache.Contains("a.png"));
+	CHECK(!cache.Contains("b.png"));
+	CHECK_EQ(cache.GetStats().Hits, 2u);
+	CHECK_EQ(cache.GetStats().Misses, 1u);
+	CHECK_EQ(cache.GetStats().ResidentBytes, 100u);
+	CHECK_EQ(cache.GetStats().ResidentCount, 1u);
+}
+
+TEST(EvictsLeastRecentlyDrawnOverBudget)
+{
+	TextureCache<FakeTexture> cache;
+	FakeBackend backend;
+	cache.Initialize(300, 2, backend.MakeReleaseFn(cache));
+	cache.Insert("1", {1}, 100);
+	cache.Insert("2", {2}, 100);
+	cache.Insert("3", {3}, 100);
+	cache.EndFrame();
+
+	// 1 and 3 are drawn, so 2 is the least recently drawn when 4 pushes the cache over budget.
+	cache.Find("1");
+	cache.Find("3");
+	cache.EndFrame();
+	cache.Insert("4", {4}, 100);
+	cache.Find("4");
+	cache.EndFrame();
+
+	CHECK(!cache.Contains("2"));
+	CHECK(cache.Contains("1") && cache.Contains("3") && cache.Contains("4"));
+	CHECK_EQ(cache.GetStats().Evictions, 1u);
+	CHECK_EQ(cache.GetStats().ResidentBytes, 300u);
+}
+
+TEST(NeverEvictsWhatThisFrameDraws)
+{
+	TextureCache<FakeTexture> cache;
+	FakeBackend backend;
+	cache.Initialize(150, 1, backend.MakeReleaseFn(cache));
+	cache.Insert("1", {1}, 100);
+	cache.Insert("2", {2}, 100);
+	cache.Find("1");
+	cache.Find("2");
+	cache.EndFrame();
+	// Over budget, but everything was on screen.
+	CHECK(cache.Contains("1") && cache.Contains("2"));
+	CHECK_EQ(cache.GetStats().ResidentBytes, 200u);
+
+	cache.Find("2");
+	cache.EndFrame();
+	CHECK(!cache.Contains("1"));
+	CHECK(cache.Contains("2"));
+}
+
+TEST(DefersReleaseUntilFramesInFlightRetire)
+{
+	const uint32_t framesInFlight = 2;
+	TextureCache<FakeTexture> cache;
+	FakeBackend backend;
+	cache.Initialize(100, framesInFlight, backend.MakeReleaseFn(cache));
+	cache.Insert("old", {1}, 100);
+	cache.Find("old");
+	cache.EndFrame(); // frame 0 drew it
+
+	cache.Insert("new", {2}, 100);
+	cache.Find("new");
+	cache.EndFrame(); // frame 1 evicts "old"
+	CHECK(!cache.Contains("old"));
+	CHECK(!backend.WasReleased(1));
+	CHECK_EQ(cache.GetStats().PendingReleaseBytes, 100u);
+
+	// Frame 1 may still be sampling it until framesInFlight more frames have been submitted.
+	for (uint32_t i = 0; i < framesInFlight; i++)
+	{
+		CHECK(!backend.WasReleased(1));
+		cache.EndFrame();
+	}
+	CHECK(backend.WasReleased(1));
+	CHECK_EQ(cache.GetStats().PendingReleaseBytes, 0u);
+	CHECK(!backend.WasReleased(2));
+}
+
+TEST(ReinsertingAKeyReplacesItsTexture)
+{
+	TextureCache<FakeTexture> cache;
+	FakeBackend backend;
+	cache.Initialize(1000, 1, backend.MakeReleaseFn(cache));
+	cache.Insert("a", {1}, 100);
+	cache.Insert("a", {2}, 300);
+	CHECK_EQ(cache.Find("a")->Id, 2);
+	CHECK_EQ(cache.GetStats().ResidentBytes, 300u);
+	CHECK_EQ(cache.GetStats().ResidentCount, 1u);
+	CHECK_EQ(cache.GetStats().PendingReleaseBytes, 100u);
+}
+
+TEST(BudgetChangesApplyAtTheEndOfTheFrame)
+{
+	TextureCache<FakeTexture> cache;
+	FakeBackend backend;
+	cache.Initialize(1000, 1, backend.MakeReleaseFn(cache));
+	for (int i = 0; i < 10; i++)
+		cache.Insert(std::to_string(i), {i}, 100);
+	cache.EndFrame();
+	cache.SetBudget(350);
+	CHECK_EQ(cache.GetBudget(), 350u);
+	CHECK_EQ(cache.GetStats().ResidentCount, 10u);
+	cache.EndFrame();
+	CHECK_EQ(cache.GetStats().ResidentCount, 3u);
+	// The oldest inserts go first.
+	CHECK(cache.Contains("9") && cache.Contains("8") && cache.Contains("7"));
+}
+
+TEST(ClearReleasesEverythingAtOnce)
+{
+	TextureCache<FakeTexture> cache;
+	FakeBackend backend;
+	cache.Initialize(100, 3, backend.MakeReleaseFn(cache));
+	cache.Insert("a", {1}, 100);
+	cache.Insert("b", {2}, 100);
+	cache.EndFrame();
+	cache.EndFrame(); // "a" is evicted and waits for its frames to retire
+	CHECK_EQ(cache.GetStats().PendingReleaseBytes, 100u);
+	cache.Clear();
+	CHECK(backend.WasReleased(1));
+	CHECK(backend.WasReleased(2));
+	CHECK_EQ(cache.GetStats().ResidentBytes, 0u);
+	CHECK_EQ(cache.GetStats().PendingReleaseBytes, 0u);
+	CHECK_EQ(cache.GetStats().ResidentCount, 0u);
+}
+
+// Random inserts, draws and budget changes: bytes and counts always add up, textures are released exactly
+// once, and never while a frame that drew them may still be in flight.
+TEST(RandomizedAccounting)
+{
+	Testing::Random random(7);
+	const uint32_t framesInFlight = 3;
+	TextureCache<FakeTexture> cache;
+	FakeBackend backend;
+	std::map<int, uint64_t> lastDrawnFrame;
+	std::map<int, uint64_t> sizes;
+	uint64_t insertedBytes = 0;
+	uint64_t releasedBytes = 0;
+	cache.Initialize(5000, framesInFlight, [&](FakeTexture& texture) {
+		backend.Released.push_back({texture.Id, cache.GetFrame()});
+		releasedBytes += sizes[texture.Id];
+		auto drawn = lastDrawnFrame.find(texture.Id);
+		if (drawn != lastDrawnFrame.end())
+			REQUIRE(cache.GetFrame() > drawn->second + framesInFlight);
+	});
+
+	int nextId = 1;
+	for (int frame = 0; frame < 2000; frame++)
+	{
+		for (int op = 0; op < 5; op++)
+		{
+			std::string key = std::to_string(random.Below(60));
+			if (random.Below(3) == 0)
+			{
+				uint64_t size = 100 + random.Below(900);
+				cache.Insert(key, {nextId}, size);
+				sizes[nextId] = size;
+				insertedBytes += size;
+				nextId++;
+			}
+			if (FakeTexture* texture = cache.Find(key))
+				lastDrawnFrame[texture->Id] = cache.GetFrame();
+		}
+		if (random.Below(50) == 0)
+			cache.SetBudget(1000 + random.Below(8000));
+		cache.EndFrame();
+
+		const TextureCacheStats& stats = cache.GetStats();
+		REQUIRE_EQ(stats.KeyCount, stats.ResidentCount); // nothing shared here
+		REQUIRE_EQ(stats.ResidentBytes + stats.PendingReleaseBytes + releasedBytes, insertedBytes);
+	}
+	lastDrawnFrame.clear(); // Clear is for an idle GPU
+	cache.Clear();
+
+	// Every texture inserted was released once.
+	std::map<int, int> releases;
+	for (const auto& [id, frame] : backend.Released)
+		releases[id]++;
+	CHECK_EQ(releases.size(), static_cast<size_t>(nextId - 1));
+	for (const auto& [id, count] : releases)
+		CHECK_EQ(count, 1);
+}
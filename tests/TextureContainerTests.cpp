@@ -0,0 +1,270 @@
+#include "TestFramework.h"
+#include "image/ImageDecoder.h"
+#include "image/TextureContainer.h"
+#include "support/TestImages.h"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	const TextureFormat BLOCK_FORMATS[] = {TextureFormat::Bc1, TextureFormat::Bc3, TextureFormat::Bc5,
+	                                       TextureFormat::Bc7};
+
+	void WriteUint32(std::vector<unsigned char>& file, size_t offset, uint32_t value)
+	{
+		for (int i = 0; i < 4; i++)
+			file[offset + i] = static_cast<unsigned char>(value >> (i * 8));
+	}
+
+	bool ReadInfo(const std::vector<unsigned char>& file, TextureContainerInfo* out_info)
+	{
+		return TextureContainer::ReadInfo(file.data(), file.size(), out_info);
+	}
+
+	// Every level is where MakeDds and MakeKtx2 put it: the same random blocks for the same seed.
+	void CheckLevels(const std::vector<unsigned char>& file, const TextureContainerInfo& info, uint64_t seed)
+	{
+		for (int level = 0; level < info.MipLevels; level++)
+		{
+			const TextureContainerLevel& entry = info.Levels[level];
+			REQUIRE(entry.Offset + entry.Size <= file.size());
+			std::vector<unsigned char> expected = TestImages::MakeNoise(entry.Size, seed + level);
+			CHECK(std::memcmp(file.data() + entry.Offset, expected.data(), entry.Size) == 0);
+		}
+	}
+}
+
+// Copy footprints count rows of blocks, and a level smaller than a block still takes a whole one.
+TEST(FootprintsCountWholeBlocks)
+{
+	CHECK_EQ(TextureFormats::GetRowPitch(TextureFormat::Rgba8, 13), 52u);
+	CHECK_EQ(TextureFormats::GetNumRows(TextureFormat::Rgba8, 13), 13);
+	CHECK_EQ(TextureFormats::GetLevelSize(TextureFormat::Rgba8, 3, 2), 24u);
+	CHECK(!TextureFormats::IsBlockCompressed(TextureFormat::Rgba8));
+
+	for (TextureFormat format : BLOCK_FORMATS)
+	{
+		size_t blockSize = format == TextureFormat::Bc1 ? 8 : 16;
+		CHECK(TextureFormats::IsBlockCompressed(format));
+		CHECK_EQ(static_cast<size_t>(TextureFormats::GetElementSize(format)), blockSize);
+		CHECK_EQ(TextureFormats::GetRowPitch(format, 256), 64 * blockSize);
+		CHECK_EQ(TextureFormats::GetRowPitch(format, 6), 2 * blockSize);
+		CHECK_EQ(TextureFormats::GetNumRows(format, 256), 64);
+		CHECK_EQ(TextureFormats::GetNumRows(format, 2), 1);
+		CHECK_EQ(TextureFormats::GetLevelSize(format, 1, 1), blockSize);
+		CHECK_EQ(TextureFormats::GetLevelSize(format, 4096, 4096), 1024 * 1024 * blockSize);
+	}
+	// A 4K image: 64 MB as RGBA8, 16 MB as BC7, 8 MB as BC1.
+	CHECK_EQ(TextureFormats::GetLevelSize(TextureFormat::Rgba8, 4096, 4096), 64u << 20);
+	CHECK_EQ(TextureFormats::GetLevelSize(TextureFormat::Bc7, 4096, 4096), 16u << 20);
+	CHECK_EQ(TextureFormats::GetLevelSize(TextureFormat::Bc1, 4096, 4096), 8u << 20);
+}
+
+TEST(ReadsDdsFiles)
+{
+	for (TextureFormat format : BLOCK_FORMATS)
+	{
+		for (bool legacyHeader : {false, true})
+		{
+			if (legacyHeader && format == TextureFormat::Bc7)
+				continue; // BC7 has no FourCC
+			std::vector<unsigned char> file = TestImages::MakeDds(format, 256, 64, 9, 1, legacyHeader);
+			CHECK(TextureContainer::IsContainer(file.data(), file.size()));
+			TextureContainerInfo info;
+			REQUIRE(ReadInfo(file, &info));
+			CHECK(info.Format == format);
+			CHECK_EQ(info.Width, 256);
+			CHECK_EQ(info.Height, 64);
+			REQUIRE_EQ(info.MipLevels, 9);
+			CHECK_EQ(info.Levels[0].Offset, legacyHeader ? 128u : 148u);
+			CHECK_EQ(info.Levels[8].Width, 1);
+			CHECK_EQ(info.Levels[8].Height, 1);
+			CHECK_EQ(info.Levels[6].Width, 4);
+			CHECK_EQ(info.Levels[6].Height, 1);
+			for (int level = 0; level < info.MipLevels; level++)
+			{
+				const TextureContainerLevel& entry = info.Levels[level];
+				CHECK_EQ(entry.Size, TextureFormats::GetLevelSize(format, entry.Width, entry.Height));
+			}
+			CHECK_EQ(info.Levels[8].Offset + info.Levels[8].Size, file.size());
+			CheckLevels(file, info, 1);
+		}
+	}
+}
+
+TEST(ReadsKtx2Files)
+{
+	for (TextureFormat format : BLOCK_FORMATS)
+	{
+		std::vector<unsigned char> file = TestImages::MakeKtx2(format, 128, 512, 10, 2);
+		CHECK(TextureContainer::IsContainer(file.data(), file.size()));
+		TextureContainerInfo info;
+		REQUIRE(ReadInfo(file, &info));
+		CHECK(info.Format == format);
+		CHECK_EQ(info.Width, 128);
+		CHECK_EQ(info.Height, 512);
+		REQUIRE_EQ(info.MipLevels, 10);
+		CHECK_EQ(info.Levels[9].Width, 1);
+		CHECK_EQ(info.Levels[9].Height, 1);
+		CHECK(info.Levels[0].Offset > info.Levels[9].Offset); // stored smallest first
+		CheckLevels(file, info, 2);
+	}
+
+	// levelCount 0 asks for a generated chain; only the base level is in the file.
+	std::vector<unsigned char> file = TestImages::MakeKtx2(TextureFormat::Bc7, 64, 64, 1, 3);
+	WriteUint32(file, 40, 0);
+	TextureContainerInfo info;
+	REQUIRE(ReadInfo(file, &info));
+	CHECK_EQ(info.MipLevels, 1);
+}
+
+// A chain longer than the image allows ends at 1x1; a DDS file cut short keeps the levels it still has.
+TEST(ChainsAreCutToWhatExists)
+{
+	std::vector<unsigned char> file = TestImages::MakeDds(TextureFormat::Bc1, 16, 8, 5, 4);
+	WriteUint32(file, 4 + 24, 12);
+	TextureContainerInfo info;
+	REQUIRE(ReadInfo(file, &info));
+	CHECK_EQ(info.MipLevels, 5);
+
+	file = TestImages::MakeDds(TextureFormat::Bc7, 64, 64, 7, 5);
+	REQUIRE(ReadInfo(file, &info));
+	size_t level3End = info.Levels[3].Offset + info.Levels[3].Size;
+	std::vector<unsigned char> truncated(file.begin(), file.begin() + level3End + 10);
+	REQUIRE(ReadInfo(truncated, &info));
+	CHECK_EQ(info.MipLevels, 4);
+
+	truncated.resize(info.Levels[0].Offset + info.Levels[0].Size - 1);
+	CHECK(!ReadInfo(truncated, &info));
+
+	// KTX2 files list every level, so one that is missing is an error.
+	file = TestImages::MakeKtx2(TextureFormat::Bc3, 64, 64, 7, 6);
+	truncated.assign(file.begin(), file.end() - 1);
+	CHECK(!ReadInfo(truncated, &info));
+}
+
+TEST(RejectsWhatD3D12OrTheReaderCannotUse)
+{
+	TextureContainerInfo info;
+	CHECK(!TextureContainer::IsContainer(nullptr, 0));
+	// Not a multiple of 4, or larger than D3D12 allows.
+	CHECK(!ReadInfo(TestImages::MakeDds(TextureFormat::Bc1, 30, 32, 1, 7), &info));
+	CHECK(!ReadInfo(TestImages::MakeKtx2(TextureFormat::Bc1, 32, 6, 1, 7), &info));
+	std::vector<unsigned char> huge = TestImages::MakeDds(TextureFormat::Bc1, 4, 4, 1, 7);
+	WriteUint32(huge, 4 + 12, 32768);
+	CHECK(!ReadInfo(huge, &info));
+
+	std::vector<unsigned char> dds = TestImages::MakeDds(TextureFormat::Bc7, 32, 32, 1, 8);
+	auto rejectsDds = [&](size_t offset, uint32_t value) {
+		std::vector<unsigned char> file = dds;
+		WriteUint32(file, offset, value);
+		return !ReadInfo(file, &info);
+	};
+	CHECK(rejectsDds(4 + 108, 0x200)); // cube map
+	CHECK(rejectsDds(4 + 108, 0x200000)); // volume
+	CHECK(rejectsDds(4 + 76, 0x40)); // uncompressed RGB
+	CHECK(rejectsDds(4 + 80, 0x31495844)); // an unknown FourCC
+	CHECK(rejectsDds(128, 28)); // DX10 header: R8G8B8A8_UNORM
+	CHECK(rejectsDds(128 + 4, 4)); // a volume dimension
+	CHECK(rejectsDds(128 + 8, 0x4)); // cube
+	CHECK(rejectsDds(128 + 12, 6)); // array
+	CHECK(rejectsDds(4, 100)); // header size
+
+	std::vector<unsigned char> ktx2 = TestImages::MakeKtx2(TextureFormat::Bc7, 32, 32, 1, 9);
+	auto rejectsKtx2 = [&](size_t offset, uint32_t value) {
+		std::vector<unsigned char> file = ktx2;
+		WriteUint32(file, offset, value);
+		return !ReadInfo(file, &info);
+	};
+	CHECK(rejectsKtx2(12, 37)); // VK_FORMAT_R8G8B8A8_UNORM
+	CHECK(rejectsKtx2(28, 1)); // depth
+	CHECK(rejectsKtx2(32, 2)); // layers
+	CHECK(rejectsKtx2(36, 6)); // faces
+	CHECK(rejectsKtx2(44, 2)); // Zstandard supercompression
+	CHECK(rejectsKtx2(40, 33)); // more levels than any file has
+	CHECK(rejectsKtx2(80 + 8, 17)); // level length disagrees with the format
+
+	// Every truncated header fails.
+	for (const std::vector<unsigned char>* file : {&dds, &ktx2})
+		for (size_t size = 0; size < 148; size++)
+			CHECK(!TextureContainer::ReadInfo(file->data(), size, &info));
+}
+
+// Random damage to the headers: whatever ReadInfo accepts stays inside the file and has consistent levels.
+TEST(RandomizedHeadersStayInBounds)
+{
+	Testing::Random random(17);
+	for (int trial = 0; trial < 20000; trial++)
+	{
+		TextureFormat format = BLOCK_FORMATS[random.Below(4)];
+		int width = 4 << random.Below(6);
+		int height = 4 << random.Below(6);
+		std::vector<unsigned char> file = random.Below(2) == 0
+			? TestImages::MakeDds(format, width, height, 1 + static_cast<int>(random.Below(8)), trial)
+			: TestImages::MakeKtx2(format, width, height, 1 + static_cast<int>(random.Below(8)), trial);
+		int numChanges = 1 + static_cast<int>(random.Below(3));
+		uint32_t headerSize = static_cast<uint32_t>(file.size() < 160 ? file.size() : 160);
+		for (int change = 0; change < numChanges; change++)
+		{
+			size_t offset = random.Below(headerSize);
+			if (random.Below(2) == 0)
+				file[offset] ^= static_cast<unsigned char>(1 + random.Below(255));
+			else
+				WriteUint32(file, offset & ~size_t(3), random.Below(64));
+		}
+		if (random.Below(4) == 0)
+			file.resize(random.Below(static_cast<uint32_t>(file.size())));
+
+		TextureContainerInfo info;
+		if (!ReadInfo(file, &info))
+			continue;
+		REQUIRE(info.MipLevels >= 1 && info.MipLevels <= APP_MAX_TEXTURE_MIP_LEVELS);
+		REQUIRE(info.Width % 4 == 0 && info.Height % 4 == 0);
+		for (int level = 0; level < info.MipLevels; level++)
+		{
+			const TextureContainerLevel& entry = info.Levels[level];
+			REQUIRE(entry.Offset <= file.size() && entry.Size <= file.size() - entry.Offset);
+			REQUIRE_EQ(entry.Size, TextureFormats::GetLevelSize(info.Format, entry.Width, entry.Height));
+		}
+	}
+}
+
+// ImageDecoder hands the blocks over as they are, starting at the first level small enough for the display.
+TEST(DecodingPassesBlocksThrough)
+{
+	for (bool ktx2 : {false, true})
+	{
+		std::vector<unsigned char> file = ktx2 ? TestImages::MakeKtx2(TextureFormat::Bc7, 1024, 512, 11, 10)
+		                                       : TestImages::MakeDds(TextureFormat::Bc7, 1024, 512, 11, 10);
+		TextureContainerInfo info;
+		REQUIRE(ReadInfo(file, &info));
+
+		DecodedImage image;
+		REQUIRE(ImageDecoder::DecodeMemory(file.data(), file.size(), image));
+		CHECK(image.Format == TextureFormat::Bc7);
+		CHECK_EQ(image.Width, 1024);
+		CHECK_EQ(image.MipLevels, 11);
+		CHECK(std::memcmp(image.Pixels, file.data() + info.Levels[0].Offset, info.Levels[0].Size) == 0);
+		size_t mipOffset = 0;
+		for (int level = 1; level < info.MipLevels; level++)
+		{
+			const TextureContainerLevel& entry = info.Levels[level];
+			REQUIRE(mipOffset + entry.Size <= image.MipData.size());
+			CHECK(std::memcmp(image.MipData.data() + mipOffset, file.data() + entry.Offset, entry.Size) == 0);
+			mipOffset += entry.Size;
+		}
+		CHECK_EQ(mipOffset, image.MipData.size());
+
+		// Two levels are skipped for a 256-pixel preview; levels that are no longer whole blocks are not.
+		REQUIRE(ImageDecoder::DecodeMemory(file.data(), file.size(), image, 256));
+		CHECK_EQ(image.Width, 256);
+		CHECK_EQ(image.Height, 128);
+		CHECK_EQ(image.SourceWidth, 1024);
+		CHECK_EQ(image.MipLevels, 9);
+		CHECK(std::memcmp(image.Pixels, file.data() + info.Levels[2].Offset, info.Levels[2].Size) == 0);
+		REQUIRE(ImageDecoder::DecodeMemory(file.data(), file.size(), image, 1));
+		CHECK_EQ(image.Width, 8);
+		CHECK_EQ(image.Height, 4);
+	}
+}
@@ -0,0 +1,216 @@
+#include "TestFramework.h"
+#include "core/ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Counts how often each of a fixed number of tasks ran.
+	struct RunCounts
+	{
+		explicit RunCounts(size_t count) : Counts(count) {}
+
+		bool AllRanOnce() const
+		{
+			for (const std::atomic<int>& count : Counts)
+				if (count.load() != 1)
+					return false;
+			return true;
+		}
+
+		std::vector<std::atomic<int>> Counts;
+	};
+
+	// Submits a binary tree of tasks from the workers themselves, depth levels deep.
+	void SubmitTree(ThreadPool& pool, std::atomic<int>& numRun, int depth)
+	{
+		numRun++;
+		if (depth == 0)
+			return;
+		for (int child = 0; child < 2; child++)
+			pool.Submit([&pool, &numRun, depth] { SubmitTree(pool, numRun, depth - 1); });
+	}
+}
+
+TEST(RunsEveryTaskOnceFromManyProducers)
+{
+	const int numProducers = 4;
+	const int tasksPerProducer = 20000;
+	ThreadPool pool;
+	pool.Start(4);
+	RunCounts runs(numProducers * tasksPerProducer);
+
+	std::vector<std::thread> producers;
+	for (int producer = 0; producer < numProducers; producer++)
+	{
+		producers.emplace_back([&, producer] {
+			for (int i = 0; i < tasksPerProducer; i++)
+				pool.Submit([&runs, index = producer * tasksPerProducer + i] { runs.Counts[index]++; });
+		});
+	}
+	for (std::thread& producer : producers)
+		producer.join();
+	pool.WaitIdle();
+	CHECK(runs.AllRanOnce());
+}
+
+TEST(TasksSubmittedFromWorkersRunBeforeIdle)
+{
+	ThreadPool pool;
+	pool.Start(3);
+	std::atomic<int> numRun = 0;
+	const int depth = 14;
+	pool.Submit([&] { SubmitTree(pool, numRun, depth); });
+	pool.WaitIdle();
+	CHECK_EQ(numRun.load(), (1 << (depth + 1)) - 1);
+}
+
+TEST(ReportsWorkerIndices)
+{
+	ThreadPool pool;
+	pool.Start(4);
+	CHECK_EQ(pool.GetNumThreads(), 4);
+	CHECK_EQ(pool.GetCurrentWorkerIndex(), -1);
+
+	ThreadPool other;
+	other.Start(1);
+	std::atomic<bool> inRange = true;
+	for (int i = 0; i < 1000; i++)
+	{
+		pool.Submit([&] {
+			int index = pool.GetCurrentWorkerIndex();
+			if (index < 0 || index >= 4 || other.GetCurrentWorkerIndex() != -1)
+				inRange = false;
+		});
+	}
+	pool.WaitIdle();
+	CHECK(inRange.load());
+}
+
+TEST(IdleWorkersStealFromBusyOnes)
+{
+	ThreadPool pool;
+	pool.Start(4);
+	std::atomic<int> numRun = 0;
+	// Everything lands in one worker's deque; the others only get work by stealing it.
+	pool.Submit([&] {
+		for (int i = 0; i < 64; i++)
+		{
+			pool.Submit([&] {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				numRun++;
+			});
+		}
+	});
+	pool.WaitIdle();
+	CHECK_EQ(numRun.load(), 64);
+	CHECK(pool.GetNumSteals() > 0);
+}
+
+TEST(ParallelForCoversEveryIndexOnce)
+{
+	ThreadPool pool;
+	pool.Start(4);
+	for (int count : {0, 1, 2, 3, 5, 64, 1000, 100000})
+	{
+		RunCounts runs(count);
+		pool.ParallelFor(count, [&](int i) { runs.Counts[i]++; });
+		CHECK(runs.AllRanOnce());
+	}
+
+	// Without workers the caller runs the loop itself.
+	ThreadPool stopped;
+	RunCounts runs(100);
+	stopped.ParallelFor(100, [&](int i) { runs.Counts[i]++; });
+	CHECK(runs.AllRanOnce());
+}
+
+// Loops started from inside tasks and inside other loops, with every worker busy, still finish.
+TEST(NestedParallelForDoesNotDeadlock)
+{
+	ThreadPool pool;
+	pool.Start(3);
+	const int outer = 16;
+	const int inner = 200;
+	RunCounts runs(outer * inner * 4);
+	for (int task = 0; task < 4; task++)
+	{
+		pool.Submit([&, task] {
+			pool.ParallelFor(outer, [&](int i) {
+				pool.ParallelFor(inner, [&](int j) { runs.Counts[(task * outer + i) * inner + j]++; });
+			});
+		});
+	}
+	pool.WaitIdle();
+	CHECK(runs.AllRanOnce());
+}
+
+TEST(ShutdownRunsQueuedTasksAndCanRestart)
+{
+	ThreadPool pool;
+	pool.Submit([] {}); // not started: ignored
+	pool.WaitIdle();
+
+	pool.Start(2);
+	std::atomic<int> numRun = 0;
+	for (int i = 0; i < 1000; i++)
+	{
+		pool.Submit([&] {
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			numRun++;
+		});
+	}
+	pool.Shutdown();
+	CHECK_EQ(numRun.load(), 1000);
+	CHECK_EQ(pool.GetNumThreads(), 0);
+	pool.Submit([&] { numRun++; }); // stopped: ignored
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	CHECK_EQ(numRun.load(), 1000);
+
+	pool.Start(2);
+	RunCounts runs(500);
+	for (int i = 0; i < 500; i++)
+		pool.Submit([&runs, i] { runs.Counts[i]++; });
+	pool.WaitIdle();
+	CHECK(runs.AllRanOnce());
+}
+
+// Random mixes of outside submissions, worker submissions and parallel loops on pools of random sizes, each
+// followed by WaitIdle: every piece of work runs exactly once and WaitIdle never returns early.
+TEST(RandomizedStress)
+{
+	for (uint64_t seed = 1; seed <= 6; seed++)
+	{
+		Testing::Random random(seed);
+		ThreadPool pool;
+		pool.Start(1 + static_cast<int>(random.Below(6)));
+		for (int round = 0; round < 20; round++)
+		{
+			int numTasks = static_cast<int>(random.Below(2000));
+			int numChildren = static_cast<int>(random.Below(4));
+			int loopSize = static_cast<int>(random.Below(300));
+			auto runs = std::make_shared<RunCounts>(static_cast<size_t>(numTasks) * (1 + numChildren + loopSize));
+
+			for (int task = 0; task < numTasks; task++)
+			{
+				pool.Submit([&pool, runs, task, numChildren, loopSize] {
+					size_t base = static_cast<size_t>(task) * (1 + numChildren + loopSize);
+					runs->Counts[base]++;
+					for (int child = 1; child <= numChildren; child++)
+						pool.Submit([runs, index = base + child] { runs->Counts[index]++; });
+					if (loopSize > 0 && task % 16 == 0)
+						pool.ParallelFor(loopSize, [&](int i) { runs->Counts[base + 1 + numChildren + i]++; });
+					else
+						for (int i = 0; i < loopSize; i++)
+							runs->Counts[base + 1 + numChildren + i]++;
+				});
+			}
+			pool.WaitIdle();
+			REQUIRE(runs->AllRanOnce());
+		}
+	}
+}
@@ -0,0 +1,192 @@
+#include "TestFramework.h"
+#include "TestImages.h"
+#include "image/DiskTextureCache.h"
+#include "image/MipGenerator.h"
+#include "image/TilePyramid.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace
+{
+	DecodedImage MakeImage(const std::vector<unsigned char>& rgba, int width, int height)
+	{
+		DecodedImage image;
+		image.Width = width;
+		image.Height = height;
+		image.SourceWidth = width;
+		image.SourceHeight = height;
+		image.Pixels = ImageDecoder::AllocatePixels(rgba.size());
+		std::memcpy(image.Pixels, rgba.data(), rgba.size());
+		return image;
+	}
+
+	// Levels 0..numLevels-1 by repeated DownsampleBoxReference, tightly packed.
+	std::vector<std::vector<unsigned char>> MakeLevels(const std::vector<unsigned char>& rgba,
+	                                                  const TileLayout& layout)
+	{
+		std::vector<std::vector<unsigned char>> levels = {rgba};
+		for (int level = 1; level < layout.NumLevels; level++)
+		{
+			int srcWidth = layout.GetLevelWidth(level - 1);
+			int width = layout.GetLevelWidth(level);
+			levels.emplace_back(static_cast<size_t>(width) * layout.GetLevelHeight(level) * 4);
+			MipGenerator::DownsampleBoxReference(levels[level - 1].data(), srcWidth, layout.GetLevelHeight(level - 1),
+			                                     static_cast<size_t>(srcWidth) * 4, levels[level].data(),
+			                                     static_cast<size_t>(width) * 4);
+		}
+		return levels;
+	}
+
+	// Every tile of every level, border included, against the texels it should show, clamped at the edges.
+	// The slot rows are padded, and the padding must survive.
+	void CheckTiles(const TilePyramid& pyramid, const std::vector<std::vector<unsigned char>>& levels)
+	{
+		const TileLayout& layout = pyramid.GetLayout();
+		const size_t rowPitch = APP_TILE_SLOT_SIZE * 4 + 20;
+		std::vector<unsigned char> slot(rowPitch * APP_TILE_SLOT_SIZE);
+		for (int level = 0; level < layout.NumLevels; level++)
+		{
+			int width = layout.GetLevelWidth(level);
+			int height = layout.GetLevelHeight(level);
+			for (int tileY = 0; tileY < layout.GetTilesY(level); tileY++)
+			{
+				for (int tileX = 0; tileX < layout.GetTilesX(level); tileX++)
+				{
+					std::fill(slot.begin(), slot.end(), 0xcd);
+					pyramid.CopyTile({level, tileX, tileY}, slot.data(), rowPitch);
+					for (int row = 0; row < APP_TILE_SLOT_SIZE; row++)
+					{
+						int y = std::clamp(tileY * APP_TILE_SIZE - APP_TILE_BORDER + row, 0, height - 1);
+						for (int column = 0; column < APP_TILE_SLOT_SIZE; column++)
+						{
+							int x = std::clamp(tileX * APP_TILE_SIZE - APP_TILE_BORDER + column, 0, width - 1);
+							const unsigned char* expected = &levels[level][(static_cast<size_t>(y) * width + x) * 4];
+							REQUIRE(std::memcmp(&slot[row * rowPitch + column * 4], expected, 4) == 0);
+						}
+						for (size_t i = APP_TILE_SLOT_SIZE * 4; i < rowPitch; i++)
+							REQUIRE_EQ(slot[row * rowPitch + i], 0xcd);
+					}
+				}
+			}
+		}
+	}
+}
+
+// Levels halve as MipGenerator sizes them and stop at the first that fits in one tile; tiles cover each
+// level exactly, the last row and column partial.
+TEST(LayoutCoversEveryLevel)
+{
+	CHECK_EQ(TileLayout::Make(1, 1).NumLevels, 1);
+	CHECK_EQ(TileLayout::Make(APP_TILE_SIZE, APP_TILE_SIZE).NumLevels, 1);
+	CHECK_EQ(TileLayout::Make(APP_TILE_SIZE + 1, 10).NumLevels, 2);
+	CHECK_EQ(TileLayout::Make(65536, 300).NumLevels, 9);
+
+	Testing::Random random(21);
+	for (int trial = 0; trial < 2000; trial++)
+	{
+		int width = random.Range(1, 100000);
+		int height = random.Range(1, trial % 2 ? 2000 : 100000);
+		TileLayout layout = TileLayout::Make(width, height);
+		REQUIRE(layout.NumLevels >= 1);
+		REQUIRE(layout.NumLevels <= MipGenerator::GetMipLevelCount(width, height));
+		int last = layout.NumLevels - 1;
+		CHECK(layout.GetLevelWidth(last) <= APP_TILE_SIZE && layout.GetLevelHeight(last) <= APP_TILE_SIZE);
+		if (last > 0)
+		{
+			bool fitsOneTile = layout.GetLevelWidth(last - 1) <= APP_TILE_SIZE &&
+				layout.GetLevelHeight(last - 1) <= APP_TILE_SIZE;
+			CHECK(!fitsOneTile);
+		}
+
+		int level = static_cast<int>(random.Below(static_cast<uint32_t>(layout.NumLevels)));
+		// std::max returns a reference, which must not outlive the expression.
+		int expectedWidth = std::max(1, width >> level);
+		int expectedHeight = std::max(1, height >> level);
+		CHECK_EQ(layout.GetLevelWidth(level), expectedWidth);
+		CHECK_EQ(layout.GetLevelHeight(level), expectedHeight);
+		int sumWidth = 0;
+		for (int x = 0; x < layout.GetTilesX(level); x++)
+		{
+			int tileWidth = layout.GetTileWidth({level, x, 0});
+			CHECK(tileWidth > 0 && tileWidth <= APP_TILE_SIZE);
+			sumWidth += tileWidth;
+		}
+		CHECK_EQ(sumWidth, layout.GetLevelWidth(level));
+		int lastY = layout.GetTilesY(level) - 1;
+		CHECK_EQ(lastY * APP_TILE_SIZE + layout.GetTileHeight({level, 0, lastY}), layout.GetLevelHeight(level));
+	}
+}
+
+TEST(TilesMatchTheMipChain)
+{
+	for (auto [width, height] : {std::pair{700, 300}, {256, 256}, {1030, 77}, {3, 900}})
+	{
+		std::vector<unsigned char> rgba = TestImages::MakePhoto(width, height, 4, width + height);
+		TilePyramid pyramid;
+		REQUIRE(pyramid.Build(MakeImage(rgba, width, height)));
+		const TileLayout& layout = pyramid.GetLayout();
+		CHECK_EQ(layout.Width, width);
+		CHECK_EQ(layout.Height, height);
+		CHECK_EQ(pyramid.GetSourceWidth(), width);
+
+		uint64_t expectedSize = 0;
+		for (int level = 0; level < layout.NumLevels; level++)
+			expectedSize += static_cast<uint64_t>(layout.GetLevelWidth(level)) * layout.GetLevelHeight(level) * 4;
+		CHECK_EQ(pyramid.GetSizeInBytes(), expectedSize);
+		CheckTiles(pyramid, MakeLevels(rgba, layout));
+	}
+}
+
+// A chain that stops short of the single-tile level is rebuilt; block-compressed images are refused.
+TEST(ShortChainsAreRebuilt)
+{
+	const int width = 1100;
+	const int height = 600;
+	std::vector<unsigned char> rgba = TestImages::MakePhoto(width, height, 4, 1);
+	DecodedImage image = MakeImage(rgba, width, height);
+	image.MipLevels = 2;
+	image.MipData.assign(static_cast<size_t>(width / 2) * (height / 2) * 4, 0); // not what the chain holds
+	TilePyramid pyramid;
+	REQUIRE(pyramid.Build(std::move(image)));
+	CHECK(image.Pixels == nullptr);
+	CheckTiles(pyramid, MakeLevels(rgba, pyramid.GetLayout()));
+
+	DecodedImage compressed;
+	compressed.Format = TextureFormat::Bc1;
+	compressed.Width = 1024;
+	compressed.Height = 1024;
+	compressed.Pixels = ImageDecoder::AllocatePixels(compressed.GetSizeInBytes());
+	TilePyramid refused;
+	CHECK(!refused.Build(std::move(compressed)));
+	CHECK(compressed.Pixels != nullptr);
+	CHECK(!refused.Build(DecodedImage()));
+}
+
+// From a disk cache entry the levels are read in place, at the cache's padded row pitch.
+TEST(CachedImagesAreReadInPlace)
+{
+	const int width = 900;
+	const int height = 333;
+	std::vector<unsigned char> rgba = TestImages::MakePhoto(width, height, 4, 2);
+	DecodedImage image = MakeImage(rgba, width, height);
+	REQUIRE(MipGenerator::GenerateMipChain(image));
+
+	TestImages::TempDirectory directory("tile-pyramid");
+	TestImages::WriteFile(directory / "source.png", {1, 2, 3});
+	DiskTextureCache cache;
+	REQUIRE(cache.Open(directory / "cache"));
+	DiskCacheKey key;
+	REQUIRE(DiskTextureCache::MakeKey(directory / "source.png", 0, {}, &key));
+	REQUIRE(cache.Store(key, image));
+	DecodedImage cached;
+	REQUIRE(cache.Load(key, cached));
+
+	TilePyramid pyramid;
+	REQUIRE(pyramid.Build(std::move(cached)));
+	CHECK(pyramid.GetLevelRowPitch(0) % APP_DISK_CACHE_ROW_PITCH_ALIGNMENT == 0);
+	CHECK(pyramid.GetLevelRowPitch(0) > static_cast<size_t>(width) * 4);
+	CheckTiles(pyramid, MakeLevels(rgba, pyramid.GetLayout()));
+}
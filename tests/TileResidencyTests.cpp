@@ -0,0 +1,238 @@
+#include "TestFramework.h"
+#include "image/TileResidency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+namespace
+{
+	// Tile rectangle in level 0 texels, as the draws stretch it.
+	void GetTileRect(const TileLayout& layout, const TileId& tile, float* out_rect)
+	{
+		float width = APP_TILE_SIZE * layout.GetScaleX(tile.Level);
+		float height = APP_TILE_SIZE * layout.GetScaleY(tile.Level);
+		out_rect[0] = tile.X * width;
+		out_rect[1] = tile.Y * height;
+		out_rect[2] = std::min(static_cast<float>(layout.Width), out_rect[0] + width);
+		out_rect[3] = std::min(static_cast<float>(layout.Height), out_rect[1] + height);
+	}
+
+	TileView MakeView(float x0, float y0, float x1, float y1, float screenWidth, float screenHeight)
+	{
+		return TileView{x0, y0, x1, y1, screenWidth, screenHeight};
+	}
+
+	// A view of a random part of the image at a random zoom, sometimes hanging over its edges.
+	TileView MakeRandomView(const TileLayout& layout, Testing::Random& random)
+	{
+		float zoom = std::pow(2.0f, -static_cast<float>(random.Below(1200)) / 100.0f);
+		float width = static_cast<float>(layout.Width) * zoom;
+		float height = width * (0.5f + random.Below(100) / 100.0f);
+		float x0 = static_cast<float>(random.Range(-200, layout.Width)) - width * 0.25f;
+		float y0 = static_cast<float>(random.Range(-200, layout.Height)) - height * 0.25f;
+		float screenWidth = static_cast<float>(random.Range(64, 1920));
+		return MakeView(x0, y0, x0 + width, y0 + height, screenWidth, screenWidth * height / width);
+	}
+}
+
+TEST(SelectsTheLevelNearestOneTexelPerPixel)
+{
+	TileResidency residency;
+	TileLayout layout = TileLayout::Make(65536, 32768);
+	residency.Initialize(layout, 64, 2);
+	CHECK_EQ(residency.SelectLevel(MakeView(0, 0, 1000, 500, 1000, 500)), 0);
+	CHECK_EQ(residency.SelectLevel(MakeView(0, 0, 1000, 500, 4000, 2000)), 0); // magnified
+	CHECK_EQ(residency.SelectLevel(MakeView(0, 0, 4000, 2000, 1000, 500)), 2);
+	CHECK_EQ(residency.SelectLevel(MakeView(0, 0, 4000, 2000, 1000, 2000)), 2); // the denser axis decides
+	CHECK_EQ(residency.SelectLevel(MakeView(0, 0, 65536, 32768, 100, 50)), layout.NumLevels - 1);
+	CHECK_EQ(residency.SelectLevel(MakeView(0, 0, 1000, 500, 0, 0)), layout.NumLevels - 1);
+
+	// Switches level at sqrt(2) of the texel density, halfway in log2 between two levels.
+	CHECK_EQ(residency.SelectLevel(MakeView(0, 0, 1390, 100, 1000, 100)), 0);
+	CHECK_EQ(residency.SelectLevel(MakeView(0, 0, 1440, 100, 1000, 100)), 1);
+	CHECK_EQ(residency.SelectLevel(MakeView(0, 0, 2800, 100, 1000, 100)), 1);
+	CHECK_EQ(residency.SelectLevel(MakeView(0, 0, 2860, 100, 1000, 100)), 2);
+}
+
+// Against a brute-force intersection of the view with every tile rectangle.
+TEST(VisibleTilesAreThoseTheViewTouches)
+{
+	Testing::Random random(22);
+	for (int trial = 0; trial < 300; trial++)
+	{
+		TileLayout layout = TileLayout::Make(random.Range(1, 40000), random.Range(1, 40000));
+		TileResidency residency;
+		residency.Initialize(layout, 16, 2);
+		TileView view = MakeRandomView(layout, random);
+		int level = static_cast<int>(random.Below(static_cast<uint32_t>(layout.NumLevels)));
+
+		int x0, y0, x1, y1;
+		residency.GetVisibleTiles(view, level, x0, y0, x1, y1);
+		for (int y = 0; y < layout.GetTilesY(level); y++)
+		{
+			for (int x = 0; x < layout.GetTilesX(level); x++)
+			{
+				float rect[4];
+				GetTileRect(layout, {level, x, y}, rect);
+				// Strictly inside, so that float rounding on the tile edges does not matter.
+				bool overlaps = rect[0] + 0.01f < view.X1 && view.X0 + 0.01f < rect[2] && rect[1] + 0.01f < view.Y1 &&
+					view.Y0 + 0.01f < rect[3];
+				bool listed = x >= x0 && x <= x1 && y >= y0 && y <= y1;
+				if (overlaps)
+					REQUIRE(listed);
+				bool clearlyOutside = rect[0] > view.X1 + 1.0f || view.X0 > rect[2] + 1.0f ||
+					rect[1] > view.Y1 + 1.0f || view.Y0 > rect[3] + 1.0f;
+				if (clearlyOutside)
+					REQUIRE(!listed);
+			}
+		}
+	}
+}
+
+// The coarsest tile comes first, then the wanted tiles nearest the centre of the view.
+TEST(RequestsCoarsestThenNearestTheCentre)
+{
+	TileLayout layout = TileLayout::Make(4096, 4096);
+	TileResidency residency;
+	residency.Initialize(layout, 64, 2);
+	residency.Update(MakeView(1024, 1024, 2048, 2048, 1024, 1024), 1);
+	CHECK(residency.HasPendingUploads());
+
+	std::vector<TileUpload> uploads;
+	residency.AllocateUploads(100, uploads);
+	REQUIRE_EQ(uploads.size(), 17u);
+	const TileId coarsest = {layout.NumLevels - 1, 0, 0};
+	CHECK(uploads[0].Tile == coarsest);
+	// The view covers tiles 4..7 in both directions; the central four come first.
+	for (int i = 1; i <= 4; i++)
+	{
+		CHECK(uploads[i].Tile.X == 5 || uploads[i].Tile.X == 6);
+		CHECK(uploads[i].Tile.Y == 5 || uploads[i].Tile.Y == 6);
+	}
+	CHECK(!residency.HasPendingUploads());
+	CHECK_EQ(residency.GetStats().ResidentTiles, 17);
+
+	// A discarded upload is forgotten and asked for again.
+	residency.Discard(uploads[16]);
+	CHECK(!residency.IsResident(uploads[16].Tile));
+	residency.Update(MakeView(1024, 1024, 2048, 2048, 1024, 1024), 2);
+	CHECK(residency.HasPendingUploads());
+	uploads.clear();
+	residency.AllocateUploads(100, uploads);
+	REQUIRE_EQ(uploads.size(), 1u);
+	CHECK_EQ(residency.GetStats().Uploads, 17u);
+}
+
+// Random views, frame after frame, with few slots and a small upload budget, against what a renderer would
+// see: every draw samples a slot that holds the tile it was drawn from (the wanted one or an ancestor), covers
+// the view, and a slot is never overwritten while a frame in flight may still sample it.
+TEST(ResidencyModel)
+{
+	Testing::Random random(23);
+	uint64_t evictions = 0;
+	for (int trial = 0; trial < 50; trial++)
+	{
+		TileLayout layout = TileLayout::Make(random.Range(300, 100000), random.Range(300, 100000));
+		const int numSlots = random.Range(10, 48);
+		const int framesInFlight = random.Range(1, 3);
+		TileResidency residency;
+		residency.Initialize(layout, numSlots, framesInFlight);
+
+		std::vector<TileId> slotTiles(numSlots);
+		std::vector<bool> slotUsed(numSlots, false);
+		std::vector<int64_t> lastDrawn(numSlots, -1000);
+		std::vector<TileUpload> uploads;
+		std::vector<TileDraw> draws;
+		TileView view = MakeRandomView(layout, random);
+		for (uint64_t frame = 1; frame <= 300; frame++)
+		{
+			// Mostly pans and zooms a little, sometimes jumps; one or two views a frame, as with a zoom lens.
+			if (random.Below(10) == 0)
+				view = MakeRandomView(layout, random);
+			float panX = (random.Below(21) - 10.0f) * 0.02f * (view.X1 - view.X0);
+			view.X0 += panX;
+			view.X1 += panX;
+			std::vector<TileView> views = {view};
+			if (random.Below(3) == 0)
+				views.push_back(MakeRandomView(layout, random));
+
+			for (const TileView& frameView : views)
+				residency.Update(frameView, frame);
+			uploads.clear();
+			residency.AllocateUploads(random.Range(1, 8), uploads);
+			for (const TileUpload& upload : uploads)
+			{
+				REQUIRE(upload.Slot >= 0 && upload.Slot < numSlots);
+				REQUIRE(lastDrawn[upload.Slot] + framesInFlight < static_cast<int64_t>(frame));
+				slotTiles[upload.Slot] = upload.Tile;
+				slotUsed[upload.Slot] = true;
+			}
+
+			for (const TileView& frameView : views)
+			{
+				draws.clear();
+				residency.GetDraws(frameView, draws);
+				int level = residency.SelectLevel(frameView);
+				int x0, y0, x1, y1;
+				residency.GetVisibleTiles(frameView, level, x0, y0, x1, y1);
+				// The coarsest tile is the first upload and never leaves, so every visible tile gets a draw.
+				REQUIRE_EQ(draws.size(), static_cast<size_t>((x1 - x0 + 1) * (y1 - y0 + 1)));
+
+				for (const TileDraw& draw : draws)
+				{
+					REQUIRE(slotUsed[draw.Slot]);
+					lastDrawn[draw.Slot] = static_cast<int64_t>(frame);
+					const TileId& drawn = slotTiles[draw.Slot];
+					REQUIRE(residency.IsResident(drawn));
+					REQUIRE(drawn.Level >= level);
+
+					// The quad lies within the drawn tile, and its texture rectangle within the slot.
+					float rect[4];
+					GetTileRect(layout, drawn, rect);
+					float slack = layout.GetScaleX(drawn.Level) + layout.GetScaleY(drawn.Level);
+					REQUIRE(draw.X0 >= rect[0] - slack && draw.X1 <= rect[2] + slack);
+					REQUIRE(draw.Y0 >= rect[1] - slack && draw.Y1 <= rect[3] + slack);
+					REQUIRE(draw.U0 >= APP_TILE_BORDER && draw.U1 <= APP_TILE_BORDER + APP_TILE_SIZE);
+					REQUIRE(draw.V0 >= APP_TILE_BORDER && draw.V1 <= APP_TILE_BORDER + APP_TILE_SIZE);
+					REQUIRE(draw.U0 <= draw.U1 && draw.V0 <= draw.V1);
+				}
+			}
+
+			TileResidencyStats stats = residency.GetStats();
+			REQUIRE(stats.ResidentTiles <= numSlots);
+			REQUIRE_EQ(static_cast<uint64_t>(stats.ResidentTiles), stats.Uploads - stats.Evictions);
+			REQUIRE(residency.IsResident({layout.NumLevels - 1, 0, 0}));
+		}
+
+		// Held still on the whole image at the next to last level (at most 3x3 tiles, plus the pinned one), the
+		// view ends up drawn entirely at that level.
+		int stillLevel = std::max(0, layout.NumLevels - 2);
+		TileView still = MakeView(0, 0, static_cast<float>(layout.Width), static_cast<float>(layout.Height),
+		                          static_cast<float>(layout.GetLevelWidth(stillLevel)),
+		                          static_cast<float>(layout.GetLevelHeight(stillLevel)));
+		for (uint64_t frame = 301; frame < 301 + 40; frame++)
+		{
+			residency.Update(still, frame);
+			uploads.clear();
+			residency.AllocateUploads(2, uploads);
+			for (const TileUpload& upload : uploads)
+				slotTiles[upload.Slot] = upload.Tile;
+		}
+		CHECK(!residency.HasPendingUploads());
+		draws.clear();
+		residency.GetDraws(still, draws);
+		CHECK_EQ(residency.SelectLevel(still), stillLevel);
+		std::map<int, int> slotsDrawn;
+		for (const TileDraw& draw : draws)
+		{
+			CHECK_EQ(slotTiles[draw.Slot].Level, stillLevel);
+			slotsDrawn[draw.Slot]++;
+		}
+		CHECK_EQ(slotsDrawn.size(), draws.size());
+		evictions += residency.GetStats().Evictions;
+	}
+	// Otherwise the slots were never short and the model checked little.
+	CHECK(evictions > 0);
+}
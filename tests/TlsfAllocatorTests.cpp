@@ -0,0 +1,202 @@
+#include "TestFramework.h"
+#include "render/TlsfAllocator.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <vector>
+
+namespace
+{
+	const uint64_t KB = 1024;
+	const uint64_t MB = 1024 * KB;
+
+	// The free ranges a TLSF allocator that merges immediately must have: the gaps between live allocations.
+	std::vector<uint64_t> GetGaps(const std::map<uint64_t, uint64_t>& live, uint64_t capacity)
+	{
+		std::vector<uint64_t> gaps;
+		uint64_t end = 0;
+		for (const auto& [offset, size] : live)
+		{
+			if (offset > end)
+				gaps.push_back(offset - end);
+			end = offset + size;
+		}
+		if (capacity > end)
+			gaps.push_back(capacity - end);
+		return gaps;
+	}
+}
+
+TEST(PlacesAtTheRequestedAlignment)
+{
+	TlsfAllocator allocator;
+	allocator.Initialize(64 * MB, 4 * KB);
+	CHECK(allocator.IsEmpty());
+	CHECK_EQ(allocator.GetCapacity(), 64 * MB);
+
+	// A small texture at 4 KB, then a regular one at 64 KB, which leaves the padding in between free.
+	TlsfAllocation small;
+	REQUIRE(allocator.Allocate(20 * KB, 4 * KB, &small));
+	CHECK_EQ(small.Offset, 0u);
+	CHECK_EQ(small.Size, 20 * KB);
+	TlsfAllocation large;
+	REQUIRE(allocator.Allocate(100 * KB, 64 * KB, &large));
+	CHECK_EQ(large.Offset, 64 * KB);
+	CHECK_EQ(large.Size, 100 * KB);
+
+	TlsfStats stats = allocator.GetStats();
+	CHECK_EQ(stats.UsedBytes, 120 * KB);
+	CHECK_EQ(stats.NumAllocations, 2u);
+	CHECK_EQ(stats.NumFreeBlocks, 2u);
+	CHECK_EQ(stats.LargestFreeBlock, 64 * MB - 164 * KB);
+	CHECK(stats.GetFragmentation() > 0.0f);
+
+	// Sizes round up to the granularity, and the padding is found again for something that fits.
+	TlsfAllocation odd;
+	REQUIRE(allocator.Allocate(1, 1, &odd));
+	CHECK_EQ(odd.Size, 4 * KB);
+	CHECK(odd.Offset == 20 * KB || odd.Offset >= 164 * KB);
+
+	CHECK(allocator.Free(small));
+	CHECK(allocator.Free(large));
+	CHECK(allocator.Free(odd));
+	CHECK(allocator.IsEmpty());
+	stats = allocator.GetStats();
+	CHECK_EQ(stats.NumFreeBlocks, 1u);
+	CHECK_EQ(stats.LargestFreeBlock, 64 * MB);
+	CHECK_EQ(stats.GetFragmentation(), 0.0f);
+}
+
+TEST(RejectsWhatCannotBeFreed)
+{
+	TlsfAllocator allocator;
+	allocator.Initialize(MB, 4 * KB);
+	TlsfAllocation allocation;
+	REQUIRE(allocator.Allocate(8 * KB, 4 * KB, &allocation));
+	CHECK(!allocator.Free(TlsfAllocation()));
+	TlsfAllocation wrongGeneration = allocation;
+	wrongGeneration.Generation++;
+	CHECK(!allocator.Free(wrongGeneration));
+	CHECK(allocator.Free(allocation));
+	CHECK(!allocator.Free(allocation));
+
+	// The node comes back for the next allocation with a new generation.
+	TlsfAllocation next;
+	REQUIRE(allocator.Allocate(8 * KB, 4 * KB, &next));
+	CHECK(!allocator.Free(allocation));
+	CHECK_EQ(allocator.GetUsedBytes(), 8 * KB);
+	CHECK(allocator.Free(next));
+}
+
+TEST(ReportsExhaustion)
+{
+	TlsfAllocator allocator;
+	allocator.Initialize(10 * MB + 100, 64 * KB); // trimmed to the granularity
+	CHECK_EQ(allocator.GetCapacity(), 10 * MB);
+	TlsfAllocation allocation;
+	CHECK(!allocator.Allocate(0, 1, &allocation));
+	CHECK(allocation.IsNull());
+	CHECK(!allocator.Allocate(11 * MB, 1, &allocation));
+	CHECK(!allocator.Allocate(UINT64_MAX, 1, &allocation));
+
+	std::vector<TlsfAllocation> allocations(160);
+	for (TlsfAllocation& each : allocations)
+		REQUIRE(allocator.Allocate(64 * KB, 64 * KB, &each));
+	CHECK(!allocator.Allocate(1, 1, &allocation));
+	CHECK_EQ(allocator.GetStats().NumFreeBlocks, 0u);
+	CHECK_EQ(allocator.GetStats().GetFragmentation(), 0.0f);
+
+	CHECK(allocator.Free(allocations[42]));
+	REQUIRE(allocator.Allocate(1, 1, &allocation));
+	CHECK_EQ(allocation.Offset, 42 * 64 * KB);
+
+	allocator.Reset();
+	CHECK(allocator.IsEmpty());
+	CHECK(!allocator.Free(allocations[0]));
+	REQUIRE(allocator.Allocate(10 * MB, 64 * KB, &allocation));
+	CHECK_EQ(allocation.Offset, 0u);
+}
+
+// Random texture-sized allocations and frees against a map of live ranges: ranges are aligned, inside the
+// capacity and never overlap; the free blocks are exactly the gaps between live ranges; stale frees are
+// rejected; and an allocation only fails when no gap is clearly large enough for it.
+TEST(RandomizedAgainstModel)
+{
+	for (uint64_t seed = 1; seed <= 8; seed++)
+	{
+		Testing::Random random(seed);
+		const uint64_t granularity = random.Below(2) ? 4 * KB : 256;
+		const uint64_t capacity = (16 + random.Below(112)) * MB + random.Below(1000) * granularity;
+		TlsfAllocator allocator;
+		allocator.Initialize(capacity, granularity);
+
+		std::map<uint64_t, uint64_t> live; // offset to size
+		std::vector<TlsfAllocation> allocations;
+		std::vector<TlsfAllocation> freed;
+		int failures = 0;
+		for (int step = 0; step < 20000; step++)
+		{
+			// Drift between mostly allocating and mostly freeing so both full and empty states are visited.
+			bool allocate = random.Below(100) < ((step / 1500) % 2 == 0 ? 65u : 35u);
+			if (allocate || allocations.empty())
+			{
+				// Mostly small, like icons and thumbnails, sometimes a few megabytes.
+				uint64_t size = random.Below(8) == 0 ? random.Range(1, 4 * MB) : random.Range(1, 256 * KB);
+				uint64_t alignment = random.Below(4) == 0 ? 64 * KB : uint64_t(1) << random.Below(13);
+				TlsfAllocation allocation;
+				if (!allocator.Allocate(size, alignment, &allocation))
+				{
+					REQUIRE(allocation.IsNull());
+					// Rounding the request up to its bin costs at most an eighth of it.
+					uint64_t needed = (size + granularity - 1) / granularity * granularity +
+						std::max(alignment, granularity) - granularity;
+					std::vector<uint64_t> gaps = GetGaps(live, capacity);
+					for (uint64_t gap : gaps)
+						REQUIRE(gap < needed + needed / 8 + granularity);
+					failures++;
+					continue;
+				}
+
+				REQUIRE_EQ(allocation.Offset % std::max(alignment, granularity), 0u);
+				REQUIRE_EQ(allocation.Size, (size + granularity - 1) / granularity * granularity);
+				REQUIRE(allocation.Offset + allocation.Size <= capacity);
+				auto next = live.lower_bound(allocation.Offset);
+				if (next != live.end())
+					REQUIRE(allocation.Offset + allocation.Size <= next->first);
+				if (next != live.begin())
+					REQUIRE(std::prev(next)->first + std::prev(next)->second <= allocation.Offset);
+				live[allocation.Offset] = allocation.Size;
+				allocations.push_back(allocation);
+			}
+			else
+			{
+				size_t victim = random.Below(static_cast<uint32_t>(allocations.size()));
+				REQUIRE(allocator.Free(allocations[victim]));
+				live.erase(allocations[victim].Offset);
+				freed.push_back(allocations[victim]);
+				allocations[victim] = allocations.back();
+				allocations.pop_back();
+			}
+
+			if (!freed.empty() && random.Below(10) == 0)
+				REQUIRE(!allocator.Free(freed[random.Below(static_cast<uint32_t>(freed.size()))]));
+
+			uint64_t usedBytes = 0;
+			for (const auto& [offset, size] : live)
+				usedBytes += size;
+			std::vector<uint64_t> gaps = GetGaps(live, capacity);
+			TlsfStats stats = allocator.GetStats();
+			REQUIRE_EQ(stats.UsedBytes, usedBytes);
+			REQUIRE_EQ(stats.NumAllocations, static_cast<uint32_t>(live.size()));
+			REQUIRE_EQ(stats.NumFreeBlocks, static_cast<uint32_t>(gaps.size()));
+			REQUIRE_EQ(stats.LargestFreeBlock, gaps.empty() ? 0 : *std::max_element(gaps.begin(), gaps.end()));
+		}
+		CHECK(failures > 0);
+
+		for (const TlsfAllocation& allocation : allocations)
+			REQUIRE(allocator.Free(allocation));
+		CHECK(allocator.IsEmpty());
+		CHECK_EQ(allocator.GetStats().LargestFreeBlock, capacity);
+	}
+}
@@ -0,0 +1,166 @@
+#include "TestFramework.h"
+#include "render/UploadRingAllocator.h"
+
+#include <deque>
+
+namespace
+{
+	constexpr uint64_t PLACEMENT_ALIGNMENT = 512; // D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
+
+	struct LiveAllocation
+	{
+		uint64_t Offset;
+		uint64_t Size;
+		uint64_t FenceValue; // 0 until submitted
+	};
+
+	bool Overlaps(const LiveAllocation& a, uint64_t offset, uint64_t size)
+	{
+		return offset < a.Offset + a.Size && a.Offset < offset + size;
+	}
+}
+
+TEST(AllocatesAlignedAndInOrder)
+{
+	UploadRingAllocator ring;
+	ring.Initialize(4096);
+	CHECK_EQ(ring.Allocate(100, PLACEMENT_ALIGNMENT), 0u);
+	CHECK_EQ(ring.Allocate(100, PLACEMENT_ALIGNMENT), 512u);
+	CHECK_EQ(ring.Allocate(10, 4), 612u);
+	CHECK_EQ(ring.GetUsedBytes(), 622u);
+	CHECK(ring.HasUnsubmittedAllocations());
+
+	ring.Submit(1);
+	CHECK(!ring.HasUnsubmittedAllocations());
+	ring.Retire(0);
+	CHECK_EQ(ring.GetUsedBytes(), 622u);
+	ring.Retire(1);
+	CHECK_EQ(ring.GetUsedBytes(), 0u);
+}
+
+TEST(RejectsWhatCannotFit)
+{
+	UploadRingAllocator ring;
+	ring.Initialize(1024);
+	CHECK_EQ(ring.Allocate(0, 1), UploadRingAllocator::INVALID_OFFSET);
+	CHECK_EQ(ring.Allocate(1025, 1), UploadRingAllocator::INVALID_OFFSET);
+	CHECK_EQ(ring.Allocate(1024, 1), 0u);
+	// Full until the submission retires.
+	CHECK_EQ(ring.Allocate(1, 1), UploadRingAllocator::INVALID_OFFSET);
+	ring.Submit(7);
+	ring.Retire(6);
+	CHECK_EQ(ring.Allocate(1, 1), UploadRingAllocator::INVALID_OFFSET);
+	ring.Retire(7);
+	CHECK_EQ(ring.Allocate(1024, 1), 0u);
+}
+
+TEST(WrapsAroundOnceTheHeadRetires)
+{
+	UploadRingAllocator ring;
+	ring.Initialize(4096);
+	CHECK_EQ(ring.Allocate(1536, PLACEMENT_ALIGNMENT), 0u);
+	ring.Submit(1);
+	CHECK_EQ(ring.Allocate(1536, PLACEMENT_ALIGNMENT), 1536u);
+	ring.Submit(2);
+
+	// 1024 bytes left at the end: too few for 1536, and the start is still in use.
+	CHECK_EQ(ring.Allocate(1536, PLACEMENT_ALIGNMENT), UploadRingAllocator::INVALID_OFFSET);
+	ring.Retire(1);
+	// The tail of the buffer is skipped and counted as used until the wrapping submission retires.
+	CHECK_EQ(ring.Allocate(1536, PLACEMENT_ALIGNMENT), 0u);
+	CHECK_EQ(ring.GetUsedBytes(), 1536u + 1024u + 1536u);
+	ring.Submit(3);
+	ring.Retire(2);
+	CHECK_EQ(ring.GetUsedBytes(), 1536u + 1024u);
+	ring.Retire(3);
+	CHECK_EQ(ring.GetUsedBytes(), 0u);
+}
+
+TEST(ResetDropsEverything)
+{
+	UploadRingAllocator ring;
+	ring.Initialize(2048);
+	ring.Allocate(1000, 1);
+	ring.Submit(1);
+	ring.Allocate(500, 1);
+	ring.Reset();
+	CHECK_EQ(ring.GetUsedBytes(), 0u);
+	CHECK(!ring.HasUnsubmittedAllocations());
+	CHECK_EQ(ring.Allocate(2048, 1), 0u);
+}
+
+// Random allocations, submissions and fence completions against a list of what is still live: nothing handed
+// out may overlap live memory or leave the buffer, and the used byte count must cover every live byte.
+TEST(RandomizedAgainstModel)
+{
+	for (uint64_t seed = 1; seed <= 20; seed++)
+	{
+		Testing::Random random(seed);
+		const uint64_t capacity = 1ull << random.Range(12, 20);
+		UploadRingAllocator ring;
+		ring.Initialize(capacity);
+
+		std::deque<LiveAllocation> live;
+		uint64_t nextFence = 1;
+		uint64_t completedFence = 0;
+		int numAllocated = 0;
+		for (int step = 0; step < 20000; step++)
+		{
+			uint32_t action = random.Below(10);
+			if (action < 6)
+			{
+				uint64_t size = 1 + random.Below(static_cast<uint32_t>(capacity / (random.Below(4) == 0 ? 2 : 16)));
+				uint64_t alignment = 1ull << random.Below(10);
+				uint64_t usedBefore = ring.GetUsedBytes();
+				uint64_t offset = ring.Allocate(size, alignment);
+				if (offset == UploadRingAllocator::INVALID_OFFSET)
+				{
+					// An empty ring takes anything that fits in it.
+					REQUIRE(usedBefore != 0);
+					continue;
+				}
+				REQUIRE_EQ(offset % alignment, 0u);
+				REQUIRE(offset + size <= capacity);
+				for (const LiveAllocation& allocation : live)
+					REQUIRE(!Overlaps(allocation, offset, size));
+				live.push_back({offset, size, 0});
+				numAllocated++;
+			}
+			else if (action < 8)
+			{
+				if (!ring.HasUnsubmittedAllocations())
+					continue;
+				uint64_t fence = nextFence++;
+				ring.Submit(fence);
+				for (LiveAllocation& allocation : live)
+					if (allocation.FenceValue == 0)
+						allocation.FenceValue = fence;
+			}
+			else
+			{
+				// The GPU catches up to some submitted value, in order.
+				if (completedFence + 1 >= nextFence)
+					continue;
+				completedFence += 1 + random.Below(static_cast<uint32_t>(nextFence - completedFence - 1));
+				ring.Retire(completedFence);
+				while (!live.empty() && live.front().FenceValue != 0 && live.front().FenceValue <= completedFence)
+					live.pop_front();
+			}
+
+			uint64_t liveBytes = 0;
+			for (const LiveAllocation& allocation : live)
+				liveBytes += allocation.Size;
+			REQUIRE(ring.GetUsedBytes() >= liveBytes);
+			REQUIRE(ring.GetUsedBytes() <= capacity);
+			REQUIRE_EQ(ring.HasUnsubmittedAllocations(), !live.empty() && live.back().FenceValue == 0);
+		}
+
+		// Draining the GPU frees all of it.
+		if (ring.HasUnsubmittedAllocations())
+			ring.Submit(nextFence++);
+		ring.Retire(nextFence);
+		CHECK_EQ(ring.GetUsedBytes(), 0u);
+		CHECK_EQ(ring.Allocate(capacity, 1), 0u);
+		CHECK(numAllocated > 1000);
+	}
+}
@@ -0,0 +1,184 @@
+#include "TestFramework.h"
+#include "render/UploadScheduler.h"
+
+#include <vector>
+
+namespace
+{
+	// A queue whose GPU only makes progress when the test says so, or when the CPU waits on it.
+	class SimulatedQueue : public IUploadQueue
+	{
+	public:
+		void Execute(uint32_t contextIndex) override { Executed.push_back(contextIndex); }
+
+		void Signal(uint64_t fenceValue) override
+		{
+			CHECK(fenceValue > LastSignaled); // one monotonic timeline
+			LastSignaled = fenceValue;
+		}
+
+		uint64_t GetCompletedValue() const override { return Completed; }
+
+		void WaitForValue(uint64_t fenceValue) override
+		{
+			CHECK(fenceValue <= LastSignaled); // waiting for something never signaled would hang
+			Waits.push_back(fenceValue);
+			Complete(fenceValue);
+		}
+
+		void Complete(uint64_t fenceValue)
+		{
+			if (fenceValue > Completed)
+				Completed = fenceValue <= LastSignaled ? fenceValue : LastSignaled;
+		}
+
+		std::vector<uint32_t> Executed;
+		std::vector<uint64_t> Waits;
+		uint64_t LastSignaled = 0;
+		uint64_t Completed = 0;
+	};
+}
+
+TEST(StampsSubmissionsInOrder)
+{
+	SimulatedQueue queue;
+	UploadScheduler scheduler;
+	scheduler.Initialize(&queue, 4);
+	for (uint64_t expected = 1; expected <= 10; expected++)
+	{
+		uint32_t context = scheduler.AcquireContext();
+		CHECK_EQ(scheduler.Submit(context), expected);
+		CHECK_EQ(queue.Executed.back(), context);
+		CHECK_EQ(scheduler.GetLastSubmittedValue(), expected);
+	}
+	CHECK(queue.Waits.size() > 0); // four contexts for ten uploads
+}
+
+TEST(ContinuesAnExistingTimeline)
+{
+	SimulatedQueue queue;
+	queue.LastSignaled = 41;
+	queue.Completed = 41;
+	UploadScheduler scheduler;
+	scheduler.Initialize(&queue, 2);
+	CHECK_EQ(scheduler.Submit(scheduler.AcquireContext()), 42u);
+}
+
+TEST(ReusesRetiredContextsBeforeGrowing)
+{
+	SimulatedQueue queue;
+	UploadScheduler scheduler;
+	scheduler.Initialize(&queue, 3);
+
+	uint32_t first = scheduler.AcquireContext();
+	uint64_t firstValue = scheduler.Submit(first);
+	queue.Complete(firstValue);
+	CHECK_EQ(scheduler.AcquireContext(), first);
+	CHECK_EQ(scheduler.GetNumContexts(), 1u);
+	scheduler.Submit(first);
+
+	// Nothing retired: the pool grows up to its limit without waiting.
+	uint32_t second = scheduler.AcquireContext();
+	scheduler.Submit(second);
+	uint32_t third = scheduler.AcquireContext();
+	scheduler.Submit(third);
+	CHECK_EQ(scheduler.GetNumContexts(), 3u);
+	CHECK(queue.Waits.empty());
+
+	// Then it waits for the oldest submission rather than creating a fourth context.
+	uint32_t fourth = scheduler.AcquireContext();
+	CHECK_EQ(scheduler.GetNumContexts(), 3u);
+	REQUIRE_EQ(queue.Waits.size(), size_t(1));
+	CHECK_EQ(queue.Waits[0], 2u);
+	CHECK_EQ(fourth, first);
+}
+
+TEST(ContextsBeingRecordedAreNeverShared)
+{
+	SimulatedQueue queue;
+	UploadScheduler scheduler;
+	scheduler.Initialize(&queue, 2);
+	uint32_t a = scheduler.AcquireContext();
+	uint32_t b = scheduler.AcquireContext();
+	CHECK(a != b);
+	// Both are recording and the pool is full; a third is created rather than handing out either.
+	uint32_t c = scheduler.AcquireContext();
+	CHECK(c != a && c != b);
+	scheduler.Submit(a);
+	scheduler.Submit(b);
+	scheduler.Submit(c);
+}
+
+TEST(FrameWaitsOnTheNewestRequiredUpload)
+{
+	SimulatedQueue queue;
+	UploadScheduler scheduler;
+	scheduler.Initialize(&queue, 4);
+	uint64_t values[3];
+	for (uint64_t& value : values)
+		value = scheduler.Submit(scheduler.AcquireContext());
+
+	// Nothing sampled: no wait.
+	CHECK_EQ(scheduler.ConsumeFrameWait(), 0u);
+
+	scheduler.RequireForFrame(values[1]);
+	scheduler.RequireForFrame(values[0]);
+	scheduler.RequireForFrame(0); // a texture with nothing left to wait for
+	CHECK_EQ(scheduler.ConsumeFrameWait(), values[1]);
+	// Consumed: the next frame only waits for what it requires itself.
+	CHECK_EQ(scheduler.ConsumeFrameWait(), 0u);
+
+	// Already complete: no GPU wait needed.
+	queue.Complete(values[2]);
+	scheduler.RequireForFrame(values[2]);
+	CHECK_EQ(scheduler.ConsumeFrameWait(), 0u);
+}
+
+TEST(WaitIdleDrainsTheQueue)
+{
+	SimulatedQueue queue;
+	UploadScheduler scheduler;
+	scheduler.Initialize(&queue, 4);
+	for (int i = 0; i < 3; i++)
+		scheduler.Submit(scheduler.AcquireContext());
+	CHECK(!scheduler.IsComplete(3));
+	CHECK(scheduler.IsComplete(0));
+	scheduler.WaitIdle();
+	CHECK(scheduler.IsComplete(3));
+	CHECK_EQ(queue.Completed, 3u);
+
+	// Waiting for what is complete does not touch the queue.
+	size_t numWaits = queue.Waits.size();
+	scheduler.WaitForValue(2);
+	CHECK_EQ(queue.Waits.size(), numWaits);
+}
+
+// Random uploads and GPU progress: a context is only recorded into once its previous submission completed.
+TEST(RandomizedNeverRecordsIntoBusyContexts)
+{
+	for (uint64_t seed = 1; seed <= 10; seed++)
+	{
+		Testing::Random random(seed);
+		SimulatedQueue queue;
+		UploadScheduler scheduler;
+		uint32_t maxContexts = 1 + random.Below(6);
+		scheduler.Initialize(&queue, maxContexts);
+
+		std::vector<uint64_t> contextValues; // fence of each context's last submission
+		for (int step = 0; step < 5000; step++)
+		{
+			if (random.Below(3) == 0)
+			{
+				queue.Complete(queue.Completed + random.Below(3));
+				continue;
+			}
+
+			uint32_t context = scheduler.AcquireContext();
+			if (context >= contextValues.size())
+				contextValues.resize(context + 1, 0);
+			REQUIRE(contextValues[context] <= queue.Completed);
+			REQUIRE(scheduler.GetNumContexts() <= maxContexts);
+			contextValues[context] = scheduler.Submit(context);
+		}
+	}
+}
@@ -0,0 +1,691 @@
+#include "TestImages.h"
+
+#include <cmath>
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include <jpeglib.h>
+#include <zlib.h>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+	uint64_t NextRandom(uint64_t& state)
+	{
+		uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	uint32_t Crc32(const unsigned char* data, size_t size, uint32_t crc = 0)
+	{
+		return static_cast<uint32_t>(crc32(crc, data, static_cast<uInt>(size)));
+	}
+
+	void PutBigEndian32(std::vector<unsigned char>& out, uint32_t value)
+	{
+		out.push_back(static_cast<unsigned char>(value >> 24));
+		out.push_back(static_cast<unsigned char>(value >> 16));
+		out.push_back(static_cast<unsigned char>(value >> 8));
+		out.push_back(static_cast<unsigned char>(value));
+	}
+
+	void PutLittleEndian32(std::vector<unsigned char>& out, uint32_t value)
+	{
+		for (int shift = 0; shift < 32; shift += 8)
+			out.push_back(static_cast<unsigned char>(value >> shift));
+	}
+
+	void PutLittleEndian64(std::vector<unsigned char>& out, uint64_t value)
+	{
+		PutLittleEndian32(out, static_cast<uint32_t>(value));
+		PutLittleEndian32(out, static_cast<uint32_t>(value >> 32));
+	}
+
+	// Sizes of a mip chain as TextureContainer computes them.
+	std::vector<size_t> GetLevelSizes(TextureFormat format, int width, int height, int mipLevels)
+	{
+		std::vector<size_t> sizes;
+		for (int level = 0; level < mipLevels; level++)
+		{
+			sizes.push_back(TextureFormats::GetLevelSize(format, width, height));
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+		}
+		return sizes;
+	}
+
+	void PutChunk(std::vector<unsigned char>& out, const char* type, const unsigned char* data, size_t size)
+	{
+		PutBigEndian32(out, static_cast<uint32_t>(size));
+		size_t start = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data, data + size);
+		PutBigEndian32(out, Crc32(out.data() + start, out.size() - start));
+	}
+
+	int GetChannels(int colorType)
+	{
+		switch (colorType)
+		{
+		case 0:
+		case 3:
+			return 1;
+		case 2:
+			return 3;
+		case 4:
+			return 2;
+		default:
+			return 4;
+		}
+	}
+
+	int Paeth(int a, int b, int c)
+	{
+		int p = a + b - c;
+		int pa = std::abs(p - a);
+		int pb = std::abs(p - b);
+		int pc = std::abs(p - c);
+		if (pa <= pb && pa <= pc)
+			return a;
+		return pb <= pc ? b : c;
+	}
+
+	struct JpegErrorManager
+	{
+		jpeg_error_mgr Base;
+		std::jmp_buf Jump;
+	};
+
+	void OnJpegError(j_common_ptr info)
+	{
+		std::longjmp(reinterpret_cast<JpegErrorManager*>(info->err)->Jump, 1);
+	}
+}
+
+namespace TestImages
+{
+	std::vector<unsigned char> MakePhoto(int width, int height, int channels, uint64_t seed, int bitDepth)
+	{
+		int bytesPerSample = bitDepth == 16 ? 2 : 1;
+		std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * channels * bytesPerSample);
+		uint64_t state = seed;
+		double phase[4];
+		for (double& p : phase)
+			p = static_cast<double>(NextRandom(state) % 1000) / 100.0;
+
+		// A disc and a bar with hard edges over soft waves, then noise of a few levels.
+		double discX = width * 0.35;
+		double discY = height * 0.4;
+		double discRadius = (width < height ? width : height) * 0.2;
+		size_t index = 0;
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				double u = static_cast<double>(x) / width;
+				double v = static_cast<double>(y) / height;
+				bool inDisc = (x - discX) * (x - discX) + (y - discY) * (y - discY) < discRadius * discRadius;
+				bool inBar = v > 0.7 && v < 0.78;
+				for (int c = 0; c < channels; c++)
+				{
+					double value = 0.5 + 0.25 * std::sin(6.0 * u + phase[c]) + 0.2 * std::cos(5.0 * v + 2.0 * phase[c]);
+					if (c == 3)
+						value = 0.75 + 0.25 * std::sin(3.0 * u * v + phase[c]); // alpha, mostly opaque
+					else if (inDisc)
+						value = 0.15 + 0.2 * c;
+					else if (inBar)
+						value = 1.0 - value;
+
+					int noise = static_cast<int>(NextRandom(state) % 7) - 3;
+					if (bitDepth == 16)
+					{
+						int sample = static_cast<int>(value * 65535.0) + noise * 97;
+						sample = sample < 0 ? 0 : (sample > 65535 ? 65535 : sample);
+						auto sample16 = static_cast<uint16_t>(sample);
+						std::memcpy(&pixels[index], &sample16, 2);
+						index += 2;
+					}
+					else
+					{
+						int sample = static_cast<int>(value * 255.0) + noise;
+						pixels[index++] = static_cast<unsigned char>(sample < 0 ? 0 : (sample > 255 ? 255 : sample));
+					}
+				}
+			}
+		}
+		return pixels;
+	}
+
+	std::vector<unsigned char> MakeNoise(size_t size, uint64_t seed)
+	{
+		std::vector<unsigned char> data(size);
+		uint64_t state = seed;
+		for (size_t i = 0; i < size; i += 8)
+		{
+			uint64_t value = NextRandom(state);
+			std::memcpy(&data[i], &value, size - i < 8 ? size - i : 8);
+		}
+		return data;
+	}
+
+	std::vector<unsigned char> EncodePng(const unsigned char* pixels, int width, int height, const PngOptions& options,
+	                                     const std::vector<uint32_t>& palette)
+	{
+		int bitDepth = options.ColorType == 3 ? 8 : options.BitDepth;
+		int bytesPerPixel = GetChannels(options.ColorType) * bitDepth / 8;
+		size_t rowSize = static_cast<size_t>(width) * bytesPerPixel;
+
+		// Filtered rows, samples big-endian as PNG stores them.
+		std::vector<unsigned char> previous(rowSize, 0);
+		std::vector<unsigned char> current(rowSize);
+		std::vector<unsigned char> filtered((rowSize + 1) * height);
+		for (int y = 0; y < height; y++)
+		{
+			const unsigned char* source = pixels + rowSize * y;
+			if (bitDepth == 16)
+			{
+				for (size_t i = 0; i < rowSize; i += 2)
+				{
+					current[i] = source[i + 1];
+					current[i + 1] = source[i];
+				}
+			}
+			else
+			{
+				std::memcpy(current.data(), source, rowSize);
+			}
+
+			int filter = options.Filter >= 0 ? options.Filter : y % 5;
+			unsigned char* out = &filtered[(rowSize + 1) * y];
+			*out++ = static_cast<unsigned char>(filter);
+			for (size_t i = 0; i < rowSize; i++)
+			{
+				int a = i >= static_cast<size_t>(bytesPerPixel) ? current[i - bytesPerPixel] : 0;
+				int b = previous[i];
+				int c = i >= static_cast<size_t>(bytesPerPixel) ? previous[i - bytesPerPixel] : 0;
+				int predictor = 0;
+				switch (filter)
+				{
+				case 1: predictor = a; break;
+				case 2: predictor = b; break;
+				case 3: predictor = (a + b) / 2; break;
+				case 4: predictor = Paeth(a, b, c); break;
+				default: break;
+				}
+				out[i] = static_cast<unsigned char>(current[i] - predictor);
+			}
+			std::swap(previous, current);
+		}
+
+		// Compressed a band of rows at a time so full flushes fall on row boundaries, like pigz -i.
+		z_stream stream = {};
+		if (deflateInit(&stream, options.Level) != Z_OK)
+			throw std::runtime_error("deflateInit failed");
+		std::vector<unsigned char> compressed(deflateBound(&stream, static_cast<uLong>(filtered.size())) +
+		                                      static_cast<size_t>(height) * 16 + 64);
+		stream.next_out = compressed.data();
+		stream.avail_out = static_cast<uInt>(compressed.size());
+		int bandRows = options.FullFlushRows > 0 ? options.FullFlushRows : height;
+		for (int y = 0; y < height; y += bandRows)
+		{
+			int rows = height - y < bandRows ? height - y : bandRows;
+			stream.next_in = &filtered[(rowSize + 1) * y];
+			stream.avail_in = static_cast<uInt>((rowSize + 1) * rows);
+			bool last = y + rows >= height;
+			if (deflate(&stream, last ? Z_FINISH : Z_FULL_FLUSH) == Z_STREAM_ERROR)
+				throw std::runtime_error("deflate failed");
+		}
+		compressed.resize(stream.total_out);
+		deflateEnd(&stream);
+
+		std::vector<unsigned char> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+		std::vector<unsigned char> header;
+		PutBigEndian32(header, static_cast<uint32_t>(width));
+		PutBigEndian32(header, static_cast<uint32_t>(height));
+		header.push_back(static_cast<unsigned char>(bitDepth));
+		header.push_back(static_cast<unsigned char>(options.ColorType));
+		header.push_back(0);
+		header.push_back(0);
+		header.push_back(0);
+		PutChunk(png, "IHDR", header.data(), header.size());
+
+		if (options.ColorType == 3)
+		{
+			std::vector<unsigned char> plte;
+			std::vector<unsigned char> trns;
+			for (uint32_t color : palette)
+			{
+				plte.push_back(static_cast<unsigned char>(color));
+				plte.push_back(static_cast<unsigned char>(color >> 8));
+				plte.push_back(static_cast<unsigned char>(color >> 16));
+				trns.push_back(static_cast<unsigned char>(color >> 24));
+			}
+			PutChunk(png, "PLTE", plte.data(), plte.size());
+			PutChunk(png, "tRNS", trns.data(), trns.size());
+		}
+
+		for (size_t offset = 0; offset < compressed.size(); offset += options.IdatSize)
+		{
+			size_t size = compressed.size() - offset;
+			size = size < static_cast<size_t>(options.IdatSize) ? size : options.IdatSize;
+			PutChunk(png, "IDAT", compressed.data() + offset, size);
+		}
+		PutChunk(png, "IEND", nullptr, 0);
+		return png;
+	}
+
+	std::vector<unsigned char> EncodeJpeg(const unsigned char* pixels, int width, int height,
+	                                      const JpegOptions& options)
+	{
+		jpeg_compress_struct info = {};
+		JpegErrorManager error = {};
+		info.err = jpeg_std_error(&error.Base);
+		error.Base.error_exit = OnJpegError;
+
+		unsigned char* buffer = nullptr;
+		unsigned long bufferSize = 0;
+		if (setjmp(error.Jump))
+		{
+			jpeg_destroy_compress(&info);
+			std::free(buffer);
+			throw std::runtime_error("libjpeg failed");
+		}
+
+		jpeg_create_compress(&info);
+		jpeg_mem_dest(&info, &buffer, &bufferSize);
+		info.image_width = static_cast<JDIMENSION>(width);
+		info.image_height = static_cast<JDIMENSION>(height);
+		info.input_components = options.Components;
+		info.in_color_space = options.Components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+		jpeg_set_defaults(&info);
+		jpeg_set_quality(&info, options.Quality, TRUE);
+		if (options.Components == 3)
+		{
+			info.comp_info[0].h_samp_factor = options.SamplingH;
+			info.comp_info[0].v_samp_factor = options.SamplingV;
+			for (int c = 1; c < 3; c++)
+			{
+				info.comp_info[c].h_samp_factor = 1;
+				info.comp_info[c].v_samp_factor = 1;
+			}
+		}
+		if (options.Progressive)
+			jpeg_simple_progression(&info);
+		info.restart_in_rows = options.RestartRows;
+
+		jpeg_start_compress(&info, TRUE);
+		size_t rowSize = static_cast<size_t>(width) * options.Components;
+		while (info.next_scanline < info.image_height)
+		{
+			auto* row = const_cast<JSAMPLE*>(pixels + rowSize * info.next_scanline);
+			jpeg_write_scanlines(&info, &row, 1);
+		}
+		jpeg_finish_compress(&info);
+		jpeg_destroy_compress(&info);
+
+		std::vector<unsigned char> jpeg(buffer, buffer + bufferSize);
+		std::free(buffer);
+		return jpeg;
+	}
+
+	std::vector<unsigned char> DecodeJpegScaled(const std::vector<unsigned char>& jpeg, int scaleDenominator,
+	                                            int* out_width, int* out_height)
+	{
+		jpeg_decompress_struct info = {};
+		JpegErrorManager error = {};
+		info.err = jpeg_std_error(&error.Base);
+		error.Base.error_exit = OnJpegError;
+		if (setjmp(error.Jump))
+		{
+			jpeg_destroy_decompress(&info);
+			throw std::runtime_error("libjpeg failed");
+		}
+
+		jpeg_create_decompress(&info);
+		jpeg_mem_src(&info, const_cast<unsigned char*>(jpeg.data()), static_cast<unsigned long>(jpeg.size()));
+		jpeg_read_header(&info, TRUE);
+		info.scale_num = 1;
+		info.scale_denom = static_cast<unsigned int>(scaleDenominator);
+		info.out_color_space = info.num_components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+		jpeg_start_decompress(&info);
+
+		int width = static_cast<int>(info.output_width);
+		int height = static_cast<int>(info.output_height);
+		int channels = info.output_components;
+		std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * channels);
+		while (info.output_scanline < info.output_height)
+		{
+			JSAMPROW row = pixels.data() + static_cast<size_t>(info.output_scanline) * width * channels;
+			jpeg_read_scanlines(&info, &row, 1);
+		}
+		jpeg_finish_decompress(&info);
+		jpeg_destroy_decompress(&info);
+
+		*out_width = width;
+		*out_height = height;
+		return ToRgba(pixels.data(), pixels.size() / channels, channels);
+	}
+
+	std::vector<unsigned char> Deflate(const unsigned char* data, size_t size, int level, bool raw, int strategy)
+	{
+		z_stream stream = {};
+		if (deflateInit2(&stream, level, Z_DEFLATED, raw ? -15 : 15, 9, strategy) != Z_OK)
+			throw std::runtime_error("deflateInit2 failed");
+		std::vector<unsigned char> compressed(deflateBound(&stream, static_cast<uLong>(size)) + 64);
+		stream.next_in = const_cast<unsigned char*>(data);
+		stream.avail_in = static_cast<uInt>(size);
+		stream.next_out = compressed.data();
+		stream.avail_out = static_cast<uInt>(compressed.size());
+		if (deflate(&stream, Z_FINISH) != Z_STREAM_END)
+			throw std::runtime_error("deflate failed");
+		compressed.resize(stream.total_out);
+		deflateEnd(&stream);
+		return compressed;
+	}
+
+	std::vector<unsigned char> MakeDds(TextureFormat format, int width, int height, int mipLevels, uint64_t seed,
+	                                   bool legacyHeader)
+	{
+		const uint32_t DDSD_CAPS_HEIGHT_WIDTH_PIXELFORMAT = 0x1007;
+		const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+		const uint32_t DDSD_LINEARSIZE = 0x80000;
+		const uint32_t DDPF_FOURCC = 0x4;
+		const uint32_t DDSCAPS_TEXTURE_MIPMAP_COMPLEX = 0x401008;
+
+		uint32_t fourCc = 0;
+		if (legacyHeader)
+		{
+			const char* name = format == TextureFormat::Bc1 ? "DXT1" : format == TextureFormat::Bc3 ? "DXT5" : "ATI2";
+			memcpy(&fourCc, name, 4);
+		}
+		else
+		{
+			memcpy(&fourCc, "DX10", 4);
+		}
+
+		std::vector<size_t> sizes = GetLevelSizes(format, width, height, mipLevels);
+		std::vector<unsigned char> file = {'D', 'D', 'S', ' '};
+		PutLittleEndian32(file, 124);
+		PutLittleEndian32(file, DDSD_CAPS_HEIGHT_WIDTH_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE);
+		PutLittleEndian32(file, static_cast<uint32_t>(height));
+		PutLittleEndian32(file, static_cast<uint32_t>(width));
+		PutLittleEndian32(file, static_cast<uint32_t>(sizes[0]));
+		PutLittleEndian32(file, 0); // depth
+		PutLittleEndian32(file, static_cast<uint32_t>(mipLevels));
+		file.resize(file.size() + 11 * 4);
+		PutLittleEndian32(file, 32); // DDS_PIXELFORMAT
+		PutLittleEndian32(file, DDPF_FOURCC);
+		PutLittleEndian32(file, fourCc);
+		file.resize(file.size() + 5 * 4);
+		PutLittleEndian32(file, DDSCAPS_TEXTURE_MIPMAP_COMPLEX);
+		file.resize(file.size() + 4 * 4); // caps2, caps3, caps4, reserved
+		if (!legacyHeader)
+		{
+			PutLittleEndian32(file, static_cast<uint32_t>(format)); // DXGI_FORMAT
+			PutLittleEndian32(file, 3); // DDS_DIMENSION_TEXTURE2D
+			PutLittleEndian32(file, 0);
+			PutLittleEndian32(file, 1); // array size
+			PutLittleEndian32(file, 0);
+		}
+
+		for (size_t level = 0; level < sizes.size(); level++)
+		{
+			std::vector<unsigned char> blocks = MakeNoise(sizes[level], seed + level);
+			file.insert(file.end(), blocks.begin(), blocks.end());
+		}
+		return file;
+	}
+
+	std::vector<unsigned char> MakeKtx2(TextureFormat format, int width, int height, int mipLevels, uint64_t seed)
+	{
+		uint32_t vkFormat = format == TextureFormat::Bc1 ? 131 : format == TextureFormat::Bc3 ? 137
+			: format == TextureFormat::Bc5 ? 141 : 145;
+		std::vector<size_t> sizes = GetLevelSizes(format, width, height, mipLevels);
+
+		std::vector<unsigned char> file = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+		PutLittleEndian32(file, vkFormat);
+		PutLittleEndian32(file, 1); // typeSize
+		PutLittleEndian32(file, static_cast<uint32_t>(width));
+		PutLittleEndian32(file, static_cast<uint32_t>(height));
+		PutLittleEndian32(file, 0); // depth
+		PutLittleEndian32(file, 0); // layers
+		PutLittleEndian32(file, 1); // faces
+		PutLittleEndian32(file, static_cast<uint32_t>(mipLevels));
+		PutLittleEndian32(file, 0); // supercompression
+		file.resize(80); // no data format descriptor, key/value or supercompression data
+
+		// The level index lists the largest level first, but the data stores the smallest first, each level
+		// aligned to the block size.
+		size_t indexOffset = file.size();
+		file.resize(indexOffset + sizes.size() * 24);
+		for (size_t level = sizes.size(); level-- > 0;)
+		{
+			file.resize((file.size() + 15) / 16 * 16);
+			std::vector<unsigned char> entry;
+			PutLittleEndian64(entry, file.size());
+			PutLittleEndian64(entry, sizes[level]);
+			PutLittleEndian64(entry, sizes[level]);
+			memcpy(file.data() + indexOffset + level * 24, entry.data(), entry.size());
+
+			std::vector<unsigned char> blocks = MakeNoise(sizes[level], seed + level);
+			file.insert(file.end(), blocks.begin(), blocks.end());
+		}
+		return file;
+	}
+
+	std::vector<unsigned char> ToRgba(const unsigned char* pixels, size_t numPixels, int channels)
+	{
+		std::vector<unsigned char> rgba(numPixels * 4);
+		for (size_t i = 0; i < numPixels; i++)
+		{
+			const unsigned char* in = pixels + i * channels;
+			unsigned char* out = &rgba[i * 4];
+			switch (channels)
+			{
+			case 1:
+				out[0] = out[1] = out[2] = in[0];
+				out[3] = 255;
+				break;
+			case 2:
+				out[0] = out[1] = out[2] = in[0];
+				out[3] = in[1];
+				break;
+			case 3:
+				out[0] = in[0];
+				out[1] = in[1];
+				out[2] = in[2];
+				out[3] = 255;
+				break;
+			default:
+				std::memcpy(out, in, 4);
+				break;
+			}
+		}
+		return rgba;
+	}
+
+	std::vector<unsigned char> DecodeBlocks(TextureFormat format, const unsigned char* blocks, int width, int height)
+	{
+		static constexpr int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+		if (format != TextureFormat::Bc1 && format != TextureFormat::Bc7)
+			return {};
+
+		std::vector<unsigned char> rgba(static_cast<size_t>(width) * height * 4);
+		int blockSize = TextureFormats::GetElementSize(format);
+		int numBlocksWide = (width + 3) / 4;
+		for (int blockY = 0; blockY < (height + 3) / 4; blockY++)
+		{
+			for (int blockX = 0; blockX < numBlocksWide; blockX++)
+			{
+				size_t blockIndex = static_cast<size_t>(blockY) * numBlocksWide + blockX;
+				const unsigned char* block = blocks + blockIndex * blockSize;
+				unsigned char palette[16][4] = {};
+				int indices[16] = {};
+				if (format == TextureFormat::Bc1)
+				{
+					uint16_t colors[2] = {static_cast<uint16_t>(block[0] | (block[1] << 8)),
+					                      static_cast<uint16_t>(block[2] | (block[3] << 8))};
+					for (int e = 0; e < 2; e++)
+					{
+						int r = colors[e] >> 11;
+						int g = (colors[e] >> 5) & 63;
+						int b = colors[e] & 31;
+						palette[e][0] = static_cast<unsigned char>((r << 3) | (r >> 2));
+						palette[e][1] = static_cast<unsigned char>((g << 2) | (g >> 4));
+						palette[e][2] = static_cast<unsigned char>((b << 3) | (b >> 2));
+						palette[e][3] = 255;
+					}
+					for (int c = 0; c < 4; c++)
+					{
+						if (colors[0] > colors[1])
+						{
+							palette[2][c] = static_cast<unsigned char>((2 * palette[0][c] + palette[1][c] + 1) / 3);
+							palette[3][c] = static_cast<unsigned char>((palette[0][c] + 2 * palette[1][c] + 1) / 3);
+						}
+						else
+						{
+							palette[2][c] = static_cast<unsigned char>((palette[0][c] + palette[1][c]) / 2);
+							palette[3][c] = 0; // transparent black
+						}
+					}
+					uint32_t indexBits =
+						block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+					for (int i = 0; i < 16; i++)
+						indices[i] = (indexBits >> (i * 2)) & 3;
+				}
+				else
+				{
+					uint64_t bits[2];
+					memcpy(bits, block, 16);
+					int position = 0;
+					auto get = [&](int count)
+					{
+						uint32_t value = 0;
+						for (int i = 0; i < count; i++, position++)
+							value |= static_cast<uint32_t>((bits[position >> 6] >> (position & 63)) & 1) << i;
+						return value;
+					};
+					if (get(7) != 1 << 6)
+						return {};
+					uint32_t endpoints[2][4];
+					for (int c = 0; c < 4; c++)
+					{
+						endpoints[0][c] = get(7);
+						endpoints[1][c] = get(7);
+					}
+					uint32_t pBits[2] = {get(1), get(1)};
+					for (int i = 0; i < 16; i++)
+						indices[i] = static_cast<int>(get(i == 0 ? 3 : 4));
+					for (int k = 0; k < 16; k++)
+					{
+						for (int c = 0; c < 4; c++)
+						{
+							uint32_t color0 = (endpoints[0][c] << 1) | pBits[0];
+							uint32_t color1 = (endpoints[1][c] << 1) | pBits[1];
+							palette[k][c] = static_cast<unsigned char>(
+								((64 - BC7_WEIGHTS[k]) * color0 + BC7_WEIGHTS[k] * color1 + 32) >> 6);
+						}
+					}
+				}
+
+				for (int i = 0; i < 16; i++)
+				{
+					int x = blockX * 4 + i % 4;
+					int y = blockY * 4 + i / 4;
+					if (x < width && y < height)
+						memcpy(&rgba[(static_cast<size_t>(y) * width + x) * 4], palette[indices[i]], 4);
+				}
+			}
+		}
+		return rgba;
+	}
+
+	double GetPsnr(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b)
+	{
+		double sum = 0.0;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			double d = static_cast<double>(a[i]) - b[i];
+			sum += d * d;
+		}
+		if (sum == 0.0)
+			return INFINITY;
+		return 10.0 * std::log10(255.0 * 255.0 * a.size() / sum);
+	}
+
+	bool WriteFile(const std::filesystem::path& path, const std::vector<unsigned char>& data)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+		return static_cast<bool>(file);
+	}
+
+	std::vector<unsigned char> ReadFile(const std::filesystem::path& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	TempDirectory::TempDirectory(const std::string& name)
+	{
+		uint64_t state = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(this)) ^
+			static_cast<uint64_t>(std::filesystem::file_time_type::clock::now().time_since_epoch().count());
+		m_path = std::filesystem::temp_directory_path() / (name + "-" + std::to_string(NextRandom(state) % 1000000));
+		std::filesystem::remove_all(m_path);
+		std::filesystem::create_directories(m_path);
+	}
+
+	TempDirectory::~TempDirectory()
+	{
+		std::error_code ec;
+		std::filesystem::remove_all(m_path, ec);
+	}
+
+	uint64_t GetPeakRss()
+	{
+#if defined(__linux__)
+		// VmHWM follows clear_refs resets; ru_maxrss does not.
+		if (std::FILE* status = std::fopen("/proc/self/status", "r"))
+		{
+			char line[256];
+			uint64_t peakKb = 0;
+			while (std::fgets(line, sizeof(line), status))
+			{
+				if (std::strncmp(line, "VmHWM:", 6) == 0)
+					peakKb = std::strtoull(line + 6, nullptr, 10);
+			}
+			std::fclose(status);
+			if (peakKb != 0)
+				return peakKb * 1024;
+		}
+		rusage usage = {};
+		getrusage(RUSAGE_SELF, &usage);
+		return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#else
+		return 0;
+#endif
+	}
+
+	bool ResetPeakRss()
+	{
+#if defined(__linux__)
+		std::FILE* clearRefs = std::fopen("/proc/self/clear_refs", "w");
+		if (!clearRefs)
+			return false;
+		bool reset = std::fputs("5", clearRefs) >= 0;
+		return std::fclose(clearRefs) == 0 && reset;
+#else
+		return false;
+#endif
+	}
+}
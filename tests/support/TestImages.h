@@ -0,0 +1,99 @@
+#pragma once
+#include "image/TextureContainer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Synthetic inputs shared by the tests and the benchmarks, so neither depends on files outside the tree.
+// PNG and deflate streams are written with zlib, JPEG with libjpeg; both are only needed by these helpers.
+namespace TestImages
+{
+	// Smooth gradients, a few hard edges and some noise: compresses and decodes like a photograph rather than
+	// like a flat colour. channels is 1 to 4; samples are 8-bit, or 16-bit little-endian when bitDepth is 16.
+	std::vector<unsigned char> MakePhoto(int width, int height, int channels, uint64_t seed, int bitDepth = 8);
+
+	// Uniformly random bytes, which deflate cannot shrink.
+	std::vector<unsigned char> MakeNoise(size_t size, uint64_t seed);
+
+	struct PngOptions
+	{
+		int ColorType = 6; // 0 gray, 2 RGB, 3 palette, 4 gray+alpha, 6 RGBA
+		int BitDepth = 8; // 8 or 16; palette images are always 8
+		int Filter = -1; // 0..4 for every row, -1 cycles through all five
+		int Level = 6; // zlib compression level
+		int FullFlushRows = 0; // > 0 full-flushes the stream every that many rows, as pigz -i does
+		int IdatSize = 65536; // the stream is split into IDAT chunks of at most this many bytes
+	};
+
+	// pixels holds one sample per channel of ColorType (palette indices for type 3), 16-bit samples in native
+	// order; palette is RGBA, used for type 3 only.
+	std::vector<unsigned char> EncodePng(const unsigned char* pixels, int width, int height, const PngOptions& options,
+	                                     const std::vector<uint32_t>& palette = {});
+
+	struct JpegOptions
+	{
+		int Components = 3; // 1 or 3
+		int Quality = 90;
+		int SamplingH = 2; // of the luma component; chroma is 1x1
+		int SamplingV = 2;
+		bool Progressive = false;
+		int RestartRows = 0; // restart marker every that many MCU rows
+	};
+
+	// pixels is gray or RGB, tightly packed.
+	std::vector<unsigned char> EncodeJpeg(const unsigned char* pixels, int width, int height,
+	                                      const JpegOptions& options);
+
+	// RGBA8 decode by libjpeg at 1 / scaleDenominator of the size (1, 2, 4 or 8), with its DCT scaling.
+	std::vector<unsigned char> DecodeJpegScaled(const std::vector<unsigned char>& jpeg, int scaleDenominator,
+	                                            int* out_width, int* out_height);
+
+	// zlib (or raw deflate) stream of data.
+	std::vector<unsigned char> Deflate(const unsigned char* data, size_t size, int level, bool raw = false,
+	                                   int strategy = 0);
+
+	// DDS and KTX2 files holding mipLevels levels of random blocks, laid out as texconv and toktx write them.
+	// DDS files get a DX10 header, or with legacyHeader the FourCC older tools write (BC1, BC3 and BC5 only).
+	std::vector<unsigned char> MakeDds(TextureFormat format, int width, int height, int mipLevels, uint64_t seed,
+	                                   bool legacyHeader = false);
+	std::vector<unsigned char> MakeKtx2(TextureFormat format, int width, int height, int mipLevels, uint64_t seed);
+
+	// RGBA8 copy of pixels with the given channel count, expanded the way stb_image does.
+	std::vector<unsigned char> ToRgba(const unsigned char* pixels, size_t numPixels, int channels);
+
+	// RGBA8 decode of a BC1 or BC7 level, interpolating with BlockCompressor's rounding. BC7 handles mode 6, the
+	// only mode BlockCompressor writes; empty for any other format or mode.
+	std::vector<unsigned char> DecodeBlocks(TextureFormat format, const unsigned char* blocks, int width, int height);
+
+	// Peak signal-to-noise ratio between two images of the same size, over every byte; infinite when they match.
+	double GetPsnr(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b);
+
+	bool WriteFile(const std::filesystem::path& path, const std::vector<unsigned char>& data);
+	std::vector<unsigned char> ReadFile(const std::filesystem::path& path);
+
+	// Empty directory under the system temporary directory, removed by the destructor.
+	class TempDirectory
+	{
+	public:
+		explicit TempDirectory(const std::string& name);
+		~TempDirectory();
+
+		TempDirectory(const TempDirectory&) = delete;
+		TempDirectory& operator=(const TempDirectory&) = delete;
+
+		const std::filesystem::path& GetPath() const { return m_path; }
+		std::string operator/(const std::string& file) const { return (m_path / file).string(); }
+
+	private:
+		std::filesystem::path m_path;
+	};
+
+	// Peak resident set size of the process, in bytes, since it started or since ResetPeakRss; 0 where the
+	// platform does not report it.
+	uint64_t GetPeakRss();
+	// Returns false where the peak cannot be reset (it needs Linux's /proc/self/clear_refs).
+	bool ResetPeakRss();
+}
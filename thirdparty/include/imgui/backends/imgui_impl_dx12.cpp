@@ -53,6 +53,7 @@
 #include "imgui/imgui.h"
 #ifndef IMGUI_DISABLE
 #include "imgui_impl_dx12.h"
+#include "render/ImGuiBufferGrowth.h" // [imgui-images]
 
 // DirectX
 #include <d3d12.h>
@@ -74,6 +75,17 @@ typedef decltype(D3D12SerializeRootSignature) *_PFN_D3D12_SERIALIZE_ROOT_SIGNATU
 // DirectX12 data
 struct ImGui_ImplDX12_RenderBuffers;
 
+// Sizes, in elements, the vertex/index buffers start at and never grow from less than
+static const int IMGUI_DX12_MIN_VERTEX_BUFFER_SIZE = 5000;
+static const int IMGUI_DX12_MIN_INDEX_BUFFER_SIZE = 10000;
+
+// Buffer replaced by a bigger one, released once the frames in flight that may still read it have completed
+struct ImGui_ImplDX12_RetiredBuffer
+{
+    ID3D12Resource*             Buffer;
+    UINT                        FrameIndex;
+};
+
 struct ImGui_ImplDX12_Texture
 {
     ID3D12Resource*             pTextureResource;
@@ -94,10 +106,15 @@ struct ImGui_ImplDX12_Data
     DXGI_FORMAT                 RTVFormat;
     DXGI_FORMAT                 DSVFormat;
     ID3D12DescriptorHeap*       pd3dSrvDescHeap;
+    D3D12_GPU_DESCRIPTOR_HANDLE hSrvDescHeapStartGpu;
+    UINT                        SrvDescHandleIncrement;
     UINT                        numFramesInFlight;
+    bool                        Bindless;
 
     ImGui_ImplDX12_RenderBuffers* pFrameResources;
     UINT                        frameIndex;
+    ImVector<ImGui_ImplDX12_RetiredBuffer> RetiredBuffers;
+    ImGui_ImplDX12_BufferStats  BufferStats;
 
     ImGui_ImplDX12_Texture      FontTexture;
     bool                        LegacySingleDescriptorUsed;
@@ -113,10 +130,13 @@ static ImGui_ImplDX12_Data* ImGui_ImplDX12_GetBackendData()
 }
 
 // Buffers used during the rendering of a frame
+// (upload heap buffers stay mapped for their whole life, the GPU reads them while mapped)
 struct ImGui_ImplDX12_RenderBuffers
 {
     ID3D12Resource*     IndexBuffer;
     ID3D12Resource*     VertexBuffer;
+    void*               IndexBufferMapped;
+    void*               VertexBufferMapped;
     int                 IndexBufferSize;
     int                 VertexBufferSize;
 };
@@ -176,6 +196,10 @@ static void ImGui_ImplDX12_SetupRenderState(ImDrawData* draw_data, ID3D12Graphic
     command_list->SetGraphicsRootSignature(bd->pRootSignature);
     command_list->SetGraphicsRoot32BitConstants(0, 16, &vertex_constant_buffer, 0);
 
+    // In bindless mode the table covers the whole heap and stays bound for every draw
+    if (bd->Bindless)
+        command_list->SetGraphicsRootDescriptorTable(1, bd->hSrvDescHeapStartGpu);
+
     // Setup blend factor
     const float blend_factor[4] = { 0.f, 0.f, 0.f, 0.f };
     command_list->OMSetBlendFactor(blend_factor);
@@ -189,6 +213,65 @@ static inline void SafeRelease(T*& res)
     res = nullptr;
 }
 
+// Create a persistently mapped upload heap buffer
+static bool ImGui_ImplDX12_CreateUploadBuffer(UINT64 size, ID3D12Resource** out_buffer, void** out_mapped)
+{
+    ImGui_ImplDX12_Data* bd = ImGui_ImplDX12_GetBackendData();
+    D3D12_HEAP_PROPERTIES props = {};
+    props.Type = D3D12_HEAP_TYPE_UPLOAD;
+    props.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    props.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    desc.Width = size;
+    desc.Height = 1;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.Format = DXGI_FORMAT_UNKNOWN;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+    ID3D12Resource* buffer = nullptr;
+    if (bd->pd3dDevice->CreateCommittedResource(&props, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&buffer)) < 0)
+        return false;
+
+    // During Map() we specify a null read range (as per DX12 API, this is informational and for tooling only)
+    D3D12_RANGE range = { 0, 0 };
+    if (buffer->Map(0, &range, out_mapped) != S_OK)
+    {
+        buffer->Release();
+        return false;
+    }
+    *out_buffer = buffer;
+    return true;
+}
+
+// Make room for 'required' elements, growing by half the current size at a time (as ImVector does) and from no less than min_size, so that a slowly growing UI
+// does not recreate its buffers every few frames. The replaced buffer may still be read by frames in flight, so it is retired instead of released.
+static bool ImGui_ImplDX12_GrowBuffer(ID3D12Resource** buffer, void** mapped, int* size, int required, int min_size, size_t elem_size)
+{
+    ImGui_ImplDX12_Data* bd = ImGui_ImplDX12_GetBackendData();
+    if (*buffer != nullptr && *size >= required)
+        return true;
+
+    int new_size = ImGuiBufferGrowth::GetGrownSize(*size, required, min_size);
+    ID3D12Resource* new_buffer = nullptr;
+    void* new_mapped = nullptr;
+    if (!ImGui_ImplDX12_CreateUploadBuffer((UINT64)new_size * elem_size, &new_buffer, &new_mapped))
+        return false;
+
+    if (*buffer != nullptr)
+    {
+        ImGui_ImplDX12_RetiredBuffer retired = { *buffer, bd->frameIndex };
+        bd->RetiredBuffers.push_back(retired);
+        bd->BufferStats.Reallocations++;
+    }
+    *buffer = new_buffer;
+    *mapped = new_mapped;
+    *size = new_size;
+    return true;
+}
+
 // Render function
 void ImGui_ImplDX12_RenderDrawData(ImDrawData* draw_data, ID3D12GraphicsCommandList* command_list)
 {
@@ -208,60 +291,23 @@ void ImGui_ImplDX12_RenderDrawData(ImDrawData* draw_data, ID3D12GraphicsCommandL
     bd->frameIndex = bd->frameIndex + 1;
     ImGui_ImplDX12_RenderBuffers* fr = &bd->pFrameResources[bd->frameIndex % bd->numFramesInFlight];
 
-    // Create and grow vertex/index buffers if needed
-    if (fr->VertexBuffer == nullptr || fr->VertexBufferSize < draw_data->TotalVtxCount)
-    {
-        SafeRelease(fr->VertexBuffer);
-        fr->VertexBufferSize = draw_data->TotalVtxCount + 5000;
-        D3D12_HEAP_PROPERTIES props = {};
-        props.Type = D3D12_HEAP_TYPE_UPLOAD;
-        props.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-        props.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-        D3D12_RESOURCE_DESC desc = {};
-        desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-        desc.Width = fr->VertexBufferSize * sizeof(ImDrawVert);
-        desc.Height = 1;
-        desc.DepthOrArraySize = 1;
-        desc.MipLevels = 1;
-        desc.Format = DXGI_FORMAT_UNKNOWN;
-        desc.SampleDesc.Count = 1;
-        desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-        desc.Flags = D3D12_RESOURCE_FLAG_NONE;
-        if (bd->pd3dDevice->CreateCommittedResource(&props, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&fr->VertexBuffer)) < 0)
-            return;
-    }
-    if (fr->IndexBuffer == nullptr || fr->IndexBufferSize < draw_data->TotalIdxCount)
-    {
-        SafeRelease(fr->IndexBuffer);
-        fr->IndexBufferSize = draw_data->TotalIdxCount + 10000;
-        D3D12_HEAP_PROPERTIES props = {};
-        props.Type = D3D12_HEAP_TYPE_UPLOAD;
-        props.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-        props.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-        D3D12_RESOURCE_DESC desc = {};
-        desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-        desc.Width = fr->IndexBufferSize * sizeof(ImDrawIdx);
-        desc.Height = 1;
-        desc.DepthOrArraySize = 1;
-        desc.MipLevels = 1;
-        desc.Format = DXGI_FORMAT_UNKNOWN;
-        desc.SampleDesc.Count = 1;
-        desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-        desc.Flags = D3D12_RESOURCE_FLAG_NONE;
-        if (bd->pd3dDevice->CreateCommittedResource(&props, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&fr->IndexBuffer)) < 0)
-            return;
-    }
+    // Release buffers replaced at least numFramesInFlight frames ago (the application waits for a frame's fence before reusing its resources)
+    for (int i = 0; i < bd->RetiredBuffers.Size; i++)
+        if (ImGuiBufferGrowth::CanRelease(bd->RetiredBuffers[i].FrameIndex, bd->frameIndex, bd->numFramesInFlight))
+        {
+            bd->RetiredBuffers[i].Buffer->Release();
+            bd->RetiredBuffers.erase(&bd->RetiredBuffers[i--]);
+        }
 
-    // Upload vertex/index data into a single contiguous GPU buffer
-    // During Map() we specify a null read range (as per DX12 API, this is informational and for tooling only)
-    void* vtx_resource, *idx_resource;
-    D3D12_RANGE range = { 0, 0 };
-    if (fr->VertexBuffer->Map(0, &range, &vtx_resource) != S_OK)
+    // Create and grow vertex/index buffers if needed
+    if (!ImGui_ImplDX12_GrowBuffer(&fr->VertexBuffer, &fr->VertexBufferMapped, &fr->VertexBufferSize, draw_data->TotalVtxCount, IMGUI_DX12_MIN_VERTEX_BUFFER_SIZE, sizeof(ImDrawVert)))
         return;
-    if (fr->IndexBuffer->Map(0, &range, &idx_resource) != S_OK)
+    if (!ImGui_ImplDX12_GrowBuffer(&fr->IndexBuffer, &fr->IndexBufferMapped, &fr->IndexBufferSize, draw_data->TotalIdxCount, IMGUI_DX12_MIN_INDEX_BUFFER_SIZE, sizeof(ImDrawIdx)))
         return;
-    ImDrawVert* vtx_dst = (ImDrawVert*)vtx_resource;
-    ImDrawIdx* idx_dst = (ImDrawIdx*)idx_resource;
+
+    // Upload vertex/index data into a single contiguous GPU buffer
+    ImDrawVert* vtx_dst = (ImDrawVert*)fr->VertexBufferMapped;
+    ImDrawIdx* idx_dst = (ImDrawIdx*)fr->IndexBufferMapped;
     for (int n = 0; n < draw_data->CmdListsCount; n++)
     {
         const ImDrawList* draw_list = draw_data->CmdLists[n];
@@ -270,14 +316,8 @@ void ImGui_ImplDX12_RenderDrawData(ImDrawData* draw_data, ID3D12GraphicsCommandL
         vtx_dst += draw_list->VtxBuffer.Size;
         idx_dst += draw_list->IdxBuffer.Size;
     }
-
-    // During Unmap() we specify the written range (as per DX12 API, this is informational and for tooling only)
-    range.End = (SIZE_T)((intptr_t)vtx_dst - (intptr_t)vtx_resource);
-    IM_ASSERT(range.End == draw_data->TotalVtxCount * sizeof(ImDrawVert));
-    fr->VertexBuffer->Unmap(0, &range);
-    range.End = (SIZE_T)((intptr_t)idx_dst - (intptr_t)idx_resource);
-    IM_ASSERT(range.End == draw_data->TotalIdxCount * sizeof(ImDrawIdx));
-    fr->IndexBuffer->Unmap(0, &range);
+    bd->BufferStats.UploadedBytes = (ImU64)draw_data->TotalVtxCount * sizeof(ImDrawVert) + (ImU64)draw_data->TotalIdxCount * sizeof(ImDrawIdx);
+    bd->BufferStats.TotalUploadedBytes += bd->BufferStats.UploadedBytes;
 
     // Setup desired DX state
     ImGui_ImplDX12_SetupRenderState(draw_data, command_list, fr);
@@ -322,10 +362,13 @@ void ImGui_ImplDX12_RenderDrawData(ImDrawData* draw_data, ID3D12GraphicsCommandL
                 const D3D12_RECT r = { (LONG)clip_min.x, (LONG)clip_min.y, (LONG)clip_max.x, (LONG)clip_max.y };
                 command_list->RSSetScissorRects(1, &r);
 
-                // Bind texture, Draw
-                D3D12_GPU_DESCRIPTOR_HANDLE texture_handle = {};
-                texture_handle.ptr = (UINT64)pcmd->GetTexID();
-                command_list->SetGraphicsRootDescriptorTable(1, texture_handle);
+                // Bind texture (bindless mode: the vertices carry it), Draw
+                if (!bd->Bindless)
+                {
+                    D3D12_GPU_DESCRIPTOR_HANDLE texture_handle = {};
+                    texture_handle.ptr = (UINT64)pcmd->GetTexID();
+                    command_list->SetGraphicsRootDescriptorTable(1, texture_handle);
+                }
                 command_list->DrawIndexedInstanced(pcmd->ElemCount, 1, pcmd->IdxOffset + global_idx_offset, pcmd->VtxOffset + global_vtx_offset, 0);
             }
         }
@@ -561,7 +604,7 @@ bool    ImGui_ImplDX12_CreateDeviceObjects()
     {
         D3D12_DESCRIPTOR_RANGE descRange = {};
         descRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-        descRange.NumDescriptors = 1;
+        descRange.NumDescriptors = bd->Bindless ? UINT_MAX : 1; // UINT_MAX: unbounded, up to the end of the heap
         descRange.BaseShaderRegister = 0;
         descRange.RegisterSpace = 0;
         descRange.OffsetInDescriptorsFromTableStart = 0;
@@ -690,7 +733,40 @@ bool    ImGui_ImplDX12_CreateDeviceObjects()
               return output;\
             }";
 
-        if (FAILED(D3DCompile(vertexShader, strlen(vertexShader), nullptr, nullptr, nullptr, "main", "vs_5_0", 0, 0, &vertexShaderBlob, nullptr)))
+        // Bindless variant: passes the texture index through, unchanged for the whole triangle (Shader Model 5.1 for resource arrays)
+        static const char* vertexShaderBindless =
+            "cbuffer vertexBuffer : register(b0) \
+            {\
+              float4x4 ProjectionMatrix; \
+            };\
+            struct VS_INPUT\
+            {\
+              float2 pos : POSITION;\
+              float4 col : COLOR0;\
+              float2 uv  : TEXCOORD0;\
+              uint   tex : TEXCOORD1;\
+            };\
+            \
+            struct PS_INPUT\
+            {\
+              float4 pos : SV_POSITION;\
+              float4 col : COLOR0;\
+              float2 uv  : TEXCOORD0;\
+              nointerpolation uint tex : TEXCOORD1;\
+            };\
+            \
+            PS_INPUT main(VS_INPUT input)\
+            {\
+              PS_INPUT output;\
+              output.pos = mul( ProjectionMatrix, float4(input.pos.xy, 0.f, 1.f));\
+              output.col = input.col;\
+              output.uv  = input.uv;\
+              output.tex = input.tex;\
+              return output;\
+            }";
+
+        const char* source = bd->Bindless ? vertexShaderBindless : vertexShader;
+        if (FAILED(D3DCompile(source, strlen(source), nullptr, nullptr, nullptr, "main", bd->Bindless ? "vs_5_1" : "vs_5_0", 0, 0, &vertexShaderBlob, nullptr)))
             return false; // NB: Pass ID3DBlob* pErrorBlob to D3DCompile() to get error showing in (const char*)pErrorBlob->GetBufferPointer(). Make sure to Release() the blob!
         psoDesc.VS = { vertexShaderBlob->GetBufferPointer(), vertexShaderBlob->GetBufferSize() };
 
@@ -700,8 +776,11 @@ bool    ImGui_ImplDX12_CreateDeviceObjects()
             { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT,   0, (UINT)offsetof(ImDrawVert, pos), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
             { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,   0, (UINT)offsetof(ImDrawVert, uv),  D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
             { "COLOR",    0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, (UINT)offsetof(ImDrawVert, col), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+#ifdef IMGUI_IMPL_DX12_DRAWVERT_TEX_INDEX
+            { "TEXCOORD", 1, DXGI_FORMAT_R32_UINT,       0, (UINT)offsetof(ImDrawVert, tex_index), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+#endif
         };
-        psoDesc.InputLayout = { local_layout, 3 };
+        psoDesc.InputLayout = { local_layout, bd->Bindless ? 4u : 3u };
     }
 
     // Create the pixel shader
@@ -722,7 +801,26 @@ bool    ImGui_ImplDX12_CreateDeviceObjects()
               return out_col; \
             }";
 
-        if (FAILED(D3DCompile(pixelShader, strlen(pixelShader), nullptr, nullptr, nullptr, "main", "ps_5_0", 0, 0, &pixelShaderBlob, nullptr)))
+        // Bindless variant: neighbouring pixels of one draw may sample different textures, hence NonUniformResourceIndex()
+        static const char* pixelShaderBindless =
+            "struct PS_INPUT\
+            {\
+              float4 pos : SV_POSITION;\
+              float4 col : COLOR0;\
+              float2 uv  : TEXCOORD0;\
+              nointerpolation uint tex : TEXCOORD1;\
+            };\
+            SamplerState sampler0 : register(s0);\
+            Texture2D textures[] : register(t0);\
+            \
+            float4 main(PS_INPUT input) : SV_Target\
+            {\
+              float4 out_col = input.col * textures[NonUniformResourceIndex(input.tex)].Sample(sampler0, input.uv); \
+              return out_col; \
+            }";
+
+        const char* source = bd->Bindless ? pixelShaderBindless : pixelShader;
+        if (FAILED(D3DCompile(source, strlen(source), nullptr, nullptr, nullptr, "main", bd->Bindless ? "ps_5_1" : "ps_5_0", 0, 0, &pixelShaderBlob, nullptr)))
         {
             vertexShaderBlob->Release();
             return false; // NB: Pass ID3DBlob* pErrorBlob to D3DCompile() to get error showing in (const char*)pErrorBlob->GetBufferPointer(). Make sure to Release() the blob!
@@ -803,7 +901,12 @@ void    ImGui_ImplDX12_InvalidateDeviceObjects()
         ImGui_ImplDX12_RenderBuffers* fr = &bd->pFrameResources[i];
         SafeRelease(fr->IndexBuffer);
         SafeRelease(fr->VertexBuffer);
+        fr->IndexBufferMapped = nullptr;
+        fr->VertexBufferMapped = nullptr;
     }
+    for (ImGui_ImplDX12_RetiredBuffer& retired : bd->RetiredBuffers)
+        retired.Buffer->Release();
+    bd->RetiredBuffers.clear();
 }
 
 #ifndef IMGUI_DISABLE_OBSOLETE_FUNCTIONS
@@ -846,6 +949,18 @@ bool ImGui_ImplDX12_Init(ImGui_ImplDX12_InitInfo* init_info)
     bd->DSVFormat = init_info->DSVFormat;
     bd->numFramesInFlight = init_info->NumFramesInFlight;
     bd->pd3dSrvDescHeap = init_info->SrvDescriptorHeap;
+    bd->hSrvDescHeapStartGpu = bd->pd3dSrvDescHeap->GetGPUDescriptorHandleForHeapStart();
+    bd->SrvDescHandleIncrement = bd->pd3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+#ifdef IMGUI_IMPL_DX12_DRAWVERT_TEX_INDEX
+    // Resource binding tier 1 caps a table at 128 SRVs and must have every descriptor in it initialized.
+    if (init_info->BindlessTextures)
+    {
+        D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+        bd->Bindless = SUCCEEDED(bd->pd3dDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))) &&
+            options.ResourceBindingTier >= D3D12_RESOURCE_BINDING_TIER_2;
+    }
+#endif
 
     io.BackendRendererUserData = (void*)bd;
     io.BackendRendererName = "imgui_impl_dx12";
@@ -866,8 +981,10 @@ bool ImGui_ImplDX12_Init(ImGui_ImplDX12_InitInfo* init_info)
         ImGui_ImplDX12_RenderBuffers* fr = &bd->pFrameResources[i];
         fr->IndexBuffer = nullptr;
         fr->VertexBuffer = nullptr;
-        fr->IndexBufferSize = 10000;
-        fr->VertexBufferSize = 5000;
+        fr->IndexBufferMapped = nullptr;
+        fr->VertexBufferMapped = nullptr;
+        fr->IndexBufferSize = IMGUI_DX12_MIN_INDEX_BUFFER_SIZE;
+        fr->VertexBufferSize = IMGUI_DX12_MIN_VERTEX_BUFFER_SIZE;
     }
 
     return true;
@@ -919,6 +1036,35 @@ void ImGui_ImplDX12_Shutdown()
     IM_DELETE(bd);
 }
 
+bool ImGui_ImplDX12_IsBindless()
+{
+    ImGui_ImplDX12_Data* bd = ImGui_ImplDX12_GetBackendData();
+    return bd != nullptr && bd->Bindless;
+}
+
+const ImGui_ImplDX12_BufferStats* ImGui_ImplDX12_GetBufferStats()
+{
+    ImGui_ImplDX12_Data* bd = ImGui_ImplDX12_GetBackendData();
+    bd->BufferStats.CapacityBytes = 0;
+    for (UINT i = 0; i < bd->numFramesInFlight; i++)
+    {
+        ImGui_ImplDX12_RenderBuffers* fr = &bd->pFrameResources[i];
+        if (fr->VertexBuffer != nullptr)
+            bd->BufferStats.CapacityBytes += (ImU64)fr->VertexBufferSize * sizeof(ImDrawVert);
+        if (fr->IndexBuffer != nullptr)
+            bd->BufferStats.CapacityBytes += (ImU64)fr->IndexBufferSize * sizeof(ImDrawIdx);
+    }
+    bd->BufferStats.RetiredBuffers = bd->RetiredBuffers.Size;
+    return &bd->BufferStats;
+}
+
+ImU32 ImGui_ImplDX12_GetTextureIndex(ImTextureID tex_id)
+{
+    ImGui_ImplDX12_Data* bd = ImGui_ImplDX12_GetBackendData();
+    IM_ASSERT((UINT64)tex_id >= bd->hSrvDescHeapStartGpu.ptr && "Texture descriptor is not in ImGui_ImplDX12_InitInfo::SrvDescriptorHeap!");
+    return (ImU32)(((UINT64)tex_id - bd->hSrvDescHeapStartGpu.ptr) / bd->SrvDescHandleIncrement);
+}
+
 void ImGui_ImplDX12_NewFrame()
 {
     ImGui_ImplDX12_Data* bd = ImGui_ImplDX12_GetBackendData();
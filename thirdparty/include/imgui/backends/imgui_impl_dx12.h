@@ -39,6 +39,12 @@ struct ImGui_ImplDX12_InitInfo
     ID3D12DescriptorHeap*       SrvDescriptorHeap;
     void                        (*SrvDescriptorAllocFn)(ImGui_ImplDX12_InitInfo* info, D3D12_CPU_DESCRIPTOR_HANDLE* out_cpu_desc_handle, D3D12_GPU_DESCRIPTOR_HANDLE* out_gpu_desc_handle);
     void                        (*SrvDescriptorFreeFn)(ImGui_ImplDX12_InitInfo* info, D3D12_CPU_DESCRIPTOR_HANDLE cpu_desc_handle, D3D12_GPU_DESCRIPTOR_HANDLE gpu_desc_handle);
+
+    // [imgui-images] Bindless mode: the whole of SrvDescriptorHeap is bound once per frame as one unbounded SRV table, and the pixel shader
+    // picks the texture from ImDrawVert::tex_index (requires IMGUI_IMPL_DX12_DRAWVERT_TEX_INDEX in imconfig.h, and every ImTextureID to be a
+    // descriptor of SrvDescriptorHeap). The application fills tex_index, and may then merge draw commands that only differ in texture.
+    // Needs resource binding tier 2; check ImGui_ImplDX12_IsBindless() after init, the backend falls back to one table per draw otherwise.
+    bool                        BindlessTextures;
 #ifndef IMGUI_DISABLE_OBSOLETE_FUNCTIONS
     D3D12_CPU_DESCRIPTOR_HANDLE LegacySingleSrvCpuDescriptor; // To facilitate transition from single descriptor to allocator callback, you may use those.
     D3D12_GPU_DESCRIPTOR_HANDLE LegacySingleSrvGpuDescriptor;
@@ -67,6 +73,21 @@ IMGUI_IMPL_API void     ImGui_ImplDX12_InvalidateDeviceObjects();
 // (Advanced) Use e.g. if you need to precisely control the timing of texture updates (e.g. for staged rendering), by setting ImDrawData::Textures = NULL to handle this manually.
 IMGUI_IMPL_API void     ImGui_ImplDX12_UpdateTexture(ImTextureData* tex);
 
+// [imgui-images] Bindless mode, see ImGui_ImplDX12_InitInfo::BindlessTextures.
+IMGUI_IMPL_API bool     ImGui_ImplDX12_IsBindless();
+IMGUI_IMPL_API ImU32    ImGui_ImplDX12_GetTextureIndex(ImTextureID tex_id); // Index of the texture's descriptor in SrvDescriptorHeap, as stored in ImDrawVert::tex_index.
+
+// [imgui-images] Vertex/index buffer statistics, for profiling.
+struct ImGui_ImplDX12_BufferStats
+{
+    ImU64                       Reallocations;      // Vertex/index buffers recreated to grow, over all frames in flight.
+    ImU64                       UploadedBytes;      // Vertices and indices written by the last ImGui_ImplDX12_RenderDrawData() call.
+    ImU64                       TotalUploadedBytes;
+    ImU64                       CapacityBytes;      // Of the buffers of all frames in flight, retired ones excluded.
+    int                         RetiredBuffers;     // Replaced buffers waiting for the frames in flight that may read them.
+};
+IMGUI_IMPL_API const ImGui_ImplDX12_BufferStats* ImGui_ImplDX12_GetBufferStats();
+
 // [BETA] Selected render state data shared with callbacks.
 // This is temporarily stored in GetPlatformIO().Renderer_RenderState during the ImGui_ImplDX12_RenderDrawData() call.
 // (Please open an issue if you feel you need access to more data)
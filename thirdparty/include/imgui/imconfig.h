@@ -118,6 +118,11 @@
 // Read about ImGuiBackendFlags_RendererHasVtxOffset for details.
 //#define ImDrawIdx unsigned int
 
+//---- [imgui-images] Carry the SRV heap index of the sampled texture in every vertex, for the DX12 backend's bindless mode.
+// ImGui leaves 'tex_index' uninitialized; ImGuiDrawMerger (src/render/ImGuiDrawMerger.cpp) fills it before rendering.
+#define IMGUI_OVERRIDE_DRAWVERT_STRUCT_LAYOUT struct ImDrawVert { ImVec2 pos; ImVec2 uv; ImU32 col; ImU32 tex_index; }
+#define IMGUI_IMPL_DX12_DRAWVERT_TEX_INDEX
+
 //---- Override ImDrawCallback signature (will need to modify renderer backends accordingly)
 //struct ImDrawList;
 //struct ImDrawCmd;